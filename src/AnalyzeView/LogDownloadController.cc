@@ -20,8 +20,7 @@
 
 #define kTimeOutMilliseconds 500
 #define kGUIRateMilliseconds 17
-#define kTableBins           512
-#define kChunkSize           (kTableBins * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN)
+#define kMaxMergeBins        512
 
 QGC_LOGGING_CATEGORY(LogDownloadControllerLog, "qgc.analyzeview.logdownloadcontroller")
 
@@ -36,6 +35,7 @@ LogDownloadController::LogDownloadController(void)
 {
     connect(MultiVehicleManager::instance(), &MultiVehicleManager::activeVehicleChanged, this, &LogDownloadController::_setActiveVehicle);
     connect(&_timer, &QTimer::timeout, this, &LogDownloadController::_processDownload);
+    connect(&_rateTimer, &QTimer::timeout, this, &LogDownloadController::_updateDataRate);
     _setActiveVehicle(MultiVehicleManager::instance()->activeVehicle());
 }
 
@@ -55,6 +55,8 @@ void
 LogDownloadController::_setActiveVehicle(Vehicle* vehicle)
 {
     if(_vehicle) {
+        // Stops the rate timer and drops the download before the entry it refers to is deleted with the list
+        cancel();
         _logEntriesModel.clearAndDeleteContents();
         disconnect(_vehicle, &Vehicle::logEntry, this, &LogDownloadController::_logEntry);
         disconnect(_vehicle, &Vehicle::logData,  this, &LogDownloadController::_logData);
@@ -248,75 +250,43 @@ LogDownloadController::_logData(uint32_t ofs, uint16_t id, uint8_t count, const
         return;
     }
 
-    bool result = false;
-    uint32_t timeout_time = kTimeOutMilliseconds;
-    if(ofs <= _downloadData->entry->size()) {
-        const uint32_t chunk = ofs / kChunkSize;
-        if (chunk != _downloadData->current_chunk) {
-            qCWarning(LogDownloadControllerLog) << "Ignored packet for out of order chunk actual:expected" << chunk << _downloadData->current_chunk;
-            return;
-        }
-        const uint16_t bin = (ofs - chunk*kChunkSize) / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
-        if (bin >= _downloadData->chunk_table.size()) {
-            qCWarning(LogDownloadControllerLog) << "Out of range bin received";
-        } else
-            _downloadData->chunk_table.setBit(bin);
-        if (_downloadData->file.pos() != ofs) {
-            // Seek to correct position
-            if (!_downloadData->file.seek(ofs)) {
-                qCWarning(LogDownloadControllerLog) << "Error while seeking log file offset";
-                return;
-            }
-        }
+    if (count == 0) {
+        //-- Sent by some vehicles for a request past the end of the log
+        return;
+    }
 
-        //-- Write chunk to file
-        if(_downloadData->file.write((const char*)data, count)) {
-            _downloadData->written += count;
-            _downloadData->rate_bytes += count;
-            _updateDataRate();
-            result = true;
-            //-- reset retries
-            _retries = 0;
-            //-- Reset timer
-            _timer.start(timeout_time);
-            //-- Do we have it all?
-            if(_logComplete()) {
-                _downloadData->entry->setStatus(tr("Downloaded"));
-                //-- Check for more
-                _receivedAllData();
-            } else if (_chunkComplete()) {
-                _downloadData->advanceChunk();
-                _requestLogData(_downloadData->ID,
-                                _downloadData->current_chunk*kChunkSize,
-                                _downloadData->chunk_table.size()*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-            } else if (bin < _downloadData->chunk_table.size() - 1 && _downloadData->chunk_table.at(bin+1)) {
-                // Likely to be grabbing fragments and got to the end of a gap
-                _findMissingData();
-            }
-        } else {
-            qCWarning(LogDownloadControllerLog) << "Error while writing log file chunk";
-        }
-    } else {
-        qCWarning(LogDownloadControllerLog) << "Received log offset greater than expected";
+    if ((count > MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN) || ((static_cast<quint64>(ofs) + count) > _downloadData->entry->size())) {
+        qCWarning(LogDownloadControllerLog) << "Received log offset greater than expected" << ofs << count;
+        return;
     }
-    if(!result) {
+
+    //-- Packets from any window are taken, the bitmap covers the whole log
+    const uint32_t bin = ofs / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    if (!_downloadData->writeBin(bin, data, count)) {
         _downloadData->entry->setStatus(tr("Error"));
+        return;
     }
-}
 
+    //-- reset retries
+    _retries = 0;
+    _downloadData->lastData.start();
+    if (!_downloadData->windowAnswered && (bin >= _downloadData->windowStart) && (bin < _downloadData->windowEnd)) {
+        _downloadData->windowAnswered = true;
+        const qreal rtt = _downloadData->windowRequested.elapsed();
+        _downloadData->rttMs = (_downloadData->rttMs > 0) ? (_downloadData->rttMs * 0.875) + (rtt * 0.125) : rtt;
+    }
 
-//----------------------------------------------------------------------------------------
-bool
-LogDownloadController::_chunkComplete() const
-{
-    return _downloadData->chunkEquals(true);
-}
-
-//----------------------------------------------------------------------------------------
-bool
-LogDownloadController::_logComplete() const
-{
-    return _chunkComplete() && (_downloadData->current_chunk+1) == _downloadData->numChunks();
+    //-- Do we have it all?
+    if (_downloadData->complete()) {
+        qCDebug(LogDownloadControllerLog) << "Log downloaded (id:" << _downloadData->ID << "size:" << _downloadData->entry->size()
+                                          << "msecs:" << _downloadData->total.elapsed() << ")";
+        _downloadData->entry->setStatus(tr("Downloaded"));
+        //-- Check for more
+        _receivedAllData();
+    } else if ((bin + 1) == _downloadData->windowEnd) {
+        //-- The vehicle is done with the window, go on with the gaps behind it
+        _requestNextWindow(_downloadData->windowEnd);
+    }
 }
 
 //----------------------------------------------------------------------------------------
@@ -324,26 +294,39 @@ void
 LogDownloadController::_receivedAllData()
 {
     _timer.stop();
+    _rateTimer.stop();
     //-- Anything queued up for download?
-    if(_prepareLogDownload()) {
-        //-- Request Log
-        _requestLogData(_downloadData->ID, 0, _downloadData->chunk_table.size()*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-        _timer.start(kTimeOutMilliseconds);
-    } else {
-        _resetSelection();
-        _setDownloading(false);
+    while(_prepareLogDownload()) {
+        if(!_downloadData->complete()) {
+            //-- Request Log, the first window covers all of it
+            _requestNextWindow(0);
+            _rateTimer.start(kGUIRateMilliseconds);
+            return;
+        }
+        //-- Empty log
+        _downloadData->entry->setStatus(tr("Downloaded"));
     }
+    _resetSelection();
+    _setDownloading(false);
 }
 
 //----------------------------------------------------------------------------------------
 void
 LogDownloadController::_findMissingData()
 {
-    if (_logComplete()) {
+    if (_downloadData->complete()) {
          _receivedAllData();
          return;
-    } else if (_chunkComplete()) {
-        _downloadData->advanceChunk();
+    }
+
+    //-- Still receiving data, only time out once the vehicle has gone quiet
+    qint64 idle = _downloadData->windowRequested.elapsed();
+    if (_downloadData->lastData.isValid()) {
+        idle = qMin(idle, _downloadData->lastData.elapsed());
+    }
+    if (idle < kTimeOutMilliseconds) {
+        _timer.start(kTimeOutMilliseconds - idle);
+        return;
     }
 
     _retries++;
@@ -359,25 +342,37 @@ LogDownloadController::_findMissingData()
     }
 #endif
 
-    _updateDataRate();
+    //-- Request what is left of the window again
+    _requestNextWindow(_downloadData->windowStart);
+}
 
-    uint16_t start = 0, end = 0;
-    const int size = _downloadData->chunk_table.size();
-    for (; start < size; start++) {
-        if (!_downloadData->chunk_table.testBit(start)) {
-            break;
-        }
+//----------------------------------------------------------------------------------------
+void
+LogDownloadController::_requestNextWindow(uint32_t fromBin)
+{
+    uint32_t start = 0, end = 0;
+    if (!_downloadData->nextWindow(fromBin, _mergeBins(), start, end)) {
+        return;
     }
 
-    for (end = start; end < size; end++) {
-        if (_downloadData->chunk_table.testBit(end)) {
-            break;
-        }
-    }
+    _downloadData->windowStart = start;
+    _downloadData->windowEnd = end;
+    _downloadData->windowAnswered = false;
+    _downloadData->windowRequested.start();
 
-    const uint32_t pos = _downloadData->current_chunk*kChunkSize + start*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN,
-                   len = (end - start)*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
-    _requestLogData(_downloadData->ID, pos, len, _retries);
+    const quint64 pos = static_cast<quint64>(start) * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    const quint64 len = qMin(static_cast<quint64>(end) * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN, static_cast<quint64>(_downloadData->entry->size())) - pos;
+    _requestLogData(_downloadData->ID, static_cast<uint32_t>(pos), static_cast<uint32_t>(len), _retries);
+    _timer.start(kTimeOutMilliseconds);
+}
+
+//----------------------------------------------------------------------------------------
+uint32_t
+LogDownloadController::_mergeBins() const
+{
+    //-- Bins the link delivers while a request is on its way, resending fewer than that beats another round trip
+    const qreal bins = (_downloadData->rate_avg * _downloadData->rttMs) / (1000.0 * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
+    return qBound<uint32_t>(1, static_cast<uint32_t>(bins), kMaxMergeBins);
 }
 
 //----------------------------------------------------------------------------------------
@@ -539,21 +534,14 @@ LogDownloadController::_prepareLogDownload()
             _downloadData->file.setFileName(filename_spl[0] + '_' + QString::number(num_dups) + '.' + filename_spl[1]);
         } while( _downloadData->file.exists());
     }
-    //-- Create file
-    if (!_downloadData->file.open(QIODevice::WriteOnly)) {
-        qCWarning(LogDownloadControllerLog) << "Failed to create log file:" <<  _downloadData->filename;
-    } else {
-        //-- Preallocate file
-        if(!_downloadData->file.resize(entry->size())) {
-            qCWarning(LogDownloadControllerLog) << "Failed to allocate space for log file:" <<  _downloadData->filename;
-        } else {
-            _downloadData->current_chunk = 0;
-            _downloadData->chunk_table = QBitArray(_downloadData->chunkBins(), false);
-            _downloadData->elapsed.start();
-            result = true;
-        }
+    //-- Create and preallocate file
+    if (_downloadData->createFile(_downloadData->file.fileName())) {
+        _downloadData->elapsed.start();
+        _downloadData->total.start();
+        result = true;
     }
     if(!result) {
+        _downloadData->closeFile();
         if (_downloadData->file.exists()) {
             _downloadData->file.remove();
         }
@@ -611,8 +599,10 @@ void
 LogDownloadController::cancel(void)
 {
     _receivedAllEntries();
+    _rateTimer.stop();
     if(_downloadData) {
         _downloadData->entry->setStatus(tr("Canceled"));
+        _downloadData->closeFile();
         if (_downloadData->file.exists()) {
             _downloadData->file.remove();
         }
@@ -61,13 +61,13 @@ private slots:
 
 private:
     bool _entriesComplete   ();
-    bool _chunkComplete     () const;
-    bool _logComplete       () const;
     void _findMissingEntries();
     void _receivedAllEntries();
     void _receivedAllData   ();
     void _resetSelection    (bool canceled = false);
     void _findMissingData   ();
+    void _requestNextWindow (uint32_t fromBin);
+    uint32_t _mergeBins     () const;
     void _requestLogList    (uint32_t start, uint32_t end);
     void _requestLogData    (uint16_t id, uint32_t offset, uint32_t count, int retryCount = 0);
     bool _prepareLogDownload();
@@ -79,6 +79,7 @@ private:
 
     LogDownloadData*    _downloadData;
     QTimer              _timer;
+    QTimer              _rateTimer;
     QmlObjectListModel  _logEntriesModel;
     Vehicle*            _vehicle;
     bool                _requestingLogEntries;
@@ -14,14 +14,20 @@
 
 #include <QtCore/QtMath>
 
-#define kTableBins 512
-#define kChunkSize (kTableBins * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN)
+#include <cstring>
 
 QGC_LOGGING_CATEGORY(LogEntryLog, "qgc.analyzeview.logentry")
 
 //-----------------------------------------------------------------------------
 LogDownloadData::LogDownloadData(QGCLogEntry* entry_)
-    : ID(entry_->id())
+    : bins(qCeil(entry_->size() / static_cast<qreal>(MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN)), false)
+    , binsReceived(0)
+    , windowStart(0)
+    , windowEnd(0)
+    , windowAnswered(false)
+    , rttMs(0)
+    , fileMap(nullptr)
+    , ID(entry_->id())
     , entry(entry_)
     , written(0)
     , rate_bytes(0)
@@ -30,29 +36,105 @@ LogDownloadData::LogDownloadData(QGCLogEntry* entry_)
 
 }
 
-void LogDownloadData::advanceChunk()
+LogDownloadData::~LogDownloadData()
 {
-       current_chunk++;
-       chunk_table = QBitArray(chunkBins(), false);
+    closeFile();
 }
 
-// The number of MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN bins in the current chunk
-uint32_t LogDownloadData::chunkBins() const
+bool LogDownloadData::createFile(const QString& path)
 {
-    return qMin(qCeil((entry->size() - current_chunk*kChunkSize)/static_cast<qreal>(MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN)),
-                kTableBins);
+    file.setFileName(path);
+    // Mapping for writing needs a file opened for reading as well
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qCWarning(LogEntryLog) << "Failed to create log file:" << path << file.errorString();
+        return false;
+    }
+    if (!file.resize(entry->size())) {
+        qCWarning(LogEntryLog) << "Failed to allocate space for log file:" << path << file.errorString();
+        return false;
+    }
+    if (entry->size() > 0) {
+        fileMap = file.map(0, entry->size());
+        if (!fileMap) {
+            // Large logs may not fit the address space of 32 bit builds
+            qCDebug(LogEntryLog) << "Unable to map log file, writing through the file:" << path << file.errorString();
+        }
+    }
+    return true;
 }
 
-// The number of kChunkSize chunks in the file
-uint32_t LogDownloadData::numChunks() const
+void LogDownloadData::closeFile()
 {
-    return qCeil(entry->size() / static_cast<qreal>(kChunkSize));
+    if (fileMap) {
+        (void) file.unmap(fileMap);
+        fileMap = nullptr;
+    }
+    file.close();
 }
 
-// True if all bins in the chunk have been set to val
-bool LogDownloadData::chunkEquals(const bool val) const
+bool LogDownloadData::writeBin(uint32_t bin, const uint8_t* data, uint8_t count)
 {
-    return chunk_table == QBitArray(chunk_table.size(), val);
+    if (bins.testBit(bin)) {
+        return true;
+    }
+
+    const qint64 ofs = static_cast<qint64>(bin) * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    if (fileMap) {
+        memcpy(fileMap + ofs, data, count);
+    } else if (!file.seek(ofs) || (file.write(reinterpret_cast<const char*>(data), count) != count)) {
+        qCWarning(LogEntryLog) << "Error while writing log file @" << ofs << file.errorString();
+        return false;
+    }
+
+    bins.setBit(bin);
+    binsReceived++;
+    written += count;
+    rate_bytes += count;
+    return true;
+}
+
+uint32_t LogDownloadData::_findBin(uint32_t from, bool received) const
+{
+    const uint32_t size = static_cast<uint32_t>(bins.size());
+    const uchar* const bits = reinterpret_cast<const uchar*>(bins.bits());
+    // Bytes with all bins in the other state are skipped as a whole
+    const uchar skip = received ? 0x00 : 0xFF;
+
+    uint32_t bin = from;
+    while (bin < size) {
+        if (((bin & 7) == 0) && (bits[bin >> 3] == skip) && ((bin + 8) <= size)) {
+            bin += 8;
+            continue;
+        }
+        if (bins.testBit(bin) == received) {
+            return bin;
+        }
+        bin++;
+    }
+    return size;
+}
+
+bool LogDownloadData::nextWindow(uint32_t fromBin, uint32_t mergeBins, uint32_t& start, uint32_t& end) const
+{
+    const uint32_t size = static_cast<uint32_t>(bins.size());
+    if (complete()) {
+        return false;
+    }
+
+    start = _findBin(qMin(fromBin, size), false);
+    if (start == size) {
+        start = _findBin(0, false);
+    }
+
+    end = _findBin(start, true);
+    while (end < size) {
+        const uint32_t next = _findBin(end, false);
+        if ((next == size) || ((next - end) >= mergeBins)) {
+            break;
+        }
+        end = _findBin(next, true);
+    }
+    return true;
 }
 
 //----------------------------------------------------------------------------------------
@@ -14,6 +14,7 @@
 #include <QtCore/QString>
 #include <QtCore/QBitArray>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
 #include <QtCore/QLoggingCategory>
 #include <QtQmlIntegration/QtQmlIntegration>
 
@@ -68,12 +69,26 @@ private:
     QString     _status;
 };
 
+/// Download state of a single log. Every MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN bytes of the log are a bin with a bit
+/// in a bitmap over the whole file, so packets are taken in any order. The vehicle serves one LOG_REQUEST_DATA at a
+/// time, a new request replaces the one it is working on. The log is requested as a sequence of windows: the first
+/// one covers the whole file, the following ones the gaps left behind. Gaps separated by fewer received bins than the
+/// link delivers in a round trip are requested as one window, resending those bins is cheaper than waiting for
+/// another request to be answered.
 struct LogDownloadData {
     LogDownloadData(QGCLogEntry* entry);
+    ~LogDownloadData();
 
-    QBitArray     chunk_table;
-    uint32_t      current_chunk;
+    QBitArray     bins;                 ///< Received bins
+    uint32_t      binsReceived;
+    uint32_t      windowStart;          ///< First bin of the window requested last
+    uint32_t      windowEnd;            ///< One past the last bin of the window requested last
+    bool          windowAnswered;       ///< Data for the window requested last has been received
+    QElapsedTimer windowRequested;
+    QElapsedTimer lastData;
+    qreal         rttMs;                ///< Smoothed time from a request to its first data
     QFile         file;
+    uchar*        fileMap;              ///< Preallocated output file mapped for writing, nullptr: written through file
     QString       filename;
     uint          ID;
     QGCLogEntry*  entry;
@@ -81,9 +96,25 @@ struct LogDownloadData {
     size_t        rate_bytes;
     qreal         rate_avg;
     QElapsedTimer elapsed;
+    QElapsedTimer total;
 
-    void advanceChunk();
-    uint32_t chunkBins() const;
-    uint32_t numChunks() const;
-    bool chunkEquals(const bool val) const;
+    /// Creates the output file with the size of the log and maps it
+    bool createFile(const QString& path);
+    void closeFile();
+
+    /// Writes the data of a packet to the output file, bins which were already received are ignored
+    ///     @return false: the write failed
+    bool writeBin(uint32_t bin, const uint8_t* data, uint8_t count);
+
+    bool complete() const { return binsReceived == static_cast<uint32_t>(bins.size()); }
+
+    /// Finds the next window to request, starting at the first missing bin from fromBin onwards, wrapping around to
+    /// the start of the log
+    ///     @param mergeBins Gaps separated by fewer received bins than this are merged into the window
+    ///     @return false: no bins are missing
+    bool nextWindow(uint32_t fromBin, uint32_t mergeBins, uint32_t& start, uint32_t& end) const;
+
+private:
+    /// @return First bin at or after from with the given state, bins.size() if there is none
+    uint32_t _findBin(uint32_t from, bool received) const;
 };
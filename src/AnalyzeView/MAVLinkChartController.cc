@@ -77,7 +77,7 @@ MAVLinkChartController::updateYRange()
 {
     if(_chartFields.count()) {
         qreal vmin  = std::numeric_limits<qreal>::max();
-        qreal vmax  = std::numeric_limits<qreal>::min();
+        qreal vmax  = std::numeric_limits<qreal>::lowest();
         for(int i = 0; i < _chartFields.count(); i++) {
             QObject* object = qvariant_cast<QObject*>(_chartFields.at(i));
             QGCMAVLinkMessageField* pField = qobject_cast<QGCMAVLinkMessageField*>(object);
@@ -102,13 +102,18 @@ void
 MAVLinkChartController::_refreshSeries()
 {
     updateXRange();
+    const qint64 now = _rangeXMax.toMSecsSinceEpoch();
+    bool rangeChanged = false;
     for(int i = 0; i < _chartFields.count(); i++) {
         QObject* object = qvariant_cast<QObject*>(_chartFields.at(i));
         QGCMAVLinkMessageField* pField = qobject_cast<QGCMAVLinkMessageField*>(object);
         if(pField) {
-            pField->updateSeries();
+            rangeChanged |= pField->updateSeries(now, static_cast<int>(_rangeXIndex));
         }
     }
+    if(rangeChanged && (_rangeYIndex == 0)) {
+        updateYRange();
+    }
 }
 
 //-----------------------------------------------------------------------------
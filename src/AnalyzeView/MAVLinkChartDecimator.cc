@@ -0,0 +1,99 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkChartDecimator.h"
+
+#include <QtCore/QtNumeric>
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+MAVLinkChartDecimator::MAVLinkChartDecimator(qint64 windowMSecs, int columns)
+    : _windowMSecs(windowMSecs)
+    , _bucketMSecs(qMax<qint64>(windowMSecs / qMax(columns, 1), 1))
+    , _capacity((windowMSecs / _bucketMSecs) + 2)
+    , _buckets(std::make_unique<Bucket[]>(_capacity))
+{
+}
+
+//-----------------------------------------------------------------------------
+void
+MAVLinkChartDecimator::append(qint64 timeMSecs, double value)
+{
+    if(qIsNaN(value)) {
+        return;
+    }
+    const qint64 index = bucketIndex(timeMSecs);
+    Bucket& b = _buckets[index % _capacity];
+    if(b.index != index) {
+        if((_newestIndex >= 0) && (index <= (_newestIndex - _capacity))) {
+            // Older than anything still kept
+            return;
+        }
+        b.index     = index;
+        b.firstTime = b.minTime = b.maxTime = b.lastTime = timeMSecs;
+        b.first     = b.min     = b.max     = b.last     = value;
+        _newestIndex = qMax(_newestIndex, index);
+        return;
+    }
+    b.last      = value;
+    b.lastTime  = timeMSecs;
+    if(value < b.min) {
+        b.min       = value;
+        b.minTime   = timeMSecs;
+    }
+    if(value > b.max) {
+        b.max       = value;
+        b.maxTime   = timeMSecs;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+MAVLinkChartDecimator::clear()
+{
+    for(qint64 i = 0; i < _capacity; i++) {
+        _buckets[i].index = -1;
+    }
+    _newestIndex = -1;
+}
+
+//-----------------------------------------------------------------------------
+const MAVLinkChartDecimator::Bucket*
+MAVLinkChartDecimator::bucket(qint64 index) const
+{
+    if(index < 0) {
+        return nullptr;
+    }
+    const Bucket& b = _buckets[index % _capacity];
+    return (b.index == index) ? &b : nullptr;
+}
+
+//-----------------------------------------------------------------------------
+int
+MAVLinkChartDecimator::appendPoints(const Bucket& bucket, QList<QPointF>& points)
+{
+    QPointF p[4] = {
+        QPointF(bucket.firstTime,   bucket.first),
+        QPointF(bucket.minTime,     bucket.min),
+        QPointF(bucket.maxTime,     bucket.max),
+        QPointF(bucket.lastTime,    bucket.last),
+    };
+    std::stable_sort(std::begin(p), std::end(p), [](const QPointF& a, const QPointF& b) { return a.x() < b.x(); });
+
+    int count = 0;
+    for(int i = 0; i < 4; i++) {
+        if((i > 0) && (p[i] == p[i - 1])) {
+            continue;
+        }
+        points.append(p[i]);
+        count++;
+    }
+    return count;
+}
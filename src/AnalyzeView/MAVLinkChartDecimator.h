@@ -0,0 +1,64 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QPointF>
+
+#include <memory>
+
+//-----------------------------------------------------------------------------
+/// M4 decimation of a sample stream for one chart time scale.
+/// Time is split into fixed width buckets, one per plot column of the time scale. Each bucket only keeps its
+/// first, min, max and last sample, which is all a line series needs to draw that column exactly. Samples are
+/// aggregated as they arrive, so rendering a window costs at most 4 points per column however high the rate is.
+class MAVLinkChartDecimator
+{
+public:
+    struct Bucket {
+        qint64  index       = -1;   ///< Absolute bucket index (time / bucketMSecs), -1: slot unused
+        qint64  firstTime   = 0;
+        qint64  minTime     = 0;
+        qint64  maxTime     = 0;
+        qint64  lastTime    = 0;
+        double  first       = 0;
+        double  min         = 0;
+        double  max         = 0;
+        double  last        = 0;
+    };
+
+    MAVLinkChartDecimator(qint64 windowMSecs, int columns);
+
+    qint64  windowMSecs     () const { return _windowMSecs; }
+    qint64  bucketMSecs     () const { return _bucketMSecs; }
+    qint64  capacity        () const { return _capacity; }
+    qint64  bucketIndex     (qint64 timeMSecs) const { return timeMSecs / _bucketMSecs; }
+
+    /// Index of the newest bucket with samples, -1 if there are none
+    qint64  newestIndex     () const { return _newestIndex; }
+
+    /// NaN samples are ignored
+    void    append          (qint64 timeMSecs, double value);
+    void    clear           ();
+
+    /// @return nullptr if no sample fell into the bucket, or it has been reused for a newer one
+    const Bucket* bucket    (qint64 index) const;
+
+    /// Appends the points of the bucket in time order, without duplicates
+    ///     @return Number of points appended
+    static int appendPoints (const Bucket& bucket, QList<QPointF>& points);
+
+private:
+    qint64  _windowMSecs;
+    qint64  _bucketMSecs;
+    qint64  _capacity;                      ///< Buckets for the window plus slack for the partially visible ones
+    qint64  _newestIndex = -1;
+    std::unique_ptr<Bucket[]> _buckets;
+};
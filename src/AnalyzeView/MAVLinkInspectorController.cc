@@ -34,6 +34,8 @@ MAVLinkInspectorController::MAVLinkInspectorController()
     _timeScaleSt.append(new TimeScale_st(this, tr("10 Sec"), 10 * 1000));
     _timeScaleSt.append(new TimeScale_st(this, tr("30 Sec"), 30 * 1000));
     _timeScaleSt.append(new TimeScale_st(this, tr("60 Sec"), 60 * 1000));
+    _timeScaleSt.append(new TimeScale_st(this, tr("2 Min"),  2 * 60 * 1000));
+    _timeScaleSt.append(new TimeScale_st(this, tr("5 Min"),  5 * 60 * 1000));
     emit timeScalesChanged();
     _rangeSt.append(new Range_st(this, tr("Auto"),    0));
     _rangeSt.append(new Range_st(this, tr("10,000"),  10000));
@@ -135,7 +137,7 @@ MAVLinkInspectorController::_vehicleAdded(Vehicle* vehicle)
     QGCMAVLinkSystem* sys = _findVehicle(static_cast<uint8_t>(vehicle->id()));
     if(sys)
     {
-        sys->messages()->clearAndDeleteContents();
+        sys->clearMessages();
     }
     else
     {
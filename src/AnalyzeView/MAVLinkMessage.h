@@ -23,6 +23,8 @@
 
 Q_DECLARE_LOGGING_CATEGORY(MAVLinkMessageLog)
 
+class QGCMAVLinkMessageField;
+
 //-----------------------------------------------------------------------------
 /// MAVLink message
 class QGCMAVLinkMessage : public QObject
@@ -72,8 +74,10 @@ signals:
 
 private:
     void _updateFields(void);
+    const uint8_t* _payload() const { return reinterpret_cast<const uint8_t*>(&_message.payload64[0]); }
 
     QmlObjectListModel  _fields;
+    QList<QGCMAVLinkMessageField*> _chartedFields;  ///< Fields with a series, they take a sample from every message
     QString             _name;
     qreal               _actualRateHz   = 0.0;
     int32_t             _targetRateHz   = 0;
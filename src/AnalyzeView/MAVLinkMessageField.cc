@@ -9,23 +9,65 @@
 
 #include "MAVLinkMessageField.h"
 #include "MAVLinkChartController.h"
+#include "MAVLinkChartDecimator.h"
+#include "MAVLinkInspectorController.h"
 #include "MAVLinkMessage.h"
 #include "QGC.h"
 #include "QGCLoggingCategory.h"
 
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QAbstractSeries>
+#include <QtCore/QDateTime>
+
+#include <cstring>
+#include <limits>
 
 QGC_LOGGING_CATEGORY(MAVLinkMessageFieldLog, "qgc.analyzeview.mavlinkmessagefield")
 
+namespace {
+
+template<typename T>
+T readElement(const char* data, int index)
+{
+    T v;
+    memcpy(&v, data + (index * sizeof(T)), sizeof(T));
+    return v;
+}
+
+}
+
 //-----------------------------------------------------------------------------
-QGCMAVLinkMessageField::QGCMAVLinkMessageField(QGCMAVLinkMessage *parent, QString name, QString type)
+QGCMAVLinkMessageField::QGCMAVLinkMessageField(QGCMAVLinkMessage *parent, const mavlink_field_info_t& fieldInfo)
     : QObject(parent)
-    , _type(type)
-    , _name(name)
+    , _type(QStringLiteral("?"))
+    , _name(fieldInfo.name)
+    , _mavType(fieldInfo.type)
+    , _wireOffset(static_cast<int>(fieldInfo.wire_offset))
+    , _arrayLength(static_cast<int>(fieldInfo.array_length))
     , _msg(parent)
 {
-    qCDebug(MAVLinkMessageFieldLog) << "Field:" << name << type;
+    int elementSize = 0;
+    switch (_mavType) {
+        case MAVLINK_TYPE_CHAR:     _type = QStringLiteral("char");     elementSize = 1; _selectable = false; break;
+        case MAVLINK_TYPE_UINT8_T:  _type = QStringLiteral("uint8_t");  elementSize = 1; break;
+        case MAVLINK_TYPE_INT8_T:   _type = QStringLiteral("int8_t");   elementSize = 1; break;
+        case MAVLINK_TYPE_UINT16_T: _type = QStringLiteral("uint16_t"); elementSize = 2; break;
+        case MAVLINK_TYPE_INT16_T:  _type = QStringLiteral("int16_t");  elementSize = 2; break;
+        case MAVLINK_TYPE_UINT32_T: _type = QStringLiteral("uint32_t"); elementSize = 4; break;
+        case MAVLINK_TYPE_INT32_T:  _type = QStringLiteral("int32_t");  elementSize = 4; break;
+        case MAVLINK_TYPE_FLOAT:    _type = QStringLiteral("float");    elementSize = 4; break;
+        case MAVLINK_TYPE_DOUBLE:   _type = QStringLiteral("double");   elementSize = 8; break;
+        case MAVLINK_TYPE_UINT64_T: _type = QStringLiteral("uint64_t"); elementSize = 8; break;
+        case MAVLINK_TYPE_INT64_T:  _type = QStringLiteral("int64_t");  elementSize = 8; break;
+    }
+    _byteSize = elementSize * qMax(_arrayLength, 1);
+
+    qCDebug(MAVLinkMessageFieldLog) << "Field:" << _name << _type;
+}
+
+//-----------------------------------------------------------------------------
+QGCMAVLinkMessageField::~QGCMAVLinkMessageField()
+{
 }
 
 //-----------------------------------------------------------------------------
@@ -35,8 +77,13 @@ QGCMAVLinkMessageField::addSeries(MAVLinkChartController* chart, QAbstractSeries
     if(!_pSeries) {
         _chart = chart;
         _pSeries = series;
+        for(const MAVLinkInspectorController::TimeScale_st* timeScale : chart->controller()->timeScaleSt()) {
+            _decimators.push_back(std::make_unique<MAVLinkChartDecimator>(timeScale->timeScale, kChartColumns));
+        }
+        _seriesBuckets.clear();
+        _seriesPointCount = 0;
+        _seriesTimeScale = -1;
         emit seriesChanged();
-        _dataIndex = 0;
         _msg->updateFieldSelection();
     }
 }
@@ -46,9 +93,12 @@ void
 QGCMAVLinkMessageField::delSeries()
 {
     if(_pSeries) {
-        _values.clear();
+        _decimators.clear();
+        _seriesBuckets.clear();
+        _seriesPointCount = 0;
+        _seriesTimeScale = -1;
         QLineSeries* lineSeries = static_cast<QLineSeries*>(_pSeries);
-        lineSeries->replace(_values);
+        lineSeries->replace(QList<QPointF>());
         _pSeries = nullptr;
         _chart   = nullptr;
         emit seriesChanged();
@@ -64,16 +114,6 @@ QGCMAVLinkMessageField::label()
     return QString(_msg->name() + ": " + _name);
 }
 
-//-----------------------------------------------------------------------------
-void
-QGCMAVLinkMessageField::setSelectable(bool sel)
-{
-    if(_selectable != sel) {
-        _selectable = sel;
-        emit selectableChanged();
-    }
-}
-
 //-----------------------------------------------------------------------------
 int
 QGCMAVLinkMessageField::chartIndex()
@@ -83,66 +123,197 @@ QGCMAVLinkMessageField::chartIndex()
     return 0;
 }
 
+//-----------------------------------------------------------------------------
+QString
+QGCMAVLinkMessageField::value()
+{
+    if(_valueDirty) {
+        _value = _formatValue();
+        _valueDirty = false;
+    }
+    return _value;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCMAVLinkMessageField::setPayload(const uint8_t* payload)
+{
+    const char* const bytes = reinterpret_cast<const char*>(payload + _wireOffset);
+    if((_rawValue.size() == _byteSize) && (memcmp(_rawValue.constData(), bytes, _byteSize) == 0)) {
+        return;
+    }
+    _rawValue.resize(_byteSize);
+    memcpy(_rawValue.data(), bytes, _byteSize);
+    _valueDirty = true;
+    emit valueChanged();
+}
+
 //-----------------------------------------------------------------------------
 void
-QGCMAVLinkMessageField::updateValue(QString newValue, qreal v)
+QGCMAVLinkMessageField::appendSample(qint64 timeMSecs, const uint8_t* payload)
 {
-    if(_value != newValue) {
-        _value = newValue;
-        emit valueChanged();
-    }
-    if(_pSeries && _chart) {
-        int count = _values.count();
-        //-- Arbitrary limit of 1 minute of data at 50Hz for now
-        if(count < (50 * 60)) {
-            QPointF p(QGC::bootTimeMilliseconds(), v);
-            _values.append(p);
-        } else {
-            if(_dataIndex >= count) _dataIndex = 0;
-            _values[_dataIndex].setX(QGC::bootTimeMilliseconds());
-            _values[_dataIndex].setY(v);
-            _dataIndex++;
+    const double value = _elementValue(reinterpret_cast<const char*>(payload + _wireOffset), 0);
+    for(const auto& decimator : _decimators) {
+        decimator->append(timeMSecs, value);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCMAVLinkMessageField::updateSeries(qint64 nowMSecs, int timeScaleIndex)
+{
+    if(!_pSeries || !_chart || (timeScaleIndex < 0) || (timeScaleIndex >= static_cast<int>(_decimators.size()))) {
+        return false;
+    }
+    const MAVLinkChartDecimator& decimator = *_decimators[timeScaleIndex];
+    QLineSeries* lineSeries = static_cast<QLineSeries*>(_pSeries);
+    const qint64 firstIndex = decimator.bucketIndex(nowMSecs - decimator.windowMSecs());
+
+    bool rebuild = (timeScaleIndex != _seriesTimeScale);
+    qint64 fromIndex = firstIndex;
+    if(!rebuild) {
+        //-- Drop what scrolled out of the window
+        int removeCount = 0;
+        while(!_seriesBuckets.isEmpty() && (_seriesBuckets.first().index < firstIndex)) {
+            removeCount += _seriesBuckets.takeFirst().pointCount;
         }
-        //-- Auto Range
-        if(_chart->rangeYIndex() == 0) {
-            qreal vmin  = std::numeric_limits<qreal>::max();
-            qreal vmax  = std::numeric_limits<qreal>::min();
-            for(int i = 0; i < _values.count(); i++) {
-                qreal v = _values[i].y();
-                if(vmax < v) vmax = v;
-                if(vmin > v) vmin = v;
-            }
-            bool changed = false;
-            if(std::abs(_rangeMin - vmin) > 0.000001) {
-                _rangeMin = vmin;
-                changed = true;
+        if(removeCount) {
+            lineSeries->removePoints(0, removeCount);
+            _seriesPointCount -= removeCount;
+        }
+        //-- The newest bucket shown may have been filling since, it is redone along with everything after it
+        if(!_seriesBuckets.isEmpty()) {
+            const SeriesBucket last = _seriesBuckets.takeLast();
+            fromIndex = last.index;
+            if(decimator.bucket(fromIndex)) {
+                lineSeries->removePoints(static_cast<int>(_seriesPointCount - last.pointCount), last.pointCount);
+                _seriesPointCount -= last.pointCount;
+            } else {
+                rebuild = true;
             }
-            if(std::abs(_rangeMax - vmax) > 0.000001) {
-                _rangeMax = vmax;
-                changed = true;
+        }
+    }
+    if(rebuild) {
+        _seriesBuckets.clear();
+        _seriesPointCount = 0;
+        _seriesTimeScale = timeScaleIndex;
+        fromIndex = firstIndex;
+    }
+
+    QList<QPointF> points;
+    const qint64 newestIndex = decimator.newestIndex();
+    for(qint64 index = qMax(fromIndex, newestIndex - decimator.capacity() + 1); index <= newestIndex; index++) {
+        const MAVLinkChartDecimator::Bucket* bucket = decimator.bucket(index);
+        if(bucket) {
+            const int count = MAVLinkChartDecimator::appendPoints(*bucket, points);
+            _seriesBuckets.append(SeriesBucket{ index, count, bucket->min, bucket->max });
+        }
+    }
+    _seriesPointCount += points.count();
+    if(rebuild) {
+        lineSeries->replace(points);
+    } else if(!points.isEmpty()) {
+        lineSeries->append(points);
+    }
+
+    //-- Auto Range over the window
+    if(_chart->rangeYIndex() != 0 || _seriesBuckets.isEmpty()) {
+        return false;
+    }
+    qreal vmin = std::numeric_limits<qreal>::max();
+    qreal vmax = std::numeric_limits<qreal>::lowest();
+    for(const SeriesBucket& bucket : _seriesBuckets) {
+        vmin = std::min(vmin, bucket.min);
+        vmax = std::max(vmax, bucket.max);
+    }
+    bool changed = false;
+    if(std::abs(_rangeMin - vmin) > 0.000001) {
+        _rangeMin = vmin;
+        changed = true;
+    }
+    if(std::abs(_rangeMax - vmax) > 0.000001) {
+        _rangeMax = vmax;
+        changed = true;
+    }
+    return changed;
+}
+
+//-----------------------------------------------------------------------------
+double
+QGCMAVLinkMessageField::_elementValue(const char* data, int index) const
+{
+    switch (_mavType) {
+        case MAVLINK_TYPE_CHAR:     return static_cast<double>(readElement<char>(data, index));
+        case MAVLINK_TYPE_UINT8_T:  return static_cast<double>(readElement<uint8_t>(data, index));
+        case MAVLINK_TYPE_INT8_T:   return static_cast<double>(readElement<int8_t>(data, index));
+        case MAVLINK_TYPE_UINT16_T: return static_cast<double>(readElement<uint16_t>(data, index));
+        case MAVLINK_TYPE_INT16_T:  return static_cast<double>(readElement<int16_t>(data, index));
+        case MAVLINK_TYPE_UINT32_T: return static_cast<double>(readElement<uint32_t>(data, index));
+        case MAVLINK_TYPE_INT32_T:  return static_cast<double>(readElement<int32_t>(data, index));
+        case MAVLINK_TYPE_FLOAT:    return static_cast<double>(readElement<float>(data, index));
+        case MAVLINK_TYPE_DOUBLE:   return readElement<double>(data, index);
+        case MAVLINK_TYPE_UINT64_T: return static_cast<double>(readElement<uint64_t>(data, index));
+        case MAVLINK_TYPE_INT64_T:  return static_cast<double>(readElement<int64_t>(data, index));
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+QString
+QGCMAVLinkMessageField::_elementString(const char* data, int index) const
+{
+    switch (_mavType) {
+        case MAVLINK_TYPE_UINT8_T:  return QString::number(readElement<uint8_t>(data, index));
+        case MAVLINK_TYPE_INT8_T:   return QString::number(readElement<int8_t>(data, index));
+        case MAVLINK_TYPE_UINT16_T: return QString::number(readElement<uint16_t>(data, index));
+        case MAVLINK_TYPE_INT16_T:  return QString::number(readElement<int16_t>(data, index));
+        case MAVLINK_TYPE_UINT32_T:
+        {
+            const uint32_t n = readElement<uint32_t>(data, index);
+            //-- Special case
+            if((_arrayLength == 0) && (_msg->id() == MAVLINK_MSG_ID_SYSTEM_TIME)) {
+                return QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(n), Qt::UTC, 0).toString("HH:mm:ss");
             }
-            if(changed) {
-                _chart->updateYRange();
+            return QString::number(n);
+        }
+        case MAVLINK_TYPE_INT32_T:  return QString::number(readElement<int32_t>(data, index));
+        case MAVLINK_TYPE_FLOAT:    return QString::number(static_cast<double>(readElement<float>(data, index)));
+        case MAVLINK_TYPE_DOUBLE:   return QString::number(readElement<double>(data, index));
+        case MAVLINK_TYPE_UINT64_T:
+        {
+            const uint64_t n = readElement<uint64_t>(data, index);
+            //-- Special case
+            if((_arrayLength == 0) && (_msg->id() == MAVLINK_MSG_ID_SYSTEM_TIME)) {
+                return QDateTime::fromMSecsSinceEpoch(n / 1000, Qt::UTC, 0).toString("yyyy MM dd HH:mm:ss");
             }
+            return QString::number(n);
         }
+        case MAVLINK_TYPE_INT64_T:  return QString::number(readElement<int64_t>(data, index));
     }
+    return QString();
 }
 
 //-----------------------------------------------------------------------------
-void
-QGCMAVLinkMessageField::updateSeries()
+QString
+QGCMAVLinkMessageField::_formatValue() const
 {
-    int count = _values.count();
-    if (count > 1) {
-        QList<QPointF> s;
-        s.reserve(count);
-        int idx = _dataIndex;
-        for(int i = 0; i < count; i++, idx++) {
-            if(idx >= count) idx = 0;
-            QPointF p(_values[idx]);
-            s.append(p);
+    if(_rawValue.size() != _byteSize) {
+        return QString();
+    }
+    const char* const data = _rawValue.constData();
+    if(_mavType == MAVLINK_TYPE_CHAR) {
+        // Strings are not necessarily null terminated
+        return (_arrayLength > 0) ? QString::fromUtf8(data, static_cast<qsizetype>(qstrnlen(data, _arrayLength))) : QString(QChar(data[0]));
+    }
+    if(_arrayLength == 0) {
+        return _elementString(data, 0);
+    }
+    QString string;
+    for(int i = 0; i < _arrayLength; i++) {
+        if(i) {
+            string += QStringLiteral(", ");
         }
-        QLineSeries* lineSeries = static_cast<QLineSeries*>(_pSeries);
-        lineSeries->replace(s);
+        string += _elementString(data, i);
     }
+    return string;
 }
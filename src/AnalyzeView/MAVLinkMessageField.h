@@ -15,18 +15,27 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QString>
-#include <QtCore/QPointF>
+#include <QtCore/QByteArray>
 #include <QtCore/QLoggingCategory>
 #include <QtQmlIntegration/QtQmlIntegration>
 
+#include <memory>
+#include <vector>
+
+#include "MAVLinkLib.h"
+
 Q_DECLARE_LOGGING_CATEGORY(MAVLinkMessageFieldLog)
 
 class QGCMAVLinkMessage;
 class MAVLinkChartController;
 class QAbstractSeries;
+class MAVLinkChartDecimator;
 
 //-----------------------------------------------------------------------------
 /// MAVLink message field
+/// Nothing is formatted as messages arrive. The raw bytes of the field are kept while its message is visible and
+/// only turned into a string when the UI reads value. Charted fields aggregate their samples per chart time scale
+/// (see MAVLinkChartDecimator) and only push the changed tail of the window to the series.
 class QGCMAVLinkMessageField : public QObject
 {
     Q_OBJECT
@@ -38,47 +47,77 @@ public:
     Q_PROPERTY(QString          label       READ label      CONSTANT)
     Q_PROPERTY(QString          type        READ type       CONSTANT)
     Q_PROPERTY(QString          value       READ value      NOTIFY valueChanged)
-    Q_PROPERTY(bool             selectable  READ selectable NOTIFY selectableChanged)
+    Q_PROPERTY(bool             selectable  READ selectable CONSTANT)
     Q_PROPERTY(int              chartIndex  READ chartIndex CONSTANT)
     Q_PROPERTY(QAbstractSeries* series      READ series     NOTIFY seriesChanged)
 
-    QGCMAVLinkMessageField(QGCMAVLinkMessage* parent, QString name, QString type);
+    QGCMAVLinkMessageField(QGCMAVLinkMessage* parent, const mavlink_field_info_t& fieldInfo);
+    ~QGCMAVLinkMessageField();
 
     QString         name            () { return _name;  }
     QString         label           ();
     QString         type            () { return _type;  }
-    QString         value           () { return _value; }
+    QString         value           ();
     bool            selectable      () const{ return _selectable; }
     bool            selected        () { return _pSeries != nullptr; }
     QAbstractSeries*series          () { return _pSeries; }
-    QList<QPointF>* values          () { return &_values;}
     qreal           rangeMin        () const{ return _rangeMin; }
     qreal           rangeMax        () const{ return _rangeMax; }
     int             chartIndex      ();
 
-    void            setSelectable   (bool sel);
-    void            updateValue     (QString newValue, qreal v);
+    /// Takes the raw bytes of the field from the message payload. valueChanged is only emitted if they changed.
+    void            setPayload      (const uint8_t* payload);
+
+    /// Adds the numeric value of the field (first element for arrays) to the chart samples
+    void            appendSample    (qint64 timeMSecs, const uint8_t* payload);
 
     void            addSeries       (MAVLinkChartController* chart, QAbstractSeries* series);
     void            delSeries       ();
-    void            updateSeries    ();
+
+    /// Brings the series up to date with the window of the time scale ending at nowMSecs
+    ///     @return true: Auto range min/max changed
+    bool            updateSeries    (qint64 nowMSecs, int timeScaleIndex);
+
+    /// Plot columns per time scale, each one is drawn from at most 4 points
+    static constexpr int kChartColumns = 1000;
 
 signals:
     void            seriesChanged       ();
-    void            selectableChanged   ();
     void            valueChanged        ();
 
 private:
+    double          _elementValue   (const char* data, int index) const;
+    QString         _elementString  (const char* data, int index) const;
+    QString         _formatValue    () const;
+
     QString     _type;
     QString     _name;
     QString     _value;
+    QByteArray  _rawValue;                  ///< Field bytes from the last payload of a visible message
+    bool        _valueDirty = false;        ///< true: _value needs formatting from _rawValue
     bool        _selectable = true;
-    int         _dataIndex  = 0;
     qreal       _rangeMin   = 0;
     qreal       _rangeMax   = 0;
 
+    uint8_t     _mavType        = MAVLINK_TYPE_CHAR;
+    int         _wireOffset     = 0;
+    int         _arrayLength    = 0;        ///< 0: single value
+    int         _byteSize       = 0;
+
     QAbstractSeries*    _pSeries = nullptr;
     QGCMAVLinkMessage*  _msg     = nullptr;
     MAVLinkChartController*      _chart   = nullptr;
-    QList<QPointF>      _values;
+
+    /// Bucket currently shown by the series
+    struct SeriesBucket {
+        qint64  index;
+        int     pointCount;
+        double  min;
+        double  max;
+    };
+
+    std::vector<std::unique_ptr<MAVLinkChartDecimator>> _decimators;   ///< One per chart time scale, only while charted
+    QList<SeriesBucket> _seriesBuckets;
+    qsizetype           _seriesPointCount   = 0;
+    int                 _seriesTimeScale    = -1;   ///< Time scale the series shows, -1: needs a full rebuild
 };
@@ -31,15 +31,7 @@ QGCMAVLinkSystem::~QGCMAVLinkSystem()
 QGCMAVLinkMessage*
 QGCMAVLinkSystem::findMessage(uint32_t id, uint8_t compId)
 {
-    for(int i = 0; i < _messages.count(); i++) {
-        QGCMAVLinkMessage* m = qobject_cast<QGCMAVLinkMessage*>(_messages.get(i));
-        if(m) {
-            if(m->id() == id && m->compId() == compId) {
-                return m;
-            }
-        }
-    }
-    return nullptr;
+    return _messageLookup.value((static_cast<quint64>(compId) << 32) | id, nullptr);
 }
 
 //-----------------------------------------------------------------------------
@@ -118,6 +110,7 @@ QGCMAVLinkSystem::append(QGCMAVLinkMessage* message)
         message->setSelected(true);
     }
     _messages.append(message);
+    _messageLookup.insert((static_cast<quint64>(message->compId()) << 32) | message->id(), message);
     //-- Sort messages by id and then compId
     if (_messages.count() > 0) {
         _messages.beginReset();
@@ -135,6 +128,14 @@ QGCMAVLinkSystem::append(QGCMAVLinkMessage* message)
     }
 }
 
+//-----------------------------------------------------------------------------
+void
+QGCMAVLinkSystem::clearMessages()
+{
+    _messageLookup.clear();
+    _messages.clearAndDeleteContents();
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCMAVLinkSystem::_checkCompID(QGCMAVLinkMessage* message)
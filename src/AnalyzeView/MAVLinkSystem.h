@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <QtCore/QHash>
 #include <QtCore/QObject>
 #include <QtCore/QStringList>
 #include <QtCore/QLoggingCategory>
@@ -51,6 +52,7 @@ public:
     QGCMAVLinkMessage*  findMessage     (uint32_t id, uint8_t compId);
     int                 findMessage     (QGCMAVLinkMessage* message);
     void                append          (QGCMAVLinkMessage* message);
+    void                clearMessages   ();
     QGCMAVLinkMessage*  selectedMsg     ();
 
 signals:
@@ -66,5 +68,6 @@ private:
     QList<int>          _compIDs;
     QStringList         _compIDsStr;
     QmlObjectListModel  _messages;      //-- List of QGCMAVLinkMessage
+    QHash<quint64, QGCMAVLinkMessage*> _messageLookup;  ///< compId << 32 | msgId, lookup for every received message
     int                 _selected = 0;
 };
@@ -9,6 +9,7 @@
 
 #include "LinkInterface.h"
 #include "LinkManager.h"
+#include "MAVLinkProtocol.h"
 #include "QGCApplication.h"
 #include "QGCLoggingCategory.h"
 #include "MAVLinkSigning.h"
@@ -58,7 +59,13 @@ bool LinkInterface::initMavlinkSigning(void)
     if (!isSecureConnection()) {
         auto appSettings = SettingsManager::instance()->appSettings();
         QByteArray signingKeyBytes = appSettings->mavlink2SigningKey()->rawValue().toByteArray();
-        if (MAVLinkSigning::initSigning(static_cast<mavlink_channel_t>(_mavlinkChannel), signingKeyBytes, MAVLinkSigning::insecureConnectionAccceptUnsignedCallback)) {
+        // The parser reads the signing state of the channel on the protocol thread
+        bool initialized = false;
+        const mavlink_channel_t channel = static_cast<mavlink_channel_t>(_mavlinkChannel);
+        MAVLinkProtocol::instance()->runOnProtocolThread([channel, &signingKeyBytes, &initialized]() {
+            initialized = MAVLinkSigning::initSigning(channel, signingKeyBytes, MAVLinkSigning::insecureConnectionAccceptUnsignedCallback);
+        });
+        if (initialized) {
             if (signingKeyBytes.isEmpty()) {
                 qCDebug(LinkInterfaceLog) << "Signing disabled on channel" << _mavlinkChannel;
             } else {
@@ -172,14 +172,16 @@ bool LinkManager::createConnectedLink(SharedLinkConfigurationPtr &config)
     config->setLink(link);
 
     (void) connect(link.get(), &LinkInterface::communicationError, qgcApp(), &QGCApplication::showAppMessage);
-    (void) connect(link.get(), &LinkInterface::bytesReceived, MAVLinkProtocol::instance(), &MAVLinkProtocol::receiveBytes);
-    (void) connect(link.get(), &LinkInterface::bytesSent, MAVLinkProtocol::instance(), &MAVLinkProtocol::logSentBytes);
+    MAVLinkProtocol::instance()->registerLink(link.get());
     (void) connect(link.get(), &LinkInterface::disconnected, this, &LinkManager::_linkDisconnected);
 
     MAVLinkProtocol::instance()->resetMetadataForLink(link.get());
     MAVLinkProtocol::instance()->setVersion(MAVLinkProtocol::instance()->getCurrentVersion());
 
     if (!link->_connect()) {
+        (void) disconnect(link.get(), &LinkInterface::communicationError, qgcApp(), &QGCApplication::showAppMessage);
+        (void) disconnect(link.get(), &LinkInterface::disconnected, this, &LinkManager::_linkDisconnected);
+        MAVLinkProtocol::instance()->unregisterLink(link.get());
         link->_freeMavlinkChannel();
         _rgLinks.removeAt(_rgLinks.indexOf(link));
         config->setLink(nullptr);
@@ -230,8 +232,7 @@ void LinkManager::_linkDisconnected()
     }
 
     (void) disconnect(link, &LinkInterface::communicationError, qgcApp(), &QGCApplication::showAppMessage);
-    (void) disconnect(link, &LinkInterface::bytesReceived, MAVLinkProtocol::instance(), &MAVLinkProtocol::receiveBytes);
-    (void) disconnect(link, &LinkInterface::bytesSent, MAVLinkProtocol::instance(), &MAVLinkProtocol::logSentBytes);
+    MAVLinkProtocol::instance()->unregisterLink(link);
     (void) disconnect(link, &LinkInterface::disconnected, this, &LinkManager::_linkDisconnected);
 
     link->_freeMavlinkChannel();
@@ -677,9 +678,11 @@ uint8_t LinkManager::allocateMavlinkChannel()
             continue;
         }
 
-        mavlink_reset_channel_status(mavlinkChannel);
-        mavlink_status_t* const mavlinkStatus = mavlink_get_channel_status(mavlinkChannel);
-        mavlinkStatus->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        MAVLinkProtocol::instance()->runOnProtocolThread([mavlinkChannel]() {
+            mavlink_reset_channel_status(mavlinkChannel);
+            mavlink_status_t* const mavlinkStatus = mavlink_get_channel_status(mavlinkChannel);
+            mavlinkStatus->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        });
         _mavlinkChannelsUsedBitMask |= (1 << mavlinkChannel);
         qCDebug(LinkManagerLog) << "allocateMavlinkChannel" << mavlinkChannel;
         return mavlinkChannel;
@@ -0,0 +1,239 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LogReplayIndex.h"
+#include "MAVLinkLib.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(LogReplayIndexLog, "qgc.comms.logreplayindex")
+
+quint64 LogReplayIndex::nowUSecs()
+{
+    return static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()) * 1000;
+}
+
+bool LogReplayIndex::parseRecord(const uchar *data, qint64 size, qint64 offset, quint64 nowUSecs, quint64 &timestampUSecs, qint64 &frameLength)
+{
+    static constexpr qint64 kV1HeaderLen = 6;
+    static constexpr qint64 kV2HeaderLen = MAVLINK_NUM_HEADER_BYTES;
+
+    const qint64 frameOffset = offset + kTimestampLen;
+    if ((frameOffset + kV1HeaderLen) > size) {
+        return false;
+    }
+
+    const uchar *const frame = data + frameOffset;
+    const bool mavlink1 = (frame[0] == MAVLINK_STX_MAVLINK1);
+    if (!mavlink1 && (frame[0] != MAVLINK_STX)) {
+        return false;
+    }
+
+    const qint64 headerLen = mavlink1 ? kV1HeaderLen : kV2HeaderLen;
+    if ((frameOffset + headerLen) > size) {
+        return false;
+    }
+
+    const uint8_t payloadLen = frame[1];
+    const bool signedFrame = !mavlink1 && (frame[2] & MAVLINK_IFLAG_SIGNED);
+    const qint64 length = headerLen + payloadLen + MAVLINK_NUM_CHECKSUM_BYTES + (signedFrame ? MAVLINK_SIGNATURE_BLOCK_LEN : 0);
+    if ((frameOffset + length) > size) {
+        return false;
+    }
+
+    // Same CRC rules as mavlink_parse_char, messages it would reject are not records either
+    const uint32_t msgid = mavlink1 ? frame[5] : (frame[7] | (frame[8] << 8) | (frame[9] << 16));
+    const mavlink_msg_entry_t *const entry = mavlink_get_msg_entry(msgid);
+    if (!entry) {
+        return false;
+    }
+    uint16_t crc;
+    crc_init(&crc);
+    crc_accumulate_buffer(&crc, reinterpret_cast<const char*>(frame + 1), static_cast<uint16_t>(headerLen - 1 + payloadLen));
+    crc_accumulate(entry->crc_extra, &crc);
+    const uchar *const ck = frame + headerLen + payloadLen;
+    if ((ck[0] != (crc & 0xFF)) || (ck[1] != (crc >> 8))) {
+        return false;
+    }
+
+    quint64 timestamp = qFromBigEndian<quint64>(data + offset);
+    if (timestamp > nowUSecs) {
+        // Old logs stored the timestamp little endian
+        timestamp = qbswap(timestamp);
+    }
+    if ((timestamp == 0) || (timestamp > nowUSecs)) {
+        return false;
+    }
+
+    timestampUSecs = timestamp;
+    frameLength = length;
+    return true;
+}
+
+qint64 LogReplayIndex::nextRecord(const uchar *data, qint64 size, qint64 offset, quint64 nowUSecs)
+{
+    quint64 timestamp;
+    qint64 frameLength;
+
+    for (qint64 pos = qMax<qint64>(offset, 0); (pos + kTimestampLen) < size; pos++) {
+        // Cheap STX test before the full validation
+        const uchar stx = data[pos + kTimestampLen];
+        if ((stx != MAVLINK_STX) && (stx != MAVLINK_STX_MAVLINK1)) {
+            continue;
+        }
+        if (parseRecord(data, size, pos, nowUSecs, timestamp, frameLength)) {
+            return pos;
+        }
+    }
+
+    return -1;
+}
+
+bool LogReplayIndex::build(const uchar *data, qint64 size, const std::atomic_bool *cancel)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    _entries.clear();
+    _recordCount = 0;
+    _startTimeUSecs = 0;
+    _endTimeUSecs = 0;
+
+    const quint64 now = nowUSecs();
+    quint64 maxTimestamp = 0;
+    qint64 offset = nextRecord(data, size, 0, now);
+
+    while (offset >= 0) {
+        if (cancel && ((_recordCount % 4096) == 0) && cancel->load(std::memory_order_relaxed)) {
+            _entries.clear();
+            return false;
+        }
+
+        quint64 timestamp;
+        qint64 frameLength;
+        (void) parseRecord(data, size, offset, now, timestamp, frameLength);
+
+        if (_recordCount == 0) {
+            _startTimeUSecs = timestamp;
+        }
+        maxTimestamp = qMax(maxTimestamp, timestamp);
+        _endTimeUSecs = timestamp;
+
+        if ((_recordCount % kStride) == 0) {
+            _entries.append(Entry{ maxTimestamp, offset });
+        }
+        _recordCount++;
+
+        const qint64 next = offset + kTimestampLen + frameLength;
+        quint64 nextTimestamp;
+        qint64 nextFrameLength;
+        offset = parseRecord(data, size, next, now, nextTimestamp, nextFrameLength) ? next : nextRecord(data, size, next, now);
+    }
+
+    qCDebug(LogReplayIndexLog) << "Indexed" << _recordCount << "records," << size << "bytes in" << timer.elapsed() << "msecs";
+
+    return isValid();
+}
+
+qint64 LogReplayIndex::seek(const uchar *data, qint64 size, quint64 timeUSecs) const
+{
+    if (_entries.isEmpty()) {
+        return -1;
+    }
+
+    // Last entry which starts before the requested time, the exact record lies within the next kStride records
+    auto it = std::lower_bound(_entries.constBegin(), _entries.constEnd(), timeUSecs, [](const Entry &entry, quint64 time) {
+        return entry.timestampUSecs < time;
+    });
+    if (it != _entries.constBegin()) {
+        --it;
+    }
+
+    const quint64 now = nowUSecs();
+    qint64 offset = it->offset;
+    while (offset >= 0) {
+        quint64 timestamp;
+        qint64 frameLength;
+        if (!parseRecord(data, size, offset, now, timestamp, frameLength)) {
+            offset = nextRecord(data, size, offset, now);
+            continue;
+        }
+        if (timestamp >= timeUSecs) {
+            return offset;
+        }
+        offset += kTimestampLen + frameLength;
+    }
+
+    return -1;
+}
+
+bool LogReplayIndex::load(const QString &indexFileName, qint64 logSize, qint64 logModifiedMSecs)
+{
+    QFile file(indexFileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 size = 0;
+    qint64 modified = 0;
+    quint64 stride = 0;
+    stream >> magic >> version >> size >> modified >> stride;
+    if ((magic != kFileMagic) || (version != kFileVersion) || (size != logSize) || (modified != logModifiedMSecs) || (stride != kStride)) {
+        qCDebug(LogReplayIndexLog) << "Stale index" << indexFileName;
+        return false;
+    }
+
+    quint64 entryCount = 0;
+    stream >> _startTimeUSecs >> _endTimeUSecs >> _recordCount >> entryCount;
+    if ((stream.status() != QDataStream::Ok) || (entryCount > static_cast<quint64>(logSize / kTimestampLen))) {
+        return false;
+    }
+
+    _entries.resize(static_cast<qsizetype>(entryCount));
+    for (Entry &entry : _entries) {
+        stream >> entry.timestampUSecs >> entry.offset;
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        _entries.clear();
+        return false;
+    }
+
+    qCDebug(LogReplayIndexLog) << "Loaded index" << indexFileName << "records:" << _recordCount;
+    return isValid();
+}
+
+bool LogReplayIndex::save(const QString &indexFileName, qint64 logSize, qint64 logModifiedMSecs) const
+{
+    QSaveFile file(indexFileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(LogReplayIndexLog) << "Unable to write index" << indexFileName << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream << kFileMagic << kFileVersion << logSize << logModifiedMSecs << kStride;
+    stream << _startTimeUSecs << _endTimeUSecs << _recordCount << static_cast<quint64>(_entries.count());
+    for (const Entry &entry : _entries) {
+        stream << entry.timestampUSecs << entry.offset;
+    }
+
+    return file.commit();
+}
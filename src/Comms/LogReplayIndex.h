@@ -0,0 +1,75 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QString>
+
+#include <atomic>
+
+Q_DECLARE_LOGGING_CATEGORY(LogReplayIndexLog)
+
+/// Timestamp to file offset index for a telemetry log (records of big endian usec timestamp + MAVLink frame).
+/// Records are validated by their frame CRC without going through a MAVLink channel, so building an index never
+/// disturbs the parse state of live links. Every kStride-th record is indexed, seeking binary searches the index
+/// and then walks at most kStride records to the exact one.
+class LogReplayIndex
+{
+public:
+    struct Entry {
+        quint64 timestampUSecs = 0; ///< Largest timestamp seen up to and including this record
+        qint64 offset = 0;          ///< Offset of the record (timestamp) in the log file
+    };
+
+    /// Scans the whole log
+    ///     @param cancel Build stops early and returns false when set
+    ///     @return false: No valid records or cancelled
+    bool build(const uchar *data, qint64 size, const std::atomic_bool *cancel = nullptr);
+
+    /// Loads the sidecar index, it is only accepted if it was built for a log of the same size and modification time
+    bool load(const QString &indexFileName, qint64 logSize, qint64 logModifiedMSecs);
+    bool save(const QString &indexFileName, qint64 logSize, qint64 logModifiedMSecs) const;
+
+    bool isValid() const { return !_entries.isEmpty(); }
+    quint64 startTimeUSecs() const { return _startTimeUSecs; }
+    quint64 endTimeUSecs() const { return _endTimeUSecs; }
+    quint64 recordCount() const { return _recordCount; }
+
+    /// @return Offset of the first record with a timestamp >= timeUSecs, -1 if there is none
+    qint64 seek(const uchar *data, qint64 size, quint64 timeUSecs) const;
+
+    /// Parses the record starting at offset
+    ///     @param[out] timestampUSecs Timestamp of the record
+    ///     @param[out] frameLength Length of the MAVLink frame which follows the timestamp
+    ///     @return false: No valid record at offset
+    static bool parseRecord(const uchar *data, qint64 size, qint64 offset, quint64 nowUSecs, quint64 &timestampUSecs, qint64 &frameLength);
+
+    /// @return Offset of the first valid record at or after offset, -1 if there is none
+    static qint64 nextRecord(const uchar *data, qint64 size, qint64 offset, quint64 nowUSecs);
+
+    /// @return Current time in usecs, used to detect little endian timestamps from old logs
+    static quint64 nowUSecs();
+
+    /// @return File name of the sidecar index for the log
+    static QString indexFileName(const QString &logFileName) { return logFileName + QStringLiteral(".qgcindex"); }
+
+    static constexpr qint64 kTimestampLen = sizeof(quint64);
+    static constexpr quint64 kStride = 64;
+
+private:
+    QList<Entry> _entries;
+    quint64 _startTimeUSecs = 0;
+    quint64 _endTimeUSecs = 0;
+    quint64 _recordCount = 0;
+
+    static constexpr quint32 kFileMagic = 0x51494458;  ///< "QIDX"
+    static constexpr quint32 kFileVersion = 1;
+};
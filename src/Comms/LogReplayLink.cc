@@ -12,14 +12,14 @@
 #include "LinkManager.h"
 #include "QGCApplication.h"
 #include "MultiVehicleManager.h"
-#ifndef __mobile__
 #include "MAVLinkProtocol.h"
-#endif
-#include "MAVLinkLib.h"
+#include "QGCLoggingCategory.h"
 
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QEventLoop>
 #include <QtCore/QFileInfo>
-#include <QtCore/QtEndian>
-#include <QtTest/QSignalSpy>
+
+QGC_LOGGING_CATEGORY(LogReplayLinkLog, "qgc.comms.logreplaylink")
 
 LogReplayLinkConfiguration::LogReplayLinkConfiguration(const QString& name)
     : LinkConfiguration(name)
@@ -68,7 +68,6 @@ LogReplayLink::LogReplayLink(SharedLinkConfigurationPtr& config)
     : LinkInterface              (config)
     , _logReplayConfig           (qobject_cast<LogReplayLinkConfiguration*>(config.get()))
     , _connected                 (false)
-    , _mavlinkChannel            (0)
     , _logCurrentTimeUSecs       (0)
     , _logStartTimeUSecs         (0)
     , _logEndTimeUSecs           (0)
@@ -86,11 +85,14 @@ LogReplayLink::LogReplayLink(SharedLinkConfigurationPtr& config)
     _errorTitle = tr("Log Replay Error");
     
     _readTickTimer.moveToThread(this);
+    _indexWatcher.moveToThread(this);
     
     QObject::connect(&_readTickTimer, &QTimer::timeout,                 this, &LogReplayLink::_readNextLogEntry);
+    QObject::connect(&_indexWatcher, &QFutureWatcher<LogReplayIndex>::finished, this, &LogReplayLink::_indexBuilt);
     QObject::connect(this, &LogReplayLink::_playOnThread,               this, &LogReplayLink::_play);
     QObject::connect(this, &LogReplayLink::_pauseOnThread,              this, &LogReplayLink::_pause);
     QObject::connect(this, &LogReplayLink::_setPlaybackSpeedOnThread,   this, &LogReplayLink::_setPlaybackSpeed);
+    QObject::connect(this, &LogReplayLink::_movePlayheadOnThread,       this, &LogReplayLink::_movePlayhead);
     
     moveToThread(this);
 }
@@ -119,6 +121,7 @@ bool LogReplayLink::_connect(void)
 void LogReplayLink::disconnect(void)
 {
     if (_connected) {
+        requestInterruption();
         quit();
         wait();
         _connected = false;
@@ -130,11 +133,19 @@ void LogReplayLink::run(void)
 {
     // Load the log file
     if (!_loadLogFile()) {
+        // Lets LinkManager drop the link, it was never usable
+        emit disconnected();
         return;
     }
     
     _connected = true;
     emit connected();
+
+    if (_logReplayConfig->batchReplay()) {
+        _replayAll();
+        _closeLogFile();
+        return;
+    }
     
     // Start playback
     _play();
@@ -143,6 +154,7 @@ void LogReplayLink::run(void)
     exec();
     
     _readTickTimer.stop();
+    _closeLogFile();
 }
 
 void LogReplayLink::_replayError(const QString& errorMsg)
@@ -157,159 +169,156 @@ void LogReplayLink::_writeBytes(const QByteArray &bytes)
     Q_UNUSED(bytes);
 }
 
-/// Parses a BigEndian quint64 timestamp
-/// @return A Unix timestamp in microseconds UTC for found message or 0 if parsing failed
-quint64 LogReplayLink::_parseTimestamp(const QByteArray& bytes)
-{
-    quint64 timestamp = qFromBigEndian(*((quint64*)(bytes.constData())));
-    quint64 currentTimestamp = ((quint64)QDateTime::currentMSecsSinceEpoch()) * 1000;
-    
-    // Now if the parsed timestamp is in the future, it must be an old file where the timestamp was stored as
-    // little endian, so switch it.
-    if (timestamp > currentTimestamp) {
-        timestamp = qbswap(timestamp);
-    }
-    
-    return timestamp;
-}
-
-/// Reads the next mavlink message from the log
-///     @param bytes[output] Bytes for mavlink message
+/// Appends the next mavlink message from the log
+///     @param bytes[output] Bytes for mavlink message are appended
 /// @return Unix timestamp in microseconds UTC for NEXT mavlink message or 0 if no message found
 quint64 LogReplayLink::_readNextMavlinkMessage(QByteArray& bytes)
 {
-    char                nextByte;
-    mavlink_status_t    status;
+    if (_playbackOffset < 0) {
+        return 0;
+    }
 
-    bytes.clear();
+    quint64 timestamp;
+    qint64 frameLength;
+    if (!LogReplayIndex::parseRecord(_logData, _logFileSize, _playbackOffset, _nowUSecs, timestamp, frameLength)) {
+        _playbackOffset = LogReplayIndex::nextRecord(_logData, _logFileSize, _playbackOffset, _nowUSecs);
+        if ((_playbackOffset < 0) || !LogReplayIndex::parseRecord(_logData, _logFileSize, _playbackOffset, _nowUSecs, timestamp, frameLength)) {
+            _playbackOffset = -1;
+            return 0;
+        }
+    }
 
-    while (_logFile.getChar(&nextByte)) { // Loop over every byte
-        mavlink_message_t message;
-        bool messageFound = mavlink_parse_char(_mavlinkChannel, nextByte, &message, &status);
+    (void) bytes.append(reinterpret_cast<const char*>(_logData + _playbackOffset + LogReplayIndex::kTimestampLen), frameLength);
+    _replayMessageCount++;
 
-        if (status.parse_state == MAVLINK_PARSE_STATE_GOT_STX) {
-            // This is the possible beginning of a mavlink message, clear any partial bytes
-            bytes.clear();
-        }
-        bytes.append(nextByte);
+    // Records normally follow each other directly, only resync through garbage when they don't
+    const qint64 next = _playbackOffset + LogReplayIndex::kTimestampLen + frameLength;
+    quint64 nextTimestamp;
+    qint64 nextFrameLength;
+    if (LogReplayIndex::parseRecord(_logData, _logFileSize, next, _nowUSecs, nextTimestamp, nextFrameLength)) {
+        _playbackOffset = next;
+        return nextTimestamp;
+    }
 
-        if (messageFound) {
-            // Return the timestamp for the next message
-            QByteArray rawTime = _logFile.read(cbTimestamp);
-            return _parseTimestamp(rawTime);
-        }
+    _playbackOffset = LogReplayIndex::nextRecord(_logData, _logFileSize, next, _nowUSecs);
+    if ((_playbackOffset >= 0) && LogReplayIndex::parseRecord(_logData, _logFileSize, _playbackOffset, _nowUSecs, nextTimestamp, nextFrameLength)) {
+        return nextTimestamp;
     }
 
+    _playbackOffset = -1;
     return 0;
 }
 
-/// Seeks to the beginning of the next successfully parsed mavlink message in the log file.
-///     @param nextMsg[output] Parsed next message that was found
-/// @return A Unix timestamp in microseconds UTC for found message or 0 if parsing failed
-quint64 LogReplayLink::_seekToNextMavlinkMessage(mavlink_message_t* nextMsg)
+bool LogReplayLink::_loadLogFile(void)
 {
-    char                nextByte;
-    mavlink_status_t    status;
-    qint64              messageStartPos = -1;
+    const QString logFilename = _logReplayConfig->logFilename();
+
+    if (_logFile.isOpen()) {
+        _replayError(tr("Attempt to load new log while log being played"));
+        return false;
+    }
+    
+    _logFile.setFileName(logFilename);
+    if (!_logFile.open(QFile::ReadOnly)) {
+        _replayError(tr("Unable to open log file: '%1', error: %2").arg(logFilename).arg(_logFile.errorString()));
+        return false;
+    }
+    _logFileSize = _logFile.size();
 
-    mavlink_reset_channel_status(_mavlinkChannel);
+    _logData = (_logFileSize > 0) ? _logFile.map(0, _logFileSize) : nullptr;
+    if (!_logData) {
+        _closeLogFile();
+        _replayError(tr("The log file '%1' is corrupt or empty.").arg(logFilename));
+        return false;
+    }
 
-    while (_logFile.getChar(&nextByte)) {
-        bool messageFound = mavlink_parse_char(_mavlinkChannel, nextByte, nextMsg, &status);
+    _nowUSecs = LogReplayIndex::nowUSecs();
+    _playbackOffset = LogReplayIndex::nextRecord(_logData, _logFileSize, 0, _nowUSecs);
 
-        if (status.parse_state == MAVLINK_PARSE_STATE_GOT_STX) {
-            // This is the possible beginning of a mavlink message
-            messageStartPos = _logFile.pos() - 1;
-        }
-        
-        // If we've found a message, jump back to the start of the message, grab the timestamp,
-        // and go back to the end of this file.
-        if (messageFound && messageStartPos != -1) {
-            _logFile.seek(messageStartPos - cbTimestamp);
-            QByteArray rawTime = _logFile.read(cbTimestamp);
-            return _parseTimestamp(rawTime);
-        }
+    quint64 startTimeUSecs = 0;
+    qint64 frameLength;
+    if ((_playbackOffset < 0) || !LogReplayIndex::parseRecord(_logData, _logFileSize, _playbackOffset, _nowUSecs, startTimeUSecs, frameLength)) {
+        _closeLogFile();
+        _replayError(tr("The log file '%1' is corrupt or empty.").arg(logFilename));
+        return false;
     }
-    
-    return 0;
-}
 
-quint64 LogReplayLink::_findLastTimestamp(void)
-{
-    char                nextByte;
-    mavlink_status_t    status;
-    quint64             lastTimestamp = 0;
-    mavlink_message_t   msg;
+    _logStartTimeUSecs = startTimeUSecs;
+    _logCurrentTimeUSecs = startTimeUSecs;
+    _logEndTimeUSecs = startTimeUSecs;
+    _logDurationUSecs = 0;
 
-    // We read through the entire file looking for the last good timestamp. This can be somewhat slow, but trying to work from the
-    // end of the file can be way slower due to all the seeking back and forth required. So instead we take the simple reliable approach.
+    if (_logReplayConfig->batchReplay()) {
+        // Batch replay never seeks
+        return true;
+    }
 
-    _logFile.reset();
-    mavlink_reset_channel_status(_mavlinkChannel);
+    const QString indexFilename = LogReplayIndex::indexFileName(logFilename);
+    const qint64 logModifiedMSecs = QFileInfo(logFilename).lastModified().toMSecsSinceEpoch();
 
-    while (_logFile.bytesAvailable() > cbTimestamp) {
-        lastTimestamp = _parseTimestamp(_logFile.read(cbTimestamp));
+    LogReplayIndex index;
+    if (index.load(indexFilename, _logFileSize, logModifiedMSecs)) {
+        _setIndex(index);
+        return true;
+    }
 
-        bool endOfMessage = false;
-        while (!endOfMessage && _logFile.getChar(&nextByte)) {
-            endOfMessage = mavlink_parse_char(_mavlinkChannel, nextByte, &msg, &status);
+    // Playback starts right away, duration and seeking become available once the index is built
+    const uchar* const data = _logData;
+    const qint64 size = _logFileSize;
+    std::atomic_bool* const cancel = &_indexCancel;
+    _indexCancel = false;
+    _indexWatcher.setFuture(QtConcurrent::run([data, size, cancel, indexFilename, logModifiedMSecs]() {
+        LogReplayIndex index;
+        if (index.build(data, size, cancel)) {
+            (void) index.save(indexFilename, size, logModifiedMSecs);
         }
-    }
+        return index;
+    }));
 
-    return lastTimestamp;
+    return true;
 }
 
-bool LogReplayLink::_loadLogFile(void)
+void LogReplayLink::_closeLogFile(void)
 {
-    QString errorMsg;
-    QString logFilename = _logReplayConfig->logFilename();
-    QFileInfo logFileInfo;
-    int logDurationSecondsTotal;
-    quint64 startTimeUSecs;
-    quint64 endTimeUSecs;
+    // The index build reads the mapping, it has to be done before unmapping
+    _indexCancel = true;
+    _indexWatcher.waitForFinished();
 
+    if (_logData) {
+        (void) _logFile.unmap(const_cast<uchar*>(_logData));
+        _logData = nullptr;
+    }
     if (_logFile.isOpen()) {
-        errorMsg = tr("Attempt to load new log while log being played");
-        goto Error;
+        _logFile.close();
     }
-    
-    _logFile.setFileName(logFilename);
-    if (!_logFile.open(QFile::ReadOnly)) {
-        errorMsg = tr("Unable to open log file: '%1', error: %2").arg(logFilename).arg(_logFile.errorString());
-        goto Error;
+    _playbackOffset = -1;
+}
+
+void LogReplayLink::_indexBuilt(void)
+{
+    if (_indexCancel || !_indexWatcher.future().isValid()) {
+        return;
     }
-    logFileInfo.setFile(logFilename);
-    _logFileSize = logFileInfo.size();
-    
-    startTimeUSecs = _parseTimestamp(_logFile.read(cbTimestamp));
-    endTimeUSecs = _findLastTimestamp();
 
-    if (endTimeUSecs <= startTimeUSecs) {
-        errorMsg = tr("The log file '%1' is corrupt or empty.").arg(logFilename);
-        goto Error;
+    const LogReplayIndex index = _indexWatcher.result();
+    if (!index.isValid() || (index.endTimeUSecs() <= index.startTimeUSecs())) {
+        _replayError(tr("The log file '%1' is corrupt or empty.").arg(_logReplayConfig->logFilename()));
+        return;
     }
 
-    // Remember the start and end time so we can move around this _logFile with the slider.
-    _logEndTimeUSecs = endTimeUSecs;
-    _logStartTimeUSecs = startTimeUSecs;
-    _logDurationUSecs = endTimeUSecs - startTimeUSecs;
-    _logCurrentTimeUSecs = startTimeUSecs;
+    _setIndex(index);
+}
 
-    // Reset our log file so when we go to read it for the first time, we start at the beginning.
-    _logFile.reset();
+void LogReplayLink::_setIndex(const LogReplayIndex& index)
+{
+    _index = index;
 
-    logDurationSecondsTotal = (_logDurationUSecs) / 1000000;
-    
-    emit logFileStats(logDurationSecondsTotal);
-    
-    return true;
-    
-Error:
-    if (_logFile.isOpen()) {
-        _logFile.close();
-    }
-    _replayError(errorMsg);
-    return false;
+    // Remember the start and end time so we can move around this _logFile with the slider.
+    _logStartTimeUSecs = _index.startTimeUSecs();
+    _logEndTimeUSecs = _index.endTimeUSecs();
+    _logDurationUSecs = (_logEndTimeUSecs > _logStartTimeUSecs) ? (_logEndTimeUSecs - _logStartTimeUSecs) : 0;
+
+    emit logFileStats(_logDurationUSecs / 1000000);
 }
 
 /// This function will read the next available log entry. It will then start
@@ -318,10 +327,15 @@ Error:
 /// induce a static drift into the log file replay.
 void LogReplayLink::_readNextLogEntry(void)
 {
+    if (_playbackSpeed <= kPlaybackSpeedAsFastAsPossible) {
+        _readAsFastAsPossible();
+        return;
+    }
+
     QByteArray bytes;
 
     // Now parse MAVLink messages, grabbing their timestamps as we go. We stop once we
-    // have at least 3ms until the next one.
+    // have at least 3ms until the next one. All messages which are due go out in a single batch.
 
     // We track what the next execution time should be in milliseconds, which we use to set
     // the next timer interrupt.
@@ -330,10 +344,9 @@ void LogReplayLink::_readNextLogEntry(void)
     while (timeToNextExecutionMSecs < 3) {
         // Read the next mavlink message from the log
         qint64 nextTimeUSecs = _readNextMavlinkMessage(bytes);
-        emit bytesReceived(this, bytes);
-        emit playbackPercentCompleteChanged(((float)(_logCurrentTimeUSecs - _logStartTimeUSecs) / (float)_logDurationUSecs) * 100);
 
-        if (_logFile.atEnd()) {
+        if (_playbackOffset < 0) {
+            _emitReplayBatch(bytes);
             _finishPlayback();
             return;
         }
@@ -350,26 +363,129 @@ void LogReplayLink::_readNextLogEntry(void)
         timeToNextExecutionMSecs = desiredCurrentTimeMSecs - currentTimeMSecs;
     }
 
-    _signalCurrentLogTimeSecs();
+    _emitReplayBatch(bytes);
+    _signalPlaybackProgress();
 
     // And schedule the next execution of this function.
     _readTickTimer.start(timeToNextExecutionMSecs);
 }
 
-void LogReplayLink::_play(void)
+/// Sends the log in kReplayBatchBytes batches, paced by how fast MAVLinkProtocol consumes them instead of
+/// by the log timestamps. Waiting on the protocol keeps its receive ring from overflowing.
+void LogReplayLink::_readAsFastAsPossible(void)
+{
+    if (_protocolBacklogged((_playbackOffset < 0) ? 0 : kMaxBatchesInFlight)) {
+        _readTickTimer.start(1);
+        return;
+    }
+
+    if (_playbackOffset < 0) {
+        // Everything sent has been processed
+        _signalPlaybackProgress();
+        _finishPlayback();
+        return;
+    }
+
+    QByteArray bytes;
+    quint64 nextTimeUSecs = 0;
+    while ((_playbackOffset >= 0) && (bytes.size() < kReplayBatchBytes)) {
+        nextTimeUSecs = _readNextMavlinkMessage(bytes);
+    }
+    if (_playbackOffset >= 0) {
+        _logCurrentTimeUSecs = nextTimeUSecs;
+    }
+    _emitReplayBatch(bytes);
+
+    if (_progressTimer.hasExpired(kProgressIntervalMSecs)) {
+        _progressTimer.start();
+        _signalPlaybackProgress();
+    }
+
+    _readTickTimer.start(0);
+}
+
+/// Streams the whole log without timers for batch replay. Runs on the link thread and only returns at the end of
+/// the log, once MAVLinkProtocol has processed all of it, or when the link is disconnected.
+void LogReplayLink::_replayAll(void)
+{
+    _suspendConnections(true);
+
+    _replayTimer.start();
+    _protocolBatchBase = MAVLinkProtocol::instance()->receivedBatchCount();
+    _emittedBatchCount = 0;
+
+    while ((_playbackOffset >= 0) && !isInterruptionRequested()) {
+        if (_protocolBacklogged(kMaxBatchesInFlight)) {
+            QThread::usleep(100);
+            continue;
+        }
+
+        QByteArray bytes;
+        while ((_playbackOffset >= 0) && (bytes.size() < kReplayBatchBytes)) {
+            (void) _readNextMavlinkMessage(bytes);
+        }
+        _emitReplayBatch(bytes);
+    }
+
+    while (_protocolBacklogged(0) && !isInterruptionRequested()) {
+        QThread::usleep(100);
+    }
+
+    _finishPlayback();
+}
+
+/// @return true: MAVLinkProtocol is more than maxBatchesInFlight batches behind, or has too many decoded messages waiting.
+/// Batch counts are for all links, which is accurate since replay suspends all other connections.
+bool LogReplayLink::_protocolBacklogged(quint64 maxBatchesInFlight) const
+{
+    const MAVLinkProtocol* const protocol = MAVLinkProtocol::instance();
+
+    const quint64 decodedBatchCount = protocol->receivedBatchCount() - _protocolBatchBase;
+    if ((decodedBatchCount + maxBatchesInFlight) < _emittedBatchCount) {
+        return true;
+    }
+
+    const qsizetype maxBacklog = (maxBatchesInFlight == 0) ? 0 : (MAVLinkProtocolWorker::ReceiveRing::capacity() / 2);
+    return protocol->receiveBacklog() > maxBacklog;
+}
+
+void LogReplayLink::_emitReplayBatch(const QByteArray& bytes)
+{
+    if (bytes.isEmpty()) {
+        return;
+    }
+
+    _emittedBatchCount++;
+    emit bytesReceived(this, bytes);
+}
+
+void LogReplayLink::_suspendConnections(bool suspend)
 {
-    LinkManager::instance()->setConnectionsSuspended(tr("Connect not allowed during Flight Data replay."));
+    if (suspend) {
+        LinkManager::instance()->setConnectionsSuspended(tr("Connect not allowed during Flight Data replay."));
+    } else {
+        LinkManager::instance()->setConnectionsAllowed();
+    }
 #ifndef __mobile__
-    MAVLinkProtocol::instance()->suspendLogForReplay(true);
+    MAVLinkProtocol::instance()->suspendLogForReplay(suspend);
 #endif
+}
+
+void LogReplayLink::_play(void)
+{
+    _suspendConnections(true);
     
     // Make sure we aren't at the end of the file, if we are, reset to the beginning and play from there.
-    if (_logFile.atEnd()) {
+    if (_playbackOffset < 0) {
         _resetPlaybackToBeginning();
     }
     
     _playbackStartTimeMSecs = (quint64)QDateTime::currentMSecsSinceEpoch();
     _playbackStartLogTimeUSecs = _logCurrentTimeUSecs;
+    _replayTimer.start();
+    _progressTimer.start();
+    _protocolBatchBase = MAVLinkProtocol::instance()->receivedBatchCount();
+    _emittedBatchCount = 0;
     _readTickTimer.start(1);
     
     emit playbackStarted();
@@ -377,85 +493,69 @@ void LogReplayLink::_play(void)
 
 void LogReplayLink::_pause(void)
 {
-    LinkManager::instance()->setConnectionsAllowed();
-#ifndef __mobile__
-    MAVLinkProtocol::instance()->suspendLogForReplay(false);
-#endif
+    _suspendConnections(false);
     
     _readTickTimer.stop();
+    if (_replayTimer.isValid()) {
+        _replayElapsedNSecs += _replayTimer.nsecsElapsed();
+        _replayTimer.invalidate();
+    }
     
     emit playbackPaused();
 }
 
 void LogReplayLink::_resetPlaybackToBeginning(void)
 {
-    if (_logFile.isOpen()) {
-        _logFile.reset();
+    if (_logData) {
+        _playbackOffset = LogReplayIndex::nextRecord(_logData, _logFileSize, 0, _nowUSecs);
     }
     
     // And since we haven't starting playback, clear the time of initial playback and the current timestamp.
+    _replayMessageCount = 0;
+    _replayElapsedNSecs = 0;
     _playbackStartTimeMSecs = 0;
     _playbackStartLogTimeUSecs = 0;
     _logCurrentTimeUSecs = _logStartTimeUSecs;
 }
 
-void LogReplayLink::movePlayhead(qreal percentComplete)
+void LogReplayLink::_movePlayhead(qreal percentComplete)
 {
     if (isPlaying()) {
-        _pauseOnThread();
-        QSignalSpy waitForPause(this, SIGNAL(playbackPaused()));
-        waitForPause.wait();
-        if (_readTickTimer.isActive()) {
-            return;
-        }
+        _pause();
     }
 
-    if (percentComplete < 0) {
-        percentComplete = 0;
-    }
-    if (percentComplete > 100) {
-        percentComplete = 100;
-    }
-    
-    qreal percentCompleteMult = percentComplete / 100.0;
-    
-    // But if we have a timestamped MAVLink log, then actually aim to hit that percentage in terms of
-    // time through the file.
-    qint64 newFilePos = (qint64)(percentCompleteMult * (qreal)_logFile.size());
-
-    // Now seek to the appropriate position, failing gracefully if we can't.
-    if (!_logFile.seek(newFilePos)) {
-        _replayError(tr("Unable to seek to new position"));
+    if (!_logData) {
         return;
     }
 
-    // But we do align to the next MAVLink message for consistency.
-    mavlink_message_t dummy;
-    _logCurrentTimeUSecs = _seekToNextMavlinkMessage(&dummy);
-
-    // Now calculate the current file location based on time.
-    qreal newRelativeTimeUSecs = (qreal)(_logCurrentTimeUSecs - _logStartTimeUSecs);
-
-    // Calculate the effective baud rate of the file in bytes/s.
-    qreal baudRate = _logFile.size() / (qreal)_logDurationUSecs / 1e6;
+    if (!_index.isValid()) {
+        // Seeking needs the index, wait for the build to complete
+        _indexWatcher.waitForFinished();
+        _indexBuilt();
+        if (!_index.isValid()) {
+            return;
+        }
+    }
 
-    // And the desired time is:
-    qreal desiredTimeUSecs = percentCompleteMult * _logDurationUSecs;
+    percentComplete = qBound(0.0, percentComplete, 100.0);
 
-    // And now jump the necessary number of bytes in the proper direction
-    qint64 offset = (newRelativeTimeUSecs - desiredTimeUSecs) * baudRate;
-    if (!_logFile.seek(_logFile.pos() + offset)) {
-        _replayError(tr("Unable to seek to new position"));
-        return;
+    // Exact seek to the first record at or after the requested time
+    const quint64 desiredTimeUSecs = _logStartTimeUSecs + static_cast<quint64>((percentComplete / 100.0) * _logDurationUSecs);
+    const qint64 offset = _index.seek(_logData, _logFileSize, desiredTimeUSecs);
+    if (offset < 0) {
+        _playbackOffset = -1;
+        _logCurrentTimeUSecs = _logEndTimeUSecs;
+    } else {
+        quint64 timestamp;
+        qint64 frameLength;
+        (void) LogReplayIndex::parseRecord(_logData, _logFileSize, offset, _nowUSecs, timestamp, frameLength);
+        _playbackOffset = offset;
+        _logCurrentTimeUSecs = timestamp;
     }
-
-    // And scan until we reach the start of a MAVLink message. We make sure to record this timestamp for
-    // smooth jumping around the file.
-    _logCurrentTimeUSecs = _seekToNextMavlinkMessage(&dummy);
     _signalCurrentLogTimeSecs();
 
     // Now update the UI with our actual final position.
-    newRelativeTimeUSecs = (qreal)(_logCurrentTimeUSecs - _logStartTimeUSecs);
+    const qreal newRelativeTimeUSecs = (qreal)(_logCurrentTimeUSecs - _logStartTimeUSecs);
     percentComplete = (newRelativeTimeUSecs / _logDurationUSecs) * 100;
     emit playbackPercentCompleteChanged(percentComplete);
 }
@@ -474,6 +574,10 @@ void LogReplayLink::_setPlaybackSpeed(qreal playbackSpeed)
 void LogReplayLink::_finishPlayback(void)
 {
     _pause();
+
+    _replayMessagesPerSec = (_replayElapsedNSecs > 0) ? ((_replayMessageCount * 1e9) / _replayElapsedNSecs) : 0;
+    qCDebug(LogReplayLinkLog) << "Replayed" << _replayMessageCount << "messages in" << (_replayElapsedNSecs / 1000000) << "msecs," << _replayMessagesPerSec << "messages/sec";
+    emit replayStats(_replayMessageCount, _replayMessagesPerSec);
     
     emit playbackAtEnd();
 }
@@ -483,6 +587,14 @@ void LogReplayLink::_signalCurrentLogTimeSecs(void)
     emit currentLogTimeSecs((_logCurrentTimeUSecs - _logStartTimeUSecs) / 1000000);
 }
 
+void LogReplayLink::_signalPlaybackProgress(void)
+{
+    if (_logDurationUSecs > 0) {
+        emit playbackPercentCompleteChanged(((float)(_logCurrentTimeUSecs - _logStartTimeUSecs) / (float)_logDurationUSecs) * 100);
+    }
+    _signalCurrentLogTimeSecs();
+}
+
 LogReplayLinkController::LogReplayLinkController(void)
     : _link             (nullptr)
     , _isPlaying        (false)
@@ -598,3 +710,107 @@ QString LogReplayLinkController::_secondsToHMS(int seconds)
         return tr("%1h:%2m:%3s").arg(hoursPart, 2, 10, QLatin1Char('0')).arg(minutesPart, 2, 10, QLatin1Char('0')).arg(secondsPart, 2, 10, QLatin1Char('0'));
     }
 }
+
+bool LogReplayBatch::_waitForVehicleRemoval(int timeoutMSecs)
+{
+    MultiVehicleManager* const multiVehicleManager = MultiVehicleManager::instance();
+    if (!multiVehicleManager->activeVehicle()) {
+        return true;
+    }
+
+    QEventLoop loop;
+    QTimer timeoutTimer;
+    timeoutTimer.setSingleShot(true);
+    (void) QObject::connect(multiVehicleManager, &MultiVehicleManager::activeVehicleChanged, &loop, [&loop](Vehicle* activeVehicle) {
+        if (!activeVehicle) {
+            loop.quit();
+        }
+    });
+    (void) QObject::connect(&timeoutTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    timeoutTimer.start(timeoutMSecs);
+    (void) loop.exec();
+
+    if (multiVehicleManager->activeVehicle()) {
+        qCWarning(LogReplayLinkLog) << "Vehicle still active after batch replay";
+        return false;
+    }
+
+    return true;
+}
+
+LogReplayBatch::Result LogReplayBatch::replay(const QString& logFilename, int timeoutMSecs)
+{
+    Result result;
+    result.logFilename = logFilename;
+
+    LogReplayLinkConfiguration* const linkConfig = new LogReplayLinkConfiguration(QStringLiteral("Batch Log Replay"));
+    linkConfig->setLogFilename(logFilename);
+    linkConfig->setBatchReplay(true);
+    linkConfig->setDynamic(true);
+
+    SharedLinkConfigurationPtr sharedConfig = LinkManager::instance()->addConfiguration(linkConfig);
+    const quint64 overflowMessageBase = MAVLinkProtocol::instance()->overflowMessageCount();
+
+    if (!LinkManager::instance()->createConnectedLink(sharedConfig)) {
+        result.errorString = QStringLiteral("Unable to start replay link");
+        LinkManager::instance()->removeConfiguration(sharedConfig.get());
+        return result;
+    }
+
+    // Keep the link alive until the results are collected
+    SharedLinkInterfacePtr sharedLink = LinkManager::instance()->sharedLinkInterfacePointerForLink(sharedConfig->link());
+    LogReplayLink* const link = qobject_cast<LogReplayLink*>(sharedLink.get());
+
+    // The link thread finishes once the whole log has been processed. The event loop must keep running meanwhile,
+    // MAVLinkProtocol delivers messages to the vehicles on this thread.
+    bool timedOut = false;
+    QEventLoop loop;
+    QTimer timeoutTimer;
+    timeoutTimer.setSingleShot(true);
+    (void) QObject::connect(link, &QThread::finished, &loop, &QEventLoop::quit);
+    (void) QObject::connect(&timeoutTimer, &QTimer::timeout, &loop, [&loop, &timedOut]() {
+        timedOut = true;
+        loop.quit();
+    });
+    if (!link->isFinished()) {
+        timeoutTimer.start(timeoutMSecs);
+        (void) loop.exec();
+    }
+
+    result.messageCount = link->replayMessageCount();
+    result.overflowMessageCount = MAVLinkProtocol::instance()->overflowMessageCount() - overflowMessageBase;
+    if (timedOut) {
+        result.errorString = QStringLiteral("Timed out after %1 messages").arg(result.messageCount);
+    } else if (result.messageCount == 0) {
+        result.errorString = QStringLiteral("No messages in log");
+    } else {
+        result.messagesPerSec = link->replayMessagesPerSec();
+        result.success = true;
+    }
+
+    sharedLink.reset();
+    LinkManager::instance()->removeConfiguration(sharedConfig.get());
+
+    // MultiVehicleManager deletes the replayed vehicle on a deferred timer once its link is gone. Until then
+    // the next replay is refused by LogReplayLink::_connect, so wait here for it to go away.
+    if (!_waitForVehicleRemoval(kVehicleRemovalTimeoutMSecs) && result.success) {
+        result.success = false;
+        result.errorString = QStringLiteral("Replayed vehicle was not removed");
+    }
+
+    qCDebug(LogReplayLinkLog) << "Batch replay" << logFilename << "messages:" << result.messageCount << "messages/sec:" << result.messagesPerSec << "overflow:" << result.overflowMessageCount << result.errorString;
+
+    return result;
+}
+
+QList<LogReplayBatch::Result> LogReplayBatch::replay(const QStringList& logFilenames, int timeoutMSecs)
+{
+    QList<Result> results;
+    results.reserve(logFilenames.count());
+
+    for (const QString& logFilename : logFilenames) {
+        results.append(replay(logFilename, timeoutMSecs));
+    }
+
+    return results;
+}
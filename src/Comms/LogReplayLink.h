@@ -11,14 +11,20 @@
 
 #include "LinkConfiguration.h"
 #include "LinkInterface.h"
+#include "LogReplayIndex.h"
 
-#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QTimer>
+
+#include <atomic>
 
 class LinkManager;
 class MAVLinkProtocol;
 
-typedef struct __mavlink_message mavlink_message_t;
+Q_DECLARE_LOGGING_CATEGORY(LogReplayLinkLog)
 
 class LogReplayLinkConfiguration : public LinkConfiguration
 {
@@ -35,6 +41,11 @@ public:
 
     QString logFilenameShort(void);
 
+    /// Batch replay streams the whole log at full speed as soon as the link connects, without pacing, seeking or
+    /// UI updates. Used by LogReplayBatch for headless replay.
+    bool batchReplay(void) const { return _batchReplay; }
+    void setBatchReplay(bool batchReplay) { _batchReplay = batchReplay; }
+
     // Virtuals from LinkConfiguration
     LinkType    type                    (void) const override                                         { return LinkConfiguration::TypeLogReplay; }
     void        copyFrom                (const LinkConfiguration* source) override;
@@ -49,6 +60,7 @@ signals:
 private:
     static constexpr const char*  _logFilenameKey = "logFilename";
     QString             _logFilename;
+    bool                _batchReplay = false;
 };
 
 /// Pseudo link that reads a telemetry log and feeds it into the application.
@@ -65,7 +77,16 @@ public:
 
     void play           (void) { emit _playOnThread(); }
     void pause          (void) { emit _pauseOnThread(); }
-    void movePlayhead   (qreal percentComplete);
+    void movePlayhead   (qreal percentComplete) { emit _movePlayheadOnThread(percentComplete); }
+
+    /// Messages replayed since playback started from the beginning of the log
+    quint64 replayMessageCount(void) const { return _replayMessageCount; }
+
+    /// Throughput of the last playback which reached the end of the log
+    qreal replayMessagesPerSec(void) const { return _replayMessagesPerSec; }
+
+    /// Playback speed which sends messages as fast as MAVLinkProtocol consumes them
+    static constexpr qreal kPlaybackSpeedAsFastAsPossible = 0;
 
     // overrides from LinkInterface
     bool isConnected(void) const override { return _connected; }
@@ -73,7 +94,7 @@ public:
     void disconnect (void) override;
 
 public slots:
-    /// Sets the acceleration factor: -100: 0.01X, 0: 1.0X, 100: 100.0X
+    /// Sets the playback speed multiplier, kPlaybackSpeedAsFastAsPossible: no pacing
     void setPlaybackSpeed(qreal playbackSpeed) { emit _setPlaybackSpeedOnThread(playbackSpeed); }
 
 signals:
@@ -84,10 +105,14 @@ signals:
     void playbackPercentCompleteChanged (qreal percentComplete);
     void currentLogTimeSecs             (int secs);
 
+    /// Throughput of the playback which just reached the end of the log
+    void replayStats                    (quint64 messageCount, qreal messagesPerSec);
+
     // Internal signals
     void _playOnThread              (void);
     void _pauseOnThread             (void);
     void _setPlaybackSpeedOnThread  (qreal playbackSpeed);
+    void _movePlayheadOnThread      (qreal percentComplete);
 
 private slots:
     // LinkInterface overrides
@@ -97,6 +122,8 @@ private slots:
     void _play              (void);
     void _pause             (void);
     void _setPlaybackSpeed  (qreal playbackSpeed);
+    void _movePlayhead      (qreal percentComplete);
+    void _indexBuilt        (void);
 
 private:
 
@@ -104,14 +131,19 @@ private:
     bool _connect(void) override;
 
     void    _replayError                (const QString& errorMsg);
-    quint64 _parseTimestamp             (const QByteArray& bytes);
-    quint64 _seekToNextMavlinkMessage   (mavlink_message_t* nextMsg);
-    quint64 _findLastTimestamp          (void);
     quint64 _readNextMavlinkMessage     (QByteArray& bytes);
     bool    _loadLogFile                (void);
+    void    _closeLogFile               (void);
+    void    _setIndex                   (const LogReplayIndex& index);
     void    _finishPlayback             (void);
     void    _resetPlaybackToBeginning   (void);
     void    _signalCurrentLogTimeSecs   (void);
+    void    _signalPlaybackProgress     (void);
+    void    _readAsFastAsPossible       (void);
+    void    _replayAll                  (void);
+    bool    _protocolBacklogged         (quint64 maxBatchesInFlight) const;
+    void    _emitReplayBatch            (const QByteArray& bytes);
+    void    _suspendConnections         (bool suspend);
 
     // QThread overrides
     void run(void) override;
@@ -119,7 +151,6 @@ private:
     LogReplayLinkConfiguration* _logReplayConfig;
 
     bool    _connected;
-    uint8_t _mavlinkChannel;
     QTimer  _readTickTimer;      ///< Timer which signals a read of next log record
 
     QString _errorTitle; ///< Title for communicatorError signals
@@ -135,9 +166,26 @@ private:
 
     MAVLinkProtocol*    _mavlink;
     QFile               _logFile;
-    quint64             _logFileSize;
-
-    static const int cbTimestamp = sizeof(quint64);
+    qint64              _logFileSize;
+    const uchar*        _logData = nullptr;         ///< Memory mapped log file
+    qint64              _playbackOffset = -1;       ///< Offset of the next record to play, -1: at end
+    quint64             _nowUSecs = 0;              ///< Reference for little endian timestamp detection
+
+    LogReplayIndex                  _index;
+    QFutureWatcher<LogReplayIndex>  _indexWatcher;  ///< Index build running on the thread pool
+    std::atomic_bool                _indexCancel = false;
+
+    quint64         _replayMessageCount = 0;
+    QElapsedTimer   _replayTimer;               ///< Time spent playing since playback was last started
+    qint64          _replayElapsedNSecs = 0;    ///< Play time accumulated before the last pause
+    qreal           _replayMessagesPerSec = 0;
+    QElapsedTimer   _progressTimer;             ///< Throttles progress signals when playing as fast as possible
+    quint64         _protocolBatchBase = 0;     ///< MAVLinkProtocol batch count when replay started
+    quint64         _emittedBatchCount = 0;
+
+    static constexpr qsizetype  kReplayBatchBytes = 16 * 1024;  ///< Bytes per bytesReceived when not pacing
+    static constexpr quint64    kMaxBatchesInFlight = 4;        ///< Batches MAVLinkProtocol may lag behind before replay waits
+    static constexpr int        kProgressIntervalMSecs = 100;
 };
 
 class LogReplayLinkController : public QObject
@@ -191,3 +239,32 @@ private:
     qreal           _playbackSpeed;
 };
 
+/// Headless replay of telemetry logs. Each log is streamed through LinkManager, MAVLinkProtocol and the Vehicle
+/// layer by a batch LogReplayLink as fast as it is consumed, with no pacing timers and no UI. Used to run archived
+/// flights through telemetry handling and to profile the receive path against real traffic.
+class LogReplayBatch
+{
+public:
+    struct Result {
+        QString logFilename;
+        bool    success = false;
+        QString errorString;
+        quint64 messageCount = 0;
+        qreal   messagesPerSec = 0;
+        quint64 overflowMessageCount = 0;   ///< Messages which overflowed the MAVLinkProtocol receive ring during the replay
+    };
+
+    /// Replays the whole log, running a local event loop until it has been processed and the vehicle it
+    /// created has been removed again
+    static Result replay(const QString& logFilename, int timeoutMSecs = kDefaultTimeoutMSecs);
+
+    /// Replays the logs one after the other
+    static QList<Result> replay(const QStringList& logFilenames, int timeoutMSecs = kDefaultTimeoutMSecs);
+
+    static constexpr int kDefaultTimeoutMSecs = 10 * 60 * 1000;
+    static constexpr int kVehicleRemovalTimeoutMSecs = 5000;
+
+private:
+    /// Runs the event loop until MultiVehicleManager has no active vehicle, returns false on timeout
+    static bool _waitForVehicleRemoval(int timeoutMSecs);
+};
@@ -9,6 +9,8 @@
 
 #include "MAVLinkProtocol.h"
 #include "LinkManager.h"
+#include "MAVLinkFrameScanner.h"
+#include "MAVLinkTlogWriter.h"
 #include "MultiVehicleManager.h"
 #include "QGCApplication.h"
 #include "QGCLoggingCategory.h"
@@ -21,22 +23,178 @@
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
 #include <QtCore/QMetaType>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QSettings>
 #include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
 
 QGC_LOGGING_CATEGORY(MAVLinkProtocolLog, "qgc.comms.mavlinkprotocol")
 
 Q_APPLICATION_STATIC(MAVLinkProtocol, _mavlinkProtocolInstance);
 
+MAVLinkProtocolWorker::MAVLinkProtocolWorker(QObject *parent)
+    : QObject(parent)
+{
+    (void) memset(_firstMessage, 1, sizeof(_firstMessage));
+
+    // qCDebug(MAVLinkProtocolLog) << Q_FUNC_INFO << this;
+}
+
+MAVLinkProtocolWorker::~MAVLinkProtocolWorker()
+{
+    // qCDebug(MAVLinkProtocolLog) << Q_FUNC_INFO << this;
+}
+
+void MAVLinkProtocolWorker::addLink(LinkInterface *link, uint8_t mavlinkChannel)
+{
+    _linkChannels[link] = mavlinkChannel;
+}
+
+void MAVLinkProtocolWorker::removeLink(LinkInterface *link)
+{
+    (void) _linkChannels.remove(link);
+}
+
+void MAVLinkProtocolWorker::resetMetadataForChannel(uint8_t mavlinkChannel)
+{
+    _totalReceiveCounter[mavlinkChannel] = 0;
+    _totalLossCounter[mavlinkChannel] = 0;
+    _runningLossPercent[mavlinkChannel] = 0.f;
+    for (int i = 0; i < 256; i++) {
+        _firstMessage[mavlinkChannel][i] = 1;
+    }
+}
+
+void MAVLinkProtocolWorker::receiveBytes(LinkInterface *link, const QByteArray &data)
+{
+    // The link pointer is only used as a key here, it may already be gone by the time the bytes arrive
+    const auto it = _linkChannels.constFind(link);
+    if (it == _linkChannels.constEnd()) {
+        qCDebug(MAVLinkProtocolLog) << "receiveBytes: link gone!" << data.size() << "bytes arrived too late";
+        (void) _receivedBatchCount.fetch_add(1, std::memory_order_release);
+        return;
+    }
+
+    const uint8_t mavlinkChannel = it.value();
+    MAVLinkFrameScanner scanner(mavlinkChannel, data);
+    mavlink_message_t message;
+    bool pushed = false;
+
+    while (scanner.next(message)) {
+        _updateCounters(mavlinkChannel, message);
+
+        if ((_totalReceiveCounter[mavlinkChannel] % 31) == 0) {
+            const uint64_t totalSent = _totalReceiveCounter[mavlinkChannel] + _totalLossCounter[mavlinkChannel];
+            emit mavlinkMessageStatus(message.sysid, totalSent, _totalReceiveCounter[mavlinkChannel], _totalLossCounter[mavlinkChannel], _runningLossPercent[mavlinkChannel]);
+        }
+
+        _pushMessage(link, message);
+        pushed = true;
+    }
+
+    (void) _receivedBatchCount.fetch_add(1, std::memory_order_release);
+
+    if (pushed && !_messagesAvailablePending.exchange(true, std::memory_order_acq_rel)) {
+        emit messagesAvailable();
+    }
+}
+
+void MAVLinkProtocolWorker::_pushMessage(LinkInterface *link, const mavlink_message_t &message)
+{
+    if (_overflowing) {
+        // Stay on the overflow queue until the consumer took it, anything pushed to the ring before would overtake it
+        QMutexLocker locker(&_overflowMutex);
+        if (!_overflow.isEmpty()) {
+            _overflow.append({link, message});
+            (void) _overflowSize.fetch_add(1, std::memory_order_relaxed);
+            (void) _overflowMessageCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        _overflowing = false;
+    }
+
+    ReceivedMessage *const received = _receiveRing.beginPush();
+    if (received) {
+        received->link = link;
+        received->message = message;
+        _receiveRing.commitPush();
+        return;
+    }
+
+    qCDebug(MAVLinkProtocolLog) << "Main thread is not keeping up, receive ring full";
+
+    QMutexLocker locker(&_overflowMutex);
+    _overflow.append({link, message});
+    (void) _overflowSize.fetch_add(1, std::memory_order_relaxed);
+    (void) _overflowMessageCount.fetch_add(1, std::memory_order_relaxed);
+    _overflowing = true;
+}
+
+void MAVLinkProtocolWorker::takeOverflow(QList<ReceivedMessage> &messages)
+{
+    QMutexLocker locker(&_overflowMutex);
+    messages.append(_overflow);
+    _overflow.clear();
+    _overflowSize.store(0, std::memory_order_relaxed);
+}
+
+void MAVLinkProtocolWorker::_updateCounters(uint8_t mavlinkChannel, const mavlink_message_t &message)
+{
+    uint8_t lastSeq = _lastIndex[message.sysid][message.compid];
+    uint8_t expectedSeq = lastSeq + 1;
+    _totalReceiveCounter[mavlinkChannel]++;
+    if (_firstMessage[message.sysid][message.compid] != 0) {
+        _firstMessage[message.sysid][message.compid] = 0;
+        lastSeq = message.seq;
+        expectedSeq = message.seq;
+    }
+
+    if (message.seq != expectedSeq) {
+        uint64_t lostMessages = message.seq;
+        if (message.seq < expectedSeq) {
+            lostMessages += 255;
+        }
+        lostMessages -= expectedSeq;
+        _totalLossCounter[mavlinkChannel] += lostMessages;
+    }
+
+    _lastIndex[message.sysid][message.compid] = message.seq;
+
+    const uint64_t totalSent = _totalReceiveCounter[mavlinkChannel] + _totalLossCounter[mavlinkChannel];
+    float receiveLossPercent = static_cast<float>(static_cast<double>(_totalLossCounter[mavlinkChannel]) / static_cast<double>(totalSent));
+    receiveLossPercent *= 100.0f;
+    receiveLossPercent *= 0.5f;
+    receiveLossPercent += (_runningLossPercent[mavlinkChannel] * 0.5f);
+    _runningLossPercent[mavlinkChannel] = receiveLossPercent;
+}
+
+/*===========================================================================*/
+
 MAVLinkProtocol::MAVLinkProtocol(QObject *parent)
     : QObject(parent)
     , _tempLogFile(new QGCTemporaryFile(QStringLiteral("%2.%3").arg(_tempLogFileTemplate, _logFileExtension), this))
+    , _tlogWriter(new MAVLinkTlogWriter(this))
+    , _workerThread(new QThread(this))
+    , _worker(new MAVLinkProtocolWorker())
 {
     // qCDebug(MAVLinkProtocolLog) << Q_FUNC_INFO << this;
+
+    _worker->moveToThread(_workerThread);
+
+    (void) connect(_workerThread, &QThread::finished, _worker, &QObject::deleteLater);
+
+    (void) connect(_worker, &MAVLinkProtocolWorker::messagesAvailable, this, &MAVLinkProtocol::_processReceivedMessages);
+    (void) connect(_worker, &MAVLinkProtocolWorker::mavlinkMessageStatus, this, &MAVLinkProtocol::mavlinkMessageStatus);
+    (void) connect(_tlogWriter, &MAVLinkTlogWriter::writeError, this, &MAVLinkProtocol::_logWriteError);
+
+    _workerThread->setObjectName(QStringLiteral("MAVLinkProtocol"));
 }
 
 MAVLinkProtocol::~MAVLinkProtocol()
 {
+    _workerThread->quit();
+    _workerThread->wait();
+
     _storeSettings();
     _closeLogFile();
 
@@ -54,7 +212,7 @@ void MAVLinkProtocol::init()
         return;
     }
 
-    (void) memset(_firstMessage, 1, sizeof(_firstMessage));
+    _workerThread->start(QThread::HighPriority);
 
     (void) connect(MultiVehicleManager::instance(), &MultiVehicleManager::vehicleRemoved, this, &MAVLinkProtocol::_vehicleCountChanged);
 
@@ -65,14 +223,52 @@ void MAVLinkProtocol::init()
 
 void MAVLinkProtocol::setVersion(unsigned version)
 {
+    QList<uint8_t> channels;
     const QList<SharedLinkInterfacePtr> sharedLinks = LinkManager::instance()->links();
     for (const SharedLinkInterfacePtr &interface : sharedLinks) {
-        mavlink_set_proto_version(interface.get()->mavlinkChannel(), version / 100);
+        channels.append(interface.get()->mavlinkChannel());
     }
 
+    // The channel status flags are also written by the parser, so they are only modified from the protocol thread
+    runOnProtocolThread([channels, version]() {
+        for (const uint8_t channel : channels) {
+            mavlink_set_proto_version(channel, version / 100);
+        }
+    });
+
     _currentVersion = version;
 }
 
+void MAVLinkProtocol::registerLink(LinkInterface *link)
+{
+    const uint8_t mavlinkChannel = link->mavlinkChannel();
+    (void) QMetaObject::invokeMethod(_worker, [this, link, mavlinkChannel]() { _worker->addLink(link, mavlinkChannel); }, Qt::QueuedConnection);
+    (void) connect(link, &LinkInterface::bytesReceived, _worker, &MAVLinkProtocolWorker::receiveBytes);
+    (void) connect(link, &LinkInterface::bytesSent, this, &MAVLinkProtocol::logSentBytes);
+}
+
+void MAVLinkProtocol::unregisterLink(LinkInterface *link)
+{
+    (void) disconnect(link, &LinkInterface::bytesReceived, _worker, &MAVLinkProtocolWorker::receiveBytes);
+    (void) disconnect(link, &LinkInterface::bytesSent, this, &MAVLinkProtocol::logSentBytes);
+
+    // Bytes the link already queued to the worker are ahead of this call and still decoded with the current state
+    const uint8_t mavlinkChannel = link->mavlinkChannel();
+    runOnProtocolThread([this, link, mavlinkChannel]() {
+        _worker->removeLink(link);
+        mavlink_reset_channel_status(mavlinkChannel);
+    });
+}
+
+void MAVLinkProtocol::runOnProtocolThread(const std::function<void()> &function)
+{
+    if (!_workerThread->isRunning() || (QThread::currentThread() == _workerThread)) {
+        function();
+    } else {
+        (void) QMetaObject::invokeMethod(_worker, function, Qt::BlockingQueuedConnection);
+    }
+}
+
 void MAVLinkProtocol::_loadSettings()
 {
     QSettings settings;
@@ -102,13 +298,8 @@ void MAVLinkProtocol::_storeSettings() const
 
 void MAVLinkProtocol::resetMetadataForLink(LinkInterface *link)
 {
-    const uint8_t channel = link->mavlinkChannel();
-    _totalReceiveCounter[channel] = 0;
-    _totalLossCounter[channel] = 0;
-    _runningLossPercent[channel] = 0.f;
-    for (int i = 0; i < 256; i++) {
-        _firstMessage[channel][i] = 1;
-    }
+    const uint8_t mavlinkChannel = link->mavlinkChannel();
+    (void) QMetaObject::invokeMethod(_worker, [this, mavlinkChannel]() { _worker->resetMetadataForChannel(mavlinkChannel); }, Qt::QueuedConnection);
 
     link->setDecodedFirstMavlinkPacket(false);
 }
@@ -117,101 +308,111 @@ void MAVLinkProtocol::logSentBytes(const LinkInterface *link, const QByteArray &
 {
     Q_UNUSED(link);
 
-    if (_logSuspendError || _logSuspendReplay || !_tempLogFile->isOpen()) {
+    if (_logSuspendError || _logSuspendReplay) {
         return;
     }
 
-    const quint64 time = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
-    uint8_t bytes_time[sizeof(quint64)]{};
-    qToBigEndian(time, bytes_time);
+    _tlogWriter->writeBytes(data.constData(), data.size());
+}
 
-    QByteArray logData = data;
-    QByteArray timeData = QByteArray::fromRawData(reinterpret_cast<const char*>(bytes_time), sizeof(bytes_time));
-    (void) logData.prepend(timeData);
-    if (_tempLogFile->write(logData) != logData.length()) {
-        const QString message = QStringLiteral("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile->fileName());
-        qgcApp()->showAppMessage(message, getName());
-        _stopLogging();
-        _logSuspendError = true;
-    }
+quint64 MAVLinkProtocol::logDroppedBytes() const
+{
+    return _tlogWriter->droppedBytes();
 }
 
-void MAVLinkProtocol::receiveBytes(LinkInterface *link, const QByteArray &data)
+quint64 MAVLinkProtocol::logDelayedBytes() const
 {
-    const SharedLinkInterfacePtr linkPtr = LinkManager::instance()->sharedLinkInterfacePointerForLink(link);
-    if (!linkPtr) {
-        qCDebug(MAVLinkProtocolLog) << "receiveBytes: link gone!" << data.size() << "bytes arrived too late";
+    return _tlogWriter->delayedBytes();
+}
+
+void MAVLinkProtocol::_logWriteError(const QString &errorString)
+{
+    if (_logSuspendError || !_tlogWriter->isOpen()) {
         return;
     }
 
-    for (const uint8_t &byte: data) {
-        const uint8_t mavlinkChannel = link->mavlinkChannel();
-        mavlink_message_t message{};
-        mavlink_status_t status{};
+    const QString message = QStringLiteral("MAVLink Logging failed. Could not write to file %1, logging disabled. %2").arg(_tempLogFile->fileName(), errorString);
+    qgcApp()->showAppMessage(message, getName());
+    if (!_tlogWriter->isClosing()) {
+        // Otherwise the close in progress finishes the file
+        _stopLogging();
+    }
+    _logSuspendError = true;
+}
 
-        if (mavlink_parse_char(mavlinkChannel, byte, &message, &status) != MAVLINK_FRAMING_OK) {
+/// Processes the messages decoded by the protocol thread. Runs on the main thread.
+void MAVLinkProtocol::_processReceivedMessages()
+{
+    _worker->acknowledgeMessagesAvailable();
+
+    MAVLinkProtocolWorker::ReceiveRing &receiveRing = _worker->receiveRing();
+    const LinkInterface *lastLink = nullptr;
+    SharedLinkInterfacePtr linkPtr;
+
+    // Handlers may spin a nested event loop which drains again, so every message is copied out and released
+    // before the fan out. Messages taken from the overflow queue are older than anything in the ring after it.
+    while (true) {
+        if (!_overflowBacklog.isEmpty()) {
+            const MAVLinkProtocolWorker::ReceivedMessage received = _overflowBacklog.takeFirst();
+            _processReceivedMessage(received.link, received.message, lastLink, linkPtr);
             continue;
         }
 
-        _updateVersion(link, mavlinkChannel);
-        _updateCounters(mavlinkChannel, message);
-        _forward(message);
-        _forwardSupport(message);
-        _logData(link, message);
+        if (MAVLinkProtocolWorker::ReceivedMessage *const received = receiveRing.front()) {
+            LinkInterface *const link = received->link;
+            const mavlink_message_t message = received->message;
+            receiveRing.popFront();
+            _processReceivedMessage(link, message, lastLink, linkPtr);
+            continue;
+        }
 
-        if (!_updateStatus(link, linkPtr, mavlinkChannel, message)) {
+        _worker->takeOverflow(_overflowBacklog);
+        if (_overflowBacklog.isEmpty()) {
             break;
         }
     }
 }
 
-void MAVLinkProtocol::_updateVersion(LinkInterface *link, uint8_t mavlinkChannel)
+void MAVLinkProtocol::_processReceivedMessage(LinkInterface *link, const mavlink_message_t &message, const LinkInterface *&lastLink, SharedLinkInterfacePtr &linkPtr)
 {
-    if (link->decodedFirstMavlinkPacket()) {
-        return;
+    if (link != lastLink) {
+        lastLink = link;
+        linkPtr = LinkManager::instance()->sharedLinkInterfacePointerForLink(link);
     }
 
-    link->setDecodedFirstMavlinkPacket(true);
-    const mavlink_status_t *const mavlinkStatus = mavlink_get_channel_status(mavlinkChannel);
-
-    if (mavlinkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1) {
+    if (!linkPtr) {
         return;
     }
 
-    if (mavlink_get_proto_version(mavlinkChannel) == 1) {
-        qCDebug(MAVLinkProtocolLog) << "Switching outbound to mavlink 2.0 due to incoming mavlink 2.0 packet:" << mavlinkChannel;
-        setVersion(200);
+    _updateVersion(link, message);
+    _forward(message);
+    _forwardSupport(message);
+    _logData(link, message);
+
+    emit messageReceived(link, message);
+
+    if (linkPtr.use_count() == 1) {
+        // Link was removed while handling the message, drop the rest of its messages
+        linkPtr.reset();
     }
 }
 
-void MAVLinkProtocol::_updateCounters(uint8_t mavlinkChannel, const mavlink_message_t &message)
+void MAVLinkProtocol::_updateVersion(LinkInterface *link, const mavlink_message_t &message)
 {
-    uint8_t lastSeq = _lastIndex[message.sysid][message.compid];
-    uint8_t expectedSeq = lastSeq + 1;
-    _totalReceiveCounter[mavlinkChannel]++;
-    if (_firstMessage[message.sysid][message.compid] != 0) {
-        _firstMessage[message.sysid][message.compid] = 0;
-        lastSeq = message.seq;
-        expectedSeq = message.seq;
+    if (link->decodedFirstMavlinkPacket()) {
+        return;
     }
 
-    if (message.seq != expectedSeq) {
-        uint64_t lostMessages = message.seq;
-        if (message.seq < expectedSeq) {
-            lostMessages += 255;
-        }
-        lostMessages -= expectedSeq;
-        _totalLossCounter[mavlinkChannel] += lostMessages;
-    }
+    link->setDecodedFirstMavlinkPacket(true);
 
-    _lastIndex[message.sysid][message.compid] = message.seq;
+    if (message.magic == MAVLINK_STX_MAVLINK1) {
+        return;
+    }
 
-    const uint64_t totalSent = _totalReceiveCounter[mavlinkChannel] + _totalLossCounter[mavlinkChannel];
-    float receiveLossPercent = static_cast<float>(static_cast<double>(_totalLossCounter[mavlinkChannel]) / static_cast<double>(totalSent));
-    receiveLossPercent *= 100.0f;
-    receiveLossPercent *= 0.5f;
-    receiveLossPercent += (_runningLossPercent[mavlinkChannel] * 0.5f);
-    _runningLossPercent[mavlinkChannel] = receiveLossPercent;
+    if (_currentVersion < 200) {
+        qCDebug(MAVLinkProtocolLog) << "Switching outbound to mavlink 2.0 due to incoming mavlink 2.0 packet:" << link->mavlinkChannel();
+        setVersion(200);
+    }
 }
 
 void MAVLinkProtocol::_forward(const mavlink_message_t &message)
@@ -256,19 +457,8 @@ void MAVLinkProtocol::_forwardSupport(const mavlink_message_t &message)
 
 void MAVLinkProtocol::_logData(LinkInterface *link, const mavlink_message_t &message)
 {
-    if (!_logSuspendError && !_logSuspendReplay && _tempLogFile->isOpen()) {
-        const quint64 timestamp = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
-        uint8_t buf[MAVLINK_MAX_PACKET_LEN + sizeof(timestamp)]{};
-        qToBigEndian(timestamp, buf);
-
-        const qsizetype len = mavlink_msg_to_send_buffer(buf + sizeof(timestamp), &message) + sizeof(timestamp);
-        const QByteArray log_data(reinterpret_cast<const char*>(buf), len);
-        if (_tempLogFile->write(log_data) != len) {
-            const QString message = QStringLiteral("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile->fileName());
-            qgcApp()->showAppMessage(message, getName());
-            _stopLogging();
-            _logSuspendError = true;
-        }
+    if (!_logSuspendError && !_logSuspendReplay && _tlogWriter->isOpen()) {
+        _tlogWriter->writeMessage(message);
 
         if ((message.msgid == MAVLINK_MSG_ID_HEARTBEAT) && !_vehicleWasArmed) {
             if (mavlink_msg_heartbeat_get_base_mode(&message) & MAV_MODE_FLAG_DECODE_POSITION_SAFETY) {
@@ -305,35 +495,19 @@ void MAVLinkProtocol::_logData(LinkInterface *link, const mavlink_message_t &mes
     }
 }
 
-bool MAVLinkProtocol::_updateStatus(LinkInterface *link, const SharedLinkInterfacePtr linkPtr, uint8_t mavlinkChannel, const mavlink_message_t &message)
-{
-    if ((_totalReceiveCounter[mavlinkChannel] % 31) == 0) {
-        const uint64_t totalSent = _totalReceiveCounter[mavlinkChannel] + _totalLossCounter[mavlinkChannel];
-        emit mavlinkMessageStatus(message.sysid, totalSent, _totalReceiveCounter[mavlinkChannel], _totalLossCounter[mavlinkChannel], _runningLossPercent[mavlinkChannel]);
-    }
-
-    emit messageReceived(link, message);
-
-    if (linkPtr.use_count() == 1) {
-        return false;
-    }
-
-    return true;
-}
-
 bool MAVLinkProtocol::_closeLogFile()
 {
-    if (!_tempLogFile->isOpen()) {
+    if (!_tlogWriter->isOpen()) {
         return false;
     }
 
-    if (_tempLogFile->size() == 0) {
+    _tlogWriter->close();
+
+    if (QFileInfo(_tempLogFile->fileName()).size() == 0) {
         (void) _tempLogFile->remove();
         return false;
     }
 
-    (void) _tempLogFile->flush();
-    _tempLogFile->close();
     return true;
 }
 
@@ -354,7 +528,7 @@ void MAVLinkProtocol::_startLogging()
     }
 #endif
 
-    if (_tempLogFile->isOpen()) {
+    if (_tlogWriter->isOpen()) {
         return;
     }
 
@@ -362,13 +536,16 @@ void MAVLinkProtocol::_startLogging()
         return;
     }
 
+    // Creates the uniquely named file, the writer thread reopens it for append
     if (!_tempLogFile->open()) {
         const QString message = QStringLiteral("Opening Flight Data file for writing failed. Unable to write to %1. Please choose a different file location.").arg(_tempLogFile->fileName());
         qgcApp()->showAppMessage(message, getName());
-        _closeLogFile();
+        _tempLogFile->close();
         _logSuspendError = true;
         return;
     }
+    _tempLogFile->close();
+    _tlogWriter->open(_tempLogFile->fileName());
 
     qCDebug(MAVLinkProtocolLog) << "Temp log" << _tempLogFile->fileName();
     (void) _checkTelemetrySavePath();
@@ -378,7 +555,7 @@ void MAVLinkProtocol::_startLogging()
 
 void MAVLinkProtocol::_stopLogging()
 {
-    if (_tempLogFile->isOpen() && _closeLogFile()) {
+    if (_closeLogFile()) {
         AppSettings *const appSettings = SettingsManager::instance()->appSettings();
         if ((_vehicleWasArmed || appSettings->telemetrySaveNotArmed()->rawValue().toBool()) && appSettings->telemetrySave()->rawValue().toBool() && !appSettings->disableAllPersistence()->rawValue().toBool()) {
             _saveTelemetryLog(_tempLogFile->fileName());
@@ -10,17 +10,100 @@
 #pragma once
 
 #include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
 #include <QtCore/QString>
 
+#include <atomic>
+#include <functional>
+
 #include "LinkInterface.h"
 #include "MAVLinkLib.h"
+#include "QGCSPSCRing.h"
 
+class MAVLinkTlogWriter;
 class QGCTemporaryFile;
+class QThread;
 
 Q_DECLARE_LOGGING_CATEGORY(MAVLinkProtocolLog)
 
+/// Frames incoming link bytes and keeps the per channel loss statistics on the protocol thread.
+/// Decoded messages are handed to MAVLinkProtocol on the main thread in batches through a lock-free ring.
+/// If the main thread falls so far behind that the ring fills up, messages continue in a mutex protected
+/// overflow queue until the main thread has caught up. No message is ever dropped and ordering is kept.
+class MAVLinkProtocolWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct ReceivedMessage {
+        LinkInterface *link = nullptr;
+        mavlink_message_t message;
+    };
+    typedef QGCSPSCRing<ReceivedMessage, 4096> ReceiveRing;
+
+    explicit MAVLinkProtocolWorker(QObject *parent = nullptr);
+    ~MAVLinkProtocolWorker();
+
+    /// Only MAVLinkProtocol on the main thread may consume from the ring
+    ReceiveRing &receiveRing() { return _receiveRing; }
+
+    /// Consumer: Moves the overflow queue into messages. Only call once the ring has been drained, everything
+    /// in the overflow queue is newer than what was in the ring.
+    void takeOverflow(QList<ReceivedMessage> &messages);
+
+    /// Must be called by the consumer before it starts draining the ring after messagesAvailable
+    void acknowledgeMessagesAvailable() { _messagesAvailablePending.store(false, std::memory_order_release); }
+
+    /// Number of decoded messages which went through the overflow queue because the ring was full
+    quint64 overflowMessageCount() const { return _overflowMessageCount.load(std::memory_order_relaxed); }
+
+    /// Number of receiveBytes calls completed, their messages are in the ring once this is incremented
+    quint64 receivedBatchCount() const { return _receivedBatchCount.load(std::memory_order_acquire); }
+
+    /// Decoded messages waiting for the main thread
+    qsizetype receiveBacklog() const { return _receiveRing.size() + _overflowSize.load(std::memory_order_relaxed); }
+
+public slots:
+    void addLink(LinkInterface *link, uint8_t mavlinkChannel);
+    void removeLink(LinkInterface *link);
+    void resetMetadataForChannel(uint8_t mavlinkChannel);
+    void receiveBytes(LinkInterface *link, const QByteArray &data);
+
+signals:
+    /// Emitted once when messages arrive in an empty or already drained ring
+    void messagesAvailable();
+
+    void mavlinkMessageStatus(int sysid, uint64_t totalSent, uint64_t totalReceived, uint64_t totalLoss, float lossPercent);
+
+private:
+    void _updateCounters(uint8_t mavlinkChannel, const mavlink_message_t &message);
+    void _pushMessage(LinkInterface *link, const mavlink_message_t &message);
+
+    ReceiveRing _receiveRing;
+    std::atomic_bool _messagesAvailablePending = false;
+    std::atomic<quint64> _overflowMessageCount = 0;
+
+    QMutex _overflowMutex;
+    QList<ReceivedMessage> _overflow;               ///< Protected by _overflowMutex
+    std::atomic<qsizetype> _overflowSize = 0;
+    bool _overflowing = false;                      ///< Producer only: true while messages go to _overflow
+    std::atomic<quint64> _receivedBatchCount = 0;
+
+    QHash<const LinkInterface*, uint8_t> _linkChannels;                ///< Links known to the worker, bytes from any other link are dropped
+
+    uint8_t _lastIndex[256][256]{};                             ///< Store the last received sequence ID for each system/component pair
+    uint8_t _firstMessage[256][256]{};                          ///< First message flag
+    uint64_t _totalReceiveCounter[MAVLINK_COMM_NUM_BUFFERS]{};  ///< The total number of successfully received messages
+    uint64_t _totalLossCounter[MAVLINK_COMM_NUM_BUFFERS]{};     ///< Total messages lost during transmission.
+    float _runningLossPercent[MAVLINK_COMM_NUM_BUFFERS]{};      ///< Loss rate
+};
+
+/*===========================================================================*/
+
 /// MAVLink micro air vehicle protocol reference implementation.
 /// MAVLink is a generic communication protocol for micro air vehicles.
 /// for more information, please see the official website: https://mavlink.io
@@ -63,6 +146,33 @@ public:
     /// Reset the counters for all metadata for this link.
     void resetMetadataForLink(LinkInterface *link);
 
+    /// Routes the received bytes of the link through the protocol thread. Called by LinkManager when the link is created.
+    void registerLink(LinkInterface *link);
+
+    /// Stops processing bytes from the link. Called by LinkManager when the link disconnects. Returns once the
+    /// protocol thread has processed all bytes already received from the link and reset the parser of its
+    /// channel, so the channel can be freed and reused.
+    void unregisterLink(LinkInterface *link);
+
+    /// Runs function on the protocol thread and waits for it to finish. The parser also writes the MAVLink
+    /// channel status, so the status flags and signing of registered channels may only be changed from here.
+    void runOnProtocolThread(const std::function<void()> &function);
+
+    /// Number of decoded messages which had to go through the overflow queue because the main thread could not keep up
+    quint64 overflowMessageCount() const { return _worker->overflowMessageCount(); }
+
+    /// Number of byte batches from all links which the protocol thread has finished decoding
+    quint64 receivedBatchCount() const { return _worker->receivedBatchCount(); }
+
+    /// Decoded messages not yet processed on the main thread
+    qsizetype receiveBacklog() const { return _worker->receiveBacklog(); }
+
+    /// Telemetry log bytes discarded because the log writer thread could not keep up
+    quint64 logDroppedBytes() const;
+
+    /// Telemetry log bytes which had to wait for the log writer thread
+    quint64 logDelayedBytes() const;
+
     /// Suspend/Restart logging during replay.
     void suspendLogForReplay(bool suspend) { _logSuspendReplay = suspend; }
 
@@ -90,10 +200,6 @@ signals:
     void mavlinkMessageStatus(int sysid, uint64_t totalSent, uint64_t totalReceived, uint64_t totalLoss, float lossPercent);
 
 public slots:
-    /// Receive bytes from a communication interface and constructs a MAVLink packet
-    ///     @param link The interface to read from
-    void receiveBytes(LinkInterface *link, const QByteArray &data);
-
     /// Log bytes sent from a communication interface and logs a MAVLink packet.
     /// It can handle multiple links in parallel, as each link has it's own buffer/parsing state machine.
     ///     @param link The interface to read from
@@ -110,8 +216,11 @@ public slots:
 
 private slots:
     void _vehicleCountChanged();
+    void _processReceivedMessages();
+    void _logWriteError(const QString &errorString);
 
 private:
+    void _processReceivedMessage(LinkInterface *link, const mavlink_message_t &message, const LinkInterface *&lastLink, SharedLinkInterfacePtr &linkPtr);
     void _logData(LinkInterface *link, const mavlink_message_t &message);
     bool _closeLogFile();
     void _startLogging();
@@ -120,9 +229,7 @@ private:
     void _forward(const mavlink_message_t &message);
     void _forwardSupport(const mavlink_message_t &message);
 
-    void _updateCounters(uint8_t mavlinkChannel, const mavlink_message_t &message);
-    bool _updateStatus(LinkInterface *link, const SharedLinkInterfacePtr linkPtr, uint8_t mavlinkChannel, const mavlink_message_t &message);
-    void _updateVersion(LinkInterface *link, uint8_t mavlinkChannel);
+    void _updateVersion(LinkInterface *link, const mavlink_message_t &message);
 
     void _saveTelemetryLog(const QString &tempLogfile);
     bool _checkTelemetrySavePath();
@@ -130,18 +237,17 @@ private:
     void _storeSettings() const;
     void _loadSettings();
 
-    QGCTemporaryFile * const _tempLogFile = nullptr;
+    QGCTemporaryFile * const _tempLogFile = nullptr;   ///< Only used to pick the file name, _tlogWriter does the writing
+    MAVLinkTlogWriter * const _tlogWriter = nullptr;
+    QThread * const _workerThread = nullptr;
+    MAVLinkProtocolWorker * const _worker = nullptr;
+    QList<MAVLinkProtocolWorker::ReceivedMessage> _overflowBacklog;    ///< Taken from the worker overflow, processed before the ring
 
     bool _logSuspendError = false;  ///< true: Logging suspended due to error
     bool _logSuspendReplay = false; ///< true: Logging suspended due to replay
     bool _vehicleWasArmed = false;  ///< true: Vehicle was armed during log sequence
 
     bool _enableVersionCheck = true;                            ///< Enable checking of version match of MAV and QGC
-    uint8_t _lastIndex[256][256]{};                             ///< Store the last received sequence ID for each system/component pair
-    uint8_t _firstMessage[256][256]{};                          ///< First message flag
-    uint64_t _totalReceiveCounter[MAVLINK_COMM_NUM_BUFFERS]{};  ///< The total number of successfully received messages
-    uint64_t _totalLossCounter[MAVLINK_COMM_NUM_BUFFERS]{};     ///< Total messages lost during transmission.
-    float _runningLossPercent[MAVLINK_COMM_NUM_BUFFERS]{};      ///< Loss rate
 
     int _systemId = kMaxSysId;
     unsigned _currentVersion = 100;
@@ -0,0 +1,283 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkTlogWriter.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtCore/QtEndian>
+
+#include <cstring>
+
+QGC_LOGGING_CATEGORY(MAVLinkTlogWriterLog, "qgc.comms.mavlinktlogwriter")
+
+MAVLinkTlogWriterWorker::MAVLinkTlogWriterWorker(QObject *parent)
+    : QObject(parent)
+{
+    // qCDebug(MAVLinkTlogWriterLog) << Q_FUNC_INFO << this;
+}
+
+MAVLinkTlogWriterWorker::~MAVLinkTlogWriterWorker()
+{
+    closeFile();
+
+    // qCDebug(MAVLinkTlogWriterLog) << Q_FUNC_INFO << this;
+}
+
+void MAVLinkTlogWriterWorker::openFile(const QString &fileName)
+{
+    closeFile();
+
+    _error = false;
+    _errorString.clear();
+    _file = new QFile(fileName, this);
+    // Blocks are already large, skip the QFile buffer copy
+    if (!_file->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+        _error = true;
+        _errorString = _file->errorString();
+        emit writeError(_errorString);
+    }
+}
+
+QString MAVLinkTlogWriterWorker::closeFile()
+{
+    if (!_file) {
+        return QString();
+    }
+
+    _file->close();
+    if (!_error && (_file->error() != QFileDevice::NoError)) {
+        _error = true;
+        _errorString = _file->errorString();
+    }
+
+    delete _file;
+    _file = nullptr;
+
+    return _errorString;
+}
+
+void MAVLinkTlogWriterWorker::writeBlock(MAVLinkTlogBlock *block)
+{
+    if (_file && !_error) {
+        if (_file->write(block->data.get(), block->size) != block->size) {
+            _error = true;
+            _errorString = _file->errorString();
+            emit writeError(_errorString);
+        }
+    }
+
+    block->size = 0;
+    emit blockWritten(block);
+}
+
+/*===========================================================================*/
+
+MAVLinkTlogWriter::MAVLinkTlogWriter(QObject *parent)
+    : QObject(parent)
+    , _writerThread(new QThread(this))
+    , _worker(new MAVLinkTlogWriterWorker())
+    , _flushTimer(new QTimer(this))
+{
+    // qCDebug(MAVLinkTlogWriterLog) << Q_FUNC_INFO << this;
+
+    _worker->moveToThread(_writerThread);
+
+    (void) connect(_writerThread, &QThread::finished, _worker, &QObject::deleteLater);
+    (void) connect(_worker, &MAVLinkTlogWriterWorker::blockWritten, this, &MAVLinkTlogWriter::_blockWritten, Qt::QueuedConnection);
+    (void) connect(_worker, &MAVLinkTlogWriterWorker::writeError, this, &MAVLinkTlogWriter::_workerWriteError, Qt::QueuedConnection);
+
+    _flushTimer->setInterval(kFlushIntervalMsecs);
+    (void) connect(_flushTimer, &QTimer::timeout, this, &MAVLinkTlogWriter::_flushTimeout);
+
+    // Double buffered: one block being filled, one being written
+    _activeBlock = _takeFreeBlock();
+    _freeBlocks.append(_takeFreeBlock());
+
+    _writerThread->setObjectName(QStringLiteral("MAVLinkTlogWriter"));
+    _writerThread->start();
+}
+
+MAVLinkTlogWriter::~MAVLinkTlogWriter()
+{
+    close();
+
+    _writerThread->quit();
+    _writerThread->wait();
+
+    // qCDebug(MAVLinkTlogWriterLog) << Q_FUNC_INFO << this;
+}
+
+void MAVLinkTlogWriter::open(const QString &fileName)
+{
+    if (_open) {
+        close();
+    }
+
+    _timestampBaseUsecs = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()) * 1000;
+    _timestampTimer.start();
+    _droppedBytes = 0;
+    _delayedBytes = 0;
+    _errorReported = false;
+
+    (void) QMetaObject::invokeMethod(_worker, [this, fileName]() { _worker->openFile(fileName); }, Qt::QueuedConnection);
+
+    _open = true;
+    _flushTimer->start();
+}
+
+void MAVLinkTlogWriter::close()
+{
+    if (!_open || _closing) {
+        return;
+    }
+
+    _flushTimer->stop();
+
+    if (!_submitActiveBlock()) {
+        // Writer is far behind and the backlog is full. What is left would otherwise be lost with the file.
+        _droppedBytes += _activeBlock->size;
+        _activeBlock->size = 0;
+    }
+
+    // Queued behind all pending blocks, so everything submitted is on disk once this returns
+    QString errorString;
+    (void) QMetaObject::invokeMethod(_worker, [this, &errorString]() { errorString = _worker->closeFile(); }, Qt::BlockingQueuedConnection);
+
+    // The queued error signal of the worker would only arrive once the file is marked closed
+    if (!errorString.isEmpty() && !_errorReported) {
+        _errorReported = true;
+        _closing = true;
+        emit writeError(errorString);
+        _closing = false;
+    }
+
+    _open = false;
+
+    if (_droppedBytes || _delayedBytes) {
+        qCWarning(MAVLinkTlogWriterLog) << "Log closed, dropped bytes:" << _droppedBytes << "delayed bytes:" << _delayedBytes;
+    }
+}
+
+void MAVLinkTlogWriter::writeMessage(const mavlink_message_t &message)
+{
+    if (!_open) {
+        return;
+    }
+
+    const qsizetype len = mavlink_msg_get_send_buffer_length(&message);
+    char *const record = _appendRecord(len);
+    if (record) {
+        (void) mavlink_msg_to_send_buffer(reinterpret_cast<uint8_t*>(record), &message);
+    }
+}
+
+void MAVLinkTlogWriter::writeBytes(const char *data, qsizetype size)
+{
+    if (!_open || (size <= 0)) {
+        return;
+    }
+
+    if ((kTimestampLen + size) > kBlockSize) {
+        qCWarning(MAVLinkTlogWriterLog) << "Record larger than a log block, dropped:" << size;
+        _droppedBytes += size;
+        return;
+    }
+
+    char *const record = _appendRecord(size);
+    if (record) {
+        (void) memcpy(record, data, size);
+    }
+}
+
+/// Reserves space for a record in the active block and fills in the timestamp
+///     @return Location to copy dataLen bytes of record data to, nullptr if the record was dropped
+char *MAVLinkTlogWriter::_appendRecord(qsizetype dataLen)
+{
+    const qsizetype recordLen = kTimestampLen + dataLen;
+    if (((_activeBlock->size + recordLen) > kBlockSize) && !_submitActiveBlock()) {
+        _droppedBytes += recordLen;
+        if ((_droppedBytes / kBlockSize) != ((_droppedBytes - recordLen) / kBlockSize)) {
+            qCWarning(MAVLinkTlogWriterLog) << "Log writer is not keeping up, dropped bytes:" << _droppedBytes;
+        }
+        return nullptr;
+    }
+
+    char *const record = _activeBlock->data.get() + _activeBlock->size;
+    const quint64 timestamp = _timestampBaseUsecs + static_cast<quint64>(_timestampTimer.nsecsElapsed() / 1000);
+    qToBigEndian(timestamp, record);
+    _activeBlock->size += recordLen;
+
+    return record + kTimestampLen;
+}
+
+/// Hands the active block to the writer thread and switches to a free one
+///     @return false: Too many blocks are waiting to be written, the active block was kept
+bool MAVLinkTlogWriter::_submitActiveBlock()
+{
+    if (_activeBlock->size == 0) {
+        return true;
+    }
+
+    if (_pendingBlockCount >= kMaxPendingBlocks) {
+        return false;
+    }
+
+    if (_pendingBlockCount > 0) {
+        // Beyond double buffering, the writer hasn't finished the previous block yet
+        _delayedBytes += _activeBlock->size;
+    }
+
+    MAVLinkTlogBlock *const block = _activeBlock;
+    _activeBlock = _takeFreeBlock();
+    _pendingBlockCount++;
+
+    (void) QMetaObject::invokeMethod(_worker, [this, block]() { _worker->writeBlock(block); }, Qt::QueuedConnection);
+
+    return true;
+}
+
+MAVLinkTlogBlock *MAVLinkTlogWriter::_takeFreeBlock()
+{
+    if (!_freeBlocks.isEmpty()) {
+        return _freeBlocks.takeLast();
+    }
+
+    auto block = std::make_unique<MAVLinkTlogBlock>();
+    block->data = std::make_unique<char[]>(kBlockSize);
+    _blocks.push_back(std::move(block));
+
+    qCDebug(MAVLinkTlogWriterLog) << "Allocated log block, total:" << _blocks.size();
+
+    return _blocks.back().get();
+}
+
+void MAVLinkTlogWriter::_blockWritten(MAVLinkTlogBlock *block)
+{
+    _pendingBlockCount--;
+    _freeBlocks.append(block);
+}
+
+void MAVLinkTlogWriter::_workerWriteError(const QString &errorString)
+{
+    if (_errorReported) {
+        return;
+    }
+
+    _errorReported = true;
+    emit writeError(errorString);
+}
+
+void MAVLinkTlogWriter::_flushTimeout()
+{
+    (void) _submitActiveBlock();
+}
@@ -0,0 +1,139 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <memory>
+#include <vector>
+
+#include "MAVLinkLib.h"
+
+class QFile;
+class QThread;
+class QTimer;
+
+Q_DECLARE_LOGGING_CATEGORY(MAVLinkTlogWriterLog)
+
+/// Block of timestamped tlog records. Ownership moves between the producer and the writer thread by pointer.
+struct MAVLinkTlogBlock
+{
+    std::unique_ptr<char[]> data;
+    qsizetype size = 0;
+};
+
+/// Owns the tlog file on the writer thread
+class MAVLinkTlogWriterWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MAVLinkTlogWriterWorker(QObject *parent = nullptr);
+    ~MAVLinkTlogWriterWorker();
+
+    void openFile(const QString &fileName);
+
+    /// @return First error hit while the file was open, empty if none
+    QString closeFile();
+
+    /// Writes the block to the file and hands it back through blockWritten
+    void writeBlock(MAVLinkTlogBlock *block);
+
+signals:
+    void blockWritten(MAVLinkTlogBlock *block);
+    void writeError(const QString &errorString);
+
+private:
+    QFile *_file = nullptr;
+    bool _error = false;    ///< true: Write failed, blocks are returned without being written
+    QString _errorString;
+};
+
+/*===========================================================================*/
+
+/// Writes the tlog without ever touching the file from the producing thread.
+/// Records (big endian usec timestamp followed by the MAVLink frame) are serialized straight into a preallocated
+/// block. Full blocks, or partial ones once kFlushIntervalMsecs has passed, are handed to the writer thread while
+/// the producer continues in the spare block. If the writer falls behind additional blocks are queued up to
+/// kMaxPendingBlocks, after which records are dropped instead of stalling telemetry.
+class MAVLinkTlogWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MAVLinkTlogWriter(QObject *parent = nullptr);
+    ~MAVLinkTlogWriter();
+
+    /// Starts logging to the specified file. The file is opened for append on the writer thread.
+    void open(const QString &fileName);
+
+    /// Writes out all pending records and closes the file. Blocks until the writer thread is done.
+    /// An error the writer thread hit and did not report yet is emitted through writeError before the
+    /// file is marked closed.
+    void close();
+
+    bool isOpen() const { return _open; }
+
+    /// true while close() is reporting a pending error, the file must not be closed again from writeError
+    bool isClosing() const { return _closing; }
+
+    /// Logs a MAVLink message
+    void writeMessage(const mavlink_message_t &message);
+
+    /// Logs raw bytes as a single record
+    void writeBytes(const char *data, qsizetype size);
+
+    /// Bytes discarded because the writer thread fell too far behind
+    quint64 droppedBytes() const { return _droppedBytes; }
+
+    /// Bytes which had to wait for a previous block to be written
+    quint64 delayedBytes() const { return _delayedBytes; }
+
+    static constexpr qsizetype kTimestampLen = sizeof(quint64);
+    static constexpr qsizetype kBlockSize = 256 * 1024;
+    static constexpr int kMaxPendingBlocks = 8;
+    static constexpr int kFlushIntervalMsecs = 1000;
+
+signals:
+    /// The file could not be opened or written. Logging stays open, but nothing further reaches the file.
+    void writeError(const QString &errorString);
+
+private slots:
+    void _blockWritten(MAVLinkTlogBlock *block);
+    void _workerWriteError(const QString &errorString);
+    void _flushTimeout();
+
+private:
+    char *_appendRecord(qsizetype dataLen);
+    bool _submitActiveBlock();
+    MAVLinkTlogBlock *_takeFreeBlock();
+
+    QThread * const _writerThread = nullptr;
+    MAVLinkTlogWriterWorker * const _worker = nullptr;
+    QTimer * const _flushTimer = nullptr;
+
+    std::vector<std::unique_ptr<MAVLinkTlogBlock>> _blocks;   ///< Owns all blocks, wherever they currently are
+    QList<MAVLinkTlogBlock*> _freeBlocks;
+    MAVLinkTlogBlock *_activeBlock = nullptr;
+    int _pendingBlockCount = 0;
+
+    bool _open = false;
+    bool _closing = false;
+    bool _errorReported = false;    ///< true: The worker error of the current file reached writeError already
+    quint64 _timestampBaseUsecs = 0;
+    QElapsedTimer _timestampTimer;      ///< Monotonic offset from _timestampBaseUsecs, avoids a wall clock query per record
+
+    quint64 _droppedBytes = 0;
+    quint64 _delayedBytes = 0;
+};
@@ -105,6 +105,8 @@ MockLink::MockLink(SharedLinkConfigurationPtr& config)
     _mavCustomMode = px4_cm.data;
 
     _mockLinkFTP = new MockLinkFTP(_vehicleSystemId, _vehicleComponentId, this);
+    // ArduPilot serves its mission, fence and rally points over FTP
+    _mockLinkFTP->enableMissionFiles(_firmwareType == MAV_AUTOPILOT_ARDUPILOTMEGA);
 
     moveToThread(this);
 
@@ -126,10 +128,14 @@ bool MockLink::_connect(void)
     if (!_connected) {
         _connected = true;
         // MockLinks use Mavlink 2.0
-        mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(mavlinkChannel());
-        mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
-        mavlink_status_t* auxStatus = mavlink_get_channel_status(mavlinkAuxChannel());
-        auxStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        const uint8_t channel = mavlinkChannel();
+        const uint8_t auxChannel = mavlinkAuxChannel();
+        MAVLinkProtocol::instance()->runOnProtocolThread([channel, auxChannel]() {
+            mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(channel);
+            mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+            mavlink_status_t* auxStatus = mavlink_get_channel_status(auxChannel);
+            auxStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        });
         start();
         emit connected();
     }
@@ -831,6 +837,11 @@ float MockLink::_floatUnionForParam(int componentId, const QString& paramName)
     return valueUnion.param_float;
 }
 
+bool MockLink::_dropParamValue(void)
+{
+    return (_paramLossPercent > 0) && (QRandomGenerator::global()->bounded(100) < _paramLossPercent);
+}
+
 void MockLink::_handleParamRequestList(const mavlink_message_t& msg)
 {
     if (_failureMode == MockConfiguration::FailParamNoReponseToRequestList) {
@@ -863,6 +874,8 @@ void MockLink::_paramRequestListWorker(void)
 
     if ((_failureMode == MockConfiguration::FailMissingParamOnInitialReqest || _failureMode == MockConfiguration::FailMissingParamOnAllRequests) && paramName == _failParam) {
         qCDebug(MockLinkLog) << "Skipping param send:" << paramName;
+    } else if (_dropParamValue()) {
+        qCDebug(MockLinkLog) << "Dropping param send:" << paramName;
     } else {
 
         char paramId[MAVLINK_MSG_ID_PARAM_VALUE_LEN];
@@ -996,6 +1009,11 @@ void MockLink::_handleParamRequestRead(const mavlink_message_t& msg)
         return;
     }
 
+    if (_dropParamValue()) {
+        qCDebug(MockLinkLog) << "Dropping request read response for" << paramId;
+        return;
+    }
+
     mavlink_msg_param_value_pack_chan(_vehicleSystemId,
                                       componentId,                                               // component id
                                       mavlinkChannel(),
@@ -1250,7 +1268,7 @@ void MockLink::_respondWithAutopilotVersion(void)
 #if !defined(NO_ARDUPILOT_DIALECT)
     }
 #endif
-    uint64_t capabilities = MAV_PROTOCOL_CAPABILITY_MAVLINK2 | MAV_PROTOCOL_CAPABILITY_MISSION_FENCE | MAV_PROTOCOL_CAPABILITY_MISSION_RALLY | MAV_PROTOCOL_CAPABILITY_MISSION_INT |
+    uint64_t capabilities = MAV_PROTOCOL_CAPABILITY_MAVLINK2 | MAV_PROTOCOL_CAPABILITY_MISSION_FENCE | MAV_PROTOCOL_CAPABILITY_MISSION_RALLY | MAV_PROTOCOL_CAPABILITY_MISSION_INT | MAV_PROTOCOL_CAPABILITY_FTP |
             (_firmwareType == MAV_AUTOPILOT_ARDUPILOTMEGA ? MAV_PROTOCOL_CAPABILITY_TERRAIN : 0);
 
     mavlink_msg_autopilot_version_pack_chan(_vehicleSystemId,
@@ -1642,9 +1660,12 @@ QString MockLink::_createRandomFile(uint32_t byteCount)
 
     tempFile.setAutoRemove(false);
     if (tempFile.open()) {
-        for (uint32_t bytesWritten=0; bytesWritten<byteCount; bytesWritten++) {
-            unsigned char byte = (QRandomGenerator::global()->generate() * 0xFF) / RAND_MAX;
-            tempFile.write((char *)&byte, 1);
+        QList<quint32> block(1024);
+        while (byteCount > 0) {
+            QRandomGenerator::global()->fillRange(block.data(), block.size());
+            const qint64 bytesToWrite = qMin<qint64>(byteCount, block.size() * sizeof(quint32));
+            tempFile.write(reinterpret_cast<const char*>(block.constData()), bytesToWrite);
+            byteCount -= bytesToWrite;
         }
         tempFile.close();
         return tempFile.fileName();
@@ -1689,27 +1710,33 @@ void MockLink::_logDownloadWorker(void)
     if (_logDownloadBytesRemaining != 0) {
         QFile file(_logDownloadFilename);
         if (file.open(QIODevice::ReadOnly)) {
-            uint8_t buffer[MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN];
-
-            qint64 bytesToRead = qMin(_logDownloadBytesRemaining, (uint32_t)MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-            Q_ASSERT(file.seek(_logDownloadCurrentOffset));
-            Q_ASSERT(file.read((char *)buffer, bytesToRead) == bytesToRead);
-
-            qCDebug(MockLinkLog) << "_logDownloadWorker" << _logDownloadCurrentOffset << _logDownloadBytesRemaining;
-
-            mavlink_message_t responseMsg;
-            mavlink_msg_log_data_pack_chan(_vehicleSystemId,
-                                           _vehicleComponentId,
-                                           mavlinkChannel(),
-                                           &responseMsg,
-                                           _logDownloadLogId,
-                                           _logDownloadCurrentOffset,
-                                           bytesToRead,
-                                           &buffer[0]);
-            respondWithMavlinkMessage(responseMsg);
-
-            _logDownloadCurrentOffset += bytesToRead;
-            _logDownloadBytesRemaining -= bytesToRead;
+            for (int i = 0; (i < _logDataPacketsPerTick) && (_logDownloadBytesRemaining != 0); i++) {
+                uint8_t buffer[MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN];
+
+                qint64 bytesToRead = qMin(_logDownloadBytesRemaining, (uint32_t)MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
+                // Not inside Q_ASSERT, release builds would skip the read
+                const bool readOk = file.seek(_logDownloadCurrentOffset) && (file.read((char *)buffer, bytesToRead) == bytesToRead);
+                Q_ASSERT(readOk);
+                Q_UNUSED(readOk);
+
+                qCDebug(MockLinkLog) << "_logDownloadWorker" << _logDownloadCurrentOffset << _logDownloadBytesRemaining;
+
+                if ((_logDataLossPercent == 0) || (QRandomGenerator::global()->bounded(100) >= _logDataLossPercent)) {
+                    mavlink_message_t responseMsg;
+                    mavlink_msg_log_data_pack_chan(_vehicleSystemId,
+                                                   _vehicleComponentId,
+                                                   mavlinkChannel(),
+                                                   &responseMsg,
+                                                   _logDownloadLogId,
+                                                   _logDownloadCurrentOffset,
+                                                   bytesToRead,
+                                                   &buffer[0]);
+                    respondWithMavlinkMessage(responseMsg);
+                }
+
+                _logDownloadCurrentOffset += bytesToRead;
+                _logDownloadBytesRemaining -= bytesToRead;
+            }
 
             file.close();
         } else {
@@ -115,6 +115,19 @@ public:
     void            setSendStatusText   (bool sendStatusText)                           { _sendStatusText = sendStatusText; }
     void            setFailureMode      (MockConfiguration::FailureMode_t failureMode)  { _failureMode = failureMode; }
 
+    /// Drops the specified percentage of PARAM_VALUE messages sent in response to parameter requests, for testing
+    /// parameter loading over a lossy link
+    void setParamLossPercent(int paramLossPercent) { _paramLossPercent = paramLossPercent; }
+
+    /// Size of the simulated log file, must be set before the log is first requested
+    void setLogDownloadFileSize(uint32_t logDownloadFileSize) { _logDownloadFileSize = logDownloadFileSize; }
+
+    /// Number of LOG_DATA messages sent per 500Hz tick, for testing log download throughput
+    void setLogDataPacketsPerTick(int logDataPacketsPerTick) { _logDataPacketsPerTick = logDataPacketsPerTick; }
+
+    /// Drops the specified percentage of LOG_DATA messages
+    void setLogDataLossPercent(int logDataLossPercent) { _logDataLossPercent = logDataLossPercent; }
+
     /// APM stack has strange handling of the first item of the mission list. If it has no
     /// onboard mission items, sometimes it sends back a home position in position 0 and
     /// sometimes it doesn't. Don't ask. This option allows you to configure that behavior
@@ -158,6 +171,9 @@ public:
     /// Reset the state of the MissionItemHandler to no items, no transactions in progress.
     void resetMissionItemHandler(void) { _missionItemHandler.reset(); }
 
+    /// Returns the items of the specified type in the ArduPilot @MISSION file format
+    QByteArray missionFile(MAV_MISSION_TYPE missionType) const { return _missionItemHandler.missionFile(missionType); }
+
     /// Returns the filename for the simulated log file. Only available after a download is requested.
     QString logDownloadFile(void) { return _logDownloadFilename; }
 
@@ -241,6 +257,7 @@ private:
     void _handleParamMapRC              (const mavlink_message_t& msg);
     bool _handleRequestMessage          (const mavlink_command_long_t& request, bool& noAck);
     float _floatUnionForParam           (int componentId, const QString& paramName);
+    bool _dropParamValue                (void);
     void _setParamFloatUnionIntoMap     (int componentId, const QString& paramName, float paramFloat);
     void _sendHomePosition              (void);
     void _sendGpsRawInt                 (void);
@@ -312,6 +329,7 @@ private:
     bool _sendStatusText;
     bool _apmSendHomePositionOnEmptyList;
     MockConfiguration::FailureMode_t _failureMode;
+    int _paramLossPercent = 0;
 
     int _sendHomePositionDelayCount;
     int _sendGPSPositionDelayCount;
@@ -320,7 +338,9 @@ private:
     int _currentParamRequestListParamIndex;     // Current parameter index for param request list workflow
 
     static const uint16_t _logDownloadLogId = 0;        ///< Id of siumulated log file
-    static const uint32_t _logDownloadFileSize = 1000;  ///< Size of simulated log file
+    uint32_t _logDownloadFileSize = 1000;               ///< Size of simulated log file
+    int _logDataPacketsPerTick = 1;
+    int _logDataLossPercent = 0;
 
     QString     _logDownloadFilename;       ///< Filename for log download which is in progress
     uint32_t    _logDownloadCurrentOffset;  ///< Current offset we are sending from
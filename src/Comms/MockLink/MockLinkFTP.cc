@@ -20,6 +20,16 @@ MockLinkFTP::MockLinkFTP(uint8_t systemIdServer, uint8_t componentIdServer, Mock
     srand(0); // make sure unit tests are deterministic
 }
 
+MockLinkFTP::~MockLinkFTP()
+{
+    for (uint8_t session: _sessions.keys()) {
+        _closeSession(session);
+    }
+    for (const QString& uploadedFile: _uploadedFiles) {
+        QFile::remove(uploadedFile);
+    }
+}
+
 void MockLinkFTP::ensureNullTemination(MavlinkFTP::Request* request)
 {
     if (request->hdr.size < sizeof(request->data)) {
@@ -88,12 +98,78 @@ void MockLinkFTP::_listCommand(uint8_t senderSystemId, uint8_t senderComponentId
     _sendResponse(senderSystemId, senderComponentId, &ackResponse, outgoingSeqNumber);
 }
 
+/// @brief Resolves a path on the vehicle to the local file served for it
+///     @param temporary Set to true if the file was created for the request
+QString MockLinkFTP::_localFile(const QString& path, bool& temporary)
+{
+    temporary = false;
+
+    QString sizePrefix = sizeFilenamePrefix;
+    if (_uploadedFiles.contains(path)) {
+        return _uploadedFiles[path];
+    } else if (path.startsWith(sizePrefix)) {
+        QString sizeString = path.right(path.length() - sizePrefix.length());
+        temporary = true;
+        return _createTestTempFile(sizeString.toInt());
+    } else if (path == "/general.json") {
+        return ":MockLink/General.MetaData.json";
+    } else if (path == "/general.json.xz") {
+        return ":MockLink/General.MetaData.json.xz";
+    } else if (path == "/parameter.json") {
+        return ":MockLink/Parameter.MetaData.json";
+    } else if (path == "/parameter.json.xz") {
+        return ":MockLink/Parameter.MetaData.json.xz";
+    } else if (_BinParamFileEnabled && path == "@PARAM/param.pck") {
+        return ":MockLink/Arduplane.params.ftp.bin";
+    } else if (_missionFilesEnabled && path.startsWith("@MISSION/")) {
+        QString tmpFilename = _createMissionTempFile(path);
+        temporary = !tmpFilename.isEmpty();
+        return tmpFilename;
+    }
+
+    return QString();
+}
+
+/// @return Id of the new session, -1 if all sessions are in use
+int MockLinkFTP::_openSession(QFile* file, bool temporary)
+{
+    if (_sessions.count() >= _maxSessions) {
+        return -1;
+    }
+
+    uint8_t session = 1;
+    while (_sessions.contains(session)) {
+        session++;
+    }
+    _sessions[session] = { file, temporary };
+
+    return session;
+}
+
+void MockLinkFTP::_closeSession(uint8_t session)
+{
+    if (!_sessions.contains(session)) {
+        return;
+    }
+
+    Session_t sessionInfo = _sessions.take(session);
+    sessionInfo.file->close();
+    if (sessionInfo.temporary) {
+        sessionInfo.file->remove();
+    }
+    delete sessionInfo.file;
+}
+
+QFile* MockLinkFTP::_sessionFile(uint8_t session) const
+{
+    return _sessions.contains(session) ? _sessions[session].file : nullptr;
+}
+
 void MockLinkFTP::_openCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber)
 {
     MavlinkFTP::Request response{};
     QString             path;
     uint16_t            outgoingSeqNumber = _nextSeqNumber(seqNumber);
-    QString             tmpFilename;
     
     ensureNullTemination(request);
 
@@ -102,43 +178,33 @@ void MockLinkFTP::_openCommand(uint8_t senderSystemId, uint8_t senderComponentId
     Q_UNUSED(cchPath); // Fix initialized-but-not-referenced warning on release builds
     path = (char *)request->data;
 
-    _currentFile.close();
-
-    QString sizePrefix = sizeFilenamePrefix;
-    if (path.startsWith(sizePrefix)) {
-        QString sizeString = path.right(path.length() - sizePrefix.length());
-        tmpFilename = _createTestTempFile(sizeString.toInt());
-    } else if (path == "/general.json") {
-        tmpFilename = ":MockLink/General.MetaData.json";
-    } else if (path == "/general.json.xz") {
-        tmpFilename = ":MockLink/General.MetaData.json.xz";
-    } else if (path == "/parameter.json") {
-        tmpFilename = ":MockLink/Parameter.MetaData.json";
-    } else if (path == "/parameter.json.xz") {
-        tmpFilename = ":MockLink/Parameter.MetaData.json.xz";
-    } else if (_BinParamFileEnabled && path == "@PARAM/param.pck") {
-        tmpFilename = ":MockLink/Arduplane.params.ftp.bin";
+    if (_sessions.count() >= _maxSessions) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrNoSessionsAvailable, outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
+        return;
     }
 
-    if (!tmpFilename.isEmpty()) {
-        _currentFile.setFileName(tmpFilename);
-        if (!_currentFile.open(QIODevice::ReadOnly)) {
-            _sendNakErrno(senderSystemId, senderComponentId, _currentFile.error(), outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
-            return;
-        }
-    } else {
+    bool    temporary;
+    QString tmpFilename = _localFile(path, temporary);
+    if (tmpFilename.isEmpty()) {
         _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileNotFound, outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
         return;
     }
+
+    QFile* file = new QFile(tmpFilename);
+    if (!file->open(QIODevice::ReadOnly)) {
+        _sendNakErrno(senderSystemId, senderComponentId, file->error(), outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
+        delete file;
+        return;
+    }
     
     response.hdr.opcode     = MavlinkFTP::kRspAck;
     response.hdr.req_opcode = MavlinkFTP::kCmdOpenFileRO;
-    response.hdr.session    = _sessionId;
+    response.hdr.session    = _openSession(file, temporary);
     
     // Data contains file length
     response.hdr.size = sizeof(uint32_t);
     /* Ardupilot sends constant wrong file size for parameter file due to dynamic on the fly generation */
-    response.openFileLength = (path == "@PARAM/param.pck" ? 1024*1024 : _currentFile.size());
+    response.openFileLength = (path == "@PARAM/param.pck" ? 1024*1024 : file->size());
     
     _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
 }
@@ -147,9 +213,10 @@ void MockLinkFTP::_readCommand(uint8_t senderSystemId, uint8_t senderComponentId
 {
     MavlinkFTP::Request	response{};
     uint16_t			outgoingSeqNumber = _nextSeqNumber(seqNumber);
+    QFile*              file = _sessionFile(request->hdr.session);
 
-    if (request->hdr.session != _sessionId) {
-        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdReadFile);
+    if (!file) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdReadFile, request->hdr.session);
         return;
     }
     
@@ -159,7 +226,7 @@ void MockLinkFTP::_readCommand(uint8_t senderSystemId, uint8_t senderComponentId
         // If we get here it means the client is requesting additional data past the first request
         if (_errMode == errModeNakSecondResponse) {
             // Nak error all subsequent requests
-            _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFail, outgoingSeqNumber, MavlinkFTP::kCmdReadFile);
+            _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFail, outgoingSeqNumber, MavlinkFTP::kCmdReadFile, request->hdr.session);
             return;
         } else if (_errMode == errModeNoSecondResponse) {
             // No rsponse for all subsequent requests
@@ -167,20 +234,20 @@ void MockLinkFTP::_readCommand(uint8_t senderSystemId, uint8_t senderComponentId
         }
     }
     
-    if (readOffset >= _currentFile.size()) {
-        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdReadFile);
+    if (readOffset >= file->size()) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdReadFile, request->hdr.session);
         return;
     }
     
-    uint8_t cBytesToRead = (uint8_t)qMin((qint64)sizeof(response.data), _currentFile.size() - readOffset);
-    _currentFile.seek(readOffset);
-    QByteArray bytes = _currentFile.read(cBytesToRead);
+    uint8_t cBytesToRead = (uint8_t)qMin((qint64)sizeof(response.data), file->size() - readOffset);
+    file->seek(readOffset);
+    QByteArray bytes = file->read(cBytesToRead);
     memcpy(response.data, bytes.constData(), cBytesToRead);
     
     // We should always have written something, otherwise there is something wrong with the code above
     Q_ASSERT(cBytesToRead);
     
-    response.hdr.session    = _sessionId;
+    response.hdr.session    = request->hdr.session;
     response.hdr.size       = cBytesToRead;
     response.hdr.offset     = request->hdr.offset;
     response.hdr.opcode     = MavlinkFTP::kRspAck;
@@ -193,9 +260,10 @@ void MockLinkFTP::_burstReadCommand(uint8_t senderSystemId, uint8_t senderCompon
 {
     uint16_t            outgoingSeqNumber = _nextSeqNumber(seqNumber);
     MavlinkFTP::Request response{};
+    QFile*              file = _sessionFile(request->hdr.session);
 
-    if (request->hdr.session != _sessionId) {
-        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFail, outgoingSeqNumber, MavlinkFTP::kCmdBurstReadFile);
+    if (!file) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdBurstReadFile, request->hdr.session);
         return;
     }
     
@@ -203,18 +271,18 @@ void MockLinkFTP::_burstReadCommand(uint8_t senderSystemId, uint8_t senderCompon
     int         burstCount  = 1;
     uint32_t    burstOffset = request->hdr.offset;
 
-    while (burstOffset < _currentFile.size() && burstCount++ < burstMax) {
-        _currentFile.seek(burstOffset);
+    while (burstOffset < file->size() && burstCount++ < burstMax) {
+        file->seek(burstOffset);
 
-        uint8_t     cBytes  = (uint8_t)qMin((qint64)sizeof(response.data), _currentFile.size() - burstOffset);
-        QByteArray  bytes   = _currentFile.read(cBytes);
+        uint8_t     cBytes  = (uint8_t)qMin((qint64)sizeof(response.data), file->size() - burstOffset);
+        QByteArray  bytes   = file->read(cBytes);
 
         // We should always have written something, otherwise there is something wrong with the code above
         Q_ASSERT(cBytes);
 
         memcpy(response.data, bytes.constData(), cBytes);
 
-        response.hdr.session        = _sessionId;
+        response.hdr.session        = request->hdr.session;
         response.hdr.size           = cBytes;
         response.hdr.offset         = burstOffset;
         response.hdr.opcode         = MavlinkFTP::kRspAck;
@@ -227,22 +295,116 @@ void MockLinkFTP::_burstReadCommand(uint8_t senderSystemId, uint8_t senderCompon
         burstOffset += cBytes;
     }
 
-    if (burstOffset >= _currentFile.size()) {
+    if (burstOffset >= file->size()) {
         // Burst is fully complete
-        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdBurstReadFile);
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdBurstReadFile, request->hdr.session);
     }
 }
 
+/// @brief Handles Create command requests. The file is kept in a temporary file, see uploadedFile.
+void MockLinkFTP::_createCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber)
+{
+    uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    ensureNullTemination(request);
+    QString path = (char *)request->data;
+
+    if (_sessions.count() >= _maxSessions) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrNoSessionsAvailable, outgoingSeqNumber, MavlinkFTP::kCmdCreateFile);
+        return;
+    }
+
+    QString uploadedFile = _uploadedFiles.value(path);
+    if (uploadedFile.isEmpty()) {
+        QGCTemporaryFile tmpFile("MockLinkFTPUpload");
+        tmpFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        tmpFile.close();
+        uploadedFile = tmpFile.fileName();
+        _uploadedFiles[path] = uploadedFile;
+    }
+
+    QFile* file = new QFile(uploadedFile);
+    if (!file->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        _sendNakErrno(senderSystemId, senderComponentId, file->error(), outgoingSeqNumber, MavlinkFTP::kCmdCreateFile);
+        delete file;
+        return;
+    }
+
+    _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdCreateFile, _openSession(file, false /* temporary */));
+}
+
+void MockLinkFTP::_writeCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber)
+{
+    MavlinkFTP::Request response{};
+    uint16_t            outgoingSeqNumber = _nextSeqNumber(seqNumber);
+    QFile*              file = _sessionFile(request->hdr.session);
+
+    if (!file || !file->isWritable()) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdWriteFile, request->hdr.session);
+        return;
+    }
+
+    if (request->hdr.offset != 0 && _errMode == errModeNakSecondResponse) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFail, outgoingSeqNumber, MavlinkFTP::kCmdWriteFile, request->hdr.session);
+        return;
+    }
+
+    if (!file->seek(request->hdr.offset) || file->write((const char*)request->data, request->hdr.size) != request->hdr.size) {
+        _sendNakErrno(senderSystemId, senderComponentId, file->error(), outgoingSeqNumber, MavlinkFTP::kCmdWriteFile, request->hdr.session);
+        return;
+    }
+    file->flush();
+
+    response.hdr.opcode         = MavlinkFTP::kRspAck;
+    response.hdr.req_opcode     = MavlinkFTP::kCmdWriteFile;
+    response.hdr.session        = request->hdr.session;
+    response.hdr.offset         = request->hdr.offset;
+    response.hdr.size           = sizeof(uint32_t);
+    response.writeFileLength    = request->hdr.size;
+
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+}
+
+void MockLinkFTP::_calcFileCRC32Command(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber)
+{
+    MavlinkFTP::Request response{};
+    uint16_t            outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    ensureNullTemination(request);
+    QString path = (char *)request->data;
+
+    bool    temporary;
+    QString localFile = _localFile(path, temporary);
+    QFile   file(localFile);
+    if (localFile.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileNotFound, outgoingSeqNumber, MavlinkFTP::kCmdCalcFileCRC32);
+        return;
+    }
+    QByteArray bytes = file.readAll();
+    file.close();
+    if (temporary) {
+        file.remove();
+    }
+
+    response.hdr.opcode     = MavlinkFTP::kRspAck;
+    response.hdr.req_opcode = MavlinkFTP::kCmdCalcFileCRC32;
+    response.hdr.size       = sizeof(uint32_t);
+    response.openFileLength = MavlinkFTP::crc32((const uint8_t*)bytes.constData(), bytes.size());
+
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+}
+
 void MockLinkFTP::_terminateCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber)
 {
     uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
 
-    if (request->hdr.session != _sessionId) {
-        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession);
+    if (!_sessions.contains(request->hdr.session)) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession, request->hdr.session);
         return;
     }
-    
-    _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession);
+
+    _closeSession(request->hdr.session);
+    _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession, request->hdr.session);
 
     emit terminateCommandReceived();
 }
@@ -251,8 +413,9 @@ void MockLinkFTP::_resetCommand(uint8_t senderSystemId, uint8_t senderComponentI
 {
     uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
     
-    _currentFile.close();
-    _currentFile.remove();
+    for (uint8_t session: _sessions.keys()) {
+        _closeSession(session);
+    }
     _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdResetSessions);
     
     emit resetCommandReceived();
@@ -275,15 +438,15 @@ void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t& message)
 
     MavlinkFTP::Request* request = (MavlinkFTP::Request*)&requestFTP.payload[0];
 
-    // kCmdOpenFileRO and kCmdResetSessions don't support retry so we can't drop those
-    if (_randomDropsEnabled && request->hdr.opcode != MavlinkFTP::kCmdOpenFileRO && request->hdr.opcode != MavlinkFTP::kCmdResetSessions) {
+    // kCmdOpenFileRO, kCmdCreateFile and kCmdResetSessions don't support retry so we can't drop those
+    if (_randomDropsEnabled && request->hdr.opcode != MavlinkFTP::kCmdOpenFileRO && request->hdr.opcode != MavlinkFTP::kCmdCreateFile && request->hdr.opcode != MavlinkFTP::kCmdResetSessions) {
         if ((rand() % 5) == 0) {
             qDebug() << "MockLinkFTP: Random drop of incoming packet";
             return;
         }
     }
 
-    if (_lastReplyValid && request->hdr.seqNumber == _lastReplySequence - 1) {
+    if (_lastReplyValid && request->hdr.seqNumber == _lastReplySequence - 1 && request->hdr.opcode == _lastReplyReqOpcode) {
         // This is the same request as the one we replied to last. It means the (n)ack got lost, and the GCS
         // resent the request
         qDebug() << "MockLinkFTP: resending response";
@@ -330,6 +493,18 @@ void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t& message)
         _burstReadCommand(message.sysid, message.compid, request, incomingSeqNumber);
         break;
 
+    case MavlinkFTP::kCmdCreateFile:
+        _createCommand(message.sysid, message.compid, request, incomingSeqNumber);
+        break;
+
+    case MavlinkFTP::kCmdWriteFile:
+        _writeCommand(message.sysid, message.compid, request, incomingSeqNumber);
+        break;
+
+    case MavlinkFTP::kCmdCalcFileCRC32:
+        _calcFileCRC32Command(message.sysid, message.compid, request, incomingSeqNumber);
+        break;
+
     case MavlinkFTP::kCmdTerminateSession:
         _terminateCommand(message.sysid, message.compid, request, incomingSeqNumber);
         break;
@@ -346,38 +521,38 @@ void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t& message)
 }
 
 /// @brief Sends an Ack
-void MockLinkFTP::_sendAck(uint8_t targetSystemId, uint8_t targetComponentId, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode)
+void MockLinkFTP::_sendAck(uint8_t targetSystemId, uint8_t targetComponentId, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode, uint8_t session)
 {
     MavlinkFTP::Request ackResponse{};
     
     ackResponse.hdr.opcode      = MavlinkFTP::kRspAck;
     ackResponse.hdr.req_opcode  = reqOpcode;
-    ackResponse.hdr.session     = _sessionId;
+    ackResponse.hdr.session     = session;
     ackResponse.hdr.size        = 0;
     
     _sendResponse(targetSystemId, targetComponentId, &ackResponse, seqNumber);
 }
 
-void MockLinkFTP::_sendNak(uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::ErrorCode_t error, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode)
+void MockLinkFTP::_sendNak(uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::ErrorCode_t error, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode, uint8_t session)
 {
     MavlinkFTP::Request nakResponse{};
 
     nakResponse.hdr.opcode      = MavlinkFTP::kRspNak;
     nakResponse.hdr.req_opcode  = reqOpcode;
-    nakResponse.hdr.session     = _sessionId;
+    nakResponse.hdr.session     = session;
     nakResponse.hdr.size        = 1;
     nakResponse.data[0]         = error;
     
     _sendResponse(targetSystemId, targetComponentId, &nakResponse, seqNumber);
 }
 
-void MockLinkFTP::_sendNakErrno(uint8_t targetSystemId, uint8_t targetComponentId, uint8_t nakErrno, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode)
+void MockLinkFTP::_sendNakErrno(uint8_t targetSystemId, uint8_t targetComponentId, uint8_t nakErrno, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpcode, uint8_t session)
 {
     MavlinkFTP::Request nakResponse{};
 
     nakResponse.hdr.opcode      = MavlinkFTP::kRspNak;
     nakResponse.hdr.req_opcode  = reqOpcode;
-    nakResponse.hdr.session     = _sessionId;
+    nakResponse.hdr.session     = session;
     nakResponse.hdr.size        = 2;
     nakResponse.data[0]         = MavlinkFTP::kErrFailErrno;
     nakResponse.data[1]         = nakErrno;
@@ -390,6 +565,7 @@ void MockLinkFTP::_sendResponse(uint8_t targetSystemId, uint8_t targetComponentI
 {
     request->hdr.seqNumber  = seqNumber;
     _lastReplySequence      = seqNumber;
+    _lastReplyReqOpcode     = request->hdr.req_opcode;
     _lastReplyValid         = true;
     
     mavlink_msg_file_transfer_protocol_pack_chan(_systemIdServer,               // System ID
@@ -401,8 +577,8 @@ void MockLinkFTP::_sendResponse(uint8_t targetSystemId, uint8_t targetComponentI
                                                  targetComponentId,
                                                  (uint8_t*)request);            // Payload
 
-    // kCmdOpenFileRO and kCmdResetSessions don't support retry so we can't drop those
-    if (_randomDropsEnabled && request->hdr.req_opcode != MavlinkFTP::kCmdOpenFileRO && request->hdr.req_opcode != MavlinkFTP::kCmdResetSessions) {
+    // kCmdOpenFileRO, kCmdCreateFile and kCmdResetSessions don't support retry so we can't drop those
+    if (_randomDropsEnabled && request->hdr.req_opcode != MavlinkFTP::kCmdOpenFileRO && request->hdr.req_opcode != MavlinkFTP::kCmdCreateFile && request->hdr.req_opcode != MavlinkFTP::kCmdResetSessions) {
         if ((rand() % 5) == 0) {
             qDebug() << "MockLinkFTP: Random drop of outgoing packet";
             return;
@@ -434,3 +610,23 @@ QString MockLinkFTP::_createTestTempFile(int size)
     tmpFile.close();
     return tmpFile.fileName();
 }
+
+QString MockLinkFTP::_createMissionTempFile(const QString& path)
+{
+    MAV_MISSION_TYPE missionType;
+    if (path == "@MISSION/mission.dat") {
+        missionType = MAV_MISSION_TYPE_MISSION;
+    } else if (path == "@MISSION/fence.dat") {
+        missionType = MAV_MISSION_TYPE_FENCE;
+    } else if (path == "@MISSION/rally.dat") {
+        missionType = MAV_MISSION_TYPE_RALLY;
+    } else {
+        return QString();
+    }
+
+    QGCTemporaryFile tmpFile("MockLinkFTPMission");
+    tmpFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    tmpFile.write(_mockLink->missionFile(missionType));
+    tmpFile.close();
+    return tmpFile.fileName();
+}
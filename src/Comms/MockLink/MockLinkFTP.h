@@ -14,6 +14,7 @@
 
 #include <QtCore/QStringList>
 #include <QtCore/QFile>
+#include <QtCore/QMap>
 
 class MockLink;
 
@@ -24,6 +25,7 @@ class MockLinkFTP : public QObject
     
 public:
     MockLinkFTP(uint8_t systemIdServer, uint8_t componentIdServer, MockLink* mockLink);
+    ~MockLinkFTP();
     
     /// @brief Sets the list of files returned by the List command. Prepend names with F or D
     /// to indicate (F)ile or (D)irectory.
@@ -62,6 +64,13 @@ public:
 
     void enableRandromDrops(bool enable) { _randomDropsEnabled = enable; }
     void enableBinParamFile(bool enable) { _BinParamFileEnabled = enable; }
+    /// Serves the mission, fence and rally items from @MISSION/mission.dat, fence.dat and rally.dat
+    void enableMissionFiles(bool enable) { _missionFilesEnabled = enable; }
+    /// Sets the number of sessions which can be open at the same time, further opens are Nak'ed with kErrNoSessionsAvailable
+    void setMaxSessions(int maxSessions) { _maxSessions = maxSessions; }
+
+    /// @return Local file holding what was uploaded to path, empty if nothing was
+    QString uploadedFile(const QString& path) const { return _uploadedFiles.value(path); }
 
     static constexpr const char* sizeFilenamePrefix = "mocklink-size-";
 
@@ -73,35 +82,49 @@ signals:
     void resetCommandReceived(void);
     
 private:
-    void        _sendAck                (uint8_t targetSystemId, uint8_t targetComponentId, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode);
-    void        _sendNak                (uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::ErrorCode_t error, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode);
-    void        _sendNakErrno           (uint8_t targetSystemId, uint8_t targetComponentId, uint8_t nakErrno, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode);
+    struct Session_t {
+        QFile*  file;
+        bool    temporary;      ///< File was created for the session, removed when it is closed
+    };
+
+    void        _sendAck                (uint8_t targetSystemId, uint8_t targetComponentId, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode, uint8_t session = 0);
+    void        _sendNak                (uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::ErrorCode_t error, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode, uint8_t session = 0);
+    void        _sendNakErrno           (uint8_t targetSystemId, uint8_t targetComponentId, uint8_t nakErrno, uint16_t seqNumber, MavlinkFTP::OpCode_t reqOpCode, uint8_t session = 0);
     void        _sendResponse           (uint8_t targetSystemId, uint8_t targetComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
     void        _listCommand            (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
     void        _openCommand            (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
     void        _readCommand            (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
-    void        _burstReadCommand          (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
+    void        _burstReadCommand       (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
+    void        _createCommand          (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
+    void        _writeCommand           (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
+    void        _calcFileCRC32Command   (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
     void        _terminateCommand       (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
     void        _resetCommand           (uint8_t senderSystemId, uint8_t senderComponentId, uint16_t seqNumber);
     uint16_t    _nextSeqNumber          (uint16_t seqNumber);
+    QString     _localFile              (const QString& path, bool& temporary);
+    int         _openSession            (QFile* file, bool temporary);
+    void        _closeSession           (uint8_t session);
+    QFile*      _sessionFile            (uint8_t session) const;
     QString     _createTestTempFile     (int size);
+    QString     _createMissionTempFile  (const QString& path);
     
     /// if request is a string, this ensures it's null-terminated
     static void ensureNullTemination(MavlinkFTP::Request* request);
 
     QStringList _fileList;  ///< List of files returned by List command
     
-    QFile                   _currentFile;
+    QMap<uint8_t, Session_t> _sessions;                         ///< Open sessions by id
+    QMap<QString, QString>  _uploadedFiles;                     ///< Local files by the path they were uploaded to
+    int                     _maxSessions        = 2;
     ErrorMode_t             _errMode            = errModeNone;  ///< Currently set error mode, as specified by setErrorMode
     const uint8_t           _systemIdServer;                    ///< System ID for server
     const uint8_t           _componentIdServer;                 ///< Component ID for server
     MockLink*               _mockLink;                          ///< MockLink to communicate through
     bool                    _lastReplyValid     = false;
     uint16_t                _lastReplySequence  = 0;
+    uint8_t                 _lastReplyReqOpcode = MavlinkFTP::kCmdNone;
     mavlink_message_t       _lastReply;
     bool                    _randomDropsEnabled = false;
     bool                    _BinParamFileEnabled = false;
-
-    static const uint8_t    _sessionId          = 1;    ///< We only support a single fixed session
+    bool                    _missionFilesEnabled = false;
 };
-
@@ -14,6 +14,7 @@
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QtEndian>
 
 QGC_LOGGING_CATEGORY(MockLinkMissionItemHandlerLog, "MockLinkMissionItemHandlerLog")
 
@@ -246,6 +247,68 @@ void MockLinkMissionItemHandler::_handleMissionRequest(const mavlink_message_t&
     }
 }
 
+QByteArray MockLinkMissionItemHandler::missionFile(MAV_MISSION_TYPE missionType) const
+{
+    QList<mavlink_mission_item_int_t> items;
+    switch (missionType) {
+    case MAV_MISSION_TYPE_MISSION:
+        items = _missionItems.values();
+        if (items.isEmpty() && _sendHomePositionOnEmptyList) {
+            mavlink_mission_item_int_t homeItem{};
+            homeItem.frame          = MAV_FRAME_GLOBAL_RELATIVE_ALT;
+            homeItem.command        = MAV_CMD_NAV_WAYPOINT;
+            homeItem.autocontinue   = true;
+            items.append(homeItem);
+        }
+        break;
+    case MAV_MISSION_TYPE_FENCE:
+        items = _fenceItems.values();
+        break;
+    case MAV_MISSION_TYPE_RALLY:
+        items = _rallyItems.values();
+        break;
+    default:
+        return QByteArray();
+    }
+
+    static constexpr int headerSize = 10;
+    static constexpr int itemSize   = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
+
+    QByteArray bytes(headerSize + (items.count() * itemSize), '\0');
+    uchar* data = reinterpret_cast<uchar*>(bytes.data());
+
+    // magic, data type, options, start, item count
+    qToLittleEndian<quint16>(0x763d, data);
+    qToLittleEndian<quint16>(missionType, data + 2);
+    qToLittleEndian<quint16>(0, data + 4);
+    qToLittleEndian<quint16>(0, data + 6);
+    qToLittleEndian<quint16>(static_cast<quint16>(items.count()), data + 8);
+
+    for (int i=0; i<items.count(); i++) {
+        const mavlink_mission_item_int_t& item = items[i];
+        uchar* record = data + headerSize + (i * itemSize);
+
+        // MISSION_ITEM_INT payload in wire order
+        qToLittleEndian<float>(item.param1, record);
+        qToLittleEndian<float>(item.param2, record + 4);
+        qToLittleEndian<float>(item.param3, record + 8);
+        qToLittleEndian<float>(item.param4, record + 12);
+        qToLittleEndian<qint32>(item.x, record + 16);
+        qToLittleEndian<qint32>(item.y, record + 20);
+        qToLittleEndian<float>(item.z, record + 24);
+        qToLittleEndian<quint16>(i, record + 28);
+        qToLittleEndian<quint16>(item.command, record + 30);
+        record[32] = _mockLink->vehicleId();
+        record[33] = MAV_COMP_ID_AUTOPILOT1;
+        record[34] = item.frame;
+        record[35] = item.current;
+        record[36] = item.autocontinue;
+        record[37] = missionType;
+    }
+
+    return bytes;
+}
+
 void MockLinkMissionItemHandler::_handleMissionCount(const mavlink_message_t& msg)
 {
     mavlink_mission_count_t missionCount;
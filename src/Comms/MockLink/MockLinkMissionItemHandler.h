@@ -12,6 +12,7 @@
 
 #include "QGCMAVLink.h"
 
+#include <QtCore/QByteArray>
 #include <QtCore/QObject>
 #include <QtCore/QMap>
 #include <QtCore/QTimer>
@@ -80,6 +81,9 @@ public:
 
     void setSendHomePositionOnEmptyList(bool sendHomePositionOnEmptyList) { _sendHomePositionOnEmptyList = sendHomePositionOnEmptyList; }
 
+    /// Returns the items of the specified type as ArduPilot serves them from @MISSION/<type>.dat over MAVLink FTP
+    QByteArray missionFile(MAV_MISSION_TYPE missionType) const;
+
 private slots:
     void _missionItemResponseTimeout(void);
 
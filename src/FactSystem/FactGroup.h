@@ -54,6 +54,9 @@ public:
     /// Allows a FactGroup to parse incoming messages and fill in values
     virtual void handleMessage(Vehicle* vehicle, mavlink_message_t& message);
 
+    /// @return Message ids handleMessage is interested in, empty list for all messages
+    virtual QList<uint32_t> handledMessageIds() const { return QList<uint32_t>(); }
+
 signals:
     void factNamesChanged           (void);
     void factGroupNamesChanged      (void);
@@ -0,0 +1,255 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterCache.h"
+#include "QGC.h"
+#include <QGCLoggingCategory.h>
+
+#include <QtCore/QSaveFile>
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+QGC_LOGGING_CATEGORY(ParameterCacheLog, "ParameterCacheLog")
+
+// Header: magic (4), version (2), reserved (2), parameter count (4), hash crc (4), string table size (4),
+// crc of entries and string table (4)
+
+ParameterCache::ParameterCache(const QString& path)
+    : _file(path)
+{
+    if (!_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    _size = _file.size();
+    if (_size < kHeaderSize) {
+        qCWarning(ParameterCacheLog) << "Cache file too small" << path;
+        return;
+    }
+
+    _data = _file.map(0, _size);
+    if (!_data) {
+        qCWarning(ParameterCacheLog) << "Unable to map cache file" << path << _file.errorString();
+        return;
+    }
+
+    if (memcmp(_data, kMagic, sizeof(kMagic)) || (qFromLittleEndian<quint16>(_data + 4) != kVersion)) {
+        qCDebug(ParameterCacheLog) << "Unknown cache format" << path;
+        return;
+    }
+
+    const quint32 count = qFromLittleEndian<quint32>(_data + 8);
+    _hashCrc = qFromLittleEndian<quint32>(_data + 12);
+    _stringsSize = qFromLittleEndian<quint32>(_data + 16);
+    const quint32 contentCrc = qFromLittleEndian<quint32>(_data + 20);
+
+    const qint64 entriesSize = static_cast<qint64>(count) * kEntrySize;
+    if ((kHeaderSize + entriesSize + _stringsSize) != _size) {
+        qCWarning(ParameterCacheLog) << "Cache file size mismatch" << path;
+        return;
+    }
+    if (QGC::crc32(_data + kHeaderSize, static_cast<unsigned>(_size - kHeaderSize), 0) != contentCrc) {
+        qCWarning(ParameterCacheLog) << "Cache file corrupt" << path;
+        return;
+    }
+
+    _count = static_cast<int>(count);
+    _strings = _data + kHeaderSize + entriesSize;
+    for (int i = 0; i < _count; i++) {
+        const uchar* const entry = _entry(i);
+        const quint64 nameEnd = static_cast<quint64>(qFromLittleEndian<quint32>(entry)) + qFromLittleEndian<quint16>(entry + 4);
+        const size_t valueSize = FactMetaData::typeToSize(static_cast<FactMetaData::ValueType_t>(entry[6]));
+        if ((nameEnd > _stringsSize) || (valueSize == 0) || (valueSize > sizeof(quint64))) {
+            qCWarning(ParameterCacheLog) << "Cache file entry out of range" << path << i;
+            _count = 0;
+            return;
+        }
+    }
+
+    _valid = true;
+}
+
+ParameterCache::~ParameterCache()
+{
+    if (_data) {
+        (void) _file.unmap(const_cast<uchar*>(_data));
+    }
+}
+
+const uchar* ParameterCache::_entry(int index) const
+{
+    return _data + kHeaderSize + (static_cast<qint64>(index) * kEntrySize);
+}
+
+QString ParameterCache::name(int index) const
+{
+    const uchar* const entry = _entry(index);
+    return QString::fromUtf8(reinterpret_cast<const char*>(_strings + qFromLittleEndian<quint32>(entry)), qFromLittleEndian<quint16>(entry + 4));
+}
+
+FactMetaData::ValueType_t ParameterCache::type(int index) const
+{
+    return static_cast<FactMetaData::ValueType_t>(_entry(index)[6]);
+}
+
+QVariant ParameterCache::rawValue(int index) const
+{
+    const uchar* const value = _entry(index) + 8;
+
+    // Same variant types ParameterManager::mavlinkMessageReceived creates, so a value from the cache compares equal
+    // to the same value from the vehicle
+    switch (type(index)) {
+    case FactMetaData::valueTypeUint8:
+        return QVariant(static_cast<int>(value[0]));
+    case FactMetaData::valueTypeInt8:
+        return QVariant(static_cast<int>(static_cast<qint8>(value[0])));
+    case FactMetaData::valueTypeUint16:
+        return QVariant(static_cast<int>(qFromLittleEndian<quint16>(value)));
+    case FactMetaData::valueTypeInt16:
+        return QVariant(static_cast<int>(qFromLittleEndian<qint16>(value)));
+    case FactMetaData::valueTypeUint32:
+        return QVariant(qFromLittleEndian<quint32>(value));
+    case FactMetaData::valueTypeInt32:
+        return QVariant(qFromLittleEndian<qint32>(value));
+    case FactMetaData::valueTypeUint64:
+        return QVariant(qFromLittleEndian<quint64>(value));
+    case FactMetaData::valueTypeInt64:
+        return QVariant(qFromLittleEndian<qint64>(value));
+    case FactMetaData::valueTypeFloat:
+    {
+        const quint32 bits = qFromLittleEndian<quint32>(value);
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        return QVariant(f);
+    }
+    case FactMetaData::valueTypeDouble:
+    {
+        const quint64 bits = qFromLittleEndian<quint64>(value);
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        return QVariant(d);
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QByteArray ParameterCache::_valueBytes(FactMetaData::ValueType_t type, const QVariant& rawValue)
+{
+    uchar bytes[sizeof(quint64)] = {};
+
+    switch (type) {
+    case FactMetaData::valueTypeUint8:
+        bytes[0] = static_cast<quint8>(rawValue.toUInt());
+        break;
+    case FactMetaData::valueTypeInt8:
+        bytes[0] = static_cast<quint8>(static_cast<qint8>(rawValue.toInt()));
+        break;
+    case FactMetaData::valueTypeUint16:
+        qToLittleEndian(static_cast<quint16>(rawValue.toUInt()), bytes);
+        break;
+    case FactMetaData::valueTypeInt16:
+        qToLittleEndian(static_cast<qint16>(rawValue.toInt()), bytes);
+        break;
+    case FactMetaData::valueTypeUint32:
+        qToLittleEndian(static_cast<quint32>(rawValue.toUInt()), bytes);
+        break;
+    case FactMetaData::valueTypeInt32:
+        qToLittleEndian(static_cast<qint32>(rawValue.toInt()), bytes);
+        break;
+    case FactMetaData::valueTypeUint64:
+        qToLittleEndian(static_cast<quint64>(rawValue.toULongLong()), bytes);
+        break;
+    case FactMetaData::valueTypeInt64:
+        qToLittleEndian(static_cast<qint64>(rawValue.toLongLong()), bytes);
+        break;
+    case FactMetaData::valueTypeFloat:
+    {
+        const float f = rawValue.toFloat();
+        quint32 bits;
+        memcpy(&bits, &f, sizeof(bits));
+        qToLittleEndian(bits, bytes);
+        break;
+    }
+    case FactMetaData::valueTypeDouble:
+    {
+        const double d = rawValue.toDouble();
+        quint64 bits;
+        memcpy(&bits, &d, sizeof(bits));
+        qToLittleEndian(bits, bytes);
+        break;
+    }
+    default:
+        return QByteArray();
+    }
+
+    return QByteArray(reinterpret_cast<const char*>(bytes), static_cast<qsizetype>(FactMetaData::typeToSize(type)));
+}
+
+quint32 ParameterCache::computeHashCrc(const QList<Param>& params)
+{
+    quint32 crc = 0;
+    for (const Param& param: params) {
+        if (param.volatileValue) {
+            continue;
+        }
+        const QByteArray name = param.name.toLocal8Bit();
+        const QByteArray value = _valueBytes(param.type, param.rawValue);
+        crc = QGC::crc32(reinterpret_cast<const quint8*>(name.constData()), static_cast<unsigned>(name.size()), crc);
+        crc = QGC::crc32(reinterpret_cast<const quint8*>(value.constData()), static_cast<unsigned>(value.size()), crc);
+    }
+    return crc;
+}
+
+bool ParameterCache::write(const QString& path, QList<Param> params)
+{
+    std::sort(params.begin(), params.end(), [](const Param& a, const Param& b) { return a.name < b.name; });
+
+    QByteArray entries;
+    QByteArray strings;
+    entries.reserve(params.count() * kEntrySize);
+    for (const Param& param: params) {
+        const QByteArray value = _valueBytes(param.type, param.rawValue);
+        const QByteArray name = param.name.toUtf8();
+        if (value.isEmpty() || (name.size() > 0xFFFF)) {
+            qCDebug(ParameterCacheLog) << "Parameter does not fit the cache" << param.name << param.type;
+            return false;
+        }
+
+        uchar entry[kEntrySize] = {};
+        qToLittleEndian(static_cast<quint32>(strings.size()), entry);
+        qToLittleEndian(static_cast<quint16>(name.size()), entry + 4);
+        entry[6] = static_cast<uchar>(param.type);
+        entry[7] = param.volatileValue ? kFlagVolatile : 0;
+        memcpy(entry + 8, value.constData(), static_cast<size_t>(value.size()));
+        entries.append(reinterpret_cast<const char*>(entry), kEntrySize);
+        strings.append(name);
+    }
+
+    const QByteArray content = entries + strings;
+    uchar header[kHeaderSize] = {};
+    memcpy(header, kMagic, sizeof(kMagic));
+    qToLittleEndian(kVersion, header + 4);
+    qToLittleEndian(static_cast<quint32>(params.count()), header + 8);
+    qToLittleEndian(computeHashCrc(params), header + 12);
+    qToLittleEndian(static_cast<quint32>(strings.size()), header + 16);
+    qToLittleEndian(QGC::crc32(reinterpret_cast<const quint8*>(content.constData()), static_cast<unsigned>(content.size()), 0), header + 20);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ParameterCacheLog) << "Unable to write cache" << path << file.errorString();
+        return false;
+    }
+    (void) file.write(reinterpret_cast<const char*>(header), kHeaderSize);
+    (void) file.write(content);
+
+    return file.commit();
+}
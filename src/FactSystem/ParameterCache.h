@@ -0,0 +1,78 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QString>
+#include <QtCore/QVariant>
+
+#include "FactMetaData.h"
+
+Q_DECLARE_LOGGING_CATEGORY(ParameterCacheLog)
+
+/// Binary parameter cache of a single vehicle component, read through a memory mapping.
+/// The file holds a fixed size header, one fixed size entry per parameter sorted by name and a string table with
+/// the parameter names. The header carries the crc the vehicle reports through _HASH_CHECK, computed over the
+/// non-volatile parameters when the cache is written, so a cache hit needs no per parameter work to validate.
+/// All values are little-endian.
+class ParameterCache
+{
+public:
+    struct Param {
+        QString                     name;
+        FactMetaData::ValueType_t   type = FactMetaData::valueTypeFloat;
+        QVariant                    rawValue;
+        bool                        volatileValue = false;  ///< true: does not take part in the hash crc
+    };
+
+    /// Maps the cache file, check isValid() before use
+    explicit ParameterCache(const QString& path);
+    ~ParameterCache();
+
+    bool isValid(void) const { return _valid; }
+    quint32 hashCrc(void) const { return _hashCrc; }
+    int count(void) const { return _count; }
+
+    QString                     name    (int index) const;
+    FactMetaData::ValueType_t   type    (int index) const;
+    /// @return Value with the same variant type as a value received through PARAM_VALUE
+    QVariant                    rawValue(int index) const;
+
+    /// Writes the cache atomically. Parameters need not be sorted.
+    ///     @return false: write failed or a parameter type does not fit the cache
+    static bool write(const QString& path, QList<Param> params);
+
+    /// Crc of the parameters as the vehicle computes it for _HASH_CHECK
+    ///     @param params Sorted by name
+    static quint32 computeHashCrc(const QList<Param>& params);
+
+    static constexpr quint16 kVersion = 1;
+
+private:
+    const uchar* _entry(int index) const;
+
+    static QByteArray _valueBytes(FactMetaData::ValueType_t type, const QVariant& rawValue);
+
+    QFile           _file;
+    const uchar*    _data   = nullptr;
+    qint64          _size   = 0;
+    bool            _valid  = false;
+    int             _count  = 0;
+    quint32         _hashCrc = 0;
+    const uchar*    _strings = nullptr;
+    quint32         _stringsSize = 0;
+
+    static constexpr char       kMagic[4]   = { 'Q', 'G', 'P', 'C' };
+    static constexpr qint64     kHeaderSize = 24;
+    static constexpr qint64     kEntrySize  = 16;   ///< name offset (4), name length (2), type (1), flags (1), value (8)
+    static constexpr quint8     kFlagVolatile = 0x01;
+};
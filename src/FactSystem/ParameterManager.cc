@@ -8,6 +8,7 @@
  ****************************************************************************/
 
 #include "ParameterManager.h"
+#include "ParameterCache.h"
 #include "QGCApplication.h"
 #include "FirmwarePlugin.h"
 #include "CompInfoParam.h"
@@ -25,6 +26,7 @@
 
 #include <QtCore/QEasingCurve>
 #include <QtCore/QFile>
+#include <QtCore/QMetaMethod>
 #include <QtCore/QVariantAnimation>
 #include <QtCore/QStandardPaths>
 #include <QtQml/qqml.h>
@@ -86,7 +88,7 @@ ParameterManager::ParameterManager(Vehicle* vehicle)
     , _prevWaitingWriteParamNameCount   (0)
     , _initialRequestRetryCount         (0)
     , _disableAllRetries                (false)
-    , _indexBatchQueueActive            (false)
+    , _indexRequestsActive              (false)
     , _totalParamCount                  (0)
     , _tryftp                           (vehicle->apmFirmware())
 {
@@ -103,6 +105,10 @@ ParameterManager::ParameterManager(Vehicle* vehicle)
     _waitingParamTimeoutTimer.setInterval(3000);
     connect(&_waitingParamTimeoutTimer, &QTimer::timeout, this, &ParameterManager::_waitingParamTimeout);
 
+    _indexRequestTimer.setSingleShot(true);
+    connect(&_indexRequestTimer, &QTimer::timeout, this, &ParameterManager::_indexRequestTimeout);
+    _indexRequestClock.start();
+
     // Ensure the cache directory exists
     QFileInfo(QSettings().fileName()).dir().mkdir("ParamCache");
 }
@@ -120,13 +126,10 @@ void ParameterManager::registerQmlTypes()
 
 void ParameterManager::_updateProgressBar(void)
 {
-    int waitingReadParamIndexCount = 0;
+    int waitingReadParamIndexCount = _indexRequestWindow.missingCount();
     int waitingReadParamNameCount = 0;
     int waitingWriteParamCount = 0;
 
-    for (int compId: _waitingReadParamIndexMap.keys()) {
-        waitingReadParamIndexCount += _waitingReadParamIndexMap[compId].count();
-    }
     for(int compId: _waitingReadParamNameMap.keys()) {
         waitingReadParamNameCount += _waitingReadParamNameMap[compId].count();
     }
@@ -250,7 +253,7 @@ void ParameterManager::_handleParamValue(int componentId, QString parameterName,
     _initialRequestTimeoutTimer.stop();
 
 #if 0
-    if (!_initialLoadComplete && !_indexBatchQueueActive) {
+    if (!_initialLoadComplete && !_indexRequestsActive) {
         // Handy for testing retry logic
         static int counter = 0;
         if (counter++ & 0x8) {
@@ -302,12 +305,9 @@ void ParameterManager::_handleParamValue(int componentId, QString parameterName,
     }
 
     // If we've never seen this component id before, setup the index wait lists.
-    if (!_waitingReadParamIndexMap.contains(componentId)) {
+    if (!_indexRequestWindow.hasComponent(componentId)) {
         // Add all indices to the wait list, parameter index is 0-based
-        for (int waitingIndex=0; waitingIndex<parameterCount; waitingIndex++) {
-            // This will add the new component id, as well as the the new waiting index and set the retry count for that index to 0
-            _waitingReadParamIndexMap[componentId][waitingIndex] = 0;
-        }
+        _indexRequestWindow.addComponent(componentId, parameterCount);
 
         // The read and write waiting lists for this component are initialized the empty
         _waitingReadParamNameMap[componentId] = QMap<QString, int>();
@@ -316,22 +316,21 @@ void ParameterManager::_handleParamValue(int componentId, QString parameterName,
         qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Seeing component for first time - paramcount:" << parameterCount;
     }
 
-    if (!_waitingReadParamIndexMap[componentId].contains(parameterIndex) &&
+    if (!_indexRequestWindow.isMissing(componentId, parameterIndex) &&
             !_waitingReadParamNameMap[componentId].contains(parameterName) &&
             !_waitingWriteParamNameMap[componentId].contains(parameterName)) {
         qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(componentId) << "Unrequested param update" << parameterName;
     }
 
     // Remove this parameter from the waiting lists
-    if (_waitingReadParamIndexMap[componentId].contains(parameterIndex)) {
-        _waitingReadParamIndexMap[componentId].remove(parameterIndex);
-        _indexBatchQueue.removeOne(parameterIndex);
-        _fillIndexBatchQueue(false /* waitingParamTimeout */);
+    if (_indexRequestWindow.received(componentId, parameterIndex, _indexRequestClock.elapsed()) && _indexRequestsActive) {
+        // A response frees a slot in the request window
+        _sendIndexRequests();
     }
     _waitingReadParamNameMap[componentId].remove(parameterName);
     _waitingWriteParamNameMap[componentId].remove(parameterName);
-    if (_waitingReadParamIndexMap[componentId].count()) {
-        qCDebug(ParameterManagerVerbose2Log) << _logVehiclePrefix(componentId) << "_waitingReadParamIndexMap:" << _waitingReadParamIndexMap[componentId];
+    if (_indexRequestWindow.missingCount(componentId)) {
+        qCDebug(ParameterManagerVerbose2Log) << _logVehiclePrefix(componentId) << "missing index count:" << _indexRequestWindow.missingCount(componentId);
     }
     if (_waitingReadParamNameMap[componentId].count()) {
         qCDebug(ParameterManagerVerbose2Log) << _logVehiclePrefix(componentId) << "_waitingReadParamNameMap" << _waitingReadParamNameMap[componentId];
@@ -342,13 +341,10 @@ void ParameterManager::_handleParamValue(int componentId, QString parameterName,
 
     // Track how many parameters we are still waiting for
 
-    int waitingReadParamIndexCount = 0;
+    int waitingReadParamIndexCount = _indexRequestWindow.missingCount();
     int waitingReadParamNameCount = 0;
     int waitingWriteParamNameCount = 0;
 
-    for(int waitingComponentId: _waitingReadParamIndexMap.keys()) {
-        waitingReadParamIndexCount += _waitingReadParamIndexMap[waitingComponentId].count();
-    }
     if (waitingReadParamIndexCount) {
         qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(componentId) << "waitingReadParamIndexCount:" << waitingReadParamIndexCount;
     }
@@ -552,11 +548,13 @@ void ParameterManager::refreshAllParameters(uint8_t componentId)
             // Add/Update all indices to the wait list, parameter index is 0-based
             if(componentId != MAV_COMP_ID_ALL && componentId != cid)
                 continue;
-            for (int waitingIndex = 0; waitingIndex < _paramCountMap[cid]; waitingIndex++) {
-                // This will add a new waiting index if needed and set the retry count for that index to 0
-                _waitingReadParamIndexMap[cid][waitingIndex] = 0;
-            }
+            _indexRequestWindow.addComponent(cid, _paramCountMap[cid]);
         }
+
+        // Let the list stream in before re-requesting what is missing from it
+        _indexRequestsActive = false;
+        _indexRequestTimer.stop();
+
         mavlink_message_t       msg;
 
         mavlink_msg_param_request_list_pack_chan(MAVLinkProtocol::instance()->getSystemId(),
@@ -657,57 +655,44 @@ QStringList ParameterManager::parameterNames(int componentId)
     return names;
 }
 
-/// Requests missing index based parameters from the vehicle.
-///     @param waitingParamTimeout: true: being called due to timeout, false: being called to re-fill the batch queue
-/// return true: Parameters were requested, false: No more requests needed
-bool ParameterManager::_fillIndexBatchQueue(bool waitingParamTimeout)
+/// Requests missing index based parameters from the vehicle, as many as the request window allows
+void ParameterManager::_sendIndexRequests(void)
 {
-    if (!_indexBatchQueueActive) {
-        return false;
+    if (!_indexRequestsActive) {
+        return;
     }
 
-    const int maxBatchSize = 10;
+    _indexRequestWindow.setMaxRetries(_disableAllRetries ? 0 : _maxInitialLoadRetrySingleParam);
 
-    if (waitingParamTimeout) {
-        // We timed out, clear the queue and try again
-        qCDebug(ParameterManagerLog) << "Refilling index based batch queue due to timeout";
-        _indexBatchQueue.clear();
-    } else {
-        qCDebug(ParameterManagerLog) << "Refilling index based batch queue due to received parameter";
+    const qint64 nowMs = _indexRequestClock.elapsed();
+    const QList<ParameterRequestWindow::Request> requests = _indexRequestWindow.takeRequests(nowMs);
+    for (const ParameterRequestWindow::Request& request: requests) {
+        _readParameterRaw(request.componentId, "", request.paramIndex);
+        qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(request.componentId) << "Read re-request for (paramIndex:" << request.paramIndex << ")";
+    }
+    if (!requests.isEmpty()) {
+        qCDebug(ParameterManagerLog) << _logVehiclePrefix(-1) << "Index re-requests sent:" << requests.count()
+                                     << "missing:" << _indexRequestWindow.missingCount()
+                                     << "window:" << _indexRequestWindow.window()
+                                     << "rtt:" << _indexRequestWindow.rttMs()
+                                     << "loss:" << _indexRequestWindow.lossRate();
     }
 
-    for(int componentId: _waitingReadParamIndexMap.keys()) {
-        if (_waitingReadParamIndexMap[componentId].count()) {
-            qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "_waitingReadParamIndexMap count" << _waitingReadParamIndexMap[componentId].count();
-            qCDebug(ParameterManagerVerbose1Log) << _logVehiclePrefix(componentId) << "_waitingReadParamIndexMap" << _waitingReadParamIndexMap[componentId];
-        }
-
-        for(int paramIndex: _waitingReadParamIndexMap[componentId].keys()) {
-            if (_indexBatchQueue.contains(paramIndex)) {
-                // Don't add more than once
-                continue;
-            }
-
-            if (_indexBatchQueue.count() > maxBatchSize) {
-                break;
-            }
-
-            _waitingReadParamIndexMap[componentId][paramIndex]++;   // Bump retry count
-            if (_disableAllRetries || _waitingReadParamIndexMap[componentId][paramIndex] > _maxInitialLoadRetrySingleParam) {
-                // Give up on this index
-                _failedReadParamIndexMap[componentId] << paramIndex;
-                qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Giving up on (paramIndex:" << paramIndex << "retryCount:" << _waitingReadParamIndexMap[componentId][paramIndex] << ")";
-                _waitingReadParamIndexMap[componentId].remove(paramIndex);
-            } else {
-                // Retry again
-                _indexBatchQueue.append(paramIndex);
-                _readParameterRaw(componentId, "", paramIndex);
-                qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Read re-request for (paramIndex:" << paramIndex << "retryCount:" << _waitingReadParamIndexMap[componentId][paramIndex] << ")";
-            }
-        }
+    const qint64 timeoutMs = _indexRequestWindow.nextTimeoutMs(nowMs);
+    if (timeoutMs < 0) {
+        _indexRequestTimer.stop();
+    } else {
+        _indexRequestTimer.start(static_cast<int>(timeoutMs));
     }
+}
 
-    return _indexBatchQueue.count() != 0;
+void ParameterManager::_indexRequestTimeout(void)
+{
+    _sendIndexRequests();
+
+    // Indices given up on may have completed the load
+    _updateProgressBar();
+    _checkInitialLoadComplete();
 }
 
 void ParameterManager::_waitingParamTimeout(void)
@@ -722,11 +707,12 @@ void ParameterManager::_waitingParamTimeout(void)
 
     qCDebug(ParameterManagerLog) << _logVehiclePrefix(-1) << "_waitingParamTimeout";
 
-    // Now that we have timed out for possibly the first time we can activate the index batch queue
-    _indexBatchQueueActive = true;
+    // Now that we have timed out for possibly the first time we can start re-requesting missing index based params
+    _indexRequestsActive = true;
+    _sendIndexRequests();
 
-    // First check for any missing parameters from the initial index based load
-    paramsRequested = _fillIndexBatchQueue(true /* waitingParamTimeout */);
+    // First check for any missing parameters from the initial index based load, the request window times those out itself
+    paramsRequested = _indexRequestWindow.missingCount() != 0;
 
     if (!paramsRequested && !_waitingForDefaultComponent && !_mapCompId2FactMap.contains(_vehicle->defaultComponentId())) {
         // Initial load is complete but we still don't have any default component params. Wait one more cycle to see if the
@@ -876,18 +862,26 @@ void ParameterManager::_sendParamSetToVehicle(int componentId, const QString& pa
 
 void ParameterManager::_writeLocalParamCache(int vehicleId, int componentId)
 {
-    CacheMapName2ParamTypeVal cacheMap;
+    QList<ParameterCache::Param> params;
+    params.reserve(_mapCompId2FactMap[componentId].count());
 
-    for (const QString& paramName: _mapCompId2FactMap[componentId].keys()) {
-        const Fact *fact = _mapCompId2FactMap[componentId][paramName];
-        cacheMap[paramName] = ParamTypeVal(fact->type(), fact->rawValue());
+    for (const Fact* fact: _mapCompId2FactMap[componentId]) {
+        ParameterCache::Param param;
+        param.name = fact->name();
+        param.type = fact->type();
+        param.rawValue = fact->rawValue();
+        // The crc is checked against the hash the autopilot reports, volatile per the autopilot metadata
+        param.volatileValue = _vehicle->compInfoManager()->compInfoParam(MAV_COMP_ID_AUTOPILOT1)->factMetaDataForName(param.name, param.type)->volatileValue();
+        params.append(param);
     }
 
-    QFile cacheFile(parameterCacheFile(vehicleId, componentId));
-    cacheFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (!ParameterCache::write(parameterCacheFile(vehicleId, componentId), params)) {
+        qCWarning(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Unable to write parameter cache";
+        return;
+    }
 
-    QDataStream ds(&cacheFile);
-    ds << cacheMap;
+    // Cache from before the binary format
+    (void) QFile::remove(parameterCacheDir().filePath(QString("%1_%2.v2").arg(vehicleId).arg(componentId)));
 }
 
 QDir ParameterManager::parameterCacheDir()
@@ -898,56 +892,32 @@ QDir ParameterManager::parameterCacheDir()
 
 QString ParameterManager::parameterCacheFile(int vehicleId, int componentId)
 {
-    return parameterCacheDir().filePath(QString("%1_%2.v2").arg(vehicleId).arg(componentId));
+    return parameterCacheDir().filePath(QString("%1_%2.v3").arg(vehicleId).arg(componentId));
 }
 
 void ParameterManager::_tryCacheHashLoad(int vehicleId, int componentId, QVariant hash_value)
 {
     qCInfo(ParameterManagerLog) << "Attemping load from cache";
 
-    uint32_t crc32_value = 0;
-    /* The datastructure of the cache table */
-    CacheMapName2ParamTypeVal cacheMap;
-    QFile cacheFile(parameterCacheFile(vehicleId, componentId));
-    if (!cacheFile.exists()) {
+    const QString cacheFile = parameterCacheFile(vehicleId, componentId);
+    if (!QFile::exists(cacheFile)) {
         /* no local cache, just wait for them to come in*/
         return;
     }
-    cacheFile.open(QIODevice::ReadOnly);
-
-    /* Deserialize the parameter cache table */
-    QDataStream ds(&cacheFile);
-    ds >> cacheMap;
-
-    /* compute the crc of the local cache to check against the remote */
 
-    for (const QString& name: cacheMap.keys()) {
-        const ParamTypeVal&             paramTypeVal    = cacheMap[name];
-        const FactMetaData::ValueType_t fact_type       = static_cast<FactMetaData::ValueType_t>(paramTypeVal.first);
-
-        if (_vehicle->compInfoManager()->compInfoParam(MAV_COMP_ID_AUTOPILOT1)->factMetaDataForName(name, fact_type)->volatileValue()) {
-            // Does not take part in CRC
-            qCDebug(ParameterManagerLog) << "Volatile parameter" << name;
-        } else {
-            const void *vdat = paramTypeVal.second.constData();
-            const FactMetaData::ValueType_t fact_type = static_cast<FactMetaData::ValueType_t>(paramTypeVal.first);
-            crc32_value = QGC::crc32((const uint8_t *)qPrintable(name), name.length(),  crc32_value);
-            crc32_value = QGC::crc32((const uint8_t *)vdat, FactMetaData::typeToSize(fact_type), crc32_value);
-        }
+    /* The crc is computed when the cache is written, no need to look at the parameters to check it */
+    const ParameterCache cache(cacheFile);
+    if (!cache.isValid() || (cache.count() == 0)) {
+        qCInfo(ParameterManagerLog) << "Parameters cache unusable" << qPrintable(QFileInfo(cacheFile).absoluteFilePath());
+        return;
     }
+    const uint32_t crc32_value = cache.hashCrc();
 
     /* if the two param set hashes match, just load from the disk */
     if (crc32_value == hash_value.toUInt()) {
         qCInfo(ParameterManagerLog) << "Parameters loaded from cache" << qPrintable(QFileInfo(cacheFile).absoluteFilePath());
 
-        int count = cacheMap.count();
-        int index = 0;
-        for (const QString& name: cacheMap.keys()) {
-            const ParamTypeVal& paramTypeVal = cacheMap[name];
-            const FactMetaData::ValueType_t fact_type = static_cast<FactMetaData::ValueType_t>(paramTypeVal.first);
-            const MAV_PARAM_TYPE mavParamType = factTypeToMavType(fact_type);
-            _handleParamValue(componentId, name, count, index++, mavParamType, paramTypeVal.second);
-        }
+        _loadParamsFromCache(componentId, cache);
 
         SharedLinkInterfacePtr sharedLink = _vehicle->vehicleLinkManager()->primaryLink().lock();
         if (sharedLink) {
@@ -994,8 +964,10 @@ void ParameterManager::_tryCacheHashLoad(int vehicleId, int componentId, QVarian
         qCInfo(ParameterManagerLog) << "Parameters cache match failed" << qPrintable(QFileInfo(cacheFile).absoluteFilePath());
         if (ParameterManagerDebugCacheFailureLog().isDebugEnabled()) {
             _debugCacheCRC[componentId] = true;
-            _debugCacheMap[componentId] = cacheMap;
-            for (const QString& name: cacheMap.keys()) {
+            CacheMapName2ParamTypeVal& cacheMap = _debugCacheMap[componentId];
+            for (int index = 0; index < cache.count(); index++) {
+                const QString name = cache.name(index);
+                cacheMap[name] = ParamTypeVal(cache.type(index), cache.rawValue(index));
                 _debugCacheParamSeen[componentId][name] = false;
             }
             qgcApp()->showAppMessage(tr("Parameter cache CRC match failed"));
@@ -1003,6 +975,77 @@ void ParameterManager::_tryCacheHashLoad(int vehicleId, int componentId, QVarian
     }
 }
 
+/// Creates the facts of a component from the parameter cache all at once. Unlike feeding each parameter through
+/// _handleParamValue there is no per parameter wait list, progress or timer work, and parametersReady is signalled
+/// once at the end.
+void ParameterManager::_loadParamsFromCache(int componentId, const ParameterCache& cache)
+{
+    const int count = cache.count();
+    const bool notifyFactAdded = isSignalConnected(QMetaMethod::fromSignal(&ParameterManager::factAdded));
+    CompInfoParam* const compInfoParam = _vehicle->compInfoManager()->compInfoParam(componentId);
+    QMap<QString, Fact*>& factMap = _mapCompId2FactMap[componentId];
+
+    for (int index = 0; index < count; index++) {
+        const QString name = cache.name(index);
+        Fact* fact = factMap.value(name, nullptr);
+        if (!fact) {
+            fact = new Fact(componentId, name, cache.type(index), this);
+            fact->setMetaData(compInfoParam->factMetaDataForName(name, fact->type()));
+            // The cache is sorted by name, so this appends
+            (void) factMap.insert(factMap.cend(), name, fact);
+
+            // We need to know when the fact value changes so we can update the vehicle
+            connect(fact, &Fact::_containerRawValueChanged, this, &ParameterManager::_factRawValueUpdated);
+
+            if (notifyFactAdded) {
+                emit factAdded(componentId, fact);
+            }
+        }
+        fact->_containerSetRawValue(cache.rawValue(index));
+    }
+
+    // Everything for this component is in, nothing left to wait for
+    if (!_paramCountMap.contains(componentId)) {
+        _paramCountMap[componentId] = count;
+        _totalParamCount += count;
+    }
+    _indexRequestWindow.setComplete(componentId);
+    _waitingReadParamNameMap[componentId] = QMap<QString, int>();
+    if (!_waitingWriteParamNameMap.contains(componentId)) {
+        _waitingWriteParamNameMap[componentId] = QMap<QString, int>();
+    }
+
+    _initialRequestTimeoutTimer.stop();
+    _waitingParamTimeoutTimer.stop();
+
+    const int waitingReadParamIndexCount = _indexRequestWindow.missingCount();
+    int waitingReadParamNameCount = 0;
+    int waitingWriteParamNameCount = 0;
+    for (const QMap<QString, int>& waiting: std::as_const(_waitingReadParamNameMap)) {
+        waitingReadParamNameCount += waiting.count();
+    }
+    for (const QMap<QString, int>& waiting: std::as_const(_waitingWriteParamNameMap)) {
+        waitingWriteParamNameCount += waiting.count();
+    }
+    if (waitingReadParamIndexCount + waitingReadParamNameCount + waitingWriteParamNameCount) {
+        // Other components are still loading
+        _waitingParamTimeoutTimer.start();
+    } else if (!_paramCountMap.contains(_vehicle->defaultComponentId())) {
+        // The cache was for another component, the timeout re-requests the parameters of the default component
+        qCDebug(ParameterManagerLog) << _logVehiclePrefix(-1) << "Restarting _waitingParamTimeoutTimer (still waiting for default component params)";
+        _waitingParamTimeoutTimer.start();
+    }
+    _prevWaitingReadParamIndexCount = waitingReadParamIndexCount;
+    _prevWaitingReadParamNameCount = waitingReadParamNameCount;
+    _prevWaitingWriteParamNameCount = waitingWriteParamNameCount;
+
+    _updateProgressBar();
+
+    qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Loaded" << count << "parameters from cache";
+
+    _checkInitialLoadComplete();
+}
+
 QString ParameterManager::readParametersFromStream(QTextStream& stream)
 {
     QString missingErrors;
@@ -1175,11 +1218,9 @@ void ParameterManager::_checkInitialLoadComplete(void)
         return;
     }
 
-    for (int componentId: _waitingReadParamIndexMap.keys()) {
-        if (_waitingReadParamIndexMap[componentId].count()) {
-            // We are still waiting on some parameters, not done yet
-            return;
-        }
+    if (_indexRequestWindow.missingCount()) {
+        // We are still waiting on some parameters, not done yet
+        return;
     }
 
     if (!_mapCompId2FactMap.contains(_vehicle->defaultComponentId())) {
@@ -1207,8 +1248,8 @@ void ParameterManager::_checkInitialLoadComplete(void)
     // Check for index based load failures
     QString indexList;
     bool initialLoadFailures = false;
-    for (int componentId: _failedReadParamIndexMap.keys()) {
-        for (int paramIndex: _failedReadParamIndexMap[componentId]) {
+    for (int componentId: _indexRequestWindow.componentIds()) {
+        for (int paramIndex: _indexRequestWindow.failedIndices(componentId)) {
             if (initialLoadFailures) {
                 indexList += ", ";
             }
@@ -1618,7 +1659,7 @@ Success:
     /* Create empty waiting lists as we have all parameters */
     _paramCountMap[componentId] = num_params;
     _totalParamCount += num_params;
-    _waitingReadParamIndexMap[componentId] = QMap<int, int>();
+    _indexRequestWindow.setComplete(componentId);
     _waitingReadParamNameMap[componentId] = QMap<QString, int>();
     _waitingWriteParamNameMap[componentId] = QMap<QString, int>();
     _checkInitialLoadComplete();
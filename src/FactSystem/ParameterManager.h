@@ -12,18 +12,21 @@
 #include <QtCore/QObject>
 #include <QtCore/QMap>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QTimer>
 #include <QtCore/QString>
 #include <QtCore/QLoggingCategory>
 
 #include "Fact.h"
 #include "FactMetaData.h"
+#include "ParameterRequestWindow.h"
 #include "MAVLinkLib.h"
 
 Q_DECLARE_LOGGING_CATEGORY(ParameterManagerVerbose1Log)
 Q_DECLARE_LOGGING_CATEGORY(ParameterManagerVerbose2Log)
 Q_DECLARE_LOGGING_CATEGORY(ParameterManagerDebugCacheFailureLog)
 
+class ParameterCache;
 class ParameterEditorController;
 class Vehicle;
 
@@ -112,6 +115,7 @@ private:
     void    _handleParamValue                   (int componentId, QString parameterName, int parameterCount, int parameterIndex, MAV_PARAM_TYPE mavParamType, QVariant parameterValue);
     void    _factRawValueUpdateWorker           (int componentId, const QString& name, FactMetaData::ValueType_t valueType, const QVariant& rawValue);
     void    _waitingParamTimeout                (void);
+    void    _indexRequestTimeout                (void);
     void    _tryCacheLookup                     (void);
     void    _initialRequestTimeout              (void);
     int     _actualComponentId                  (int componentId);
@@ -119,13 +123,14 @@ private:
     void    _sendParamSetToVehicle              (int componentId, const QString& paramName, FactMetaData::ValueType_t valueType, const QVariant& value);
     void    _writeLocalParamCache               (int vehicleId, int componentId);
     void    _tryCacheHashLoad                   (int vehicleId, int componentId, QVariant hash_value);
+    void    _loadParamsFromCache                (int componentId, const ParameterCache& cache);
     void    _loadMetaData                       (void);
     void    _clearMetaData                      (void);
     QString _remapParamNameToVersion            (const QString& paramName);
     void    _loadOfflineEditingParams           (void);
     QString _logVehiclePrefix                   (int componentId);
     void    _setLoadProgress                    (double loadProgress);
-    bool    _fillIndexBatchQueue                (bool waitingParamTimeout);
+    void    _sendIndexRequests                  (void);
     void    _updateProgressBar                  (void);
     void    _checkInitialLoadComplete           (void);
     void    _ftpDownloadComplete                (const QString& fileName, const QString& errorMsg);
@@ -169,14 +174,14 @@ private:
     static const int    _maxReadWriteRetry = 5;                 ///< Maximum retries read/write
     bool                _disableAllRetries;                     ///< true: Don't retry any requests (used for testing)
 
-    bool        _indexBatchQueueActive; ///< true: we are actively batching re-requests for missing index base params, false: index based re-request has not yet started
-    QList<int>  _indexBatchQueue;       ///< The current queue of index re-requests
+    bool                    _indexRequestsActive;   ///< true: missing index based params are being re-requested, false: index based re-request has not yet started
+    ParameterRequestWindow  _indexRequestWindow;    ///< Missing index based params and the requests for them in flight
+    QTimer                  _indexRequestTimer;     ///< Fires when the oldest index request in flight times out
+    QElapsedTimer           _indexRequestClock;
 
     QMap<int, int>                  _paramCountMap;             ///< Key: Component id, Value: count of parameters in this component
-    QMap<int, QMap<int, int> >      _waitingReadParamIndexMap;  ///< Key: Component id, Value: Map { Key: parameter index still waiting for, Value: retry count }
     QMap<int, QMap<QString, int> >  _waitingReadParamNameMap;   ///< Key: Component id, Value: Map { Key: parameter name still waiting for, Value: retry count }
     QMap<int, QMap<QString, int> >  _waitingWriteParamNameMap;  ///< Key: Component id, Value: Map { Key: parameter name still waiting for, Value: retry count }
-    QMap<int, QList<int> >          _failedReadParamIndexMap;   ///< Key: Component id, Value: failed parameter index
 
     int _totalParamCount;                       ///< Number of parameters across all components
     int _waitingWriteParamBatchCount = 0;       ///< Number of parameters which are batched up waiting on write responses
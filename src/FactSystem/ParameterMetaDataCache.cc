@@ -0,0 +1,382 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterMetaDataCache.h"
+#include "ComponentInformationCache.h"
+#include <QGCLoggingCategory.h>
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+QGC_LOGGING_CATEGORY(ParameterMetaDataCacheLog, "ParameterMetaDataCacheLog")
+
+QByteArray ParameterMetaDataCache::Record::toBytes(void) const
+{
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    const quint8 flags = (rebootRequired ? 0x01 : 0) | (readOnly ? 0x02 : 0) | (volatileValue ? 0x04 : 0) | (boolean ? 0x08 : 0);
+    stream << type << category << group << shortDescription << longDescription << min << max << defaultValue << units
+           << decimalPlaces << increment << flags << values << bitmask;
+
+    return bytes;
+}
+
+bool ParameterMetaDataCache::Record::fromBytes(const QByteArray& bytes, Record& record)
+{
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint8 flags = 0;
+    stream >> record.type >> record.category >> record.group >> record.shortDescription >> record.longDescription
+           >> record.min >> record.max >> record.defaultValue >> record.units >> record.decimalPlaces >> record.increment
+           >> flags >> record.values >> record.bitmask;
+    record.rebootRequired = flags & 0x01;
+    record.readOnly = flags & 0x02;
+    record.volatileValue = flags & 0x04;
+    record.boolean = flags & 0x08;
+
+    return (stream.status() == QDataStream::Ok) && stream.atEnd();
+}
+
+ParameterMetaDataCache::~ParameterMetaDataCache()
+{
+    _close();
+}
+
+void ParameterMetaDataCache::_close(void)
+{
+    if (_data) {
+        (void) _file.unmap(const_cast<uchar*>(_data));
+        _data = nullptr;
+    }
+    _file.close();
+    _size = 0;
+    _sectionCount = 0;
+    _entryCount = 0;
+    _strings = nullptr;
+    _stringsSize = 0;
+}
+
+QString ParameterMetaDataCache::fileTag(const QString& producer, const QByteArray& metaData)
+{
+    return QStringLiteral("ParameterMetaData_%1_v%2_%3").arg(producer).arg(kVersion).arg(QString::fromLatin1(QCryptographicHash::hash(metaData, QCryptographicHash::Sha1).toHex()));
+}
+
+bool ParameterMetaDataCache::load(const QString& producer, const QString& metaDataFile, const BuildFunction& build, ComponentInformationCache* fileCache)
+{
+    _close();
+    _sections.clear();
+
+    QFile file(metaDataFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(ParameterMetaDataCacheLog) << "Unable to open meta data file" << metaDataFile << file.errorString();
+        return false;
+    }
+    const QByteArray metaData = file.readAll();
+    file.close();
+
+    if (!fileCache) {
+        fileCache = &ComponentInformationCache::defaultInstance();
+    }
+
+    const QString tag = fileTag(producer, metaData);
+    const QString cachedPath = fileCache->access(tag);
+    if (!cachedPath.isEmpty()) {
+        if (open(cachedPath)) {
+            qCDebug(ParameterMetaDataCacheLog) << "Using cached meta data" << metaDataFile << cachedPath;
+            return true;
+        }
+        qCWarning(ParameterMetaDataCacheLog) << "Cached meta data unusable, parsing again" << cachedPath;
+    }
+
+    Sections sections;
+    if (!build(metaData, sections)) {
+        qCDebug(ParameterMetaDataCacheLog) << "Meta data has errors, not caching" << metaDataFile;
+        _sections = sections;
+        return true;
+    }
+
+    if (!cachedPath.isEmpty()) {
+        // The cache does not replace entries, so the unusable file is rewritten in place
+        if (write(cachedPath, sections) && open(cachedPath)) {
+            qCDebug(ParameterMetaDataCacheLog) << "Rewrote cached meta data" << metaDataFile << cachedPath;
+            return true;
+        }
+    } else {
+        // The cache moves the file in place, so it is written next to the other temporary downloads first
+        const QString tempPath = QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation)).absoluteFilePath(tag);
+        if (write(tempPath, sections)) {
+            const QString insertedPath = fileCache->insert(tag, tempPath);
+            if (!insertedPath.isEmpty() && open(insertedPath)) {
+                qCDebug(ParameterMetaDataCacheLog) << "Cached meta data" << metaDataFile << insertedPath;
+                return true;
+            }
+        }
+        (void) QFile::remove(tempPath);
+    }
+
+    qCWarning(ParameterMetaDataCacheLog) << "Unable to cache meta data" << metaDataFile;
+    _sections = sections;
+    return true;
+}
+
+bool ParameterMetaDataCache::open(const QString& path)
+{
+    _close();
+
+    _file.setFileName(path);
+    if (!_file.open(QIODevice::ReadOnly)) {
+        qCWarning(ParameterMetaDataCacheLog) << "Unable to open cache file" << path << _file.errorString();
+        return false;
+    }
+
+    _size = _file.size();
+    if (_size < kHeaderSize) {
+        qCWarning(ParameterMetaDataCacheLog) << "Cache file too small" << path;
+        _close();
+        return false;
+    }
+
+    const uchar* const data = _file.map(0, _size);
+    if (!data) {
+        qCWarning(ParameterMetaDataCacheLog) << "Unable to map cache file" << path << _file.errorString();
+        _close();
+        return false;
+    }
+    _data = data;
+
+    if (memcmp(_data, kMagic, sizeof(kMagic)) || (qFromLittleEndian<quint16>(_data + 4) != kVersion)) {
+        qCDebug(ParameterMetaDataCacheLog) << "Unknown cache format" << path;
+        _close();
+        return false;
+    }
+
+    const quint32 sectionCount = qFromLittleEndian<quint32>(_data + 8);
+    const quint32 entryCount = qFromLittleEndian<quint32>(_data + 12);
+    const quint32 stringsSize = qFromLittleEndian<quint32>(_data + 16);
+    const qint64 tablesSize = (static_cast<qint64>(sectionCount) * kSectionSize) + (static_cast<qint64>(entryCount) * kEntrySize);
+    if ((kHeaderSize + tablesSize + stringsSize) != _size) {
+        qCWarning(ParameterMetaDataCacheLog) << "Cache file size mismatch" << path;
+        _close();
+        return false;
+    }
+
+    _sectionCount = static_cast<int>(sectionCount);
+    _entryCount = static_cast<int>(entryCount);
+    _strings = _data + kHeaderSize + tablesSize;
+    _stringsSize = stringsSize;
+
+    // The file is only ever replaced atomically, so the tables are range checked but there is no content crc which
+    // would have to read the whole data area on every load. A damaged record fails to decode on its own.
+    quint64 nextEntry = 0;
+    for (int i = 0; i < _sectionCount; i++) {
+        const uchar* const section = _section(i);
+        const quint64 nameEnd = static_cast<quint64>(qFromLittleEndian<quint32>(section)) + qFromLittleEndian<quint16>(section + 4);
+        const quint32 firstEntry = qFromLittleEndian<quint32>(section + 8);
+        const quint32 sectionEntries = qFromLittleEndian<quint32>(section + 12);
+        if ((nameEnd > _stringsSize) || (firstEntry != nextEntry) || ((nextEntry + sectionEntries) > entryCount)) {
+            qCWarning(ParameterMetaDataCacheLog) << "Cache file section out of range" << path << i;
+            _close();
+            return false;
+        }
+        nextEntry += sectionEntries;
+    }
+    if (nextEntry != entryCount) {
+        qCWarning(ParameterMetaDataCacheLog) << "Cache file entries not covered by sections" << path;
+        _close();
+        return false;
+    }
+    for (int i = 0; i < _entryCount; i++) {
+        const uchar* const entry = _entry(i);
+        const quint64 nameEnd = static_cast<quint64>(qFromLittleEndian<quint32>(entry)) + qFromLittleEndian<quint16>(entry + 4);
+        const quint64 recordEnd = static_cast<quint64>(qFromLittleEndian<quint32>(entry + 8)) + qFromLittleEndian<quint32>(entry + 12);
+        if ((nameEnd > _stringsSize) || (recordEnd > _stringsSize)) {
+            qCWarning(ParameterMetaDataCacheLog) << "Cache file entry out of range" << path << i;
+            _close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const uchar* ParameterMetaDataCache::_section(int index) const
+{
+    return _data + kHeaderSize + (static_cast<qint64>(index) * kSectionSize);
+}
+
+const uchar* ParameterMetaDataCache::_entry(int index) const
+{
+    return _data + kHeaderSize + (static_cast<qint64>(_sectionCount) * kSectionSize) + (static_cast<qint64>(index) * kEntrySize);
+}
+
+QByteArray ParameterMetaDataCache::_name(const uchar* tableEntry) const
+{
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(_strings + qFromLittleEndian<quint32>(tableEntry)), qFromLittleEndian<quint16>(tableEntry + 4));
+}
+
+int ParameterMetaDataCache::_find(const uchar* table, int first, int count, const QByteArray& name) const
+{
+    // Section and entry tables have the same stride
+    static_assert(kSectionSize == kEntrySize);
+
+    int low = first;
+    int high = first + count - 1;
+    while (low <= high) {
+        const int mid = low + ((high - low) / 2);
+        const int result = _name(table + (static_cast<qint64>(mid) * kEntrySize)).compare(name);
+        if (result == 0) {
+            return mid;
+        } else if (result < 0) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    return -1;
+}
+
+QByteArray ParameterMetaDataCache::record(const QString& section, const QString& name) const
+{
+    if (!_data) {
+        const auto sectionIt = _sections.constFind(section);
+        if (sectionIt == _sections.constEnd()) {
+            return QByteArray();
+        }
+        return sectionIt->value(name);
+    }
+
+    const int sectionIndex = _find(_section(0), 0, _sectionCount, section.toUtf8());
+    if (sectionIndex < 0) {
+        return QByteArray();
+    }
+    const uchar* const sectionEntry = _section(sectionIndex);
+    const int entryIndex = _find(_entry(0), static_cast<int>(qFromLittleEndian<quint32>(sectionEntry + 8)), static_cast<int>(qFromLittleEndian<quint32>(sectionEntry + 12)), name.toUtf8());
+    if (entryIndex < 0) {
+        return QByteArray();
+    }
+
+    const uchar* const entry = _entry(entryIndex);
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(_strings + qFromLittleEndian<quint32>(entry + 8)), qFromLittleEndian<quint32>(entry + 12));
+}
+
+QStringList ParameterMetaDataCache::sections(void) const
+{
+    if (!_data) {
+        return _sections.keys();
+    }
+
+    QStringList sectionNames;
+    for (int i = 0; i < _sectionCount; i++) {
+        sectionNames.append(QString::fromUtf8(_name(_section(i))));
+    }
+    return sectionNames;
+}
+
+QStringList ParameterMetaDataCache::names(const QString& section) const
+{
+    if (!_data) {
+        return _sections.value(section).keys();
+    }
+
+    QStringList entryNames;
+    const int sectionIndex = _find(_section(0), 0, _sectionCount, section.toUtf8());
+    if (sectionIndex >= 0) {
+        const uchar* const sectionEntry = _section(sectionIndex);
+        const int first = static_cast<int>(qFromLittleEndian<quint32>(sectionEntry + 8));
+        const int count = static_cast<int>(qFromLittleEndian<quint32>(sectionEntry + 12));
+        for (int i = first; i < (first + count); i++) {
+            entryNames.append(QString::fromUtf8(_name(_entry(i))));
+        }
+    }
+    return entryNames;
+}
+
+bool ParameterMetaDataCache::write(const QString& path, const Sections& sections)
+{
+    using NamedRecord = QPair<QByteArray, QByteArray>;
+    const auto byName = [](const NamedRecord& a, const NamedRecord& b) { return a.first < b.first; };
+
+    // Lookups compare utf8 bytes, which only sort like QString for plain ascii names
+    QList<QPair<QByteArray, QList<NamedRecord>>> sortedSections;
+    for (auto sectionIt = sections.constBegin(); sectionIt != sections.constEnd(); ++sectionIt) {
+        QList<NamedRecord> records;
+        for (auto it = sectionIt->constBegin(); it != sectionIt->constEnd(); ++it) {
+            records.append(NamedRecord(it.key().toUtf8(), it.value()));
+        }
+        std::sort(records.begin(), records.end(), byName);
+        sortedSections.append(QPair<QByteArray, QList<NamedRecord>>(sectionIt.key().toUtf8(), records));
+    }
+    std::sort(sortedSections.begin(), sortedSections.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    QByteArray sectionTable;
+    QByteArray entryTable;
+    QByteArray strings;
+    quint32 entryCount = 0;
+    for (const auto& section: sortedSections) {
+        if (section.first.size() > 0xFFFF) {
+            qCWarning(ParameterMetaDataCacheLog) << "Section name too long" << section.first;
+            return false;
+        }
+
+        uchar sectionEntry[kSectionSize] = {};
+        qToLittleEndian(static_cast<quint32>(strings.size()), sectionEntry);
+        qToLittleEndian(static_cast<quint16>(section.first.size()), sectionEntry + 4);
+        qToLittleEndian(entryCount, sectionEntry + 8);
+        qToLittleEndian(static_cast<quint32>(section.second.count()), sectionEntry + 12);
+        sectionTable.append(reinterpret_cast<const char*>(sectionEntry), kSectionSize);
+        strings.append(section.first);
+
+        for (const NamedRecord& record: section.second) {
+            if (record.first.size() > 0xFFFF) {
+                qCWarning(ParameterMetaDataCacheLog) << "Parameter name too long" << record.first;
+                return false;
+            }
+
+            uchar entry[kEntrySize] = {};
+            qToLittleEndian(static_cast<quint32>(strings.size()), entry);
+            qToLittleEndian(static_cast<quint16>(record.first.size()), entry + 4);
+            strings.append(record.first);
+            qToLittleEndian(static_cast<quint32>(strings.size()), entry + 8);
+            qToLittleEndian(static_cast<quint32>(record.second.size()), entry + 12);
+            strings.append(record.second);
+            entryTable.append(reinterpret_cast<const char*>(entry), kEntrySize);
+            entryCount++;
+        }
+    }
+
+    uchar header[kHeaderSize] = {};
+    memcpy(header, kMagic, sizeof(kMagic));
+    qToLittleEndian(kVersion, header + 4);
+    qToLittleEndian(static_cast<quint32>(sortedSections.count()), header + 8);
+    qToLittleEndian(entryCount, header + 12);
+    qToLittleEndian(static_cast<quint32>(strings.size()), header + 16);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ParameterMetaDataCacheLog) << "Unable to write cache" << path << file.errorString();
+        return false;
+    }
+    (void) file.write(reinterpret_cast<const char*>(header), kHeaderSize);
+    (void) file.write(sectionTable);
+    (void) file.write(entryTable);
+    (void) file.write(strings);
+
+    return file.commit();
+}
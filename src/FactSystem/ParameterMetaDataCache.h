@@ -0,0 +1,120 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMap>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include <functional>
+
+class ComponentInformationCache;
+
+Q_DECLARE_LOGGING_CATEGORY(ParameterMetaDataCacheLog)
+
+/// Pre-parsed parameter meta data of a single meta data file, read through a memory mapping.
+/// A meta data file is parsed once per content: the parser hands over an opaque record per parameter, grouped in
+/// sections, which are written to a binary file kept in the ComponentInformationCache under a tag made from the
+/// hash of the meta data file. Later loads of the same file map the binary file and only decode the records of the
+/// parameters the vehicle actually has.
+/// The file holds a fixed size header, a section table sorted by name, one fixed size entry per record sorted by
+/// section and name, and a data area with the names and records. All values are little-endian.
+class ParameterMetaDataCache
+{
+public:
+    /// Records by parameter name
+    using Section = QMap<QString, QByteArray>;
+    /// Sections by name
+    using Sections = QMap<QString, Section>;
+    /// Parses the content of the meta data file
+    ///     @return false: the meta data has errors, the records are used but not cached
+    using BuildFunction = std::function<bool(const QByteArray& metaData, Sections& sections)>;
+
+    /// Parameter meta data as found in the firmware meta data files, fields which are not present are empty
+    struct Record {
+        QString type;
+        QString category;
+        QString group;
+        QString shortDescription;
+        QString longDescription;
+        QString min;
+        QString max;
+        QString defaultValue;
+        QString units;
+        QString decimalPlaces;
+        QString increment;
+        bool    rebootRequired  = false;
+        bool    readOnly        = false;
+        bool    volatileValue   = false;
+        bool    boolean         = false;
+        QList<QPair<QString, QString>> values;  ///< code, description
+        QList<QPair<QString, QString>> bitmask; ///< bit index, description
+
+        QByteArray toBytes(void) const;
+        static bool fromBytes(const QByteArray& bytes, Record& record);
+    };
+
+    ParameterMetaDataCache() = default;
+    ~ParameterMetaDataCache();
+
+    /// Maps the cache built from the current content of the meta data file, building and caching it if there is none
+    ///     @param producer Name of the meta data format, part of the cache tag
+    ///     @param fileCache Cache to keep the binary file in, nullptr for ComponentInformationCache::defaultInstance()
+    ///     @return false: the meta data file could not be read
+    bool load(const QString& producer, const QString& metaDataFile, const BuildFunction& build, ComponentInformationCache* fileCache = nullptr);
+
+    /// Maps a cache file written by write()
+    bool open(const QString& path);
+
+    /// @return true: the records are read through the memory mapping
+    bool isMapped(void) const { return _data != nullptr; }
+
+    /// @return Record of the parameter, null if there is none. Mapped records are not copied, so they are only valid
+    ///         for the lifetime of the cache.
+    QByteArray record(const QString& section, const QString& name) const;
+
+    QStringList sections(void) const;
+    QStringList names(const QString& section) const;
+
+    /// Writes the cache atomically
+    static bool write(const QString& path, const Sections& sections);
+
+    /// Cache tag for the content of a meta data file
+    static QString fileTag(const QString& producer, const QByteArray& metaData);
+
+    static constexpr quint16 kVersion = 1;
+
+private:
+    void _close(void);
+    const uchar* _section(int index) const;
+    const uchar* _entry(int index) const;
+    QByteArray _name(const uchar* tableEntry) const;
+    /// Binary search of a name in a section or entry table, both have the name in the first 6 bytes
+    int _find(const uchar* table, int first, int count, const QByteArray& name) const;
+
+    QFile           _file;
+    const uchar*    _data           = nullptr;
+    qint64          _size           = 0;
+    int             _sectionCount   = 0;
+    int             _entryCount     = 0;
+    const uchar*    _strings        = nullptr;
+    quint32         _stringsSize    = 0;
+    Sections        _sections;      ///< Used instead of the mapping when the cache could not be written
+
+    static constexpr char       kMagic[4]           = { 'Q', 'G', 'P', 'M' };
+    static constexpr qint64     kHeaderSize         = 20;   ///< magic (4), version (2), reserved (2), section count (4), entry count (4), data size (4)
+    static constexpr qint64     kSectionSize        = 16;   ///< name offset (4), name length (2), reserved (2), first entry (4), entry count (4)
+    static constexpr qint64     kEntrySize          = 16;   ///< name offset (4), name length (2), reserved (2), record offset (4), record length (4)
+};
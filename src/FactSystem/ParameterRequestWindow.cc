@@ -0,0 +1,255 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterRequestWindow.h"
+
+ParameterRequestWindow::ParameterRequestWindow()
+{
+
+}
+
+void ParameterRequestWindow::reset(void)
+{
+    _components.clear();
+    _sent.clear();
+    _missingCount = 0;
+    _inFlight = 0;
+    _window = kInitialWindow;
+    _slowStart = true;
+    _srtt = 0.;
+    _rttVar = 0.;
+    _baseRtt = 0.;
+    _rto = kInitialRtoMs;
+    _lastBackoffMs = -1;
+    _lossRate = 0.;
+}
+
+void ParameterRequestWindow::addComponent(int componentId, int paramCount)
+{
+    const auto it = _components.constFind(componentId);
+    if (it != _components.constEnd()) {
+        // Entries of the old component left in _sent are no longer in flight, so they are dropped as stale
+        _missingCount -= it->missingCount;
+        _inFlight -= it->inFlightCount;
+    }
+
+    paramCount = qMax(paramCount, 0);
+
+    Component component;
+    component.paramCount = paramCount;
+    component.missing = QBitArray(paramCount, true);
+    component.inFlight = QBitArray(paramCount, false);
+    component.sentMs = QVector<qint64>(paramCount, 0);
+    component.sendCount = QVector<quint8>(paramCount, 0);
+    component.missingCount = paramCount;
+    _components[componentId] = component;
+
+    _missingCount += paramCount;
+}
+
+void ParameterRequestWindow::setComplete(int componentId)
+{
+    const auto it = _components.find(componentId);
+    if (it == _components.end()) {
+        _components[componentId] = Component();
+        return;
+    }
+
+    Component& component = it.value();
+    _missingCount -= component.missingCount;
+    _inFlight -= component.inFlightCount;
+    (void) component.missing.fill(false);
+    (void) component.inFlight.fill(false);
+    component.missingCount = 0;
+    component.inFlightCount = 0;
+    component.failed.clear();
+}
+
+bool ParameterRequestWindow::isMissing(int componentId, int paramIndex) const
+{
+    const auto it = _components.constFind(componentId);
+    if ((it == _components.constEnd()) || (paramIndex < 0) || (paramIndex >= it->paramCount)) {
+        return false;
+    }
+
+    return it->missing.testBit(paramIndex);
+}
+
+int ParameterRequestWindow::missingCount(int componentId) const
+{
+    const auto it = _components.constFind(componentId);
+    return (it == _components.constEnd()) ? 0 : it->missingCount;
+}
+
+QList<int> ParameterRequestWindow::failedIndices(int componentId) const
+{
+    const auto it = _components.constFind(componentId);
+    return (it == _components.constEnd()) ? QList<int>() : it->failed;
+}
+
+bool ParameterRequestWindow::received(int componentId, int paramIndex, qint64 nowMs)
+{
+    const auto it = _components.find(componentId);
+    if ((it == _components.end()) || (paramIndex < 0) || (paramIndex >= it->paramCount)) {
+        return false;
+    }
+
+    Component& component = it.value();
+    if (!component.missing.testBit(paramIndex)) {
+        return false;
+    }
+
+    if (component.inFlight.testBit(paramIndex)) {
+        // Karn: the response to a retransmitted request may belong to any of the requests
+        if (component.sendCount[paramIndex] == 1) {
+            _rttSample(static_cast<double>(nowMs - component.sentMs[paramIndex]));
+        }
+        const bool windowFull = _inFlight >= window();
+        _clearInFlight(component, paramIndex);
+        _lossSample(false);
+
+        const double queued = (_srtt > 0.) ? (_window * (1. - (_baseRtt / _srtt))) : 0.;
+        if (queued < kQueueLow) {
+            // With a window which is not used the round trip time says nothing about the capacity of the link
+            if (windowFull && (_lossRate < kHighLoss)) {
+                // Per response, so doubling or adding one per round trip
+                _window += _slowStart ? 1. : (1. / _window);
+            }
+        } else {
+            _slowStart = false;
+            if (queued > kQueueHigh) {
+                _window -= 1. / _window;
+            }
+        }
+        _window = qBound(kMinWindow, _window, static_cast<double>(kMaxWindow));
+    }
+
+    component.missing.clearBit(paramIndex);
+    component.missingCount--;
+    _missingCount--;
+
+    return true;
+}
+
+QList<ParameterRequestWindow::Request> ParameterRequestWindow::takeRequests(qint64 nowMs)
+{
+    _expire(nowMs);
+
+    QList<Request> requests;
+    for (auto it = _components.begin(); (it != _components.end()) && (_inFlight < window()); ++it) {
+        Component& component = it.value();
+
+        // Each pass of the cursor over the component visits every candidate once
+        int candidates = component.missingCount - component.inFlightCount;
+        while ((candidates > 0) && (_inFlight < window())) {
+            const int paramIndex = component.cursor;
+            component.cursor = (component.cursor + 1) % component.paramCount;
+            if (!component.missing.testBit(paramIndex) || component.inFlight.testBit(paramIndex)) {
+                continue;
+            }
+            candidates--;
+
+            if (component.sendCount[paramIndex] >= _maxRetries) {
+                component.missing.clearBit(paramIndex);
+                component.missingCount--;
+                _missingCount--;
+                component.failed.append(paramIndex);
+                continue;
+            }
+
+            component.inFlight.setBit(paramIndex);
+            component.inFlightCount++;
+            _inFlight++;
+            component.sendCount[paramIndex]++;
+            component.sentMs[paramIndex] = nowMs;
+            _sent.enqueue(Sent{ it.key(), paramIndex, nowMs });
+            requests.append(Request{ it.key(), paramIndex });
+        }
+    }
+
+    return requests;
+}
+
+qint64 ParameterRequestWindow::nextTimeoutMs(qint64 nowMs)
+{
+    while (!_sent.isEmpty() && !_isCurrent(_sent.head())) {
+        (void) _sent.dequeue();
+    }
+    if (_sent.isEmpty()) {
+        return -1;
+    }
+
+    return qMax<qint64>(_sent.head().sentMs + _rto - nowMs, 0);
+}
+
+void ParameterRequestWindow::_clearInFlight(Component& component, int paramIndex)
+{
+    component.inFlight.clearBit(paramIndex);
+    component.inFlightCount--;
+    _inFlight--;
+}
+
+bool ParameterRequestWindow::_isCurrent(const Sent& sent) const
+{
+    const auto it = _components.constFind(sent.componentId);
+    if ((it == _components.constEnd()) || (sent.paramIndex >= it->paramCount)) {
+        return false;
+    }
+
+    return it->inFlight.testBit(sent.paramIndex) && (it->sentMs[sent.paramIndex] == sent.sentMs);
+}
+
+void ParameterRequestWindow::_expire(qint64 nowMs)
+{
+    // The timeout backs off below, requests sent together still time out together
+    const qint64 rto = _rto;
+
+    while (!_sent.isEmpty()) {
+        const Sent sent = _sent.head();
+        if (_isCurrent(sent)) {
+            if ((nowMs - sent.sentMs) < rto) {
+                // Sent in order, so the rest has not timed out either
+                break;
+            }
+
+            _clearInFlight(_components[sent.componentId], sent.paramIndex);
+            _lossSample(true);
+
+            // Drops within the same round trip are most likely the same burst of interference. Occasional drops are
+            // just retried, backing off for them would mostly stretch out the tail of the download.
+            if ((_lossRate >= kHighLoss) && ((_lastBackoffMs < 0) || ((nowMs - _lastBackoffMs) >= qMax(static_cast<qint64>(_srtt), kMinRtoMs)))) {
+                _slowStart = false;
+                _window = qMax(kMinWindow, _window * kWindowDecrease);
+                _rto = qMin(_rto * 2, kMaxRtoMs);
+                _lastBackoffMs = nowMs;
+            }
+        }
+        (void) _sent.dequeue();
+    }
+}
+
+void ParameterRequestWindow::_rttSample(double rttMs)
+{
+    rttMs = qMax(rttMs, 1.);
+    if (_srtt <= 0.) {
+        _srtt = rttMs;
+        _rttVar = rttMs / 2.;
+    } else {
+        _rttVar += kRttVarBeta * (qAbs(_srtt - rttMs) - _rttVar);
+        _srtt += kRttAlpha * (rttMs - _srtt);
+    }
+    _baseRtt = (_baseRtt <= 0.) ? _srtt : qMin(_baseRtt, _srtt);
+
+    _rto = qBound(kMinRtoMs, static_cast<qint64>(_srtt + (4. * _rttVar)), kMaxRtoMs);
+}
+
+void ParameterRequestWindow::_lossSample(bool lost)
+{
+    _lossRate += kLossAlpha * ((lost ? 1. : 0.) - _lossRate);
+}
@@ -0,0 +1,133 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QBitArray>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QQueue>
+#include <QtCore/QVector>
+#include <QtCore/QtGlobal>
+
+/// Schedules the PARAM_REQUEST_READ requests for the parameter indices missing after the initial PARAM_REQUEST_LIST.
+/// Missing and in flight indices are kept in one bitset per component. The number of requests in flight is a window
+/// sized from the round trip time as in TCP Vegas: the responses queued on the link are estimated from how far the
+/// smoothed round trip time is above the lowest one seen. The window doubles every round trip until a queue shows
+/// up, then grows by one per round trip while fewer than kQueueLow responses are queued and shrinks by one while
+/// more than kQueueHigh are. Telemetry radios drop packets without being congested, so a request which is not
+/// answered within the retransmission timeout is only retried; the window halves for drops only while the smoothed
+/// loss rate is above kHighLoss. The timeout is computed from the smoothed round trip time and its variation as in
+/// TCP (RFC 6298), retransmitted requests give no round trip samples. Under high loss it backs off along with the
+/// window, at most once per round trip.
+/// All times are in milliseconds on a monotonic clock supplied by the caller.
+class ParameterRequestWindow
+{
+public:
+    struct Request {
+        int componentId;
+        int paramIndex;
+    };
+
+    ParameterRequestWindow();
+
+    /// Forgets all components and the round trip and loss history
+    void reset(void);
+
+    /// Maximum number of requests for a single index before it is given up on, 0 gives up without requesting
+    void setMaxRetries(int maxRetries) { _maxRetries = maxRetries; }
+
+    /// Marks all indices of the component as missing, replacing what is known about the component
+    void addComponent(int componentId, int paramCount);
+    bool hasComponent(int componentId) const { return _components.contains(componentId); }
+
+    /// All parameters of the component were received by other means (cache, ftp)
+    void setComplete(int componentId);
+
+    /// @return true: the index was missing
+    bool received(int componentId, int paramIndex, qint64 nowMs);
+
+    bool isMissing(int componentId, int paramIndex) const;
+    int missingCount(void) const { return _missingCount; }
+    int missingCount(int componentId) const;
+
+    QList<int> componentIds(void) const { return _components.keys(); }
+
+    /// @return Indices given up on after the maximum number of retries
+    QList<int> failedIndices(int componentId) const;
+
+    /// Times out the requests in flight for longer than the retransmission timeout and fills the window back up
+    /// @return The requests to send now
+    QList<Request> takeRequests(qint64 nowMs);
+
+    /// @return Time until the oldest request in flight times out, -1 if there are none
+    qint64 nextTimeoutMs(qint64 nowMs);
+
+    int window(void) const { return static_cast<int>(_window); }
+    int inFlight(void) const { return _inFlight; }
+    double rttMs(void) const { return _srtt; }
+    qint64 rtoMs(void) const { return _rto; }
+    double lossRate(void) const { return _lossRate; }
+
+    static constexpr int kInitialWindow = 8;
+    static constexpr int kMaxWindow = 64;
+
+private:
+    struct Component {
+        int             paramCount = 0;
+        QBitArray       missing;
+        QBitArray       inFlight;
+        QVector<qint64> sentMs;
+        QVector<quint8> sendCount;
+        int             missingCount = 0;
+        int             inFlightCount = 0;
+        int             cursor = 0;         ///< Where the search for the next index to request continues
+        QList<int>      failed;
+    };
+
+    struct Sent {
+        int     componentId;
+        int     paramIndex;
+        qint64  sentMs;
+    };
+
+    void _clearInFlight(Component& component, int paramIndex);
+    void _expire(qint64 nowMs);
+    bool _isCurrent(const Sent& sent) const;
+    void _rttSample(double rttMs);
+    void _lossSample(bool lost);
+
+    QMap<int, Component>    _components;
+    QQueue<Sent>            _sent;          ///< In send order, stale entries are dropped when they reach the head
+    int                     _missingCount = 0;
+    int                     _inFlight = 0;
+    int                     _maxRetries = kDefaultMaxRetries;
+
+    double  _window = kInitialWindow;
+    bool    _slowStart = true;
+    double  _srtt = 0.;
+    double  _rttVar = 0.;
+    double  _baseRtt = 0.;                      ///< Lowest smoothed round trip time, the one without queueing
+    qint64  _rto = kInitialRtoMs;
+    qint64  _lastBackoffMs = -1;
+    double  _lossRate = 0.;
+
+    static constexpr int    kDefaultMaxRetries = 5;
+    static constexpr double kMinWindow = 1.;
+    static constexpr double kWindowDecrease = 0.5;
+    static constexpr double kQueueLow = 2.;
+    static constexpr double kQueueHigh = 4.;
+    static constexpr double kHighLoss = 0.5;            ///< Smoothed loss rate above which drops shrink the window
+    static constexpr double kLossAlpha = 1. / 16.;
+    static constexpr double kRttAlpha = 1. / 8.;
+    static constexpr double kRttVarBeta = 1. / 4.;
+    static constexpr qint64 kInitialRtoMs = 1000;
+    static constexpr qint64 kMinRtoMs = 200;
+    static constexpr qint64 kMaxRtoMs = 3000;
+};
@@ -140,27 +140,40 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
     }
     _parameterMetaDataLoaded = true;
 
-    QString currentCategory;
-
     qCDebug(APMParameterMetaDataLog) << "Loading parameter meta data:" << metaDataFile;
 
-    QFile xmlFile(metaDataFile);
-    Q_ASSERT(xmlFile.exists());
+    // The xml is only parsed when the file content changed, FactMetaData is created from the cached records on use
+    const bool loaded = _metaDataCache.load(kCacheProducer, metaDataFile,
+                                            [this](const QByteArray& metaData, ParameterMetaDataCache::Sections& sections) {
+                                                // Records are completed over several elements and group fixups, so they are serialized once parsing stops
+                                                QMap<QString, ParameterNameToRecordMap> vehicleTypeToParametersMap;
+                                                const bool parsed = _parseParameterMetaData(metaData, vehicleTypeToParametersMap);
+                                                for (auto typeIt = vehicleTypeToParametersMap.constBegin(); typeIt != vehicleTypeToParametersMap.constEnd(); ++typeIt) {
+                                                    ParameterMetaDataCache::Section& section = sections[typeIt.key()];
+                                                    for (auto it = typeIt->constBegin(); it != typeIt->constEnd(); ++it) {
+                                                        section[it.key()] = it.value().toBytes();
+                                                    }
+                                                }
+                                                return parsed;
+                                            });
+    if (!loaded) {
+        qCWarning(APMParameterMetaDataLog) << "Unable to load parameter meta data:" << metaDataFile;
+    }
+}
 
-    bool success = xmlFile.open(QIODevice::ReadOnly);
-    Q_UNUSED(success);
-    Q_ASSERT(success);
+bool APMParameterMetaData::_parseParameterMetaData(const QByteArray& metaData, QMap<QString, ParameterNameToRecordMap>& vehicleTypeToParametersMap)
+{
+    QString currentCategory;
 
-    QXmlStreamReader xml(xmlFile.readAll());
-    xmlFile.close();
+    QXmlStreamReader xml(metaData);
     if (xml.hasError()) {
         qCWarning(APMParameterMetaDataLog) << "Badly formed XML, reading failed: " << xml.errorString();
-        return;
+        return false;
     }
 
-    bool                badMetaData = true;
-    QStack<int>         xmlState;
-    APMFactMetaDataRaw* rawMetaData = nullptr;
+    bool                            badMetaData = true;
+    QStack<int>                     xmlState;
+    ParameterMetaDataCache::Record* rawMetaData = nullptr;
 
     xmlState.push(XmlStateNone);
 
@@ -181,13 +194,13 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
             } else if (elementName == "vehicles") {
                 if (xmlState.top() != XmlstateParamFileFound) {
                     qCWarning(APMParameterMetaDataLog) << "Badly formed XML, vehicles matched";
-                    return;
+                    return false;
                 }
                 xmlState.push(XmlStateFoundVehicles);
             } else if (elementName == "libraries") {
                 if (xmlState.top() != XmlstateParamFileFound) {
                     qCWarning(APMParameterMetaDataLog) << "Badly formed XML, libraries matched";
-                    return;
+                    return false;
                 }
                 currentCategory = "libraries";
                 xmlState.push(XmlStateFoundLibraries);
@@ -195,7 +208,7 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                 if (xmlState.top() != XmlStateFoundVehicles && xmlState.top() != XmlStateFoundLibraries) {
                     qCWarning(APMParameterMetaDataLog) << "Badly formed XML, parameters matched"
                                                        << "but we don't have proper vehicle or libraries yet";
-                    return;
+                    return false;
                 }
 
                 if (xml.attributes().hasAttribute("name")) {
@@ -213,7 +226,7 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                         qCDebug(APMParameterMetaDataVerboseLog) << "not interested in this block of parameters, skipping:" << nameValue;
                         if (skipXMLBlock(xml, "parameters")) {
                             qCWarning(APMParameterMetaDataLog) << "something wrong with the xml, skip of the xml failed";
-                            return;
+                            return false;
                         }
                         xml.readNext();
                         continue;
@@ -223,13 +236,13 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                 if (xmlState.top() != XmlStateFoundParameters) {
                     qCWarning(APMParameterMetaDataLog) << "Badly formed XML, element param matched"
                                                        << "while we are not yet in parameters";
-                    return;
+                    return false;
                 }
                 xmlState.push(XmlStateFoundParameter);
 
                 if (!xml.attributes().hasAttribute("name")) {
                     qCWarning(APMParameterMetaDataLog) << "Badly formed XML, parameter attribute name missing";
-                    return;
+                    return false;
                 }
 
                 QString name = xml.attributes().value("name").toString();
@@ -250,16 +263,13 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                           << "group: " << group;
 
                 Q_ASSERT(!rawMetaData);
-                if (_vehicleTypeToParametersMap[currentCategory].contains(name)) {
+                if (vehicleTypeToParametersMap[currentCategory].contains(name)) {
                     qCDebug(APMParameterMetaDataLog) << "Duplicate parameter found:" << name;
-                    rawMetaData = _vehicleTypeToParametersMap[currentCategory][name];
                 } else {
-                    rawMetaData = new APMFactMetaDataRaw(this);
-                    _vehicleTypeToParametersMap[currentCategory][name] = rawMetaData;
                     groupMembers[group] << name;
                 }
+                rawMetaData = &vehicleTypeToParametersMap[currentCategory][name];
                 qCDebug(APMParameterMetaDataVerboseLog) << "inserting metadata for field" << name;
-                rawMetaData->name = name;
                 if (!category.isEmpty()) {
                     rawMetaData->category = category;
                 }
@@ -270,12 +280,12 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                 // We should be getting meta data now
                 if (xmlState.top() != XmlStateFoundParameter) {
                     qCWarning(APMParameterMetaDataLog) << "Badly formed XML, while reading parameter fields wrong state";
-                    return;
+                    return false;
                 }
                 if (!badMetaData) {
-                    if (!parseParameterAttributes(xml, rawMetaData)) {
+                    if (!parseParameterAttributes(xml, *rawMetaData)) {
                         qCDebug(APMParameterMetaDataLog) << "Badly formed XML, failed to read parameter attributes";
-                        return;
+                        return false;
                     }
                     continue;
                 }
@@ -292,7 +302,7 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                 xmlState.pop();
             } else if (elementName == "parameters") {
                 qCDebug(APMParameterMetaDataVerboseLog) << "end of parameters for category: " << currentCategory;
-                correctGroupMemberships(_vehicleTypeToParametersMap[currentCategory], groupMembers);
+                correctGroupMemberships(vehicleTypeToParametersMap[currentCategory], groupMembers);
                 groupMembers.clear();
                 xmlState.pop();
             } else if (elementName == "vehicles") {
@@ -302,15 +312,17 @@ void APMParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
         }
         xml.readNext();
     }
+
+    return !xml.hasError();
 }
 
-void APMParameterMetaData::correctGroupMemberships(ParameterNametoFactMetaDataMap& parameterToFactMetaDataMap,
+void APMParameterMetaData::correctGroupMemberships(ParameterNameToRecordMap& parameterToRecordMap,
                                                    QMap<QString,QStringList>& groupMembers)
 {
     foreach(const QString& groupName, groupMembers.keys()) {
             if (groupMembers[groupName].count() == 1) {
                 foreach(const QString& parameter, groupMembers.value(groupName)) {
-                    parameterToFactMetaDataMap[parameter]->group = FactMetaData::defaultGroup();
+                    parameterToRecordMap[parameter].group = FactMetaData::defaultGroup();
                 }
             }
         }
@@ -326,7 +338,7 @@ bool APMParameterMetaData::skipXMLBlock(QXmlStreamReader& xml, const QString& bl
     return !xml.isEndDocument();
 }
 
-bool APMParameterMetaData::parseParameterAttributes(QXmlStreamReader& xml, APMFactMetaDataRaw* rawMetaData)
+bool APMParameterMetaData::parseParameterAttributes(QXmlStreamReader& xml, ParameterMetaDataCache::Record& rawMetaData)
 {
     QString elementName = xml.name().toString();
     QList<QPair<QString,QString> > values;
@@ -354,33 +366,33 @@ bool APMParameterMetaData::parseParameterAttributes(QXmlStreamReader& xml, APMFa
 
                 // everything should be good. lets collect min and max
                 if (rangeList.count() == 2) {
-                    rawMetaData->min = rangeList.first().trimmed();
-                    rawMetaData->max = rangeList.last().trimmed();
+                    rawMetaData.min = rangeList.first().trimmed();
+                    rawMetaData.max = rangeList.last().trimmed();
 
                     // sanitize min and max off any comments that they may have
-                    if (rawMetaData->min.contains(' ')) {
-                        rawMetaData->min = rawMetaData->min.split(' ').first();
+                    if (rawMetaData.min.contains(' ')) {
+                        rawMetaData.min = rawMetaData.min.split(' ').first();
                     }
-                    if(rawMetaData->max.contains(' ')) {
-                        rawMetaData->max = rawMetaData->max.split(' ').first();
+                    if(rawMetaData.max.contains(' ')) {
+                        rawMetaData.max = rawMetaData.max.split(' ').first();
                     }
-                    qCDebug(APMParameterMetaDataVerboseLog) << "read field parameter " << "min: " << rawMetaData->min
-                                                     << "max: " << rawMetaData->max;
+                    qCDebug(APMParameterMetaDataVerboseLog) << "read field parameter " << "min: " << rawMetaData.min
+                                                     << "max: " << rawMetaData.max;
                 }
             } else if (attributeName == "Increment") {
                 QString increment = xml.readElementText();
                 qCDebug(APMParameterMetaDataVerboseLog) << "read Increment: " << increment;
-                rawMetaData->incrementSize = increment;
+                rawMetaData.increment = increment;
             } else if (attributeName == "Units") {
                 QString units = xml.readElementText();
                 qCDebug(APMParameterMetaDataVerboseLog) << "read Units: " << units;
-                rawMetaData->units = units;
+                rawMetaData.units = units;
             } else if (attributeName == "ReadOnly") {
                 QString strValue = xml.readElementText().trimmed();
                 if (strValue.compare("true", Qt::CaseInsensitive) == 0) {
-                    rawMetaData->readOnly = true;
+                    rawMetaData.readOnly = true;
                 }
-                qCDebug(APMParameterMetaDataVerboseLog) << "read ReadOnly: " << rawMetaData->readOnly;
+                qCDebug(APMParameterMetaDataVerboseLog) << "read ReadOnly: " << rawMetaData.readOnly;
             } else if (attributeName == "Bitmask") {
                 bool    parseError = false;
 
@@ -391,7 +403,7 @@ bool APMParameterMetaData::parseParameterAttributes(QXmlStreamReader& xml, APMFa
                     foreach (const QString& bitmask, bitmaskList) {
                         QStringList pair = bitmask.split(":");
                         if (pair.count() == 2) {
-                            rawMetaData->bitmask << QPair<QString, QString>(pair[0], pair[1]);
+                            rawMetaData.bitmask << QPair<QString, QString>(pair[0], pair[1]);
                         } else {
                             qCDebug(APMParameterMetaDataLog) << "parse error: bitmask:" << bitmaskString << "pair count:" << pair.count();
                             parseError = true;
@@ -401,12 +413,12 @@ bool APMParameterMetaData::parseParameterAttributes(QXmlStreamReader& xml, APMFa
                 }
 
                 if (parseError) {
-                    rawMetaData->bitmask.clear();
+                    rawMetaData.bitmask.clear();
                 }
             } else if (attributeName == "RebootRequired") {
                 QString strValue = xml.readElementText().trimmed();
                 if (strValue.compare("true", Qt::CaseInsensitive) == 0) {
-                    rawMetaData->rebootRequired = true;
+                    rawMetaData.rebootRequired = true;
                 }
             }
         } else if (elementName == "values") {
@@ -417,7 +429,7 @@ bool APMParameterMetaData::parseParameterAttributes(QXmlStreamReader& xml, APMFa
             qCDebug(APMParameterMetaDataVerboseLog) << "read value parameter " << "value desc: "
                                              << valueName << "code: " << valueValue;
             values << QPair<QString,QString>(valueValue, valueName);
-            rawMetaData->values = values;
+            rawMetaData.values = values;
         } else {
             qCWarning(APMParameterMetaDataLog) << "Unknown parameter element in XML: " << elementName;
         }
@@ -431,16 +443,15 @@ FactMetaData* APMParameterMetaData::getMetaDataForFact(const QString& name, MAV_
 {
     bool                keepTrying      = true;
     QString             mavTypeString   = mavTypeToString(vehicleType);
-    APMFactMetaDataRaw* rawMetaData     = nullptr;
+    QByteArray          recordBytes;
 
     // check if we have metadata for fact, use generic otherwise
     while (keepTrying) {
-        if (_vehicleTypeToParametersMap[mavTypeString].contains(name)) {
-            rawMetaData = _vehicleTypeToParametersMap[mavTypeString][name];
-        } else if (_vehicleTypeToParametersMap["libraries"].contains(name)) {
-            rawMetaData = _vehicleTypeToParametersMap["libraries"][name];
+        recordBytes = _metaDataCache.record(mavTypeString, name);
+        if (recordBytes.isNull()) {
+            recordBytes = _metaDataCache.record(QStringLiteral("libraries"), name);
         }
-        if (!rawMetaData && mavTypeString == "Rover") {
+        if (recordBytes.isNull() && mavTypeString == "Rover") {
             // Hack city: Older versions of Rover have different name
             mavTypeString = "APMrover2";
         } else {
@@ -450,66 +461,72 @@ FactMetaData* APMParameterMetaData::getMetaDataForFact(const QString& name, MAV_
 
     FactMetaData *metaData = new FactMetaData(type, this);
 
+    ParameterMetaDataCache::Record rawMetaData;
+    if (!recordBytes.isNull() && !ParameterMetaDataCache::Record::fromBytes(recordBytes, rawMetaData)) {
+        qCWarning(APMParameterMetaDataLog) << "Unable to decode cached metaData for" << name;
+        recordBytes.clear();
+    }
+
     // we don't have data for this fact
-    if (!rawMetaData) {
+    if (recordBytes.isNull()) {
         metaData->setCategory(QStringLiteral("Advanced"));
         metaData->setGroup(_groupFromParameterName(name));
         qCDebug(APMParameterMetaDataLog) << "No metaData for " << name << "using generic metadata";
         return metaData;
     }
 
-    metaData->setName(rawMetaData->name);
-    if (!rawMetaData->category.isEmpty()) {
-        metaData->setCategory(rawMetaData->category);
+    metaData->setName(name);
+    if (!rawMetaData.category.isEmpty()) {
+        metaData->setCategory(rawMetaData.category);
     }
-    metaData->setGroup(rawMetaData->group);
-    metaData->setVehicleRebootRequired(rawMetaData->rebootRequired);
-    metaData->setReadOnly(rawMetaData->readOnly);
+    metaData->setGroup(rawMetaData.group);
+    metaData->setVehicleRebootRequired(rawMetaData.rebootRequired);
+    metaData->setReadOnly(rawMetaData.readOnly);
 
-    if (!rawMetaData->shortDescription.isEmpty()) {
-        metaData->setShortDescription(rawMetaData->shortDescription);
+    if (!rawMetaData.shortDescription.isEmpty()) {
+        metaData->setShortDescription(rawMetaData.shortDescription);
     }
 
-    if (!rawMetaData->longDescription.isEmpty()) {
-        metaData->setLongDescription(rawMetaData->longDescription);
+    if (!rawMetaData.longDescription.isEmpty()) {
+        metaData->setLongDescription(rawMetaData.longDescription);
     }
 
-    if (!rawMetaData->units.isEmpty()) {
-        metaData->setRawUnits(rawMetaData->units);
+    if (!rawMetaData.units.isEmpty()) {
+        metaData->setRawUnits(rawMetaData.units);
     }
 
-    if (!rawMetaData->min.isEmpty()) {
+    if (!rawMetaData.min.isEmpty()) {
         QVariant varMin;
         QString errorString;
-        if (metaData->convertAndValidateRaw(rawMetaData->min, false /* validate as well */, varMin, errorString)) {
+        if (metaData->convertAndValidateRaw(rawMetaData.min, false /* validate as well */, varMin, errorString)) {
             metaData->setRawMin(varMin);
         } else {
             qCDebug(APMParameterMetaDataLog) << "Invalid min value, name:" << metaData->name()
-                                             << " type:" << metaData->type() << " min:" << rawMetaData->min
+                                             << " type:" << metaData->type() << " min:" << rawMetaData.min
                                              << " error:" << errorString;
         }
     }
 
-    if (!rawMetaData->max.isEmpty()) {
+    if (!rawMetaData.max.isEmpty()) {
         QVariant varMax;
         QString errorString;
-        if (metaData->convertAndValidateRaw(rawMetaData->max, false /* validate as well */, varMax, errorString)) {
+        if (metaData->convertAndValidateRaw(rawMetaData.max, false /* validate as well */, varMax, errorString)) {
             metaData->setRawMax(varMax);
         } else {
             qCDebug(APMParameterMetaDataLog) << "Invalid max value, name:" << metaData->name() << " type:"
-                                             << metaData->type() << " max:" << rawMetaData->max
+                                             << metaData->type() << " max:" << rawMetaData.max
                                              << " error:" << errorString;
         }
     }
 
-    if (rawMetaData->values.count() > 0) {
+    if (rawMetaData.values.count() > 0) {
         QStringList     enumStrings;
         QVariantList    enumValues;
 
-        for (int i=0; i<rawMetaData->values.count(); i++) {
+        for (int i=0; i<rawMetaData.values.count(); i++) {
             QVariant    enumValue;
             QString     errorString;
-            QPair<QString, QString> enumPair = rawMetaData->values[i];
+            QPair<QString, QString> enumPair = rawMetaData.values[i];
 
             if (metaData->convertAndValidateRaw(enumPair.first, false /* validate */, enumValue, errorString)) {
                 enumValues << enumValue;
@@ -529,14 +546,14 @@ FactMetaData* APMParameterMetaData::getMetaDataForFact(const QString& name, MAV_
         }
     }
 
-    if (rawMetaData->bitmask.count() > 0) {
+    if (rawMetaData.bitmask.count() > 0) {
         QStringList     bitmaskStrings;
         QVariantList    bitmaskValues;
 
-        for (int i=0; i<rawMetaData->bitmask.count(); i++) {
+        for (int i=0; i<rawMetaData.bitmask.count(); i++) {
             QVariant    bitmaskValue;
             QString     errorString;
-            QPair<QString, QString> bitmaskPair = rawMetaData->bitmask[i];
+            QPair<QString, QString> bitmaskPair = rawMetaData.bitmask[i];
 
             bool ok = false;
             unsigned int bitSet = bitmaskPair.first.toUInt(&ok);
@@ -600,14 +617,14 @@ FactMetaData* APMParameterMetaData::getMetaDataForFact(const QString& name, MAV_
         }
     }
 
-    if (!rawMetaData->incrementSize.isEmpty()) {
+    if (!rawMetaData.increment.isEmpty()) {
         double  increment;
         bool    ok;
-        increment = rawMetaData->incrementSize.toDouble(&ok);
+        increment = rawMetaData.increment.toDouble(&ok);
         if (ok) {
             metaData->setRawIncrement(increment);
         } else {
-            qCDebug(APMParameterMetaDataLog) << "Invalid value for increment, name:" << metaData->name() << " increment:" << rawMetaData->incrementSize;
+            qCDebug(APMParameterMetaDataLog) << "Invalid value for increment, name:" << metaData->name() << " increment:" << rawMetaData.increment;
         }
     }
 
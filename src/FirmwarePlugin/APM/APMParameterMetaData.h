@@ -17,38 +17,12 @@
 
 #include "MAVLinkLib.h"
 #include "FactMetaData.h"
+#include "ParameterMetaDataCache.h"
 
 Q_DECLARE_LOGGING_CATEGORY(APMParameterMetaDataLog)
 Q_DECLARE_LOGGING_CATEGORY(APMParameterMetaDataVerboseLog)
 
-class APMFactMetaDataRaw : public QObject
-{
-    Q_OBJECT
-public:
-    APMFactMetaDataRaw(QObject *parent = nullptr)
-        : QObject(parent), rebootRequired(false)
-    { }
-
-    QString name;
-    QString category;
-    QString group;
-    QString shortDescription;
-    QString longDescription;
-    QString min;
-    QString max;
-    QString incrementSize;
-    QString units;
-    bool    rebootRequired;
-    bool    readOnly;
-    QList<QPair<QString, QString> > values;
-    QList<QPair<QString, QString> > bitmask;
-};
-
-
 /// Collection of Parameter Facts for PX4 AutoPilot
-
-typedef QMap<QString, APMFactMetaDataRaw*> ParameterNametoFactMetaDataMap;
-
 class APMParameterMetaData : public QObject
 {
     Q_OBJECT
@@ -76,14 +50,18 @@ private:
 
     QVariant _stringToTypedVariant(const QString& string, FactMetaData::ValueType_t type, bool* convertOk);
     bool skipXMLBlock(QXmlStreamReader& xml, const QString& blockName);
-    bool parseParameterAttributes(QXmlStreamReader& xml, APMFactMetaDataRaw *rawMetaData);
-    void correctGroupMemberships(ParameterNametoFactMetaDataMap& parameterToFactMetaDataMap, QMap<QString,QStringList>& groupMembers);
+    typedef QMap<QString, ParameterMetaDataCache::Record> ParameterNameToRecordMap;
+
+    bool _parseParameterMetaData(const QByteArray& metaData, QMap<QString, ParameterNameToRecordMap>& vehicleTypeToParametersMap);
+    bool parseParameterAttributes(QXmlStreamReader& xml, ParameterMetaDataCache::Record& rawMetaData);
+    void correctGroupMemberships(ParameterNameToRecordMap& parameterToRecordMap, QMap<QString,QStringList>& groupMembers);
     QString mavTypeToString(MAV_TYPE vehicleTypeEnum);
     QString _groupFromParameterName(const QString& name);
 
     bool                                            _parameterMetaDataLoaded        = false;    ///< true: parameter meta data already loaded
     // FIXME: metadata is vehicle type specific now
-    QMap<QString, ParameterNametoFactMetaDataMap>   _vehicleTypeToParametersMap;                ///< Maps from a vehicle type to paramametertoFactMeta map>
+    ParameterMetaDataCache                          _metaDataCache;                             ///< Raw meta data with a section per vehicle type
 
     static constexpr const char* kInvalidConverstion = "Internal Error: No support for string parameters";
+    static constexpr const char* kCacheProducer = "APM";
 };
@@ -87,62 +87,72 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
 
     qCDebug(PX4ParameterMetaDataLog) << "Loading parameter meta data:" << metaDataFile;
 
-    QFile xmlFile(metaDataFile);
-
-    if (!xmlFile.exists()) {
+    if (!QFile::exists(metaDataFile)) {
         qWarning() << "Internal error: metaDataFile mission" << metaDataFile;
         return;
     }
-    
-    if (!xmlFile.open(QIODevice::ReadOnly)) {
-        qWarning() << "Internal error: Unable to open parameter file:" << metaDataFile << xmlFile.errorString();
+
+    // The xml is only parsed when the file content changed, FactMetaData is created from the cached records on use
+    const bool loaded = _metaDataCache.load(kCacheProducer, metaDataFile,
+                                            [this, &metaDataFile](const QByteArray& metaData, ParameterMetaDataCache::Sections& sections) {
+                                                return _parseParameterMetaData(metaDataFile, metaData, sections[QString()]);
+                                            });
+    if (!loaded) {
+        qWarning() << "Internal error: Unable to open parameter file:" << metaDataFile;
         return;
     }
-    
-    QXmlStreamReader xml(xmlFile.readAll());
-    xmlFile.close();
+
+#ifdef GENERATE_PARAMETER_JSON
+    _generateParameterJson();
+#endif
+}
+
+bool PX4ParameterMetaData::_parseParameterMetaData(const QString& metaDataFile, const QByteArray& metaData, ParameterMetaDataCache::Section& records)
+{
+    QXmlStreamReader xml(metaData);
     if (xml.hasError()) {
         qWarning() << "Badly formed XML" << xml.errorString();
-        return;
+        return false;
     }
-    
-    QString         factGroup;
-    QString         errorString;
-    FactMetaData*   metaData = nullptr;
-    int             xmlState = XmlStateNone;
-    bool            badMetaData = true;
-    
+
+    QString                         factGroup;
+    QString                         name;
+    ParameterMetaDataCache::Record  record;
+    bool                            haveRecord = false;
+    int                             xmlState = XmlStateNone;
+    bool                            badMetaData = true;
+
     while (!xml.atEnd()) {
         if (xml.isStartElement()) {
             QString elementName = xml.name().toString();
-            
+
             if (elementName == "parameters") {
                 if (xmlState != XmlStateNone) {
                     qWarning() << "Badly formed XML";
-                    return;
+                    return false;
                 }
                 xmlState = XmlStateFoundParameters;
-                
+
             } else if (elementName == "version") {
                 if (xmlState != XmlStateFoundParameters) {
                     qWarning() << "Badly formed XML";
-                    return;
+                    return false;
                 }
                 xmlState = XmlStateFoundVersion;
-                
+
                 bool convertOk;
                 QString strVersion = xml.readElementText();
                 int intVersion = strVersion.toInt(&convertOk);
                 if (!convertOk) {
                     qWarning() << "Badly formed XML";
-                    return;
+                    return false;
                 }
                 if (intVersion <= 2) {
                     // We can't read these old files
                     qDebug() << "Parameter version stamp too old, skipping load. Found:" << intVersion << "Want: 3 File:" << metaDataFile;
-                    return;
+                    return true;
                 }
-                
+
             } else if (elementName == "parameter_version_major") {
                 // Just skip over for now
             } else if (elementName == "parameter_version_minor") {
@@ -152,33 +162,33 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                 if (xmlState != XmlStateFoundVersion) {
                     // We didn't get a version stamp, assume older version we can't read
                     qDebug() << "Parameter version stamp not found, skipping load" << metaDataFile;
-                    return;
+                    return true;
                 }
                 xmlState = XmlStateFoundGroup;
-                
+
                 if (!xml.attributes().hasAttribute("name")) {
                     qWarning() << "Badly formed XML";
-                    return;
+                    return false;
                 }
                 factGroup = xml.attributes().value("name").toString();
                 qCDebug(PX4ParameterMetaDataLog) << "Found group: " << factGroup;
-                
+
             } else if (elementName == "parameter") {
                 if (xmlState != XmlStateFoundGroup) {
                     qWarning() << "Badly formed XML";
-                    return;
+                    return false;
                 }
                 xmlState = XmlStateFoundParameter;
-                
+
                 if (!xml.attributes().hasAttribute("name") || !xml.attributes().hasAttribute("type")) {
                     qWarning() << "Badly formed XML";
-                    return;
+                    return false;
                 }
-                
-                QString name = xml.attributes().value("name").toString();
+
+                name = xml.attributes().value("name").toString();
                 QString type = xml.attributes().value("type").toString();
                 QString strDefault =    xml.attributes().value("default").toString();
-                
+
                 QString category = xml.attributes().value("category").toString();
                 if (category.isEmpty()) {
                     category = QStringLiteral("Standard");
@@ -200,106 +210,74 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
 
                 qCDebug(PX4ParameterMetaDataLog) << "Found parameter name:" << name << " type:" << type << " default:" << strDefault;
 
-                // Convert type from string to FactMetaData::ValueType_t
+                // Check the type now, so records with a bad type never make it into the cache
                 bool unknownType;
-                FactMetaData::ValueType_t foundType = FactMetaData::stringToType(type, unknownType);
+                (void) FactMetaData::stringToType(type, unknownType);
                 if (unknownType) {
                     qWarning() << "Parameter meta data with bad type:" << type << " name:" << name;
-                    return;
+                    return false;
                 }
-                
-                // Now that we know type we can create meta data object and add it to the system
-                metaData = new FactMetaData(foundType, this);
-                if (_mapParameterName2FactMetaData.contains(name)) {
+
+                record = ParameterMetaDataCache::Record();
+                record.type = type;
+                haveRecord = true;
+                if (records.contains(name)) {
                     // We can't trust the meta data since we have dups
                     qCWarning(PX4ParameterMetaDataLog) << "Duplicate parameter found:" << name;
                     badMetaData = true;
                     // Reset to default meta data
-                    _mapParameterName2FactMetaData[name] = metaData;
                 } else {
-                    _mapParameterName2FactMetaData[name] = metaData;
-                    metaData->setName(name);
-                    metaData->setCategory(category);
-                    metaData->setGroup(factGroup);
-                    metaData->setReadOnly(readOnly);
-                    metaData->setVolatileValue(volatileValue);
-                    
-                    if (xml.attributes().hasAttribute("default") && !strDefault.isEmpty()) {
-                        QVariant varDefault;
-                        
-                        if (metaData->convertAndValidateRaw(strDefault, false, varDefault, errorString)) {
-                            metaData->setRawDefaultValue(varDefault);
-                        } else {
-                            qCWarning(PX4ParameterMetaDataLog) << "Invalid default value, name:" << name << " type:" << type << " default:" << strDefault << " error:" << errorString;
-                        }
+                    record.category = category;
+                    record.group = factGroup;
+                    record.readOnly = readOnly;
+                    record.volatileValue = volatileValue;
+                    if (xml.attributes().hasAttribute("default")) {
+                        record.defaultValue = strDefault;
                     }
                 }
-                
+
             } else {
                 // We should be getting meta data now
                 if (xmlState != XmlStateFoundParameter) {
                     qWarning() << "Badly formed XML";
-                    return;
+                    return false;
                 }
 
                 if (!badMetaData) {
-                    if (metaData) {
+                    if (haveRecord) {
                         if (elementName == "short_desc") {
                             QString text = xml.readElementText();
                             text = text.replace("\n", " ");
                             qCDebug(PX4ParameterMetaDataLog) << "Short description:" << text;
-                            metaData->setShortDescription(text);
+                            record.shortDescription = text;
 
                         } else if (elementName == "long_desc") {
                             QString text = xml.readElementText();
                             text = text.replace("\n", " ");
                             qCDebug(PX4ParameterMetaDataLog) << "Long description:" << text;
-                            metaData->setLongDescription(text);
+                            record.longDescription = text;
 
                         } else if (elementName == "min") {
-                            QString text = xml.readElementText();
-                            qCDebug(PX4ParameterMetaDataLog) << "Min:" << text;
-
-                            QVariant varMin;
-                            if (metaData->convertAndValidateRaw(text, false /* convertOnly */, varMin, errorString)) {
-                                metaData->setRawMin(varMin);
-                            } else {
-                                qCWarning(PX4ParameterMetaDataLog) << "Invalid min value, name:" << metaData->name() << " type:" << metaData->type() << " min:" << text << " error:" << errorString;
-                            }
+                            record.min = xml.readElementText();
+                            qCDebug(PX4ParameterMetaDataLog) << "Min:" << record.min;
 
                         } else if (elementName == "max") {
-                            QString text = xml.readElementText();
-                            qCDebug(PX4ParameterMetaDataLog) << "Max:" << text;
-
-                            QVariant varMax;
-                            if (metaData->convertAndValidateRaw(text, false /* convertOnly */, varMax, errorString)) {
-                                metaData->setRawMax(varMax);
-                            } else {
-                                qCWarning(PX4ParameterMetaDataLog) << "Invalid max value, name:" << metaData->name() << " type:" << metaData->type() << " max:" << text << " error:" << errorString;
-                            }
+                            record.max = xml.readElementText();
+                            qCDebug(PX4ParameterMetaDataLog) << "Max:" << record.max;
 
                         } else if (elementName == "unit") {
-                            QString text = xml.readElementText();
-                            qCDebug(PX4ParameterMetaDataLog) << "Unit:" << text;
-                            metaData->setRawUnits(text);
+                            record.units = xml.readElementText();
+                            qCDebug(PX4ParameterMetaDataLog) << "Unit:" << record.units;
 
                         } else if (elementName == "decimal") {
-                            QString text = xml.readElementText();
-                            qCDebug(PX4ParameterMetaDataLog) << "Decimal:" << text;
-
-                            bool convertOk;
-                            QVariant varDecimals = QVariant(text).toUInt(&convertOk);
-                            if (convertOk) {
-                                metaData->setDecimalPlaces(varDecimals.toInt());
-                            } else {
-                                qCWarning(PX4ParameterMetaDataLog) << "Invalid decimals value, name:" << metaData->name() << " type:" << metaData->type() << " decimals:" << text << " error: invalid number";
-                            }
+                            record.decimalPlaces = xml.readElementText();
+                            qCDebug(PX4ParameterMetaDataLog) << "Decimal:" << record.decimalPlaces;
 
                         } else if (elementName == "reboot_required") {
                             QString text = xml.readElementText();
                             qCDebug(PX4ParameterMetaDataLog) << "RebootRequired:" << text;
                             if (text.compare("true", Qt::CaseInsensitive) == 0) {
-                                metaData->setVehicleRebootRequired(true);
+                                record.rebootRequired = true;
                             }
 
                         } else if (elementName == "values") {
@@ -310,59 +288,26 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
                             QString enumString = xml.readElementText();
                             qCDebug(PX4ParameterMetaDataLog) << "parameter value:"
                                                              << "value desc:" << enumString << "code:" << enumValueStr;
+                            record.values.append(QPair<QString, QString>(enumValueStr, enumString));
 
-                            QVariant    enumValue;
-                            QString     errorString;
-                            if (metaData->convertAndValidateRaw(enumValueStr, false /* validate */, enumValue, errorString)) {
-                                metaData->addEnumInfo(enumString, enumValue);
-                            } else {
-                                qCDebug(PX4ParameterMetaDataLog) << "Invalid enum value, name:" << metaData->name()
-                                                                 << " type:" << metaData->type() << " value:" << enumValueStr
-                                                                 << " error:" << errorString;
-                            }
                         } else if (elementName == "increment") {
-                            double  increment;
-                            bool    ok;
-                            QString text = xml.readElementText();
-                            increment = text.toDouble(&ok);
-                            if (ok) {
-                                metaData->setRawIncrement(increment);
-                            } else {
-                                qCWarning(PX4ParameterMetaDataLog) << "Invalid value for increment, name:" << metaData->name() << " increment:" << text;
-                            }
+                            record.increment = xml.readElementText();
 
                         } else if (elementName == "boolean") {
-                            QVariant    enumValue;
-                            metaData->convertAndValidateRaw(1, false /* validate */, enumValue, errorString);
-                            metaData->addEnumInfo(tr("Enabled"), enumValue);
-                            metaData->convertAndValidateRaw(0, false /* validate */, enumValue, errorString);
-                            metaData->addEnumInfo(tr("Disabled"), enumValue);
+                            record.boolean = true;
 
                         } else if (elementName == "bitmask") {
                             // doing nothing individual bits will follow anyway. May be used for sanity checking.
 
                         } else if (elementName == "bit") {
                             bool ok = false;
-                            unsigned char bit = xml.attributes().value("index").toString().toUInt(&ok);
+                            QString bitIndex = xml.attributes().value("index").toString();
+                            (void) bitIndex.toUInt(&ok);
                             if (ok) {
                                 QString bitDescription = xml.readElementText();
                                 qCDebug(PX4ParameterMetaDataLog) << "parameter value:"
-                                                                 << "index:" << bit << "description:" << bitDescription;
-
-                                if (bit < 31) {
-                                    QVariant bitmaskRawValue = 1 << bit;
-                                    QVariant bitmaskValue;
-                                    QString errorString;
-                                    if (metaData->convertAndValidateRaw(bitmaskRawValue, true, bitmaskValue, errorString)) {
-                                        metaData->addBitmaskInfo(bitDescription, bitmaskValue);
-                                    } else {
-                                        qCDebug(PX4ParameterMetaDataLog) << "Invalid bitmask value, name:" << metaData->name()
-                                                                         << " type:" << metaData->type() << " value:" << bitmaskValue
-                                                                         << " error:" << errorString;
-                                    }
-                                } else {
-                                    qCWarning(PX4ParameterMetaDataLog) << "Invalid value for bitmask, bit:" << bit;
-                                }
+                                                                 << "index:" << bitIndex << "description:" << bitDescription;
+                                record.bitmask.append(QPair<QString, QString>(bitIndex, bitDescription));
                             }
                         } else {
                             qCDebug(PX4ParameterMetaDataLog) << "Unknown element in XML: " << elementName;
@@ -376,17 +321,13 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
             QString elementName = xml.name().toString();
 
             if (elementName == "parameter") {
-                // Done loading this parameter, validate default value
-                if (metaData->defaultValueAvailable()) {
-                    QVariant var;
-
-                    if (!metaData->convertAndValidateRaw(metaData->rawDefaultValue(), false /* convertOnly */, var, errorString)) {
-                        qCWarning(PX4ParameterMetaDataLog) << "Invalid default value, name:" << metaData->name() << " type:" << metaData->type() << " default:" << metaData->rawDefaultValue() << " error:" << errorString;
-                    }
+                // Done loading this parameter
+                if (haveRecord) {
+                    records[name] = record.toBytes();
                 }
 
                 // Reset for next parameter
-                metaData = nullptr;
+                haveRecord = false;
                 badMetaData = false;
                 xmlState = XmlStateFoundGroup;
             } else if (elementName == "group") {
@@ -398,9 +339,142 @@ void PX4ParameterMetaData::loadParameterFactMetaDataFile(const QString& metaData
         xml.readNext();
     }
 
-#ifdef GENERATE_PARAMETER_JSON
-    _generateParameterJson();
-#endif
+    return !xml.hasError();
+}
+
+FactMetaData* PX4ParameterMetaData::_createMetaData(const QString& name, const ParameterMetaDataCache::Record& record)
+{
+    bool unknownType;
+    FactMetaData::ValueType_t foundType = FactMetaData::stringToType(record.type, unknownType);
+    if (unknownType) {
+        qWarning() << "Parameter meta data with bad type:" << record.type << " name:" << name;
+        return nullptr;
+    }
+
+    QString         errorString;
+    FactMetaData*   metaData = new FactMetaData(foundType, this);
+
+    metaData->setName(name);
+    if (!record.category.isEmpty()) {
+        metaData->setCategory(record.category);
+    }
+    if (!record.group.isEmpty()) {
+        metaData->setGroup(record.group);
+    }
+    metaData->setReadOnly(record.readOnly);
+    metaData->setVolatileValue(record.volatileValue);
+
+    if (!record.defaultValue.isEmpty()) {
+        QVariant varDefault;
+
+        if (metaData->convertAndValidateRaw(record.defaultValue, false, varDefault, errorString)) {
+            metaData->setRawDefaultValue(varDefault);
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid default value, name:" << name << " type:" << record.type << " default:" << record.defaultValue << " error:" << errorString;
+        }
+    }
+
+    if (!record.shortDescription.isEmpty()) {
+        metaData->setShortDescription(record.shortDescription);
+    }
+    if (!record.longDescription.isEmpty()) {
+        metaData->setLongDescription(record.longDescription);
+    }
+
+    if (!record.min.isEmpty()) {
+        QVariant varMin;
+        if (metaData->convertAndValidateRaw(record.min, false /* convertOnly */, varMin, errorString)) {
+            metaData->setRawMin(varMin);
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid min value, name:" << metaData->name() << " type:" << metaData->type() << " min:" << record.min << " error:" << errorString;
+        }
+    }
+
+    if (!record.max.isEmpty()) {
+        QVariant varMax;
+        if (metaData->convertAndValidateRaw(record.max, false /* convertOnly */, varMax, errorString)) {
+            metaData->setRawMax(varMax);
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid max value, name:" << metaData->name() << " type:" << metaData->type() << " max:" << record.max << " error:" << errorString;
+        }
+    }
+
+    if (!record.units.isEmpty()) {
+        metaData->setRawUnits(record.units);
+    }
+
+    if (!record.decimalPlaces.isEmpty()) {
+        bool convertOk;
+        QVariant varDecimals = QVariant(record.decimalPlaces).toUInt(&convertOk);
+        if (convertOk) {
+            metaData->setDecimalPlaces(varDecimals.toInt());
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid decimals value, name:" << metaData->name() << " type:" << metaData->type() << " decimals:" << record.decimalPlaces << " error: invalid number";
+        }
+    }
+
+    if (record.rebootRequired) {
+        metaData->setVehicleRebootRequired(true);
+    }
+
+    for (const QPair<QString, QString>& value: record.values) {
+        QVariant    enumValue;
+        QString     errorString;
+        if (metaData->convertAndValidateRaw(value.first, false /* validate */, enumValue, errorString)) {
+            metaData->addEnumInfo(value.second, enumValue);
+        } else {
+            qCDebug(PX4ParameterMetaDataLog) << "Invalid enum value, name:" << metaData->name()
+                                             << " type:" << metaData->type() << " value:" << value.first
+                                             << " error:" << errorString;
+        }
+    }
+
+    if (!record.increment.isEmpty()) {
+        bool    ok;
+        double  increment = record.increment.toDouble(&ok);
+        if (ok) {
+            metaData->setRawIncrement(increment);
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid value for increment, name:" << metaData->name() << " increment:" << record.increment;
+        }
+    }
+
+    if (record.boolean) {
+        QVariant    enumValue;
+        metaData->convertAndValidateRaw(1, false /* validate */, enumValue, errorString);
+        metaData->addEnumInfo(tr("Enabled"), enumValue);
+        metaData->convertAndValidateRaw(0, false /* validate */, enumValue, errorString);
+        metaData->addEnumInfo(tr("Disabled"), enumValue);
+    }
+
+    for (const QPair<QString, QString>& bitmask: record.bitmask) {
+        unsigned char bit = static_cast<unsigned char>(bitmask.first.toUInt());
+        if (bit < 31) {
+            QVariant bitmaskRawValue = 1 << bit;
+            QVariant bitmaskValue;
+            QString errorString;
+            if (metaData->convertAndValidateRaw(bitmaskRawValue, true, bitmaskValue, errorString)) {
+                metaData->addBitmaskInfo(bitmask.second, bitmaskValue);
+            } else {
+                qCDebug(PX4ParameterMetaDataLog) << "Invalid bitmask value, name:" << metaData->name()
+                                                 << " type:" << metaData->type() << " value:" << bitmaskValue
+                                                 << " error:" << errorString;
+            }
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid value for bitmask, bit:" << bit;
+        }
+    }
+
+    // Validate the default value against the range
+    if (metaData->defaultValueAvailable()) {
+        QVariant var;
+
+        if (!metaData->convertAndValidateRaw(metaData->rawDefaultValue(), false /* convertOnly */, var, errorString)) {
+            qCWarning(PX4ParameterMetaDataLog) << "Invalid default value, name:" << metaData->name() << " type:" << metaData->type() << " default:" << metaData->rawDefaultValue() << " error:" << errorString;
+        }
+    }
+
+    return metaData;
 }
 
 #ifdef GENERATE_PARAMETER_JSON
@@ -417,6 +491,10 @@ void PX4ParameterMetaData::_generateParameterJson()
 {
     qCDebug(ParameterManagerLog) << "PX4ParameterMetaData::_generateParameterJson";
 
+    for (const QString& paramName: _metaDataCache.names(QString())) {
+        (void) getMetaDataForFact(paramName, MAV_TYPE_GENERIC, FactMetaData::valueTypeFloat);
+    }
+
     int indentLevel = 0;
     QFile jsonFile(QDir(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)).absoluteFilePath("parameter.json"));
     jsonFile.open(QFile::WriteOnly | QFile::Truncate | QFile::Text);
@@ -491,13 +569,28 @@ FactMetaData* PX4ParameterMetaData::getMetaDataForFact(const QString& name, MAV_
 {
     Q_UNUSED(vehicleType)
 
-    if (!_mapParameterName2FactMetaData.contains(name)) {
+    const auto it = _mapParameterName2FactMetaData.constFind(name);
+    if (it != _mapParameterName2FactMetaData.constEnd()) {
+        return it.value();
+    }
+
+    FactMetaData* metaData = nullptr;
+    const QByteArray recordBytes = _metaDataCache.record(QString(), name);
+    if (!recordBytes.isNull()) {
+        ParameterMetaDataCache::Record record;
+        if (ParameterMetaDataCache::Record::fromBytes(recordBytes, record)) {
+            metaData = _createMetaData(name, record);
+        } else {
+            qCWarning(PX4ParameterMetaDataLog) << "Unable to decode cached metaData for" << name;
+        }
+    }
+    if (!metaData) {
         qCDebug(PX4ParameterMetaDataLog) << "No metaData for " << name << "using generic metadata";
-        FactMetaData* metaData = new FactMetaData(type, this);
-        _mapParameterName2FactMetaData[name] = metaData;
+        metaData = new FactMetaData(type, this);
     }
+    _mapParameterName2FactMetaData[name] = metaData;
 
-    return _mapParameterName2FactMetaData[name];
+    return metaData;
 }
 
 void PX4ParameterMetaData::getParameterMetaDataVersionInfo(const QString& metaDataFile, int& majorVersion, int& minorVersion)
@@ -12,6 +12,7 @@
 
 #include "MAVLinkLib.h"
 #include "FactMetaData.h"
+#include "ParameterMetaDataCache.h"
 
 #include <QtCore/QObject>
 #include <QtCore/QLoggingCategory>
@@ -47,6 +48,8 @@ private:
     };
 
     QVariant _stringToTypedVariant(const QString& string, FactMetaData::ValueType_t type, bool* convertOk);
+    bool _parseParameterMetaData(const QString& metaDataFile, const QByteArray& metaData, ParameterMetaDataCache::Section& records);
+    FactMetaData* _createMetaData(const QString& name, const ParameterMetaDataCache::Record& record);
     static void _outputFileWarning(const QString& metaDataFile, const QString& error1, const QString& error2);
 
 #ifdef GENERATE_PARAMETER_JSON
@@ -54,8 +57,10 @@ private:
 #endif
 
     bool                                _parameterMetaDataLoaded        = false;    ///< true: parameter meta data already loaded
-    FactMetaData::NameToMetaDataMap_t   _mapParameterName2FactMetaData;             ///< Maps from a parameter name to FactMetaData
+    ParameterMetaDataCache              _metaDataCache;                             ///< Raw meta data of all parameters in the file
+    FactMetaData::NameToMetaDataMap_t   _mapParameterName2FactMetaData;             ///< Maps from a parameter name to FactMetaData, filled on first use
 
     static constexpr const char* kInvalidConverstion = "Internal Error: No support for string parameters";
+    static constexpr const char* kCacheProducer = "PX4";
 
 };
@@ -21,6 +21,10 @@
 
 #include <QtCore/QSettings>
 #include <QtCore/QThread>
+#include <QtCore/QVarLengthArray>
+
+#include <algorithm>
+#include <limits>
 
 // JoystickLog Category declaration moved to QGCLoggingCategory.cc to allow access in Vehicle
 QGC_LOGGING_CATEGORY(JoystickValuesLog, "JoystickValuesLog")
@@ -439,58 +443,111 @@ void Joystick::run()
     _open();
     //-- Reset timers
     _axisTime.start();
+    _inputClock.start();
+    _latencyReportTime.start();
+    _pendingInputNs = -1;
     for (int buttonIndex = 0; buttonIndex < _totalButtonCount; buttonIndex++) {
         if(_buttonActionArray[buttonIndex]) {
             _buttonActionArray[buttonIndex]->buttonTime.start();
         }
     }
+    if (_eventDriven()) {
+        _runEventDriven();
+    } else {
+        _runPolled();
+    }
+    _close();
+}
+
+void Joystick::_runPolled()
+{
     while (!_exitThread) {
         _update();
+        if (_readAxes() && (_pendingInputNs < 0)) {
+            _pendingInputNs = _inputClock.nsecsElapsed();
+        }
         _handleButtons();
-        if (axisCount() != 0) {
+        //-- Check elapsed time since last run
+        if ((axisCount() != 0) && (_axisTime.elapsed() > static_cast<int>(1000.0f / _axisFrequencyHz))) {
             _handleAxis();
         }
         QThread::msleep(qMin(static_cast<int>(1000.0f / _maxAxisFrequencyHz), static_cast<int>(1000.0f / _maxButtonFrequencyHz)) / 2);
     }
-    _close();
+}
+
+void Joystick::_runEventDriven()
+{
+    // Sticks and buttons may have been moved while the joystick was not read
+    (void) _readAxes();
+    _handleButtons();
+    while (!_exitThread) {
+        //-- Changes are sent at most at the axis frequency, otherwise the last values are repeated as a keepalive
+        const int sendIntervalMs = static_cast<int>(1000.0f / _axisFrequencyHz);
+        const int keepaliveMs = qMax(kKeepaliveMs, sendIntervalMs);
+        const int axisDueMs = ((_pendingInputNs >= 0) || _accumulator) ? sendIntervalMs : keepaliveMs;
+
+        int waitMs = kMaxInputWaitMs;
+        if (axisCount() != 0) {
+            waitMs = qMin(waitMs, qMax(0, axisDueMs - static_cast<int>(_axisTime.elapsed())));
+        }
+        if (_nextButtonRepeatMs >= 0) {
+            waitMs = qMin(waitMs, _nextButtonRepeatMs);
+        }
+
+        qint64 inputNs = -1;
+        const int changes = _waitForInput(waitMs, inputNs);
+        //-- Buttons are sent along with the axes
+        const bool axesChanged = (changes & InputAxes) && _readAxes();
+        if ((axesChanged || (changes & InputButtons)) && (_pendingInputNs < 0)) {
+            _pendingInputNs = inputNs;
+        }
+        if ((changes & InputButtons) || (_nextButtonRepeatMs >= 0)) {
+            _handleButtons();
+        }
+        if ((axisCount() != 0) && (_axisTime.elapsed() >= (((_pendingInputNs >= 0) || _accumulator) ? sendIntervalMs : keepaliveMs))) {
+            _handleAxis();
+        }
+    }
+}
+
+bool Joystick::_readAxes()
+{
+    bool changed = false;
+    for (int axisIndex = 0; axisIndex < _axisCount; axisIndex++) {
+        const int newAxisValue = _getAxis(axisIndex);
+        if (newAxisValue != _rgAxisValues[axisIndex]) {
+            _rgAxisValues[axisIndex] = newAxisValue;
+            changed = true;
+        }
+    }
+    return changed;
 }
 
 void Joystick::_handleButtons()
 {
-    int lastBbuttonValues[256];
-    //-- Update button states
-    for (int buttonIndex = 0; buttonIndex < _buttonCount; buttonIndex++) {
-        bool newButtonValue = _getButton(buttonIndex);
-        if(buttonIndex < 256)
-            lastBbuttonValues[buttonIndex] = _rgButtonValues[buttonIndex];
+    //-- Update button states, hat buttons are appended to the end of the normal button list
+    const int numHatButtons = 4;
+    QVarLengthArray<int, 8> releasedButtons;
+    for (int buttonIndex = 0; buttonIndex < _totalButtonCount; buttonIndex++) {
+        bool newButtonValue;
+        if (buttonIndex < _buttonCount) {
+            newButtonValue = _getButton(buttonIndex);
+        } else {
+            // Get hat value from joystick
+            const int hatButtonIndex = buttonIndex - _buttonCount;
+            newButtonValue = _getHat(hatButtonIndex / numHatButtons, hatButtonIndex % numHatButtons);
+        }
         if (newButtonValue && _rgButtonValues[buttonIndex] == BUTTON_UP) {
             _rgButtonValues[buttonIndex] = BUTTON_DOWN;
             emit rawButtonPressedChanged(buttonIndex, newButtonValue);
         } else if (!newButtonValue && _rgButtonValues[buttonIndex] != BUTTON_UP) {
             _rgButtonValues[buttonIndex] = BUTTON_UP;
+            releasedButtons.append(buttonIndex);
             emit rawButtonPressedChanged(buttonIndex, newButtonValue);
         }
     }
-    //-- Update hat - append hat buttons to the end of the normal button list
-    int numHatButtons = 4;
-    for (int hatIndex = 0; hatIndex < _hatCount; hatIndex++) {
-        for (int hatButtonIndex = 0; hatButtonIndex<numHatButtons; hatButtonIndex++) {
-            // Create new index value that includes the normal button list
-            int rgButtonValueIndex = hatIndex*numHatButtons + hatButtonIndex + _buttonCount;
-            // Get hat value from joystick
-            bool newButtonValue = _getHat(hatIndex, hatButtonIndex);
-            if(rgButtonValueIndex < 256)
-                lastBbuttonValues[rgButtonValueIndex] = _rgButtonValues[rgButtonValueIndex];
-            if (newButtonValue && _rgButtonValues[rgButtonValueIndex] == BUTTON_UP) {
-                _rgButtonValues[rgButtonValueIndex] = BUTTON_DOWN;
-                emit rawButtonPressedChanged(rgButtonValueIndex, newButtonValue);
-            } else if (!newButtonValue && _rgButtonValues[rgButtonValueIndex] != BUTTON_UP) {
-                _rgButtonValues[rgButtonValueIndex] = BUTTON_UP;
-                emit rawButtonPressedChanged(rgButtonValueIndex, newButtonValue);
-            }
-        }
-    }
-    //-- Process button press/release
+    //-- Process button press
+    _nextButtonRepeatMs = -1;
     for (int buttonIndex = 0; buttonIndex < _totalButtonCount; buttonIndex++) {
         if(_rgButtonValues[buttonIndex] == BUTTON_DOWN || _rgButtonValues[buttonIndex] == BUTTON_REPEAT) {
             if(_buttonActionArray[buttonIndex]) {
@@ -532,124 +589,184 @@ void Joystick::_handleButtons()
                         qCDebug(JoystickLog) << "Repeat button triggered" << buttonIndex << buttonAction;
                         _executeButtonAction(buttonAction, true);
                     }
+                    const int repeatDueMs = qMax(0, buttonDelay + 1 - static_cast<int>(_buttonActionArray[buttonIndex]->buttonTime.elapsed()));
+                    _nextButtonRepeatMs = (_nextButtonRepeatMs < 0) ? repeatDueMs : qMin(_nextButtonRepeatMs, repeatDueMs);
                 }
             }
             //-- Flag it as processed
             _rgButtonValues[buttonIndex] = BUTTON_REPEAT;
-        } else if(_rgButtonValues[buttonIndex] == BUTTON_UP) {
-            //-- Button up transition
-            if(buttonIndex < 256) {
-                if(lastBbuttonValues[buttonIndex] == BUTTON_DOWN || lastBbuttonValues[buttonIndex] == BUTTON_REPEAT) {
-                    if(_buttonActionArray[buttonIndex]) {
-                        QString buttonAction = _buttonActionArray[buttonIndex]->action;
-                        if(buttonAction.isEmpty() || buttonAction == _buttonActionNone)
-                            continue;
-                        qCDebug(JoystickLog) << "Button up" << buttonIndex << buttonAction;
-                        _executeButtonAction(buttonAction, false);
-                    }
-                }
-            }
+        }
+    }
+    //-- Process button release
+    for (const int buttonIndex : releasedButtons) {
+        if(_buttonActionArray[buttonIndex]) {
+            QString buttonAction = _buttonActionArray[buttonIndex]->action;
+            if(buttonAction.isEmpty() || buttonAction == _buttonActionNone)
+                continue;
+            qCDebug(JoystickLog) << "Button up" << buttonIndex << buttonAction;
+            _executeButtonAction(buttonAction, false);
         }
     }
 }
 
 void Joystick::_handleAxis()
 {
-    //-- Get frequency
-    int axisDelay = static_cast<int>(1000.0f / _axisFrequencyHz);
-    //-- Check elapsed time since last run
-    if(_axisTime.elapsed() > axisDelay) {
-        _axisTime.start();
-        //-- Update axis
-        for (int axisIndex = 0; axisIndex < _axisCount; axisIndex++) {
-            int newAxisValue = _getAxis(axisIndex);
-            // Calibration code requires signal to be emitted even if value hasn't changed
-            _rgAxisValues[axisIndex] = newAxisValue;
-            emit rawAxisValueChanged(axisIndex, newAxisValue);
-        }
-        if (_activeVehicle && _activeVehicle->joystickEnabled() && !_calibrationMode && _calibrated) {
-            int     axis = _rgFunctionAxis[rollFunction];
-            float   roll = _adjustRange(_rgAxisValues[axis],    _rgCalibration[axis], _deadband);
+    //-- Time since the last run, the axis values are read by the caller
+    const float elapsedSecs = _axisTime.restart() / 1000.f;
+    const qint64 inputNs = _pendingInputNs;
+    _pendingInputNs = -1;
+    for (int axisIndex = 0; axisIndex < _axisCount; axisIndex++) {
+        // Calibration code requires signal to be emitted even if value hasn't changed
+        emit rawAxisValueChanged(axisIndex, _rgAxisValues[axisIndex]);
+    }
+    if (_activeVehicle && _activeVehicle->joystickEnabled() && !_calibrationMode && _calibrated) {
+        int     axis = _rgFunctionAxis[rollFunction];
+        float   roll = _adjustRange(_rgAxisValues[axis],    _rgCalibration[axis], _deadband);
 
-                    axis = _rgFunctionAxis[pitchFunction];
-            float   pitch = _adjustRange(_rgAxisValues[axis],   _rgCalibration[axis], _deadband);
+                axis = _rgFunctionAxis[pitchFunction];
+        float   pitch = _adjustRange(_rgAxisValues[axis],   _rgCalibration[axis], _deadband);
 
-                    axis = _rgFunctionAxis[yawFunction];
-            float   yaw = _adjustRange(_rgAxisValues[axis],     _rgCalibration[axis],_deadband);
+                axis = _rgFunctionAxis[yawFunction];
+        float   yaw = _adjustRange(_rgAxisValues[axis],     _rgCalibration[axis],_deadband);
 
-                    axis = _rgFunctionAxis[throttleFunction];
-            float   throttle = _adjustRange(_rgAxisValues[axis],_rgCalibration[axis], _throttleMode==ThrottleModeDownZero?false:_deadband);
+                axis = _rgFunctionAxis[throttleFunction];
+        float   throttle = _adjustRange(_rgAxisValues[axis],_rgCalibration[axis], _throttleMode==ThrottleModeDownZero?false:_deadband);
 
-            // These are only used for printing JoystickValuesLog
-            float   gimbalPitch = 0.0f;
-            float   gimbalYaw   = 0.0f;
+        // These are only used for printing JoystickValuesLog
+        float   gimbalPitch = 0.0f;
+        float   gimbalYaw   = 0.0f;
 
-            if(_axisCount > 4) {
-                axis = _rgFunctionAxis[gimbalPitchFunction];
-                gimbalPitch = _adjustRange(_rgAxisValues[axis], _rgCalibration[axis],_deadband);
-            }
+        if(_axisCount > 4) {
+            axis = _rgFunctionAxis[gimbalPitchFunction];
+            gimbalPitch = _adjustRange(_rgAxisValues[axis], _rgCalibration[axis],_deadband);
+        }
 
-            if(_axisCount > 5) {
-                axis = _rgFunctionAxis[gimbalYawFunction];
-                gimbalYaw = _adjustRange(_rgAxisValues[axis],   _rgCalibration[axis],_deadband);
-            }
+        if(_axisCount > 5) {
+            axis = _rgFunctionAxis[gimbalYawFunction];
+            gimbalYaw = _adjustRange(_rgAxisValues[axis],   _rgCalibration[axis],_deadband);
+        }
 
-            if (_accumulator) {
-                static float throttle_accu = 0.f;
-                throttle_accu += throttle * (40 / 1000.f); //for throttle to change from min to max it will take 1000ms (40ms is a loop time)
-                throttle_accu = std::max(static_cast<float>(-1.f), std::min(throttle_accu, static_cast<float>(1.f)));
-                throttle = throttle_accu;
-            }
+        if (_accumulator) {
+            static float throttle_accu = 0.f;
+            throttle_accu += throttle * elapsedSecs; //for throttle to change from min to max it will take 1000ms
+            throttle_accu = std::max(static_cast<float>(-1.f), std::min(throttle_accu, static_cast<float>(1.f)));
+            throttle = throttle_accu;
+        }
 
-            if (_circleCorrection) {
-                float roll_limited      = std::max(static_cast<float>(-M_PI_4), std::min(roll,      static_cast<float>(M_PI_4)));
-                float pitch_limited     = std::max(static_cast<float>(-M_PI_4), std::min(pitch,     static_cast<float>(M_PI_4)));
-                float yaw_limited       = std::max(static_cast<float>(-M_PI_4), std::min(yaw,       static_cast<float>(M_PI_4)));
-                float throttle_limited  = std::max(static_cast<float>(-M_PI_4), std::min(throttle,  static_cast<float>(M_PI_4)));
-
-                // Map from unit circle to linear range and limit
-                roll =      std::max(-1.0f, std::min(tanf(asinf(roll_limited)),     1.0f));
-                pitch =     std::max(-1.0f, std::min(tanf(asinf(pitch_limited)),    1.0f));
-                yaw =       std::max(-1.0f, std::min(tanf(asinf(yaw_limited)),      1.0f));
-                throttle =  std::max(-1.0f, std::min(tanf(asinf(throttle_limited)), 1.0f));
-            }
+        if (_circleCorrection) {
+            float roll_limited      = std::max(static_cast<float>(-M_PI_4), std::min(roll,      static_cast<float>(M_PI_4)));
+            float pitch_limited     = std::max(static_cast<float>(-M_PI_4), std::min(pitch,     static_cast<float>(M_PI_4)));
+            float yaw_limited       = std::max(static_cast<float>(-M_PI_4), std::min(yaw,       static_cast<float>(M_PI_4)));
+            float throttle_limited  = std::max(static_cast<float>(-M_PI_4), std::min(throttle,  static_cast<float>(M_PI_4)));
+
+            // Map from unit circle to linear range and limit
+            roll =      std::max(-1.0f, std::min(tanf(asinf(roll_limited)),     1.0f));
+            pitch =     std::max(-1.0f, std::min(tanf(asinf(pitch_limited)),    1.0f));
+            yaw =       std::max(-1.0f, std::min(tanf(asinf(yaw_limited)),      1.0f));
+            throttle =  std::max(-1.0f, std::min(tanf(asinf(throttle_limited)), 1.0f));
+        }
 
-            if ( _exponential < -0.01f) {
-                // Exponential (0% to -50% range like most RC radios)
-                // _exponential is set by a slider in joystickConfigAdvanced.qml
-                // Calculate new RPY with exponential applied
-                roll =  -_exponential*powf(roll, 3) + (1+_exponential)*roll;
-                pitch = -_exponential*powf(pitch,3) + (1+_exponential)*pitch;
-                yaw =   -_exponential*powf(yaw,  3) + (1+_exponential)*yaw;
-            }
+        if ( _exponential < -0.01f) {
+            // Exponential (0% to -50% range like most RC radios)
+            // _exponential is set by a slider in joystickConfigAdvanced.qml
+            // Calculate new RPY with exponential applied
+            roll =  -_exponential*powf(roll, 3) + (1+_exponential)*roll;
+            pitch = -_exponential*powf(pitch,3) + (1+_exponential)*pitch;
+            yaw =   -_exponential*powf(yaw,  3) + (1+_exponential)*yaw;
+        }
 
-            // Adjust throttle to 0:1 range
-            if (_throttleMode == ThrottleModeCenterZero && _activeVehicle->supportsThrottleModeCenterZero()) {
-                if (!_activeVehicle->supportsNegativeThrust() || !_negativeThrust) {
-                    throttle = std::max(0.0f, throttle);
-                }
-            } else {
-                throttle = (throttle + 1.0f) / 2.0f;
+        // Adjust throttle to 0:1 range
+        if (_throttleMode == ThrottleModeCenterZero && _activeVehicle->supportsThrottleModeCenterZero()) {
+            if (!_activeVehicle->supportsNegativeThrust() || !_negativeThrust) {
+                throttle = std::max(0.0f, throttle);
             }
-            qCDebug(JoystickValuesLog) << "name:roll:pitch:yaw:throttle:gimbalPitch:gimbalYaw" << name() << roll << -pitch << yaw << throttle << gimbalPitch << gimbalYaw;
-            // NOTE: The buttonPressedBits going to MANUAL_CONTROL are currently used by ArduSub (and it only handles 16 bits)
-            // Set up button bitmap
-            quint64 buttonPressedBits = 0;  // Buttons pressed for manualControl signal
-            for (int buttonIndex = 0; buttonIndex < _totalButtonCount; buttonIndex++) {
-                quint64 buttonBit = static_cast<quint64>(1LL << buttonIndex);
-                if (_rgButtonValues[buttonIndex] != BUTTON_UP) {
-                    // Mark the button as pressed as long as its pressed
-                    buttonPressedBits |= buttonBit;
-                }
+        } else {
+            throttle = (throttle + 1.0f) / 2.0f;
+        }
+        qCDebug(JoystickValuesLog) << "name:roll:pitch:yaw:throttle:gimbalPitch:gimbalYaw" << name() << roll << -pitch << yaw << throttle << gimbalPitch << gimbalYaw;
+        // NOTE: The buttonPressedBits going to MANUAL_CONTROL are currently used by ArduSub (and it only handles 16 bits)
+        // Set up button bitmap
+        quint64 buttonPressedBits = 0;  // Buttons pressed for manualControl signal
+        for (int buttonIndex = 0; buttonIndex < _totalButtonCount; buttonIndex++) {
+            quint64 buttonBit = static_cast<quint64>(1LL << buttonIndex);
+            if (_rgButtonValues[buttonIndex] != BUTTON_UP) {
+                // Mark the button as pressed as long as its pressed
+                buttonPressedBits |= buttonBit;
             }
-            emit axisValues(roll, pitch, yaw, throttle);
+        }
+        emit axisValues(roll, pitch, yaw, throttle);
 
-            uint16_t shortButtons = static_cast<uint16_t>(buttonPressedBits & 0xFFFF);
-            _activeVehicle->sendJoystickDataThreadSafe(roll, pitch, yaw, throttle, shortButtons);
+        uint16_t shortButtons = static_cast<uint16_t>(buttonPressedBits & 0xFFFF);
+        _activeVehicle->sendJoystickDataThreadSafe(roll, pitch, yaw, throttle, shortButtons);
+        if (inputNs >= 0) {
+            _recordInputLatency(_inputClock.nsecsElapsed() - inputNs);
         }
     }
 }
 
+void Joystick::_recordInputLatency(qint64 latencyNs)
+{
+    const quint32 latencyUs = static_cast<quint32>(qBound<qint64>(0, latencyNs / 1000, std::numeric_limits<quint32>::max()));
+    if (_latencySamplesUs.size() < kLatencySamples) {
+        _latencySamplesUs.append(latencyUs);
+    } else {
+        _latencySamplesUs[_latencySampleNext] = latencyUs;
+    }
+    _latencySampleNext = (_latencySampleNext + 1) % kLatencySamples;
+
+    if (_latencyReportTime.elapsed() < kLatencyReportMs) {
+        return;
+    }
+    _latencyReportTime.start();
+
+    QVector<quint32> sorted = _latencySamplesUs;
+    std::sort(sorted.begin(), sorted.end());
+    {
+        QMutexLocker locker(&_latencyMutex);
+        _latencySampleCount = sorted.size();
+        _latencyP50Ms = latencyPercentileMs(sorted, 50);
+        _latencyP95Ms = latencyPercentileMs(sorted, 95);
+        _latencyP99Ms = latencyPercentileMs(sorted, 99);
+        qCDebug(JoystickLog) << "Input latency ms p50:p95:p99" << _latencyP50Ms << _latencyP95Ms << _latencyP99Ms << "samples" << _latencySampleCount;
+    }
+    emit inputLatencyChanged();
+}
+
+float Joystick::latencyPercentileMs(const QVector<quint32>& sortedUs, int percent)
+{
+    if (sortedUs.isEmpty()) {
+        return 0;
+    }
+    // Nearest rank, rounded down
+    const qsizetype index = ((sortedUs.size() - 1) * qBound(0, percent, 100)) / 100;
+    return sortedUs[index] / 1000.0f;
+}
+
+int Joystick::inputLatencySamples() const
+{
+    QMutexLocker locker(&_latencyMutex);
+    return _latencySampleCount;
+}
+
+float Joystick::inputLatencyP50Ms() const
+{
+    QMutexLocker locker(&_latencyMutex);
+    return _latencyP50Ms;
+}
+
+float Joystick::inputLatencyP95Ms() const
+{
+    QMutexLocker locker(&_latencyMutex);
+    return _latencyP95Ms;
+}
+
+float Joystick::inputLatencyP99Ms() const
+{
+    QMutexLocker locker(&_latencyMutex);
+    return _latencyP99Ms;
+}
+
+
 void Joystick::startPolling(Vehicle* vehicle)
 {
     if (vehicle) {
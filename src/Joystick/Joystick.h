@@ -16,8 +16,11 @@
 #include "CustomActionManager.h"
 #include "QmlObjectListModel.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
 #include <QtCore/QThread>
+#include <QtCore/QVector>
 #include <QtCore/QTimer>
 #include <QtCore/QLoggingCategory>
 #include <QtQmlIntegration/QtQmlIntegration>
@@ -121,6 +124,11 @@ public:
     Q_PROPERTY(float    exponential             READ exponential            WRITE setExponential        NOTIFY exponentialChanged)
     Q_PROPERTY(bool     accumulator             READ accumulator            WRITE setAccumulator        NOTIFY accumulatorChanged)
     Q_PROPERTY(bool     circleCorrection        READ circleCorrection       WRITE setCircleCorrection   NOTIFY circleCorrectionChanged)
+    Q_PROPERTY(bool     eventDriven             READ eventDriven                                        CONSTANT)
+    Q_PROPERTY(int      inputLatencySamples     READ inputLatencySamples                                NOTIFY inputLatencyChanged)
+    Q_PROPERTY(float    inputLatencyP50Ms       READ inputLatencyP50Ms                                  NOTIFY inputLatencyChanged)
+    Q_PROPERTY(float    inputLatencyP95Ms       READ inputLatencyP95Ms                                  NOTIFY inputLatencyChanged)
+    Q_PROPERTY(float    inputLatencyP99Ms       READ inputLatencyP99Ms                                  NOTIFY inputLatencyChanged)
 
     Q_INVOKABLE void    setButtonRepeat     (int button, bool repeat);
     Q_INVOKABLE bool    getButtonRepeat     (int button);
@@ -192,6 +200,23 @@ public:
     /// Set joystick button repeat rate (in Hz)
     void  setButtonFrequency(float val);
 
+    /// true: input is read from the events of the backend and MANUAL_CONTROL is sent when it changes, limited to the
+    /// axis frequency and repeated as a keepalive. false: the backend is polled and MANUAL_CONTROL is sent at the axis
+    /// frequency.
+    bool  eventDriven       () const { return _eventDriven(); }
+
+    /// Percentiles of the time from an input change to the MANUAL_CONTROL carrying it, over the last
+    /// kLatencySamples changes. Polled backends only see a change at the next poll. The SDL event timestamps
+    /// only have millisecond resolution, so with SDL the input time and the percentiles are only good to a
+    /// millisecond.
+    int   inputLatencySamples   () const;
+    float inputLatencyP50Ms     () const;
+    float inputLatencyP95Ms     () const;
+    float inputLatencyP99Ms     () const;
+
+    /// @return Percentile of latencies in microseconds sorted in ascending order, in milliseconds, 0 if there are none
+    static float latencyPercentileMs(const QVector<quint32>& sortedUs, int percent);
+
 signals:
     // The raw signals are only meant for use by calibration
     void rawAxisValueChanged        (int index, int value);
@@ -206,6 +231,7 @@ signals:
     void enabledChanged             (bool enabled);
     void circleCorrectionChanged    (bool circleCorrection);
     void axisValues                 (float roll, float pitch, float yaw, float throttle);
+    void inputLatencyChanged        ();
 
     void axisFrequencyHzChanged     ();
     void buttonFrequencyHzChanged   ();
@@ -242,6 +268,7 @@ protected:
     int     _findAssignableButtonAction(const QString& action);
     bool    _validAxis              (int axis) const;
     bool    _validButton            (int button) const;
+    bool    _readAxes               ();
     void    _handleAxis             ();
     void    _handleButtons          ();
     void    _buildActionList        (Vehicle* activeVehicle);
@@ -255,6 +282,16 @@ private:
     virtual int  _getAxis   (int i)      = 0;
     virtual bool _getHat    (int hat,int i) = 0;
 
+    virtual bool _eventDriven   () const { return false; }
+    /// Waits for input of an event driven backend, returning as soon as there is any
+    ///     @param inputNs Returns the time of the earliest input on _inputClock
+    ///     @return InputChange flags of the input received, 0 on timeout
+    virtual int  _waitForInput  (int timeoutMs, qint64& inputNs) { Q_UNUSED(timeoutMs); Q_UNUSED(inputNs); return 0; }
+
+    void _runPolled         ();
+    void _runEventDriven    ();
+    void _recordInputLatency(qint64 latencyNs);
+
     void _updateTXModeSettingsKey(Vehicle* activeVehicle);
     int _mapFunctionMode(int mode, int function);
     void _remapAxes(int currentMode, int newMode, int (&newMapping)[maxFunction]);
@@ -270,6 +307,11 @@ protected:
         BUTTON_REPEAT
     };
 
+    enum InputChange {
+        InputAxes       = 0x01,
+        InputButtons    = 0x02
+    };
+
     static constexpr const float _defaultAxisFrequencyHz   = 25.0f;
     static constexpr const float _defaultButtonFrequencyHz = 5.0f;
 
@@ -302,6 +344,9 @@ protected:
     static int          _transmitterMode;
     int                 _rgFunctionAxis[maxFunction] = {};
     QElapsedTimer       _axisTime;
+    QElapsedTimer       _inputClock;                ///< Time base of the input timestamps
+    qint64              _pendingInputNs     = -1;   ///< Earliest input change not sent yet, -1 for none
+    int                 _nextButtonRepeatMs = -1;   ///< Time until a held repeat button is due, -1 for none
 
     QmlObjectListModel              _assignableButtonActions;
     QList<AssignedButtonAction*>    _buttonActionArray;
@@ -314,9 +359,23 @@ protected:
     static constexpr const float _minButtonFrequencyHz     = 0.25f;
     static constexpr const float _maxButtonFrequencyHz     = 50.0f;
 
+    static constexpr int kKeepaliveMs       = 100;  ///< Longest interval between MANUAL_CONTROL of an event driven backend
+    static constexpr int kMaxInputWaitMs    = 100;  ///< Longest wait for input, bounds the time to notice _exitThread
+    static constexpr int kLatencySamples    = 1000;
+    static constexpr int kLatencyReportMs   = 1000;
+
 private:
     const char* _txModeSettingsKey = nullptr;
 
+    QVector<quint32>    _latencySamplesUs;          ///< Ring buffer, only used by the joystick thread
+    int                 _latencySampleNext  = 0;
+    QElapsedTimer       _latencyReportTime;
+    mutable QMutex      _latencyMutex;              ///< Guards the percentiles below
+    int                 _latencySampleCount = 0;
+    float               _latencyP50Ms       = 0;
+    float               _latencyP95Ms       = 0;
+    float               _latencyP99Ms       = 0;
+
     static constexpr const char* _rgFunctionSettingsKey[maxFunction] = {
         "RollAxis",
         "PitchAxis",
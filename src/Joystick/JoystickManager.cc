@@ -186,22 +186,36 @@ bool JoystickManager::setActiveJoystickName(const QString &name)
 void JoystickManager::_updateAvailableJoysticks()
 {
 #ifdef QGC_SDL_JOYSTICK
+    // Joystick input events are left in the queue for the input thread of the active joystick, if it runs
+    const Uint32 eventRanges[][2] = {
+        { SDL_FIRSTEVENT,               SDL_JOYAXISMOTION - 1 },
+        { SDL_JOYBUTTONUP + 1,          SDL_CONTROLLERAXISMOTION - 1 },
+        { SDL_CONTROLLERBUTTONUP + 1,   SDL_LASTEVENT },
+    };
+    SDL_PumpEvents();
+    if (!_activeJoystick || !_activeJoystick->isRunning()) {
+        // Nobody takes the input events, left queued they would fill the SDL queue and device events would be lost
+        SDL_FlushEvents(SDL_JOYAXISMOTION, SDL_JOYBUTTONUP);
+        SDL_FlushEvents(SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERBUTTONUP);
+    }
     SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        switch(event.type) {
-        case SDL_QUIT:
-            qCDebug(JoystickManagerLog) << "SDL ERROR:" << SDL_GetError();
-            break;
-        case SDL_JOYDEVICEADDED:
-            qCDebug(JoystickManagerLog) << "Joystick added:" << event.jdevice.which;
-            _setActiveJoystickFromSettings();
-            break;
-        case SDL_JOYDEVICEREMOVED:
-            qCDebug(JoystickManagerLog) << "Joystick removed:" << event.jdevice.which;
-            _setActiveJoystickFromSettings();
-            break;
-        default:
-            break;
+    for (const auto& eventRange : eventRanges) {
+        while (SDL_PeepEvents(&event, 1, SDL_GETEVENT, eventRange[0], eventRange[1]) > 0) {
+            switch(event.type) {
+            case SDL_QUIT:
+                qCDebug(JoystickManagerLog) << "SDL ERROR:" << SDL_GetError();
+                break;
+            case SDL_JOYDEVICEADDED:
+                qCDebug(JoystickManagerLog) << "Joystick added:" << event.jdevice.which;
+                _setActiveJoystickFromSettings();
+                break;
+            case SDL_JOYDEVICEREMOVED:
+                qCDebug(JoystickManagerLog) << "Joystick removed:" << event.jdevice.which;
+                _setActiveJoystickFromSettings();
+                break;
+            default:
+                break;
+            }
         }
     }
 #elif defined(Q_OS_ANDROID)
@@ -14,6 +14,7 @@
 #include <QtCore/QTextStream>
 #include <QtCore/QFile>
 #include <QtCore/QIODevice>
+#include <QtCore/QThread>
 
 JoystickSDL::JoystickSDL(const QString& name, int axisCount, int buttonCount, int hatCount, int index, bool isGameController)
     : Joystick(name,axisCount,buttonCount,hatCount)
@@ -133,6 +134,12 @@ bool JoystickSDL::_open(void) {
         return false;
     }
 
+    _instanceId = SDL_JoystickInstanceID(sdlJoystick);
+
+    // Input events queued before the input thread started are stale, they must not count as input or latency samples
+    SDL_FlushEvents(SDL_JOYAXISMOTION, SDL_JOYBUTTONUP);
+    SDL_FlushEvents(SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERBUTTONUP);
+
     qCDebug(JoystickLog) << "Opened joystick at" << sdlJoystick;
 
     return true;
@@ -154,6 +161,11 @@ void JoystickSDL::_close(void) {
 
     sdlJoystick   = nullptr;
     sdlController = nullptr;
+    _instanceId   = -1;
+
+    // Input events still queued belong to the closed joystick
+    SDL_FlushEvents(SDL_JOYAXISMOTION, SDL_JOYBUTTONUP);
+    SDL_FlushEvents(SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERBUTTONUP);
 }
 
 bool JoystickSDL::_update(void)
@@ -166,6 +178,83 @@ bool JoystickSDL::_update(void)
     return true;
 }
 
+// SDL2 has no blocking wait for joystick input: joystick events are only generated by pumping, and without the video
+// subsystem SDL_WaitEventTimeout pumps and sleeps a millisecond in a loop, taking every event type off the queue.
+// So this still polls, every kPumpIntervalUs, but only takes the input events off the queue, the device events are
+// left for JoystickManager. Event timestamps are SDL ticks, input times are only good to a millisecond.
+int JoystickSDL::_waitForInput(int timeoutMs, qint64& inputNs)
+{
+    QElapsedTimer waitTime;
+    waitTime.start();
+    forever {
+        SDL_PumpEvents();
+        const int changes = _takeInputEvents(inputNs);
+        if (changes || (waitTime.elapsed() >= timeoutMs)) {
+            return changes;
+        }
+        QThread::usleep(kPumpIntervalUs);
+    }
+}
+
+int JoystickSDL::_takeInputEvents(qint64& inputNs)
+{
+    const Uint32 nowTicks = SDL_GetTicks();
+    const qint64 nowNs = _inputClock.nsecsElapsed();
+
+    int changes = 0;
+    const Uint32 eventRanges[][2] = {
+        { SDL_JOYAXISMOTION,        SDL_JOYBUTTONUP },
+        { SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERBUTTONUP },
+    };
+    for (const auto& eventRange : eventRanges) {
+        SDL_Event events[kMaxEvents];
+        int count;
+        do {
+            count = SDL_PeepEvents(events, kMaxEvents, SDL_GETEVENT, eventRange[0], eventRange[1]);
+            for (int i = 0; i < count; i++) {
+                const SDL_Event& event = events[i];
+                SDL_JoystickID which;
+                int change;
+                switch (event.type) {
+                case SDL_JOYAXISMOTION:
+                    which = event.jaxis.which;
+                    change = InputAxes;
+                    break;
+                case SDL_JOYHATMOTION:
+                    which = event.jhat.which;
+                    change = InputButtons;
+                    break;
+                case SDL_JOYBUTTONDOWN:
+                case SDL_JOYBUTTONUP:
+                    which = event.jbutton.which;
+                    change = InputButtons;
+                    break;
+                case SDL_CONTROLLERAXISMOTION:
+                    which = event.caxis.which;
+                    change = InputAxes;
+                    break;
+                case SDL_CONTROLLERBUTTONDOWN:
+                case SDL_CONTROLLERBUTTONUP:
+                    which = event.cbutton.which;
+                    change = InputButtons;
+                    break;
+                default:
+                    continue;
+                }
+                if (which != _instanceId) {
+                    continue;
+                }
+                // Event timestamps are SDL ticks in milliseconds
+                const qint64 eventNs = qMax<qint64>(0, nowNs - (static_cast<qint64>(static_cast<Uint32>(nowTicks - event.common.timestamp)) * 1000000));
+                inputNs = changes ? qMin(inputNs, eventNs) : eventNs;
+                changes |= change;
+            }
+        } while (count == kMaxEvents);
+    }
+
+    return changes;
+}
+
 bool JoystickSDL::_getButton(int i) {
     if (_isGameController) {
         return SDL_GameControllerGetButton(sdlController, SDL_GameControllerButton(i)) == 1;
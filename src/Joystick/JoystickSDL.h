@@ -47,10 +47,18 @@ private:
     int  _getAxis   (int i) final;
     bool _getHat    (int hat,int i) final;
 
+    bool _eventDriven   () const final { return true; }
+    int  _waitForInput  (int timeoutMs, qint64& inputNs) final;
+    int  _takeInputEvents(qint64& inputNs);
+
     SDL_Joystick*       sdlJoystick;
     SDL_GameController* sdlController;
 
     bool    _isGameController;
     int     _index;      ///< Index for SDL_JoystickOpen
+    SDL_JoystickID _instanceId = -1;    ///< Id of the open joystick in its events
+
+    static constexpr int kPumpIntervalUs = 2000;  ///< The poll interval the joystick thread had before it read events
+    static constexpr int kMaxEvents = 32;
 
 };
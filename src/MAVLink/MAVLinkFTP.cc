@@ -9,6 +9,8 @@
 
 #include "MAVLinkFTP.h"
 
+#include <array>
+
 QString MavlinkFTP::opCodeToString(OpCode_t opCode)
 {
     switch (opCode) {
@@ -83,3 +85,24 @@ QString MavlinkFTP::errorCodeToString(ErrorCode_t errorCode)
     return "Unknown Error";
 }
 
+
+uint32_t MavlinkFTP::crc32(const uint8_t* src, size_t len, uint32_t crc)
+{
+    static const auto crcTable = []() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < table.size(); i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+            }
+            table[i] = value;
+        }
+        return table;
+    }();
+
+    for (size_t i = 0; i < len; i++) {
+        crc = crcTable[(crc ^ src[i]) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
@@ -90,4 +90,8 @@ public:
 
     static QString opCodeToString   (OpCode_t opCode);
     static QString errorCodeToString(ErrorCode_t errorCode);
+
+    /// CRC32 as returned by kCmdCalcFileCRC32 (no initial or final inversion)
+    ///     @param crc CRC of the preceding parts of the file, 0 for the first part
+    static uint32_t crc32(const uint8_t* src, size_t len, uint32_t crc = 0);
 };
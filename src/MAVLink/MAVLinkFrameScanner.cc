@@ -0,0 +1,157 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkFrameScanner.h"
+#include "QGCLoggingCategory.h"
+
+#include <cstring>
+
+QGC_LOGGING_CATEGORY(MAVLinkFrameScannerLog, "qgc.mavlink.mavlinkframescanner")
+
+MAVLinkFrameScanner::MAVLinkFrameScanner(uint8_t channel, QByteArrayView data)
+    : _channel(channel)
+    , _status(mavlink_get_channel_status(channel))
+    , _data(reinterpret_cast<const uint8_t*>(data.data()))
+    , _size(data.size())
+{
+    Q_ASSERT(_status);
+}
+
+bool MAVLinkFrameScanner::next(mavlink_message_t &message)
+{
+    while (_index < _size) {
+        // The per-byte state machine owns the bytes until it is back to idle
+        if (_bytewiseOnly || (_index < _bytewiseEnd) || (_status->parse_state > MAVLINK_PARSE_STATE_IDLE)) {
+            if (_parseBytewise(message)) {
+                return true;
+            }
+            continue;
+        }
+
+        // Bytes outside of a frame are ignored by the state machine while idle, skip straight to the next STX
+        const uint8_t *const end = _data + _size;
+        const uint8_t *stx = _data + _index;
+        while ((stx < end) && (*stx != MAVLINK_STX) && (*stx != MAVLINK_STX_MAVLINK1)) {
+            ++stx;
+        }
+        _index = stx - _data;
+
+        if ((_index < _size) && _parseFrame(message)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Validates and decodes the frame starting at the STX at _index. If the frame can't be handled in bulk the
+/// bytes are marked for the per-byte state machine instead and false is returned.
+bool MAVLinkFrameScanner::_parseFrame(mavlink_message_t &message)
+{
+    const uint8_t *const frame = _data + _index;
+    const qsizetype remaining = _size - _index;
+    const bool mavlink1 = (frame[0] == MAVLINK_STX_MAVLINK1);
+    const qsizetype headerLen = mavlink1 ? kV1HeaderLen : kV2HeaderLen;
+
+    if (remaining < headerLen) {
+        // Frame continues in the next buffer
+        _bytewiseEnd = _size;
+        return false;
+    }
+
+    const uint8_t payloadLen = frame[1];
+    const uint8_t incompatFlags = mavlink1 ? 0 : frame[2];
+    if ((incompatFlags != 0) || _status->signing) {
+        // Signatures and unknown incompat flags are handled by the state machine
+        _bytewiseEnd = _index + 1;
+        return false;
+    }
+
+    const qsizetype frameLen = headerLen + payloadLen + kChecksumLen;
+    if (remaining < frameLen) {
+        _bytewiseEnd = _size;
+        return false;
+    }
+
+    const uint32_t msgid = mavlink1 ? frame[5] : (frame[7] | (frame[8] << 8) | (frame[9] << 16));
+    const mavlink_msg_entry_t *const entry = mavlink_get_msg_entry(msgid);
+    const uint8_t crcExtra = entry ? entry->crc_extra : 0;
+
+    uint16_t crc;
+    crc_init(&crc);
+    crc_accumulate_buffer(&crc, reinterpret_cast<const char*>(frame + 1), static_cast<uint16_t>(headerLen - 1 + payloadLen));
+    crc_accumulate(crcExtra, &crc);
+
+    const uint8_t *const ck = frame + headerLen + payloadLen;
+    if ((ck[0] != (crc & 0xFF)) || (ck[1] != (crc >> 8))) {
+        // Could be a false STX inside other data. Let the state machine consume it so resync and error
+        // counting match the per-byte path exactly.
+        qCDebug(MAVLinkFrameScannerLog) << "Bad CRC, msgid:" << msgid << "channel:" << _channel;
+        _bytewiseEnd = _index + 1;
+        return false;
+    }
+
+    message.checksum = crc;
+    message.magic = frame[0];
+    message.len = payloadLen;
+    message.incompat_flags = incompatFlags;
+    message.compat_flags = mavlink1 ? 0 : frame[3];
+    message.seq = mavlink1 ? frame[2] : frame[4];
+    message.sysid = mavlink1 ? frame[3] : frame[5];
+    message.compid = mavlink1 ? frame[4] : frame[6];
+    message.msgid = msgid;
+
+    char *const payload = _MAV_PAYLOAD_NON_CONST(&message);
+    (void) memcpy(payload, frame + headerLen, payloadLen);
+    if (entry && (payloadLen < entry->max_msg_len)) {
+        // Same zero-fill of truncated MAVLink 2 payloads as the state machine
+        (void) memset(payload + payloadLen, 0, entry->max_msg_len - payloadLen);
+    }
+    message.ck[0] = ck[0];
+    message.ck[1] = ck[1];
+
+    // Keep the channel status identical to what mavlink_parse_char would have produced
+    if (mavlink1) {
+        _status->flags |= MAVLINK_STATUS_FLAG_IN_MAVLINK1;
+    } else {
+        _status->flags &= ~MAVLINK_STATUS_FLAG_IN_MAVLINK1;
+    }
+    _status->current_rx_seq = message.seq;
+    if (_status->packet_rx_success_count == 0) {
+        _status->packet_rx_drop_count = 0;
+    }
+    _status->packet_rx_success_count++;
+
+    _index += frameLen;
+    _bulkFrameCount++;
+
+    return true;
+}
+
+/// Feeds bytes through mavlink_parse_char until a message completes or the state machine no longer owns the
+/// remaining bytes.
+bool MAVLinkFrameScanner::_parseBytewise(mavlink_message_t &message)
+{
+    mavlink_status_t status;
+
+    while (_index < _size) {
+        const uint8_t byte = _data[_index++];
+        _bytewiseByteCount++;
+
+        if (mavlink_parse_char(_channel, byte, &message, &status) == MAVLINK_FRAMING_OK) {
+            return true;
+        }
+
+        if (!_bytewiseOnly && (_index >= _bytewiseEnd) && (_status->parse_state <= MAVLINK_PARSE_STATE_IDLE)) {
+            break;
+        }
+    }
+
+    return false;
+}
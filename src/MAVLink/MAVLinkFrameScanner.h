@@ -0,0 +1,66 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArrayView>
+#include <QtCore/QLoggingCategory>
+
+#include "MAVLinkLib.h"
+
+Q_DECLARE_LOGGING_CATEGORY(MAVLinkFrameScannerLog)
+
+/// Bulk MAVLink frame scanner for a single receive buffer.
+/// Frames which are fully contained in the buffer are located by their STX marker, sized from the header and
+/// checked with a single CRC pass over the whole frame. Anything the fast path can't prove identical to the
+/// mavlink_parse_char state machine (frames split across buffers, signed frames, signing enabled on the channel,
+/// bad CRCs, unknown incompat flags) is fed through mavlink_parse_char byte by byte, so channel status, parse
+/// error counts and signing behave exactly as before.
+class MAVLinkFrameScanner
+{
+public:
+    /// Constructs a scanner over the specified buffer. The buffer must outlive the scanner.
+    ///     @param channel MAVLink channel the bytes were received on
+    ///     @param data Received bytes
+    MAVLinkFrameScanner(uint8_t channel, QByteArrayView data);
+
+    /// Decodes the next message from the buffer
+    ///     @param message Filled in with the decoded message
+    ///     @return true: message was decoded, false: buffer exhausted
+    bool next(mavlink_message_t &message);
+
+    /// Forces all bytes through mavlink_parse_char. Only used to compare/benchmark against the reference parser.
+    void setBytewiseOnly(bool bytewiseOnly) { _bytewiseOnly = bytewiseOnly; }
+
+    /// @return Number of messages decoded through the bulk path
+    quint64 bulkFrameCount() const { return _bulkFrameCount; }
+
+    /// @return Number of bytes fed to the per-byte state machine
+    quint64 bytewiseByteCount() const { return _bytewiseByteCount; }
+
+private:
+    bool _parseFrame(mavlink_message_t &message);
+    bool _parseBytewise(mavlink_message_t &message);
+
+    const uint8_t _channel;
+    mavlink_status_t *const _status;
+    const uint8_t *const _data;
+    const qsizetype _size;
+
+    qsizetype _index = 0;
+    qsizetype _bytewiseEnd = 0;  ///< Bytes up to this index must go through mavlink_parse_char
+    bool _bytewiseOnly = false;
+
+    quint64 _bulkFrameCount = 0;
+    quint64 _bytewiseByteCount = 0;
+
+    static constexpr qsizetype kV1HeaderLen = 6;                                        ///< STX, len, seq, sysid, compid, msgid
+    static constexpr qsizetype kV2HeaderLen = MAVLINK_NUM_HEADER_BYTES;                 ///< STX + MAVLINK_CORE_HEADER_LEN
+    static constexpr qsizetype kChecksumLen = MAVLINK_NUM_CHECKSUM_BYTES;
+};
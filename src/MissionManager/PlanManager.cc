@@ -13,8 +13,13 @@
 #include "MAVLinkProtocol.h"
 #include "QGCApplication.h"
 #include "MissionCommandTree.h"
+#include "FTPManager.h"
 #include "QGCLoggingCategory.h"
 
+#include <QtCore/QFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QtEndian>
+
 QGC_LOGGING_CATEGORY(PlanManagerLog, "PlanManagerLog")
 
 PlanManager::PlanManager(Vehicle* vehicle, MAV_MISSION_TYPE planType)
@@ -29,6 +34,7 @@ PlanManager::PlanManager(Vehicle* vehicle, MAV_MISSION_TYPE planType)
     , _missionItemCountToRead   (-1)
     , _currentMissionIndex      (-1)
     , _lastCurrentIndex         (-1)
+    , _tryftp                   (vehicle->apmFirmware())
 {
     _ackTimeoutTimer = new QTimer(this);
     _ackTimeoutTimer->setSingleShot(true);
@@ -139,9 +145,168 @@ void PlanManager::loadFromVehicle(void)
     _retryCount = 0;
     _setTransactionInProgress(TransactionRead);
     _connectToMavlink();
+    if (!_requestListFTP()) {
+        _requestList();
+    }
+}
+
+/// Starts reading the whole plan as a single file through MAVLink FTP
+/// @return false: FTP is not available, the item protocol has to be used
+bool PlanManager::_requestListFTP(void)
+{
+    if (!_tryftp) {
+        return false;
+    }
+    if (!(_vehicle->capabilityBits() & MAV_PROTOCOL_CAPABILITY_FTP)) {
+        qCDebug(PlanManagerLog) << QStringLiteral("_requestListFTP %1 vehicle does not support FTP, using mission protocol").arg(_planTypeString());
+        _tryftp = false;
+        return false;
+    }
+
+    SharedLinkInterfacePtr sharedLink = _vehicle->vehicleLinkManager()->primaryLink().lock();
+    if (!sharedLink || sharedLink->linkConfiguration()->isHighLatency()) {
+        return false;
+    }
+
+    QString fileName;
+    switch (_planType) {
+    case MAV_MISSION_TYPE_MISSION:
+        fileName = QStringLiteral("mission.dat");
+        break;
+    case MAV_MISSION_TYPE_FENCE:
+        fileName = QStringLiteral("fence.dat");
+        break;
+    case MAV_MISSION_TYPE_RALLY:
+        fileName = QStringLiteral("rally.dat");
+        break;
+    default:
+        return false;
+    }
+
+    _clearMissionItems();
+
+    FTPManager* ftpManager = _vehicle->ftpManager();
+    connect(ftpManager, &FTPManager::downloadComplete, this, &PlanManager::_ftpDownloadComplete);
+    // The file is generated on the fly by the vehicle, so the size from the open response is not checked
+    if (!ftpManager->download(MAV_COMP_ID_AUTOPILOT1, QStringLiteral("@MISSION/") + fileName,
+                              QStandardPaths::writableLocation(QStandardPaths::TempLocation),
+                              _missionFileName(), false /* No filesize check */)) {
+        qCDebug(PlanManagerLog) << QStringLiteral("_requestListFTP %1 FTPManager busy, using mission protocol").arg(_planTypeString());
+        disconnect(ftpManager, &FTPManager::downloadComplete, this, &PlanManager::_ftpDownloadComplete);
+        return false;
+    }
+    connect(ftpManager, &FTPManager::commandProgress, this, &PlanManager::_ftpDownloadProgress);
+
+    qCDebug(PlanManagerLog) << QStringLiteral("_requestListFTP %1").arg(_planTypeString()) << fileName;
+
+    return true;
+}
+
+/// Local name of the downloaded plan file, unique per vehicle and plan type
+QString PlanManager::_missionFileName(void)
+{
+    return QStringLiteral("qgc-plan-%1-%2.dat").arg(_vehicle->id()).arg(_planType);
+}
+
+void PlanManager::_ftpDownloadComplete(const QString& fileName, const QString& errorMsg)
+{
+    FTPManager* ftpManager = _vehicle->ftpManager();
+    disconnect(ftpManager, &FTPManager::downloadComplete, this, &PlanManager::_ftpDownloadComplete);
+    disconnect(ftpManager, &FTPManager::commandProgress, this, &PlanManager::_ftpDownloadProgress);
+
+    if (_transactionInProgress != TransactionRead) {
+        QFile::remove(fileName);
+        return;
+    }
+
+    if (errorMsg.isEmpty()) {
+        const bool parsed = _parseMissionFile(fileName);
+        QFile::remove(fileName);
+        if (parsed) {
+            qCDebug(PlanManagerLog) << QStringLiteral("_ftpDownloadComplete %1 count:").arg(_planTypeString()) << _missionItems.count();
+            _finishTransaction(true);
+            return;
+        }
+        // The vehicle serves a format we don't understand, trying again won't help
+        qCWarning(PlanManagerLog) << QStringLiteral("_ftpDownloadComplete %1 invalid plan file, using mission protocol").arg(_planTypeString());
+        _tryftp = false;
+    } else if (errorMsg.contains("No Sessions Available")) {
+        // Other transfers hold all sessions, FTP may work next time
+        qCDebug(PlanManagerLog) << QStringLiteral("_ftpDownloadComplete %1 no FTP session available, using mission protocol").arg(_planTypeString());
+    } else {
+        // No plan file, an unsupported opcode or a timeout: every later read would fail the same way, after waiting
+        // for the timeout again
+        qCDebug(PlanManagerLog) << QStringLiteral("_ftpDownloadComplete %1 download failed, using mission protocol from now on:").arg(_planTypeString()) << errorMsg;
+        _tryftp = false;
+    }
+
+    _clearMissionItems();
+    _retryCount = 0;
     _requestList();
 }
 
+void PlanManager::_ftpDownloadProgress(float progress)
+{
+    emit progressPctChanged(static_cast<double>(progress));
+}
+
+/// Decodes a plan file downloaded from @MISSION into _missionItems
+/// @return false: the file is invalid, _missionItems is left empty
+bool PlanManager::_parseMissionFile(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(PlanManagerLog) << "_parseMissionFile open failed" << fileName << file.errorString();
+        return false;
+    }
+    const QByteArray bytes = file.readAll();
+    const uchar* data = reinterpret_cast<const uchar*>(bytes.constData());
+
+    if (bytes.size() < kMissionFileHeaderSize) {
+        qCWarning(PlanManagerLog) << "_parseMissionFile file too short" << bytes.size();
+        return false;
+    }
+
+    const quint16 magic     = qFromLittleEndian<quint16>(data);
+    const quint16 dataType  = qFromLittleEndian<quint16>(data + 2);
+    const quint16 start     = qFromLittleEndian<quint16>(data + 6);
+    const quint16 numItems  = qFromLittleEndian<quint16>(data + 8);
+    if ((magic != kMissionFileMagic) || (dataType != _planType) || (start != 0)) {
+        qCWarning(PlanManagerLog) << "_parseMissionFile bad header magic:type:start" << magic << dataType << start;
+        return false;
+    }
+    if (bytes.size() < (kMissionFileHeaderSize + (static_cast<qint64>(numItems) * kMissionFileItemSize))) {
+        qCWarning(PlanManagerLog) << "_parseMissionFile truncated file size:count" << bytes.size() << numItems;
+        return false;
+    }
+
+    _clearMissionItems();
+    _missionItems.reserve(numItems);
+    for (int i=0; i<numItems; i++) {
+        const uchar* record = data + kMissionFileHeaderSize + (i * kMissionFileItemSize);
+
+        // MISSION_ITEM_INT payload in wire order
+        mavlink_mission_item_int_t missionItem{};
+        missionItem.param1          = qFromLittleEndian<float>(record);
+        missionItem.param2          = qFromLittleEndian<float>(record + 4);
+        missionItem.param3          = qFromLittleEndian<float>(record + 8);
+        missionItem.param4          = qFromLittleEndian<float>(record + 12);
+        missionItem.x               = qFromLittleEndian<qint32>(record + 16);
+        missionItem.y               = qFromLittleEndian<qint32>(record + 20);
+        missionItem.z               = qFromLittleEndian<float>(record + 24);
+        missionItem.seq             = start + i;
+        missionItem.command         = qFromLittleEndian<quint16>(record + 30);
+        missionItem.frame           = record[34];
+        missionItem.current         = record[35];
+        missionItem.autocontinue    = record[36];
+        missionItem.mission_type    = _planType;
+
+        _missionItems.append(_createMissionItem(missionItem));
+    }
+
+    return true;
+}
+
 /// Internal call to request list of mission items. May be called during a retry sequence.
 void PlanManager::_requestList(void)
 {
@@ -375,16 +540,10 @@ void PlanManager::_requestNextMissionItem(void)
 void PlanManager::_handleMissionItem(const mavlink_message_t& message)
 {
     MAV_CMD          command;
-    MAV_FRAME        frame;
     MAV_MISSION_TYPE missionType;
-    double           param1;
-    double           param2;
-    double           param3;
-    double           param4;
     double           param5;
     double           param6;
     double           param7;
-    bool             autoContinue;
     bool             isCurrentItem;
     int              seq;
 
@@ -392,16 +551,10 @@ void PlanManager::_handleMissionItem(const mavlink_message_t& message)
     mavlink_msg_mission_item_int_decode(&message, &missionItem);
 
     command =       (MAV_CMD)missionItem.command;
-    frame =         (MAV_FRAME)missionItem.frame;
     missionType =   (MAV_MISSION_TYPE)missionItem.mission_type;
-    param1 =        missionItem.param1;
-    param2 =        missionItem.param2;
-    param3 =        missionItem.param3;
-    param4 =        missionItem.param4;
     param5 =        missionItem.frame == MAV_FRAME_MISSION ? (double)missionItem.x : (double)missionItem.x * 1e-7;
     param6 =        missionItem.frame == MAV_FRAME_MISSION ? (double)missionItem.y : (double)missionItem.y * 1e-7;
     param7 =        (double)missionItem.z;
-    autoContinue =  missionItem.autocontinue;
     isCurrentItem = missionItem.current;
     seq =           missionItem.seq;
 
@@ -412,13 +565,6 @@ void PlanManager::_handleMissionItem(const mavlink_message_t& message)
        return;
     }
 
-    // We don't support editing ALT_INT frames so change on the way in.
-    if (frame == MAV_FRAME_GLOBAL_INT) {
-        frame = MAV_FRAME_GLOBAL;
-    } else if (frame == MAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
-        frame = MAV_FRAME_GLOBAL_RELATIVE_ALT;
-    }
-
     bool ardupilotHomePositionUpdate = false;
     if (!_checkForExpectedAck(AckMissionItem)) {
         if (_vehicle->apmFirmware() && seq ==  0 && _planType == MAV_MISSION_TYPE_MISSION) {
@@ -439,27 +585,7 @@ void PlanManager::_handleMissionItem(const mavlink_message_t& message)
     
     if (_itemIndicesToRead.contains(seq)) {
         _itemIndicesToRead.removeOne(seq);
-
-        MissionItem* item = new MissionItem(seq,
-                                            command,
-                                            frame,
-                                            param1,
-                                            param2,
-                                            param3,
-                                            param4,
-                                            param5,
-                                            param6,
-                                            param7,
-                                            autoContinue,
-                                            isCurrentItem,
-                                            this);
-
-        if (item->command() == MAV_CMD_DO_JUMP && !_vehicle->firmwarePlugin()->sendHomePositionToVehicle()) {
-            // Home is in position 0
-            item->setParam1((int)item->param1() + 1);
-        }
-
-        _missionItems.append(item);
+        _missionItems.append(_createMissionItem(missionItem));
     } else {
         qCDebug(PlanManagerLog) << QStringLiteral("_handleMissionItem %1 mission item received item index which was not requested, disregrarding:").arg(_planTypeString()) << seq;
         // We have to put the ack timeout back since it was removed above
@@ -477,6 +603,40 @@ void PlanManager::_handleMissionItem(const mavlink_message_t& message)
     }
 }
 
+/// Creates the MissionItem for an item read from the vehicle, by the mission protocol or from a plan file
+MissionItem* PlanManager::_createMissionItem(const mavlink_mission_item_int_t& missionItem)
+{
+    MAV_FRAME frame = (MAV_FRAME)missionItem.frame;
+
+    // We don't support editing ALT_INT frames so change on the way in.
+    if (frame == MAV_FRAME_GLOBAL_INT) {
+        frame = MAV_FRAME_GLOBAL;
+    } else if (frame == MAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
+        frame = MAV_FRAME_GLOBAL_RELATIVE_ALT;
+    }
+
+    MissionItem* item = new MissionItem(missionItem.seq,
+                                        (MAV_CMD)missionItem.command,
+                                        frame,
+                                        missionItem.param1,
+                                        missionItem.param2,
+                                        missionItem.param3,
+                                        missionItem.param4,
+                                        missionItem.frame == MAV_FRAME_MISSION ? (double)missionItem.x : (double)missionItem.x * 1e-7,
+                                        missionItem.frame == MAV_FRAME_MISSION ? (double)missionItem.y : (double)missionItem.y * 1e-7,
+                                        (double)missionItem.z,
+                                        missionItem.autocontinue,
+                                        missionItem.current,
+                                        this);
+
+    if (item->command() == MAV_CMD_DO_JUMP && !_vehicle->firmwarePlugin()->sendHomePositionToVehicle()) {
+        // Home is in position 0
+        item->setParam1((int)item->param1() + 1);
+    }
+
+    return item;
+}
+
 void PlanManager::_clearMissionItems(void)
 {
     _itemIndicesToRead.clear();
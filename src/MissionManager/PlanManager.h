@@ -88,6 +88,8 @@ signals:
 private slots:
     void _mavlinkMessageReceived(const mavlink_message_t& message);
     void _ackTimeout(void);
+    void _ftpDownloadComplete(const QString& fileName, const QString& errorMsg);
+    void _ftpDownloadProgress(float progress);
 
 protected:
     typedef enum {
@@ -120,6 +122,10 @@ protected:
     QString _missionResultToString(MAV_MISSION_RESULT result);
     void _finishTransaction(bool success, bool apmGuidedItemWrite = false);
     void _requestList(void);
+    bool _requestListFTP(void);
+    bool _parseMissionFile(const QString& fileName);
+    MissionItem* _createMissionItem(const mavlink_mission_item_int_t& missionItem);
+    QString _missionFileName(void);
     void _writeMissionCount(void);
     void _writeMissionItemsWorker(void);
     void _clearAndDeleteMissionItems(void);
@@ -149,7 +155,15 @@ protected:
     QList<MissionItem*> _writeMissionItems;     ///< Set of mission items currently being written to vehicle
     int                 _currentMissionIndex;
     int                 _lastCurrentIndex;
+    bool                _tryftp;                ///< Read the plan through MAVLink FTP before falling back to the item protocol, cleared once FTP failed
 
 private:
     void _setTransactionInProgress(TransactionType_t type);
+
+    /// ArduPilot serves the items of each plan type as @MISSION/<type>.dat: a header of magic (2), MAV_MISSION_TYPE (2),
+    /// options (2), first item index (2) and item count (2), followed by one MISSION_ITEM_INT payload per item. All
+    /// values are little-endian.
+    static constexpr quint16    kMissionFileMagic       = 0x763d;
+    static constexpr int        kMissionFileHeaderSize  = 10;
+    static constexpr int        kMissionFileItemSize    = MAVLINK_MSG_ID_MISSION_ITEM_INT_LEN;
 };
@@ -69,6 +69,7 @@ Rectangle {
                 ListElement { text: "2x";   value: 2 }
                 ListElement { text: "5x";   value: 5 }
                 ListElement { text: "10x";  value: 10 }
+                ListElement { text: "Max";  value: 0 }
             }
 
             onActivated: (index) => { controller.playbackSpeed = model.get(currentIndex).value }
@@ -21,7 +21,8 @@ ChartView {
     margins.top:        chartHeader.height + (ScreenTools.defaultFontPixelHeight * 2)
 
     property var chartController:   null
-    property var seriesColors:      ["#00E04B","#DE8500","#F32836","#BFBFBF","#536DFF","#EECC44"]
+    property var seriesColors:      ["#00E04B","#DE8500","#F32836","#BFBFBF","#536DFF","#EECC44",
+                                     "#00BFBF","#B45CFF","#FF6EC7","#8FD14F","#FFA07A","#4FC3F7"]
 
     function addDimension(field) {
         if(!chartController) {
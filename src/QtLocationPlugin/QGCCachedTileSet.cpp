@@ -31,6 +31,8 @@
 
 #include <QtNetwork/QNetworkProxy>
 
+#include <limits>
+
 QGC_LOGGING_CATEGORY(QGCCachedTileSetLog, "qgc.qtlocation.qgccachedtileset")
 
 QGCCachedTileSet::QGCCachedTileSet(const QString &name, QObject *parent)
@@ -38,6 +40,9 @@ QGCCachedTileSet::QGCCachedTileSet(const QString &name, QObject *parent)
     , _name(name)
 {
     // qCDebug(QGCCachedTileSetLog) << Q_FUNC_INFO << this;
+
+    _backoffTimer.setSingleShot(true);
+    (void) connect(&_backoffTimer, &QTimer::timeout, this, &QGCCachedTileSet::_prepareDownload);
 }
 
 QGCCachedTileSet::~QGCCachedTileSet()
@@ -69,6 +74,10 @@ void QGCCachedTileSet::createDownloadTask()
         setErrorCount(0);
         setDownloading(true);
         _noMoreTiles = false;
+        // Starts from what the provider allows and adapts to how the server responds
+        _limiter.reset(static_cast<int>(QGeoTileFetcherQGC::concurrentDownloads(_type)));
+        _downloadClock.start();
+        _lastStatsMs = 0;
     }
 
     QGCGetTileDownloadListTask* const task = new QGCGetTileDownloadListTask(_id, kTileBatchSize);
@@ -95,6 +104,12 @@ void QGCCachedTileSet::resumeDownloadTask()
 void QGCCachedTileSet::cancelDownloadTask()
 {
     _cancelPending = true;
+
+    // Nothing in flight to finish the cancel while backing off
+    if (_backoffTimer.isActive()) {
+        _backoffTimer.stop();
+        _prepareDownload();
+    }
 }
 
 void QGCCachedTileSet::_tileListFetched(const QQueue<QGCTile*> &tiles)
@@ -105,7 +120,7 @@ void QGCCachedTileSet::_tileListFetched(const QQueue<QGCTile*> &tiles)
     }
 
     if (tiles.isEmpty()) {
-        _doneWithDownload();
+        _prepareDownload();
         return;
     }
 
@@ -138,47 +153,81 @@ void QGCCachedTileSet::_doneWithDownload()
         setUniqueTileSize(_uniqueTileCount * avg);
     }
 
+    _backoffTimer.stop();
     setDownloading(false);
+    _updateDownloadStats(true);
 
     emit completeChanged();
 }
 
 void QGCCachedTileSet::_prepareDownload()
 {
-    if (_tilesToDownload.isEmpty()) {
-        if (_noMoreTiles) {
+    if (_cancelPending) {
+        // Tiles claimed but not requested go back to pending when the download is resumed
+        qDeleteAll(_tilesToDownload);
+        _tilesToDownload.clear();
+        _retryRequests.clear();
+        if (_replies.isEmpty()) {
+            setDownloading(false);
+        }
+        return;
+    }
+
+    if (_tilesToDownload.isEmpty() && _retryRequests.isEmpty()) {
+        if (!_noMoreTiles) {
+            if (!_batchRequested) {
+                createDownloadTask();
+            }
+        } else if (_replies.isEmpty()) {
             _doneWithDownload();
-        } else if (!_batchRequested) {
-            createDownloadTask();
         }
         return;
     }
 
-    for (qsizetype i = _replies.count(); i < QGeoTileFetcherQGC::concurrentDownloads(_type); i++) {
-        if (_tilesToDownload.isEmpty()) {
-            break;
+    const qint64 backoff = _limiter.backoffRemaining(_downloadClock.elapsed());
+    if (backoff > 0) {
+        if (!_backoffTimer.isActive()) {
+            _backoffTimer.start(static_cast<int>(backoff));
+        }
+        return;
+    }
+
+    while ((_replies.count() < _limiter.limit()) && (!_retryRequests.isEmpty() || !_tilesToDownload.isEmpty())) {
+        if (!_retryRequests.isEmpty()) {
+            _sendRequest(_retryRequests.dequeue());
+            continue;
         }
 
         QGCTile* const tile = _tilesToDownload.dequeue();
         const int mapId = UrlFactory::getQtMapIdFromProviderType(tile->type());
         QNetworkRequest request = QGeoTileFetcherQGC::getNetworkRequest(mapId, tile->x(), tile->y(), tile->z());
-        request.setOriginatingObject(this);
         request.setAttribute(QNetworkRequest::User, tile->hash());
+        delete tile;
 
-        QNetworkReply* const reply = _networkManager->get(request);
-        reply->setParent(this);
-        QGCFileDownload::setIgnoreSSLErrorsIfNeeded(*reply);
-        (void) connect(reply, &QNetworkReply::finished, this, &QGCCachedTileSet::_networkReplyFinished);
-        (void) connect(reply, &QNetworkReply::errorOccurred, this, &QGCCachedTileSet::_networkReplyError);
-        (void) _replies.insert(tile->hash(), reply);
+        _sendRequest(request);
+    }
 
-        delete tile;
-        if (!_batchRequested && !_noMoreTiles && (_tilesToDownload.count() < (QGeoTileFetcherQGC::concurrentDownloads(_type) * 10))) {
-            createDownloadTask();
-        }
+    if (!_batchRequested && !_noMoreTiles && (static_cast<uint32_t>(_tilesToDownload.count()) < (kTileBatchSize / 2))) {
+        createDownloadTask();
     }
 }
 
+void QGCCachedTileSet::_sendRequest(QNetworkRequest request)
+{
+    request.setOriginatingObject(this);
+
+    QNetworkReply* const reply = _networkManager->get(request);
+    reply->setParent(this);
+    QGCFileDownload::setIgnoreSSLErrorsIfNeeded(*reply);
+    // Latency is measured from when the request goes out, not from when it was queued in QNetworkAccessManager.
+    // Sent again after a redirect, the last request is the one answered.
+    (void) connect(reply, &QNetworkReply::requestSent, this, [this, reply]() {
+        (void) _dispatchedAt.insert(reply, _downloadClock.elapsed());
+    });
+    (void) connect(reply, &QNetworkReply::finished, this, &QGCCachedTileSet::_networkReplyFinished);
+    (void) _replies.insert(request.attribute(QNetworkRequest::User).toString(), reply);
+}
+
 void QGCCachedTileSet::_networkReplyFinished()
 {
     QNetworkReply* const reply = qobject_cast<QNetworkReply*>(QObject::sender());
@@ -188,32 +237,99 @@ void QGCCachedTileSet::_networkReplyFinished()
     }
     reply->deleteLater();
 
+    const qint64 sentMs = _dispatchedAt.value(reply, -1);
+    (void) _dispatchedAt.remove(reply);
+
+    const QString hash = reply->request().attribute(QNetworkRequest::User).toString();
+    if (_replies.remove(hash) == 0) {
+        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Reply not in list:" << hash;
+    }
+
     if (reply->error() != QNetworkReply::NoError) {
-        return;
+        _downloadFailed(reply, hash);
+    } else {
+        const QByteArray image = reply->readAll();
+        const qint64 now = _downloadClock.elapsed();
+        const qint64 latency = (sentMs < 0) ? -1 : (now - sentMs);
+        _limiter.requestSucceeded(now, latency, image.size(), _dispatchedAt.count() + 1);
+
+        if (!_cacheDownloadedTile(hash, image)) {
+            setErrorCount(_errorCount + 1);
+            if (!hash.isEmpty()) {
+                QGCUpdateTileDownloadStateTask* const task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateError, hash);
+                getQGCMapEngine()->addTask(task);
+            }
+        }
     }
 
-    if (!reply->isOpen()) {
-        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Reply";
+    _updateDownloadStats();
+    _prepareDownload();
+}
+
+void QGCCachedTileSet::_downloadFailed(QNetworkReply *reply, const QString &hash)
+{
+    const QNetworkReply::NetworkError error = reply->error();
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const qint64 now = _downloadClock.elapsed();
+
+    bool retry = false;
+    if ((status == 429) || (status == 503)) {
+        // Retry-After in seconds, the HTTP date form is left to the backoff
+        bool ok = false;
+        const qint64 retryAfter = reply->rawHeader(QByteArrayLiteral("Retry-After")).trimmed().toLongLong(&ok);
+        _limiter.requestThrottled(now, ok ? (retryAfter * 1000) : 0);
+        retry = true;
+    } else if (error != QNetworkReply::OperationCanceledError) {
+        _limiter.requestFailed(now);
+        switch (error) {
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::ProxyTimeoutError:
+        case QNetworkReply::UnknownNetworkError:
+            retry = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    QNetworkRequest request = reply->request();
+    const int retries = request.attribute(kRetryCountAttribute).toInt();
+    if (retry && (retries < kMaxRetries) && !hash.isEmpty()) {
+        qCDebug(QGCCachedTileSetLog) << "Retrying tile" << hash << "status:" << status << reply->errorString();
+        request.setAttribute(kRetryCountAttribute, retries + 1);
+        _retryRequests.enqueue(request);
         return;
     }
 
-    const QString hash = reply->request().attribute(QNetworkRequest::User).toString();
+    if (error != QNetworkReply::OperationCanceledError) {
+        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Error fetching tile" << hash << reply->errorString();
+    }
+
+    setErrorCount(_errorCount + 1);
+
     if (hash.isEmpty()) {
         qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Hash";
         return;
     }
 
-    if (_replies.contains(hash)) {
-        (void) _replies.remove(hash);
-    } else {
-        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Reply not in list: " << hash;
+    QGCUpdateTileDownloadStateTask* const task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateError, hash);
+    getQGCMapEngine()->addTask(task);
+}
+
+bool QGCCachedTileSet::_cacheDownloadedTile(const QString &hash, QByteArray image)
+{
+    if (hash.isEmpty()) {
+        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Hash";
+        return false;
     }
     qCDebug(QGCCachedTileSetLog) << "Tile fetched:" << hash;
 
-    QByteArray image = reply->readAll();
     if (image.isEmpty()) {
         qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Image";
-        return;
+        return false;
     }
 
     const QString type = UrlFactory::tileHashToType(hash);
@@ -225,14 +341,14 @@ void QGCCachedTileSet::_networkReplyFinished()
         image = elevationProvider->serialize(image);
         if (image.isEmpty()) {
             qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Failed to Serialize Terrain Tile";
-            return;
+            return false;
         }
     }
 
     const QString format = mapProvider->getImageFormat(image);
     if (format.isEmpty()) {
         qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Format";
-        return;
+        return false;
     }
 
     QGeoFileTileCacheQGC::cacheTile(type, hash, image, format, _id);
@@ -249,39 +365,41 @@ void QGCCachedTileSet::_networkReplyFinished()
         setUniqueTileSize(avg * _uniqueTileCount);
     }
 
-    _prepareDownload();
+    return true;
 }
 
-void QGCCachedTileSet::_networkReplyError(QNetworkReply::NetworkError error)
+void QGCCachedTileSet::_updateDownloadStats(bool force)
 {
-    QNetworkReply* const reply = qobject_cast<QNetworkReply*>(QObject::sender());
-    if (!reply) {
+    const qint64 now = _downloadClock.isValid() ? _downloadClock.elapsed() : 0;
+    if (!force && ((now - _lastStatsMs) < kStatsIntervalMs)) {
         return;
     }
-    qCDebug(QGCCachedTileSetLog) << Q_FUNC_INFO << "Error fetching tile" << reply->errorString();
+    _lastStatsMs = now;
 
-    setErrorCount(_errorCount + 1);
+    _tilesPerSecond = _limiter.tilesPerSecond(now);
+    const quint32 remaining = (_totalTileCount > _savedTileCount) ? (_totalTileCount - _savedTileCount) : 0;
+    const qint64 eta = _limiter.etaMs(remaining, now);
+    _etaSeconds = (eta < 0) ? -1 : static_cast<int>(qMin<qint64>(eta / 1000, std::numeric_limits<int>::max()));
 
-    const QString hash = reply->request().attribute(QNetworkRequest::User).toString();
-    if (hash.isEmpty()) {
-        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Hash";
-        return;
-    }
+    qCDebug(QGCCachedTileSetLog) << _name << "tiles/s:" << _tilesPerSecond << "limit:" << _limiter.limit() << "sent:" << _dispatchedAt.count()
+                                 << "latency ms:" << _limiter.latencyMs() << "base:" << _limiter.baseLatencyMs()
+                                 << "eta s:" << _etaSeconds;
 
-    if (_replies.contains(hash)) {
-        (void) _replies.remove(hash);
-    } else {
-        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Reply not in list:" << hash;
-    }
+    emit downloadStatsChanged();
+}
 
-    if (error != QNetworkReply::OperationCanceledError) {
-        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Error:" << reply->errorString();
+QString QGCCachedTileSet::downloadRateStr() const
+{
+    if (!_downloading || (_tilesPerSecond <= 0.)) {
+        return QString();
     }
 
-    QGCUpdateTileDownloadStateTask* const task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateError, hash);
-    getQGCMapEngine()->addTask(task);
+    QString rate = tr("%1 tiles/s").arg(_tilesPerSecond, 0, 'f', 1);
+    if (_etaSeconds >= 0) {
+        rate += tr(", %1 left").arg(QString::asprintf("%d:%02d:%02d", _etaSeconds / 3600, (_etaSeconds / 60) % 60, _etaSeconds % 60));
+    }
 
-    _prepareDownload();
+    return rate;
 }
 
 void QGCCachedTileSet::setSelected(bool sel)
@@ -19,12 +19,17 @@
 #pragma once
 
 #include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
 #include <QtCore/QQueue>
 #include <QtCore/QString>
+#include <QtCore/QTimer>
 #include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkRequest>
+
+#include "QGCTileDownloadLimiter.h"
 
 Q_DECLARE_LOGGING_CATEGORY(QGCCachedTileSetLog)
 
@@ -67,6 +72,10 @@ class QGCCachedTileSet : public QObject
     Q_PROPERTY(quint32      errorCount          READ    errorCount          NOTIFY errorCountChanged)
     Q_PROPERTY(QString      errorCountStr       READ    errorCountStr       NOTIFY errorCountChanged)
     Q_PROPERTY(bool         selected            READ    selected            WRITE  setSelected  NOTIFY selectedChanged)
+    Q_PROPERTY(double       tilesPerSecond      READ    tilesPerSecond      NOTIFY downloadStatsChanged)
+    Q_PROPERTY(int          etaSeconds          READ    etaSeconds          NOTIFY downloadStatsChanged)
+    Q_PROPERTY(int          concurrentDownloads READ    concurrentDownloads NOTIFY downloadStatsChanged)
+    Q_PROPERTY(QString      downloadRateStr     READ    downloadRateStr     NOTIFY downloadStatsChanged)
 
 public:
     explicit QGCCachedTileSet(const QString &name, QObject *parent = nullptr);
@@ -110,6 +119,10 @@ public:
     quint32 errorCount() const { return _errorCount; }
     QString errorCountStr() const;
     bool selected() const { return _selected; }
+    double tilesPerSecond() const { return _tilesPerSecond; }
+    int etaSeconds() const { return _etaSeconds; }   ///< -1: unknown
+    int concurrentDownloads() const { return _dispatchedAt.count(); }   ///< Requests sent and not yet answered
+    QString downloadRateStr() const;
 
     void setManager(QGCMapEngineManager *mgr) { _manager = mgr; }
     void setSelected(bool sel);
@@ -151,15 +164,19 @@ signals:
     void errorCountChanged();
     void selectedChanged();
     void nameChanged();
+    void downloadStatsChanged();
 
 private slots:
     void _tileListFetched(const QQueue<QGCTile*> &tiles);
     void _networkReplyFinished();
-    void _networkReplyError(QNetworkReply::NetworkError error);
+    void _prepareDownload();
 
 private:
-    void _prepareDownload();
     void _doneWithDownload();
+    void _sendRequest(QNetworkRequest request);
+    void _downloadFailed(QNetworkReply *reply, const QString &hash);
+    bool _cacheDownloadedTile(const QString &hash, QByteArray image);
+    void _updateDownloadStats(bool force = false);
 
     QString _name;
     QString _mapTypeStr;
@@ -188,9 +205,22 @@ private:
     QDateTime _creationDate;
 
     QHash<QString, QNetworkReply*> _replies;
+    QHash<QNetworkReply*, qint64> _dispatchedAt;   ///< Replies whose request has been sent, QNetworkAccessManager queues those beyond its connections per host
     QQueue<QGCTile*> _tilesToDownload;
+    QQueue<QNetworkRequest> _retryRequests;
     QGCMapEngineManager *_manager = nullptr;
     QNetworkAccessManager *_networkManager = nullptr;
 
-    static constexpr uint32_t kTileBatchSize = 256;
+    QGCTileDownloadLimiter _limiter;
+    QElapsedTimer _downloadClock;
+    QTimer _backoffTimer;
+    qint64 _lastStatsMs = 0;
+    double _tilesPerSecond = 0.;
+    int _etaSeconds = -1;
+
+    /// Tiles claimed from the database at once, the next batch is requested when half of it is left
+    static constexpr uint32_t kTileBatchSize = 2048;
+    static constexpr int kMaxRetries = 3;
+    static constexpr qint64 kStatsIntervalMs = 1000;
+    static constexpr QNetworkRequest::Attribute kRetryCountAttribute = static_cast<QNetworkRequest::Attribute>(QNetworkRequest::User + 2);
 };
@@ -0,0 +1,228 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCMBTiles.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+
+#include <atomic>
+
+QGC_LOGGING_CATEGORY(QGCMBTilesLog, "qgc.qtlocationplugin.qgcmbtiles")
+
+static QString _uniqueConnectionName()
+{
+    static std::atomic_int connectionCount = 0;
+    return QStringLiteral("QGCMBTilesSession%1").arg(connectionCount++);
+}
+
+/*===========================================================================*/
+
+QGCMBTilesReader::QGCMBTilesReader(const QString &path)
+    : _connectionName(_uniqueConnectionName())
+{
+    _db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), _connectionName);
+    _db.setDatabaseName(path);
+    _db.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+    if (!_db.open()) {
+        _errorString = _db.lastError().text();
+        qCWarning(QGCMBTilesLog) << "Unable to open MBTiles archive" << path << _errorString;
+        return;
+    }
+
+    QSqlQuery query(_db);
+    if (query.exec(QStringLiteral("SELECT name, value FROM metadata"))) {
+        while (query.next()) {
+            _metadata.insert(query.value(0).toString(), query.value(1).toString());
+        }
+    }
+
+    if (!query.exec(QStringLiteral("SELECT MIN(zoom_level), MAX(zoom_level), COUNT(*) FROM tiles")) || !query.next()) {
+        _errorString = QStringLiteral("Not an MBTiles archive");
+        qCWarning(QGCMBTilesLog) << "Unable to open MBTiles archive" << path << _errorString << query.lastError().text();
+        return;
+    }
+    _minZoom = query.value(0).toInt();
+    _maxZoom = query.value(1).toInt();
+    _tileCount = query.value(2).toULongLong();
+
+    _valid = true;
+}
+
+QGCMBTilesReader::~QGCMBTilesReader()
+{
+    // The connection can only be removed once no QSqlDatabase refers to it anymore
+    _db.close();
+    _db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(_connectionName);
+}
+
+void QGCMBTilesReader::bounds(double &west, double &south, double &east, double &north) const
+{
+    west = -180.0;
+    south = -85.0511;
+    east = 180.0;
+    north = 85.0511;
+
+    // left, bottom, right, top
+    const QStringList values = _metadata.value(QStringLiteral("bounds")).split(',');
+    if (values.count() == 4) {
+        west = values[0].toDouble();
+        south = values[1].toDouble();
+        east = values[2].toDouble();
+        north = values[3].toDouble();
+    }
+}
+
+bool QGCMBTilesReader::forEachTile(const std::function<bool(int z, int x, int y, const QByteArray &data)> &callback)
+{
+    if (!_valid) {
+        return false;
+    }
+
+    QSqlQuery query(_db);
+    query.setForwardOnly(true);
+    if (!query.exec(QStringLiteral("SELECT zoom_level, tile_column, tile_row, tile_data FROM tiles"))) {
+        qCWarning(QGCMBTilesLog) << "MBTiles SQL error (read tiles):" << query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        const int z = query.value(0).toInt();
+        if ((z < 0) || (z > QGCMBTiles::kMaxZoom)) {
+            qCWarning(QGCMBTilesLog) << "Skipping tile with invalid zoom level" << z;
+            continue;
+        }
+        if (!callback(z, query.value(1).toInt(), QGCMBTiles::flipRow(z, query.value(2).toInt()), query.value(3).toByteArray())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*===========================================================================*/
+
+QGCMBTilesWriter::QGCMBTilesWriter(const QString &path)
+    : _path(path)
+    , _connectionName(_uniqueConnectionName())
+{
+    (void) QFile::remove(path);
+
+    _db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), _connectionName);
+    _db.setDatabaseName(path);
+    if (!_db.open()) {
+        (void) _fail(_db.lastError().text());
+        return;
+    }
+
+    QSqlQuery query(_db);
+    // A partial archive is thrown away, it needs no journal
+    (void) query.exec(QStringLiteral("PRAGMA journal_mode = OFF"));
+    (void) query.exec(QStringLiteral("PRAGMA synchronous = OFF"));
+    if (!query.exec(QStringLiteral("CREATE TABLE metadata (name TEXT, value TEXT)")) ||
+        !query.exec(QStringLiteral("CREATE TABLE tiles (zoom_level INTEGER, tile_column INTEGER, tile_row INTEGER, tile_data BLOB)"))) {
+        (void) _fail(query.lastError().text());
+        return;
+    }
+
+    _insertTile = std::make_unique<QSqlQuery>(_db);
+    if (!_insertTile->prepare(QStringLiteral("INSERT INTO tiles(zoom_level, tile_column, tile_row, tile_data) VALUES(?, ?, ?, ?)"))) {
+        (void) _fail(_insertTile->lastError().text());
+        return;
+    }
+
+    _valid = _db.transaction();
+    if (!_valid) {
+        (void) _fail(_db.lastError().text());
+    }
+}
+
+QGCMBTilesWriter::~QGCMBTilesWriter()
+{
+    _insertTile.reset();
+    if (_db.isOpen()) {
+        (void) _db.rollback();
+        _db.close();
+    }
+    _db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(_connectionName);
+}
+
+bool QGCMBTilesWriter::_fail(const QString &errorString)
+{
+    qCWarning(QGCMBTilesLog) << "Unable to write MBTiles archive" << _path << errorString;
+    _errorString = errorString;
+    _valid = false;
+    return false;
+}
+
+bool QGCMBTilesWriter::addTile(int z, int x, int y, const QByteArray &data)
+{
+    if (!_valid) {
+        return false;
+    }
+
+    if ((z < 0) || (z > QGCMBTiles::kMaxZoom) || (x < 0) || (y < 0) || (x >= (1 << z)) || (y >= (1 << z)) || data.isEmpty()) {
+        qCWarning(QGCMBTilesLog) << "Skipping invalid tile" << z << x << y;
+        return false;
+    }
+
+    _insertTile->bindValue(0, z);
+    _insertTile->bindValue(1, x);
+    _insertTile->bindValue(2, QGCMBTiles::flipRow(z, y));
+    _insertTile->bindValue(3, data);
+    if (!_insertTile->exec()) {
+        return _fail(_insertTile->lastError().text());
+    }
+
+    _tileCount++;
+    if ((_tileCount % kTransactionTiles) == 0) {
+        if (!_db.commit() || !_db.transaction()) {
+            return _fail(_db.lastError().text());
+        }
+    }
+
+    return true;
+}
+
+bool QGCMBTilesWriter::finish(const QList<QPair<QString, QString>> &metadata)
+{
+    if (!_valid) {
+        return false;
+    }
+
+    QSqlQuery query(_db);
+    if (!query.exec(QStringLiteral("CREATE UNIQUE INDEX tile_index ON tiles (zoom_level, tile_column, tile_row)"))) {
+        return _fail(query.lastError().text());
+    }
+
+    (void) query.prepare(QStringLiteral("INSERT INTO metadata(name, value) VALUES(?, ?)"));
+    for (const QPair<QString, QString> &item : metadata) {
+        query.bindValue(0, item.first);
+        query.bindValue(1, item.second);
+        if (!query.exec()) {
+            return _fail(query.lastError().text());
+        }
+    }
+
+    query.finish();
+    _insertTile.reset();
+    if (!_db.commit()) {
+        return _fail(_db.lastError().text());
+    }
+
+    _valid = false;
+    _db.close();
+
+    return true;
+}
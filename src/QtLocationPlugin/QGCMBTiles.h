@@ -0,0 +1,109 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtSql/QSqlDatabase>
+
+#include <functional>
+#include <memory>
+
+Q_DECLARE_LOGGING_CATEGORY(QGCMBTilesLog)
+
+class QSqlQuery;
+
+/// MBTiles tile archives (https://github.com/mapbox/mbtiles-spec), an SQLite database with a tiles table and
+/// name/value metadata. The archive stores tile rows in the TMS scheme, counted from the south. Both classes
+/// take and return XYZ rows, the same as QGC tile hashes.
+/// Each instance uses its own database connection, which must only be used from the thread which created it.
+namespace QGCMBTiles
+{
+    constexpr int kMaxZoom = 30;    ///< Highest zoom level whose rows fit an int
+
+    /// @return Row in the other of the XYZ and TMS schemes
+    constexpr int flipRow(int z, int y) { return (1 << z) - 1 - y; }
+}
+
+/// Streams the tiles of an MBTiles archive. Not thread-safe.
+class QGCMBTilesReader
+{
+public:
+    explicit QGCMBTilesReader(const QString &path);
+    ~QGCMBTilesReader();
+
+    QGCMBTilesReader(const QGCMBTilesReader&) = delete;
+    QGCMBTilesReader& operator=(const QGCMBTilesReader&) = delete;
+
+    bool isValid() const { return _valid; }
+    const QString &errorString() const { return _errorString; }
+    const QHash<QString, QString> &metadata() const { return _metadata; }
+
+    quint64 tileCount() const { return _tileCount; }
+    int minZoom() const { return _minZoom; }
+    int maxZoom() const { return _maxZoom; }
+
+    /// Bounds from the "bounds" metadata, the whole Web Mercator world if the archive has none
+    void bounds(double &west, double &south, double &east, double &north) const;
+
+    /// Calls the callback for every tile, in no particular order. The archive is streamed, it may be far larger than memory.
+    ///     @param callback Returns false to stop
+    /// @return false if the tiles could not be read or the callback stopped the walk
+    bool forEachTile(const std::function<bool(int z, int x, int y, const QByteArray &data)> &callback);
+
+private:
+    const QString _connectionName;
+    QSqlDatabase _db;
+    bool _valid = false;
+    QString _errorString;
+    QHash<QString, QString> _metadata;
+    quint64 _tileCount = 0;
+    int _minZoom = 0;
+    int _maxZoom = 0;
+};
+
+/// Writes an MBTiles archive. Tiles are inserted in transactions of kTransactionTiles, the tile index is
+/// created by finish() once all rows are in, which is much faster than keeping it up to date. Not thread-safe.
+class QGCMBTilesWriter
+{
+public:
+    /// Replaces any existing file at path
+    explicit QGCMBTilesWriter(const QString &path);
+    ~QGCMBTilesWriter();
+
+    QGCMBTilesWriter(const QGCMBTilesWriter&) = delete;
+    QGCMBTilesWriter& operator=(const QGCMBTilesWriter&) = delete;
+
+    bool isValid() const { return _valid; }
+    const QString &errorString() const { return _errorString; }
+
+    bool addTile(int z, int x, int y, const QByteArray &data);
+    quint64 tileCount() const { return _tileCount; }
+
+    /// Indexes the tiles and writes the metadata
+    bool finish(const QList<QPair<QString, QString>> &metadata);
+
+    static constexpr quint64 kTransactionTiles = 1000;
+
+private:
+    bool _fail(const QString &errorString);
+
+    const QString _path;
+    const QString _connectionName;
+    QSqlDatabase _db;
+    std::unique_ptr<QSqlQuery> _insertTile;
+    quint64 _tileCount = 0;
+    bool _valid = false;
+    QString _errorString;
+};
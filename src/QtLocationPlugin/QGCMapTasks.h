@@ -26,6 +26,8 @@
 #include "QGCCacheTile.h"
 #include "QGCCachedTileSet.h"
 
+#include <atomic>
+
 class QGCMapTask : public QObject
 {
     Q_OBJECT
@@ -44,7 +46,8 @@ public:
         taskPruneCache,
         taskReset,
         taskExport,
-        taskImport
+        taskImport,
+        taskAttachArchive
     };
     Q_ENUM(TaskType);
 
@@ -61,11 +64,16 @@ public:
         emit error(m_type, errorString);
     }
 
+    /// The worker drops cancelled tasks instead of running them, callable from any thread
+    void cancel() { m_cancelled = true; }
+    bool isCancelled() const { return m_cancelled; }
+
 signals:
     void error(QGCMapTask::TaskType type, const QString &errorString);
 
 private:
     const TaskType m_type = TaskType::taskInit;
+    std::atomic_bool m_cancelled = false;
 };
 
 //-----------------------------------------------------------------------------
@@ -167,7 +175,7 @@ public:
         delete m_tile;
     }
 
-    QGCCacheTile *tile() { return m_tile; }
+    QGCCacheTile *tile() const { return m_tile; }
 
 private:
     QGCCacheTile* const m_tile = nullptr;
@@ -368,15 +376,18 @@ class QGCImportTileTask : public QGCMapTask
     Q_OBJECT
 
 public:
-    QGCImportTileTask(const QString &path, bool replace, QObject *parent = nullptr)
+    /// @param mapType Map type of the tiles of an MBTiles or PMTiles archive which does not name a known one in its metadata
+    QGCImportTileTask(const QString &path, bool replace, const QString &mapType = QString(), QObject *parent = nullptr)
         : QGCMapTask(QGCMapTask::taskImport, parent)
         , m_path(path)
         , m_replace(replace)
+        , m_mapType(mapType)
     {}
     ~QGCImportTileTask() = default;
 
     QString path() const { return m_path; }
     bool replace() const { return m_replace; }
+    QString mapType() const { return m_mapType; }
 
     void setImportCompleted()
     {
@@ -395,6 +406,40 @@ signals:
 private:
     const QString m_path;
     const bool m_replace = false;
+    const QString m_mapType;
+};
+
+//-----------------------------------------------------------------------------
+
+/// Serves the tiles of a PMTiles archive straight from the file, ahead of the cache database
+class QGCAttachArchiveTask : public QGCMapTask
+{
+    Q_OBJECT
+
+public:
+    /// @param path PMTiles archive, empty: detach all archives
+    /// @param mapType Map type the archive is served for if it does not name a known one in its metadata
+    QGCAttachArchiveTask(const QString &path, const QString &mapType = QString(), QObject *parent = nullptr)
+        : QGCMapTask(QGCMapTask::taskAttachArchive, parent)
+        , m_path(path)
+        , m_mapType(mapType)
+    {}
+    ~QGCAttachArchiveTask() = default;
+
+    QString path() const { return m_path; }
+    QString mapType() const { return m_mapType; }
+
+    void setArchiveAttached(const QString &mapType)
+    {
+        emit archiveAttached(mapType);
+    }
+
+signals:
+    void archiveAttached(const QString &mapType);
+
+private:
+    const QString m_path;
+    const QString m_mapType;
 };
 
 //-----------------------------------------------------------------------------
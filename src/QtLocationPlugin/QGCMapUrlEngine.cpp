@@ -277,6 +277,21 @@ QString UrlFactory::tileHashToType(QStringView tileHash)
     return providerTypeFromHash(providerHash);
 }
 
+bool UrlFactory::tileHashToXYZ(QStringView tileHash, int &x, int &y, int &z)
+{
+    // Parsed from the end, the provider hash is not always 10 characters
+    const qsizetype len = tileHash.size();
+    if (len < 29) {
+        return false;
+    }
+
+    bool okX = false, okY = false, okZ = false;
+    x = tileHash.mid(len - 19, 8).toInt(&okX);
+    y = tileHash.mid(len - 11, 8).toInt(&okY);
+    z = tileHash.mid(len - 3, 3).toInt(&okZ);
+    return (okX && okY && okZ);
+}
+
 QString UrlFactory::getTileHash(QStringView type, int x, int y, int z)
 {
     const int hash = hashFromProviderType(type);
@@ -0,0 +1,685 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCPMTiles.h"
+#include "QGCLoggingCategory.h"
+#include "QGCZlib.h"
+
+#include <QtCore/QJsonDocument>
+#include <QtCore/QSaveFile>
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+QGC_LOGGING_CATEGORY(QGCPMTilesLog, "qgc.qtlocationplugin.qgcpmtiles")
+
+namespace QGCPMTiles
+{
+
+static void _rotate(quint64 n, quint64 &x, quint64 &y, quint64 rx, quint64 ry)
+{
+    if (ry == 0) {
+        if (rx == 1) {
+            x = n - 1 - x;
+            y = n - 1 - y;
+        }
+        std::swap(x, y);
+    }
+}
+
+quint64 zxyToTileId(int z, int x, int y)
+{
+    // Tile ids of all lower zoom levels come first
+    const quint64 acc = ((quint64(1) << (2 * z)) - 1) / 3;
+    const quint64 n = quint64(1) << z;
+
+    quint64 tx = static_cast<quint64>(x);
+    quint64 ty = static_cast<quint64>(y);
+    quint64 d = 0;
+    for (quint64 s = n / 2; s > 0; s /= 2) {
+        const quint64 rx = ((tx & s) > 0) ? 1 : 0;
+        const quint64 ry = ((ty & s) > 0) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        _rotate(n, tx, ty, rx, ry);
+    }
+
+    return acc + d;
+}
+
+void tileIdToZxy(quint64 tileId, int &z, int &x, int &y)
+{
+    quint64 acc = 0;
+    int zoom = 0;
+    for (; zoom < kMaxZoom; zoom++) {
+        const quint64 count = quint64(1) << (2 * zoom);
+        if (tileId < (acc + count)) {
+            break;
+        }
+        acc += count;
+    }
+
+    const quint64 n = quint64(1) << zoom;
+    quint64 t = tileId - acc;
+    quint64 tx = 0;
+    quint64 ty = 0;
+    for (quint64 s = 1; s < n; s *= 2) {
+        const quint64 rx = 1 & (t / 2);
+        const quint64 ry = 1 & (t ^ rx);
+        _rotate(s, tx, ty, rx, ry);
+        tx += s * rx;
+        ty += s * ry;
+        t /= 4;
+    }
+
+    z = zoom;
+    x = static_cast<int>(tx);
+    y = static_cast<int>(ty);
+}
+
+TileType tileTypeFromFormat(const QString &format)
+{
+    if (format == QLatin1String("png")) {
+        return TileTypePng;
+    } else if ((format == QLatin1String("jpg")) || (format == QLatin1String("jpeg"))) {
+        return TileTypeJpeg;
+    } else if (format == QLatin1String("webp")) {
+        return TileTypeWebp;
+    } else if (format == QLatin1String("avif")) {
+        return TileTypeAvif;
+    } else if (format == QLatin1String("pbf")) {
+        return TileTypeMvt;
+    }
+
+    return TileTypeUnknown;
+}
+
+QString formatFromTileType(TileType tileType)
+{
+    switch (tileType) {
+    case TileTypeMvt:
+        return QStringLiteral("pbf");
+    case TileTypePng:
+        return QStringLiteral("png");
+    case TileTypeJpeg:
+        return QStringLiteral("jpg");
+    case TileTypeWebp:
+        return QStringLiteral("webp");
+    case TileTypeAvif:
+        return QStringLiteral("avif");
+    default:
+        return QString();
+    }
+}
+
+static qint32 _toE7(double degrees)
+{
+    return static_cast<qint32>(qRound(degrees * 1e7));
+}
+
+static double _fromE7(const uchar *data)
+{
+    return qFromLittleEndian<qint32>(data) / 1e7;
+}
+
+QByteArray serializeHeader(const Header &header)
+{
+    QByteArray result(kHeaderLen, '\0');
+    uchar *const data = reinterpret_cast<uchar*>(result.data());
+
+    (void) memcpy(data, "PMTiles", 7);
+    data[7] = 3;
+    qToLittleEndian<quint64>(header.rootDirOffset, data + 8);
+    qToLittleEndian<quint64>(header.rootDirLength, data + 16);
+    qToLittleEndian<quint64>(header.metadataOffset, data + 24);
+    qToLittleEndian<quint64>(header.metadataLength, data + 32);
+    qToLittleEndian<quint64>(header.leafDirsOffset, data + 40);
+    qToLittleEndian<quint64>(header.leafDirsLength, data + 48);
+    qToLittleEndian<quint64>(header.tileDataOffset, data + 56);
+    qToLittleEndian<quint64>(header.tileDataLength, data + 64);
+    qToLittleEndian<quint64>(header.addressedTiles, data + 72);
+    qToLittleEndian<quint64>(header.tileEntries, data + 80);
+    qToLittleEndian<quint64>(header.tileContents, data + 88);
+    data[96] = header.clustered ? 1 : 0;
+    data[97] = header.internalCompression;
+    data[98] = header.tileCompression;
+    data[99] = header.tileType;
+    data[100] = header.minZoom;
+    data[101] = header.maxZoom;
+    qToLittleEndian<qint32>(_toE7(header.minLon), data + 102);
+    qToLittleEndian<qint32>(_toE7(header.minLat), data + 106);
+    qToLittleEndian<qint32>(_toE7(header.maxLon), data + 110);
+    qToLittleEndian<qint32>(_toE7(header.maxLat), data + 114);
+    data[118] = header.centerZoom;
+    qToLittleEndian<qint32>(_toE7(header.centerLon), data + 119);
+    qToLittleEndian<qint32>(_toE7(header.centerLat), data + 123);
+
+    return result;
+}
+
+bool deserializeHeader(const uchar *data, qint64 size, Header &header)
+{
+    if ((size < kHeaderLen) || (memcmp(data, "PMTiles", 7) != 0) || (data[7] != 3)) {
+        return false;
+    }
+
+    header.rootDirOffset = qFromLittleEndian<quint64>(data + 8);
+    header.rootDirLength = qFromLittleEndian<quint64>(data + 16);
+    header.metadataOffset = qFromLittleEndian<quint64>(data + 24);
+    header.metadataLength = qFromLittleEndian<quint64>(data + 32);
+    header.leafDirsOffset = qFromLittleEndian<quint64>(data + 40);
+    header.leafDirsLength = qFromLittleEndian<quint64>(data + 48);
+    header.tileDataOffset = qFromLittleEndian<quint64>(data + 56);
+    header.tileDataLength = qFromLittleEndian<quint64>(data + 64);
+    header.addressedTiles = qFromLittleEndian<quint64>(data + 72);
+    header.tileEntries = qFromLittleEndian<quint64>(data + 80);
+    header.tileContents = qFromLittleEndian<quint64>(data + 88);
+    header.clustered = (data[96] == 1);
+    header.internalCompression = static_cast<Compression>(data[97]);
+    header.tileCompression = static_cast<Compression>(data[98]);
+    header.tileType = static_cast<TileType>(data[99]);
+    header.minZoom = data[100];
+    header.maxZoom = data[101];
+    header.minLon = _fromE7(data + 102);
+    header.minLat = _fromE7(data + 106);
+    header.maxLon = _fromE7(data + 110);
+    header.maxLat = _fromE7(data + 114);
+    header.centerZoom = data[118];
+    header.centerLon = _fromE7(data + 119);
+    header.centerLat = _fromE7(data + 123);
+
+    return true;
+}
+
+static void _writeVarint(QByteArray &data, quint64 value)
+{
+    while (value >= 0x80) {
+        data.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    data.append(static_cast<char>(value));
+}
+
+static bool _readVarint(const QByteArray &data, qsizetype &pos, quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= data.size()) {
+            return false;
+        }
+        const quint8 byte = static_cast<quint8>(data[pos++]);
+        value |= static_cast<quint64>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QByteArray serializeDirectory(const std::vector<Entry> &entries)
+{
+    // Columns of varints, tile ids as deltas and offsets as 0 when contiguous with the previous entry
+    QByteArray data;
+    data.reserve(static_cast<qsizetype>(entries.size()) * 6 + 10);
+    _writeVarint(data, entries.size());
+
+    quint64 lastId = 0;
+    for (const Entry &entry : entries) {
+        _writeVarint(data, entry.tileId - lastId);
+        lastId = entry.tileId;
+    }
+    for (const Entry &entry : entries) {
+        _writeVarint(data, entry.runLength);
+    }
+    for (const Entry &entry : entries) {
+        _writeVarint(data, entry.length);
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        if ((i > 0) && (entries[i].offset == (entries[i - 1].offset + entries[i - 1].length))) {
+            _writeVarint(data, 0);
+        } else {
+            _writeVarint(data, entries[i].offset + 1);
+        }
+    }
+
+    return data;
+}
+
+bool deserializeDirectory(const QByteArray &data, std::vector<Entry> &entries)
+{
+    qsizetype pos = 0;
+    quint64 count = 0;
+    // Every entry takes at least four bytes
+    if (!_readVarint(data, pos, count) || (count > static_cast<quint64>(data.size()))) {
+        return false;
+    }
+
+    entries.assign(count, Entry());
+
+    quint64 lastId = 0;
+    for (Entry &entry : entries) {
+        quint64 value = 0;
+        if (!_readVarint(data, pos, value)) {
+            return false;
+        }
+        lastId += value;
+        entry.tileId = lastId;
+    }
+    for (Entry &entry : entries) {
+        quint64 value = 0;
+        if (!_readVarint(data, pos, value)) {
+            return false;
+        }
+        entry.runLength = static_cast<quint32>(value);
+    }
+    for (Entry &entry : entries) {
+        quint64 value = 0;
+        if (!_readVarint(data, pos, value)) {
+            return false;
+        }
+        entry.length = static_cast<quint32>(value);
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        quint64 value = 0;
+        if (!_readVarint(data, pos, value)) {
+            return false;
+        }
+        if ((value == 0) && (i > 0)) {
+            entries[i].offset = entries[i - 1].offset + entries[i - 1].length;
+        } else if (value == 0) {
+            return false;
+        } else {
+            entries[i].offset = value - 1;
+        }
+    }
+
+    return true;
+}
+
+} // namespace QGCPMTiles
+
+using namespace QGCPMTiles;
+
+/*===========================================================================*/
+
+QGCPMTilesReader::QGCPMTilesReader(const QString &path)
+    : _path(path)
+    , _file(path)
+{
+    _valid = _open();
+    if (!_valid) {
+        qCWarning(QGCPMTilesLog) << "Unable to open PMTiles archive" << path << _errorString;
+    }
+}
+
+QGCPMTilesReader::~QGCPMTilesReader()
+{
+    // The mapping is released when _file is destroyed
+}
+
+bool QGCPMTilesReader::_open()
+{
+    if (!_file.open(QIODevice::ReadOnly)) {
+        _errorString = _file.errorString();
+        return false;
+    }
+
+    _size = _file.size();
+    _data = (_size >= kHeaderLen) ? _file.map(0, _size) : nullptr;
+    if (!_data) {
+        _errorString = QStringLiteral("Unable to map file");
+        return false;
+    }
+
+    if (!deserializeHeader(_data, _size, _header)) {
+        _errorString = QStringLiteral("Not a PMTiles v3 archive");
+        return false;
+    }
+
+    if ((_header.internalCompression != CompressionNone) && (_header.internalCompression != CompressionGzip)) {
+        _errorString = QStringLiteral("Unsupported directory compression %1").arg(_header.internalCompression);
+        return false;
+    }
+
+    if ((_header.tileCompression != CompressionNone) && (_header.tileCompression != CompressionUnknown) && (_header.tileCompression != CompressionGzip)) {
+        _errorString = QStringLiteral("Unsupported tile compression %1").arg(_header.tileCompression);
+        return false;
+    }
+
+    if (!_inFile(_header.rootDirOffset, _header.rootDirLength) || !_inFile(_header.tileDataOffset, _header.tileDataLength)) {
+        _errorString = QStringLiteral("Truncated archive");
+        return false;
+    }
+
+    const QByteArray rootDirectory = _decompress(_data + _header.rootDirOffset, _header.rootDirLength, _header.internalCompression);
+    if (!deserializeDirectory(rootDirectory, _rootDirectory)) {
+        _errorString = QStringLiteral("Corrupt root directory");
+        return false;
+    }
+
+    if ((_header.metadataLength > 0) && _inFile(_header.metadataOffset, _header.metadataLength)) {
+        const QByteArray metadata = _decompress(_data + _header.metadataOffset, _header.metadataLength, _header.internalCompression);
+        _metadata = QJsonDocument::fromJson(metadata).object();
+    }
+
+    qCDebug(QGCPMTilesLog) << "Opened" << _path << "tiles:" << _header.addressedTiles << "zoom:" << _header.minZoom << "-" << _header.maxZoom;
+
+    return true;
+}
+
+QByteArray QGCPMTilesReader::_decompress(const uchar *data, qint64 size, Compression compression) const
+{
+    if (compression == CompressionGzip) {
+        return QGCZlib::inflateGzip(QByteArrayView(data, size));
+    }
+
+    return QByteArray(reinterpret_cast<const char*>(data), size);
+}
+
+QByteArray QGCPMTilesReader::_tileData(const Entry &entry) const
+{
+    const quint64 offset = _header.tileDataOffset + entry.offset;
+    if (!_inFile(offset, entry.length)) {
+        qCWarning(QGCPMTilesLog) << "Tile outside of archive" << _path << entry.tileId;
+        return QByteArray();
+    }
+
+    return _decompress(_data + offset, entry.length, _header.tileCompression);
+}
+
+const std::vector<Entry> *QGCPMTilesReader::_leafDirectory(quint64 offset, quint32 length)
+{
+    const auto it = _leafDirectories.constFind(offset);
+    if (it != _leafDirectories.constEnd()) {
+        return &it.value();
+    }
+
+    const quint64 fileOffset = _header.leafDirsOffset + offset;
+    if (!_inFile(fileOffset, length)) {
+        qCWarning(QGCPMTilesLog) << "Leaf directory outside of archive" << _path << offset;
+        return nullptr;
+    }
+
+    std::vector<Entry> entries;
+    if (!deserializeDirectory(_decompress(_data + fileOffset, length, _header.internalCompression), entries)) {
+        qCWarning(QGCPMTilesLog) << "Corrupt leaf directory" << _path << offset;
+        return nullptr;
+    }
+
+    // Leaf directories cover neighbouring tiles, which are looked up together while panning
+    if (_leafDirectories.size() >= kMaxCachedLeafDirectories) {
+        _leafDirectories.clear();
+    }
+
+    return &(*_leafDirectories.insert(offset, std::move(entries)));
+}
+
+QByteArray QGCPMTilesReader::tile(int z, int x, int y)
+{
+    if (!_valid || (z < _header.minZoom) || (z > _header.maxZoom) || (z > kMaxZoom) || (x < 0) || (y < 0) || (x >= (1 << z)) || (y >= (1 << z))) {
+        return QByteArray();
+    }
+
+    const quint64 tileId = zxyToTileId(z, x, y);
+    const std::vector<Entry> *directory = &_rootDirectory;
+    for (int depth = 0; depth < kMaxDirectoryDepth; depth++) {
+        const auto it = std::upper_bound(directory->cbegin(), directory->cend(), tileId, [](quint64 id, const Entry &entry) {
+            return (id < entry.tileId);
+        });
+        if (it == directory->cbegin()) {
+            return QByteArray();
+        }
+
+        const Entry entry = *(it - 1);
+        if (entry.runLength > 0) {
+            return ((tileId < (entry.tileId + entry.runLength)) ? _tileData(entry) : QByteArray());
+        }
+
+        directory = _leafDirectory(entry.offset, entry.length);
+        if (!directory) {
+            return QByteArray();
+        }
+    }
+
+    return QByteArray();
+}
+
+bool QGCPMTilesReader::forEachTile(const std::function<bool(int z, int x, int y, const QByteArray &data)> &callback)
+{
+    return (_valid && _walkDirectory(_rootDirectory, 0, callback));
+}
+
+bool QGCPMTilesReader::_walkDirectory(const std::vector<Entry> &entries, int depth, const std::function<bool(int, int, int, const QByteArray&)> &callback)
+{
+    if (depth >= kMaxDirectoryDepth) {
+        return false;
+    }
+
+    for (const Entry &entry : entries) {
+        if (entry.runLength == 0) {
+            // Not cached, a walk visits every leaf directory once
+            const quint64 fileOffset = _header.leafDirsOffset + entry.offset;
+            std::vector<Entry> leafEntries;
+            if (!_inFile(fileOffset, entry.length) || !deserializeDirectory(_decompress(_data + fileOffset, entry.length, _header.internalCompression), leafEntries)) {
+                qCWarning(QGCPMTilesLog) << "Corrupt leaf directory" << _path << entry.offset;
+                return false;
+            }
+            if (!_walkDirectory(leafEntries, depth + 1, callback)) {
+                return false;
+            }
+            continue;
+        }
+
+        const QByteArray data = _tileData(entry);
+        if (data.isEmpty()) {
+            return false;
+        }
+
+        for (quint64 tileId = entry.tileId; tileId < (entry.tileId + entry.runLength); tileId++) {
+            int z, x, y;
+            tileIdToZxy(tileId, z, x, y);
+            if (!callback(z, x, y, data)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*===========================================================================*/
+
+QGCPMTilesWriter::QGCPMTilesWriter(const QString &path)
+    : _path(path)
+    , _tileData(path + QStringLiteral(".XXXXXX"))
+{
+    _valid = _tileData.open();
+    if (!_valid) {
+        _errorString = _tileData.errorString();
+        qCWarning(QGCPMTilesLog) << "Unable to create PMTiles tile data file" << _tileData.fileTemplate() << _errorString;
+    }
+}
+
+QGCPMTilesWriter::~QGCPMTilesWriter()
+{
+    // The temporary tile data file is removed when _tileData is destroyed
+}
+
+bool QGCPMTilesWriter::_fail(const QString &errorString)
+{
+    qCWarning(QGCPMTilesLog) << "Unable to write PMTiles archive" << _path << errorString;
+    _errorString = errorString;
+    _valid = false;
+    return false;
+}
+
+bool QGCPMTilesWriter::addTile(int z, int x, int y, const QByteArray &data)
+{
+    if (!_valid) {
+        return false;
+    }
+
+    if ((z < 0) || (z > kMaxZoom) || (x < 0) || (y < 0) || (x >= (1 << z)) || (y >= (1 << z)) || data.isEmpty()) {
+        qCWarning(QGCPMTilesLog) << "Skipping invalid tile" << z << x << y;
+        return false;
+    }
+
+    if (_tileData.write(data) != data.size()) {
+        return _fail(_tileData.errorString());
+    }
+
+    _entries.push_back(Entry{ zxyToTileId(z, x, y), _tileDataSize, static_cast<quint32>(data.size()), 1 });
+    _tileDataSize += data.size();
+
+    return true;
+}
+
+bool QGCPMTilesWriter::_writeAll(QSaveFile &file, const char *data, qint64 size)
+{
+    return (file.write(data, size) == size);
+}
+
+bool QGCPMTilesWriter::_buildDirectories(QByteArray &rootDirectory, QByteArray &leafDirectories) const
+{
+    rootDirectory = serializeDirectory(_entries);
+    leafDirectories.clear();
+    if (rootDirectory.size() <= kMaxRootDirLen) {
+        return true;
+    }
+
+    // Split into leaf directories, growing them until the root directory pointing at them fits
+    for (size_t leafSize = kMinLeafEntries; leafSize < (_entries.size() * 2); leafSize *= 2) {
+        std::vector<Entry> rootEntries;
+        leafDirectories.clear();
+        for (size_t first = 0; first < _entries.size(); first += leafSize) {
+            const size_t last = std::min(first + leafSize, _entries.size());
+            const std::vector<Entry> leafEntries(_entries.cbegin() + first, _entries.cbegin() + last);
+            const QByteArray leaf = serializeDirectory(leafEntries);
+            rootEntries.push_back(Entry{ leafEntries.front().tileId, static_cast<quint64>(leafDirectories.size()), static_cast<quint32>(leaf.size()), 0 });
+            leafDirectories.append(leaf);
+        }
+
+        rootDirectory = serializeDirectory(rootEntries);
+        if (rootDirectory.size() <= kMaxRootDirLen) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool QGCPMTilesWriter::finish(Header header, const QJsonObject &metadata)
+{
+    if (!_valid) {
+        return false;
+    }
+
+    if (_entries.empty()) {
+        return _fail(QStringLiteral("No tiles"));
+    }
+
+    if (!_tileData.flush()) {
+        return _fail(_tileData.errorString());
+    }
+
+    const uchar *const source = _tileData.map(0, static_cast<qint64>(_tileDataSize));
+    if (!source) {
+        return _fail(_tileData.errorString());
+    }
+
+    // Tile id order, a tile added more than once keeps its last data
+    std::stable_sort(_entries.begin(), _entries.end(), [](const Entry &a, const Entry &b) {
+        return (a.tileId < b.tileId);
+    });
+
+    std::vector<Entry> sourceEntries;
+    sourceEntries.reserve(_entries.size());
+    for (size_t i = 0; i < _entries.size(); i++) {
+        if (((i + 1) < _entries.size()) && (_entries[i + 1].tileId == _entries[i].tileId)) {
+            continue;
+        }
+        sourceEntries.push_back(_entries[i]);
+    }
+
+    // Lay the tile data out in tile id order. Runs of neighbouring tiles with the same content, such as open
+    // water, share one copy of the data and one directory entry.
+    std::vector<quint64> contentSources;
+    _entries.clear();
+    quint64 tileDataLength = 0;
+    for (const Entry &entry : sourceEntries) {
+        if (!_entries.empty()) {
+            Entry &last = _entries.back();
+            if (((last.tileId + last.runLength) == entry.tileId) && (last.length == entry.length) &&
+                    (memcmp(source + contentSources.back(), source + entry.offset, entry.length) == 0)) {
+                last.runLength++;
+                continue;
+            }
+        }
+        _entries.push_back(Entry{ entry.tileId, tileDataLength, entry.length, 1 });
+        contentSources.push_back(entry.offset);
+        tileDataLength += entry.length;
+    }
+
+    QByteArray rootDirectory;
+    QByteArray leafDirectories;
+    if (!_buildDirectories(rootDirectory, leafDirectories)) {
+        return _fail(QStringLiteral("Too many tiles for the root directory"));
+    }
+
+    const QByteArray metadataJson = QJsonDocument(metadata).toJson(QJsonDocument::Compact);
+
+    int minZoom, maxZoom, x, y;
+    tileIdToZxy(_entries.front().tileId, minZoom, x, y);
+    tileIdToZxy(_entries.back().tileId + _entries.back().runLength - 1, maxZoom, x, y);
+
+    header.rootDirOffset = kHeaderLen;
+    header.rootDirLength = rootDirectory.size();
+    header.metadataOffset = header.rootDirOffset + header.rootDirLength;
+    header.metadataLength = metadataJson.size();
+    header.leafDirsOffset = header.metadataOffset + header.metadataLength;
+    header.leafDirsLength = leafDirectories.size();
+    header.tileDataOffset = header.leafDirsOffset + header.leafDirsLength;
+    header.tileDataLength = tileDataLength;
+    header.addressedTiles = sourceEntries.size();
+    header.tileEntries = _entries.size();
+    header.tileContents = _entries.size();
+    header.clustered = true;
+    header.internalCompression = CompressionNone;
+    header.minZoom = static_cast<quint8>(minZoom);
+    header.maxZoom = static_cast<quint8>(maxZoom);
+
+    QSaveFile file(_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return _fail(file.errorString());
+    }
+
+    const QByteArray headerData = serializeHeader(header);
+    bool ok = _writeAll(file, headerData.constData(), headerData.size()) &&
+              _writeAll(file, rootDirectory.constData(), rootDirectory.size()) &&
+              _writeAll(file, metadataJson.constData(), metadataJson.size()) &&
+              _writeAll(file, leafDirectories.constData(), leafDirectories.size());
+    for (size_t i = 0; ok && (i < _entries.size()); i++) {
+        ok = _writeAll(file, reinterpret_cast<const char*>(source + contentSources[i]), _entries[i].length);
+    }
+
+    if (!ok) {
+        file.cancelWriting();
+        return _fail(file.errorString());
+    }
+
+    if (!file.commit()) {
+        return _fail(file.errorString());
+    }
+
+    qCDebug(QGCPMTilesLog) << "Wrote" << _path << "tiles:" << header.addressedTiles << "contents:" << header.tileContents;
+
+    _valid = false;
+    return true;
+}
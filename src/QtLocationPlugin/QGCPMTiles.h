@@ -0,0 +1,179 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QString>
+#include <QtCore/QTemporaryFile>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+Q_DECLARE_LOGGING_CATEGORY(QGCPMTilesLog)
+
+class QSaveFile;
+
+/// PMTiles v3 single file tile archives (https://github.com/protomaps/PMTiles/blob/main/spec/v3/spec.md).
+/// Tiles are addressed by a Hilbert curve tile id and located through a root directory and optional leaf
+/// directories. Tile rows follow the XYZ scheme, the same as QGC tile hashes.
+namespace QGCPMTiles
+{
+    enum Compression : quint8 {
+        CompressionUnknown = 0,
+        CompressionNone = 1,
+        CompressionGzip = 2,
+        CompressionBrotli = 3,
+        CompressionZstd = 4
+    };
+
+    enum TileType : quint8 {
+        TileTypeUnknown = 0,
+        TileTypeMvt = 1,
+        TileTypePng = 2,
+        TileTypeJpeg = 3,
+        TileTypeWebp = 4,
+        TileTypeAvif = 5
+    };
+
+    struct Header {
+        quint64 rootDirOffset = 0;
+        quint64 rootDirLength = 0;
+        quint64 metadataOffset = 0;
+        quint64 metadataLength = 0;
+        quint64 leafDirsOffset = 0;
+        quint64 leafDirsLength = 0;
+        quint64 tileDataOffset = 0;
+        quint64 tileDataLength = 0;
+        quint64 addressedTiles = 0;
+        quint64 tileEntries = 0;
+        quint64 tileContents = 0;
+        bool clustered = false;
+        Compression internalCompression = CompressionNone;
+        Compression tileCompression = CompressionNone;
+        TileType tileType = TileTypeUnknown;
+        quint8 minZoom = 0;
+        quint8 maxZoom = 0;
+        double minLon = -180.;
+        double minLat = -85.;
+        double maxLon = 180.;
+        double maxLat = 85.;
+        quint8 centerZoom = 0;
+        double centerLon = 0.;
+        double centerLat = 0.;
+    };
+
+    struct Entry {
+        quint64 tileId = 0;
+        quint64 offset = 0;
+        quint32 length = 0;
+        quint32 runLength = 0;      ///< 0: entry points to a leaf directory
+    };
+
+    quint64 zxyToTileId(int z, int x, int y);
+    void tileIdToZxy(quint64 tileId, int &z, int &x, int &y);
+
+    /// @return TileTypeUnknown for formats PMTiles has no type for
+    TileType tileTypeFromFormat(const QString &format);
+    QString formatFromTileType(TileType tileType);
+
+    QByteArray serializeHeader(const Header &header);
+    bool deserializeHeader(const uchar *data, qint64 size, Header &header);
+    QByteArray serializeDirectory(const std::vector<Entry> &entries);
+    bool deserializeDirectory(const QByteArray &data, std::vector<Entry> &entries);
+
+    constexpr qint64 kHeaderLen = 127;
+    constexpr qint64 kMaxRootDirLen = 16384 - kHeaderLen;   ///< Header and root directory fit the first 16 KiB
+    constexpr int kMaxZoom = 26;                            ///< Highest zoom level whose tile ids fit 64 bits
+}
+
+/// Reads tiles from a memory mapped PMTiles archive.
+/// The root directory is decoded when the archive is opened, leaf directories on first use. Not thread-safe.
+class QGCPMTilesReader
+{
+public:
+    explicit QGCPMTilesReader(const QString &path);
+    ~QGCPMTilesReader();
+
+    bool isValid() const { return _valid; }
+    const QString &errorString() const { return _errorString; }
+    const QString &path() const { return _path; }
+    const QGCPMTiles::Header &header() const { return _header; }
+    const QJsonObject &metadata() const { return _metadata; }
+
+    /// @return Decompressed tile data, empty if the archive has no such tile
+    QByteArray tile(int z, int x, int y);
+
+    /// Calls the callback for every tile in tile id order, decompressing each one
+    ///     @param callback Returns false to stop
+    /// @return false if the archive is corrupt or the callback stopped the walk
+    bool forEachTile(const std::function<bool(int z, int x, int y, const QByteArray &data)> &callback);
+
+private:
+    bool _open();
+    const std::vector<QGCPMTiles::Entry> *_leafDirectory(quint64 offset, quint32 length);
+    bool _walkDirectory(const std::vector<QGCPMTiles::Entry> &entries, int depth, const std::function<bool(int, int, int, const QByteArray&)> &callback);
+    QByteArray _decompress(const uchar *data, qint64 size, QGCPMTiles::Compression compression) const;
+    QByteArray _tileData(const QGCPMTiles::Entry &entry) const;
+    bool _inFile(quint64 offset, quint64 length) const { return ((offset <= static_cast<quint64>(_size)) && (length <= (static_cast<quint64>(_size) - offset))); }
+
+    const QString _path;
+    QFile _file;
+    const uchar *_data = nullptr;
+    qint64 _size = 0;
+    bool _valid = false;
+    QString _errorString;
+    QGCPMTiles::Header _header;
+    QJsonObject _metadata;
+    std::vector<QGCPMTiles::Entry> _rootDirectory;
+    QHash<quint64, std::vector<QGCPMTiles::Entry>> _leafDirectories;   ///< By offset in the leaf directory section
+
+    static constexpr int kMaxDirectoryDepth = 4;
+    static constexpr int kMaxCachedLeafDirectories = 64;
+};
+
+/// Writes a PMTiles archive.
+/// Tile data is streamed to a temporary file next to the archive while only the directory entries are kept in
+/// memory. finish() sorts the tiles by tile id, so they may be added in any order, and writes the archive
+/// clustered with uncompressed directories.
+class QGCPMTilesWriter
+{
+public:
+    explicit QGCPMTilesWriter(const QString &path);
+    ~QGCPMTilesWriter();
+
+    bool isValid() const { return _valid; }
+    const QString &errorString() const { return _errorString; }
+
+    /// @param data Tile data as it is to be stored, compressed per the tile compression of the header
+    bool addTile(int z, int x, int y, const QByteArray &data);
+    quint64 tileCount() const { return _entries.size(); }
+
+    /// Writes the archive, the directory and zoom fields of the header are filled in
+    bool finish(QGCPMTiles::Header header, const QJsonObject &metadata);
+
+private:
+    bool _fail(const QString &errorString);
+    bool _buildDirectories(QByteArray &rootDirectory, QByteArray &leafDirectories) const;
+    static bool _writeAll(QSaveFile &file, const char *data, qint64 size);
+
+    const QString _path;
+    QTemporaryFile _tileData;
+    std::vector<QGCPMTiles::Entry> _entries;
+    quint64 _tileDataSize = 0;
+    bool _valid = false;
+    QString _errorString;
+
+    static constexpr size_t kMinLeafEntries = 4096;
+};
@@ -20,20 +20,60 @@
 #include "QGCCachedTileSet.h"
 #include "QGCMapTasks.h"
 #include "QGCMapUrlEngine.h"
+#include "QGCMBTiles.h"
+#include "QGCPMTiles.h"
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/QDateTime>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonObject>
 #include <QtCore/QSettings>
+#include <QtCore/QtMath>
 #include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlQuery>
 #include <QtSql/QSqlError>
 
+#include <algorithm>
+
 QByteArray QGCCacheWorker::_bingNoTileImage;
 
 QGC_LOGGING_CATEGORY(QGCTileCacheWorkerLog, "qgc.qtlocationplugin.qgctilecacheworker")
 
+namespace {
+
+enum class ArchiveFormat {
+    Database,
+    MBTiles,
+    PMTiles
+};
+
+ArchiveFormat _archiveFormat(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if(suffix == QLatin1String("mbtiles")) {
+        return ArchiveFormat::MBTiles;
+    } else if(suffix == QLatin1String("pmtiles")) {
+        return ArchiveFormat::PMTiles;
+    }
+    return ArchiveFormat::Database;
+}
+
+/// Metadata key holding the QGC map type of an archive's tiles
+constexpr const char* kArchiveMapTypeKey = "qgc_map_type";
+
+/// The map type an archive names wins, the one given with the task is for archives built elsewhere
+QString _archiveMapType(const QString &metadataMapType, const QString &taskMapType)
+{
+    if(!metadataMapType.isEmpty() && UrlFactory::getMapProviderFromProviderType(metadataMapType)) {
+        return metadataMapType;
+    }
+    return taskMapType;
+}
+
+} // namespace
+
 QGCCacheWorker::QGCCacheWorker(QObject* parent)
     : QThread(parent)
 {
@@ -48,7 +88,12 @@ QGCCacheWorker::~QGCCacheWorker()
 void QGCCacheWorker::stop()
 {
     QMutexLocker lock(&_taskQueueMutex);
-    qDeleteAll(_taskQueue);
+    for (QQueue<QueuedTask> &queue : _queues) {
+        for (const QueuedTask &queued : queue) {
+            delete queued.task;
+        }
+        queue.clear();
+    }
     lock.unlock();
 
     if(this->isRunning()) {
@@ -64,9 +109,12 @@ bool QGCCacheWorker::enqueueTask(QGCMapTask *task)
         return false;
     }
 
-    // TODO: Prepend Stop Task Instead?
+    const TaskPriority priority = taskPriority(task);
     QMutexLocker lock(&_taskQueueMutex);
-    _taskQueue.enqueue(task);
+    QQueue<QueuedTask> &queue = _queues[priority];
+    queue.enqueue(QueuedTask{ task, _nextSeq++ });
+    QueueMetrics &metrics = _metrics[priority];
+    metrics.peakDepth = qMax(metrics.peakDepth, static_cast<quint64>(queue.count()));
     lock.unlock();
 
     if (isRunning()) {
@@ -97,14 +145,32 @@ QGCCacheWorker::run()
 
     QMutexLocker lock(&_taskQueueMutex);
     while (true) {
-        if (!_taskQueue.isEmpty()) {
-            QGCMapTask* const task = _taskQueue.dequeue();
+        if (!_queues[PriorityFetch].isEmpty()) {
             lock.unlock();
-            _runTask(task);
+            _runFetchTasks();
+            if (_accessedTiles.count() >= kMaxPendingAccess) {
+                _flushTileAccess();
+            }
             lock.relock();
-            task->deleteLater();
+            continue;
+        }
+
+        const QList<QGCMapTask*> batch = _takeWriteBatch();
+        if (!batch.isEmpty()) {
+            const TaskPriority priority = taskPriority(batch.first());
+            lock.unlock();
+            _runBatch(batch);
+            lock.relock();
+            for (QGCMapTask* const task : batch) {
+                if (task->isCancelled()) {
+                    _metrics[priority].cancelled++;
+                } else {
+                    _metrics[priority].processed++;
+                }
+                task->deleteLater();
+            }
 
-            const qsizetype count = _taskQueue.count();
+            const qsizetype count = _queues[PriorityInteractive].count() + _queues[PriorityBackground].count();
             if (count > 100) {
                 _updateTimeout = kLongTimeout;
             } else if (count < 25) {
@@ -112,24 +178,140 @@ QGCCacheWorker::run()
             }
 
             if ((count == 0) || _updateTimer.hasExpired(_updateTimeout)) {
+                qCDebug(QGCTileCacheWorkerLog) << "Queue depth fetch:" << _queues[PriorityFetch].count()
+                                               << "interactive:" << _queues[PriorityInteractive].count()
+                                               << "background:" << _queues[PriorityBackground].count()
+                                               << "cancelled fetches:" << _metrics[PriorityFetch].cancelled;
                 if (_valid) {
                     lock.unlock();
+                    _flushTileAccess();
                     _updateTotals();
                     lock.relock();
                 }
             }
         } else {
             (void) _waitc.wait(lock.mutex(), 5000);
-            if (_taskQueue.isEmpty()) {
+            if (std::all_of(_queues.cbegin(), _queues.cend(), [](const QQueue<QueuedTask> &queue) { return queue.isEmpty(); })) {
                 break;
             }
         }
     }
     lock.unlock();
 
+    _flushTileAccess();
     _disconnectDB();
 }
 
+QGCCacheWorker::TaskPriority QGCCacheWorker::taskPriority(const QGCMapTask *task)
+{
+    switch (task->type()) {
+    case QGCMapTask::taskFetchTile:
+        return PriorityFetch;
+    case QGCMapTask::taskCacheTile:
+        // Tiles for a tile set come from its download, the rest from browsing the map
+        return ((static_cast<const QGCSaveTileTask*>(task)->tile()->tileSet() == UINT64_MAX) ? PriorityInteractive : PriorityBackground);
+    case QGCMapTask::taskGetTileDownloadList:
+    case QGCMapTask::taskUpdateTileDownloadState:
+        return PriorityBackground;
+    default:
+        return PriorityInteractive;
+    }
+}
+
+QGCCacheWorker::QueueMetrics QGCCacheWorker::queueMetrics(TaskPriority priority)
+{
+    QMutexLocker lock(&_taskQueueMutex);
+    QueueMetrics metrics = _metrics[priority];
+    metrics.depth = _queues[priority].count();
+    return metrics;
+}
+
+bool QGCCacheWorker::_isBatchable(const QGCMapTask *task)
+{
+    return ((task->type() == QGCMapTask::taskCacheTile) || (task->type() == QGCMapTask::taskUpdateTileDownloadState));
+}
+
+bool QGCCacheWorker::_isBarrier(const QGCMapTask *task)
+{
+    return ((taskPriority(task) == PriorityInteractive) && (task->type() != QGCMapTask::taskCacheTile));
+}
+
+QList<QGCMapTask*> QGCCacheWorker::_takeWriteBatch()
+{
+    QQueue<QueuedTask> &interactive = _queues[PriorityInteractive];
+    QQueue<QueuedTask> &background = _queues[PriorityBackground];
+
+    QQueue<QueuedTask> *queue = nullptr;
+    quint64 seqLimit = UINT64_MAX;
+    if (!interactive.isEmpty()) {
+        const QueuedTask &head = interactive.head();
+        if (_isBarrier(head.task) && !background.isEmpty() && (background.head().seq < head.seq)) {
+            queue = &background;
+            seqLimit = head.seq;
+        } else {
+            queue = &interactive;
+        }
+    } else if (!background.isEmpty()) {
+        queue = &background;
+    }
+
+    QList<QGCMapTask*> batch;
+    if (!queue) {
+        return batch;
+    }
+
+    batch.append(queue->dequeue().task);
+    if (_isBatchable(batch.first())) {
+        while ((batch.count() < kMaxBatchTasks) && !queue->isEmpty() && _isBatchable(queue->head().task) && (queue->head().seq < seqLimit)) {
+            batch.append(queue->dequeue().task);
+        }
+    }
+    return batch;
+}
+
+/// Runs the tasks, in a single transaction if there is more than one. Fetches which come in meanwhile are served
+/// between the writes.
+void QGCCacheWorker::_runBatch(const QList<QGCMapTask*> &batch)
+{
+    const bool transaction = _valid && (batch.count() > 1) && _db->transaction();
+
+    for (QGCMapTask* const task : batch) {
+        if (!task->isCancelled()) {
+            _runTask(task);
+        }
+        _runFetchTasks();
+    }
+
+    if (transaction && !_db->commit()) {
+        qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (commit batch):" << _db->lastError().text();
+        (void) _db->rollback();
+    }
+
+    if (batch.count() > 1) {
+        qCDebug(QGCTileCacheWorkerLog) << "Batched" << batch.count() << "tasks";
+    }
+}
+
+void QGCCacheWorker::_runFetchTasks()
+{
+    QMutexLocker lock(&_taskQueueMutex);
+    QQueue<QueuedTask> &queue = _queues[PriorityFetch];
+    QueueMetrics &metrics = _metrics[PriorityFetch];
+    while (!queue.isEmpty()) {
+        QGCMapTask* const task = queue.dequeue().task;
+        if (task->isCancelled()) {
+            metrics.cancelled++;
+            task->deleteLater();
+            continue;
+        }
+        lock.unlock();
+        _runTask(task);
+        task->deleteLater();
+        lock.relock();
+        metrics.processed++;
+    }
+}
+
 void QGCCacheWorker::_runTask(QGCMapTask *task)
 {
     switch (task->type()) {
@@ -171,6 +353,9 @@ void QGCCacheWorker::_runTask(QGCMapTask *task)
     case QGCMapTask::taskImport:
         _importSets(task);
         break;
+    case QGCMapTask::taskAttachArchive:
+        _attachArchive(task);
+        break;
     default:
         qCWarning(QGCTileCacheWorkerLog) << Q_FUNC_INFO << "given unhandled task type" << task->type();
         break;
@@ -257,21 +442,26 @@ QGCCacheWorker::_saveTile(QGCMapTask *mtask)
 {
     if(_valid) {
         QGCSaveTileTask* task = static_cast<QGCSaveTileTask*>(mtask);
-        QSqlQuery query(*_db);
-        query.prepare("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
-        query.addBindValue(task->tile()->hash());
-        query.addBindValue(task->tile()->format());
-        query.addBindValue(task->tile()->img());
-        query.addBindValue(task->tile()->img().size());
-        query.addBindValue(task->tile()->type());
-        query.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
-        if(query.exec()) {
-            quint64 tileID = query.lastInsertId().toULongLong();
+        QSqlQuery* const query = _preparedQuery(querySaveTile);
+        if(!query) {
+            return;
+        }
+        query->bindValue(0, task->tile()->hash());
+        query->bindValue(1, task->tile()->format());
+        query->bindValue(2, task->tile()->img());
+        query->bindValue(3, task->tile()->img().size());
+        query->bindValue(4, task->tile()->type());
+        query->bindValue(5, QDateTime::currentDateTime().toSecsSinceEpoch());
+        if(query->exec()) {
+            quint64 tileID = query->lastInsertId().toULongLong();
             quint64 setID = task->tile()->tileSet() == UINT64_MAX ? _getDefaultTileSet() : task->tile()->tileSet();
-            QString s = QString("INSERT INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(tileID).arg(setID);
-            query.prepare(s);
-            if(!query.exec()) {
-                qWarning() << "Map Cache SQL error (add tile into SetTiles):" << query.lastError().text();
+            QSqlQuery* const setQuery = _preparedQuery(querySaveSetTile);
+            if(setQuery) {
+                setQuery->bindValue(0, tileID);
+                setQuery->bindValue(1, setID);
+                if(!setQuery->exec()) {
+                    qWarning() << "Map Cache SQL error (add tile into SetTiles):" << setQuery->lastError().text();
+                }
             }
             qCDebug(QGCTileCacheWorkerLog) << "_saveTile() HASH:" << task->tile()->hash();
         } else {
@@ -290,20 +480,26 @@ QGCCacheWorker::_getTile(QGCMapTask* mtask)
     if(!_testTask(mtask)) {
         return;
     }
+    if(!_archives.isEmpty() && _getArchiveTile(mtask)) {
+        return;
+    }
     bool found = false;
     QGCFetchTileTask* task = static_cast<QGCFetchTileTask*>(mtask);
-    QSqlQuery query(*_db);
-    QString s = QString("SELECT tile, format, type FROM Tiles WHERE hash = \"%1\"").arg(task->hash());
-    if(query.exec(s)) {
-        if(query.next()) {
-            const QByteArray& arrray   = query.value(0).toByteArray();
-            const QString& format  = query.value(1).toString();
-            const QString& type = query.value(2).toString();
+    QSqlQuery* const query = _preparedQuery(queryGetTile);
+    if(query) {
+        query->bindValue(0, task->hash());
+        if(query->exec() && query->next()) {
+            const QByteArray& arrray   = query->value(0).toByteArray();
+            const QString& format  = query->value(1).toString();
+            const QString& type = query->value(2).toString();
+            (void) _accessedTiles.insert(query->value(3).toULongLong());
             qCDebug(QGCTileCacheWorkerLog) << "_getTile() (Found in DB) HASH:" << task->hash();
             QGCCacheTile* tile = new QGCCacheTile(task->hash(), arrray, format, type);
             task->setTileFetched(tile);
             found = true;
         }
+        //-- Don't hold on to the read snapshot, it keeps the WAL from being checkpointed
+        query->finish();
     }
     if(!found) {
         qCDebug(QGCTileCacheWorkerLog) << "_getTile() (NOT in DB) HASH:" << task->hash();
@@ -408,23 +604,15 @@ QGCCacheWorker::_updateSetTotals(QGCCachedTileSet* set)
 void
 QGCCacheWorker::_updateTotals()
 {
+    //-- Kept up to date by triggers, see _createCacheIndex()
     QSqlQuery query(*_db);
-    QString s;
-    s = QString("SELECT COUNT(size), SUM(size) FROM Tiles");
-    qCDebug(QGCTileCacheWorkerLog) << "_updateTotals(): " << s;
-    if(query.exec(s)) {
-        if(query.next()) {
-            _totalCount = query.value(0).toUInt();
-            _totalSize  = query.value(1).toULongLong();
-        }
-    }
-    s = QString("SELECT COUNT(size), SUM(size) FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1)").arg(_getDefaultTileSet());
-    qCDebug(QGCTileCacheWorkerLog) << "_updateTotals(): " << s;
-    if(query.exec(s)) {
-        if(query.next()) {
-            _defaultCount = query.value(0).toUInt();
-            _defaultSize  = query.value(1).toULongLong();
-        }
+    if(query.exec("SELECT totalCount, totalSize, defaultCount, defaultSize FROM CacheTotals WHERE id = 0") && query.next()) {
+        _totalCount   = query.value(0).toUInt();
+        _totalSize    = query.value(1).toULongLong();
+        _defaultCount = query.value(2).toUInt();
+        _defaultSize  = query.value(3).toULongLong();
+    } else {
+        qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (read totals):" << query.lastError().text();
     }
     emit updateTotals(_totalCount, _totalSize, _defaultCount, _defaultSize);
     if (!_updateTimer.isValid()) {
@@ -434,16 +622,43 @@ QGCCacheWorker::_updateTotals()
     }
 }
 
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_flushTileAccess()
+{
+    if(_accessedTiles.isEmpty() || !_valid) {
+        return;
+    }
+    QSqlQuery* const query = _preparedQuery(queryTouchTile);
+    if(query) {
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        const bool transaction = _db->transaction();
+        for(const quint64 tileID : std::as_const(_accessedTiles)) {
+            query->bindValue(0, now);
+            query->bindValue(1, tileID);
+            if(!query->exec()) {
+                qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (update tile access):" << query->lastError().text();
+                break;
+            }
+        }
+        if(transaction) {
+            (void) _db->commit();
+        }
+    }
+    _accessedTiles.clear();
+}
+
 //-----------------------------------------------------------------------------
 quint64 QGCCacheWorker::_findTile(const QString &hash)
 {
     quint64 tileID = 0;
-    QSqlQuery query(*_db);
-    QString s = QString("SELECT tileID FROM Tiles WHERE hash = \"%1\"").arg(hash);
-    if(query.exec(s)) {
-        if(query.next()) {
-            tileID = query.value(0).toULongLong();
+    QSqlQuery* const query = _preparedQuery(queryFindTile);
+    if(query) {
+        query->bindValue(0, hash);
+        if(query->exec() && query->next()) {
+            tileID = query->value(0).toULongLong();
         }
+        query->finish();
     }
     return tileID;
 }
@@ -491,16 +706,19 @@ QGCCacheWorker::_createTileSet(QGCMapTask *mtask)
                         quint64 tileID = _findTile(hash);
                         if(!tileID) {
                             //-- Set to download
-                            query.prepare("INSERT OR IGNORE INTO TilesDownload(setID, hash, type, x, y, z, state) VALUES(?, ?, ?, ?, ? ,? ,?)");
-                            query.addBindValue(setID);
-                            query.addBindValue(hash);
-                            query.addBindValue(UrlFactory::getQtMapIdFromProviderType(type));
-                            query.addBindValue(x);
-                            query.addBindValue(y);
-                            query.addBindValue(z);
-                            query.addBindValue(0);
-                            if(!query.exec()) {
-                                qWarning() << "Map Cache SQL error (add tile into TilesDownload):" << query.lastError().text();
+                            QSqlQuery* const downloadQuery = _preparedQuery(queryAddDownload);
+                            if(downloadQuery) {
+                                downloadQuery->bindValue(0, setID);
+                                downloadQuery->bindValue(1, hash);
+                                downloadQuery->bindValue(2, UrlFactory::getQtMapIdFromProviderType(type));
+                                downloadQuery->bindValue(3, x);
+                                downloadQuery->bindValue(4, y);
+                                downloadQuery->bindValue(5, z);
+                                downloadQuery->bindValue(6, 0);
+                            }
+                            if(!downloadQuery || !downloadQuery->exec()) {
+                                qWarning() << "Map Cache SQL error (add tile into TilesDownload):" << (downloadQuery ? downloadQuery->lastError().text() : QString());
+                                (void) _db->rollback();
                                 mtask->setError("Error creating tile set download list");
                                 return;
                             } else
@@ -508,8 +726,7 @@ QGCCacheWorker::_createTileSet(QGCMapTask *mtask)
                         } else {
                             //-- Tile already in the database. No need to dowload.
                             QString s = QString("INSERT OR IGNORE INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(tileID).arg(setID);
-                            query.prepare(s);
-                            if(!query.exec()) {
+                            if(!query.exec(s)) {
                                 qWarning() << "Map Cache SQL error (add tile into SetTiles):" << query.lastError().text();
                             }
                             qCDebug(QGCTileCacheWorkerLog) << "_createTileSet() Already Cached HASH:" << hash;
@@ -536,9 +753,17 @@ QGCCacheWorker::_getTileDownloadList(QGCMapTask* mtask)
     }
     QQueue<QGCTile*> tiles;
     QGCGetTileDownloadListTask* task = static_cast<QGCGetTileDownloadListTask*>(mtask);
+    // Claim the batch as one rowid range: the selected rows are the first pending ones in rowid order, so every
+    // pending row within the range is part of the batch and a single UPDATE marks them all
+    const bool transaction = _db->transaction();
     QSqlQuery query(*_db);
-    QString s = QString("SELECT hash, type, x, y, z FROM TilesDownload WHERE setID = %1 AND state = 0 LIMIT %2").arg(task->setID()).arg(task->count());
-    if(query.exec(s)) {
+    query.prepare("SELECT rowid, hash, type, x, y, z FROM TilesDownload WHERE setID = ? AND state = ? ORDER BY rowid LIMIT ?");
+    query.addBindValue(task->setID());
+    query.addBindValue(static_cast<int>(QGCTile::StatePending));
+    query.addBindValue(task->count());
+    qint64 firstRow = -1;
+    qint64 lastRow = -1;
+    if(query.exec()) {
         while(query.next()) {
             QGCTile* tile = new QGCTile;
             // tile->setTileSet(task->setID());
@@ -548,13 +773,28 @@ QGCCacheWorker::_getTileDownloadList(QGCMapTask* mtask)
             tile->setY(query.value("y").toInt());
             tile->setZ(query.value("z").toInt());
             tiles.enqueue(tile);
-        }
-        for(int i = 0; i < tiles.size(); i++) {
-            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 and hash = \"%3\"").arg(static_cast<int>(QGCTile::StateDownloading)).arg(task->setID()).arg(tiles[i]->hash());
-            if(!query.exec(s)) {
-                qWarning() << "Map Cache SQL error (set TilesDownload state):" << query.lastError().text();
+            lastRow = query.value(0).toLongLong();
+            if(firstRow < 0) {
+                firstRow = lastRow;
             }
         }
+        query.finish();
+    } else {
+        qWarning() << "Map Cache SQL error (select TilesDownload):" << query.lastError().text();
+    }
+    if(!tiles.isEmpty()) {
+        query.prepare("UPDATE TilesDownload SET state = ? WHERE setID = ? AND state = ? AND rowid BETWEEN ? AND ?");
+        query.addBindValue(static_cast<int>(QGCTile::StateDownloading));
+        query.addBindValue(task->setID());
+        query.addBindValue(static_cast<int>(QGCTile::StatePending));
+        query.addBindValue(firstRow);
+        query.addBindValue(lastRow);
+        if(!query.exec()) {
+            qWarning() << "Map Cache SQL error (set TilesDownload state):" << query.lastError().text();
+        }
+    }
+    if(transaction) {
+        (void) _db->commit();
     }
     task->setTileListFetched(tiles);
 }
@@ -567,19 +807,29 @@ QGCCacheWorker::_updateTileDownloadState(QGCMapTask* mtask)
         return;
     }
     QGCUpdateTileDownloadStateTask* task = static_cast<QGCUpdateTileDownloadStateTask*>(mtask);
-    QSqlQuery query(*_db);
-    QString s;
+    QSqlQuery* query = nullptr;
     if(task->state() == QGCTile::StateComplete) {
-        s = QString("DELETE FROM TilesDownload WHERE setID = %1 AND hash = \"%2\"").arg(task->setID()).arg(task->hash());
+        query = _preparedQuery(queryDeleteDownload);
+        if(query) {
+            query->bindValue(0, task->setID());
+            query->bindValue(1, task->hash());
+        }
+    } else if(task->hash() == "*") {
+        query = _preparedQuery(queryUpdateSetDownload);
+        if(query) {
+            query->bindValue(0, static_cast<int>(task->state()));
+            query->bindValue(1, task->setID());
+        }
     } else {
-        if(task->hash() == "*") {
-            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2").arg(static_cast<int>(task->state())).arg(task->setID());
-        } else {
-            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 AND hash = \"%3\"").arg(static_cast<int>(task->state())).arg(task->setID()).arg(task->hash());
+        query = _preparedQuery(queryUpdateDownload);
+        if(query) {
+            query->bindValue(0, static_cast<int>(task->state()));
+            query->bindValue(1, task->setID());
+            query->bindValue(2, task->hash());
         }
     }
-    if(!query.exec(s)) {
-        qWarning() << "QGCCacheWorker::_updateTileDownloadState() Error:" << query.lastError().text();
+    if(query && !query->exec()) {
+        qWarning() << "QGCCacheWorker::_updateTileDownloadState() Error:" << query->lastError().text();
     }
 }
 
@@ -591,26 +841,55 @@ QGCCacheWorker::_pruneCache(QGCMapTask* mtask)
         return;
     }
     QGCPruneCacheTask* task = static_cast<QGCPruneCacheTask*>(mtask);
+    //-- Recently viewed tiles must not be evicted as if they were old
+    _flushTileAccess();
     QSqlQuery query(*_db);
-    QString s;
-    //-- Select tiles in default set only, sorted by oldest.
-    s = QString("SELECT tileID, size, hash FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1) ORDER BY DATE ASC LIMIT 128").arg(_getDefaultTileSet());
-    qint64 amount = (qint64)task->amount();
-    QList<quint64> tlist;
-    if(query.exec(s)) {
-        while(query.next() && amount >= 0) {
-            tlist << query.value(0).toULongLong();
-            amount -= query.value(1).toULongLong();
-            qCDebug(QGCTileCacheWorkerLog) << "_pruneCache() HASH:" << query.value(2).toString();
+    qint64 amount = static_cast<qint64>(task->amount());
+    quint64 pruned = 0;
+    while(amount > 0) {
+        //-- Least recently used tiles of the default set only, as many as it takes to free the amount
+        query.prepare("SELECT size FROM TileLru ORDER BY accessed ASC, tileID ASC LIMIT ?");
+        query.addBindValue(kPruneChunkTiles);
+        if(!query.exec()) {
+            qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (select LRU tiles):" << query.lastError().text();
+            break;
         }
-        while(tlist.count()) {
-            s = QString("DELETE FROM Tiles WHERE tileID = %1").arg(tlist[0]);
-            tlist.removeFirst();
-            if(!query.exec(s))
+        int count = 0;
+        while((amount > 0) && query.next()) {
+            amount -= query.value(0).toLongLong();
+            count++;
+        }
+        query.finish();
+        if(count == 0) {
+            break;
+        }
+        const bool transaction = _db->transaction();
+        bool ok = true;
+        for(const char* const s : { "DELETE FROM SetTiles WHERE tileID IN (SELECT tileID FROM TileLru ORDER BY accessed ASC, tileID ASC LIMIT ?)",
+                                    "DELETE FROM Tiles WHERE tileID IN (SELECT tileID FROM TileLru ORDER BY accessed ASC, tileID ASC LIMIT ?)" }) {
+            query.prepare(s);
+            query.addBindValue(count);
+            if(!query.exec()) {
+                qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (prune):" << query.lastError().text();
+                ok = false;
                 break;
+            }
         }
-        task->setPruned();
+        if(transaction) {
+            if(ok) {
+                (void) _db->commit();
+            } else {
+                (void) _db->rollback();
+            }
+        }
+        if(!ok) {
+            break;
+        }
+        pruned += count;
+        _runFetchTasks();
     }
+    qCDebug(QGCTileCacheWorkerLog) << "_pruneCache() pruned" << pruned << "tiles";
+    task->setPruned();
 }
 
 //-----------------------------------------------------------------------------
@@ -667,6 +946,7 @@ QGCCacheWorker::_resetCacheDatabase(QGCMapTask* mtask)
         return;
     }
     QGCResetTask* task = static_cast<QGCResetTask*>(mtask);
+    _resetPreparedQueries();
     QSqlQuery query(*_db);
     QString s;
     s = QString("DROP TABLE Tiles");
@@ -677,6 +957,11 @@ QGCCacheWorker::_resetCacheDatabase(QGCMapTask* mtask)
     query.exec(s);
     s = QString("DROP TABLE TilesDownload");
     query.exec(s);
+    s = QString("DROP TABLE TileLru");
+    query.exec(s);
+    s = QString("DROP TABLE CacheTotals");
+    query.exec(s);
+    _accessedTiles.clear();
     _valid = _createDB(*_db);
     task->setResetCompleted();
 }
@@ -689,12 +974,27 @@ QGCCacheWorker::_importSets(QGCMapTask* mtask)
         return;
     }
     QGCImportTileTask* task = static_cast<QGCImportTileTask*>(mtask);
+    //-- Archives are always merged into the database
+    const ArchiveFormat format = _archiveFormat(task->path());
+    if(format != ArchiveFormat::Database) {
+        if(format == ArchiveFormat::MBTiles) {
+            _importMBTiles(task);
+        } else {
+            _importPMTiles(task);
+        }
+        task->setImportCompleted();
+        return;
+    }
     //-- If replacing, simply copy over it
     if(task->replace()) {
         //-- Close and delete old database
+        _accessedTiles.clear();
         _disconnectDB();
         QFile file(_databasePath);
         file.remove();
+        //-- WAL files of the old database must not be applied to the new one
+        (void) QFile::remove(_databasePath + QStringLiteral("-wal"));
+        (void) QFile::remove(_databasePath + QStringLiteral("-shm"));
         //-- Copy given database
         QFile::copy(task->path(), _databasePath);
         task->setProgress(25);
@@ -743,18 +1043,7 @@ QGCCacheWorker::_importSets(QGCMapTask* mtask)
                         quint64 insertSetID     = _getDefaultTileSet();
                         //-- If not default set, create new one
                         if(!defaultSet) {
-                            //-- Check if we have this tile set already
-                            if(_findTileSetID(name, insertSetID)) {
-                                int testCount = 0;
-                                //-- Set with this name already exists. Make name unique.
-                                while (true) {
-                                    auto testName = QString::asprintf("%s %02d", name.toLatin1().data(), ++testCount);
-                                    if(!_findTileSetID(testName, insertSetID) || testCount > 99) {
-                                        name = testName;
-                                        break;
-                                    }
-                                }
-                            }
+                            name = _uniqueTileSetName(name);
                             //-- Create new set
                             QSqlQuery cQuery(*_db);
                             cQuery.prepare("INSERT INTO TileSets("
@@ -868,6 +1157,16 @@ QGCCacheWorker::_exportSets(QGCMapTask* mtask)
         return;
     }
     QGCExportTileTask* task = static_cast<QGCExportTileTask*>(mtask);
+    const ArchiveFormat format = _archiveFormat(task->path());
+    if(format != ArchiveFormat::Database) {
+        if(format == ArchiveFormat::MBTiles) {
+            _exportMBTiles(task);
+        } else {
+            _exportPMTiles(task);
+        }
+        task->setExportCompleted();
+        return;
+    }
     //-- Delete target if it exists
     QFile file(task->path());
     file.remove();
@@ -969,6 +1268,423 @@ QGCCacheWorker::_exportSets(QGCMapTask* mtask)
     task->setExportCompleted();
 }
 
+//-----------------------------------------------------------------------------
+QString
+QGCCacheWorker::_uniqueTileSetName(const QString &name)
+{
+    quint64 setID = 0;
+    if(!_findTileSetID(name, setID)) {
+        return name;
+    }
+    //-- Set with this name already exists. Make name unique.
+    int testCount = 0;
+    while (true) {
+        auto testName = QString::asprintf("%s %02d", name.toLatin1().data(), ++testCount);
+        if(!_findTileSetID(testName, setID) || testCount > 99) {
+            return testName;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_importMBTiles(QGCImportTileTask* task)
+{
+    QGCMBTilesReader reader(task->path());
+    if(!reader.isValid()) {
+        task->setError("Error opening MBTiles archive: " + reader.errorString());
+        return;
+    }
+    ArchiveImport import;
+    import.task = task;
+    import.mapType = _archiveMapType(reader.metadata().value(kArchiveMapTypeKey), task->mapType());
+    import.tileCount = reader.tileCount();
+    double west, south, east, north;
+    reader.bounds(west, south, east, north);
+    const QString name = reader.metadata().value("name", QFileInfo(task->path()).completeBaseName());
+    if(!import.tileCount) {
+        task->setError("No tiles in MBTiles archive");
+    } else if(_beginArchiveImport(import, name, north, west, south, east, reader.minZoom(), reader.maxZoom())) {
+        if(!reader.forEachTile([this, &import](int z, int x, int y, const QByteArray& data) {
+            //-- Beyond the zoom levels a tile hash can hold
+            if(z <= QGCPMTiles::kMaxZoom) {
+                _importArchiveTile(import, z, x, y, data);
+            }
+            return true;
+        })) {
+            task->setError("Error reading MBTiles archive, only part of it was imported");
+        }
+        _finishArchiveImport(import);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_importPMTiles(QGCImportTileTask* task)
+{
+    QGCPMTilesReader reader(task->path());
+    if(!reader.isValid()) {
+        task->setError("Error opening PMTiles archive: " + reader.errorString());
+        return;
+    }
+    const QGCPMTiles::Header& header = reader.header();
+    if(header.tileType == QGCPMTiles::TileTypeMvt) {
+        task->setError("Vector tile archives are not supported");
+        return;
+    }
+    ArchiveImport import;
+    import.task = task;
+    import.mapType = _archiveMapType(reader.metadata().value(kArchiveMapTypeKey).toString(), task->mapType());
+    import.tileCount = header.addressedTiles;
+    const QString name = reader.metadata().value("name").toString(QFileInfo(task->path()).completeBaseName());
+    if(!import.tileCount) {
+        task->setError("No tiles in PMTiles archive");
+    } else if(_beginArchiveImport(import, name, header.maxLat, header.minLon, header.minLat, header.maxLon, header.minZoom, header.maxZoom)) {
+        if(!reader.forEachTile([this, &import](int z, int x, int y, const QByteArray& data) {
+            _importArchiveTile(import, z, x, y, data);
+            return true;
+        })) {
+            task->setError("PMTiles archive is corrupt, only part of it was imported");
+        }
+        _finishArchiveImport(import);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_beginArchiveImport(ArchiveImport& import, const QString& name, double topleftLat, double topleftLon, double bottomRightLat, double bottomRightLon, int minZoom, int maxZoom)
+{
+    if(import.mapType.isEmpty()) {
+        import.task->setError(QString("Archive has no %1 metadata, the map type must be given").arg(kArchiveMapTypeKey));
+        return false;
+    }
+    if(!UrlFactory::getMapProviderFromProviderType(import.mapType)) {
+        import.task->setError("Unknown map type: " + import.mapType);
+        return false;
+    }
+    QSqlQuery query(*_db);
+    query.prepare("INSERT INTO TileSets("
+        "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, defaultSet, date"
+        ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    query.addBindValue(_uniqueTileSetName(name));
+    query.addBindValue(import.mapType);
+    query.addBindValue(topleftLat);
+    query.addBindValue(topleftLon);
+    query.addBindValue(bottomRightLat);
+    query.addBindValue(bottomRightLon);
+    query.addBindValue(minZoom);
+    query.addBindValue(maxZoom);
+    query.addBindValue(UrlFactory::getQtMapIdFromProviderType(import.mapType));
+    query.addBindValue(import.tileCount);
+    query.addBindValue(0);
+    query.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
+    if(!query.exec()) {
+        qWarning() << "Map Cache SQL error (add imported tile set):" << query.lastError().text();
+        import.task->setError("Error adding imported tile set to database");
+        return false;
+    }
+    import.setID = query.lastInsertId().toULongLong();
+    (void) _db->transaction();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_importArchiveTile(ArchiveImport& import, int z, int x, int y, const QByteArray& image)
+{
+    const QString hash = UrlFactory::getTileHash(import.mapType, x, y, z);
+    QSqlQuery* const query = _preparedQuery(querySaveTile);
+    QSqlQuery* const setQuery = _preparedQuery(querySaveSetTile);
+    if(query && setQuery) {
+        query->bindValue(0, hash);
+        query->bindValue(1, UrlFactory::getImageFormat(import.mapType, image));
+        query->bindValue(2, image);
+        query->bindValue(3, image.size());
+        query->bindValue(4, import.mapType);
+        query->bindValue(5, QDateTime::currentDateTime().toSecsSinceEpoch());
+        quint64 tileID = 0;
+        if(query->exec()) {
+            tileID = query->lastInsertId().toULongLong();
+            import.tilesSaved++;
+        } else {
+            //-- Already cached, it only joins the set
+            tileID = _findTile(hash);
+        }
+        if(tileID) {
+            setQuery->bindValue(0, tileID);
+            setQuery->bindValue(1, import.setID);
+            if(!setQuery->exec()) {
+                qWarning() << "Map Cache SQL error (add tile into SetTiles):" << setQuery->lastError().text();
+            }
+        }
+    }
+    import.tilesRead++;
+    if((import.tilesRead % kArchiveChunkTiles) == 0) {
+        //-- Keep the map responsive during long imports
+        if(!_db->commit()) {
+            qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (commit import):" << _db->lastError().text();
+        }
+        _runFetchTasks();
+        (void) _db->transaction();
+    }
+    const int progress = static_cast<int>(qMin<quint64>(import.tilesRead * 100 / import.tileCount, 100));
+    if(progress != import.lastProgress) {
+        import.lastProgress = progress;
+        import.task->setProgress(progress);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_finishArchiveImport(ArchiveImport& import)
+{
+    if(!_db->commit()) {
+        qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (commit import):" << _db->lastError().text();
+    }
+    QSqlQuery query(*_db);
+    if(query.exec(QString("SELECT COUNT(tileID) FROM SetTiles WHERE setID = %1").arg(import.setID)) && query.next()) {
+        const quint64 count = query.value(0).toULongLong();
+        if(!count) {
+            _deleteTileSet(import.setID);
+            import.task->setError("No tiles could be imported from the archive");
+            return;
+        }
+        (void) query.exec(QString("UPDATE TileSets SET numTiles = %1 WHERE setID = %2").arg(count).arg(import.setID));
+    }
+    qCDebug(QGCTileCacheWorkerLog) << "Imported" << import.tilesRead << "tiles," << import.tilesSaved << "new, as" << import.mapType;
+    import.task->setProgress(100);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::ArchiveExport::addTile(int z, int x, int y)
+{
+    minZoom = (tileCount == 0) ? z : qMin(minZoom, z);
+    maxZoom = (tileCount == 0) ? z : qMax(maxZoom, z);
+    const double n = static_cast<double>(1 << z);
+    minLon = qMin(minLon, x / n * 360.0 - 180.0);
+    maxLon = qMax(maxLon, (x + 1) / n * 360.0 - 180.0);
+    maxLat = qMax(maxLat, qRadiansToDegrees(std::atan(std::sinh(M_PI * (1.0 - 2.0 * y / n)))));
+    minLat = qMin(minLat, qRadiansToDegrees(std::atan(std::sinh(M_PI * (1.0 - 2.0 * (y + 1) / n)))));
+    tileCount++;
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_beginArchiveExport(QGCExportTileTask* task, ArchiveExport& archive, QSqlQuery& tiles)
+{
+    //-- An archive holds tiles of a single map type. The default set mixes all types, only those of the
+    //   other exported sets are taken from it.
+    QStringList names;
+    QStringList setIDs;
+    for(QGCCachedTileSet* set : task->sets()) {
+        if(!set->defaultSet()) {
+            if(archive.mapType.isEmpty()) {
+                archive.mapType = set->type();
+            } else if(archive.mapType != set->type()) {
+                task->setError("All tile sets exported to an archive must use the same map type");
+                return false;
+            }
+        }
+        names.append(set->name());
+        setIDs.append(QString::number(set->id()));
+    }
+    if(archive.mapType.isEmpty()) {
+        archive.mapType = task->sets().first()->type();
+    }
+    if(archive.mapType.isEmpty()) {
+        task->setError("Tile set has no map type");
+        return false;
+    }
+    archive.name = names.join(", ");
+    const QString hashPrefix = UrlFactory::getTileHash(archive.mapType, 0, 0, 0).chopped(19) + "%";
+    const QString where = QString("WHERE tileID IN (SELECT tileID FROM SetTiles WHERE setID IN (%1)) AND hash LIKE ?").arg(setIDs.join(','));
+    QSqlQuery query(*_db);
+    query.prepare("SELECT COUNT(tileID) FROM Tiles " + where);
+    query.addBindValue(hashPrefix);
+    if(query.exec() && query.next()) {
+        archive.expectedTiles = query.value(0).toULongLong();
+    }
+    if(!archive.expectedTiles) {
+        task->setError("No tiles to export");
+        return false;
+    }
+    //-- Streamed, each tile is read once
+    tiles.setForwardOnly(true);
+    tiles.prepare("SELECT hash, format, tile FROM Tiles " + where);
+    tiles.addBindValue(hashPrefix);
+    if(!tiles.exec()) {
+        qWarning() << "Map Cache SQL error (read exported tiles):" << tiles.lastError().text();
+        task->setError("Error reading tiles to export");
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_exportMBTiles(QGCExportTileTask* task)
+{
+    QGCMBTilesWriter writer(task->path());
+    if(!writer.isValid()) {
+        task->setError("Error creating MBTiles archive: " + writer.errorString());
+        return;
+    }
+    ArchiveExport archive;
+    QSqlQuery tiles(*_db);
+    if(!_beginArchiveExport(task, archive, tiles)) {
+        return;
+    }
+    int lastProgress = -1;
+    while(tiles.next()) {
+        int x, y, z;
+        if(!UrlFactory::tileHashToXYZ(tiles.value(0).toString(), x, y, z)) {
+            continue;
+        }
+        if(archive.format.isEmpty()) {
+            archive.format = tiles.value(1).toString();
+        }
+        if(!writer.addTile(z, x, y, tiles.value(2).toByteArray())) {
+            if(!writer.isValid()) {
+                break;
+            }
+            continue;
+        }
+        archive.addTile(z, x, y);
+        const int progress = static_cast<int>(qMin<quint64>(archive.tileCount * 100 / archive.expectedTiles, 100));
+        if(progress != lastProgress) {
+            lastProgress = progress;
+            task->setProgress(progress);
+        }
+    }
+    tiles.finish();
+    const QList<QPair<QString, QString>> metadata = {
+        { "name", archive.name },
+        { "format", (archive.format == "jpeg") ? QString("jpg") : archive.format },
+        { "type", "baselayer" },
+        { "version", "1.0" },
+        { "bounds", QString("%1,%2,%3,%4").arg(archive.minLon, 0, 'f', 6).arg(archive.minLat, 0, 'f', 6).arg(archive.maxLon, 0, 'f', 6).arg(archive.maxLat, 0, 'f', 6) },
+        { "minzoom", QString::number(archive.minZoom) },
+        { "maxzoom", QString::number(archive.maxZoom) },
+        { kArchiveMapTypeKey, archive.mapType },
+    };
+    if(!writer.finish(metadata)) {
+        task->setError("Error writing MBTiles archive: " + writer.errorString());
+        return;
+    }
+    task->setProgress(100);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_exportPMTiles(QGCExportTileTask* task)
+{
+    QGCPMTilesWriter writer(task->path());
+    if(!writer.isValid()) {
+        task->setError("Error creating PMTiles archive: " + writer.errorString());
+        return;
+    }
+    ArchiveExport archive;
+    QSqlQuery tiles(*_db);
+    if(!_beginArchiveExport(task, archive, tiles)) {
+        return;
+    }
+    int lastProgress = -1;
+    while(tiles.next()) {
+        int x, y, z;
+        if(!UrlFactory::tileHashToXYZ(tiles.value(0).toString(), x, y, z)) {
+            continue;
+        }
+        if(archive.format.isEmpty()) {
+            archive.format = tiles.value(1).toString();
+        }
+        if(!writer.addTile(z, x, y, tiles.value(2).toByteArray())) {
+            if(!writer.isValid()) {
+                break;
+            }
+            continue;
+        }
+        archive.addTile(z, x, y);
+        //-- The rest of the progress is writing the archive out
+        const int progress = static_cast<int>(qMin<quint64>(archive.tileCount * 90 / archive.expectedTiles, 90));
+        if(progress != lastProgress) {
+            lastProgress = progress;
+            task->setProgress(progress);
+        }
+    }
+    tiles.finish();
+    QGCPMTiles::Header header;
+    header.tileCompression = QGCPMTiles::CompressionNone;
+    header.tileType = QGCPMTiles::tileTypeFromFormat(archive.format);
+    header.minLon = archive.minLon;
+    header.minLat = archive.minLat;
+    header.maxLon = archive.maxLon;
+    header.maxLat = archive.maxLat;
+    header.centerZoom = static_cast<quint8>(archive.minZoom);
+    header.centerLon = (archive.minLon + archive.maxLon) / 2.0;
+    header.centerLat = (archive.minLat + archive.maxLat) / 2.0;
+    QJsonObject metadata;
+    metadata.insert("name", archive.name);
+    metadata.insert("format", archive.format);
+    metadata.insert("type", "baselayer");
+    metadata.insert(kArchiveMapTypeKey, archive.mapType);
+    if(!writer.finish(header, metadata)) {
+        task->setError("Error writing PMTiles archive: " + writer.errorString());
+        return;
+    }
+    task->setProgress(100);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_attachArchive(QGCMapTask* mtask)
+{
+    QGCAttachArchiveTask* task = static_cast<QGCAttachArchiveTask*>(mtask);
+    if(task->path().isEmpty()) {
+        _archives.clear();
+        qCDebug(QGCTileCacheWorkerLog) << "Detached all tile archives";
+        return;
+    }
+    auto reader = std::make_shared<QGCPMTilesReader>(task->path());
+    if(!reader->isValid()) {
+        task->setError("Error opening PMTiles archive: " + reader->errorString());
+        return;
+    }
+    const QString mapType = _archiveMapType(reader->metadata().value(kArchiveMapTypeKey).toString(), task->mapType());
+    if(mapType.isEmpty() || !UrlFactory::getMapProviderFromProviderType(mapType)) {
+        task->setError(QString("Archive has no valid %1 metadata, the map type must be given").arg(kArchiveMapTypeKey));
+        return;
+    }
+    //-- Replaces any archive attached for the same map type
+    _archives.insert(UrlFactory::getTileHash(mapType, 0, 0, 0).chopped(19), reader);
+    qCDebug(QGCTileCacheWorkerLog) << "Attached tile archive" << task->path() << "for" << mapType;
+    task->setArchiveAttached(mapType);
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_getArchiveTile(QGCMapTask* mtask)
+{
+    QGCFetchTileTask* task = static_cast<QGCFetchTileTask*>(mtask);
+    const QString& hash = task->hash();
+    if(hash.size() < 19) {
+        return false;
+    }
+    const auto it = _archives.constFind(hash.chopped(19));
+    int x, y, z;
+    if(it == _archives.constEnd() || !UrlFactory::tileHashToXYZ(hash, x, y, z)) {
+        return false;
+    }
+    const QByteArray image = it.value()->tile(z, x, y);
+    if(image.isEmpty()) {
+        return false;
+    }
+    const QString type = UrlFactory::tileHashToType(hash);
+    qCDebug(QGCTileCacheWorkerLog) << "_getTile() (Found in archive) HASH:" << hash;
+    task->setTileFetched(new QGCCacheTile(hash, image, UrlFactory::getImageFormat(type, image), type));
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 bool QGCCacheWorker::_testTask(QGCMapTask* mtask)
 {
@@ -1010,11 +1726,79 @@ QGCCacheWorker::_connectDB()
 {
     _db.reset(new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kSession)));
     _db->setDatabaseName(_databasePath);
-    _db->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
     _valid = _db->open();
+    if(!_valid) {
+        return false;
+    }
+    _configureConnection(*_db, true);
+
+    //-- Opened after the writer switched to WAL, reads then never wait on a write transaction
+    _readDb.reset(new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kReadSession)));
+    _readDb->setDatabaseName(_databasePath);
+    _readDb->setConnectOptions("QSQLITE_OPEN_READONLY");
+    if(_readDb->open()) {
+        _configureConnection(*_readDb, false);
+    } else {
+        qCWarning(QGCTileCacheWorkerLog) << "Read-only connection failed, reading through the writer:" << _readDb->lastError().text();
+        _readDb.reset();
+        QSqlDatabase::removeDatabase(kReadSession);
+    }
     return _valid;
 }
 
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_configureConnection(QSqlDatabase& db, bool writer)
+{
+    QSqlQuery query(db);
+    if(writer) {
+        if(!query.exec("PRAGMA journal_mode=WAL") || !query.next() || (query.value(0).toString().compare("wal", Qt::CaseInsensitive) != 0)) {
+            qCWarning(QGCTileCacheWorkerLog) << "WAL journal not available:" << query.lastError().text();
+        }
+        //-- With WAL, NORMAL only syncs on checkpoints. A crash may lose the last commits, never the database.
+        (void) query.exec("PRAGMA synchronous=NORMAL");
+    }
+    (void) query.exec(QString("PRAGMA cache_size=-%1").arg(kCacheSizeKiB));
+    (void) query.exec("PRAGMA temp_store=MEMORY");
+}
+
+//-----------------------------------------------------------------------------
+QSqlQuery*
+QGCCacheWorker::_preparedQuery(PreparedQuery id)
+{
+    static constexpr const char* kQueries[queryCount] = {
+        "INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)",
+        "INSERT INTO SetTiles(tileID, setID) VALUES(?, ?)",
+        "SELECT tileID FROM Tiles WHERE hash = ?",
+        "SELECT tile, format, type, tileID FROM Tiles WHERE hash = ?",
+        "INSERT OR IGNORE INTO TilesDownload(setID, hash, type, x, y, z, state) VALUES(?, ?, ?, ?, ?, ?, ?)",
+        "DELETE FROM TilesDownload WHERE setID = ? AND hash = ?",
+        "UPDATE TilesDownload SET state = ? WHERE setID = ? AND hash = ?",
+        "UPDATE TilesDownload SET state = ? WHERE setID = ?",
+        "UPDATE TileLru SET accessed = ? WHERE tileID = ?",
+    };
+
+    std::unique_ptr<QSqlQuery>& query = _preparedQueries[id];
+    if(!query) {
+        QSqlDatabase& db = ((id == queryGetTile) && _readDb) ? *_readDb : *_db;
+        query = std::make_unique<QSqlQuery>(db);
+        if(!query->prepare(kQueries[id])) {
+            qCWarning(QGCTileCacheWorkerLog) << "Map Cache SQL error (prepare):" << kQueries[id] << query->lastError().text();
+            query.reset();
+        }
+    }
+    return query.get();
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_resetPreparedQueries()
+{
+    for(std::unique_ptr<QSqlQuery>& query : _preparedQueries) {
+        query.reset();
+    }
+}
+
 //-----------------------------------------------------------------------------
 bool
 QGCCacheWorker::_createDB(QSqlDatabase& db, bool createDefault)
@@ -1072,8 +1856,11 @@ QGCCacheWorker::_createDB(QSqlDatabase& db, bool createDefault)
                 {
                     qWarning() << "Map Cache SQL error (create TilesDownload db):" << query.lastError().text();
                 } else {
+                    if(!query.exec("CREATE INDEX IF NOT EXISTS TilesDownloadState ON TilesDownload ( setID, state )")) {
+                        qWarning() << "Map Cache SQL error (create TilesDownload index):" << query.lastError().text();
+                    }
                     //-- Database it ready for use
-                    res = true;
+                    res = _createCacheIndex(db);
                 }
             }
         }
@@ -1103,10 +1890,99 @@ QGCCacheWorker::_createDB(QSqlDatabase& db, bool createDefault)
     return res;
 }
 
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_createCacheIndex(QSqlDatabase& db)
+{
+    //-- TileLru holds the tiles which are only in the default set, the ones pruning may evict, by last access.
+    //   CacheTotals holds the counts and sizes _updateTotals() reports. Pruning and totals are then independent
+    //   of the size of the cache.
+    static constexpr const char* kStatements[] = {
+        "CREATE INDEX IF NOT EXISTS SetTilesTile ON SetTiles ( tileID )",
+        "CREATE TABLE IF NOT EXISTS TileLru ("
+            "tileID INTEGER PRIMARY KEY NOT NULL, "
+            "size INTEGER NOT NULL, "
+            "accessed INTEGER NOT NULL)",
+        "CREATE INDEX IF NOT EXISTS TileLruAccessed ON TileLru ( accessed )",
+        "CREATE TABLE IF NOT EXISTS CacheTotals ("
+            "id INTEGER PRIMARY KEY CHECK (id = 0), "
+            "totalCount INTEGER NOT NULL, "
+            "totalSize INTEGER NOT NULL, "
+            "defaultCount INTEGER NOT NULL, "
+            "defaultSize INTEGER NOT NULL)",
+        "CREATE TRIGGER IF NOT EXISTS TilesInsertTotals AFTER INSERT ON Tiles BEGIN "
+            "UPDATE CacheTotals SET totalCount = totalCount + 1, totalSize = totalSize + IFNULL(NEW.size, 0); "
+        "END",
+        "CREATE TRIGGER IF NOT EXISTS TilesDeleteTotals AFTER DELETE ON Tiles BEGIN "
+            "UPDATE CacheTotals SET totalCount = totalCount - 1, totalSize = totalSize - IFNULL(OLD.size, 0); "
+            "DELETE FROM TileLru WHERE tileID = OLD.tileID; "
+        "END",
+        "CREATE TRIGGER IF NOT EXISTS TileLruInsertTotals AFTER INSERT ON TileLru BEGIN "
+            "UPDATE CacheTotals SET defaultCount = defaultCount + 1, defaultSize = defaultSize + NEW.size; "
+        "END",
+        "CREATE TRIGGER IF NOT EXISTS TileLruDeleteTotals AFTER DELETE ON TileLru BEGIN "
+            "UPDATE CacheTotals SET defaultCount = defaultCount - 1, defaultSize = defaultSize - OLD.size; "
+        "END",
+        //-- A tile added to another set is no longer evictable, one added to the default set alone is
+        "CREATE TRIGGER IF NOT EXISTS SetTilesInsertLru AFTER INSERT ON SetTiles BEGIN "
+            "DELETE FROM TileLru WHERE tileID = NEW.tileID AND NEW.setID IS NOT (SELECT setID FROM TileSets WHERE defaultSet = 1); "
+            "INSERT OR IGNORE INTO TileLru(tileID, size, accessed) SELECT tileID, IFNULL(size, 0), date FROM Tiles "
+                "WHERE tileID = NEW.tileID AND NEW.setID = (SELECT setID FROM TileSets WHERE defaultSet = 1) "
+                "AND NOT EXISTS (SELECT 1 FROM SetTiles WHERE tileID = NEW.tileID AND setID IS NOT NEW.setID); "
+        "END",
+        //-- A tile left in the default set alone when another set is deleted becomes evictable
+        "CREATE TRIGGER IF NOT EXISTS SetTilesDeleteLru AFTER DELETE ON SetTiles BEGIN "
+            "INSERT OR IGNORE INTO TileLru(tileID, size, accessed) SELECT tileID, IFNULL(size, 0), date FROM Tiles "
+                "WHERE tileID = OLD.tileID "
+                "AND EXISTS (SELECT 1 FROM SetTiles WHERE tileID = OLD.tileID AND setID = (SELECT setID FROM TileSets WHERE defaultSet = 1)) "
+                "AND NOT EXISTS (SELECT 1 FROM SetTiles WHERE tileID = OLD.tileID AND setID IS NOT (SELECT setID FROM TileSets WHERE defaultSet = 1)); "
+        "END",
+    };
+
+    QSqlQuery query(db);
+    for(const char* const s : kStatements) {
+        if(!query.exec(s)) {
+            qWarning() << "Map Cache SQL error (create cache index):" << query.lastError().text();
+            return false;
+        }
+    }
+
+    if(query.exec("SELECT COUNT(*) FROM CacheTotals") && query.next() && (query.value(0).toInt() > 0)) {
+        return true;
+    }
+
+    //-- Database from before the index. The totals row is inserted last, so filling TileLru does not count twice.
+    qCDebug(QGCTileCacheWorkerLog) << "Building map cache LRU index";
+    const bool transaction = db.transaction();
+    const bool ok =
+        query.exec("INSERT OR IGNORE INTO TileLru(tileID, size, accessed) SELECT tileID, IFNULL(size, 0), date FROM Tiles WHERE tileID IN "
+                   "(SELECT tileID FROM SetTiles GROUP BY tileID HAVING COUNT(DISTINCT setID) = 1 "
+                   "AND MIN(setID) = (SELECT setID FROM TileSets WHERE defaultSet = 1))") &&
+        query.exec("INSERT INTO CacheTotals(id, totalCount, totalSize, defaultCount, defaultSize) SELECT 0, "
+                   "(SELECT COUNT(*) FROM Tiles), (SELECT IFNULL(SUM(size), 0) FROM Tiles), COUNT(*), IFNULL(SUM(size), 0) FROM TileLru");
+    if(!ok) {
+        qWarning() << "Map Cache SQL error (build cache index):" << query.lastError().text();
+    }
+    if(transaction) {
+        if(ok) {
+            (void) db.commit();
+        } else {
+            (void) db.rollback();
+        }
+    }
+    return ok;
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCCacheWorker::_disconnectDB()
 {
+    //-- Queries must be gone before their connection
+    _resetPreparedQueries();
+    if (_readDb) {
+        _readDb.reset();
+        QSqlDatabase::removeDatabase(kReadSession);
+    }
     if (_db) {
         _db.reset();
         QSqlDatabase::removeDatabase(kSession);
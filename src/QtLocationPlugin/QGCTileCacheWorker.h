@@ -18,19 +18,35 @@
 
 #pragma once
 
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QMutex>
 #include <QtCore/QQueue>
+#include <QtCore/QSet>
 #include <QtCore/QString>
 #include <QtCore/QThread>
 #include <QtCore/QWaitCondition>
 
+#include <array>
+#include <memory>
+
 Q_DECLARE_LOGGING_CATEGORY(QGCTileCacheWorkerLog)
 
 class QGCMapTask;
 class QGCCachedTileSet;
+class QGCExportTileTask;
+class QGCImportTileTask;
+class QGCPMTilesReader;
 class QSqlDatabase;
-
+class QSqlQuery;
+
+/// Runs map cache tasks against the SQLite tile database.
+/// Tasks are queued by priority class (see TaskPriority). Tile fetches are always served first, from a separate
+/// read-only connection, even between the writes of a batch. Runs of queued tile saves and download state updates
+/// are written in a single transaction. The database is in WAL mode, so fetches are served from the last committed
+/// state even while a write transaction is open.
+/// Tile sets are exchanged as QGC databases, MBTiles or PMTiles archives, picked by file extension. Attached PMTiles
+/// archives are consulted before the database when fetching tiles.
 class QGCCacheWorker : public QThread
 {
     Q_OBJECT
@@ -39,6 +55,23 @@ public:
     explicit QGCCacheWorker(QObject *parent = nullptr);
     ~QGCCacheWorker();
 
+    enum TaskPriority {
+        PriorityFetch,          ///< Tile lookups for the visible map
+        PriorityInteractive,    ///< Tiles cached while browsing and user requested operations
+        PriorityBackground,     ///< Tile set download bookkeeping
+        PriorityCount
+    };
+
+    struct QueueMetrics {
+        quint64 depth = 0;      ///< Tasks waiting
+        quint64 peakDepth = 0;
+        quint64 processed = 0;
+        quint64 cancelled = 0;  ///< Dropped without running
+    };
+
+    QueueMetrics queueMetrics(TaskPriority priority);
+    static TaskPriority taskPriority(const QGCMapTask *task);
+
     void setDatabaseFile(const QString &path) { _databasePath = path; }
 
 public slots:
@@ -53,6 +86,16 @@ protected:
 
 private:
     void _runTask(QGCMapTask *task);
+    void _runBatch(const QList<QGCMapTask*> &batch);
+    void _runFetchTasks();
+    static bool _isBatchable(const QGCMapTask *task);
+
+    /// User requested operations which must not overtake background tasks queued before them
+    static bool _isBarrier(const QGCMapTask *task);
+
+    /// Takes the next interactive or background task, along with the tasks which can be batched with it
+    ///     Must be called with _taskQueueMutex locked
+    QList<QGCMapTask*> _takeWriteBatch();
 
     void _saveTile(QGCMapTask *task);
     void _getTile(QGCMapTask *task);
@@ -66,11 +109,17 @@ private:
     void _resetCacheDatabase(QGCMapTask *task);
     void _importSets(QGCMapTask *task);
     void _exportSets(QGCMapTask *task);
+    void _attachArchive(QGCMapTask *task);
+    bool _getArchiveTile(QGCMapTask *task);
     bool _testTask(QGCMapTask *task);
 
     bool _connectDB();
     void _disconnectDB();
+    static void _configureConnection(QSqlDatabase &db, bool writer);
     bool _createDB(QSqlDatabase &db, bool createDefault = true);
+    /// Creates the LRU index of the default set and the running totals, both kept up to date by triggers.
+    /// Filled from the tiles once when missing.
+    bool _createCacheIndex(QSqlDatabase &db);
     bool _findTileSetID(const QString &name, quint64 &setID);
     bool _init();
     quint64 _findTile(const QString &hash);
@@ -79,10 +128,83 @@ private:
     void _deleteTileSet(quint64 id);
     void _updateSetTotals(QGCCachedTileSet *set);
     void _updateTotals();
+    /// Writes the access time of the tiles fetched since the last flush to the LRU index
+    void _flushTileAccess();
+    QString _uniqueTileSetName(const QString &name);
+
+    /// State of an MBTiles or PMTiles import. Tiles are written in transactions of kArchiveChunkTiles, fetches
+    /// are served between them.
+    struct ArchiveImport {
+        QGCImportTileTask *task = nullptr;
+        QString mapType;
+        quint64 setID = 0;
+        quint64 tileCount = 0;      ///< Tiles in the archive
+        quint64 tilesRead = 0;
+        quint64 tilesSaved = 0;     ///< Tiles which were not in the database yet
+        int lastProgress = -1;
+    };
+
+    void _importMBTiles(QGCImportTileTask *task);
+    void _importPMTiles(QGCImportTileTask *task);
+    bool _beginArchiveImport(ArchiveImport &import, const QString &name, double topleftLat, double topleftLon, double bottomRightLat, double bottomRightLon, int minZoom, int maxZoom);
+    void _importArchiveTile(ArchiveImport &import, int z, int x, int y, const QByteArray &image);
+    void _finishArchiveImport(ArchiveImport &import);
+
+    /// MBTiles or PMTiles export, of the tiles of the exported sets which belong to the map type of the export
+    struct ArchiveExport {
+        QString mapType;
+        QString name;
+        QString format;
+        quint64 expectedTiles = 0;
+        quint64 tileCount = 0;      ///< Tiles exported so far
+        int minZoom = 0;
+        int maxZoom = 0;
+        double minLon = 180.;
+        double minLat = 90.;
+        double maxLon = -180.;
+        double maxLat = -90.;
+
+        /// Extends the zoom range and bounds by the tile
+        void addTile(int z, int x, int y);
+    };
+
+    /// Starts reading the tiles to export, each tile once
+    bool _beginArchiveExport(QGCExportTileTask *task, ArchiveExport &archive, QSqlQuery &tiles);
+    void _exportMBTiles(QGCExportTileTask *task);
+    void _exportPMTiles(QGCExportTileTask *task);
+
+    enum PreparedQuery {
+        querySaveTile,
+        querySaveSetTile,
+        queryFindTile,
+        queryGetTile,
+        queryAddDownload,
+        queryDeleteDownload,
+        queryUpdateDownload,
+        queryUpdateSetDownload,
+        queryTouchTile,
+        queryCount
+    };
+
+    /// Statement prepared on first use and kept until the connection is closed
+    ///     @return nullptr: prepare failed
+    QSqlQuery *_preparedQuery(PreparedQuery id);
+    void _resetPreparedQueries();
 
     std::shared_ptr<QSqlDatabase> _db = nullptr;
+    std::shared_ptr<QSqlDatabase> _readDb = nullptr;       ///< Read-only connection for tile fetches, nullptr: fetches use _db
+    std::array<std::unique_ptr<QSqlQuery>, queryCount> _preparedQueries;
+    QHash<QString, std::shared_ptr<QGCPMTilesReader>> _archives;   ///< Attached archives by provider hash prefix of the tile hash
+    QSet<quint64> _accessedTiles;                         ///< Fetched since the last _flushTileAccess()
+    struct QueuedTask {
+        QGCMapTask *task;
+        quint64 seq;            ///< Enqueue order across all classes
+    };
+
     QMutex _taskQueueMutex;
-    QQueue<QGCMapTask*> _taskQueue;
+    std::array<QQueue<QueuedTask>, PriorityCount> _queues;
+    std::array<QueueMetrics, PriorityCount> _metrics;
+    quint64 _nextSeq = 0;
     QWaitCondition _waitc;
     QString _databasePath;
     quint32 _defaultCount = 0;
@@ -97,7 +219,13 @@ private:
 
     static QByteArray _bingNoTileImage;
     static constexpr const char *kSession = "QGeoTileWorkerSession";
+    static constexpr const char *kReadSession = "QGeoTileReadSession";
     static constexpr const char *kExportSession = "QGeoTileExportSession";
+    static constexpr int kMaxBatchTasks = 256;          ///< Tasks written per transaction
+    static constexpr int kArchiveChunkTiles = 1000;     ///< Archive tiles imported or exported per transaction
+    static constexpr int kCacheSizeKiB = 8 * 1024;      ///< SQLite page cache per connection
+    static constexpr int kPruneChunkTiles = 512;        ///< Tiles evicted per transaction
+    static constexpr int kMaxPendingAccess = 1024;      ///< Fetched tiles whose access time is written at once
     static constexpr int kShortTimeout = 2;
     static constexpr int kLongTimeout = 5;
 };
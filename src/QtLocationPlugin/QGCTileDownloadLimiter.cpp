@@ -0,0 +1,141 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileDownloadLimiter.h"
+
+QGCTileDownloadLimiter::QGCTileDownloadLimiter(int initialLimit, int maxLimit)
+    : _initialLimit(qBound(kMinLimit, static_cast<double>(initialLimit), static_cast<double>(maxLimit)))
+    , _maxLimit(qMax(kMinLimit, static_cast<double>(maxLimit)))
+    , _limit(_initialLimit)
+{
+
+}
+
+void QGCTileDownloadLimiter::reset(int initialLimit)
+{
+    if (initialLimit > 0) {
+        _initialLimit = qBound(kMinLimit, static_cast<double>(initialLimit), _maxLimit);
+    }
+    _limit = _initialLimit;
+    _rtt = 0.;
+    _rttDev = 0.;
+    _rttSamples = 0;
+    _baseRtt = 0.;
+    _slowStart = true;
+    _consecutiveErrors = 0;
+    _resumeAtMs = 0;
+    _window.clear();
+    _windowBytes = 0;
+}
+
+void QGCTileDownloadLimiter::requestSucceeded(qint64 nowMs, qint64 latencyMs, qint64 bytes, int inFlight)
+{
+    _consecutiveErrors = 0;
+
+    _window.enqueue(Completion{ nowMs, bytes });
+    _windowBytes += bytes;
+    _pruneWindow(nowMs);
+
+    if (latencyMs < 0) {
+        return;
+    }
+
+    const double rtt = qMax<double>(latencyMs, 1.);
+    if (_rttSamples++ == 0) {
+        _rtt = rtt;
+    } else {
+        _rttDev += kRttAlpha * (qAbs(rtt - _rtt) - _rttDev);
+        _rtt += kRttAlpha * (rtt - _rtt);
+    }
+    if (_rttSamples < kWarmupSamples) {
+        return;
+    }
+    _baseRtt = (_baseRtt <= 0.) ? _rtt : qMin(_baseRtt, _rtt);
+
+    const double queued = _limit * qMax(0., _rtt - _baseRtt - _rttDev) / _rtt;
+    if (queued < kQueueLow) {
+        // With few requests in flight the latency says nothing about the capacity of the server
+        if (inFlight < (_limit / 2.)) {
+            return;
+        }
+        // Per response, so doubling or adding one per round trip
+        _limit += _slowStart ? 1. : (1. / _limit);
+    } else {
+        _slowStart = false;
+        if (queued > kQueueHigh) {
+            _limit -= 1. / _limit;
+        }
+    }
+
+    _limit = qBound(kMinLimit, _limit, _maxLimit);
+}
+
+void QGCTileDownloadLimiter::requestFailed(qint64 nowMs)
+{
+    _consecutiveErrors++;
+    _slowStart = false;
+    _limit = qMax(kMinLimit, _limit * kErrorDecrease);
+
+    if (_consecutiveErrors >= kErrorsBeforeBackoff) {
+        _backoff(nowMs, kErrorBackoffMs << qMin(_consecutiveErrors - kErrorsBeforeBackoff, 16));
+    }
+}
+
+void QGCTileDownloadLimiter::requestThrottled(qint64 nowMs, qint64 retryAfterMs)
+{
+    _consecutiveErrors++;
+    _slowStart = false;
+    _limit = qMax(kMinLimit, _limit / 2.);
+    _backoff(nowMs, qMax(retryAfterMs, kThrottleBackoffMs << qMin(_consecutiveErrors - 1, 16)));
+}
+
+void QGCTileDownloadLimiter::_backoff(qint64 nowMs, qint64 delayMs)
+{
+    _resumeAtMs = qMax(_resumeAtMs, nowMs + qMin(delayMs, kMaxBackoffMs));
+}
+
+void QGCTileDownloadLimiter::_pruneWindow(qint64 nowMs)
+{
+    while (!_window.isEmpty() && (_window.head().timeMs < (nowMs - kRateWindowMs))) {
+        _windowBytes -= _window.dequeue().bytes;
+    }
+}
+
+double QGCTileDownloadLimiter::tilesPerSecond(qint64 nowMs)
+{
+    _pruneWindow(nowMs);
+    if (_window.count() < 2) {
+        return 0.;
+    }
+
+    // Over the time the window covers so far, it is shorter than kRateWindowMs right after a start
+    const qint64 span = qMax<qint64>(nowMs - _window.head().timeMs, 1000);
+    return (_window.count() * 1000.) / span;
+}
+
+double QGCTileDownloadLimiter::bytesPerSecond(qint64 nowMs)
+{
+    _pruneWindow(nowMs);
+    if (_window.count() < 2) {
+        return 0.;
+    }
+
+    const qint64 span = qMax<qint64>(nowMs - _window.head().timeMs, 1000);
+    return (_windowBytes * 1000.) / span;
+}
+
+qint64 QGCTileDownloadLimiter::etaMs(quint64 remainingTiles, qint64 nowMs)
+{
+    const double rate = tilesPerSecond(nowMs);
+    if (rate <= 0.) {
+        return -1;
+    }
+
+    return static_cast<qint64>((remainingTiles * 1000.) / rate);
+}
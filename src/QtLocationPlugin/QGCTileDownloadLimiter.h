@@ -0,0 +1,93 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QQueue>
+#include <QtCore/QtGlobal>
+
+/// Picks how many tile requests a tile set download keeps in flight.
+/// The number of requests queued at the server is estimated from how far the smoothed latency is above the lowest
+/// smoothed latency seen, as in TCP Vegas. Latency within the mean deviation of the responses is taken as jitter
+/// rather than queueing, and the lowest latency is only tracked once kWarmupSamples have been smoothed, so a jittery
+/// server does not look congested. The limit doubles every round trip until a queue shows up, then grows
+/// by one per round trip while fewer than kQueueLow requests are queued and shrinks by one while more than
+/// kQueueHigh are. Errors shrink the limit, repeated errors and throttling (HTTP 429/503) also pause all requests
+/// with exponential backoff. Also measures throughput over a sliding window.
+/// All times are in milliseconds on a monotonic clock supplied by the caller.
+class QGCTileDownloadLimiter
+{
+public:
+    explicit QGCTileDownloadLimiter(int initialLimit = kDefaultInitialLimit, int maxLimit = kDefaultMaxLimit);
+
+    /// Back to the initial limit, with no latency or throughput history
+    ///     @param initialLimit Replaces the initial limit if > 0
+    void reset(int initialLimit = 0);
+
+    int limit() const { return static_cast<int>(_limit); }
+
+    /// @return Time until requests may be sent again, 0 if not backing off
+    qint64 backoffRemaining(qint64 nowMs) const { return qMax<qint64>(_resumeAtMs - nowMs, 0); }
+
+    ///     @param latencyMs Time from sending the request to the response, < 0 if unknown: only counts towards throughput
+    ///     @param inFlight Requests sent and still in flight, including this one
+    void requestSucceeded(qint64 nowMs, qint64 latencyMs, qint64 bytes, int inFlight);
+    void requestFailed(qint64 nowMs);
+
+    /// The server asked to slow down
+    ///     @param retryAfterMs From the Retry-After header, 0 if there is none
+    void requestThrottled(qint64 nowMs, qint64 retryAfterMs);
+
+    double tilesPerSecond(qint64 nowMs);
+    double bytesPerSecond(qint64 nowMs);
+
+    /// @return Estimated time to download the remaining tiles at the current rate, -1 if unknown
+    qint64 etaMs(quint64 remainingTiles, qint64 nowMs);
+
+    double latencyMs() const { return _rtt; }
+    double baseLatencyMs() const { return _baseRtt; }
+    double latencyDeviationMs() const { return _rttDev; }
+
+    static constexpr int kDefaultInitialLimit = 6;
+    static constexpr int kDefaultMaxLimit = 32;
+
+private:
+    void _pruneWindow(qint64 nowMs);
+    void _backoff(qint64 nowMs, qint64 delayMs);
+
+    struct Completion {
+        qint64 timeMs;
+        qint64 bytes;
+    };
+
+    double _initialLimit;
+    const double _maxLimit;
+    double _limit;
+    double _rtt = 0.;                                   ///< Smoothed latency
+    double _rttDev = 0.;                                ///< Smoothed mean deviation of the latency
+    int _rttSamples = 0;
+    double _baseRtt = 0.;                               ///< Lowest smoothed latency, the latency without queueing
+    bool _slowStart = true;
+    int _consecutiveErrors = 0;
+    qint64 _resumeAtMs = 0;
+    QQueue<Completion> _window;
+    qint64 _windowBytes = 0;
+
+    static constexpr double kMinLimit = 1.;
+    static constexpr double kRttAlpha = 0.05;           ///< Latency smoothing per response, tile sizes vary a lot
+    static constexpr int kWarmupSamples = 20;           ///< About 1 / kRttAlpha, before that the smoothed latency is mostly the first response
+    static constexpr double kQueueLow = 3.;
+    static constexpr double kQueueHigh = 6.;
+    static constexpr double kErrorDecrease = 0.9;
+    static constexpr int kErrorsBeforeBackoff = 3;
+    static constexpr qint64 kErrorBackoffMs = 500;
+    static constexpr qint64 kThrottleBackoffMs = 1000;
+    static constexpr qint64 kMaxBackoffMs = 60 * 1000;
+    static constexpr qint64 kRateWindowMs = 10 * 1000;
+};
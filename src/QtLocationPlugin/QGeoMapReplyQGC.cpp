@@ -48,6 +48,9 @@ QGeoTiledMapReplyQGC::QGeoTiledMapReplyQGC(QNetworkAccessManager *networkManager
     QGCFetchTileTask* const task = QGeoFileTileCacheQGC::createFetchTileTask(UrlFactory::getProviderTypeFromQtMapId(spec.mapId()), spec.x(), spec.y(), spec.zoom());
     (void) connect(task, &QGCFetchTileTask::tileFetched, this, &QGeoTiledMapReplyQGC::_cacheReply);
     (void) connect(task, &QGCMapTask::error, this, &QGeoTiledMapReplyQGC::_cacheError);
+    // Tiles scrolled out of view are aborted, their lookups are dropped if still queued
+    (void) connect(this, &QGeoTiledMapReplyQGC::aborted, task, &QGCMapTask::cancel);
+    (void) connect(this, &QObject::destroyed, task, &QGCMapTask::cancel);
     getQGCMapEngine()->addTask(task);
 }
 
@@ -214,7 +214,7 @@ Item {
     QGCFileDialog {
         id:             fileDialog
         folder:         QGroundControl.settingsManager.appSettings.missionSavePath
-        nameFilters:    [ qsTr("Tile Sets (*.%1)").arg(defaultSuffix) ]
+        nameFilters:    [ qsTr("Tile Sets (*.%1)").arg(defaultSuffix), qsTr("MBTiles (*.mbtiles)"), qsTr("PMTiles (*.pmtiles)") ]
         defaultSuffix:  _appSettings.tilesetFileExtension
 
         onAcceptedForSave: (file) => {
@@ -227,7 +227,8 @@ Item {
         }
 
         onAcceptedForLoad: (file) => {
-            if(!QGroundControl.mapEngineManager.importSets(file)) {
+            // Archives exported by QGC name their map type, others are imported as the map type shown
+            if(!QGroundControl.mapEngineManager.importSets(file, mapType)) {
                 showList();
             }
             close()
@@ -548,6 +549,13 @@ Item {
                         QGCLabel {  text: qsTr("Downloaded:"); width: infoView._labelWidth; }
                         QGCLabel {  text: (offlineMapView._currentSelection ? offlineMapView._currentSelection.savedTileCountStr : "") + " (" + (offlineMapView._currentSelection ? offlineMapView._currentSelection.savedTileSizeStr : "") + ")"; horizontalAlignment: Text.AlignRight; width: infoView._valueWidth; }
                     }
+                    Row {
+                        spacing:    ScreenTools.defaultFontPixelWidth
+                        anchors.horizontalCenter: parent.horizontalCenter
+                        visible:    offlineMapView && offlineMapView._currentSelection && !_defaultSet && offlineMapView._currentSelection.downloading && offlineMapView._currentSelection.downloadRateStr !== ""
+                        QGCLabel {  text: qsTr("Rate:"); width: infoView._labelWidth; }
+                        QGCLabel {  text: offlineMapView._currentSelection ? offlineMapView._currentSelection.downloadRateStr : ""; horizontalAlignment: Text.AlignRight; width: infoView._valueWidth; }
+                    }
                     Row {
                         spacing:    ScreenTools.defaultFontPixelWidth
                         anchors.horizontalCenter: parent.horizontalCenter
@@ -282,6 +282,12 @@ void QGCMapEngineManager::taskError(QGCMapTask::TaskType type, const QString &er
     case QGCMapTask::taskExport:
         task = QStringLiteral("Export Tile Sets");
         break;
+    case QGCMapTask::taskImport:
+        task = QStringLiteral("Import Tile Sets");
+        break;
+    case QGCMapTask::taskAttachArchive:
+        task = QStringLiteral("Attach Tile Archive");
+        break;
     default:
         task = QStringLiteral("Database Error");
         break;
@@ -356,7 +362,7 @@ int QGCMapEngineManager::selectedCount() const
     return count;
 }
 
-bool QGCMapEngineManager::importSets(const QString &path)
+bool QGCMapEngineManager::importSets(const QString &path, const QString &mapType)
 {
     setImportAction(ActionNone);
 
@@ -366,7 +372,7 @@ bool QGCMapEngineManager::importSets(const QString &path)
 
     setImportAction(ActionImporting);
 
-    QGCImportTileTask* const task = new QGCImportTileTask(path, _importReplace);
+    QGCImportTileTask* const task = new QGCImportTileTask(path, _importReplace, mapType);
     (void) connect(task, &QGCImportTileTask::actionCompleted, this, &QGCMapEngineManager::_actionCompleted);
     (void) connect(task, &QGCImportTileTask::actionProgress, this, &QGCMapEngineManager::_actionProgressHandler);
     (void) connect(task, &QGCMapTask::error, this, &QGCMapEngineManager::taskError);
@@ -407,6 +413,29 @@ bool QGCMapEngineManager::exportSets(const QString &path)
     return true;
 }
 
+bool QGCMapEngineManager::attachArchive(const QString &path, const QString &mapType)
+{
+    if (path.isEmpty()) {
+        return false;
+    }
+
+    QGCAttachArchiveTask* const task = new QGCAttachArchiveTask(path, mapType);
+    (void) connect(task, &QGCAttachArchiveTask::archiveAttached, this, [path](const QString &type) {
+        qCDebug(QGCMapEngineManagerLog) << "Serving" << type << "tiles from" << path;
+    });
+    (void) connect(task, &QGCMapTask::error, this, &QGCMapEngineManager::taskError);
+    (void) getQGCMapEngine()->addTask(task);
+
+    return true;
+}
+
+void QGCMapEngineManager::detachArchives()
+{
+    QGCAttachArchiveTask* const task = new QGCAttachArchiveTask(QString());
+    (void) connect(task, &QGCMapTask::error, this, &QGCMapEngineManager::taskError);
+    (void) getQGCMapEngine()->addTask(task);
+}
+
 void QGCMapEngineManager::_actionCompleted()
 {
     const ImportAction oldState = _importAction;
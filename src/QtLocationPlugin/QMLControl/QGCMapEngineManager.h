@@ -61,7 +61,13 @@ public:
 
     Q_INVOKABLE bool exportSets(const QString &path = QString());
     Q_INVOKABLE bool findName(const QString &name) const;
-    Q_INVOKABLE bool importSets(const QString &path = QString());
+    /// Imports a QGC tile set database, or an MBTiles (.mbtiles) or PMTiles (.pmtiles) archive as a new tile set
+    ///     @param mapType Map type of the tiles of an archive without a known "qgc_map_type" in its metadata
+    Q_INVOKABLE bool importSets(const QString &path = QString(), const QString &mapType = QString());
+    /// Serves map tiles straight from a PMTiles archive, without importing it
+    ///     @param mapType Map type the archive is served for if its metadata has no known "qgc_map_type"
+    Q_INVOKABLE bool attachArchive(const QString &path, const QString &mapType = QString());
+    Q_INVOKABLE void detachArchives();
     Q_INVOKABLE QString getUniqueName() const;
     Q_INVOKABLE void deleteTileSet(QGCCachedTileSet *tileSet);
     Q_INVOKABLE void loadTileSets();
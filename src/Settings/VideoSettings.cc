@@ -107,6 +107,8 @@ DECLARE_SETTINGSFACT(VideoSettings, rtspTimeout)
 DECLARE_SETTINGSFACT(VideoSettings, streamEnabled)
 DECLARE_SETTINGSFACT(VideoSettings, disableWhenDisarmed)
 DECLARE_SETTINGSFACT(VideoSettings, lowLatencyMode)
+DECLARE_SETTINGSFACT(VideoSettings, frameStatsLog)
+DECLARE_SETTINGSFACT(VideoSettings, telemetryTrack)
 
 DECLARE_SETTINGSFACT_NO_FUNC(VideoSettings, videoSource)
 {
@@ -143,6 +145,23 @@ DECLARE_SETTINGSFACT_NO_FUNC(VideoSettings, forceVideoDecoder)
     return _forceVideoDecoderFact;
 }
 
+DECLARE_SETTINGSFACT_NO_FUNC(VideoSettings, frameTap)
+{
+    if (!_frameTapFact) {
+        _frameTapFact = _createSettingsFact(frameTapName);
+
+        // POSIX shared memory is only used on desktop unix platforms
+        _frameTapFact->setVisible(
+#if defined(QGC_GST_STREAMING) && defined(Q_OS_UNIX) && !defined(Q_OS_ANDROID) && !defined(Q_OS_IOS)
+            true
+#else
+            false
+#endif
+        );
+    }
+    return _frameTapFact;
+}
+
 DECLARE_SETTINGSFACT_NO_FUNC(VideoSettings, udpPort)
 {
     if (!_udpPortFact) {
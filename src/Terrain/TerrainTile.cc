@@ -13,10 +13,13 @@
 #include <QtCore/QtNumeric>
 #include <QtPositioning/QGeoCoordinate>
 
+#include <cmath>
+#include <cstring>
+
 QGC_LOGGING_CATEGORY(TerrainTileLog, "qgc.terrain.terraintile");
 
 TerrainTile::TerrainTile(const QByteArray &byteArray)
-    : _tileInfo(*reinterpret_cast<const TileInfo_t*>(byteArray.constData()))
+    : _data(byteArray)
 {
     // qCDebug(TerrainTileLog) << Q_FUNC_INFO << this;
 
@@ -28,12 +31,19 @@ TerrainTile::TerrainTile(const QByteArray &byteArray)
         return;
     }
 
+    (void) memcpy(&_tileInfo, _data.constData(), cTileHeaderBytes);
+
     const int cTileDataBytes = static_cast<int>(sizeof(int16_t)) * _tileInfo.gridSizeLat * _tileInfo.gridSizeLon;
     if (cTileBytesAvailable < cTileHeaderBytes + cTileDataBytes) {
         qCWarning(TerrainTileLog) << "Terrain tile binary data too small for tile data";
         return;
     }
 
+    if ((_tileInfo.gridSizeLat <= 0) || (_tileInfo.gridSizeLon <= 0)) {
+        qCWarning(TerrainTileLog) << this << "Tile grid is empty";
+        return;
+    }
+
     if (((_tileInfo.neLon - _tileInfo.swLon) < 0.0) || ((_tileInfo.neLat - _tileInfo.swLat) < 0.0)) {
         qCWarning(TerrainTileLog) << this << "Tile extent is infeasible";
         _isValid = false;
@@ -49,18 +59,8 @@ TerrainTile::TerrainTile(const QByteArray &byteArray)
     qCDebug(TerrainTileLog) << this << "TileInfo: min, max, avg:" << _tileInfo.minElevation << _tileInfo.maxElevation << _tileInfo.avgElevation;
     qCDebug(TerrainTileLog) << this << "TileInfo: cell size:" << _cellSizeLat << _cellSizeLon;
 
-    _elevationData.resize(_tileInfo.gridSizeLat);
-    for (int k = 0; k < _tileInfo.gridSizeLat; k++) {
-        _elevationData[k].resize(_tileInfo.gridSizeLon);
-    }
-
-    int valueIndex = 0;
-    const int16_t* const pTileData = reinterpret_cast<const int16_t*>(&reinterpret_cast<const uint8_t*>(byteArray.constData())[cTileHeaderBytes]);
-    for (int i = 0; i < _tileInfo.gridSizeLat; i++) {
-        for (int j = 0; j < _tileInfo.gridSizeLon; j++) {
-            _elevationData[i][j] = pTileData[valueIndex++];
-        }
-    }
+    // The header is 48 bytes, so the grid is aligned as long as the data is
+    _elevations = reinterpret_cast<const int16_t*>(&reinterpret_cast<const uint8_t*>(_data.constData())[cTileHeaderBytes]);
 
     _isValid = true;
 }
@@ -91,14 +91,7 @@ double TerrainTile::elevation(const QGeoCoordinate &coordinate) const
         return qQNaN();
     }
 
-    if ((latIndex >= _elevationData.size()) || (lonIndex >= _elevationData[latIndex].size())) {
-        qCWarning(TerrainTileLog).noquote() << this << "Internal error: _elevationData size inconsistent _tileInfo << coordinate" << coordinate
-            << "\n\t_tillIndo.gridSizeLat:" << _tileInfo.gridSizeLat << "_tileInfo.gridSizeLon:" << _tileInfo.gridSizeLon
-            << "\n\t_data.size():" << _elevationData.size() << "_elevationData[latIndex].size():" << _elevationData[latIndex].size();
-        return qQNaN();
-    }
-
-    const int16_t elevation = _elevationData[latIndex][lonIndex];
+    const int16_t elevation = _elevations[(latIndex * _tileInfo.gridSizeLon) + lonIndex];
     if (elevation < _tileInfo.minElevation) {
         qCWarning(TerrainTileLog) << this << "Warning: elevation read is below min elevation in tile:" << elevation << "<" << _tileInfo.minElevation;
     } else if (elevation > _tileInfo.maxElevation) {
@@ -109,3 +102,68 @@ double TerrainTile::elevation(const QGeoCoordinate &coordinate) const
 
     return static_cast<double>(elevation);
 }
+
+qsizetype TerrainTile::elevations(const QGeoCoordinate *coordinates, double *elevations, qsizetype count, Interpolation interpolation) const
+{
+    if (!_isValid) {
+        qCWarning(TerrainTileLog) << this << "Request for elevations, but tile is invalid.";
+        for (qsizetype i = 0; i < count; i++) {
+            elevations[i] = qQNaN();
+        }
+        return count;
+    }
+
+    const int gridSizeLat = _tileInfo.gridSizeLat;
+    const int gridSizeLon = _tileInfo.gridSizeLon;
+    const double latScale = 1.0 / _cellSizeLat;
+    const double lonScale = 1.0 / _cellSizeLon;
+    qsizetype outsideCount = 0;
+
+    if (interpolation == Interpolation::Nearest) {
+        for (qsizetype i = 0; i < count; i++) {
+            const int latIndex = static_cast<int>(std::floor((coordinates[i].latitude() - _tileInfo.swLat) * latScale));
+            const int lonIndex = static_cast<int>(std::floor((coordinates[i].longitude() - _tileInfo.swLon) * lonScale));
+            if ((latIndex < 0) || (latIndex >= gridSizeLat) || (lonIndex < 0) || (lonIndex >= gridSizeLon)) {
+                elevations[i] = qQNaN();
+                outsideCount++;
+                continue;
+            }
+            elevations[i] = _cellElevation(latIndex, lonIndex);
+        }
+    } else {
+        // Grid positions relative to the cell centers. Within half a cell of the tile edge the edge cells are used as is.
+        const int maxLatIndex = qMax(gridSizeLat - 2, 0);
+        const int maxLonIndex = qMax(gridSizeLon - 2, 0);
+        const int latStep = (gridSizeLat > 1) ? gridSizeLon : 0;
+        const int lonStep = (gridSizeLon > 1) ? 1 : 0;
+        const int16_t *const data = _elevations;
+
+        for (qsizetype i = 0; i < count; i++) {
+            const double latCells = (coordinates[i].latitude() - _tileInfo.swLat) * latScale;
+            const double lonCells = (coordinates[i].longitude() - _tileInfo.swLon) * lonScale;
+            if (!((latCells >= 0.0) && (latCells <= gridSizeLat) && (lonCells >= 0.0) && (lonCells <= gridSizeLon))) {
+                elevations[i] = qQNaN();
+                outsideCount++;
+                continue;
+            }
+
+            const double latPos = qBound(0.0, latCells - 0.5, static_cast<double>(gridSizeLat - 1));
+            const double lonPos = qBound(0.0, lonCells - 0.5, static_cast<double>(gridSizeLon - 1));
+            const int latIndex = qMin(static_cast<int>(latPos), maxLatIndex);
+            const int lonIndex = qMin(static_cast<int>(lonPos), maxLonIndex);
+            const double latFrac = latPos - latIndex;
+            const double lonFrac = lonPos - lonIndex;
+
+            const int16_t *const cell = data + (latIndex * gridSizeLon) + lonIndex;
+            const double south = cell[0] + (lonFrac * (cell[lonStep] - cell[0]));
+            const double north = cell[latStep] + (lonFrac * (cell[latStep + lonStep] - cell[latStep]));
+            elevations[i] = south + (latFrac * (north - south));
+        }
+    }
+
+    if (outsideCount > 0) {
+        qCWarning(TerrainTileLog) << this << "Internal error:" << outsideCount << "of" << count << "coordinates outside tile bounds";
+    }
+
+    return outsideCount;
+}
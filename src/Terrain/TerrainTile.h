@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <QtCore/QByteArray>
 #include <QtCore/QList>
 #include <QtCore/QLoggingCategory>
 
@@ -17,13 +18,20 @@ class TerrainTileTest;
 
 Q_DECLARE_LOGGING_CATEGORY(TerrainTileLog)
 
+/// Elevation grid of a terrain tile. Elevations are read in place from the serialized tile, a single row major
+/// buffer with row 0 being the southernmost row of cells.
 class TerrainTile
 {
     friend class TerrainTileTest;
 
 public:
+    enum class Interpolation {
+        Nearest,    ///< Elevation of the cell the coordinate falls in
+        Bilinear,   ///< Interpolated between the centers of the four nearest cells
+    };
+
     /// Constructor from serialized elevation data (either from file or web)
-    ///    @param document
+    ///    @param byteArray Kept (shared, not copied) for the life of the tile, may be raw data of a file mapping
     explicit TerrainTile(const QByteArray &byteArray);
     virtual ~TerrainTile();
 
@@ -31,11 +39,20 @@ public:
     ///    @return true if data is valid
     bool isValid() const { return _isValid; }
 
+    /// Size of the serialized tile data
+    qsizetype dataSize() const { return _data.size(); }
+
     /// Evaluates the elevation at the given coordinate
     ///    @param coordinate
     ///    @return elevation
     double elevation(const QGeoCoordinate &coordinate) const;
 
+    /// Evaluates the elevations at a batch of coordinates
+    ///    @param coordinates count coordinates
+    ///    @param[out] elevations count elevations, NaN for coordinates outside the tile
+    ///    @return Number of coordinates outside the tile
+    qsizetype elevations(const QGeoCoordinate *coordinates, double *elevations, qsizetype count, Interpolation interpolation = Interpolation::Nearest) const;
+
     /// Accessor for the minimum elevation of the tile
     ///    @return minimum elevation
     double minElevation() const { return (_isValid ? static_cast<double>(_tileInfo.minElevation) : qQNaN()); }
@@ -57,8 +74,12 @@ protected:
     } Q_PACKED;
 
 private:
+    /// Elevation of a cell, indices must be within the grid
+    double _cellElevation(int latIndex, int lonIndex) const { return static_cast<double>(_elevations[(latIndex * _tileInfo.gridSizeLon) + lonIndex]); }
+
     TileInfo_t _tileInfo{};
-    QList<QList<int16_t>> _elevationData;   ///< 2D elevation data array
+    QByteArray _data;                       ///< Serialized tile
+    const int16_t *_elevations = nullptr;   ///< gridSizeLat rows of gridSizeLon elevations within _data
     double _cellSizeLat = 0.0;              ///< data grid size in latitude direction
     double _cellSizeLon = 0.0;              ///< data grid size in longitude direction
     bool _isValid = false;                  ///< data loaded is valid
@@ -0,0 +1,247 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainTileCache.h"
+#include "TerrainTile.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+
+QGC_LOGGING_CATEGORY(TerrainTileCacheLog, "qgc.terrain.terraintilecache")
+
+TerrainTileCache::TerrainTileCache(const QString &path, qint64 maxMemoryBytes, qint64 maxDiskBytes)
+    : _dir(path)
+    , _diskEnabled(!path.isEmpty() && QDir::root().mkpath(path))
+    , _maxMemoryBytes(maxMemoryBytes)
+    , _maxDiskBytes(maxDiskBytes)
+{
+    if (!path.isEmpty() && !_diskEnabled) {
+        qCWarning(TerrainTileCacheLog) << "Could not create terrain disk cache directory:" << path;
+    }
+
+    if (_diskEnabled) {
+        _pruneDisk();
+    }
+
+    qCDebug(TerrainTileCacheLog) << "Terrain cache in:" << path << "memory budget:" << _maxMemoryBytes << "disk budget:" << _maxDiskBytes << "disk usage:" << _diskBytes;
+}
+
+TerrainTileCache::~TerrainTileCache()
+{
+    clearMemory();
+}
+
+QString TerrainTileCache::defaultPath()
+{
+#if defined(Q_OS_ANDROID) || defined(Q_OS_IOS)
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+#else
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+#endif
+    return (cacheDir.isEmpty() ? QString() : (cacheDir + QStringLiteral("/QGCTerrainCache")));
+}
+
+std::shared_ptr<const TerrainTile> TerrainTileCache::tile(const QString &key)
+{
+    {
+        QMutexLocker locker(&_mutex);
+        const std::shared_ptr<const TerrainTile> memoryTile = _memoryTile(key);
+        if (memoryTile) {
+            return memoryTile;
+        }
+    }
+
+    // Disk I/O runs unlocked so a slow disk does not hold up lookups of tiles which are in memory
+    const std::shared_ptr<const TerrainTile> tile = _loadFromDisk(key);
+    if (!tile) {
+        return nullptr;
+    }
+
+    QMutexLocker locker(&_mutex);
+    return _insertMemory(key, tile, tile->dataSize());
+}
+
+std::shared_ptr<const TerrainTile> TerrainTileCache::insert(const QString &key, const QByteArray &data)
+{
+    const std::shared_ptr<const TerrainTile> tile = std::make_shared<const TerrainTile>(data);
+    if (!tile->isValid()) {
+        qCWarning(TerrainTileCacheLog) << "Invalid tile not cached:" << key;
+        return nullptr;
+    }
+
+    {
+        QMutexLocker locker(&_mutex);
+        const std::shared_ptr<const TerrainTile> memoryTile = _memoryTile(key);
+        if (memoryTile) {
+            return memoryTile;
+        }
+    }
+
+    _saveToDisk(key, data);
+
+    QMutexLocker locker(&_mutex);
+    return _insertMemory(key, tile, data.size());
+}
+
+void TerrainTileCache::clearMemory()
+{
+    QMutexLocker locker(&_mutex);
+
+    _lookup.clear();
+    _lru.clear();
+    _memoryBytes = 0;
+}
+
+qsizetype TerrainTileCache::memoryTileCount()
+{
+    QMutexLocker locker(&_mutex);
+    return _lookup.count();
+}
+
+qint64 TerrainTileCache::memoryBytes()
+{
+    QMutexLocker locker(&_mutex);
+    return _memoryBytes;
+}
+
+std::shared_ptr<const TerrainTile> TerrainTileCache::_memoryTile(const QString &key)
+{
+    const auto it = _lookup.constFind(key);
+    if (it == _lookup.constEnd()) {
+        return nullptr;
+    }
+
+    _lru.splice(_lru.begin(), _lru, it.value());
+    return _lru.front().tile;
+}
+
+std::shared_ptr<const TerrainTile> TerrainTileCache::_insertMemory(const QString &key, const std::shared_ptr<const TerrainTile> &tile, qint64 bytes)
+{
+    // Another thread may have loaded the same tile while the lock was released for disk I/O
+    const std::shared_ptr<const TerrainTile> memoryTile = _memoryTile(key);
+    if (memoryTile) {
+        return memoryTile;
+    }
+
+    _lru.push_front(Entry{ key, tile, bytes });
+    _lookup.insert(key, _lru.begin());
+    _memoryBytes += bytes;
+
+    // The newest tile always stays, even if it is larger than the whole budget
+    while ((_memoryBytes > _maxMemoryBytes) && (_lru.size() > 1)) {
+        const Entry &oldest = _lru.back();
+        qCDebug(TerrainTileCacheLog) << "Evicting tile from memory:" << oldest.key;
+        _memoryBytes -= oldest.bytes;
+        (void) _lookup.remove(oldest.key);
+        _lru.pop_back();
+    }
+
+    return tile;
+}
+
+QString TerrainTileCache::_fileName(const QString &key) const
+{
+    return _dir.filePath(key + QLatin1String(kFileExtension));
+}
+
+std::shared_ptr<const TerrainTile> TerrainTileCache::_loadFromDisk(const QString &key) const
+{
+    if (!_diskEnabled) {
+        return nullptr;
+    }
+
+    QFile file(_fileName(key));
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    // Tiles are read rather than memory mapped, a mapping would keep a file descriptor open for every cached tile
+    quint32 header[2];
+    if ((file.read(reinterpret_cast<char*>(header), sizeof(header)) != static_cast<qint64>(sizeof(header))) || (header[0] != kFileMagic) || (header[1] != kFileVersion)) {
+        qCWarning(TerrainTileCacheLog) << "Discarding terrain tile with bad header" << file.fileName();
+        file.close();
+        (void) file.remove();
+        return nullptr;
+    }
+
+    const QByteArray tileData = file.readAll();
+    const std::shared_ptr<const TerrainTile> tile = std::make_shared<const TerrainTile>(tileData);
+    if (!tile->isValid()) {
+        qCWarning(TerrainTileCacheLog) << "Discarding invalid terrain tile" << file.fileName();
+        file.close();
+        (void) file.remove();
+        return nullptr;
+    }
+
+    // Pruning removes the least recently used tiles first
+    (void) file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+
+    qCDebug(TerrainTileCacheLog) << "Loaded tile from disk:" << key;
+
+    return tile;
+}
+
+void TerrainTileCache::_saveToDisk(const QString &key, const QByteArray &data)
+{
+    if (!_diskEnabled) {
+        return;
+    }
+
+    QSaveFile file(_fileName(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(TerrainTileCacheLog) << "Unable to write terrain tile" << file.fileName() << file.errorString();
+        return;
+    }
+
+    const quint32 header[2] = { kFileMagic, kFileVersion };
+    static_assert(sizeof(header) == kFileHeaderLen);
+    (void) file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    (void) file.write(data);
+    if (!file.commit()) {
+        qCWarning(TerrainTileCacheLog) << "Unable to write terrain tile" << file.fileName() << file.errorString();
+        return;
+    }
+
+    const qint64 fileBytes = kFileHeaderLen + data.size();
+    if ((_diskBytes.fetch_add(fileBytes) + fileBytes) > _maxDiskBytes) {
+        _pruneDisk();
+    }
+}
+
+void TerrainTileCache::_pruneDisk()
+{
+    QMutexLocker locker(&_diskMutex);
+
+    // Newest first
+    const QFileInfoList files = _dir.entryInfoList({ QStringLiteral("*") + QLatin1String(kFileExtension) }, QDir::Files, QDir::Time);
+
+    qint64 bytes = 0;
+    for (const QFileInfo &fileInfo : files) {
+        bytes += fileInfo.size();
+    }
+
+    if (bytes > _maxDiskBytes) {
+        // Prune below the budget, so that pruning does not run again on the next few inserts
+        const qint64 targetBytes = _maxDiskBytes - (_maxDiskBytes / 4);
+        for (qsizetype i = files.count() - 1; (i >= 0) && (bytes > targetBytes); i--) {
+            const QFileInfo &fileInfo = files[i];
+            if (QFile::remove(fileInfo.filePath())) {
+                qCDebug(TerrainTileCacheLog) << "Pruned tile from disk:" << fileInfo.fileName();
+                bytes -= fileInfo.size();
+            }
+        }
+    }
+
+    _diskBytes = bytes;
+}
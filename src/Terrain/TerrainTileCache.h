@@ -0,0 +1,102 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDir>
+#include <QtCore/QHash>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+
+#include <atomic>
+#include <list>
+#include <memory>
+
+class TerrainTile;
+
+Q_DECLARE_LOGGING_CATEGORY(TerrainTileCacheLog)
+
+/// Two tier cache of decoded terrain tiles, keyed by tile hash.
+/// Tiles in use are kept in a memory LRU bounded by the size of their elevation data. Every tile is also stored
+/// on disk in its serialized form, one file per tile, and is read back as is when it is loaded again. Loading from
+/// disk parses nothing beyond the tile header, so terrain is warm right away after a restart. The disk tier is
+/// pruned to its budget, least recently used tiles first.
+/// Thread-safe, only one instance per directory must exist.
+class TerrainTileCache
+{
+public:
+    /// @param path Directory of the disk tier, an empty path disables the disk tier
+    explicit TerrainTileCache(const QString &path, qint64 maxMemoryBytes = kDefaultMaxMemoryBytes, qint64 maxDiskBytes = kDefaultMaxDiskBytes);
+    ~TerrainTileCache();
+
+    /// @return Tile from memory or disk, nullptr if it is in neither
+    std::shared_ptr<const TerrainTile> tile(const QString &key);
+
+    /// Adds a tile to both tiers
+    ///     @param data Serialized tile
+    ///     @return nullptr if the tile data is invalid
+    std::shared_ptr<const TerrainTile> insert(const QString &key, const QByteArray &data);
+
+    /// Drops the memory tier, the disk tier is kept
+    void clearMemory();
+
+    qsizetype memoryTileCount();
+    qint64 memoryBytes();
+    qint64 maxMemoryBytes() const { return _maxMemoryBytes; }
+    qint64 diskBytes() const { return _diskBytes; }
+    qint64 maxDiskBytes() const { return _maxDiskBytes; }
+
+    static QString defaultPath();
+
+    static constexpr qint64 kDefaultMaxMemoryBytes = 32 * 1024 * 1024;
+    static constexpr qint64 kDefaultMaxDiskBytes = 512 * 1024 * 1024;
+
+private:
+    struct Entry {
+        QString key;
+        std::shared_ptr<const TerrainTile> tile;
+        qint64 bytes = 0;
+    };
+
+    std::shared_ptr<const TerrainTile> _loadFromDisk(const QString &key) const;
+    void _saveToDisk(const QString &key, const QByteArray &data);
+    QString _fileName(const QString &key) const;
+
+    /// Removes the least recently used tiles from disk until the disk tier is below its budget
+    void _pruneDisk();
+
+    /// @return Tile from the memory tier, marked as most recently used
+    ///     Must be called with _mutex locked
+    std::shared_ptr<const TerrainTile> _memoryTile(const QString &key);
+
+    /// Adds the tile as most recently used and evicts the least recently used tiles over budget
+    ///     Must be called with _mutex locked
+    ///     @return The tile already in memory for key, if there is one, otherwise tile
+    std::shared_ptr<const TerrainTile> _insertMemory(const QString &key, const std::shared_ptr<const TerrainTile> &tile, qint64 bytes);
+
+    const QDir _dir;
+    const bool _diskEnabled;
+    const qint64 _maxMemoryBytes;
+    const qint64 _maxDiskBytes;
+
+    QMutex _mutex;
+    std::list<Entry> _lru;                                      ///< Most recently used first
+    QHash<QString, std::list<Entry>::iterator> _lookup;
+    qint64 _memoryBytes = 0;
+
+    QMutex _diskMutex;                                          ///< Serializes pruning
+    std::atomic<qint64> _diskBytes = 0;                         ///< Approximate between prunes
+
+    static constexpr quint32 kFileMagic = 0x51544552;           ///< "QTER"
+    static constexpr quint32 kFileVersion = 1;
+    static constexpr qint64 kFileHeaderLen = 2 * sizeof(quint32);
+    static constexpr const char *kFileExtension = ".qgcterrain";
+};
@@ -34,6 +34,7 @@ TerrainTileManager *TerrainTileManager::instance()
 
 TerrainTileManager::TerrainTileManager(QObject *parent)
     : QObject(parent)
+    , _tileCache(TerrainTileCache::defaultPath())
     , _networkManager(new QNetworkAccessManager(this))
 {
     // qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << this;
@@ -47,51 +48,59 @@ TerrainTileManager::TerrainTileManager(QObject *parent)
 
 TerrainTileManager::~TerrainTileManager()
 {
-    qDeleteAll(_tiles);
-
     // qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << this;
 }
 
-bool TerrainTileManager::getAltitudesForCoordinates(const QList<QGeoCoordinate> &coordinates, QList<double> &altitudes, bool &error)
+bool TerrainTileManager::getAltitudesForCoordinates(const QList<QGeoCoordinate> &coordinates, QList<double> &altitudes, bool &error, TerrainTile::Interpolation interpolation)
 {
     error = false;
 
     const QString elevationProviderName = SettingsManager::instance()->flightMapSettings()->elevationMapProvider()->rawValue().toString();
     const SharedMapProvider provider = UrlFactory::getMapProviderFromProviderType(elevationProviderName);
-    for (const QGeoCoordinate &coordinate: coordinates) {
-        const QString tileHash = UrlFactory::getTileHash(
-            provider->getMapName(),
-            provider->long2tileX(coordinate.longitude(), 1),
-            provider->lat2tileY(coordinate.latitude(), 1),
-            1
-        );
-        qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "hash:coordinate" << tileHash << coordinate;
-
-        TerrainTile* const tile = _getCachedTile(tileHash);
+
+    const qsizetype firstAltitude = altitudes.count();
+    altitudes.resize(firstAltitude + coordinates.count());
+
+    // Consecutive coordinates mostly fall in the same tile, each run of them is looked up as one batch
+    qsizetype runStart = 0;
+    while (runStart < coordinates.count()) {
+        const int tileX = provider->long2tileX(coordinates[runStart].longitude(), 1);
+        const int tileY = provider->lat2tileY(coordinates[runStart].latitude(), 1);
+
+        qsizetype runEnd = runStart + 1;
+        while ((runEnd < coordinates.count()) && (provider->long2tileX(coordinates[runEnd].longitude(), 1) == tileX) && (provider->lat2tileY(coordinates[runEnd].latitude(), 1) == tileY)) {
+            runEnd++;
+        }
+
+        const QString tileHash = UrlFactory::getTileHash(provider->getMapName(), tileX, tileY, 1);
+        qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "hash:coordinate:count" << tileHash << coordinates[runStart] << (runEnd - runStart);
+
+        const std::shared_ptr<const TerrainTile> tile = _getCachedTile(tileHash);
         if (tile) {
-            const double elevation = tile->elevation(coordinate);
-            if (qIsNaN(elevation)) {
+            if (tile->elevations(coordinates.constData() + runStart, altitudes.data() + firstAltitude + runStart, runEnd - runStart, interpolation) > 0) {
                 error = true;
                 qCWarning(TerrainTileManagerLog) << Q_FUNC_INFO << "Internal Error: missing elevation in tile cache";
             } else {
-                qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "returning elevation from tile cache" << elevation;
+                qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "returning elevations from tile cache";
             }
-            altitudes.push_back(elevation);
-        } else if (_state != TerrainQuery::State::Downloading) {
-            QGeoTileSpec spec;
-            spec.setX(provider->long2tileX(coordinate.longitude(), 1));
-            spec.setY(provider->lat2tileY(coordinate.latitude(), 1));
-            spec.setZoom(1);
-            spec.setMapId(provider->getMapId());
-            const QNetworkRequest request = QGeoTileFetcherQGC::getNetworkRequest(spec.mapId(), spec.x(), spec.y(), spec.zoom());
-            QGeoTiledMapReplyQGC* const reply = new QGeoTiledMapReplyQGC(_networkManager, request, spec, this);
-            (void) connect(reply, &QGeoTiledMapReplyQGC::finished, this, &TerrainTileManager::_terrainDone);
-            _state = TerrainQuery::State::Downloading;
-            // TODO: Batch Downloading?
-            return false;
         } else {
+            altitudes.resize(firstAltitude);
+            if (_state != TerrainQuery::State::Downloading) {
+                QGeoTileSpec spec;
+                spec.setX(tileX);
+                spec.setY(tileY);
+                spec.setZoom(1);
+                spec.setMapId(provider->getMapId());
+                const QNetworkRequest request = QGeoTileFetcherQGC::getNetworkRequest(spec.mapId(), spec.x(), spec.y(), spec.zoom());
+                QGeoTiledMapReplyQGC* const reply = new QGeoTiledMapReplyQGC(_networkManager, request, spec, this);
+                (void) connect(reply, &QGeoTiledMapReplyQGC::finished, this, &TerrainTileManager::_terrainDone);
+                _state = TerrainQuery::State::Downloading;
+                // TODO: Batch Downloading?
+            }
             return false;
         }
+
+        runStart = runEnd;
     }
 
     return true;
@@ -139,7 +148,7 @@ void TerrainTileManager::addPathQuery(TerrainQueryInterface *terrainQueryInterfa
 
     bool error;
     QList<double> altitudes;
-    if (!getAltitudesForCoordinates(coordinates, altitudes, error)) {
+    if (!getAltitudesForCoordinates(coordinates, altitudes, error, TerrainTile::Interpolation::Bilinear)) {
         qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "queue count" << _requestQueue.count();
         const QueuedRequestInfo_t queuedRequestInfo = {
             terrainQueryInterface,
@@ -250,7 +259,8 @@ void TerrainTileManager::_terrainDone()
         QList<double> altitudes;
         QueuedRequestInfo_t &requestInfo = _requestQueue[i];
 
-        if (!getAltitudesForCoordinates(requestInfo.coordinates, altitudes, error)) {
+        const TerrainTile::Interpolation interpolation = (requestInfo.queryMode == TerrainQuery::QueryMode::QueryModePath) ? TerrainTile::Interpolation::Bilinear : TerrainTile::Interpolation::Nearest;
+        if (!getAltitudesForCoordinates(requestInfo.coordinates, altitudes, error, interpolation)) {
             continue;
         }
 
@@ -285,37 +295,12 @@ void TerrainTileManager::_terrainDone()
 
 void TerrainTileManager::_cacheTile(const QByteArray &data, const QString &hash)
 {
-    TerrainTile* const terrainTile = new TerrainTile(data);
-    if (terrainTile->isValid()) {
-        _tilesMutex.lock();
-        if (!_tiles.contains(hash)) {
-            (void) _tiles.insert(hash, terrainTile);
-        } else {
-            delete terrainTile;
-        }
-        _tilesMutex.unlock();
-    } else {
-        delete terrainTile;
+    if (!_tileCache.insert(hash, data)) {
         qCWarning(TerrainTileManagerLog) << "Received invalid tile";
     }
 }
 
-TerrainTile *TerrainTileManager::_getCachedTile(const QString &hash)
+std::shared_ptr<const TerrainTile> TerrainTileManager::_getCachedTile(const QString &hash)
 {
-    _tilesMutex.lock();
-    if (!_tiles.contains(hash)) {
-        _tilesMutex.unlock();
-        return nullptr;
-    }
-
-    TerrainTile* const tile = _tiles[hash];
-
-    if (!tile->isValid()) {
-        _tilesMutex.unlock();
-        return nullptr;
-    }
-
-    _tilesMutex.unlock();
-
-    return tile;
+    return _tileCache.tile(hash);
 }
@@ -10,14 +10,14 @@
 #pragma once
 
 #include "TerrainQueryInterface.h"
+#include "TerrainTile.h"
+#include "TerrainTileCache.h"
 
 #include <QtCore/QLoggingCategory>
-#include <QtCore/QMutex>
 #include <QtCore/QObject>
 #include <QtCore/QQueue>
 #include <QtPositioning/QGeoCoordinate>
 
-class TerrainTile;
 class QNetworkAccessManager;
 class UnitTestTerrainQuery;
 
@@ -36,8 +36,9 @@ public:
 
     /// Either returns altitudes from cache or queues database request
     ///     @param[out] error true: altitude not returned due to error, false: altitudes returned
+    ///     @param interpolation Path queries use bilinear interpolation for a smooth profile
     ///     @return true: altitude returned (check error as well), false: database query queued (altitudes not returned)
-    bool getAltitudesForCoordinates(const QList<QGeoCoordinate> &coordinates, QList<double> &altitudes, bool &error);
+    bool getAltitudesForCoordinates(const QList<QGeoCoordinate> &coordinates, QList<double> &altitudes, bool &error, TerrainTile::Interpolation interpolation = TerrainTile::Interpolation::Nearest);
 
     void addCoordinateQuery(TerrainQueryInterface *terrainQueryInterface, const QList<QGeoCoordinate> &coordinates);
     void addPathQuery(TerrainQueryInterface *terrainQueryInterface, const QGeoCoordinate &startPoint, const QGeoCoordinate &endPoint);
@@ -50,7 +51,7 @@ private:
     static QList<QGeoCoordinate> _pathQueryToCoords(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord, double &distanceBetween, double &finalDistanceBetween);
     void _tileFailed();
     void _cacheTile(const QByteArray &data, const QString &hash);
-    TerrainTile *_getCachedTile(const QString &hash);
+    std::shared_ptr<const TerrainTile> _getCachedTile(const QString &hash);
 
     struct QueuedRequestInfo_t {
         TerrainQueryInterface *terrainQueryInterface;
@@ -63,8 +64,7 @@ private:
     QQueue<QueuedRequestInfo_t> _requestQueue;
     TerrainQuery::State _state = TerrainQuery::State::Idle;
 
-    QMutex _tilesMutex;
-    QHash<QString, TerrainTile*> _tiles;
+    TerrainTileCache _tileCache;
 
     QNetworkAccessManager *_networkManager = nullptr;
 };
@@ -31,6 +31,9 @@ Item {
     property var    _mapEngineManager:              QGroundControl.mapEngineManager
     property bool   _currentlyImportOrExporting:    _mapEngineManager.importAction === QGCMapEngineManager.ActionExporting || _mapEngineManager.importAction === QGCMapEngineManager.ActionImporting
     property real   _largeTextFieldWidth:           ScreenTools.defaultFontPixelWidth * 30
+    property string _currentMapType:                _mapProviderFact.rawValue + " " + _mapTypeFact.rawValue
+    property string _archiveMapType:                _currentMapType    ///< Used for MBTiles/PMTiles archives which do not name their map type
+    property bool   _attachArchive:                 false              ///< The file dialog picks a PMTiles archive to serve tiles from
 
     property Fact   _mapProviderFact:   _settingsManager.flightMapSettings.mapProvider
     property Fact   _mapTypeFact:       _settingsManager.flightMapSettings.mapType
@@ -142,6 +145,24 @@ Item {
                 onClicked:  exportDialogComponent.createObject(mainWindow).open()
             }
 
+            LabelledButton {
+                label:      qsTr("Serve Tiles From PMTiles Archive")
+                buttonText: qsTr("Open")
+                visible:    QGroundControl.corePlugin.options.showOfflineMapImport
+                onClicked: {
+                    _attachArchive = true
+                    fileDialog.title = qsTr("Open PMTiles Archive")
+                    fileDialog.openForLoad()
+                }
+            }
+
+            LabelledButton {
+                label:      qsTr("Stop Serving Archives")
+                buttonText: qsTr("Close")
+                visible:    QGroundControl.corePlugin.options.showOfflineMapImport
+                onClicked:  _mapEngineManager.detachArchives()
+            }
+
             RowLayout {
                 spacing: ScreenTools.defaultFontPixelWidth
                 visible: _currentlyImportOrExporting
@@ -229,7 +250,7 @@ Item {
         QGCFileDialog {
             id:             fileDialog
             folder:         _appSettings.missionSavePath
-            nameFilters:    [ qsTr("Tile Sets (*.%1)").arg(defaultSuffix) ]
+            nameFilters:    _attachArchive ? [ qsTr("PMTiles (*.pmtiles)") ] : [ qsTr("Tile Sets (*.%1)").arg(defaultSuffix), qsTr("MBTiles (*.mbtiles)"), qsTr("PMTiles (*.pmtiles)") ]
             defaultSuffix:  _appSettings.tilesetFileExtension
 
             onAcceptedForSave: (file) => {
@@ -239,8 +260,16 @@ Item {
 
             onAcceptedForLoad: (file) => {
                 close()
-                _mapEngineManager.importSets(file)
+                if (_attachArchive) {
+                    _attachArchive = false
+                    // Archives exported by QGC name their map type, others are served as the current map type
+                    _mapEngineManager.attachArchive(file, _currentMapType)
+                } else {
+                    _mapEngineManager.importSets(file, _archiveMapType)
+                }
             }
+
+            onRejected: _attachArchive = false
         }
 
         Component {
@@ -281,6 +310,7 @@ Item {
 
                 onAccepted: {
                     close()
+                    _attachArchive = false
                     fileDialog.title = qsTr("Import Tiles")
                     fileDialog.openForLoad()
                 }
@@ -288,6 +318,22 @@ Item {
                 ColumnLayout {
                     spacing: ScreenTools.defaultFontPixelWidth / 2
 
+                    QGCLabel { text: qsTr("Map type of MBTiles/PMTiles archives not exported by QGC") }
+                    QGCComboBox {
+                        Layout.fillWidth:   true
+                        model:              _mapEngineManager.mapList
+                        sizeToContents:     true
+
+                        onActivated: (index) => { _archiveMapType = textAt(index) }
+
+                        Component.onCompleted: {
+                            _archiveMapType = _currentMapType
+                            var index = find(_archiveMapType)
+                            if (index < 0) index = 0
+                            currentIndex = index
+                        }
+                    }
+
                     QGCRadioButton {
                         text:           qsTr("Append to existing sets")
                         checked:        !_mapEngineManager.importReplace
@@ -103,6 +103,32 @@ SettingsPage {
             visible:            !_videoAutoStreamConfig && _isStreamSource && fact.visible && _isGST
         }
 
+        FactCheckBoxSlider {
+            Layout.fillWidth:   true
+            text:               qsTr("Log Video Frame Timing")
+            fact:               _videoSettings.frameStatsLog
+            visible:            _isStreamSource && fact.visible && _isGST
+        }
+
+        LabelledLabel {
+            Layout.fillWidth:   true
+            label:              qsTr("Frame Timing")
+            labelText:          qsTr("%1 fps, latency %2 ms, decode p95 %3 ms, jitter %4 ms, %5 dropped")
+                                    .arg(_videoManager.frameStats.fps.toFixed(1))
+                                    .arg(_videoManager.frameStats.totalLatency.toFixed(1))
+                                    .arg(_videoManager.frameStats.decodeP95.toFixed(1))
+                                    .arg(_videoManager.frameStats.jitter.toFixed(1))
+                                    .arg(_videoManager.frameStats.framesDropped)
+            visible:            _isStreamSource && _isGST && _videoManager.frameStats.valid
+        }
+
+        FactCheckBoxSlider {
+            Layout.fillWidth:   true
+            text:               qsTr("Share Decoded Video Frames")
+            fact:               _videoSettings.frameTap
+            visible:            _isStreamSource && fact.visible && _isGST
+        }
+
         LabelledFactComboBox {
             Layout.fillWidth:   true
             label:              qsTr("Video decode priority")
@@ -123,6 +149,13 @@ SettingsPage {
             visible:            _videoSettings.recordingFormat.visible
         }
 
+        FactCheckBoxSlider {
+            Layout.fillWidth:   true
+            text:               qsTr("Save Telemetry Track")
+            fact:               _videoSettings.telemetryTrack
+            visible:            fact.visible
+        }
+
         FactCheckBoxSlider {
             Layout.fillWidth:   true
             text:               qsTr("Auto-Delete Saved Recordings")
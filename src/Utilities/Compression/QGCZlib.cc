@@ -96,4 +96,50 @@ bool inflateGzipFile(const QString &gzippedFileName, const QString &decompressed
     return true;
 }
 
+QByteArray inflateGzip(QByteArrayView gzippedData)
+{
+    z_stream strm;
+    strm.zalloc = nullptr;
+    strm.zfree = nullptr;
+    strm.opaque = nullptr;
+    strm.avail_in = static_cast<uInt>(gzippedData.size());
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(gzippedData.data()));
+
+    int ret = inflateInit2(&strm, 16 + MAX_WBITS);
+    if (ret != Z_OK) {
+        qCWarning(QGCZlibLog) << "inflateInit2 failed:" << ret;
+        return QByteArray();
+    }
+
+    // Grown as needed, most gzip streams compress text and small images by less than 4:1
+    QByteArray result(qMax<qsizetype>(gzippedData.size() * 4, 1024), Qt::Uninitialized);
+    qsizetype total = 0;
+    do {
+        if (total == result.size()) {
+            result.resize(result.size() * 2);
+        }
+        strm.avail_out = static_cast<uInt>(result.size() - total);
+        strm.next_out = reinterpret_cast<Bytef*>(result.data() + total);
+
+        ret = inflate(&strm, Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_NEED_DICT) {
+            qCWarning(QGCZlibLog) << "inflate failed:" << ret;
+            inflateEnd(&strm);
+            return QByteArray();
+        }
+
+        total = result.size() - strm.avail_out;
+    } while ((ret != Z_STREAM_END) && ((strm.avail_in > 0) || (strm.avail_out == 0)));
+
+    inflateEnd(&strm);
+
+    if (ret != Z_STREAM_END) {
+        qCWarning(QGCZlibLog) << "inflate did not reach stream end:" << ret;
+        return QByteArray();
+    }
+
+    result.truncate(total);
+    return result;
+}
+
 } // namespace QGCZlib
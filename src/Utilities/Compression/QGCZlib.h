@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <QtCore/QByteArray>
+#include <QtCore/QByteArrayView>
 #include <QtCore/QString>
 #include <QtCore/QLoggingCategory>
 
@@ -21,4 +23,9 @@ namespace QGCZlib
     ///     @param decompressedFilename Fully qualified path to for file to decompress to
     /// @return bool Success
     bool inflateGzipFile(const QString &gzippedFileName, const QString &decompressedFilename);
+
+    /// Decompresses gzip data held in memory
+    ///     @param gzippedData  Complete gzip stream
+    /// @return Decompressed data, empty on failure
+    QByteArray inflateGzip(QByteArrayView gzippedData);
 }
@@ -0,0 +1,108 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+/// Bounded lock-free ring buffer for exactly one producer thread and one consumer thread.
+/// Slots are preallocated, so pushing and popping never allocate. Capacity must be a power of two.
+template<typename T, qsizetype Capacity>
+class QGCSPSCRing
+{
+    static_assert((Capacity > 0) && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of two");
+
+public:
+    QGCSPSCRing() : _slots(std::make_unique<T[]>(Capacity)) {}
+
+    QGCSPSCRing(const QGCSPSCRing&) = delete;
+    QGCSPSCRing &operator=(const QGCSPSCRing&) = delete;
+
+    static constexpr qsizetype capacity() { return Capacity; }
+
+    /// Producer: Returns the next free slot to be filled in place, nullptr if the ring is full.
+    /// The slot is only visible to the consumer after commitPush.
+    T *beginPush()
+    {
+        const quint64 head = _head.load(std::memory_order_relaxed);
+        if ((head - _tail.load(std::memory_order_acquire)) == static_cast<quint64>(Capacity)) {
+            return nullptr;
+        }
+        return &_slots[head & kMask];
+    }
+
+    /// Producer: Publishes the slot returned by beginPush
+    void commitPush()
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// Producer: Copies value into the ring
+    ///     @return false: ring is full, value was not added
+    bool push(const T &value)
+    {
+        T *const slot = beginPush();
+        if (!slot) {
+            return false;
+        }
+        *slot = value;
+        commitPush();
+        return true;
+    }
+
+    /// Consumer: Returns the oldest entry, nullptr if the ring is empty.
+    /// The entry stays valid until popFront.
+    T *front()
+    {
+        const quint64 tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &_slots[tail & kMask];
+    }
+
+    /// Consumer: Releases the entry returned by front back to the producer
+    void popFront()
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// Consumer: Copies out the oldest entry
+    ///     @return false: ring is empty
+    bool pop(T &value)
+    {
+        T *const slot = front();
+        if (!slot) {
+            return false;
+        }
+        value = *slot;
+        popFront();
+        return true;
+    }
+
+    /// Approximate number of entries, exact only when called from either side with the other side idle
+    qsizetype size() const
+    {
+        return static_cast<qsizetype>(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire));
+    }
+
+    bool isEmpty() const { return (size() == 0); }
+
+private:
+    static constexpr quint64 kMask = static_cast<quint64>(Capacity) - 1;
+
+    // Head and tail are written by different threads, keep them on separate cache lines
+    alignas(64) std::atomic<quint64> _head = 0;
+    alignas(64) std::atomic<quint64> _tail = 0;
+
+    std::unique_ptr<T[]> _slots;
+};
@@ -40,14 +40,35 @@ void CompInfoParam::setJson(const QString& metadataJsonFileName)
         return;
     }
 
+    _noJsonMetadata = false;
+
+    // The json is only parsed when the file content changed, FactMetaData is created from the cached records on use
+    const bool loaded = _metaDataCache.load(_cacheProducer, metadataJsonFileName,
+                                            [this](const QByteArray& metaData, ParameterMetaDataCache::Sections& sections) {
+                                                return _parseJson(metaData, sections);
+                                            });
+    if (!loaded) {
+        qCWarning(CompInfoParamLog) << "Metadata json file open failed: compid:" << compId << metadataJsonFileName;
+        return;
+    }
+
+    // Indexed names are tried against every name without a direct match, so they are all needed right away
+    for (const QString& indexedName: _metaDataCache.names(_indexedNamesSection)) {
+        FactMetaData* newMetaData = _createMetaData(_metaDataCache.record(_indexedNamesSection, indexedName));
+        if (newMetaData) {
+            _indexedNameMetaDataList.append(RegexFactMetaDataPair_t(newMetaData->name(), newMetaData));
+        }
+    }
+}
+
+bool CompInfoParam::_parseJson(const QByteArray& metaData, ParameterMetaDataCache::Sections& sections)
+{
     QString         errorString;
     QJsonDocument   jsonDoc;
 
-    _noJsonMetadata = false;
-
-    if (!JsonHelper::isJsonFile(metadataJsonFileName, jsonDoc, errorString)) {
+    if (!JsonHelper::isJsonFile(metaData, jsonDoc, errorString)) {
         qCWarning(CompInfoParamLog) << "Metadata json file open failed: compid:" << compId << errorString;
-        return;
+        return false;
     }
     QJsonObject jsonObj = jsonDoc.object();
 
@@ -57,32 +78,47 @@ void CompInfoParam::setJson(const QString& metadataJsonFileName)
     };
     if (!JsonHelper::validateKeys(jsonObj, keyInfoList, errorString)) {
         qCWarning(CompInfoParamLog) << "Metadata json validation failed: compid:" << compId << errorString;
-        return;
+        return false;
     }
 
     int version = jsonObj[JsonHelper::jsonVersionKey].toInt();
     if (version != 1) {
         qCWarning(CompInfoParamLog) << "Metadata json unsupported version" << version;
-        return;
+        return false;
     }
 
+    // Each parameter object is kept as compact json and only turned into FactMetaData when the parameter shows up
     QJsonArray rgParameters = jsonObj[_jsonParametersKey].toArray();
     for (QJsonValue parameterValue: rgParameters) {
-        QMap<QString, QString> emptyDefineMap;
-
         if (!parameterValue.isObject()) {
             qCWarning(CompInfoParamLog) << "Metadata json read failed: compid:" << compId << "parameters array contains non-object";
-            return;
+            return false;
         }
 
-        FactMetaData* newMetaData = FactMetaData::createFromJsonObject(parameterValue.toObject(), emptyDefineMap, this);
+        const QJsonObject parameterObject = parameterValue.toObject();
+        const QString name = parameterObject[_jsonNameKey].toString();
+        const QString section = name.contains(_indexedNameTag) ? _indexedNamesSection : _namesSection;
+        sections[section][name] = QJsonDocument(parameterObject).toJson(QJsonDocument::Compact);
+    }
 
-        if (newMetaData->name().contains(_indexedNameTag)) {
-            _indexedNameMetaDataList.append(RegexFactMetaDataPair_t(newMetaData->name(), newMetaData));
-        } else {
-            _nameToMetaDataMap[newMetaData->name()] = newMetaData;
-        }
+    return true;
+}
+
+FactMetaData* CompInfoParam::_createMetaData(const QByteArray& record)
+{
+    if (record.isNull()) {
+        return nullptr;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument jsonDoc = QJsonDocument::fromJson(record, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        qCWarning(CompInfoParamLog) << "Unable to decode cached metadata: compid:" << compId << parseError.errorString();
+        return nullptr;
     }
+
+    QMap<QString, QString> emptyDefineMap;
+    return FactMetaData::createFromJsonObject(jsonDoc.object(), emptyDefineMap, this);
 }
 
 FactMetaData* CompInfoParam::factMetaDataForName(const QString& name, FactMetaData::ValueType_t type)
@@ -100,28 +136,33 @@ FactMetaData* CompInfoParam::factMetaDataForName(const QString& name, FactMetaDa
         if (_nameToMetaDataMap.contains(name)) {
             factMetaData = _nameToMetaDataMap[name];
         } else {
-            // We didn't get any direct matches. Try an indexed name.
-            for (int i=0; i<_indexedNameMetaDataList.count(); i++) {
-                const RegexFactMetaDataPair_t& pair = _indexedNameMetaDataList[i];
-
-                QString indexedName = pair.first;
-                const QString indexedRegex("(\\d+)");
-                indexedName.replace(_indexedNameTag, indexedRegex);
-
-                const QRegularExpression      regex(indexedName);
-                const QRegularExpressionMatch match = regex.match(name);
-
-                const QStringList captured = match.capturedTexts();
-                if (captured.count() == 2) {
-                    factMetaData = new FactMetaData(*pair.second, this);
-                    factMetaData->setName(name);
-
-                    QString shortDescription = factMetaData->shortDescription();
-                    shortDescription.replace(_indexedNameTag, captured[1]);
-                    factMetaData->setShortDescription(shortDescription);
-                    QString longDescription = factMetaData->shortDescription();
-                    longDescription.replace(_indexedNameTag, captured[1]);
-                    factMetaData->setLongDescription(longDescription);
+            // Direct matches from the json are created on first use
+            factMetaData = _createMetaData(_metaDataCache.record(_namesSection, name));
+
+            if (!factMetaData) {
+                // We didn't get any direct matches. Try an indexed name.
+                for (int i=0; i<_indexedNameMetaDataList.count(); i++) {
+                    const RegexFactMetaDataPair_t& pair = _indexedNameMetaDataList[i];
+
+                    QString indexedName = pair.first;
+                    const QString indexedRegex("(\\d+)");
+                    indexedName.replace(_indexedNameTag, indexedRegex);
+
+                    const QRegularExpression      regex(indexedName);
+                    const QRegularExpressionMatch match = regex.match(name);
+
+                    const QStringList captured = match.capturedTexts();
+                    if (captured.count() == 2) {
+                        factMetaData = new FactMetaData(*pair.second, this);
+                        factMetaData->setName(name);
+
+                        QString shortDescription = factMetaData->shortDescription();
+                        shortDescription.replace(_indexedNameTag, captured[1]);
+                        factMetaData->setShortDescription(shortDescription);
+                        QString longDescription = factMetaData->shortDescription();
+                        longDescription.replace(_indexedNameTag, captured[1]);
+                        factMetaData->setLongDescription(longDescription);
+                    }
                 }
             }
 
@@ -12,6 +12,7 @@
 #include "CompInfo.h"
 #include "QGCMAVLink.h"
 #include "FactMetaData.h"
+#include "ParameterMetaDataCache.h"
 
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
@@ -37,6 +38,8 @@ public:
 
 private:
     QObject* _getOpaqueParameterMetaData(void);
+    bool _parseJson(const QByteArray& metaData, ParameterMetaDataCache::Sections& sections);
+    FactMetaData* _createMetaData(const QByteArray& record);
 
     static FirmwarePlugin*  _anyVehicleTypeFirmwarePlugin   (MAV_AUTOPILOT firmwareType);
     static QString          _parameterMetaDataFile          (Vehicle* vehicle, MAV_AUTOPILOT firmwareType, int& majorVersion, int& minorVersion);
@@ -44,11 +47,16 @@ private:
     typedef QPair<QString /* indexed name */, FactMetaData*> RegexFactMetaDataPair_t;
 
     bool                                _noJsonMetadata             = true;
+    ParameterMetaDataCache              _metaDataCache;             ///< Parameter objects from the json, by name
     FactMetaData::NameToMetaDataMap_t   _nameToMetaDataMap;
     QList<RegexFactMetaDataPair_t>      _indexedNameMetaDataList;
     QObject*                            _opaqueParameterMetaData    = nullptr;
 
     static constexpr const char* _jsonParametersKey           = "parameters";
+    static constexpr const char* _jsonNameKey                 = "name";
+    static constexpr const char* _namesSection                = "names";
+    static constexpr const char* _indexedNamesSection         = "indexedNames";
+    static constexpr const char* _cacheProducer               = "CompInfoParam";
     static constexpr const char* _cachedMetaDataFilePrefix    = "ParameterFactMetaData";
     static constexpr const char* _indexedNameTag              = "{n}";
 };
@@ -13,216 +13,303 @@
 #include "QGCApplication.h"
 #include "QGCLoggingCategory.h"
 
-#include <QtCore/QFile>
+#include <QtCore/QDataStream>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QSaveFile>
 
 QGC_LOGGING_CATEGORY(FTPManagerLog, "FTPManagerLog")
 
 FTPManager::FTPManager(Vehicle* vehicle)
-    : QObject   (vehicle)
-    , _vehicle  (vehicle)
+    : QObject               (vehicle)
+    , _vehicle              (vehicle)
+    // Mock link responds immediately if at all, speed up unit tests with faster timeout
+    , _ackOrNakTimeoutMsecs (qgcApp()->runningUnitTests() ? 10 : _ackOrNakTimeoutMsecsDefault)
 {
-    _ackOrNakTimeoutTimer.setSingleShot(true);
-    // Mock link responds immediately if at all, speed up unit tests with faster timoue
-    _ackOrNakTimeoutTimer.setInterval(qgcApp()->runningUnitTests() ? 10 : _ackOrNakTimeoutMsecs);
+    // The timeouts of all requests in flight are checked on a single timer
+    _ackOrNakTimeoutTimer.setInterval(qMax(1, _ackOrNakTimeoutMsecs / 4));
     connect(&_ackOrNakTimeoutTimer, &QTimer::timeout, this, &FTPManager::_ackOrNakTimeout);
-    
+    _clock.start();
+
     // Make sure we don't have bad structure packing
     Q_ASSERT(sizeof(MavlinkFTP::RequestHeader) == 12);
 }
 
+FTPManager::~FTPManager()
+{
+    // The vehicle going away is a link drop as well, keep what was downloaded so far
+    for (Transfer_t* transfer: _transfers) {
+        if (transfer->type == TransferDownload && transfer->file.isOpen() && transfer->checksize && transfer->blocksDone > 0) {
+            _saveResumeFile(transfer);
+        }
+    }
+    qDeleteAll(_transfers);
+}
+
 bool FTPManager::download(uint8_t fromCompId, const QString& fromURI, const QString& toDir, const QString& fileName, bool checksize)
 {
     qCDebug(FTPManagerLog) << "download fromURI:" << fromURI << "to:" << toDir << "fromCompId:" << fromCompId;
 
-    if (!_rgStateMachine.isEmpty()) {
+    if (_legacyTransfer(TransferDownload) || _legacyTransfer(TransferList)) {
         qCDebug(FTPManagerLog) << "Cannot download. Already in another operation";
         return false;
     }
 
-    static const StateFunctions_t rgDownloadStateMachine[] = {
-        { &FTPManager::_openFileROBegin,            &FTPManager::_openFileROAckOrNak,           &FTPManager::_openFileROTimeout },
-        { &FTPManager::_burstReadFileBegin,         &FTPManager::_burstReadFileAckOrNak,        &FTPManager::_burstReadFileTimeout },
-        { &FTPManager::_fillMissingBlocksBegin,     &FTPManager::_fillMissingBlocksAckOrNak,    &FTPManager::_fillMissingBlocksTimeout },
-        { &FTPManager::_resetSessionsBegin,         &FTPManager::_resetSessionsAckOrNak,        &FTPManager::_resetSessionsTimeout },
-        { &FTPManager::_downloadCompleteNoError,    nullptr,                                    nullptr },
-    };
-    for (size_t i=0; i<sizeof(rgDownloadStateMachine)/sizeof(rgDownloadStateMachine[0]); i++) {
-        _rgStateMachine.append(rgDownloadStateMachine[i]);
+    Transfer_t* transfer = _newDownload(fromCompId, fromURI, toDir, fileName, checksize);
+    if (!transfer) {
+        return false;
     }
+    transfer->legacy = true;
+    _queueTransfer(transfer);
 
-    _downloadState.reset();
-    _downloadState.toDir.setPath(toDir);
-    _downloadState.checksize = checksize;
+    return true;
+}
 
-    if (!_parseURI(fromCompId, fromURI, _downloadState.fullPathOnVehicle, _ftpCompId)) {
-        qCWarning(FTPManagerLog) << "_parseURI failed";
+bool FTPManager::listDirectory(uint8_t fromCompId, const QString& fromURI)
+{
+    qCDebug(FTPManagerLog) << "list directory fromURI:" << fromURI << "fromCompId:" << fromCompId;
+
+    if (_legacyTransfer(TransferDownload) || _legacyTransfer(TransferList)) {
+        qCDebug(FTPManagerLog) << "Cannot list directory. Already in another operation";
         return false;
     }
 
-    // We need to strip off the file name from the fully qualified path. We can't use the usual QDir
-    // routines because this path does not exist locally.
-    int lastDirSlashIndex;
-    for (lastDirSlashIndex=_downloadState.fullPathOnVehicle.size()-1; lastDirSlashIndex>=0; lastDirSlashIndex--) {
-        if (_downloadState.fullPathOnVehicle[lastDirSlashIndex] == '/') {
-            break;
-        }
+    Transfer_t* transfer = _newTransfer(TransferList, fromCompId, fromURI);
+    if (!transfer) {
+        return false;
     }
-    lastDirSlashIndex++; // move past slash
+    transfer->legacy = true;
 
-    if (fileName.isEmpty()) {
-        _downloadState.fileName = _downloadState.fullPathOnVehicle.right(_downloadState.fullPathOnVehicle.size() - lastDirSlashIndex);
-    } else {
-        _downloadState.fileName = fileName;
+    qCDebug(FTPManagerLog) << "list directory pathOnVehicle" << transfer->pathOnVehicle;
+
+    _queueTransfer(transfer);
+
+    return true;
+}
+
+void FTPManager::cancelDownload()
+{
+    Transfer_t* transfer = _legacyTransfer(TransferDownload);
+    if (transfer) {
+        cancelTransfer(transfer->id);
     }
+}
 
-    qCDebug(FTPManagerLog) << "_downloadState.fullPathOnVehicle:_downloadState.fileName" << _downloadState.fullPathOnVehicle << _downloadState.fileName;
+int FTPManager::queueDownload(uint8_t fromCompId, const QString& fromURI, const QString& toDir, const QString& fileName, bool checksize)
+{
+    qCDebug(FTPManagerLog) << "queueDownload fromURI:" << fromURI << "to:" << toDir << "fromCompId:" << fromCompId;
 
-    _startStateMachine();
+    Transfer_t* transfer = _newDownload(fromCompId, fromURI, toDir, fileName, checksize);
+    if (!transfer) {
+        return -1;
+    }
+    int transferId = transfer->id;
+    _queueTransfer(transfer);
 
-    return true;
+    return transferId;
 }
 
-bool FTPManager::listDirectory(uint8_t fromCompId, const QString& fromURI)
+int FTPManager::queueUpload(uint8_t toCompId, const QString& fromFile, const QString& toURI)
 {
-    qCDebug(FTPManagerLog) << "list directory fromURI:" << fromURI << "fromCompId:" << fromCompId;
+    qCDebug(FTPManagerLog) << "queueUpload fromFile:" << fromFile << "toURI:" << toURI << "toCompId:" << toCompId;
 
-    if (!_rgStateMachine.isEmpty()) {
-        qCDebug(FTPManagerLog) << "Cannot list directory. Already in another operation";
-        return false;
+    QFileInfo fileInfo(fromFile);
+    if (!fileInfo.isFile() || fileInfo.size() > std::numeric_limits<uint32_t>::max()) {
+        qCWarning(FTPManagerLog) << "queueUpload: invalid file" << fromFile;
+        return -1;
     }
 
-    static const StateFunctions_t rgStateMachine[] = {
-        { &FTPManager::_listDirectoryBegin,             &FTPManager::_listDirectoryAckOrNak,        &FTPManager::_listDirectoryTimeout },
-        { &FTPManager::_listDirectoryCompleteNoError,   nullptr,                                    nullptr },
-    };
-    for (size_t i=0; i<sizeof(rgStateMachine)/sizeof(rgStateMachine[0]); i++) {
-        _rgStateMachine.append(rgStateMachine[i]);
+    Transfer_t* transfer = _newTransfer(TransferUpload, toCompId, toURI);
+    if (!transfer) {
+        return -1;
     }
+    transfer->localPath = fileInfo.absoluteFilePath();
+    transfer->fileSize  = static_cast<uint32_t>(fileInfo.size());
+    transfer->sizeKnown = true;
+    transfer->blocks.resize(_blockCount(transfer->fileSize));
+    transfer->blocksRequested.fill(false, transfer->blocks.size());
+    int transferId = transfer->id;
+    _queueTransfer(transfer);
+
+    return transferId;
+}
 
-    _listDirectoryState.reset();
+void FTPManager::cancelTransfer(int transferId)
+{
+    // Deferred so a transfer can be cancelled from within its own signals
+    QMetaObject::invokeMethod(this, [this, transferId]() {
+        Transfer_t* transfer = _transfer(transferId);
+        if (transfer) {
+            qCDebug(FTPManagerLog) << "cancelTransfer" << transferId;
+            _transferFailed(transfer, QStringLiteral("Aborted"));
+        }
+    }, Qt::QueuedConnection);
+}
 
-    if (!_parseURI(fromCompId, fromURI, _listDirectoryState.fullPathOnVehicle, _ftpCompId)) {
+FTPManager::Transfer_t* FTPManager::_newTransfer(TransferType_t type, uint8_t compId, const QString& uri)
+{
+    QString pathOnVehicle;
+    uint8_t ftpCompId;
+
+    if (!_parseURI(compId, uri, pathOnVehicle, ftpCompId)) {
         qCWarning(FTPManagerLog) << "_parseURI failed";
-        return false;
+        return nullptr;
     }
 
-    qCDebug(FTPManagerLog) << "_listDirectoryState.fullPathOnVehicle" << _listDirectoryState.fullPathOnVehicle;
-
-    _startStateMachine();
+    Transfer_t* transfer    = new Transfer_t;
+    transfer->id            = _nextTransferId++;
+    transfer->type          = type;
+    transfer->compId        = ftpCompId;
+    transfer->pathOnVehicle = pathOnVehicle;
 
-    return true;
+    return transfer;
 }
 
-void FTPManager::cancelDownload()
+FTPManager::Transfer_t* FTPManager::_newDownload(uint8_t fromCompId, const QString& fromURI, const QString& toDir, const QString& fileName, bool checksize)
 {
-    if (!_downloadState.inProgress()) {
-        return;
+    Transfer_t* transfer = _newTransfer(TransferDownload, fromCompId, fromURI);
+    if (!transfer) {
+        return nullptr;
     }
 
-    _ackOrNakTimeoutTimer.stop();
-    _rgStateMachine.clear();
-    static const StateFunctions_t rgTerminateStateMachine[] = {
-        { &FTPManager::_terminateSessionBegin,  &FTPManager::_terminateSessionAckOrNak,     &FTPManager::_terminateSessionTimeout },
-        { &FTPManager::_terminateComplete,      nullptr,                                    nullptr },
-    };
-    for (size_t i=0; i<sizeof(rgTerminateStateMachine)/sizeof(rgTerminateStateMachine[0]); i++) {
-        _rgStateMachine.append(rgTerminateStateMachine[i]);
+    // We need to strip off the file name from the fully qualified path. We can't use the usual QDir
+    // routines because this path does not exist locally.
+    QString localFileName = fileName;
+    if (localFileName.isEmpty()) {
+        localFileName = transfer->pathOnVehicle.mid(transfer->pathOnVehicle.lastIndexOf('/') + 1);
     }
-    _downloadState.retryCount = 0;
-    _startStateMachine();
+    transfer->localPath = QDir(toDir).absoluteFilePath(localFileName);
+    transfer->checksize = checksize;
+
+    qCDebug(FTPManagerLog) << "pathOnVehicle:localPath" << transfer->pathOnVehicle << transfer->localPath;
+
+    return transfer;
 }
 
-void FTPManager::_terminateSessionBegin(void)
+FTPManager::Transfer_t* FTPManager::_transfer(int transferId)
 {
-    MavlinkFTP::Request request{};
-    request.hdr.session = _downloadState.sessionId;
-    request.hdr.opcode  = MavlinkFTP::kCmdTerminateSession;
-    _sendRequestExpectAck(&request);
+    for (Transfer_t* transfer: _transfers) {
+        if (transfer->id == transferId) {
+            return transfer;
+        }
+    }
+    return nullptr;
 }
 
-void FTPManager::_terminateSessionAckOrNak(const MavlinkFTP::Request *ackOrNak)
+FTPManager::Transfer_t* FTPManager::_legacyTransfer(TransferType_t type)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
-    if (requestOpCode != MavlinkFTP::kCmdTerminateSession) {
-        qCDebug(FTPManagerLog) << "_terminateSessionAckOrNak: Ack disregarding ack for incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
-        return;
-    }
-    if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-        qCDebug(FTPManagerLog) << "_terminateSessionAckOrNak: Ack disregarding ack for incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-        return;
+    for (Transfer_t* transfer: _transfers) {
+        if (transfer->legacy && transfer->type == type) {
+            return transfer;
+        }
     }
-
-    _ackOrNakTimeoutTimer.stop();
-    _advanceStateMachine();
+    return nullptr;
 }
 
-void FTPManager::_terminateSessionTimeout(void)
+FTPManager::Transfer_t* FTPManager::_burstTransfer(uint8_t compId, uint8_t sessionId)
 {
-    if (++_downloadState.retryCount > _maxRetry) {
-        qCDebug(FTPManagerLog) << QString("_terminateSessionTimeout retries exceeded");
-        _downloadComplete(tr("Download failed"));
-    } else {
-        // Try again
-        qCDebug(FTPManagerLog) << QString("_terminateSessionTimeout: retrying - retryCount(%1)").arg(_downloadState.retryCount);
-        _terminateSessionBegin();
+    for (Transfer_t* transfer: _transfers) {
+        if (transfer->state == StateBurstRead && transfer->compId == compId && transfer->sessionId == sessionId) {
+            return transfer;
+        }
     }
-
+    return nullptr;
 }
 
-void FTPManager::_terminateComplete(void)
+void FTPManager::_queueTransfer(Transfer_t* transfer)
 {
-    _downloadComplete("Aborted");
+    _transfers.append(transfer);
+    _startQueuedTransfers();
 }
 
-/// Closes out a download session by writing the file and doing cleanup.
-///     @param errorMsg Error message, empty if no error
-void FTPManager::_downloadComplete(const QString& errorMsg)
+int FTPManager::_activeSessions(uint8_t compId)
 {
-    qCDebug(FTPManagerLog) << QString("_downloadComplete: errorMsg(%1)").arg(errorMsg);
-    
-    QString downloadFilePath    = _downloadState.toDir.absoluteFilePath(_downloadState.fileName);
-    QString error               = errorMsg;
+    int count = 0;
+    for (const Transfer_t* transfer: _transfers) {
+        if (transfer->compId == compId && transfer->type != TransferList && transfer->state != StateQueued) {
+            count++;
+        }
+    }
+    return count;
+}
 
-    _ackOrNakTimeoutTimer.stop();
-    _rgStateMachine.clear();
-    _currentStateMachineIndex = -1;
-    if (_downloadState.file.isOpen()) {
-        _downloadState.file.close();
-        if (!errorMsg.isEmpty()) {
-            _downloadState.file.remove();
+/// Starts the queued transfers in queue order as long as their component has sessions left. Directory listings
+/// don't use a session.
+void FTPManager::_startQueuedTransfers(void)
+{
+    // Starting a transfer can complete it and start others, go by id
+    QList<int> queued;
+    for (const Transfer_t* transfer: _transfers) {
+        if (transfer->state == StateQueued) {
+            queued.append(transfer->id);
         }
     }
+    for (int transferId: queued) {
+        Transfer_t* transfer = _transfer(transferId);
+        if (!transfer || transfer->state != StateQueued) {
+            continue;
+        }
+        if (transfer->type != TransferList) {
+            const Server_t& server = _servers[transfer->compId];
+            int maxSessions = server.maxSessions ? qMin(server.maxSessions, _maxSessions) : _maxSessions;
+            if (_activeSessions(transfer->compId) >= maxSessions) {
+                continue;
+            }
+        }
+        _startTransfer(transfer);
+    }
 
-    emit downloadComplete(downloadFilePath, errorMsg);
+    if (_transfers.isEmpty()) {
+        _ackOrNakTimeoutTimer.stop();
+    } else if (!_ackOrNakTimeoutTimer.isActive()) {
+        _ackOrNakTimeoutTimer.start();
+    }
 }
 
-/// Closes out a list directory sequence
-///     @param errorMsg Error message, empty if no error
-void FTPManager::_listDirectoryComplete(const QString& errorMsg)
+void FTPManager::_startTransfer(Transfer_t* transfer)
 {
-    qCDebug(FTPManagerLog) << QString("_listDirectoryComplete: errorMsg(%1)").arg(errorMsg);
-    
-    _ackOrNakTimeoutTimer.stop();
-    _rgStateMachine.clear();
-    _currentStateMachineIndex = -1;
+    qCDebug(FTPManagerLog) << "_startTransfer id:type:pathOnVehicle" << transfer->id << transfer->type << transfer->pathOnVehicle;
 
-    QStringList rgDirectoryList = _listDirectoryState.rgDirectoryList;
-    if (!errorMsg.isEmpty()) {
-        rgDirectoryList.clear();
-    }
+    transfer->elapsed.start();
 
-    emit listDirectoryComplete(rgDirectoryList, errorMsg);
+    MavlinkFTP::Request request{};
+
+    switch (transfer->type) {
+    case TransferDownload:
+        transfer->state     = StateOpen;
+        request.hdr.opcode  = MavlinkFTP::kCmdOpenFileRO;
+        _fillRequestDataWithString(&request, transfer->pathOnVehicle);
+        _sendRequest(transfer, &request);
+        break;
+    case TransferUpload:
+        // Still open if the transfer was requeued for lack of sessions
+        transfer->file.setFileName(transfer->localPath);
+        if (!transfer->file.isOpen() && !transfer->file.open(QFile::ReadOnly)) {
+            qCDebug(FTPManagerLog) << "_startTransfer: open failed" << transfer->file.errorString();
+            _transferFailed(transfer, tr("Upload failed: Error reading file"));
+            return;
+        }
+        transfer->state     = StateOpen;
+        request.hdr.opcode  = MavlinkFTP::kCmdCreateFile;
+        _fillRequestDataWithString(&request, transfer->pathOnVehicle);
+        _sendRequest(transfer, &request);
+        break;
+    case TransferList:
+        transfer->state = StateList;
+        _listDirectoryWorker(transfer);
+        break;
+    }
 }
 
 void FTPManager::_mavlinkMessageReceived(const mavlink_message_t& message)
 {
-    if (message.msgid != MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL ||
-            message.sysid != _vehicle->id() || message.compid != _ftpCompId) {
+    if (message.msgid != MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL || message.sysid != _vehicle->id() || _transfers.isEmpty()) {
         return;
     }
 
-    if (_currentStateMachineIndex == -1) {
+    auto serverIt = _servers.find(message.compid);
+    if (serverIt == _servers.end()) {
         return;
     }
 
@@ -234,40 +321,175 @@ void FTPManager::_mavlinkMessageReceived(const mavlink_message_t& message)
     if (data.target_system != qgcId) {
         return;
     }
-    
-    MavlinkFTP::Request* request = (MavlinkFTP::Request*)&data.payload[0];
 
-    // Ignore old/reordered packets (handle wrap-around properly)
-    uint16_t actualIncomingSeqNumber = request->hdr.seqNumber;
-    if ((uint16_t)((_expectedIncomingSeqNumber - 1) - actualIncomingSeqNumber) < (std::numeric_limits<uint16_t>::max()/2)) {
-        qCDebug(FTPManagerLog) << "_mavlinkMessageReceived: Received old packet seqNum expected:actual" << _expectedIncomingSeqNumber << actualIncomingSeqNumber
-                               << "hdr.opcode:hdr.req_opcode" << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.opcode)) <<  MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.req_opcode));
+    const MavlinkFTP::Request*  ackOrNak        = (const MavlinkFTP::Request*)&data.payload[0];
+    MavlinkFTP::OpCode_t        requestOpCode   = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
 
+    qCDebug(FTPManagerLog) << "_mavlinkMessageReceived: hdr.opcode:hdr.req_opcode:seqNumber:session"
+                           << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.opcode)) << MavlinkFTP::opCodeToString(requestOpCode)
+                           << ackOrNak->hdr.seqNumber << ackOrNak->hdr.session;
+
+    // Requests continue past the sequence numbers used by the component, bursts use up several (handle wrap-around properly)
+    uint16_t nextSeqNumber = ackOrNak->hdr.seqNumber + 1;
+    if (static_cast<int16_t>(nextSeqNumber - serverIt->nextSeqNumber) > 0) {
+        serverIt->nextSeqNumber = nextSeqNumber;
+    }
+
+    if (requestOpCode == MavlinkFTP::kCmdBurstReadFile) {
+        // Burst packets are only numbered from the burst request on, they are matched by session
+        Transfer_t* transfer = _burstTransfer(message.compid, ackOrNak->hdr.session);
+        if (transfer) {
+            _burstReadFileAckOrNak(transfer, ackOrNak);
+        }
         return;
     }
 
-    qCDebug(FTPManagerLog) << "_mavlinkMessageReceived: hdr.opcode:hdr.req_opcode:seqNumber"
-                           << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.opcode)) <<  MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.req_opcode))
-                           << request->hdr.seqNumber;
+    // Replies are numbered one past their request
+    auto pendingIt = _pendingRequests.find(_pendingKey(message.compid, ackOrNak->hdr.seqNumber - 1));
+    if (pendingIt == _pendingRequests.end() || pendingIt->request.hdr.opcode != requestOpCode) {
+        qCDebug(FTPManagerLog) << "_mavlinkMessageReceived: Disregarding reply without request";
+        return;
+    }
+    PendingRequest_t pending = *pendingIt;
+    _pendingRequests.erase(pendingIt);
+
+    Transfer_t* transfer = _transfer(pending.transferId);
+    if (!transfer) {
+        return;
+    }
+
+    switch (requestOpCode) {
+    case MavlinkFTP::kCmdOpenFileRO:
+    case MavlinkFTP::kCmdCreateFile:
+        _openAckOrNak(transfer, ackOrNak);
+        break;
+    case MavlinkFTP::kCmdReadFile:
+        _fillMissingBlocksAckOrNak(transfer, pending, ackOrNak);
+        break;
+    case MavlinkFTP::kCmdWriteFile:
+        _writeFileAckOrNak(transfer, pending, ackOrNak);
+        break;
+    case MavlinkFTP::kCmdListDirectory:
+        _listDirectoryAckOrNak(transfer, ackOrNak);
+        break;
+    case MavlinkFTP::kCmdCalcFileCRC32:
+        _checkCrcAckOrNak(transfer, ackOrNak);
+        break;
+    case MavlinkFTP::kCmdTerminateSession:
+        // A Nak means the session is gone already, which is as good
+        qCDebug(FTPManagerLog) << "_mavlinkMessageReceived: session terminated" << transfer->sessionId;
+        transfer->sessionOpen = false;
+        _transferComplete(transfer, QString());
+        break;
+    default:
+        break;
+    }
+}
+
+void FTPManager::_ackOrNakTimeout(void)
+{
+    const qint64 nowMs = _clock.elapsed();
+
+    // Retries and failures change the pending requests, collect the timed out ones first
+    QList<quint32> timedOut;
+    for (auto it = _pendingRequests.cbegin(); it != _pendingRequests.cend(); it++) {
+        if (nowMs - it->sentMs >= _ackOrNakTimeoutMsecs) {
+            timedOut.append(it.key());
+        }
+    }
+    for (quint32 key: timedOut) {
+        auto it = _pendingRequests.find(key);
+        if (it == _pendingRequests.end()) {
+            // Dropped along with its failed transfer
+            continue;
+        }
+        PendingRequest_t pending = *it;
+        _pendingRequests.erase(it);
+
+        Transfer_t* transfer = _transfer(pending.transferId);
+        if (transfer) {
+            _requestTimeout(transfer, pending);
+        }
+    }
 
-    (this->*_rgStateMachine[_currentStateMachineIndex].ackNakFn)(request);
+    // Bursts have no reply to wait for, a stalled burst is started again from where it stopped
+    QList<int> bursts;
+    for (const Transfer_t* transfer: _transfers) {
+        if (transfer->state == StateBurstRead && nowMs - transfer->lastActivityMs >= _ackOrNakTimeoutMsecs) {
+            bursts.append(transfer->id);
+        }
+    }
+    for (int transferId: bursts) {
+        Transfer_t* transfer = _transfer(transferId);
+        if (!transfer) {
+            continue;
+        }
+        if (++transfer->burstRetryCount > _maxRetry) {
+            qCDebug(FTPManagerLog) << "_ackOrNakTimeout: burst retries exceeded";
+            _transferFailed(transfer, tr("Download failed"), true /* resumable */);
+        } else {
+            qCDebug(FTPManagerLog) << QString("_ackOrNakTimeout: retrying burst - retryCount(%1) offset(%2)").arg(transfer->burstRetryCount).arg(transfer->burstOffset);
+            _burstReadFileWorker(transfer, false /* firstRequest */);
+        }
+    }
+
+    if (_transfers.isEmpty()) {
+        _ackOrNakTimeoutTimer.stop();
+    }
 }
 
-void FTPManager::_startStateMachine(void)
+void FTPManager::_requestTimeout(Transfer_t* transfer, PendingRequest_t& pending)
 {
-    _currentStateMachineIndex = -1;
-    _advanceStateMachine();
+    MavlinkFTP::OpCode_t opCode = static_cast<MavlinkFTP::OpCode_t>(pending.request.hdr.opcode);
+
+    qCDebug(FTPManagerLog) << "_requestTimeout:" << MavlinkFTP::opCodeToString(opCode) << "seqNumber:" << pending.request.hdr.seqNumber << "retryCount:" << pending.retryCount;
+
+    switch (opCode) {
+    case MavlinkFTP::kCmdOpenFileRO:
+    case MavlinkFTP::kCmdCreateFile:
+        // Not retried, a second open would leave the session of a lost ack open on the vehicle
+        _transferFailed(transfer, _failedMessage(transfer), true /* resumable */);
+        break;
+    case MavlinkFTP::kCmdTerminateSession:
+        if (pending.retryCount < _maxRetry) {
+            _retryRequest(transfer, pending);
+        } else {
+            // All data is through, the session times out on the vehicle eventually
+            _transferComplete(transfer, QString());
+        }
+        break;
+    default:
+        _retryRequest(transfer, pending);
+        break;
+    }
 }
 
-void FTPManager::_advanceStateMachine(void)
+/// Sends a request again with the same sequence number
+///     @return false: retries exceeded, the transfer failed
+bool FTPManager::_retryRequest(Transfer_t* transfer, PendingRequest_t& pending)
 {
-    _currentStateMachineIndex++;
-    (this->*_rgStateMachine[_currentStateMachineIndex].beginFn)();
+    if (++pending.retryCount > _maxRetry) {
+        qCDebug(FTPManagerLog) << "_retryRequest: retries exceeded" << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(pending.request.hdr.opcode));
+        _transferFailed(transfer, _failedMessage(transfer), true /* resumable */);
+        return false;
+    }
+
+    pending.sentMs = _clock.elapsed();
+    _pendingRequests.insert(_pendingKey(transfer->compId, pending.request.hdr.seqNumber), pending);
+    _sendMessage(transfer->compId, &pending.request);
+
+    return true;
 }
 
-void FTPManager::_ackOrNakTimeout(void)
+void FTPManager::_dropPendingRequests(int transferId)
 {
-    (this->*_rgStateMachine[_currentStateMachineIndex].timeoutFn)();
+    for (auto it = _pendingRequests.begin(); it != _pendingRequests.end(); ) {
+        if (it->transferId == transferId) {
+            it = _pendingRequests.erase(it);
+        } else {
+            it++;
+        }
+    }
 }
 
 void FTPManager::_fillRequestDataWithString(MavlinkFTP::Request* request, const QString& str)
@@ -293,449 +515,582 @@ QString FTPManager::_errorMsgFromNak(const MavlinkFTP::Request* nak)
     return errorMsg;
 }
 
-void FTPManager::_openFileROBegin(void)
+QString FTPManager::_failedMessage(Transfer_t* transfer) const
 {
-    MavlinkFTP::Request request{};
-    request.hdr.session = 0;
-    request.hdr.opcode  = MavlinkFTP::kCmdOpenFileRO;
-    request.hdr.offset  = 0;
-    request.hdr.size    = 0;
-    _fillRequestDataWithString(&request, _downloadState.fullPathOnVehicle);
-    _sendRequestExpectAck(&request);
+    switch (transfer->type) {
+    case TransferDownload:
+        return tr("Download failed");
+    case TransferUpload:
+        return tr("Upload failed");
+    case TransferList:
+        break;
+    }
+    return tr("List directory failed");
 }
 
-void FTPManager::_openFileROTimeout(void)
+void FTPManager::_openAckOrNak(Transfer_t* transfer, const MavlinkFTP::Request* ackOrNak)
 {
-    qCDebug(FTPManagerLog) << "_openFileROTimeout";
-    _downloadComplete(tr("Download failed"));
-}
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
 
-void FTPManager::_openFileROAckOrNak(const MavlinkFTP::Request* ackOrNak)
-{
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
-    if (requestOpCode != MavlinkFTP::kCmdOpenFileRO) {
-        qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack disregarding ack for incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
+        qCDebug(FTPManagerLog) << "_openAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+
+        // The component has fewer sessions than we use, wait for one of ours to finish
+        int otherSessions = _activeSessions(transfer->compId) - 1;
+        if (errorCode == MavlinkFTP::kErrNoSessionsAvailable && otherSessions > 0) {
+            qCDebug(FTPManagerLog) << "_openAckOrNak: requeued, sessions available" << otherSessions;
+            _servers[transfer->compId].maxSessions = otherSessions;
+            transfer->state = StateQueued;
+            return;
+        }
+
+        _transferFailed(transfer, _failedMessage(transfer) + ": " + _errorMsgFromNak(ackOrNak));
         return;
     }
-    if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-        qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack disregarding ack for incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
+
+    transfer->sessionId     = ackOrNak->hdr.session;
+    transfer->sessionOpen   = true;
+
+    if (transfer->type == TransferUpload) {
+        qCDebug(FTPManagerLog) << "_openAckOrNak: Ack - sessionId" << transfer->sessionId;
+        _writeFileWorker(transfer);
         return;
     }
 
-    _ackOrNakTimeoutTimer.stop();
+    qCDebug(FTPManagerLog) << "_openAckOrNak: Ack - sessionId:openFileLength" << ackOrNak->hdr.session << ackOrNak->openFileLength;
 
-    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
-        qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack  - sessionId:openFileLength" << ackOrNak->hdr.session << ackOrNak->openFileLength;
+    if (ackOrNak->hdr.size != sizeof(uint32_t)) {
+        qCDebug(FTPManagerLog) << "_openAckOrNak: Ack ack->hdr.size != sizeof(uint32_t)" << ackOrNak->hdr.size << sizeof(uint32_t);
+        _transferFailed(transfer, tr("Download failed"));
+        return;
+    }
 
-        if (ackOrNak->hdr.size != sizeof(uint32_t)) {
-            qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack ack->hdr.size != sizeof(uint32_t)" << ackOrNak->hdr.size << sizeof(uint32_t);
-            _downloadComplete(tr("Download failed"));
-            return;
-        }
+    transfer->reportedSize = ackOrNak->openFileLength;
+    if (transfer->checksize) {
+        transfer->fileSize  = transfer->reportedSize;
+        transfer->sizeKnown = true;
+        transfer->blocks.resize(_blockCount(transfer->fileSize));
+        transfer->resumed   = _loadResumeFile(transfer);
+    }
 
-        _downloadState.sessionId        = ackOrNak->hdr.session;
-        _downloadState.fileSize         = ackOrNak->openFileLength;
-        _downloadState.expectedOffset   = 0;
+    transfer->file.setFileName(transfer->localPath);
+    if (!transfer->file.open(transfer->resumed ? QFile::ReadWrite : (QFile::ReadWrite | QFile::Truncate))) {
+        qCDebug(FTPManagerLog) << "_openAckOrNak: Ack file open failed" << transfer->file.errorString();
+        _transferFailed(transfer, tr("Download failed"));
+        return;
+    }
+    // Blocks are written where they belong as they come in
+    if (transfer->sizeKnown && !transfer->resumed && !transfer->file.resize(transfer->fileSize)) {
+        qCDebug(FTPManagerLog) << "_openAckOrNak: Ack file resize failed" << transfer->file.errorString();
+        _transferFailed(transfer, tr("Download failed: Error saving file"));
+        return;
+    }
 
-        _downloadState.file.setFileName(_downloadState.toDir.filePath(_downloadState.fileName));
-        if (_downloadState.file.open(QFile::WriteOnly | QFile::Truncate)) {
-            _advanceStateMachine();
-        } else {
-            qCDebug(FTPManagerLog) << "_openFileROAckOrNak: Ack _downloadState.file open failed" << _downloadState.file.errorString();
-            _downloadComplete(tr("Download failed"));
-        }
-    } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
-        qCDebug(FTPManagerLog) << "_handlOpenFileROAck: Nak -" << _errorMsgFromNak(ackOrNak);
-        _downloadComplete(tr("Download failed") + ": " + _errorMsgFromNak(ackOrNak));
+    if (transfer->resumed) {
+        qCDebug(FTPManagerLog) << "_openAckOrNak: resuming download - blocksDone:blockCount" << transfer->blocksDone << transfer->blocks.size();
     }
+
+    transfer->burstOffset = 0;
+    _continueBurst(transfer);
 }
 
-void FTPManager::_burstReadFileWorker(bool firstRequest)
+void FTPManager::_burstReadFileWorker(Transfer_t* transfer, bool firstRequest)
 {
-    qCDebug(FTPManagerLog) << "_burstReadFileWorker: starting burst at offset:firstRequest:retryCount" << _downloadState.expectedOffset << firstRequest << _downloadState.retryCount;
+    qCDebug(FTPManagerLog) << "_burstReadFileWorker: starting burst at offset:firstRequest:retryCount" << transfer->burstOffset << firstRequest << transfer->burstRetryCount;
 
     MavlinkFTP::Request request{};
-    request.hdr.session = _downloadState.sessionId;
+    request.hdr.session = transfer->sessionId;
     request.hdr.opcode  = MavlinkFTP::kCmdBurstReadFile;
-    request.hdr.offset  = _downloadState.expectedOffset;
+    request.hdr.offset  = transfer->burstOffset;
     request.hdr.size    = sizeof(request.data);
 
     if (firstRequest) {
-        _downloadState.retryCount = 0;
-    } else {
-        // Must used same sequence number as previous request
-        _expectedIncomingSeqNumber -= 2;
+        transfer->burstRetryCount = 0;
     }
 
-    _sendRequestExpectAck(&request);
+    transfer->state = StateBurstRead;
+    _sendRequest(transfer, &request, false /* expectReply */);
+    transfer->burstSeqNumber            = request.hdr.seqNumber;
+    transfer->burstExpectedSeqNumber    = request.hdr.seqNumber + 1;
+    transfer->lastActivityMs            = _clock.elapsed();
 }
 
-void FTPManager::_burstReadFileBegin(void)
+/// Bursts from the first missing block at or past the end of the last burst, skipping the blocks already there from
+/// a previous attempt. Once the bursts have been through the file the holes are filled in.
+void FTPManager::_continueBurst(Transfer_t* transfer)
 {
-    _burstReadFileWorker(true /* firstRequestr */);
+    if (transfer->sizeKnown) {
+        int block = _nextMissingBlock(transfer, transfer->burstOffset / kBlockSize, false /* skipRequested */);
+        if (block < 0) {
+            _fillMissingBlocksBegin(transfer);
+            return;
+        }
+        transfer->burstOffset = block * kBlockSize;
+    }
+
+    _burstReadFileWorker(transfer, true /* firstRequest */);
 }
 
-void FTPManager::_burstReadFileAckOrNak(const MavlinkFTP::Request* ackOrNak)
+void FTPManager::_burstReadFileAckOrNak(Transfer_t* transfer, const MavlinkFTP::Request* ackOrNak)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
-
-    if (requestOpCode != MavlinkFTP::kCmdBurstReadFile) {
-        qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Disregarding due to incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
-        return;
-    }
-    if (ackOrNak->hdr.session != _downloadState.sessionId) {
-        qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Disregarding due to incorrect session id actual:expected" << ackOrNak->hdr.session << _downloadState.sessionId;
+    // Packets of an earlier burst in the same session
+    if (static_cast<int16_t>(ackOrNak->hdr.seqNumber - transfer->burstSeqNumber) <= 0) {
+        qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Disregarding packet from previous burst actual:burst" << ackOrNak->hdr.seqNumber << transfer->burstSeqNumber;
         return;
     }
 
-    _ackOrNakTimeoutTimer.stop();
+    transfer->lastActivityMs    = _clock.elapsed();
+    transfer->burstRetryCount   = 0;
 
-    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
-        if (ackOrNak->hdr.seqNumber < _expectedIncomingSeqNumber) {
-            qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Disregarding Ack due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-            return;
-        }
+    bool packetsMissing = ackOrNak->hdr.seqNumber != transfer->burstExpectedSeqNumber;
+    transfer->burstExpectedSeqNumber = ackOrNak->hdr.seqNumber + 1;
 
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
         qCDebug(FTPManagerLog) << QString("_burstReadFileAckOrNak: Ack offset(%1) size(%2) burstComplete(%3)").arg(ackOrNak->hdr.offset).arg(ackOrNak->hdr.size).arg(ackOrNak->hdr.burstComplete);
 
-        if (ackOrNak->hdr.offset != _downloadState.expectedOffset) {
-            if (ackOrNak->hdr.offset > _downloadState.expectedOffset) {
-                // There is a hole in our data, record it as missing and continue on
-                MissingData_t missingData;
-                missingData.offset          = _downloadState.expectedOffset;
-                missingData.cBytesMissing   = ackOrNak->hdr.offset - _downloadState.expectedOffset;
-                _downloadState.rgMissingData.append(missingData);
-                qCDebug(FTPManagerLog) << "_handleBurstReadFileAck: adding missing data offset:cBytesMissing" << missingData.offset << missingData.cBytesMissing;
-            } else {
-                // Offset is past what we have already seen, disregard and wait for something usefule
-                _ackOrNakTimeoutTimer.start();
-                qCDebug(FTPManagerLog) << "_handleBurstReadFileAck: received offset less than expected offset received:expected" << ackOrNak->hdr.offset << _downloadState.expectedOffset;
-                return;
-            }
-        }
-
-        _downloadState.file.seek(ackOrNak->hdr.offset);
-        int bytesWritten = _downloadState.file.write((const char*)ackOrNak->data, ackOrNak->hdr.size);
-        if (bytesWritten != ackOrNak->hdr.size) {
-            _downloadComplete(tr("Download failed: Error saving file"));
+        // Missing packets leave holes in the block bitmap, they are filled in after the bursts
+        if (!_writeData(transfer, ackOrNak->hdr.offset, ackOrNak->data, ackOrNak->hdr.size)) {
             return;
         }
-        _downloadState.bytesWritten += ackOrNak->hdr.size;
-        _downloadState.expectedOffset = ackOrNak->hdr.offset + ackOrNak->hdr.size;
+        transfer->burstOffset = ackOrNak->hdr.offset + ackOrNak->hdr.size;
+
+        _emitProgress(transfer);
 
         if (ackOrNak->hdr.burstComplete) {
             // The current burst is done, request next one in offset sequence
-            _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber;
-            _burstReadFileWorker(true /* firstRequest */);
-        } else {
-            // Still within a burst, next ack should come automatically
-            _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber + 1;
-            _ackOrNakTimeoutTimer.start();
-        }
-
-        // Emit progress last, as cancel could be called in there
-        if (_downloadState.fileSize != 0) {
-            emit commandProgress((float)(_downloadState.bytesWritten) / (float)_downloadState.fileSize);
+            _continueBurst(transfer);
         }
     } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
         MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
 
-        if (errorCode == MavlinkFTP::kErrEOF) {
-            // Burst sequence has gone through the whole file
-            if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-                qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: EOF Nak"
-                    "with incorrect sequence nr actual:expected"
-                    << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-                /* We have received the EOF Nak but out of sequence, i.e. data is missing */
-                _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber;
-                _burstReadFileWorker(true); /* Retry from last expected offset */
-            } else {
-                qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak EOF";
-                _advanceStateMachine();
-            }
-        } else { /* Don't care is this is out of sequence */
+        if (errorCode != MavlinkFTP::kErrEOF) {
             qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
-            _downloadComplete(tr("Download failed"));
+            _transferFailed(transfer, tr("Download failed"), true /* resumable */);
+            return;
         }
+
+        if (!transfer->sizeKnown) {
+            if (packetsMissing) {
+                // The EOF Nak came out of sequence, the end of the file may be missing
+                qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak: EOF Nak with missing packets, retry from offset" << transfer->burstOffset;
+                _burstReadFileWorker(transfer, true /* firstRequest */);
+                return;
+            }
+            transfer->fileSize  = transfer->dataEnd;
+            transfer->sizeKnown = true;
+            transfer->blocks.resize(_blockCount(transfer->fileSize));
+        }
+
+        qCDebug(FTPManagerLog) << "_burstReadFileAckOrNak EOF";
+        _fillMissingBlocksBegin(transfer);
     }
 }
 
-void FTPManager::_burstReadFileTimeout(void)
+void FTPManager::_fillMissingBlocksBegin(Transfer_t* transfer)
 {
-    if (++_downloadState.retryCount > _maxRetry) {
-        qCDebug(FTPManagerLog) << QString("_burstReadFileTimeout retries exceeded");
-        _downloadComplete(tr("Download failed"));
+    transfer->state             = StateFillMissing;
+    transfer->nextBlock         = 0;
+    transfer->blocksInFlight    = 0;
+    transfer->blocksRequested.fill(false, transfer->blocks.size());
+    _fillMissingBlocksWorker(transfer);
+}
+
+/// Keeps up to kRequestWindow ReadFile requests for missing blocks in flight
+void FTPManager::_fillMissingBlocksWorker(Transfer_t* transfer)
+{
+    while (transfer->blocksInFlight < kRequestWindow) {
+        int block = _nextMissingBlock(transfer, transfer->nextBlock, true /* skipRequested */);
+        if (block < 0) {
+            break;
+        }
+        transfer->nextBlock = block + 1;
+        transfer->blocksRequested.setBit(block);
+        transfer->blocksInFlight++;
+
+        MavlinkFTP::Request request{};
+        request.hdr.session = transfer->sessionId;
+        request.hdr.opcode  = MavlinkFTP::kCmdReadFile;
+        request.hdr.offset  = block * kBlockSize;
+        request.hdr.size    = static_cast<uint8_t>(qMin<uint32_t>(kBlockSize, transfer->fileSize - request.hdr.offset));
+
+        qCDebug(FTPManagerLog) << "_fillMissingBlocksWorker: offset:size" << request.hdr.offset << request.hdr.size;
+
+        _sendRequest(transfer, &request);
+    }
+
+    if (transfer->blocksInFlight > 0) {
+        return;
+    }
+
+    if (!_allBlocksDone(transfer)) {
+        qCDebug(FTPManagerLog) << "_fillMissingBlocksWorker: no missing blocks but file still incomplete - blocksDone:blockCount" << transfer->blocksDone << transfer->blocks.size();
+        _transferFailed(transfer, tr("Download failed"), true /* resumable */);
+    } else if (transfer->resumed) {
+        _checkCrc(transfer);
     } else {
-        // Try again
-        qCDebug(FTPManagerLog) << QString("_burstReadFileTimeout: retrying - retryCount(%1) offset(%2)").arg(_downloadState.retryCount).arg(_downloadState.expectedOffset);
-        _burstReadFileWorker(false /* firstReqeust */);
+        _terminateSession(transfer);
     }
 }
 
-void FTPManager::_listDirectoryWorker(bool firstRequest)
+void FTPManager::_fillMissingBlocksAckOrNak(Transfer_t* transfer, PendingRequest_t& pending, const MavlinkFTP::Request* ackOrNak)
 {
-    qCDebug(FTPManagerLog) << "_listDirectoryWorker: offset:firstRequest:retryCount" << _listDirectoryState.expectedOffset << firstRequest << _listDirectoryState.retryCount;
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+        _transferFailed(transfer, tr("Download failed"), true /* resumable */);
+        return;
+    }
 
-    MavlinkFTP::Request request{};
-    request.hdr.session = _downloadState.sessionId;
-    request.hdr.opcode  = MavlinkFTP::kCmdListDirectory;
-    request.hdr.offset  = _listDirectoryState.expectedOffset;
-    request.hdr.size    = sizeof(request.data);
-    _fillRequestDataWithString(&request, _listDirectoryState.fullPathOnVehicle);
-    
-    if (firstRequest) {
-        _listDirectoryState.retryCount = 0;
-    } else {
-        // Must used same sequence number as previous request
-        _expectedIncomingSeqNumber -= 2;
+    qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Ack offset:size" << ackOrNak->hdr.offset << ackOrNak->hdr.size;
+
+    if (ackOrNak->hdr.offset != pending.request.hdr.offset) {
+        // Ask for the same offset again
+        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Ack offset mismatch retry, retryCount:offset" << pending.retryCount << pending.request.hdr.offset;
+        _retryRequest(transfer, pending);
+        return;
+    }
+
+    if (!_writeData(transfer, ackOrNak->hdr.offset, ackOrNak->data, ackOrNak->hdr.size)) {
+        return;
+    }
+
+    int block = pending.request.hdr.offset / kBlockSize;
+    transfer->blocksRequested.clearBit(block);
+    transfer->blocksInFlight--;
+    if (!transfer->blocks.testBit(block)) {
+        // A short read within the file
+        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: incomplete block" << block;
+        _transferFailed(transfer, tr("Download failed"), true /* resumable */);
+        return;
     }
 
-    _sendRequestExpectAck(&request);
+    _emitProgress(transfer);
+    _fillMissingBlocksWorker(transfer);
 }
 
-void FTPManager::_listDirectoryBegin(void)
+/// Keeps up to kRequestWindow WriteFile requests in flight
+void FTPManager::_writeFileWorker(Transfer_t* transfer)
 {
-    _listDirectoryWorker(true /* firstRequest */);
+    transfer->state = StateWrite;
+
+    while (transfer->blocksInFlight < kRequestWindow) {
+        int block = _nextMissingBlock(transfer, transfer->nextBlock, true /* skipRequested */);
+        if (block < 0) {
+            break;
+        }
+        transfer->nextBlock = block + 1;
+        transfer->blocksRequested.setBit(block);
+        transfer->blocksInFlight++;
+
+        MavlinkFTP::Request request{};
+        request.hdr.session = transfer->sessionId;
+        request.hdr.opcode  = MavlinkFTP::kCmdWriteFile;
+        request.hdr.offset  = block * kBlockSize;
+        request.hdr.size    = static_cast<uint8_t>(qMin<uint32_t>(kBlockSize, transfer->fileSize - request.hdr.offset));
+
+        if (!transfer->file.seek(request.hdr.offset) || transfer->file.read((char*)request.data, request.hdr.size) != request.hdr.size) {
+            qCDebug(FTPManagerLog) << "_writeFileWorker: read failed" << transfer->file.errorString();
+            _transferFailed(transfer, tr("Upload failed: Error reading file"));
+            return;
+        }
+
+        qCDebug(FTPManagerLog) << "_writeFileWorker: offset:size" << request.hdr.offset << request.hdr.size;
+
+        _sendRequest(transfer, &request);
+    }
+
+    if (transfer->blocksInFlight == 0 && _allBlocksDone(transfer)) {
+        _terminateSession(transfer);
+    }
 }
 
-void FTPManager::_listDirectoryAckOrNak(const MavlinkFTP::Request* ackOrNak)
+void FTPManager::_writeFileAckOrNak(Transfer_t* transfer, const PendingRequest_t& pending, const MavlinkFTP::Request* ackOrNak)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
-
-    if (requestOpCode != MavlinkFTP::kCmdListDirectory) {
-        qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak: Disregarding due to incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
+        qCDebug(FTPManagerLog) << "_writeFileAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
+        _transferFailed(transfer, tr("Upload failed") + ": " + _errorMsgFromNak(ackOrNak));
         return;
     }
 
-    _ackOrNakTimeoutTimer.stop();
+    int block = pending.request.hdr.offset / kBlockSize;
 
-    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
-        if (ackOrNak->hdr.seqNumber < _expectedIncomingSeqNumber) {
-            qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak: Disregarding Ack due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-            return;
-        }
+    qCDebug(FTPManagerLog) << "_writeFileAckOrNak: Ack offset" << pending.request.hdr.offset;
+
+    transfer->blocksRequested.clearBit(block);
+    transfer->blocksInFlight--;
+    if (!transfer->blocks.testBit(block)) {
+        transfer->blocks.setBit(block);
+        transfer->blocksDone++;
+    }
+    transfer->bytesTransferred += pending.request.hdr.size;
+
+    _emitProgress(transfer);
+    _writeFileWorker(transfer);
+}
+
+void FTPManager::_listDirectoryWorker(Transfer_t* transfer)
+{
+    qCDebug(FTPManagerLog) << "_listDirectoryWorker: offset" << transfer->listOffset;
 
+    MavlinkFTP::Request request{};
+    request.hdr.session = 0;
+    request.hdr.opcode  = MavlinkFTP::kCmdListDirectory;
+    request.hdr.offset  = transfer->listOffset;
+    _fillRequestDataWithString(&request, transfer->pathOnVehicle);
+
+    _sendRequest(transfer, &request);
+}
+
+void FTPManager::_listDirectoryAckOrNak(Transfer_t* transfer, const MavlinkFTP::Request* ackOrNak)
+{
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
         qCDebug(FTPManagerLog) << QString("_listDirectoryAckOrNak: Ack size(%1)").arg(ackOrNak->hdr.size);
 
-        // Parse entries in ackOrNak->data into _listDirectoryState.rgDirectoryList
+        // Parse entries in ackOrNak->data into the directory list
         const char* curDataPtr = (const char*)ackOrNak->data;
         while (curDataPtr < (const char*)ackOrNak->data + ackOrNak->hdr.size) {
             QString dirEntry = curDataPtr;
             curDataPtr += dirEntry.size() + 1;
-            _listDirectoryState.rgDirectoryList.append(dirEntry);
-            _listDirectoryState.expectedOffset++;
+            transfer->dirList.append(dirEntry);
+            transfer->listOffset++;
         }
 
         // Request next set of directory entries
-        _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber;
-        _listDirectoryWorker(true /* firstRequest */);
+        _listDirectoryWorker(transfer);
     } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
         MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
 
         if (errorCode == MavlinkFTP::kErrEOF) {
             // All entries returned
-            if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-                qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak: Disregarding Nak due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-                _ackOrNakTimeoutTimer.start();
-                return;
-            } else {
-                qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak EOF";
-                _advanceStateMachine();
-            }
-        } else { /* Don't care is this is out of sequence */
+            qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak EOF";
+            _transferComplete(transfer, QString());
+        } else {
             qCDebug(FTPManagerLog) << "_listDirectoryAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
-            _listDirectoryComplete(tr("List directory failed"));
+            _transferFailed(transfer, tr("List directory failed"));
         }
     }
 }
 
-void FTPManager::_listDirectoryTimeout(void)
+/// Closes the session of a transfer which got all its data through. Unlike ResetSessions this leaves the sessions of
+/// the other transfers open.
+void FTPManager::_terminateSession(Transfer_t* transfer)
 {
-    if (++_listDirectoryState.retryCount > _maxRetry) {
-        qCDebug(FTPManagerLog) << QString("_listDirectoryTimeout retries exceeded");
-        _listDirectoryComplete(tr("List directory failed"));
-    } else {
-        // Try again
-        qCDebug(FTPManagerLog) << QString("_listDirectoryTimeout: retrying - retryCount(%1) offset(%2)").arg(_listDirectoryState.retryCount).arg(_listDirectoryState.expectedOffset);
-        _listDirectoryWorker(false /* firstReqeust */);
-    }
-}
-
-void FTPManager::_fillMissingBlocksWorker(bool firstRequest)
-{
-    if (_downloadState.rgMissingData.count()) {
-        MavlinkFTP::Request request{};
-        MissingData_t&      missingData = _downloadState.rgMissingData.first();
-
-        uint32_t cBytesToRead = qMin((uint32_t)sizeof(request.data), missingData.cBytesMissing);
-
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksBegin: offset:cBytesToRead" << missingData.offset << cBytesToRead;
-
-        request.hdr.session                 = _downloadState.sessionId;
-        request.hdr.opcode                  = MavlinkFTP::kCmdReadFile;
-        request.hdr.offset                  = missingData.offset;
-        request.hdr.size                    = cBytesToRead;
-
-        if (firstRequest) {
-            _downloadState.retryCount = 0;
-        } else {
-            // Must used same sequence number as previous request
-            _expectedIncomingSeqNumber -= 2;
-        }
-        _downloadState.expectedOffset = request.hdr.offset;
+    transfer->state = StateTerminate;
 
-        _sendRequestExpectAck(&request);
-    } else {
-        // We should have the full file now
-        if (_downloadState.checksize == false || _downloadState.bytesWritten == _downloadState.fileSize) {
-            _advanceStateMachine();
-        } else {
-            qCDebug(FTPManagerLog) << "_fillMissingBlocksWorker: no missing blocks but file still incomplete - bytesWritten:fileSize" << _downloadState.bytesWritten << _downloadState.fileSize;
-            _downloadComplete(tr("Download failed"));
-        }
-    }
+    MavlinkFTP::Request request{};
+    request.hdr.session = transfer->sessionId;
+    request.hdr.opcode  = MavlinkFTP::kCmdTerminateSession;
+    _sendRequest(transfer, &request);
 }
 
-void FTPManager::_fillMissingBlocksBegin(void)
+/// A resumed download is only complete if the blocks kept from before belong to the same file
+void FTPManager::_checkCrc(Transfer_t* transfer)
 {
-    _fillMissingBlocksWorker(true /* firstRequest */);
+    transfer->state = StateCheckCrc;
+
+    MavlinkFTP::Request request{};
+    request.hdr.opcode = MavlinkFTP::kCmdCalcFileCRC32;
+    _fillRequestDataWithString(&request, transfer->pathOnVehicle);
+    _sendRequest(transfer, &request);
 }
 
-void FTPManager::_fillMissingBlocksAckOrNak(const MavlinkFTP::Request* ackOrNak)
+void FTPManager::_checkCrcAckOrNak(Transfer_t* transfer, const MavlinkFTP::Request* ackOrNak)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
+    transfer->resumed = false;
 
-    if (requestOpCode != MavlinkFTP::kCmdReadFile) {
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Disregarding due to incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
+    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak || ackOrNak->hdr.size != sizeof(uint32_t)) {
+        // Not supported by the vehicle, the file size is all that can be checked
+        qCDebug(FTPManagerLog) << "_checkCrcAckOrNak: no crc from vehicle";
+        _terminateSession(transfer);
         return;
     }
-    if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Disregarding due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
+
+    uint32_t vehicleCrc = ackOrNak->openFileLength;
+    uint32_t localCrc   = _crc32(transfer->file);
+    if (vehicleCrc == localCrc) {
+        qCDebug(FTPManagerLog) << "_checkCrcAckOrNak: crc match" << Qt::hex << localCrc;
+        _terminateSession(transfer);
         return;
     }
-    if (ackOrNak->hdr.session != _downloadState.sessionId) {
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Disregarding due to incorrect session id actual:expected" << ackOrNak->hdr.session << _downloadState.sessionId;
-        return;
+
+    // The file changed on the vehicle since the blocks were saved, start over
+    qCDebug(FTPManagerLog) << "_checkCrcAckOrNak: crc mismatch, downloading again - vehicle:local" << Qt::hex << vehicleCrc << localCrc;
+    _removeResumeFile(transfer);
+    transfer->blocks.fill(false);
+    transfer->blocksDone    = 0;
+    transfer->burstOffset   = 0;
+    _continueBurst(transfer);
+}
+
+/// Writes received data to the file and marks the blocks it completes. Packets are aligned to blocks unless the
+/// vehicle sends short reads, which only happens at the end of the file.
+///     @return false: write failed, the transfer failed
+bool FTPManager::_writeData(Transfer_t* transfer, uint32_t offset, const uint8_t* data, uint8_t size)
+{
+    uint32_t end = offset + size;
+    if (transfer->sizeKnown && end > transfer->fileSize) {
+        // Past the size reported on open
+        if (offset >= transfer->fileSize) {
+            return true;
+        }
+        end     = transfer->fileSize;
+        size    = static_cast<uint8_t>(end - offset);
     }
 
-    _ackOrNakTimeoutTimer.stop();
+    if (!transfer->file.seek(offset) || transfer->file.write((const char*)data, size) != size) {
+        qCDebug(FTPManagerLog) << "_writeData: write failed" << transfer->file.errorString();
+        _transferFailed(transfer, tr("Download failed: Error saving file"));
+        return false;
+    }
+    transfer->bytesTransferred += size;
+    transfer->dataEnd = qMax(transfer->dataEnd, end);
 
-    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Ack offset:size" << ackOrNak->hdr.offset << ackOrNak->hdr.size;
+    if (!transfer->sizeKnown && transfer->blocks.size() < _blockCount(transfer->dataEnd)) {
+        transfer->blocks.resize(_blockCount(transfer->dataEnd));
+    }
 
-        if (ackOrNak->hdr.offset != _downloadState.expectedOffset) {
-            if (++_downloadState.retryCount > _maxRetry) {
-                qCDebug(FTPManagerLog) << QString("_fillMissingBlocksAckOrNak: offset mismatch, retries exceeded");
-                _downloadComplete(tr("Download failed"));
-                return;
+    if (offset % kBlockSize == 0) {
+        int block = offset / kBlockSize;
+        bool blockComplete = size == kBlockSize || !transfer->sizeKnown || end == transfer->fileSize;
+        if (blockComplete && block < transfer->blocks.size() && !transfer->blocks.testBit(block)) {
+            transfer->blocks.setBit(block);
+            transfer->blocksDone++;
+            if (transfer->checksize && ++transfer->blocksSinceSave >= kResumeSaveBlocks) {
+                transfer->blocksSinceSave = 0;
+                _saveResumeFile(transfer);
             }
-
-            // Ask for current offset again
-            qCDebug(FTPManagerLog) << QString("_fillMissingBlocksAckOrNak: Ack offset mismatch retry, retryCount(%1) offset(%2)").arg(_downloadState.retryCount).arg(_downloadState.expectedOffset);
-            _fillMissingBlocksWorker(false /* firstReqeust */);
-            return;
         }
+    }
 
-        _downloadState.file.seek(ackOrNak->hdr.offset);
-        int bytesWritten = _downloadState.file.write((const char*)ackOrNak->data, ackOrNak->hdr.size);
-        if (bytesWritten != ackOrNak->hdr.size) {
-            _downloadComplete(tr("Download failed: Error saving file"));
-            return;
-        }
-        _downloadState.bytesWritten += ackOrNak->hdr.size;
+    return true;
+}
 
-        MissingData_t& missingData = _downloadState.rgMissingData.first();
-        missingData.offset += ackOrNak->hdr.size;
-        missingData.cBytesMissing -= ackOrNak->hdr.size;
-        if (missingData.cBytesMissing == 0) {
-            // This block is finished, remove it
-            _downloadState.rgMissingData.takeFirst();
+int FTPManager::_nextMissingBlock(Transfer_t* transfer, int fromBlock, bool skipRequested) const
+{
+    for (int block = fromBlock; block < transfer->blocks.size(); block++) {
+        if (!transfer->blocks.testBit(block) && !(skipRequested && transfer->blocksRequested.testBit(block))) {
+            return block;
         }
+    }
+    return -1;
+}
 
-        // Move on to fill in possible next hole
-        _fillMissingBlocksWorker(true /* firstReqeust */);
+bool FTPManager::_allBlocksDone(Transfer_t* transfer) const
+{
+    return transfer->sizeKnown && transfer->blocksDone == transfer->blocks.size();
+}
 
-        // Emit progress last, as cancel could be called in there
-        if (_downloadState.fileSize != 0) {
-            emit commandProgress((float)(_downloadState.bytesWritten) / (float)_downloadState.fileSize);
-        }
-    } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
-        MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
+void FTPManager::_emitProgress(Transfer_t* transfer)
+{
+    float progress = 0;
+    if (transfer->checksize && transfer->blocks.size() > 0) {
+        progress = static_cast<float>(transfer->blocksDone) / static_cast<float>(transfer->blocks.size());
+    } else if (transfer->reportedSize != 0) {
+        // The reported size may be wrong without checksize
+        progress = qMin(1.0f, static_cast<float>(transfer->bytesTransferred) / static_cast<float>(transfer->reportedSize));
+    }
 
-        if (errorCode == MavlinkFTP::kErrEOF) {
-            qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak EOF";
-            if (_downloadState.checksize == false || _downloadState.bytesWritten == _downloadState.fileSize) {
-                // We've successfully complete filling in all missing blocks
-                _advanceStateMachine();
-                return;
-            }
-        }
+    qint64 elapsedMs        = transfer->elapsed.elapsed();
+    double bytesPerSecond   = elapsedMs > 0 ? (transfer->bytesTransferred * 1000.0) / elapsedMs : 0;
 
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
-        _downloadComplete(tr("Download failed"));
+    emit transferProgress(transfer->id, progress, transfer->bytesTransferred, bytesPerSecond);
+    if (transfer->legacy && (transfer->checksize ? transfer->fileSize : transfer->reportedSize) != 0) {
+        emit commandProgress(progress);
     }
 }
 
-void FTPManager::_fillMissingBlocksTimeout(void)
+/// Fails a transfer, closing its session on the vehicle without waiting for the ack
+///     @param resumable true: a download keeps the data received so far for the next attempt
+void FTPManager::_transferFailed(Transfer_t* transfer, const QString& errorMsg, bool resumable)
 {
-    if (++_downloadState.retryCount > _maxRetry) {
-        qCDebug(FTPManagerLog) << QString("_fillMissingBlocksTimeout retries exceeded");
-        _downloadComplete(tr("Download failed"));
-    } else {
-        // Ask for current offset again
-        qCDebug(FTPManagerLog) << QString("_fillMissingBlocksTimeout: retrying - retryCount(%1) offset(%2)").arg(_downloadState.retryCount).arg(_downloadState.expectedOffset);
-        _fillMissingBlocksWorker(false /* firstReqeust */);
+    qCDebug(FTPManagerLog) << "_transferFailed: id:errorMsg:resumable" << transfer->id << errorMsg << resumable;
+
+    _dropPendingRequests(transfer->id);
+
+    if (transfer->type == TransferDownload) {
+        bool keep = resumable && transfer->checksize && transfer->sizeKnown && transfer->blocksDone > 0 && _saveResumeFile(transfer);
+        if (transfer->file.isOpen()) {
+            transfer->file.close();
+            if (!keep) {
+                transfer->file.remove();
+                _removeResumeFile(transfer);
+            }
+        } else if (!resumable && QFile::exists(transfer->localPath + resumeFileSuffix)) {
+            // The partial file of an earlier attempt is of no use anymore
+            QFile::remove(transfer->localPath);
+            _removeResumeFile(transfer);
+        }
     }
-}
 
-void FTPManager::_resetSessionsBegin(void)
-{
-    MavlinkFTP::Request request{};
-    request.hdr.opcode  = MavlinkFTP::kCmdResetSessions;
-    request.hdr.size    = 0;
-    _sendRequestExpectAck(&request);
+    if (transfer->sessionOpen) {
+        MavlinkFTP::Request request{};
+        request.hdr.session = transfer->sessionId;
+        request.hdr.opcode  = MavlinkFTP::kCmdTerminateSession;
+        _sendRequest(transfer, &request, false /* expectReply */);
+        transfer->sessionOpen = false;
+    }
+
+    _transferComplete(transfer, errorMsg);
 }
 
-void FTPManager::_resetSessionsAckOrNak(const MavlinkFTP::Request* ackOrNak)
+/// Removes the transfer, signals its completion and starts the next ones in the queue
+///     @param errorMsg Error message, empty if no error
+void FTPManager::_transferComplete(Transfer_t* transfer, const QString& errorMsg)
 {
-    MavlinkFTP::OpCode_t requestOpCode = static_cast<MavlinkFTP::OpCode_t>(ackOrNak->hdr.req_opcode);
+    qCDebug(FTPManagerLog) << QString("_transferComplete: id(%1) errorMsg(%2) bytesTransferred(%3) msecs(%4)").arg(transfer->id).arg(errorMsg).arg(transfer->bytesTransferred).arg(transfer->elapsed.elapsed());
 
-    if (requestOpCode != MavlinkFTP::kCmdResetSessions) {
-        qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak: Disregarding due to incorrect requestOpCode" << MavlinkFTP::opCodeToString(requestOpCode);
-        return;
+    _dropPendingRequests(transfer->id);
+    _transfers.removeOne(transfer);
+
+    if (transfer->file.isOpen()) {
+        transfer->file.close();
     }
-    if (ackOrNak->hdr.seqNumber != _expectedIncomingSeqNumber) {
-        qCDebug(FTPManagerLog) << "_resetSessionsAckOrNak: Disregarding due to incorrect sequence actual:expected" << ackOrNak->hdr.seqNumber << _expectedIncomingSeqNumber;
-        return;
+    if (errorMsg.isEmpty() && transfer->type == TransferDownload) {
+        _removeResumeFile(transfer);
     }
 
-    _ackOrNakTimeoutTimer.stop();
-
-    if (ackOrNak->hdr.opcode == MavlinkFTP::kRspAck) {
-        qCDebug(FTPManagerLog) << "_resetSessionsAckOrNak: Ack";
-        _advanceStateMachine();
-    } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
-        qCDebug(FTPManagerLog) << "_resetSessionsAckOrNak: Nak -" << _errorMsgFromNak(ackOrNak);
-        _downloadComplete(QString());
+    int             transferId  = transfer->id;
+    TransferType_t  type        = transfer->type;
+    bool            legacy      = transfer->legacy;
+    QString         localPath   = transfer->localPath;
+    QStringList     dirList     = errorMsg.isEmpty() ? transfer->dirList : QStringList();
+    delete transfer;
+
+    emit transferComplete(transferId, localPath, errorMsg);
+    if (legacy) {
+        if (type == TransferList) {
+            emit listDirectoryComplete(dirList, errorMsg);
+        } else {
+            emit downloadComplete(localPath, errorMsg);
+        }
     }
+
+    _startQueuedTransfers();
 }
 
-void FTPManager::_resetSessionsTimeout(void)
+void FTPManager::_sendRequest(Transfer_t* transfer, MavlinkFTP::Request* request, bool expectReply)
 {
-    qCDebug(FTPManagerLog) << "_resetSessionsTimeout";
-    _downloadComplete(QString());
+    Server_t& server = _servers[transfer->compId];
+
+    request->hdr.seqNumber  = server.nextSeqNumber;    // The reply is numbered one past the request
+    server.nextSeqNumber    += 2;
+
+    if (expectReply) {
+        PendingRequest_t pending;
+        pending.transferId  = transfer->id;
+        pending.request     = *request;
+        pending.sentMs      = _clock.elapsed();
+        pending.retryCount  = 0;
+        _pendingRequests.insert(_pendingKey(transfer->compId, request->hdr.seqNumber), pending);
+    }
+
+    _sendMessage(transfer->compId, request);
 }
 
-void FTPManager::_sendRequestExpectAck(MavlinkFTP::Request* request)
+void FTPManager::_sendMessage(uint8_t compId, const MavlinkFTP::Request* request)
 {
-    _ackOrNakTimeoutTimer.start();
-    
     SharedLinkInterfacePtr sharedLink = _vehicle->vehicleLinkManager()->primaryLink().lock();
     if (sharedLink) {
-        request->hdr.seqNumber = _expectedIncomingSeqNumber + 1;    // Outgoing is 1 past last incoming
-        _expectedIncomingSeqNumber += 2;
-
-        qCDebug(FTPManagerLog) << "_sendRequestExpectAck opcode:" << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.opcode)) << "seqNumber:" << request->hdr.seqNumber;
+        qCDebug(FTPManagerLog) << "_sendMessage opcode:" << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(request->hdr.opcode)) << "seqNumber:" << request->hdr.seqNumber << "compId:" << compId;
 
         mavlink_message_t message;
         mavlink_msg_file_transfer_protocol_pack_chan(MAVLinkProtocol::instance()->getSystemId(),
@@ -744,12 +1099,96 @@ void FTPManager::_sendRequestExpectAck(MavlinkFTP::Request* request)
                                                      &message,
                                                      0,                                                     // Target network, 0=broadcast?
                                                      _vehicle->id(),
-                                                     _ftpCompId,
-                                                     (uint8_t*)request);                                    // Payload
+                                                     compId,
+                                                     (const uint8_t*)request);                              // Payload
         _vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), message);
     } else {
-        qCDebug(FTPManagerLog) << "_sendRequestExpectAck No primary link. Allowing timeout to fail sequence.";
+        qCDebug(FTPManagerLog) << "_sendMessage No primary link. Allowing timeout to fail sequence.";
+    }
+}
+
+/// Loads the blocks received by an earlier attempt of the same download. The resume file is only used if it was
+/// written for the same file on the same component and the partial file is still there.
+bool FTPManager::_loadResumeFile(Transfer_t* transfer)
+{
+    QFile resumeFile(transfer->localPath + resumeFileSuffix);
+    if (!resumeFile.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&resumeFile);
+    quint32     magic;
+    quint16     version;
+    QString     pathOnVehicle;
+    quint8      compId;
+    quint32     fileSize;
+    qint32      blockSize;
+    QBitArray   blocks;
+    stream >> magic >> version >> pathOnVehicle >> compId >> fileSize >> blockSize >> blocks;
+    resumeFile.close();
+
+    if (stream.status() != QDataStream::Ok || magic != kResumeMagic || version != kResumeVersion ||
+            pathOnVehicle != transfer->pathOnVehicle || compId != transfer->compId || fileSize != transfer->fileSize ||
+            blockSize != kBlockSize || blocks.size() != transfer->blocks.size() ||
+            QFileInfo(transfer->localPath).size() != static_cast<qint64>(fileSize)) {
+        qCDebug(FTPManagerLog) << "_loadResumeFile: resume file does not match download" << resumeFile.fileName();
+        _removeResumeFile(transfer);
+        return false;
     }
+
+    transfer->blocks        = blocks;
+    transfer->blocksDone    = blocks.count(true);
+
+    return true;
+}
+
+bool FTPManager::_saveResumeFile(Transfer_t* transfer)
+{
+    // The bitmap must not claim blocks which are not on disk yet
+    if (!transfer->file.flush()) {
+        return false;
+    }
+
+    QSaveFile resumeFile(transfer->localPath + resumeFileSuffix);
+    if (!resumeFile.open(QFile::WriteOnly)) {
+        qCDebug(FTPManagerLog) << "_saveResumeFile: open failed" << resumeFile.errorString();
+        return false;
+    }
+
+    QDataStream stream(&resumeFile);
+    stream << kResumeMagic << kResumeVersion << transfer->pathOnVehicle << static_cast<quint8>(transfer->compId)
+           << transfer->fileSize << static_cast<qint32>(kBlockSize) << transfer->blocks;
+
+    return stream.status() == QDataStream::Ok && resumeFile.commit();
+}
+
+void FTPManager::_removeResumeFile(Transfer_t* transfer)
+{
+    QFile::remove(transfer->localPath + resumeFileSuffix);
+}
+
+int FTPManager::_blockCount(uint32_t fileSize)
+{
+    return static_cast<int>((static_cast<qint64>(fileSize) + kBlockSize - 1) / kBlockSize);
+}
+
+quint32 FTPManager::_crc32(QFile& file)
+{
+    quint32 crc = 0;
+
+    file.flush();
+    if (!file.seek(0)) {
+        return crc;
+    }
+    while (!file.atEnd()) {
+        QByteArray bytes = file.read(64 * 1024);
+        if (bytes.isEmpty()) {
+            break;
+        }
+        crc = MavlinkFTP::crc32((const uint8_t*)bytes.constData(), bytes.size(), crc);
+    }
+
+    return crc;
 }
 
 bool FTPManager::_parseURI(uint8_t fromCompId, const QString& uri, QString& parsedURI, uint8_t& compId)
@@ -784,20 +1223,3 @@ bool FTPManager::_parseURI(uint8_t fromCompId, const QString& uri, QString& pars
 
     return true;
 }
-
-bool FTPManager::_isListDirectoryStateMachine(void)
-{
-    if (_rgStateMachine.isEmpty()) {
-        qCWarning(FTPManagerLog) << "INTERNAL ERROR: _isListDirectoryStateMachine called with empty state machine";
-        return false;
-    }
-
-    if (_rgStateMachine[0].beginFn == &FTPManager::_listDirectoryBegin) {
-        return true;
-    } else if (_rgStateMachine[0].beginFn == &FTPManager::_openFileROBegin) {
-        return false;
-    } else {
-        qCWarning(FTPManagerLog) << "INTERNAL ERROR: _isListDirectoryStateMachine called with invalid state machine";
-        return false;
-    }
-}
@@ -12,7 +12,11 @@
 #include "MAVLinkFTP.h"
 
 #include <QtCore/QObject>
-#include <QtCore/QDir>
+#include <QtCore/QBitArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QMap>
 #include <QtCore/QTimer>
 #include <QtCore/QLoggingCategory>
 
@@ -20,14 +24,20 @@ Q_DECLARE_LOGGING_CATEGORY(FTPManagerLog)
 
 class Vehicle;
 
+/// MAVLink FTP client. Transfers are queued and run concurrently, each in its own session on the component, up to the
+/// number of sessions the component allows. Downloads are written to files preallocated to the size reported by the
+/// vehicle. The blocks received are kept in a bitmap which is saved next to the file when a download fails, so
+/// downloading the same file again resumes where it stopped. A resumed download is checked against the CRC32 of the
+/// file on the vehicle. Uploads keep a window of WriteFile requests in flight.
 class FTPManager : public QObject
 {
     Q_OBJECT
 
     friend class Vehicle;
-    
+
 public:
     FTPManager(Vehicle* vehicle);
+    ~FTPManager();
 
 	/// Downloads the specified file.
     ///     @param fromCompId Component id of the component to download from. If fromCompId is MAV_COMP_ID_ALL, then MAV_COMP_ID_AUTOPILOT1 is used.
@@ -56,7 +66,32 @@ public:
     /// This will emit downloadComplete() when done, and if there's currently a download in progress
     void cancelDownload();
 
+    /// Queues a download which runs alongside the other transfers. Parameters are the same as for download().
+    /// @return Id of the transfer, -1: error
+    /// Signals transferProgress, transferComplete
+    int queueDownload(uint8_t fromCompId, const QString& fromURI, const QString& toDir, const QString& fileName = QString(), bool checksize = true);
+
+    /// Queues an upload of a local file, an existing file on the vehicle is replaced
+    ///     @param toCompId Component id of the component to upload to. If toCompId is MAV_COMP_ID_ALL, then MAV_COMP_ID_AUTOPILOT1 is used.
+    ///     @param fromFile Local file to upload
+    ///     @param toURI    Fully qualified path of the file on the component, in the same format as for download()
+    /// @return Id of the transfer, -1: error
+    /// Signals transferProgress, transferComplete
+    int queueUpload(uint8_t toCompId, const QString& fromFile, const QString& toURI);
+
+    /// Cancels a queued or running transfer. Signals transferComplete with an error.
+    void cancelTransfer(int transferId);
+
+    /// @return Number of transfers running or waiting in the queue
+    int transferCount(void) const { return _transfers.count(); }
+
+    /// Sets the maximum number of sessions used at the same time on one component. Fewer are used if the component
+    /// runs out of sessions.
+    void setMaxSessions(int maxSessions) { _maxSessions = qMax(1, maxSessions); }
+
     static constexpr const char* mavlinkFTPScheme = "mftp";
+    /// Suffix of the file next to a partial download which holds what was received so far
+    static constexpr const char* resumeFileSuffix = ".ftpresume";
 
 signals:
     void downloadComplete       (const QString& file, const QString& errorMsg);
@@ -65,118 +100,150 @@ signals:
     /// Signalled during a lengthy command to show progress
     ///     @param value Amount of progress: 0.0 = none, 1.0 = complete
     void commandProgress(float value);
-	
+
+    /// Signalled whenever data of a queued transfer is received or acknowledged
+    ///     @param progress         0.0 = none, 1.0 = complete
+    ///     @param bytesTransferred Bytes transferred over the link by this transfer, not counting resumed data
+    ///     @param bytesPerSecond   Average throughput since the transfer started
+    void transferProgress(int transferId, float progress, qint64 bytesTransferred, double bytesPerSecond);
+
+    /// Signalled when a queued transfer is done
+    ///     @param file     Local file downloaded to or uploaded from
+    ///     @param errorMsg Error message, empty if no error
+    void transferComplete(int transferId, const QString& file, const QString& errorMsg);
+
 private slots:
     void _ackOrNakTimeout(void);
 
 private:
-    typedef void (FTPManager::*StateBeginFn)    (void);
-    typedef void (FTPManager::*StateAckNakFn)   (const MavlinkFTP::Request* ackOrNak);
-    typedef void (FTPManager::*StateTimeoutFn)  (void);
-
-    struct StateFunctions_t {
-        StateBeginFn    beginFn;
-        StateAckNakFn   ackNakFn;
-        StateTimeoutFn  timeoutFn;
-    };
-
-    struct MissingData_t {
-        uint32_t offset;
-        uint32_t cBytesMissing;
+    typedef enum {
+        TransferDownload,
+        TransferUpload,
+        TransferList,
+    } TransferType_t;
+
+    typedef enum {
+        StateQueued,
+        StateOpen,          ///< OpenFileRO or CreateFile sent
+        StateBurstRead,     ///< Burst reads from the first missing block
+        StateFillMissing,   ///< ReadFile requests for the blocks missed by the bursts
+        StateWrite,         ///< WriteFile requests
+        StateList,          ///< ListDirectory requests
+        StateTerminate,     ///< TerminateSession sent
+        StateCheckCrc,      ///< CalcFileCRC32 sent for a resumed download
+    } TransferState_t;
+
+    struct Transfer_t {
+        int             id;
+        TransferType_t  type;
+        TransferState_t state           = StateQueued;
+        bool            legacy          = false;    ///< Started by download() or listDirectory(), signals through their signals
+        uint8_t         compId          = MAV_COMP_ID_AUTOPILOT1;
+        QString         pathOnVehicle;
+        QString         localPath;
+        bool            checksize       = true;
+        uint8_t         sessionId       = 0;
+        bool            sessionOpen     = false;
+        uint32_t        fileSize        = 0;        ///< Size of the file, downloads without checksize only know it at EOF
+        uint32_t        reportedSize    = 0;        ///< Size from the open response
+        bool            sizeKnown       = false;
+        QFile           file;
+        QBitArray       blocks;                     ///< Blocks received or acknowledged
+        int             blocksDone      = 0;
+        QBitArray       blocksRequested;            ///< Blocks with a ReadFile or WriteFile request in flight
+        int             blocksInFlight  = 0;
+        int             nextBlock       = 0;        ///< Where the search for the next block to request continues
+        uint32_t        dataEnd         = 0;        ///< End of the data received so far
+        uint32_t        burstOffset     = 0;        ///< Offset the current burst continues at
+        uint16_t        burstSeqNumber  = 0;        ///< Sequence number of the current burst request
+        uint16_t        burstExpectedSeqNumber = 0; ///< Sequence number of the next burst packet
+        int             burstRetryCount = 0;
+        qint64          lastActivityMs  = 0;        ///< Last burst packet received
+        bool            resumed         = false;    ///< Blocks were loaded from the resume file
+        int             blocksSinceSave = 0;
+        uint32_t        listOffset      = 0;
+        QStringList     dirList;
+        QString         errorMsg;
+        QElapsedTimer   elapsed;
+        qint64          bytesTransferred = 0;
     };
 
-    struct DownloadState_t {
-        uint8_t                 sessionId;
-        uint32_t                expectedOffset;         ///< offset which should be coming next
-        uint32_t                bytesWritten;
-        QList<MissingData_t>    rgMissingData;
-        QString                 fullPathOnVehicle;      ///< Fully qualified path to file on vehicle
-        QDir                    toDir;                  ///< Directory to download file to
-        QString                 fileName;               ///< Filename (no path) for download file
-        uint32_t                fileSize;               ///< Size of file being downloaded
-        QFile                   file;
-        int                     retryCount;
-        bool                    checksize;
-
-        bool inProgress() const { return fileSize > 0; }
-
-        void reset() {
-            sessionId       = 0;
-            expectedOffset  = 0;
-            bytesWritten    = 0;
-            retryCount      = 0;
-            fileSize        = 0;
-            fullPathOnVehicle.clear();
-            fileName.clear();
-            rgMissingData.clear();
-            file.close();
-        }
+    struct PendingRequest_t {
+        int                 transferId;
+        MavlinkFTP::Request request;
+        qint64              sentMs;
+        int                 retryCount;
     };
 
-    struct ListDirectoryState_t {
-        uint8_t     sessionId;
-        uint32_t    expectedOffset;         ///< offset which should be coming next
-        QString     fullPathOnVehicle;      ///< Fully qualified path to file on vehicle
-        QStringList rgDirectoryList;
-        int         retryCount;
-
-        bool inProgress() const { return rgDirectoryList.count() > 0; }
-
-        void reset() {
-            sessionId       = 0;
-            expectedOffset  = 0;
-            fullPathOnVehicle.clear();
-            rgDirectoryList.clear();
-            retryCount      = 0;
-        }
+    struct Server_t {
+        uint16_t    nextSeqNumber   = 0;
+        int         maxSessions     = 0;    ///< Sessions the component allows, 0: not known yet
     };
 
+    Transfer_t* _newTransfer            (TransferType_t type, uint8_t compId, const QString& uri);
+    Transfer_t* _newDownload            (uint8_t fromCompId, const QString& fromURI, const QString& toDir, const QString& fileName, bool checksize);
+    Transfer_t* _transfer               (int transferId);
+    Transfer_t* _legacyTransfer         (TransferType_t type);
+    Transfer_t* _burstTransfer          (uint8_t compId, uint8_t sessionId);
+    void    _queueTransfer              (Transfer_t* transfer);
+    void    _startQueuedTransfers       (void);
+    void    _startTransfer              (Transfer_t* transfer);
+    int     _activeSessions             (uint8_t compId);
     void    _mavlinkMessageReceived     (const mavlink_message_t& message);
-    void    _startStateMachine          (void);
-    void    _advanceStateMachine        (void);
-    void    _listDirectoryBegin         (void);
-    void    _listDirectoryAckOrNak      (const MavlinkFTP::Request* ackOrNak);
-    void    _listDirectoryTimeout       (void);
-    void    _openFileROBegin            (void);
-    void    _openFileROAckOrNak         (const MavlinkFTP::Request* ackOrNak);
-    void    _openFileROTimeout          (void);
-    void    _burstReadFileBegin         (void);
-    void    _burstReadFileAckOrNak      (const MavlinkFTP::Request* ackOrNak);
-    void    _burstReadFileTimeout       (void);
-    void    _fillMissingBlocksBegin     (void);
-    void    _fillMissingBlocksAckOrNak  (const MavlinkFTP::Request* ackOrNak);
-    void    _fillMissingBlocksTimeout   (void);
-    void    _resetSessionsBegin         (void);
-    void    _resetSessionsAckOrNak      (const MavlinkFTP::Request* ackOrNak);
-    void    _resetSessionsTimeout       (void);
+    void    _openAckOrNak               (Transfer_t* transfer, const MavlinkFTP::Request* ackOrNak);
+    void    _burstReadFileWorker        (Transfer_t* transfer, bool firstRequest);
+    void    _burstReadFileAckOrNak      (Transfer_t* transfer, const MavlinkFTP::Request* ackOrNak);
+    void    _continueBurst              (Transfer_t* transfer);
+    void    _fillMissingBlocksBegin     (Transfer_t* transfer);
+    void    _fillMissingBlocksWorker    (Transfer_t* transfer);
+    void    _fillMissingBlocksAckOrNak  (Transfer_t* transfer, PendingRequest_t& pending, const MavlinkFTP::Request* ackOrNak);
+    void    _writeFileWorker            (Transfer_t* transfer);
+    void    _writeFileAckOrNak          (Transfer_t* transfer, const PendingRequest_t& pending, const MavlinkFTP::Request* ackOrNak);
+    void    _listDirectoryWorker        (Transfer_t* transfer);
+    void    _listDirectoryAckOrNak      (Transfer_t* transfer, const MavlinkFTP::Request* ackOrNak);
+    void    _terminateSession           (Transfer_t* transfer);
+    void    _checkCrc                   (Transfer_t* transfer);
+    void    _checkCrcAckOrNak           (Transfer_t* transfer, const MavlinkFTP::Request* ackOrNak);
+    bool    _writeData                  (Transfer_t* transfer, uint32_t offset, const uint8_t* data, uint8_t size);
+    int     _nextMissingBlock           (Transfer_t* transfer, int fromBlock, bool skipRequested) const;
+    bool    _allBlocksDone              (Transfer_t* transfer) const;
+    void    _emitProgress               (Transfer_t* transfer);
+    QString _failedMessage              (Transfer_t* transfer) const;
+    void    _transferFailed             (Transfer_t* transfer, const QString& errorMsg, bool resumable = false);
+    void    _transferComplete           (Transfer_t* transfer, const QString& errorMsg);
+    void    _requestTimeout             (Transfer_t* transfer, PendingRequest_t& pending);
+    bool    _retryRequest               (Transfer_t* transfer, PendingRequest_t& pending);
+    void    _dropPendingRequests        (int transferId);
+    void    _sendRequest                (Transfer_t* transfer, MavlinkFTP::Request* request, bool expectReply = true);
+    void    _sendMessage                (uint8_t compId, const MavlinkFTP::Request* request);
+    bool    _loadResumeFile             (Transfer_t* transfer);
+    bool    _saveResumeFile             (Transfer_t* transfer);
+    void    _removeResumeFile           (Transfer_t* transfer);
     QString _errorMsgFromNak            (const MavlinkFTP::Request* nak);
-    void    _sendRequestExpectAck       (MavlinkFTP::Request* request);
-    void    _downloadCompleteNoError    (void) { _downloadComplete(QString()); }
-    void    _downloadComplete           (const QString& errorMsg);
-    void    _fillRequestDataWithString(MavlinkFTP::Request* request, const QString& str);
-    void    _fillMissingBlocksWorker    (bool firstRequest);
-    void    _burstReadFileWorker        (bool firstRequest);
-    void    _listDirectoryWorker        (bool firstRequest);
+    void    _fillRequestDataWithString  (MavlinkFTP::Request* request, const QString& str);
     bool    _parseURI                   (uint8_t fromCompId, const QString& uri, QString& parsedURI, uint8_t& compId);
-    bool    _isListDirectoryStateMachine(void);
-    void    _listDirectoryCompleteNoError(void) { _listDirectoryComplete(QString()); }
-    void    _listDirectoryComplete      (const QString& errorMsg);
-
-    void    _terminateSessionBegin      (void);
-    void    _terminateSessionAckOrNak   (const MavlinkFTP::Request* ackOrNak);
-    void    _terminateSessionTimeout    (void);
-    void    _terminateComplete          (void);
-
-    Vehicle*                _vehicle;
-    uint8_t                 _ftpCompId = MAV_COMP_ID_AUTOPILOT1;
-    QList<StateFunctions_t> _rgStateMachine;
-    DownloadState_t         _downloadState;
-    ListDirectoryState_t    _listDirectoryState;
-    QTimer                  _ackOrNakTimeoutTimer;
-    int                     _currentStateMachineIndex   = -1;
-    uint16_t                _expectedIncomingSeqNumber  = 0;
-    
-    static const int _ackOrNakTimeoutMsecs  = 1000;
+
+    static int      _blockCount         (uint32_t fileSize);
+    static quint32  _crc32              (QFile& file);
+    static quint32  _pendingKey         (uint8_t compId, uint16_t seqNumber) { return (static_cast<quint32>(compId) << 16) | seqNumber; }
+
+    Vehicle*                            _vehicle;
+    QList<Transfer_t*>                  _transfers;         ///< In queue order
+    QMap<quint32, PendingRequest_t>     _pendingRequests;   ///< By component and sequence number of the request
+    QMap<uint8_t, Server_t>             _servers;           ///< By component id
+    QTimer                              _ackOrNakTimeoutTimer;
+    QElapsedTimer                       _clock;
+    int                                 _ackOrNakTimeoutMsecs;
+    int                                 _maxSessions        = kDefaultMaxSessions;
+    int                                 _nextTransferId     = 1;
+
+    static const int _ackOrNakTimeoutMsecsDefault = 1000;
     static const int _maxRetry              = 3;
-};
 
+    static constexpr int        kBlockSize          = sizeof(((MavlinkFTP::Request*)0)->data);
+    static constexpr int        kDefaultMaxSessions = 2;
+    static constexpr int        kRequestWindow      = 4;    ///< ReadFile or WriteFile requests in flight per transfer
+    static constexpr int        kResumeSaveBlocks   = 256;  ///< Blocks received between saves of the resume file while downloading
+    static constexpr quint32    kResumeMagic        = 0x51474652;   ///< "QGFR"
+    static constexpr quint16    kResumeVersion      = 1;
+};
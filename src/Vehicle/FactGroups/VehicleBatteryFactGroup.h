@@ -52,6 +52,7 @@ public:
 
     // Overrides from FactGroup
     void handleMessage(Vehicle* vehicle, mavlink_message_t& message) override;
+    QList<uint32_t> handledMessageIds() const override;
 
 private slots:
     void _timeRemainingChanged(QVariant value);
@@ -39,6 +39,11 @@ VehicleDistanceSensorFactGroup::VehicleDistanceSensorFactGroup(QObject* parent)
     _addFact(&_maxDistanceFact,         _maxDistanceFactName);
 }
 
+QList<uint32_t> VehicleDistanceSensorFactGroup::handledMessageIds() const
+{
+    return { MAVLINK_MSG_ID_DISTANCE_SENSOR };
+}
+
 void VehicleDistanceSensorFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_message_t& message)
 {
     if (message.msgid != MAVLINK_MSG_ID_DISTANCE_SENSOR) {
@@ -49,6 +49,7 @@ public:
 
     // Overrides from FactGroup
     void handleMessage(Vehicle* vehicle, mavlink_message_t& message) override;
+    QList<uint32_t> handledMessageIds() const override;
 
 private:
     const QString _rotationNoneFactName =     QStringLiteral("rotationNone");
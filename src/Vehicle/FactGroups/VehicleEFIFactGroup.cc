@@ -69,6 +69,11 @@ VehicleEFIFactGroup::VehicleEFIFactGroup(QObject* parent)
     _ptCompFact.setRawValue(qQNaN());
 }
 
+QList<uint32_t> VehicleEFIFactGroup::handledMessageIds() const
+{
+    return { MAVLINK_MSG_ID_EFI_STATUS };
+}
+
 void VehicleEFIFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_message_t& message)
 {
     switch (message.msgid) {
@@ -55,6 +55,11 @@ VehicleEstimatorStatusFactGroup::VehicleEstimatorStatusFactGroup(QObject* parent
     _addFact(&_vertPosAccuracyFact,             _vertPosAccuracyFactName);
 }
 
+QList<uint32_t> VehicleEstimatorStatusFactGroup::handledMessageIds() const
+{
+    return { MAVLINK_MSG_ID_ESTIMATOR_STATUS };
+}
+
 void VehicleEstimatorStatusFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_message_t& message)
 {
     if (message.msgid != MAVLINK_MSG_ID_ESTIMATOR_STATUS) {
@@ -79,6 +79,22 @@ VehicleFactGroup::VehicleFactGroup(QObject* parent)
     _hobbsFact.setRawValue(QVariant(QString("0000:00:00")));
 }
 
+QList<uint32_t> VehicleFactGroup::handledMessageIds() const
+{
+    QList<uint32_t> msgIds = {
+        MAVLINK_MSG_ID_ATTITUDE,
+        MAVLINK_MSG_ID_ATTITUDE_QUATERNION,
+        MAVLINK_MSG_ID_ALTITUDE,
+        MAVLINK_MSG_ID_VFR_HUD,
+        MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT,
+        MAVLINK_MSG_ID_RAW_IMU
+    };
+#ifndef NO_ARDUPILOT_DIALECT
+    msgIds.append(MAVLINK_MSG_ID_RANGEFINDER);
+#endif
+    return msgIds;
+}
+
 void VehicleFactGroup::handleMessage(Vehicle* vehicle, mavlink_message_t& message)
 {
     switch (message.msgid) {
@@ -14,6 +14,11 @@
 VehicleGPS2FactGroup::VehicleGPS2FactGroup(QObject* parent)
     : VehicleGPSFactGroup(parent) {}
 
+QList<uint32_t> VehicleGPS2FactGroup::handledMessageIds() const
+{
+    return { MAVLINK_MSG_ID_GPS2_RAW };
+}
+
 void VehicleGPS2FactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_message_t& message)
 {
     switch (message.msgid) {
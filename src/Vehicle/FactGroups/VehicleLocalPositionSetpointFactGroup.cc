@@ -37,6 +37,11 @@ VehicleLocalPositionSetpointFactGroup::VehicleLocalPositionSetpointFactGroup(QOb
     _vzFact.setRawValue(qQNaN());
 }
 
+QList<uint32_t> VehicleLocalPositionSetpointFactGroup::handledMessageIds() const
+{
+    return { MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED };
+}
+
 void VehicleLocalPositionSetpointFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_message_t& message)
 {
     if (message.msgid != MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED) {
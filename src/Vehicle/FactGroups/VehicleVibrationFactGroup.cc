@@ -32,6 +32,11 @@ VehicleVibrationFactGroup::VehicleVibrationFactGroup(QObject* parent)
     _zAxisFact.setRawValue(qQNaN());
 }
 
+QList<uint32_t> VehicleVibrationFactGroup::handledMessageIds() const
+{
+    return { MAVLINK_MSG_ID_VIBRATION };
+}
+
 void VehicleVibrationFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_message_t& message)
 {
     if (message.msgid != MAVLINK_MSG_ID_VIBRATION) {
@@ -358,6 +358,77 @@ void Vehicle::_commonInit()
     _loadJoystickSettings();
 
     _gimbalController = new GimbalController(MAVLinkProtocol::instance(), this);
+
+    _registerMessageHandlers();
+}
+
+/// Sets up the routing of incoming messages to the vehicle components. Registration order is dispatch order.
+void Vehicle::_registerMessageHandlers()
+{
+    _messageDispatcher.registerHandler(QStringLiteral("TerrainProtocolHandler"), { MAVLINK_MSG_ID_TERRAIN_REQUEST, MAVLINK_MSG_ID_TERRAIN_REPORT },
+        [this](LinkInterface*, mavlink_message_t& message) {
+            return _terrainProtocolHandler->mavlinkMessageReceived(message);
+        });
+    _messageDispatcher.registerHandler(QStringLiteral("FTPManager"), { MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL },
+        [this](LinkInterface*, mavlink_message_t& message) {
+            _ftpManager->_mavlinkMessageReceived(message);
+            return true;
+        });
+    _messageDispatcher.registerHandler(QStringLiteral("ParameterManager"), { MAVLINK_MSG_ID_PARAM_VALUE },
+        [this](LinkInterface*, mavlink_message_t& message) {
+            _parameterManager->mavlinkMessageReceived(message);
+            return true;
+        });
+    _messageDispatcher.registerHandler(QStringLiteral("ImageProtocolManager"), { MAVLINK_MSG_ID_DATA_TRANSMISSION_HANDSHAKE, MAVLINK_MSG_ID_ENCAPSULATED_DATA },
+        [this](LinkInterface*, mavlink_message_t& message) {
+            (void) QMetaObject::invokeMethod(_imageProtocolManager, "mavlinkMessageReceived", Qt::AutoConnection, message);
+            return true;
+        });
+    _messageDispatcher.registerHandler(QStringLiteral("RemoteIDManager"), { MAVLINK_MSG_ID_OPEN_DRONE_ID_ARM_STATUS },
+        [this](LinkInterface*, mavlink_message_t& message) {
+            _remoteIDManager->mavlinkMessageReceived(message);
+            return true;
+        });
+    // Waits can be for any message id
+    _messageDispatcher.registerHandler(QStringLiteral("RequestMessage"), {},
+        [this](LinkInterface*, mavlink_message_t& message) {
+            _waitForMavlinkMessageMessageReceivedHandler(message);
+            return true;
+        });
+    // Battery fact groups are created dynamically as new batteries are discovered
+    _messageDispatcher.registerHandler(QStringLiteral("BatteryFactGroupCreation"), { MAVLINK_MSG_ID_HIGH_LATENCY, MAVLINK_MSG_ID_HIGH_LATENCY2, MAVLINK_MSG_ID_BATTERY_STATUS },
+        [this](LinkInterface*, mavlink_message_t& message) {
+            VehicleBatteryFactGroup::handleMessageForFactGroupCreation(this, message);
+            return true;
+        });
+
+    // Let the fact groups take a whack at the mavlink traffic. Fact groups added later on are picked up as they show up.
+    _registerFactGroupMessageHandlers();
+    (void) connect(this, &FactGroup::factGroupNamesChanged, this, &Vehicle::_registerFactGroupMessageHandlers);
+
+    _messageDispatcher.registerHandler(QStringLiteral("Vehicle"), handledMessageIds(),
+        [this](LinkInterface*, mavlink_message_t& message) {
+            this->handleMessage(this, message);
+            return true;
+        });
+}
+
+void Vehicle::_registerFactGroupMessageHandlers()
+{
+    const QMap<QString, FactGroup*>& groups = factGroups();
+    for (auto it = groups.constBegin(); it != groups.constEnd(); ++it) {
+        FactGroup* const factGroup = it.value();
+        if (_dispatchedFactGroups.contains(factGroup)) {
+            continue;
+        }
+        (void) _dispatchedFactGroups.insert(factGroup);
+
+        _messageDispatcher.registerHandler(it.key(), factGroup->handledMessageIds(),
+            [this, factGroup](LinkInterface*, mavlink_message_t& message) {
+                factGroup->handleMessage(this, message);
+                return true;
+            });
+    }
 }
 
 Vehicle::~Vehicle()
@@ -504,25 +575,10 @@ void Vehicle::_mavlinkMessageReceived(LinkInterface* link, mavlink_message_t mes
         return;
     }
 
-    if (!_terrainProtocolHandler->mavlinkMessageReceived(message)) {
+    // Route the message to the components which handle it
+    if (!_messageDispatcher.dispatch(link, message)) {
         return;
     }
-    _ftpManager->_mavlinkMessageReceived(message);
-    _parameterManager->mavlinkMessageReceived(message);
-    (void) QMetaObject::invokeMethod(_imageProtocolManager, "mavlinkMessageReceived", Qt::AutoConnection, message);
-    _remoteIDManager->mavlinkMessageReceived(message);
-
-    _waitForMavlinkMessageMessageReceivedHandler(message);
-
-    // Battery fact groups are created dynamically as new batteries are discovered
-    VehicleBatteryFactGroup::handleMessageForFactGroupCreation(this, message);
-
-    // Let the fact groups take a whack at the mavlink traffic
-    for (FactGroup* factGroup : factGroups()) {
-        factGroup->handleMessage(this, message);
-    }
-
-    this->handleMessage(this, message);
 
     switch (message.msgid) {
     case MAVLINK_MSG_ID_HOME_POSITION:
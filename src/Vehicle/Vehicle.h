@@ -11,6 +11,7 @@
 
 #include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
+#include <QtCore/QSet>
 #include <QtCore/QSharedPointer>
 #include <QtCore/QTime>
 #include <QtCore/QTimer>
@@ -25,6 +26,7 @@
 #include "QmlObjectListModel.h"
 #include "SysStatusSensorInfo.h"
 #include "VehicleLinkManager.h"
+#include "VehicleMessageDispatcher.h"
 
 #include "TerrainFactGroup.h"
 #include "VehicleFactGroup.h"
@@ -966,6 +968,8 @@ private:
     void _handleMavlinkLoggingDataAcked (mavlink_message_t& message);
     void _ackMavlinkLogData             (uint16_t sequence);
     void _commonInit                    ();
+    void _registerMessageHandlers       ();
+    void _registerFactGroupMessageHandlers();
     void _setupAutoDisarmSignalling     ();
     void _setCapabilities               (uint64_t capabilityBits);
     void _updateArmed                   (bool armed);
@@ -1251,6 +1255,9 @@ private:
 
     TerrainProtocolHandler* _terrainProtocolHandler = nullptr;
 
+    VehicleMessageDispatcher        _messageDispatcher;
+    QSet<FactGroup*>                _dispatchedFactGroups;      ///< Fact groups already registered with _messageDispatcher
+
     MissionManager*                 _missionManager             = nullptr;
     GeoFenceManager*                _geoFenceManager            = nullptr;
     RallyPointManager*              _rallyPointManager          = nullptr;
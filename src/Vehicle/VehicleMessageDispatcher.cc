@@ -0,0 +1,168 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VehicleMessageDispatcher.h"
+#include "QGCLoggingCategory.h"
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(VehicleMessageDispatcherLog, "qgc.vehicle.vehiclemessagedispatcher")
+
+VehicleMessageDispatcher::VehicleMessageDispatcher()
+    : _msgIdTable(std::make_unique<uint16_t[]>(kMsgIdTableSize))
+{
+    _timer.start();
+}
+
+VehicleMessageDispatcher::~VehicleMessageDispatcher()
+{
+
+}
+
+void VehicleMessageDispatcher::registerHandler(const QString &name, const QList<uint32_t> &msgIds, const Handler &handler)
+{
+    const HandlerInfo handlerInfo{ name, msgIds, handler };
+    _handlers.append(handlerInfo);
+
+    // Route lists which are already built get the new handler appended, which keeps registration order
+    const qsizetype handlerIndex = _handlers.count() - 1;
+    for (RouteList &routeList : _routeLists) {
+        if (_handlerWantsMessage(handlerInfo, routeList.msgId)) {
+            Route route;
+            route.handlerIndex = handlerIndex;
+            routeList.routes.append(route);
+        }
+    }
+}
+
+bool VehicleMessageDispatcher::_handlerWantsMessage(const HandlerInfo &handlerInfo, uint32_t msgId) const
+{
+    return (handlerInfo.msgIds.isEmpty() || handlerInfo.msgIds.contains(msgId));
+}
+
+/// Returns the index of the route list for the msgid, building it on first use
+qsizetype VehicleMessageDispatcher::_routeListIndex(uint32_t msgId)
+{
+    if (msgId < kMsgIdTableSize) {
+        const uint16_t tableEntry = _msgIdTable[msgId];
+        if (tableEntry != 0) {
+            return tableEntry - 1;
+        }
+    } else {
+        const auto it = _extendedMsgIdRoutes.constFind(msgId);
+        if (it != _extendedMsgIdRoutes.constEnd()) {
+            return it.value();
+        }
+    }
+
+    RouteList routeList;
+    routeList.msgId = msgId;
+    for (qsizetype i = 0; i < _handlers.count(); i++) {
+        if (_handlerWantsMessage(_handlers[i], msgId)) {
+            Route route;
+            route.handlerIndex = i;
+            routeList.routes.append(route);
+        }
+    }
+    _routeLists.append(routeList);
+
+    const qsizetype index = _routeLists.count() - 1;
+    if ((msgId < kMsgIdTableSize) && (index < kMsgIdTableSize - 1)) {
+        _msgIdTable[msgId] = static_cast<uint16_t>(index + 1);
+    } else {
+        _extendedMsgIdRoutes[msgId] = index;
+    }
+
+    return index;
+}
+
+bool VehicleMessageDispatcher::dispatch(LinkInterface *link, mavlink_message_t &message)
+{
+    const qsizetype listIndex = _routeListIndex(message.msgid);
+    bool continueDispatch = true;
+
+    // Index based iteration on purpose: handlers may register new handlers, which appends to the lists while we iterate
+    for (qsizetype i = 0; continueDispatch && (i < _routeLists[listIndex].routes.count()); i++) {
+        const qsizetype handlerIndex = _routeLists[listIndex].routes[i].handlerIndex;
+
+        const qint64 start = _timer.nsecsElapsed();
+        continueDispatch = _handlers[handlerIndex].handler(link, message);
+        const quint64 elapsed = static_cast<quint64>(_timer.nsecsElapsed() - start);
+
+        Route &route = _routeLists[listIndex].routes[i];
+        route.calls++;
+        route.totalNsecs += elapsed;
+        route.maxNsecs = qMax(route.maxNsecs, elapsed);
+    }
+
+    if (VehicleMessageDispatcherLog().isDebugEnabled()) {
+        const qint64 nowMsecs = _timer.elapsed();
+        if ((nowMsecs - _lastStatsLogMsecs) > kStatsLogIntervalMsecs) {
+            _lastStatsLogMsecs = nowMsecs;
+            _logHandlerStats();
+        }
+    }
+
+    return continueDispatch;
+}
+
+QList<VehicleMessageDispatcher::HandlerStats> VehicleMessageDispatcher::handlerStats() const
+{
+    QList<HandlerStats> stats;
+
+    for (const RouteList &routeList : _routeLists) {
+        for (const Route &route : routeList.routes) {
+            if (route.calls == 0) {
+                continue;
+            }
+            HandlerStats handlerStats;
+            handlerStats.name = _handlers[route.handlerIndex].name;
+            handlerStats.msgId = routeList.msgId;
+            handlerStats.calls = route.calls;
+            handlerStats.totalNsecs = route.totalNsecs;
+            handlerStats.maxNsecs = route.maxNsecs;
+            stats.append(handlerStats);
+        }
+    }
+
+    std::sort(stats.begin(), stats.end(), [](const HandlerStats &a, const HandlerStats &b) {
+        return a.totalNsecs > b.totalNsecs;
+    });
+
+    return stats;
+}
+
+void VehicleMessageDispatcher::resetHandlerStats()
+{
+    for (RouteList &routeList : _routeLists) {
+        for (Route &route : routeList.routes) {
+            route.calls = 0;
+            route.totalNsecs = 0;
+            route.maxNsecs = 0;
+        }
+    }
+}
+
+void VehicleMessageDispatcher::_logHandlerStats() const
+{
+    const QList<HandlerStats> stats = handlerStats();
+
+    qCDebug(VehicleMessageDispatcherLog) << "Slowest message handlers:";
+    for (qsizetype i = 0; i < qMin(stats.count(), kStatsLogCount); i++) {
+        const HandlerStats &handlerStats = stats[i];
+        const mavlink_message_info_t *const info = mavlink_get_message_info_by_id(handlerStats.msgId);
+        qCDebug(VehicleMessageDispatcherLog).noquote() << QStringLiteral("  %1 %2(%3) calls:%4 total:%5us avg:%6us max:%7us")
+            .arg(handlerStats.name, info ? QString(info->name) : QStringLiteral("UNKNOWN"))
+            .arg(handlerStats.msgId)
+            .arg(handlerStats.calls)
+            .arg(handlerStats.totalNsecs / 1000)
+            .arg(handlerStats.totalNsecs / handlerStats.calls / 1000.0, 0, 'f', 1)
+            .arg(handlerStats.maxNsecs / 1000);
+    }
+}
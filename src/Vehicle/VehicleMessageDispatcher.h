@@ -0,0 +1,94 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QString>
+
+#include <functional>
+#include <memory>
+
+#include "MAVLinkLib.h"
+
+class LinkInterface;
+
+Q_DECLARE_LOGGING_CATEGORY(VehicleMessageDispatcherLog)
+
+/// Routes incoming messages to the consumers which registered for the message id, instead of offering every
+/// message to every consumer. Lookup goes through a 64K entry msgid table. Time spent in each handler is
+/// accumulated per msgid, enable VehicleMessageDispatcherLog to get a periodic report of the slowest handlers.
+class VehicleMessageDispatcher
+{
+public:
+    /// @return false: Stop dispatching the message to any further handlers
+    typedef std::function<bool(LinkInterface *link, mavlink_message_t &message)> Handler;
+
+    struct HandlerStats {
+        QString name;
+        uint32_t msgId = 0;
+        quint64 calls = 0;
+        quint64 totalNsecs = 0;
+        quint64 maxNsecs = 0;
+    };
+
+    VehicleMessageDispatcher();
+    ~VehicleMessageDispatcher();
+
+    /// Registers a message handler. Handlers for the same message id are called in registration order.
+    /// Registering from within a handler is allowed, the new handler also sees the message being dispatched.
+    ///     @param name Name shown in the timing report
+    ///     @param msgIds Message ids to route to the handler, empty to receive all messages
+    void registerHandler(const QString &name, const QList<uint32_t> &msgIds, const Handler &handler);
+
+    /// Calls all handlers registered for the message id
+    ///     @return false: A handler stopped dispatch of the message
+    bool dispatch(LinkInterface *link, mavlink_message_t &message);
+
+    /// @return Timing for each msgid/handler pair which has been called, slowest total time first
+    QList<HandlerStats> handlerStats() const;
+    void resetHandlerStats();
+
+private:
+    struct HandlerInfo {
+        QString name;
+        QList<uint32_t> msgIds;     ///< Empty for all messages
+        Handler handler;
+    };
+
+    struct Route {
+        qsizetype handlerIndex = 0;
+        quint64 calls = 0;
+        quint64 totalNsecs = 0;
+        quint64 maxNsecs = 0;
+    };
+
+    struct RouteList {
+        uint32_t msgId = 0;
+        QList<Route> routes;
+    };
+
+    qsizetype _routeListIndex(uint32_t msgId);
+    bool _handlerWantsMessage(const HandlerInfo &handlerInfo, uint32_t msgId) const;
+    void _logHandlerStats() const;
+
+    QList<HandlerInfo> _handlers;
+    QList<RouteList> _routeLists;
+    std::unique_ptr<uint16_t[]> _msgIdTable;            ///< msgid -> _routeLists index + 1, 0: route list not built yet
+    QHash<uint32_t, qsizetype> _extendedMsgIdRoutes;    ///< Route lists for msgids which don't fit in the table
+    QElapsedTimer _timer;
+    qint64 _lastStatsLogMsecs = 0;
+
+    static constexpr uint32_t kMsgIdTableSize = 65536;
+    static constexpr qint64 kStatsLogIntervalMsecs = 10000;
+    static constexpr qsizetype kStatsLogCount = 20;
+};
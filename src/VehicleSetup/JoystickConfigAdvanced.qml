@@ -122,6 +122,22 @@ Item {
             visible:            advancedSettings.checked
         }
         //-----------------------------------------------------------------
+        //-- Input Latency
+        QGCLabel {
+            text:               _activeJoystick && _activeJoystick.eventDriven ? qsTr("Input latency, sent on change (ms):") : qsTr("Input latency, polled (ms):")
+            Layout.alignment:   Qt.AlignVCenter
+            visible:            advancedSettings.checked
+        }
+        QGCLabel {
+            text:               !_activeJoystick || _activeJoystick.inputLatencySamples === 0 ?
+                                    qsTr("No input yet") :
+                                    qsTr("p50 %1  p95 %2  p99 %3").arg(_activeJoystick.inputLatencyP50Ms.toFixed(2))
+                                                                  .arg(_activeJoystick.inputLatencyP95Ms.toFixed(2))
+                                                                  .arg(_activeJoystick.inputLatencyP99Ms.toFixed(2))
+            Layout.alignment:   Qt.AlignVCenter
+            visible:            advancedSettings.checked
+        }
+        //-----------------------------------------------------------------
         //-- Button Repeat Frequency
         QGCLabel {
             text:               qsTr("Button repeat frequency (Hz):")
@@ -46,22 +46,8 @@ SubtitleWriter::~SubtitleWriter()
 
 void SubtitleWriter::startCapturingTelemetry(const QString& videoFile)
 {
-    // Delete facts of last run
-    _facts.clear();
-
     // Gather the facts currently displayed into _facts
-    FactValueGrid* grid = new FactValueGrid();
-    grid->setProperty("userSettingsGroup", HorizontalFactValueGrid::telemetryBarUserSettingsGroup);
-    grid->setProperty("defaultSettingsGroup", HorizontalFactValueGrid::telemetryBarDefaultSettingsGroup);
-    grid->_loadSettings();
-    for (int colIndex = 0; colIndex < grid->columns()->count(); colIndex++) {
-        QmlObjectListModel* list = grid->columns()->value<QmlObjectListModel*>(colIndex);
-        for (int rowIndex = 0; rowIndex < list->count(); rowIndex++) {
-            InstrumentValueData* value = list->value<InstrumentValueData*>(rowIndex);
-            _facts += value->fact();
-        }
-    }
-    grid->deleteLater();
+    _facts = telemetryBarFacts();
 
     // One subtitle always starts where the previous ended
     _lastEndTime = QTime(0, 0);
@@ -103,6 +89,26 @@ void SubtitleWriter::startCapturingTelemetry(const QString& videoFile)
     _timer->start(1000/_sampleRate);
 }
 
+QList<Fact*> SubtitleWriter::telemetryBarFacts()
+{
+    QList<Fact*> facts;
+
+    FactValueGrid* grid = new FactValueGrid();
+    grid->setProperty("userSettingsGroup", HorizontalFactValueGrid::telemetryBarUserSettingsGroup);
+    grid->setProperty("defaultSettingsGroup", HorizontalFactValueGrid::telemetryBarDefaultSettingsGroup);
+    grid->_loadSettings();
+    for (int colIndex = 0; colIndex < grid->columns()->count(); colIndex++) {
+        QmlObjectListModel* list = grid->columns()->value<QmlObjectListModel*>(colIndex);
+        for (int rowIndex = 0; rowIndex < list->count(); rowIndex++) {
+            InstrumentValueData* value = list->value<InstrumentValueData*>(rowIndex);
+            facts += value->fact();
+        }
+    }
+    grid->deleteLater();
+
+    return facts;
+}
+
 void SubtitleWriter::stopCapturingTelemetry()
 {
     qCDebug(SubtitleWriterLog) << "Stopping writing";
@@ -38,6 +38,9 @@ public:
     void startCapturingTelemetry(const QString &videoFile);
     void stopCapturingTelemetry();
 
+    // The facts currently displayed in the telemetry bar
+    static QList<Fact*> telemetryBarFacts();
+
 private slots:
     // Captures a snapshot of telemetry data from vehicle into the subtitles file.
     void _captureTelemetry();
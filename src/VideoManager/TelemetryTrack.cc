@@ -0,0 +1,407 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TelemetryTrack.h"
+#include "Fact.h"
+#include "QGCLoggingCategory.h"
+#include "Vehicle.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTimer>
+#include <QtCore/QtEndian>
+
+#include <cstddef>
+#include <cstring>
+
+QGC_LOGGING_CATEGORY(TelemetryTrackLog, "qgc.videomanager.telemetrytrack")
+
+using namespace TelemetryTrack;
+
+QString TelemetryTrack::fileNameForVideo(const QString &videoFile)
+{
+    const QFileInfo videoFileInfo(videoFile);
+    return QStringLiteral("%1/%2.%3").arg(videoFileInfo.path(), videoFileInfo.completeBaseName(), kFileExtension);
+}
+
+static void _appendString(QByteArray &data, const QString &string)
+{
+    const QByteArray utf8 = string.toUtf8().left(UINT16_MAX);
+    const quint16 length = qToLittleEndian(static_cast<quint16>(utf8.size()));
+    (void) data.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    (void) data.append(utf8);
+}
+
+template<typename T>
+static void _appendValue(QByteArray &data, T value)
+{
+    value = qToLittleEndian(value);
+    (void) data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/// Reads a little endian value from the header, advancing offset. Fails if it would run past size.
+template<typename T>
+static bool _readValue(const uchar *data, qint64 size, qint64 &offset, T &value)
+{
+    if ((offset + static_cast<qint64>(sizeof(T))) > size) {
+        return false;
+    }
+
+    value = qFromLittleEndian<T>(data + offset);
+    offset += sizeof(T);
+    return true;
+}
+
+static bool _readString(const uchar *data, qint64 size, qint64 &offset, QString &string)
+{
+    quint16 length = 0;
+    if (!_readValue(data, size, offset, length) || ((offset + length) > size)) {
+        return false;
+    }
+
+    string = QString::fromUtf8(reinterpret_cast<const char*>(data + offset), length);
+    offset += length;
+    return true;
+}
+
+/*===========================================================================*/
+
+TelemetryTrackWriter::TelemetryTrackWriter(QObject *parent)
+    : QObject(parent)
+    , _flushTimer(new QTimer(this))
+    , _snapshotTimer(new QTimer(this))
+{
+    // qCDebug(TelemetryTrackLog) << Q_FUNC_INFO << this;
+
+    _flushTimer->setInterval(kFlushIntervalMsecs);
+    _snapshotTimer->setInterval(kSnapshotIntervalMsecs);
+
+    (void) connect(_flushTimer, &QTimer::timeout, this, &TelemetryTrackWriter::_flush);
+    (void) connect(_snapshotTimer, &QTimer::timeout, this, &TelemetryTrackWriter::_writeSnapshot);
+}
+
+TelemetryTrackWriter::~TelemetryTrackWriter()
+{
+    stopCapturingTelemetry();
+
+    // qCDebug(TelemetryTrackLog) << Q_FUNC_INFO << this;
+}
+
+void TelemetryTrackWriter::startCapturingTelemetry(const QString &videoFile, Vehicle *vehicle, const QList<Fact*> &facts)
+{
+    stopCapturingTelemetry();
+
+    if (!vehicle) {
+        qCWarning(TelemetryTrackLog) << "No active vehicle, telemetry track not written";
+        return;
+    }
+
+    QList<FactInfo_t> factInfo;
+    for (Fact *fact : facts) {
+        if (fact) {
+            _facts.append(fact);
+            factInfo.append({fact->shortDescription(), fact->rawUnits()});
+        }
+    }
+
+    if (!open(fileNameForVideo(videoFile), factInfo, QDateTime::currentMSecsSinceEpoch())) {
+        _facts.clear();
+        return;
+    }
+
+    _vehicle = vehicle;
+
+    // The Facts go away with the vehicle
+    _connections.append(connect(_vehicle, &QObject::destroyed, this, &TelemetryTrackWriter::stopCapturingTelemetry));
+    _connections.append(connect(_vehicle, &Vehicle::mavlinkMessageReceived, this, &TelemetryTrackWriter::_mavlinkMessageReceived));
+    for (int i = 0; i < _facts.count(); i++) {
+        _connections.append(connect(_facts[i], &Fact::rawValueChanged, this, [this, i](const QVariant &value) {
+            _writeFact(i, value);
+        }));
+    }
+
+    _writeSnapshot();
+    _snapshotTimer->start();
+}
+
+void TelemetryTrackWriter::stopCapturingTelemetry()
+{
+    for (const QMetaObject::Connection &connection : std::as_const(_connections)) {
+        (void) disconnect(connection);
+    }
+    _connections.clear();
+
+    _snapshotTimer->stop();
+    _vehicle = nullptr;
+    _facts.clear();
+
+    close();
+}
+
+bool TelemetryTrackWriter::open(const QString &fileName, const QList<FactInfo_t> &facts, qint64 startUtcMs)
+{
+    close();
+
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(TelemetryTrackLog) << "Unable to open telemetry track" << fileName << _file.errorString();
+        return false;
+    }
+
+    QByteArray header(kMagic, sizeof(kMagic));
+    _appendValue<quint32>(header, kVersion);
+    const qsizetype recordOffsetPos = header.size();
+    _appendValue<quint32>(header, 0);
+    _appendValue<qint64>(header, startUtcMs);
+    _appendValue<quint32>(header, static_cast<quint32>(facts.count()));
+    for (const FactInfo_t &fact : facts) {
+        _appendString(header, fact.name);
+        _appendString(header, fact.units);
+    }
+
+    // Keep the records 8 byte aligned in the mapped file
+    header.resize((header.size() + 7) & ~7, '\0');
+    const quint32 recordOffset = qToLittleEndian(static_cast<quint32>(header.size()));
+    (void) memcpy(header.data() + recordOffsetPos, &recordOffset, sizeof(recordOffset));
+
+    if (_file.write(header) != header.size()) {
+        qCWarning(TelemetryTrackLog) << "Unable to write telemetry track header" << fileName << _file.errorString();
+        _file.close();
+        return false;
+    }
+
+    _pending.clear();
+    _pending.reserve(64 * 1024);
+    _elapsed.start();
+    _flushTimer->start();
+
+    qCDebug(TelemetryTrackLog) << "Writing telemetry track to file:" << fileName;
+
+    return true;
+}
+
+void TelemetryTrackWriter::close()
+{
+    if (!_file.isOpen()) {
+        return;
+    }
+
+    qCDebug(TelemetryTrackLog) << "Stopping writing";
+
+    _flushTimer->stop();
+    _flush();
+    _file.close();
+}
+
+void TelemetryTrackWriter::writeRecord(const Record_t &record)
+{
+    if (_file.isOpen()) {
+        (void) _pending.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+}
+
+void TelemetryTrackWriter::_flush()
+{
+    if (_pending.isEmpty()) {
+        return;
+    }
+
+    if (_file.write(_pending) != _pending.size()) {
+        qCWarning(TelemetryTrackLog) << "Telemetry track write failed" << _file.errorString();
+    }
+    (void) _file.flush();
+    _pending.resize(0);
+}
+
+void TelemetryTrackWriter::_writeSnapshot()
+{
+    for (int i = 0; i < _facts.count(); i++) {
+        _writeFact(i, _facts[i]->rawValue());
+    }
+}
+
+void TelemetryTrackWriter::_writeFact(int id, const QVariant &value)
+{
+    bool ok = false;
+    const double rawValue = value.toDouble(&ok);
+    if (!ok) {
+        return;
+    }
+
+    Record_t record{};
+    record.timeUs = _elapsedUs();
+    record.type = RecordTypeFact;
+    record.id = static_cast<quint16>(id);
+    record.payload.fact = rawValue;
+    writeRecord(record);
+}
+
+void TelemetryTrackWriter::_mavlinkMessageReceived(const mavlink_message_t &message)
+{
+    if (message.sysid != _vehicle->id()) {
+        return;
+    }
+
+    Record_t record{};
+
+    switch (message.msgid) {
+    case MAVLINK_MSG_ID_ATTITUDE:
+    {
+        mavlink_attitude_t attitude;
+        mavlink_msg_attitude_decode(&message, &attitude);
+
+        record.type = RecordTypeAttitude;
+        record.payload.attitude.timeBootMs = attitude.time_boot_ms;
+        record.payload.attitude.roll = attitude.roll;
+        record.payload.attitude.pitch = attitude.pitch;
+        record.payload.attitude.yaw = attitude.yaw;
+        record.payload.attitude.rollSpeed = attitude.rollspeed;
+        record.payload.attitude.pitchSpeed = attitude.pitchspeed;
+        record.payload.attitude.yawSpeed = attitude.yawspeed;
+        break;
+    }
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+    {
+        mavlink_global_position_int_t position;
+        mavlink_msg_global_position_int_decode(&message, &position);
+
+        record.type = RecordTypePosition;
+        record.payload.position.timeBootMs = position.time_boot_ms;
+        record.payload.position.lat = position.lat;
+        record.payload.position.lon = position.lon;
+        record.payload.position.alt = position.alt;
+        record.payload.position.relativeAlt = position.relative_alt;
+        record.payload.position.vx = position.vx;
+        record.payload.position.vy = position.vy;
+        record.payload.position.vz = position.vz;
+        record.payload.position.hdg = position.hdg;
+        break;
+    }
+    default:
+        return;
+    }
+
+    record.timeUs = _elapsedUs();
+    writeRecord(record);
+}
+
+/*===========================================================================*/
+
+TelemetryTrackReader::~TelemetryTrackReader()
+{
+    close();
+}
+
+bool TelemetryTrackReader::open(const QString &fileName)
+{
+    close();
+
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::ReadOnly)) {
+        qCWarning(TelemetryTrackLog) << "Unable to open telemetry track" << fileName << _file.errorString();
+        return false;
+    }
+
+    const qint64 size = _file.size();
+    const uchar *data = (size > 0) ? _file.map(0, size) : nullptr;
+    if (!data) {
+        qCWarning(TelemetryTrackLog) << "Unable to map telemetry track" << fileName << _file.errorString();
+        _file.close();
+        return false;
+    }
+
+    qint64 offset = sizeof(kMagic);
+    quint32 version = 0;
+    quint32 recordOffset = 0;
+    quint32 factCount = 0;
+    bool valid = (size >= offset) && (memcmp(data, kMagic, sizeof(kMagic)) == 0) &&
+                 _readValue(data, size, offset, version) && (version == kVersion) &&
+                 _readValue(data, size, offset, recordOffset) &&
+                 _readValue(data, size, offset, _startUtcMs) &&
+                 _readValue(data, size, offset, factCount);
+
+    for (quint32 i = 0; valid && (i < factCount); i++) {
+        FactInfo_t fact;
+        valid = _readString(data, size, offset, fact.name) && _readString(data, size, offset, fact.units);
+        _facts.append(fact);
+    }
+
+    if (!valid || (recordOffset < offset) || (recordOffset > size)) {
+        qCWarning(TelemetryTrackLog) << "Not a telemetry track" << fileName;
+        close();
+        return false;
+    }
+
+    // A trailing partial record is left over if QGC stopped while writing it
+    _records = data + recordOffset;
+    _count = static_cast<qsizetype>((size - recordOffset) / static_cast<qint64>(sizeof(Record_t)));
+
+    qCDebug(TelemetryTrackLog) << "Opened telemetry track" << fileName << "records" << _count;
+
+    return true;
+}
+
+void TelemetryTrackReader::close()
+{
+    // QFile::close unmaps the file
+    _file.close();
+    _records = nullptr;
+    _count = 0;
+    _startUtcMs = 0;
+    _facts.clear();
+}
+
+Record_t TelemetryTrackReader::record(qsizetype index) const
+{
+    Q_ASSERT((index >= 0) && (index < _count));
+
+    Record_t record;
+    (void) memcpy(&record, _records + (index * sizeof(Record_t)), sizeof(record));
+    return record;
+}
+
+qint64 TelemetryTrackReader::_timeAt(qsizetype index) const
+{
+    qint64 timeUs;
+    (void) memcpy(&timeUs, _records + (index * sizeof(Record_t)) + offsetof(Record_t, timeUs), sizeof(timeUs));
+    return timeUs;
+}
+
+qsizetype TelemetryTrackReader::indexAt(qint64 timeUs) const
+{
+    // First record after timeUs
+    qsizetype low = 0;
+    qsizetype high = _count;
+    while (low < high) {
+        const qsizetype mid = low + ((high - low) / 2);
+        if (_timeAt(mid) <= timeUs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low - 1;
+}
+
+bool TelemetryTrackReader::latest(quint16 type, quint16 id, qint64 timeUs, Record_t &record, qint64 maxAgeUs) const
+{
+    for (qsizetype index = indexAt(timeUs); index >= 0; index--) {
+        const Record_t candidate = this->record(index);
+        if ((timeUs - candidate.timeUs) > maxAgeUs) {
+            break;
+        }
+        if ((candidate.type == type) && (candidate.id == id)) {
+            record = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,192 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+/**
+ * @file
+ *   @brief Binary telemetry track written next to video recordings.
+ *
+ * A recording "<name>.mkv" gets a "<name>.qgctlm" holding the raw values of the telemetry bar Facts and the
+ * vehicle attitude and position at the rate the messages arrive. The file is a header followed by fixed size
+ * records in time order, so it stays readable up to the last complete record even if QGC stops mid-recording,
+ * and a record for any point of the video is found with a binary search instead of parsing the whole file.
+ *
+ * Header (little endian):
+ *   char[8]  magic "QGCTLM\0\0"
+ *   uint32   version
+ *   uint32   offset of the first record
+ *   int64    recording start, msecs since epoch UTC
+ *   uint32   Fact count, followed per Fact by uint16 length + UTF-8 name and uint16 length + UTF-8 units
+ *
+ * Records: TelemetryTrack::Record_t, timeUs is relative to the start of the video.
+ */
+
+#pragma once
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include "MAVLinkLib.h"
+
+class Fact;
+class QTimer;
+class Vehicle;
+
+Q_DECLARE_LOGGING_CATEGORY(TelemetryTrackLog)
+
+namespace TelemetryTrack
+{
+    static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "telemetry track records are written in host byte order");
+
+    constexpr char kMagic[8] = { 'Q', 'G', 'C', 'T', 'L', 'M', '\0', '\0' };
+    constexpr quint32 kVersion = 1;
+    constexpr const char *kFileExtension = "qgctlm";
+
+    enum RecordType : quint16 {
+        RecordTypeFact      = 1,    ///< id is the index into the Fact table, payload.fact
+        RecordTypeAttitude  = 2,    ///< payload.attitude from ATTITUDE
+        RecordTypePosition  = 3,    ///< payload.position from GLOBAL_POSITION_INT
+    };
+
+    struct Attitude_t {
+        quint32 timeBootMs;
+        float   roll;               ///< rad
+        float   pitch;              ///< rad
+        float   yaw;                ///< rad
+        float   rollSpeed;          ///< rad/s
+        float   pitchSpeed;         ///< rad/s
+        float   yawSpeed;           ///< rad/s
+    };
+
+    struct Position_t {
+        quint32 timeBootMs;
+        qint32  lat;                ///< degE7
+        qint32  lon;                ///< degE7
+        qint32  alt;                ///< mm AMSL
+        qint32  relativeAlt;        ///< mm above home
+        qint16  vx;                 ///< cm/s
+        qint16  vy;                 ///< cm/s
+        qint16  vz;                 ///< cm/s
+        quint16 hdg;                ///< cdeg, UINT16_MAX if unknown
+    };
+
+    struct Record_t {
+        qint64  timeUs;
+        quint16 type;               ///< RecordType
+        quint16 id;
+        quint32 reserved;
+        union {
+            double      fact;
+            Attitude_t  attitude;
+            Position_t  position;
+            quint8      raw[32];
+        } payload;
+    };
+    static_assert(sizeof(Record_t) == 48, "telemetry track record layout changed");
+
+    struct FactInfo_t {
+        QString name;
+        QString units;
+    };
+
+    /// Returns the telemetry track file belonging to a video file
+    QString fileNameForVideo(const QString &videoFile);
+}
+
+/*===========================================================================*/
+
+/// Records the telemetry track of a video recording. Records are collected in memory and appended to the file
+/// every kFlushIntervalMsecs. Fact values are written when they change and repeated every kSnapshotIntervalMsecs,
+/// which bounds how far back TelemetryTrackReader::latest has to look for them.
+class TelemetryTrackWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TelemetryTrackWriter(QObject *parent = nullptr);
+    ~TelemetryTrackWriter();
+
+    /// Starts recording the Facts and the attitude/position messages of vehicle next to videoFile.
+    /// Should be called when the first frame is written to the video, this is time 0 of the track.
+    void startCapturingTelemetry(const QString &videoFile, Vehicle *vehicle, const QList<Fact*> &facts);
+    void stopCapturingTelemetry();
+
+    bool open(const QString &fileName, const QList<TelemetryTrack::FactInfo_t> &facts, qint64 startUtcMs);
+    void close();
+    bool isOpen() const { return _file.isOpen(); }
+
+    /// Queues a record, timeUs must not decrease
+    void writeRecord(const TelemetryTrack::Record_t &record);
+
+    static constexpr int kFlushIntervalMsecs = 1000;
+    static constexpr int kSnapshotIntervalMsecs = 1000;
+
+private slots:
+    void _mavlinkMessageReceived(const mavlink_message_t &message);
+    void _flush();
+    void _writeSnapshot();
+
+private:
+    void _writeFact(int id, const QVariant &value);
+    qint64 _elapsedUs() const { return _elapsed.nsecsElapsed() / 1000; }
+
+    QFile _file;
+    QByteArray _pending;
+    QElapsedTimer _elapsed;
+    QTimer *_flushTimer = nullptr;
+    QTimer *_snapshotTimer = nullptr;
+    Vehicle *_vehicle = nullptr;
+    QList<Fact*> _facts;
+    QList<QMetaObject::Connection> _connections;
+};
+
+/*===========================================================================*/
+
+/// Memory maps a telemetry track for random access. Records are located by time with a binary search, O(log n)
+/// in the number of records, latest() then only steps back over the records inside its maxAgeUs window.
+class TelemetryTrackReader
+{
+public:
+    TelemetryTrackReader() = default;
+    ~TelemetryTrackReader();
+
+    TelemetryTrackReader(const TelemetryTrackReader&) = delete;
+    TelemetryTrackReader& operator=(const TelemetryTrackReader&) = delete;
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return _records != nullptr; }
+
+    qint64 startUtcMs() const { return _startUtcMs; }
+    const QList<TelemetryTrack::FactInfo_t> &facts() const { return _facts; }
+
+    qsizetype count() const { return _count; }
+    TelemetryTrack::Record_t record(qsizetype index) const;
+
+    /// Index of the last record at or before timeUs, -1 if the track starts later
+    qsizetype indexAt(qint64 timeUs) const;
+
+    /// Most recent record of type/id at or before timeUs, ignoring records older than maxAgeUs.
+    /// Pass the presentation time of a video frame (relative to the first frame) to get the telemetry shown with it.
+    bool latest(quint16 type, quint16 id, qint64 timeUs, TelemetryTrack::Record_t &record, qint64 maxAgeUs = kDefaultMaxAgeUs) const;
+
+    static constexpr qint64 kDefaultMaxAgeUs = 2000000;
+
+private:
+    qint64 _timeAt(qsizetype index) const;
+
+    QFile _file;
+    const uchar *_records = nullptr;
+    qsizetype _count = 0;
+    qint64 _startUtcMs = 0;
+    QList<TelemetryTrack::FactInfo_t> _facts;
+};
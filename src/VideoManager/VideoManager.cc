@@ -16,6 +16,7 @@
 #include "SettingsManager.h"
 #include "AppSettings.h"
 #include "SubtitleWriter.h"
+#include "TelemetryTrack.h"
 #include "Vehicle.h"
 #include "VideoReceiver.h"
 #include "VideoSettings.h"
@@ -54,6 +55,7 @@ Q_APPLICATION_STATIC(VideoManager, _videoManagerInstance);
 VideoManager::VideoManager(QObject *parent)
     : QObject(parent)
     , _subtitleWriter(new SubtitleWriter(this))
+    , _telemetryTrackWriter(new TelemetryTrackWriter(this))
     , _videoSettings(SettingsManager::instance()->videoSettings())
 {
     // qCDebug(VideoManagerLog) << Q_FUNC_INFO << this;
@@ -122,6 +124,8 @@ void VideoManager::init()
     (void) connect(_videoSettings->tcpUrl(), &Fact::rawValueChanged, this, &VideoManager::_videoSourceChanged);
     (void) connect(_videoSettings->aspectRatio(), &Fact::rawValueChanged, this, &VideoManager::aspectRatioChanged);
     (void) connect(_videoSettings->lowLatencyMode(), &Fact::rawValueChanged, this, &VideoManager::_lowLatencyModeChanged);
+    (void) connect(_videoSettings->frameStatsLog(), &Fact::rawValueChanged, this, &VideoManager::_updateFrameStatsLog);
+    (void) connect(_videoSettings->frameTap(), &Fact::rawValueChanged, this, &VideoManager::_frameTapChanged);
     (void) connect(MultiVehicleManager::instance(), &MultiVehicleManager::activeVehicleChanged, this, &VideoManager::_setActiveVehicle);
 
     int index = 0;
@@ -183,6 +187,7 @@ void VideoManager::init()
                 _recording = active;
                 if (!active) {
                     _subtitleWriter->stopCapturingTelemetry();
+                    _telemetryTrackWriter->stopCapturingTelemetry();
                 }
                 emit recordingChanged();
             }
@@ -192,6 +197,9 @@ void VideoManager::init()
             qCDebug(VideoManagerLog) << "Video" << videoReceiver.index << "recording started";
             if (videoReceiver.index == 0) {
                 _subtitleWriter->startCapturingTelemetry(_videoFile);
+                if (_videoSettings->telemetryTrack()->rawValue().toBool()) {
+                    _telemetryTrackWriter->startCapturingTelemetry(_videoFile, _activeVehicle, SubtitleWriter::telemetryBarFacts());
+                }
             }
         });
 
@@ -203,6 +211,13 @@ void VideoManager::init()
             }
         });
 
+        (void) connect(videoReceiver.receiver, &VideoReceiver::frameStatsChanged, this, [this, &videoReceiver](const VideoFrameStats &stats) {
+            if (videoReceiver.index == 0) {
+                _frameStats = stats;
+                emit frameStatsChanged();
+            }
+        });
+
         (void) connect(videoReceiver.receiver, &VideoReceiver::onTakeScreenshotComplete, this, [this, &videoReceiver](VideoReceiver::STATUS status) {
             if (status == VideoReceiver::STATUS_OK) {
                 qCDebug(VideoManagerLog) << "Video" << videoReceiver.index << "screenshot taken";
@@ -212,6 +227,9 @@ void VideoManager::init()
         });
     }
 
+    _updateFrameStatsLog();
+    _updateFrameTap();
+
     _videoSourceChanged();
 
     startVideo();
@@ -778,10 +796,71 @@ void VideoManager::_stopReceiver(unsigned id)
     _videoReceiverData[id].receiver->stop();
 }
 
+void VideoManager::_updateFrameStatsLog()
+{
+    const bool enabled = _videoSettings->frameStatsLog()->rawValue().toBool();
+    const QString logPath = SettingsManager::instance()->appSettings()->logSavePath();
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh.mm.ss");
+
+    for (VideoReceiverData &videoReceiver : _videoReceiverData) {
+        if (videoReceiver.receiver == nullptr) {
+            continue;
+        }
+
+        if (!enabled || logPath.isEmpty()) {
+            videoReceiver.frameStatsLogFile.clear();
+        } else if (videoReceiver.frameStatsLogFile.isEmpty()) {
+            // One file per receiver for as long as logging stays enabled, restarts of the stream append to it
+            videoReceiver.frameStatsLogFile = QStringLiteral("%1/%2_video%3_timing.csv").arg(logPath, timestamp).arg(videoReceiver.index);
+        }
+
+        videoReceiver.receiver->setFrameStatsLogFile(videoReceiver.frameStatsLogFile);
+    }
+}
+
+void VideoManager::_frameTapChanged()
+{
+    _updateFrameTap();
+    _restartAllVideos();
+}
+
+void VideoManager::_updateFrameTap()
+{
+    const bool enabled = _videoSettings->frameTap()->rawValue().toBool();
+
+    for (VideoReceiverData &videoReceiver : _videoReceiverData) {
+        if (videoReceiver.receiver != nullptr) {
+            videoReceiver.receiver->setFrameTapName(enabled ? QStringLiteral("/qgc_video%1").arg(videoReceiver.index) : QString());
+        }
+    }
+
+    _vehicleAttitudeChanged();
+}
+
+void VideoManager::_vehicleAttitudeChanged()
+{
+    if (!_activeVehicle || !_videoSettings->frameTap()->rawValue().toBool()) {
+        return;
+    }
+
+    const float roll = _activeVehicle->roll()->rawValue().toFloat();
+    const float pitch = _activeVehicle->pitch()->rawValue().toFloat();
+    const float yaw = _activeVehicle->heading()->rawValue().toFloat();
+
+    for (VideoReceiverData &videoReceiver : _videoReceiverData) {
+        if (videoReceiver.receiver != nullptr) {
+            videoReceiver.receiver->setVehicleAttitude(roll, pitch, yaw);
+        }
+    }
+}
+
 void VideoManager::_setActiveVehicle(Vehicle *vehicle)
 {
     if (_activeVehicle) {
         (void) disconnect(_activeVehicle->vehicleLinkManager(), &VehicleLinkManager::communicationLostChanged, this, &VideoManager::_communicationLostChanged);
+        (void) disconnect(_activeVehicle->roll(), &Fact::rawValueChanged, this, &VideoManager::_vehicleAttitudeChanged);
+        (void) disconnect(_activeVehicle->pitch(), &Fact::rawValueChanged, this, &VideoManager::_vehicleAttitudeChanged);
+        (void) disconnect(_activeVehicle->heading(), &Fact::rawValueChanged, this, &VideoManager::_vehicleAttitudeChanged);
         if (_activeVehicle->cameraManager()) {
             MavlinkCameraControl *const pCamera = _activeVehicle->cameraManager()->currentCameraInstance();
             if (pCamera) {
@@ -794,6 +873,9 @@ void VideoManager::_setActiveVehicle(Vehicle *vehicle)
     _activeVehicle = vehicle;
     if (_activeVehicle) {
         (void) connect(_activeVehicle->vehicleLinkManager(), &VehicleLinkManager::communicationLostChanged, this, &VideoManager::_communicationLostChanged);
+        (void) connect(_activeVehicle->roll(), &Fact::rawValueChanged, this, &VideoManager::_vehicleAttitudeChanged);
+        (void) connect(_activeVehicle->pitch(), &Fact::rawValueChanged, this, &VideoManager::_vehicleAttitudeChanged);
+        (void) connect(_activeVehicle->heading(), &Fact::rawValueChanged, this, &VideoManager::_vehicleAttitudeChanged);
         if (_activeVehicle->cameraManager()) {
             (void) connect(_activeVehicle->cameraManager(), &QGCCameraManager::streamChanged, this, &VideoManager::_restartAllVideos);
             MavlinkCameraControl *const pCamera = _activeVehicle->cameraManager()->currentCameraInstance();
@@ -15,12 +15,15 @@
 #include <QtCore/QSize>
 #include <QtQmlIntegration/QtQmlIntegration>
 
+#include "VideoFrameStats.h"
+
 Q_DECLARE_LOGGING_CATEGORY(VideoManagerLog)
 
 #define MAX_VIDEO_RECEIVERS 2
 
 class FinishVideoInitialization;
 class SubtitleWriter;
+class TelemetryTrackWriter;
 class Vehicle;
 class VideoReceiver;
 class VideoSettings;
@@ -48,6 +51,7 @@ class VideoManager : public QObject
     Q_PROPERTY(double   thermalAspectRatio      READ thermalAspectRatio                         NOTIFY aspectRatioChanged)
     Q_PROPERTY(double   thermalHfov             READ thermalHfov                                NOTIFY aspectRatioChanged)
     Q_PROPERTY(QSize    videoSize               READ videoSize                                  NOTIFY videoSizeChanged)
+    Q_PROPERTY(VideoFrameStats frameStats       READ frameStats                                 NOTIFY frameStatsChanged)
     Q_PROPERTY(QString  imageFile               READ imageFile                                  NOTIFY imageFileChanged)
     Q_PROPERTY(QString  uvcVideoSourceID        READ uvcVideoSourceID                           NOTIFY uvcVideoSourceIDChanged)
 
@@ -88,6 +92,7 @@ public:
     QSize videoSize() const { return QSize((_videoSize >> 16) & 0xFFFF, _videoSize & 0xFFFF); }
     QString imageFile() const { return _imageFile; }
     QString uvcVideoSourceID() const { return _uvcVideoSourceID; }
+    VideoFrameStats frameStats() const { return _frameStats; }
     void setfullScreen(bool on);
 
 signals:
@@ -105,11 +110,15 @@ signals:
     void streamingChanged();
     void uvcVideoSourceIDChanged();
     void videoSizeChanged();
+    void frameStatsChanged();
 
 private slots:
     bool _updateUVC();
     void _communicationLostChanged(bool communicationLost);
     void _lowLatencyModeChanged() { _restartAllVideos(); }
+    void _updateFrameStatsLog();
+    void _frameTapChanged();
+    void _vehicleAttitudeChanged();
     void _setActiveVehicle(Vehicle *vehicle);
     void _videoSourceChanged();
 
@@ -122,6 +131,7 @@ private:
     void _restartVideo(unsigned id);
     void _startReceiver(unsigned id);
     void _stopReceiver(unsigned id);
+    void _updateFrameTap();
     static void _cleanupOldVideos();
 
     struct VideoReceiverData {
@@ -131,10 +141,12 @@ private:
         bool started = false;
         bool lowLatencyStreaming = false;
         size_t index = 0;
+        QString frameStatsLogFile;
     };
     QList<VideoReceiverData> _videoReceiverData = QList<VideoReceiverData>(MAX_VIDEO_RECEIVERS);
 
     SubtitleWriter *_subtitleWriter = nullptr;
+    TelemetryTrackWriter *_telemetryTrackWriter = nullptr;
 
     bool _initialized = false;
     bool _fullScreen = false;
@@ -145,6 +157,7 @@ private:
     QString _imageFile;
     QString _uvcVideoSourceID;
     QString _videoFile;
+    VideoFrameStats _frameStats;
     Vehicle *_activeVehicle = nullptr;
     VideoSettings *_videoSettings = nullptr;
 };
@@ -0,0 +1,174 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VideoFrameTap.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <new>
+
+struct qgc_frame_tap {
+    uint8_t* base;
+    size_t size;
+};
+
+static const qgc_frame_tap_header_t* _header(const qgc_frame_tap_t* tap)
+{
+    return reinterpret_cast<const qgc_frame_tap_header_t*>(tap->base);
+}
+
+static const qgc_frame_tap_frame_info_t* _slot(const qgc_frame_tap_t* tap, uint64_t sequence)
+{
+    const qgc_frame_tap_header_t* header = _header(tap);
+    const size_t index = static_cast<size_t>((sequence - 1) % header->slot_count);
+    return reinterpret_cast<const qgc_frame_tap_frame_info_t*>(tap->base + header->header_size + (index * header->slot_size));
+}
+
+/// Copies the slot header of a frame. Fails if the slot does not hold the requested sequence (any more).
+static int _slotInfo(const qgc_frame_tap_t* tap, uint64_t sequence, qgc_frame_tap_frame_info_t* info, const uint8_t** data)
+{
+    if (tap == nullptr) {
+        return QGC_FRAME_TAP_NO_FRAME;
+    }
+    if (qgc_frame_tap_is_stale(tap)) {
+        return QGC_FRAME_TAP_STALE;
+    }
+
+    const uint64_t latest = qgc_frame_tap_latest_sequence(tap);
+    if (sequence == 0) {
+        sequence = latest;
+    }
+    if ((sequence == 0) || (sequence > latest) || ((latest - sequence) >= _header(tap)->slot_count)) {
+        return QGC_FRAME_TAP_NO_FRAME;
+    }
+
+    const qgc_frame_tap_frame_info_t* slot = _slot(tap, sequence);
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != sequence) {
+        return QGC_FRAME_TAP_OVERWRITTEN;
+    }
+
+    (void) memcpy(info, slot, sizeof(*info));
+    info->sequence = sequence;
+    *data = reinterpret_cast<const uint8_t*>(slot) + QGC_FRAME_TAP_ALIGNMENT;
+
+    if ((info->data_size > (_header(tap)->slot_size - QGC_FRAME_TAP_ALIGNMENT)) || !qgc_frame_tap_frame_valid(tap, info)) {
+        return QGC_FRAME_TAP_OVERWRITTEN;
+    }
+
+    return QGC_FRAME_TAP_OK;
+}
+
+qgc_frame_tap_t* qgc_frame_tap_open(const char* name)
+{
+    const int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (static_cast<size_t>(st.st_size) < sizeof(qgc_frame_tap_header_t))) {
+        (void) close(fd);
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* const base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    (void) close(fd);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+
+    const qgc_frame_tap_header_t* header = static_cast<const qgc_frame_tap_header_t*>(base);
+    if ((header->magic != QGC_FRAME_TAP_MAGIC) ||
+            (header->version != QGC_FRAME_TAP_VERSION) ||
+            (header->slot_count == 0) ||
+            (header->slot_size <= QGC_FRAME_TAP_ALIGNMENT) ||
+            ((header->header_size + (static_cast<size_t>(header->slot_count) * header->slot_size)) > size)) {
+        (void) munmap(base, size);
+        return nullptr;
+    }
+
+    qgc_frame_tap_t* tap = new (std::nothrow) qgc_frame_tap_t;
+    if (tap == nullptr) {
+        (void) munmap(base, size);
+        return nullptr;
+    }
+
+    tap->base = static_cast<uint8_t*>(base);
+    tap->size = size;
+
+    return tap;
+}
+
+void qgc_frame_tap_close(qgc_frame_tap_t* tap)
+{
+    if (tap == nullptr) {
+        return;
+    }
+
+    (void) munmap(tap->base, tap->size);
+    delete tap;
+}
+
+int qgc_frame_tap_is_stale(const qgc_frame_tap_t* tap)
+{
+    return (tap == nullptr) || (__atomic_load_n(&_header(tap)->closed, __ATOMIC_ACQUIRE) != 0);
+}
+
+uint64_t qgc_frame_tap_latest_sequence(const qgc_frame_tap_t* tap)
+{
+    if (tap == nullptr) {
+        return 0;
+    }
+
+    return __atomic_load_n(&_header(tap)->sequence, __ATOMIC_ACQUIRE);
+}
+
+const uint8_t* qgc_frame_tap_peek(qgc_frame_tap_t* tap, uint64_t sequence, qgc_frame_tap_frame_info_t* info)
+{
+    const uint8_t* data = nullptr;
+    if (_slotInfo(tap, sequence, info, &data) != QGC_FRAME_TAP_OK) {
+        return nullptr;
+    }
+
+    return data;
+}
+
+int qgc_frame_tap_frame_valid(const qgc_frame_tap_t* tap, const qgc_frame_tap_frame_info_t* info)
+{
+    if ((tap == nullptr) || (info->sequence == 0)) {
+        return 0;
+    }
+
+    // Order all preceding reads of the slot before re-checking its sequence
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&_slot(tap, info->sequence)->sequence, __ATOMIC_RELAXED) == info->sequence;
+}
+
+int qgc_frame_tap_read(qgc_frame_tap_t* tap, uint64_t sequence, qgc_frame_tap_frame_info_t* info, uint8_t* buffer, size_t size)
+{
+    const uint8_t* data = nullptr;
+    const int result = _slotInfo(tap, sequence, info, &data);
+    if (result != QGC_FRAME_TAP_OK) {
+        return result;
+    }
+
+    if (size < info->data_size) {
+        return QGC_FRAME_TAP_BUFFER_TOO_SMALL;
+    }
+
+    (void) memcpy(buffer, data, info->data_size);
+
+    return qgc_frame_tap_frame_valid(tap, info) ? QGC_FRAME_TAP_OK : QGC_FRAME_TAP_OVERWRITTEN;
+}
@@ -0,0 +1,131 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+/**
+ * @file
+ *   @brief Reader API for the decoded video frames QGC publishes to POSIX shared memory.
+ *
+ * When "Share Decoded Video Frames" is enabled QGC decodes each video stream a second time into RGBA
+ * and writes the frames into a fixed size ring of slots in the shared memory object "/qgc_video<N>".
+ * The writer never waits for readers: it always overwrites the oldest slot. Each slot is guarded by a
+ * sequence number, so a reader can either copy a frame (qgc_frame_tap_read) or process it in place
+ * (qgc_frame_tap_peek) and check afterwards that it was not overwritten meanwhile (qgc_frame_tap_frame_valid).
+ *
+ * This header and VideoFrameTap.cc only depend on POSIX shared memory and can be copied into other projects.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QGC_FRAME_TAP_MAGIC         0x50415446u     /* "FTAP" */
+#define QGC_FRAME_TAP_VERSION       1u
+#define QGC_FRAME_TAP_FORMAT_RGBA   0x41424752u     /* fourcc 'RGBA' */
+#define QGC_FRAME_TAP_ALIGNMENT     64u
+
+/* Return codes */
+#define QGC_FRAME_TAP_OK                0
+#define QGC_FRAME_TAP_NO_FRAME          -1  /* No frame published yet or requested sequence not available */
+#define QGC_FRAME_TAP_OVERWRITTEN       -2  /* Writer reused the slot while it was read */
+#define QGC_FRAME_TAP_BUFFER_TOO_SMALL  -3
+#define QGC_FRAME_TAP_STALE             -4  /* Writer abandoned the segment, close and open again */
+
+/* Placed at offset 0 of the shared memory object */
+typedef struct qgc_frame_tap_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;         /* Bytes per slot, slot header included */
+    uint32_t header_size;       /* Offset of the first slot */
+    uint32_t closed;            /* Non zero once the writer abandoned this segment */
+    uint64_t sequence;          /* Sequence of the latest complete frame, 0 before the first one */
+} qgc_frame_tap_header_t;
+
+/* Placed at the start of every slot, pixel data follows at QGC_FRAME_TAP_ALIGNMENT */
+typedef struct qgc_frame_tap_frame_info {
+    uint64_t sequence;          /* Frame sequence, 0 while the slot is being written */
+    uint64_t pts_ns;            /* Presentation timestamp of the frame in the stream */
+    uint64_t capture_time_us;   /* CLOCK_MONOTONIC when the frame was published */
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;            /* Bytes per row */
+    uint32_t format;            /* QGC_FRAME_TAP_FORMAT_* */
+    uint32_t data_size;
+    uint32_t reserved;
+    float    roll;              /* Vehicle attitude when the frame was published, degrees */
+    float    pitch;
+    float    yaw;
+    float    reserved2;
+} qgc_frame_tap_frame_info_t;
+
+typedef struct qgc_frame_tap qgc_frame_tap_t;
+
+/* Maps the named segment read only. Returns NULL if it does not exist (yet) or is not a frame tap. */
+qgc_frame_tap_t* qgc_frame_tap_open(const char* name);
+void qgc_frame_tap_close(qgc_frame_tap_t* tap);
+
+/* Non zero once the writer abandoned the segment, for example because the frame size grew. */
+int qgc_frame_tap_is_stale(const qgc_frame_tap_t* tap);
+
+/* Sequence of the latest complete frame, 0 if none was published yet. */
+uint64_t qgc_frame_tap_latest_sequence(const qgc_frame_tap_t* tap);
+
+/* Returns a pointer to the pixel data of a frame inside the shared memory, without copying it. A sequence
+ * of 0 selects the latest frame. The data may be overwritten at any time, so call
+ * qgc_frame_tap_frame_valid() with the returned info once done with it. Returns NULL if not available. */
+const uint8_t* qgc_frame_tap_peek(qgc_frame_tap_t* tap, uint64_t sequence, qgc_frame_tap_frame_info_t* info);
+
+/* Non zero if the frame described by info is still intact in its slot. */
+int qgc_frame_tap_frame_valid(const qgc_frame_tap_t* tap, const qgc_frame_tap_frame_info_t* info);
+
+/* Copies a frame into buffer. A sequence of 0 selects the latest frame. Returns a QGC_FRAME_TAP_* code. */
+int qgc_frame_tap_read(qgc_frame_tap_t* tap, uint64_t sequence, qgc_frame_tap_frame_info_t* info, uint8_t* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+
+#include <vector>
+
+/// RAII wrapper of the C reader API
+class VideoFrameTapReader
+{
+public:
+    explicit VideoFrameTapReader(const char* name) : _tap(qgc_frame_tap_open(name)) {}
+    ~VideoFrameTapReader() { qgc_frame_tap_close(_tap); }
+
+    VideoFrameTapReader(const VideoFrameTapReader&) = delete;
+    VideoFrameTapReader& operator=(const VideoFrameTapReader&) = delete;
+
+    bool isOpen() const { return _tap != nullptr; }
+    bool isStale() const { return qgc_frame_tap_is_stale(_tap) != 0; }
+    uint64_t latestSequence() const { return qgc_frame_tap_latest_sequence(_tap); }
+
+    const uint8_t* peek(qgc_frame_tap_frame_info_t& info, uint64_t sequence = 0) { return qgc_frame_tap_peek(_tap, sequence, &info); }
+    bool frameValid(const qgc_frame_tap_frame_info_t& info) const { return qgc_frame_tap_frame_valid(_tap, &info) != 0; }
+
+    /// Copies a frame, growing buffer as needed
+    int read(qgc_frame_tap_frame_info_t& info, std::vector<uint8_t>& buffer, uint64_t sequence = 0)
+    {
+        int result = qgc_frame_tap_read(_tap, sequence, &info, buffer.data(), buffer.size());
+        if (result == QGC_FRAME_TAP_BUFFER_TOO_SMALL) {
+            buffer.resize(info.data_size);
+            result = qgc_frame_tap_read(_tap, sequence, &info, buffer.data(), buffer.size());
+        }
+        return result;
+    }
+
+private:
+    qgc_frame_tap_t* _tap;
+};
+#endif
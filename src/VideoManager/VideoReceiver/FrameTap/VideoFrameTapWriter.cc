@@ -0,0 +1,180 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VideoFrameTapWriter.h"
+#include "QGCLoggingCategory.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+QGC_LOGGING_CATEGORY(VideoFrameTapLog, "qgc.videomanager.videoreceiver.videoframetap")
+
+static_assert(sizeof(qgc_frame_tap_header_t) <= QGC_FRAME_TAP_ALIGNMENT, "frame tap header does not fit its alignment");
+static_assert(sizeof(qgc_frame_tap_frame_info_t) <= QGC_FRAME_TAP_ALIGNMENT, "frame tap slot header does not fit its alignment");
+
+static size_t _align(size_t size)
+{
+    return (size + QGC_FRAME_TAP_ALIGNMENT - 1) & ~static_cast<size_t>(QGC_FRAME_TAP_ALIGNMENT - 1);
+}
+
+/// Marks a segment left behind by a previous writer as closed, so its readers reopen, and removes its name
+static void _abandonExisting(const QByteArray& name)
+{
+    const int fd = shm_open(name.constData(), O_RDWR, 0);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st;
+    if ((fstat(fd, &st) == 0) && (static_cast<size_t>(st.st_size) >= sizeof(qgc_frame_tap_header_t))) {
+        void* const base = mmap(nullptr, sizeof(qgc_frame_tap_header_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base != MAP_FAILED) {
+            qgc_frame_tap_header_t* header = static_cast<qgc_frame_tap_header_t*>(base);
+            if (header->magic == QGC_FRAME_TAP_MAGIC) {
+                __atomic_store_n(&header->closed, 1u, __ATOMIC_RELEASE);
+            }
+            (void) munmap(base, sizeof(qgc_frame_tap_header_t));
+        }
+    }
+
+    (void) close(fd);
+    (void) shm_unlink(name.constData());
+}
+
+VideoFrameTapWriter::VideoFrameTapWriter(const QString& name, uint32_t slotCount)
+    : _name(name)
+    , _slotCount(qMax(slotCount, 2u))
+{
+    qCDebug(VideoFrameTapLog) << "Frame tap" << _name << "slots" << _slotCount;
+}
+
+VideoFrameTapWriter::~VideoFrameTapWriter()
+{
+    _destroy();
+}
+
+bool VideoFrameTapWriter::writeFrame(const Frame_t& frame)
+{
+    if ((frame.data == nullptr) || (frame.size == 0)) {
+        return false;
+    }
+
+    if ((_base == nullptr) || (frame.size > (_slotSize - QGC_FRAME_TAP_ALIGNMENT))) {
+        if (_failed) {
+            return false;
+        }
+
+        _destroy();
+        if (!_create(frame.size)) {
+            _failed = true;
+            return false;
+        }
+    }
+
+    qgc_frame_tap_header_t* header = reinterpret_cast<qgc_frame_tap_header_t*>(_base);
+    const uint64_t sequence = ++_sequence;
+    const size_t index = static_cast<size_t>((sequence - 1) % _slotCount);
+    uint8_t* const slot = _base + header->header_size + (index * _slotSize);
+    qgc_frame_tap_frame_info_t* info = reinterpret_cast<qgc_frame_tap_frame_info_t*>(slot);
+
+    // Invalidate the slot before touching its contents, readers holding the old sequence detect the overwrite
+    __atomic_store_n(&info->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    struct timespec now;
+    (void) clock_gettime(CLOCK_MONOTONIC, &now);
+
+    info->pts_ns = frame.ptsNs;
+    info->capture_time_us = (static_cast<uint64_t>(now.tv_sec) * 1000000) + (static_cast<uint64_t>(now.tv_nsec) / 1000);
+    info->width = frame.width;
+    info->height = frame.height;
+    info->stride = frame.stride;
+    info->format = frame.format;
+    info->data_size = static_cast<uint32_t>(frame.size);
+    info->roll = frame.roll;
+    info->pitch = frame.pitch;
+    info->yaw = frame.yaw;
+    (void) memcpy(slot + QGC_FRAME_TAP_ALIGNMENT, frame.data, frame.size);
+
+    __atomic_store_n(&info->sequence, sequence, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->sequence, sequence, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool VideoFrameTapWriter::_create(size_t dataSize)
+{
+    const QByteArray name = _name.toLocal8Bit();
+
+    _abandonExisting(name);
+
+    const int fd = shm_open(name.constData(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        qCWarning(VideoFrameTapLog) << "shm_open failed" << _name << strerror(errno);
+        return false;
+    }
+
+    _slotSize = static_cast<uint32_t>(_align(QGC_FRAME_TAP_ALIGNMENT + dataSize));
+    _size = QGC_FRAME_TAP_ALIGNMENT + (static_cast<size_t>(_slotCount) * _slotSize);
+
+    if (ftruncate(fd, static_cast<off_t>(_size)) != 0) {
+        qCWarning(VideoFrameTapLog) << "ftruncate failed" << _name << _size << strerror(errno);
+        (void) close(fd);
+        (void) shm_unlink(name.constData());
+        return false;
+    }
+
+    void* const base = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void) close(fd);
+    if (base == MAP_FAILED) {
+        qCWarning(VideoFrameTapLog) << "mmap failed" << _name << _size << strerror(errno);
+        (void) shm_unlink(name.constData());
+        return false;
+    }
+
+    _base = static_cast<uint8_t*>(base);
+
+    // ftruncate zero fills, so every slot starts out invalid
+    qgc_frame_tap_header_t* header = reinterpret_cast<qgc_frame_tap_header_t*>(_base);
+    header->version = QGC_FRAME_TAP_VERSION;
+    header->slot_count = _slotCount;
+    header->slot_size = _slotSize;
+    header->header_size = QGC_FRAME_TAP_ALIGNMENT;
+    header->closed = 0;
+    header->sequence = 0;
+    __atomic_store_n(&header->magic, QGC_FRAME_TAP_MAGIC, __ATOMIC_RELEASE);
+
+    _sequence = 0;
+
+    qCDebug(VideoFrameTapLog) << "Created frame tap" << _name << "slot size" << _slotSize << "total" << _size;
+
+    return true;
+}
+
+void VideoFrameTapWriter::_destroy()
+{
+    if (_base == nullptr) {
+        return;
+    }
+
+    qgc_frame_tap_header_t* header = reinterpret_cast<qgc_frame_tap_header_t*>(_base);
+    __atomic_store_n(&header->closed, 1u, __ATOMIC_RELEASE);
+
+    (void) munmap(_base, _size);
+    (void) shm_unlink(_name.toLocal8Bit().constData());
+
+    _base = nullptr;
+    _size = 0;
+    _slotSize = 0;
+}
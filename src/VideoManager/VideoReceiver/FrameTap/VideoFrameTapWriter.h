@@ -0,0 +1,62 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QString>
+
+#include "VideoFrameTap.h"
+
+Q_DECLARE_LOGGING_CATEGORY(VideoFrameTapLog)
+
+/// Publishes decoded frames into the POSIX shared memory ring described in VideoFrameTap.h.
+/// Memory use is bounded to slotCount frames. Publishing never blocks: the oldest slot is always
+/// overwritten. The segment is (re)created on the first frame and whenever a frame no longer fits.
+class VideoFrameTapWriter
+{
+public:
+    struct Frame_t {
+        const uint8_t*  data = nullptr;
+        size_t          size = 0;
+        uint32_t        width = 0;
+        uint32_t        height = 0;
+        uint32_t        stride = 0;
+        uint32_t        format = QGC_FRAME_TAP_FORMAT_RGBA;
+        uint64_t        ptsNs = 0;
+        float           roll = 0;
+        float           pitch = 0;
+        float           yaw = 0;
+    };
+
+    explicit VideoFrameTapWriter(const QString& name, uint32_t slotCount = kDefaultSlotCount);
+    ~VideoFrameTapWriter();
+
+    VideoFrameTapWriter(const VideoFrameTapWriter&) = delete;
+    VideoFrameTapWriter& operator=(const VideoFrameTapWriter&) = delete;
+
+    const QString& name() const { return _name; }
+
+    /// Must only be called from one thread at a time
+    bool writeFrame(const Frame_t& frame);
+
+    static constexpr uint32_t kDefaultSlotCount = 4;
+
+private:
+    bool _create(size_t dataSize);
+    void _destroy();
+
+    QString     _name;
+    uint32_t    _slotCount;
+    uint8_t*    _base = nullptr;
+    size_t      _size = 0;
+    uint32_t    _slotSize = 0;
+    uint64_t    _sequence = 0;
+    bool        _failed = false;
+};
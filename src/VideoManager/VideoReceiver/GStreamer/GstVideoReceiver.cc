@@ -16,6 +16,9 @@
 
 #include "GstVideoReceiver.h"
 #include "QGCLoggingCategory.h"
+#ifdef QGC_VIDEO_FRAME_TAP
+#include "VideoFrameTapWriter.h"
+#endif
 
 #include <QtCore/QDebug>
 #include <QtCore/QUrl>
@@ -31,6 +34,11 @@ QGC_LOGGING_CATEGORY(VideoReceiverLog, "VideoReceiverLog")
 // _source-->_tee
 //              |
 //              +-->queue-->_recorderValve[-->_fileSink]
+//              |
+//              +-->queue(leaky)-->_frameTapSink       (only if a frame tap name is set)
+//
+// Frame timing is sampled by pad probes on the parser sink pad inside _source,
+// the _tee sink pad, the _decoderValve src pad and the _videoSink sink pad.
 //
 
 GstVideoReceiver::GstVideoReceiver(QObject* parent)
@@ -139,6 +147,15 @@ GstVideoReceiver::start(const QString& uri, unsigned timeout, int buffer)
 
         g_object_set(_decoderValve, "drop", TRUE, nullptr);
 
+        if ((pad = gst_element_get_static_pad(_decoderValve, "src")) == nullptr) {
+            qCCritical(VideoReceiverLog) << "gst_element_get_static_pad() failed";
+            break;
+        }
+
+        _decoderProbeId = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, _decoderProbe, this, nullptr);
+        gst_object_unref(pad);
+        pad = nullptr;
+
         if((recorderQueue = gst_element_factory_make("queue", nullptr)) == nullptr)  {
             qCCritical(VideoReceiverLog) << "gst_element_factory_make('queue') failed";
             break;
@@ -163,6 +180,21 @@ GstVideoReceiver::start(const QString& uri, unsigned timeout, int buffer)
             break;
         }
 
+        _frameStats.reset();
+
+        GstElement* parser;
+
+        if ((parser = gst_bin_get_by_name(GST_BIN(_source), "parser")) != nullptr) {
+            if ((pad = gst_element_get_static_pad(parser, "sink")) != nullptr) {
+                _sourceProbeId = gst_pad_add_probe(pad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST), _sourceProbe, this, nullptr);
+                gst_object_unref(pad);
+                pad = nullptr;
+            }
+
+            gst_object_unref(parser);
+            parser = nullptr;
+        }
+
         gst_bin_add_many(GST_BIN(_pipeline), _source, _tee, decoderQueue, _decoderValve, recorderQueue, _recorderValve, nullptr);
 
         pipelineUp = true;
@@ -202,6 +234,11 @@ GstVideoReceiver::start(const QString& uri, unsigned timeout, int buffer)
             break;
         }
 
+        // The frame tap is optional, streaming goes on without it
+        if (!_frameTapName.isEmpty() && !_addFrameTap()) {
+            qCWarning(VideoReceiverLog) << "Unable to add frame tap" << _frameTapName;
+        }
+
         GstBus* bus = nullptr;
 
         if ((bus = gst_pipeline_get_bus(GST_PIPELINE(_pipeline))) != nullptr) {
@@ -225,6 +262,8 @@ GstVideoReceiver::start(const QString& uri, unsigned timeout, int buffer)
             _pipeline = nullptr;
         }
 
+        _removeFrameTap();
+
         // If we failed before adding items to the pipeline, then clean up
         if (!pipelineUp) {
             if (_recorderValve != nullptr) {
@@ -265,6 +304,10 @@ GstVideoReceiver::start(const QString& uri, unsigned timeout, int buffer)
         GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(_pipeline), GST_DEBUG_GRAPH_SHOW_ALL, "pipeline-started");
         qCDebug(VideoReceiverLog) << "Started" << _uri;
 
+        if (!_frameStatsLogFile.isEmpty()) {
+            _frameStats.openLog(_frameStatsLogFile);
+        }
+
         _dispatchSignal([this](){
             emit onStartComplete(STATUS_OK);
         });
@@ -297,6 +340,31 @@ GstVideoReceiver::stop(void)
         _teeProbeId = 0;
     }
 
+    if (_decoderProbeId != 0) {
+        GstPad* srcpad;
+        if ((srcpad = gst_element_get_static_pad(_decoderValve, "src")) != nullptr) {
+            gst_pad_remove_probe(srcpad, _decoderProbeId);
+            gst_object_unref(srcpad);
+            srcpad = nullptr;
+        }
+        _decoderProbeId = 0;
+    }
+
+    if (_sourceProbeId != 0) {
+        GstElement* parser;
+        if ((parser = gst_bin_get_by_name(GST_BIN(_source), "parser")) != nullptr) {
+            GstPad* sinkpad;
+            if ((sinkpad = gst_element_get_static_pad(parser, "sink")) != nullptr) {
+                gst_pad_remove_probe(sinkpad, _sourceProbeId);
+                gst_object_unref(sinkpad);
+                sinkpad = nullptr;
+            }
+            gst_object_unref(parser);
+            parser = nullptr;
+        }
+        _sourceProbeId = 0;
+    }
+
     if (_pipeline != nullptr) {
         GstBus* bus;
 
@@ -355,13 +423,18 @@ GstVideoReceiver::stop(void)
         _tee = nullptr;
         _source = nullptr;
 
+        _removeFrameTap();
+
         _lastSourceFrameTime = 0;
 
+        _frameStats.closeLog();
+
         if (_streaming) {
             _streaming = false;
             qCDebug(VideoReceiverLog) << "Streaming stopped" << _uri;
             _dispatchSignal([this](){
                 emit streamingChanged(_streaming);
+                emit frameStatsChanged(VideoFrameStats());
             });
         } else {
             qCDebug(VideoReceiverLog) << "Streaming did not start" << _uri;
@@ -628,6 +701,58 @@ GstVideoReceiver::takeScreenshot(const QString& imageFile)
     });
 }
 
+void
+GstVideoReceiver::setFrameStatsLogFile(const QString& logFile)
+{
+    if (_needDispatch()) {
+        QString cachedLogFile = logFile;
+        _slotHandler.dispatch([this, cachedLogFile]() {
+            setFrameStatsLogFile(cachedLogFile);
+        });
+        return;
+    }
+
+    if (logFile == _frameStatsLogFile) {
+        return;
+    }
+
+    _frameStatsLogFile = logFile;
+
+    if (_pipeline == nullptr) {
+        return;
+    }
+
+    if (_frameStatsLogFile.isEmpty()) {
+        _frameStats.closeLog();
+    } else {
+        _frameStats.openLog(_frameStatsLogFile);
+    }
+}
+
+void
+GstVideoReceiver::setFrameTapName(const QString& name)
+{
+    if (_needDispatch()) {
+        QString cachedName = name;
+        _slotHandler.dispatch([this, cachedName]() {
+            setFrameTapName(cachedName);
+        });
+        return;
+    }
+
+    _frameTapName = name;
+}
+
+void
+GstVideoReceiver::setVehicleAttitude(float roll, float pitch, float yaw)
+{
+    // Called at telemetry rate from the main thread, read from the frame tap streaming thread
+    QMutexLocker lock(&_frameTapAttitudeSync);
+    _frameTapRoll = roll;
+    _frameTapPitch = pitch;
+    _frameTapYaw = yaw;
+}
+
 const char* GstVideoReceiver::_kFileMux[FILE_FORMAT_MAX - FILE_FORMAT_MIN] = {
     "matroskamux",
     "qtmux",
@@ -644,6 +769,14 @@ GstVideoReceiver::_watchdog(void)
 
         const qint64 now = QDateTime::currentSecsSinceEpoch();
 
+        if (_streaming) {
+            const VideoFrameStats stats = _frameStats.snapshot(g_get_monotonic_time());
+            _frameStats.flushLog();
+            _dispatchSignal([this, stats](){
+                emit frameStatsChanged(stats);
+            });
+        }
+
         if (_lastSourceFrameTime == 0) {
             _lastSourceFrameTime = now;
         }
@@ -1013,6 +1146,117 @@ GstVideoReceiver::_makeFileSink(const QString& videoFile, FILE_FORMAT format)
     return fileSink;
 }
 
+GstElement*
+GstVideoReceiver::_makeFrameTapSink(void)
+{
+    GstElement* frameTapSink = nullptr;
+    GstElement* decoder = nullptr;
+    GstElement* convert = nullptr;
+    GstElement* filter = nullptr;
+    GstElement* sink = nullptr;
+    GstElement* bin = nullptr;
+    bool releaseElements = true;
+
+    do {
+        if ((decoder = _makeDecoder()) == nullptr) {
+            qCCritical(VideoReceiverLog) << "_makeDecoder() failed";
+            break;
+        }
+
+        if ((convert = gst_element_factory_make("videoconvert", nullptr)) == nullptr) {
+            qCCritical(VideoReceiverLog) << "gst_element_factory_make('videoconvert') failed";
+            break;
+        }
+
+        if ((filter = gst_element_factory_make("capsfilter", nullptr)) == nullptr) {
+            qCCritical(VideoReceiverLog) << "gst_element_factory_make('capsfilter') failed";
+            break;
+        }
+
+        GstCaps* caps;
+
+        if ((caps = gst_caps_from_string("video/x-raw, format=(string)RGBA")) == nullptr) {
+            qCCritical(VideoReceiverLog) << "gst_caps_from_string() failed";
+            break;
+        }
+
+        g_object_set(filter, "caps", caps, nullptr);
+        gst_caps_unref(caps);
+        caps = nullptr;
+
+        if ((sink = gst_element_factory_make("appsink", nullptr)) == nullptr) {
+            qCCritical(VideoReceiverLog) << "gst_element_factory_make('appsink') failed";
+            break;
+        }
+
+        // Keep only the newest frame and never hold up the pipeline
+        g_object_set(sink, "emit-signals", TRUE, "sync", FALSE, "async", FALSE, "max-buffers", 1, "drop", TRUE, nullptr);
+        g_signal_connect(sink, "new-sample", G_CALLBACK(_onFrameTapSample), this);
+
+        if ((bin = gst_bin_new("frametapbin")) == nullptr) {
+            qCCritical(VideoReceiverLog) << "gst_bin_new('frametapbin') failed";
+            break;
+        }
+
+        gst_bin_add_many(GST_BIN(bin), decoder, convert, filter, sink, nullptr);
+
+        releaseElements = false;
+
+        if (!gst_element_link_many(convert, filter, sink, nullptr)) {
+            qCCritical(VideoReceiverLog) << "gst_element_link_many() failed";
+            break;
+        }
+
+        g_signal_connect(decoder, "pad-added", G_CALLBACK(_linkPad), convert);
+
+        GstPad* pad;
+
+        if ((pad = gst_element_get_static_pad(decoder, "sink")) == nullptr) {
+            qCCritical(VideoReceiverLog) << "gst_element_get_static_pad() failed";
+            break;
+        }
+
+        GstPad* ghostpad = gst_ghost_pad_new("sink", pad);
+
+        gst_element_add_pad(bin, ghostpad);
+
+        gst_object_unref(pad);
+        pad = nullptr;
+
+        frameTapSink = bin;
+        bin = nullptr;
+    } while(0);
+
+    if (releaseElements) {
+        if (sink != nullptr) {
+            gst_object_unref(sink);
+            sink = nullptr;
+        }
+
+        if (filter != nullptr) {
+            gst_object_unref(filter);
+            filter = nullptr;
+        }
+
+        if (convert != nullptr) {
+            gst_object_unref(convert);
+            convert = nullptr;
+        }
+
+        if (decoder != nullptr) {
+            gst_object_unref(decoder);
+            decoder = nullptr;
+        }
+    }
+
+    if (bin != nullptr) {
+        gst_object_unref(bin);
+        bin = nullptr;
+    }
+
+    return frameTapSink;
+}
+
 void
 GstVideoReceiver::_onNewSourcePad(GstPad* pad)
 {
@@ -1184,6 +1428,75 @@ GstVideoReceiver::_addVideoSink(GstPad* pad)
     return true;
 }
 
+bool
+GstVideoReceiver::_addFrameTap(void)
+{
+#ifdef QGC_VIDEO_FRAME_TAP
+    GstElement* queue;
+
+    if ((queue = gst_element_factory_make("queue", nullptr)) == nullptr) {
+        qCCritical(VideoReceiverLog) << "gst_element_factory_make('queue') failed";
+        return false;
+    }
+
+    // Leak downstream so a tap decoder slower than real time never blocks the tee, and with it the display and the
+    // recorder. A leaked frame breaks the frames that refer to it, so the tap waits for the next keyframe afterwards.
+    g_object_set(queue, "leaky", 2, "max-size-buffers", 3, "max-size-bytes", 0, "max-size-time", (guint64)0, nullptr);
+    g_signal_connect(queue, "overrun", G_CALLBACK(_onFrameTapOverrun), this);
+
+    _frameTapWaitKeyframe = true;
+
+    GstPad* queueSrcPad;
+
+    if ((queueSrcPad = gst_element_get_static_pad(queue, "src")) == nullptr) {
+        qCCritical(VideoReceiverLog) << "gst_element_get_static_pad() failed";
+        gst_object_unref(queue);
+        return false;
+    }
+
+    gst_pad_add_probe(queueSrcPad, GST_PAD_PROBE_TYPE_BUFFER, _frameTapKeyframeProbe, this, nullptr);
+    gst_object_unref(queueSrcPad);
+    queueSrcPad = nullptr;
+
+    if ((_frameTapSink = _makeFrameTapSink()) == nullptr) {
+        qCCritical(VideoReceiverLog) << "_makeFrameTapSink() failed";
+        gst_object_unref(queue);
+        return false;
+    }
+
+    _frameTap = new VideoFrameTapWriter(_frameTapName);
+
+    gst_bin_add_many(GST_BIN(_pipeline), queue, _frameTapSink, nullptr);
+
+    if (!gst_element_link_many(_tee, queue, _frameTapSink, nullptr)) {
+        qCCritical(VideoReceiverLog) << "Unable to link frame tap";
+        gst_bin_remove_many(GST_BIN(_pipeline), queue, _frameTapSink, nullptr);
+        _frameTapSink = nullptr;
+        _removeFrameTap();
+        return false;
+    }
+
+    qCDebug(VideoReceiverLog) << "Frame tap added" << _frameTapName;
+
+    return true;
+#else
+    qCWarning(VideoReceiverLog) << "Frame tap is not supported on this platform";
+    return false;
+#endif
+}
+
+void
+GstVideoReceiver::_removeFrameTap(void)
+{
+    // The branch elements belong to the pipeline, by now it is stopped and no more samples arrive
+    _frameTapSink = nullptr;
+
+#ifdef QGC_VIDEO_FRAME_TAP
+    delete _frameTap;
+#endif
+    _frameTap = nullptr;
+}
+
 void
 GstVideoReceiver::_noteTeeFrame(void)
 {
@@ -1513,14 +1826,51 @@ GstVideoReceiver::_padProbe(GstElement* element, GstPad* pad, gpointer user_data
 }
 
 GstPadProbeReturn
-GstVideoReceiver::_teeProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
+GstVideoReceiver::_sourceProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
 {
     Q_UNUSED(pad)
     Q_UNUSED(info)
 
+    if(user_data != nullptr) {
+        GstVideoReceiver* pThis = static_cast<GstVideoReceiver*>(user_data);
+        pThis->_frameStats.noteSourceBuffer(g_get_monotonic_time());
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn
+GstVideoReceiver::_teeProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
+{
+    Q_UNUSED(pad)
+
     if(user_data != nullptr) {
         GstVideoReceiver* pThis = static_cast<GstVideoReceiver*>(user_data);
         pThis->_noteTeeFrame();
+
+        GstBuffer* buf = gst_pad_probe_info_get_buffer(info);
+
+        if (buf != nullptr && GST_BUFFER_PTS_IS_VALID(buf)) {
+            pThis->_frameStats.noteParsedFrame(GST_BUFFER_PTS(buf), g_get_monotonic_time());
+        }
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn
+GstVideoReceiver::_decoderProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
+{
+    Q_UNUSED(pad)
+
+    if(user_data != nullptr) {
+        GstVideoReceiver* pThis = static_cast<GstVideoReceiver*>(user_data);
+
+        GstBuffer* buf = gst_pad_probe_info_get_buffer(info);
+
+        if (buf != nullptr && GST_BUFFER_PTS_IS_VALID(buf)) {
+            pThis->_frameStats.noteDecoderInput(GST_BUFFER_PTS(buf), g_get_monotonic_time());
+        }
     }
 
     return GST_PAD_PROBE_OK;
@@ -1530,7 +1880,6 @@ GstPadProbeReturn
 GstVideoReceiver::_videoSinkProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
 {
     Q_UNUSED(pad)
-    Q_UNUSED(info)
 
     if(user_data != nullptr) {
         GstVideoReceiver* pThis = static_cast<GstVideoReceiver*>(user_data);
@@ -1563,6 +1912,12 @@ GstVideoReceiver::_videoSinkProbe(GstPad* pad, GstPadProbeInfo* info, gpointer u
         }
 
         pThis->_noteVideoSinkFrame();
+
+        GstBuffer* buf = gst_pad_probe_info_get_buffer(info);
+
+        if (buf != nullptr && GST_BUFFER_PTS_IS_VALID(buf)) {
+            pThis->_frameStats.noteDecodedFrame(GST_BUFFER_PTS(buf), g_get_monotonic_time());
+        }
     }
 
     return GST_PAD_PROBE_OK;
@@ -1613,3 +1968,94 @@ GstVideoReceiver::_keyframeWatch(GstPad* pad, GstPadProbeInfo* info, gpointer us
 
     return GST_PAD_PROBE_REMOVE;
 }
+
+void
+GstVideoReceiver::_onFrameTapOverrun(GstElement* queue, gpointer user_data)
+{
+    Q_UNUSED(queue)
+
+    // Emitted right before the queue leaks its oldest frame
+    GstVideoReceiver* pThis = static_cast<GstVideoReceiver*>(user_data);
+    pThis->_frameTapWaitKeyframe = true;
+}
+
+GstPadProbeReturn
+GstVideoReceiver::_frameTapKeyframeProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
+{
+    Q_UNUSED(pad)
+
+    if (info == nullptr || user_data == nullptr) {
+        qCCritical(VideoReceiverLog) << "Invalid arguments";
+        return GST_PAD_PROBE_DROP;
+    }
+
+    GstVideoReceiver* pThis = static_cast<GstVideoReceiver*>(user_data);
+
+    if (!pThis->_frameTapWaitKeyframe) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer* buf = gst_pad_probe_info_get_buffer(info);
+
+    if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        return GST_PAD_PROBE_DROP;
+    }
+
+    pThis->_frameTapWaitKeyframe = false;
+
+    return GST_PAD_PROBE_OK;
+}
+
+GstFlowReturn
+GstVideoReceiver::_onFrameTapSample(GstElement* sink, gpointer user_data)
+{
+    GstSample* sample = nullptr;
+
+    g_signal_emit_by_name(sink, "pull-sample", &sample);
+
+    if (sample == nullptr) {
+        return GST_FLOW_OK;
+    }
+
+#ifdef QGC_VIDEO_FRAME_TAP
+    GstVideoReceiver* pThis = static_cast<GstVideoReceiver*>(user_data);
+    GstBuffer* buf = gst_sample_get_buffer(sample);
+    GstCaps* caps = gst_sample_get_caps(sample);
+    GstMapInfo map;
+
+    if (pThis->_frameTap != nullptr && buf != nullptr && caps != nullptr && gst_buffer_map(buf, &map, GST_MAP_READ)) {
+        const GstStructure* s = gst_caps_get_structure(caps, 0);
+        gint width = 0;
+        gint height = 0;
+        gst_structure_get_int(s, "width", &width);
+        gst_structure_get_int(s, "height", &height);
+
+        VideoFrameTapWriter::Frame_t frame;
+        frame.data = map.data;
+        frame.size = map.size;
+        frame.width = width;
+        frame.height = height;
+        frame.stride = width * 4;
+        frame.format = QGC_FRAME_TAP_FORMAT_RGBA;
+        frame.ptsNs = GST_BUFFER_PTS_IS_VALID(buf) ? GST_BUFFER_PTS(buf) : 0;
+
+        pThis->_frameTapAttitudeSync.lock();
+        frame.roll = pThis->_frameTapRoll;
+        frame.pitch = pThis->_frameTapPitch;
+        frame.yaw = pThis->_frameTapYaw;
+        pThis->_frameTapAttitudeSync.unlock();
+
+        if (width > 0 && height > 0 && map.size >= static_cast<gsize>(frame.stride) * height) {
+            pThis->_frameTap->writeFrame(frame);
+        }
+
+        gst_buffer_unmap(buf, &map);
+    }
+#else
+    Q_UNUSED(user_data)
+#endif
+
+    gst_sample_unref(sample);
+
+    return GST_FLOW_OK;
+}
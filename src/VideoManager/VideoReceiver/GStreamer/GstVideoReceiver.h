@@ -26,8 +26,12 @@
 
 #include <gst/gst.h>
 
+#include <atomic>
+
 Q_DECLARE_LOGGING_CATEGORY(VideoReceiverLog)
 
+class VideoFrameTapWriter;
+
 class Worker : public QThread
 {
     Q_OBJECT
@@ -95,6 +99,9 @@ public slots:
     virtual void startRecording(const QString& videoFile, FILE_FORMAT format);
     virtual void stopRecording(void);
     virtual void takeScreenshot(const QString& imageFile);
+    virtual void setFrameStatsLogFile(const QString& logFile);
+    virtual void setFrameTapName(const QString& name);
+    virtual void setVehicleAttitude(float roll, float pitch, float yaw);
 
 protected slots:
     virtual void _watchdog(void);
@@ -104,11 +111,14 @@ protected:
     virtual GstElement* _makeSource(const QString& uri);
     virtual GstElement* _makeDecoder(GstCaps* caps = nullptr, GstElement* videoSink = nullptr);
     virtual GstElement* _makeFileSink(const QString& videoFile, FILE_FORMAT format);
+    virtual GstElement* _makeFrameTapSink(void);
 
     virtual void _onNewSourcePad(GstPad* pad);
     virtual void _onNewDecoderPad(GstPad* pad);
     virtual bool _addDecoder(GstElement* src);
     virtual bool _addVideoSink(GstPad* pad);
+    virtual bool _addFrameTap(void);
+    virtual void _removeFrameTap(void);
     virtual void _noteTeeFrame(void);
     virtual void _noteVideoSinkFrame(void);
     virtual void _noteEndOfStream(void);
@@ -125,10 +135,15 @@ protected:
     static void _linkPad(GstElement* element, GstPad* pad, gpointer data);
     static gboolean _padProbe(GstElement* element, GstPad* pad, gpointer user_data);
     static gboolean _filterParserCaps(GstElement* bin, GstPad* pad, GstElement* element, GstQuery* query, gpointer data);
+    static GstPadProbeReturn _sourceProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
     static GstPadProbeReturn _teeProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+    static GstPadProbeReturn _decoderProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
     static GstPadProbeReturn _videoSinkProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
     static GstPadProbeReturn _eosProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
     static GstPadProbeReturn _keyframeWatch(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+    static GstFlowReturn _onFrameTapSample(GstElement* sink, gpointer user_data);
+    static void _onFrameTapOverrun(GstElement* queue, gpointer user_data);
+    static GstPadProbeReturn _frameTapKeyframeProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
 
     bool                _streaming;
     bool                _decoding;
@@ -150,6 +165,22 @@ protected:
     gulong              _videoSinkProbeId = 0;
 
     gulong              _teeProbeId = 0;
+    gulong              _sourceProbeId = 0;
+    gulong              _decoderProbeId = 0;
+
+    //-- Frame timing, fed by the source, tee, decoder and video sink probes
+    VideoFrameStatsCollector _frameStats;
+    QString             _frameStatsLogFile;
+
+    //-- Optional shared memory branch: _tee-->queue-->_frameTapSink
+    QString             _frameTapName;
+    GstElement*         _frameTapSink = nullptr;
+    VideoFrameTapWriter* _frameTap = nullptr;
+    std::atomic<bool>   _frameTapWaitKeyframe = true;   ///< Set when the tap queue leaked a frame, delta frames are dropped until the next keyframe
+    QMutex              _frameTapAttitudeSync;
+    float               _frameTapRoll = 0;
+    float               _frameTapPitch = 0;
+    float               _frameTapYaw = 0;
 
     QTimer              _watchdogTimer;
 
@@ -0,0 +1,271 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VideoFrameStats.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+QGC_LOGGING_CATEGORY(VideoFrameStatsLog, "qgc.videomanager.videoreceiver.videoframestats")
+
+VideoFrameStatsCollector::VideoFrameStatsCollector()
+{
+    reset();
+}
+
+VideoFrameStatsCollector::~VideoFrameStatsCollector()
+{
+    closeLog();
+}
+
+void VideoFrameStatsCollector::reset()
+{
+    QMutexLocker lock(&_mutex);
+
+    _frames.clear();
+    _pendingSourceUs = 0;
+
+    _decodeTimes.clear();
+    _decodeTimes.reserve(kDecodeTimeSamples);
+    _decodeTimesIndex = 0;
+
+    _framesDecoded = 0;
+    _framesDropped = 0;
+    _lastDecodedUs = 0;
+    _averageIntervalUs = 0;
+    _jitterHistogram = QList<int>(std::size(kJitterBuckets) + 1, 0);
+
+    _windowFrames = 0;
+    _windowStartUs = 0;
+    _windowParserUs = 0;
+    _windowQueueUs = 0;
+    _windowDecodeUs = 0;
+    _windowTotalUs = 0;
+    _windowJitterUs = 0;
+}
+
+void VideoFrameStatsCollector::noteSourceBuffer(qint64 nowUs)
+{
+    QMutexLocker lock(&_mutex);
+
+    if (_pendingSourceUs == 0) {
+        _pendingSourceUs = nowUs;
+    }
+}
+
+void VideoFrameStatsCollector::noteParsedFrame(quint64 pts, qint64 nowUs)
+{
+    QMutexLocker lock(&_mutex);
+
+    Frame_t &frame = _frames[pts];
+    frame.sourceUs = (_pendingSourceUs != 0) ? _pendingSourceUs : nowUs;
+    frame.parsedUs = nowUs;
+    frame.decoderInUs = 0;
+    _pendingSourceUs = 0;
+
+    _evictFrames();
+}
+
+void VideoFrameStatsCollector::noteDecoderInput(quint64 pts, qint64 nowUs)
+{
+    QMutexLocker lock(&_mutex);
+
+    const auto it = _frames.find(pts);
+    if (it != _frames.end()) {
+        it->decoderInUs = nowUs;
+    }
+}
+
+void VideoFrameStatsCollector::noteDecodedFrame(quint64 pts, qint64 nowUs)
+{
+    QMutexLocker lock(&_mutex);
+
+    _framesDecoded++;
+    _windowFrames++;
+
+    if (_lastDecodedUs != 0) {
+        const double intervalUs = nowUs - _lastDecodedUs;
+        if (_averageIntervalUs == 0) {
+            _averageIntervalUs = intervalUs;
+        }
+
+        const double deviationUs = std::abs(intervalUs - _averageIntervalUs);
+        _averageIntervalUs = (_averageIntervalUs * 0.9) + (intervalUs * 0.1);
+        _windowJitterUs += static_cast<qint64>(deviationUs);
+
+        qsizetype bucket = 0;
+        while ((bucket < static_cast<qsizetype>(std::size(kJitterBuckets))) && (deviationUs > (kJitterBuckets[bucket] * 1000.0))) {
+            bucket++;
+        }
+        _jitterHistogram[bucket]++;
+    }
+    _lastDecodedUs = nowUs;
+
+    const auto it = _frames.find(pts);
+    if ((it == _frames.end()) || (it->decoderInUs == 0)) {
+        return;
+    }
+
+    const Frame_t frame = *it;
+    _frames.erase(it);
+
+    const qint64 decodeUs = nowUs - frame.decoderInUs;
+    _windowParserUs += frame.parsedUs - frame.sourceUs;
+    _windowQueueUs += frame.decoderInUs - frame.parsedUs;
+    _windowDecodeUs += decodeUs;
+    _windowTotalUs += nowUs - frame.sourceUs;
+
+    if (_decodeTimes.count() < kDecodeTimeSamples) {
+        _decodeTimes.append(decodeUs);
+    } else {
+        _decodeTimes[_decodeTimesIndex] = decodeUs;
+        _decodeTimesIndex = (_decodeTimesIndex + 1) % kDecodeTimeSamples;
+    }
+
+    if (_logEnabled) {
+        _logFrame(pts, frame, nowUs);
+    }
+}
+
+VideoFrameStats VideoFrameStatsCollector::snapshot(qint64 nowUs)
+{
+    QMutexLocker lock(&_mutex);
+
+    VideoFrameStats stats;
+
+    stats.valid = (_framesDecoded != 0);
+    stats.framesDecoded = _framesDecoded;
+    stats.framesDropped = _framesDropped;
+    stats.jitterHistogram = _jitterHistogram;
+    for (const int bucket : kJitterBuckets) {
+        stats.jitterBuckets.append(bucket);
+    }
+
+    if ((_windowStartUs != 0) && (nowUs > _windowStartUs)) {
+        stats.fps = (_windowFrames * 1000000.0) / (nowUs - _windowStartUs);
+    }
+
+    if (_windowFrames != 0) {
+        stats.parserLatency = _windowParserUs / (_windowFrames * 1000.0);
+        stats.queueLatency = _windowQueueUs / (_windowFrames * 1000.0);
+        stats.decodeLatency = _windowDecodeUs / (_windowFrames * 1000.0);
+        stats.totalLatency = _windowTotalUs / (_windowFrames * 1000.0);
+        stats.jitter = _windowJitterUs / (_windowFrames * 1000.0);
+    }
+
+    if (!_decodeTimes.isEmpty()) {
+        QList<qint64> sorted = _decodeTimes;
+        std::sort(sorted.begin(), sorted.end());
+
+        const auto percentile = [&sorted](double p) {
+            const qsizetype index = std::clamp<qsizetype>(static_cast<qsizetype>(std::ceil(p * sorted.count())) - 1, 0, sorted.count() - 1);
+            return sorted[index] / 1000.0;
+        };
+        stats.decodeP50 = percentile(0.50);
+        stats.decodeP95 = percentile(0.95);
+        stats.decodeP99 = percentile(0.99);
+    }
+
+    _windowFrames = 0;
+    _windowStartUs = nowUs;
+    _windowParserUs = 0;
+    _windowQueueUs = 0;
+    _windowDecodeUs = 0;
+    _windowTotalUs = 0;
+    _windowJitterUs = 0;
+
+    return stats;
+}
+
+bool VideoFrameStatsCollector::openLog(const QString &fileName)
+{
+    closeLog();
+
+    _logFile.setFileName(fileName);
+    if (!_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qCWarning(VideoFrameStatsLog) << "Unable to open frame timing log" << fileName << _logFile.errorString();
+        return false;
+    }
+
+    if (_logFile.size() == 0) {
+        (void) _logFile.write("pts_ns,source_us,parsed_us,decoder_in_us,decoded_us,parser_ms,queue_ms,decode_ms,total_ms,dropped\n");
+    }
+
+    _mutex.lock();
+    _logEnabled = true;
+    _mutex.unlock();
+
+    qCDebug(VideoFrameStatsLog) << "Logging frame timing to" << fileName;
+
+    return true;
+}
+
+void VideoFrameStatsCollector::closeLog()
+{
+    if (!_logFile.isOpen()) {
+        return;
+    }
+
+    _mutex.lock();
+    _logEnabled = false;
+    _mutex.unlock();
+
+    flushLog();
+    _logFile.close();
+}
+
+void VideoFrameStatsCollector::flushLog()
+{
+    QByteArray rows;
+
+    _mutex.lock();
+    rows.swap(_logRows);
+    _mutex.unlock();
+
+    if (_logFile.isOpen() && !rows.isEmpty()) {
+        (void) _logFile.write(rows);
+        (void) _logFile.flush();
+    }
+}
+
+void VideoFrameStatsCollector::_evictFrames()
+{
+    while (_frames.count() > kMaxPendingFrames) {
+        const auto it = _frames.begin();
+        if (it->decoderInUs != 0) {
+            _framesDropped++;
+            if (_logEnabled) {
+                _logFrame(it.key(), it.value(), 0);
+            }
+        }
+        _frames.erase(it);
+    }
+}
+
+void VideoFrameStatsCollector::_logFrame(quint64 pts, const Frame_t &frame, qint64 decodedUs)
+{
+    _logRows += QByteArray::number(pts) + ',' +
+                QByteArray::number(frame.sourceUs) + ',' +
+                QByteArray::number(frame.parsedUs) + ',' +
+                QByteArray::number(frame.decoderInUs) + ',';
+
+    if (decodedUs != 0) {
+        _logRows += QByteArray::number(decodedUs) + ',' +
+                    QByteArray::number((frame.parsedUs - frame.sourceUs) / 1000.0, 'f', 3) + ',' +
+                    QByteArray::number((frame.decoderInUs - frame.parsedUs) / 1000.0, 'f', 3) + ',' +
+                    QByteArray::number((decodedUs - frame.decoderInUs) / 1000.0, 'f', 3) + ',' +
+                    QByteArray::number((decodedUs - frame.sourceUs) / 1000.0, 'f', 3) + ",0\n";
+    } else {
+        _logRows += ",,,,,1\n";
+    }
+}
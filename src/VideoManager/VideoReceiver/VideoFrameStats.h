@@ -0,0 +1,125 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMap>
+#include <QtCore/QMetaType>
+#include <QtCore/QMutex>
+
+Q_DECLARE_LOGGING_CATEGORY(VideoFrameStatsLog)
+
+/// Snapshot of the frame timing measured inside a video receiver. Latencies are averaged over the
+/// frames decoded since the previous snapshot, the jitter histogram and counters since stream start.
+/// All times are in milliseconds.
+class VideoFrameStats
+{
+    Q_GADGET
+    Q_PROPERTY(bool         valid               MEMBER valid                CONSTANT)
+    Q_PROPERTY(double       fps                 MEMBER fps                  CONSTANT)
+    Q_PROPERTY(quint64      framesDecoded       MEMBER framesDecoded        CONSTANT)
+    Q_PROPERTY(quint64      framesDropped       MEMBER framesDropped        CONSTANT)
+    Q_PROPERTY(double       parserLatency       MEMBER parserLatency        CONSTANT)
+    Q_PROPERTY(double       queueLatency        MEMBER queueLatency         CONSTANT)
+    Q_PROPERTY(double       decodeLatency       MEMBER decodeLatency        CONSTANT)
+    Q_PROPERTY(double       totalLatency        MEMBER totalLatency         CONSTANT)
+    Q_PROPERTY(double       decodeP50           MEMBER decodeP50            CONSTANT)
+    Q_PROPERTY(double       decodeP95           MEMBER decodeP95            CONSTANT)
+    Q_PROPERTY(double       decodeP99           MEMBER decodeP99            CONSTANT)
+    Q_PROPERTY(double       jitter              MEMBER jitter               CONSTANT)
+    Q_PROPERTY(QList<int>   jitterHistogram     MEMBER jitterHistogram      CONSTANT)
+    Q_PROPERTY(QList<int>   jitterBuckets       MEMBER jitterBuckets        CONSTANT)
+
+public:
+    bool        valid = false;          ///< false until the first frame reached the video sink
+    double      fps = 0;                ///< Frames per second at the video sink
+    quint64     framesDecoded = 0;      ///< Frames which reached the video sink
+    quint64     framesDropped = 0;      ///< Frames which entered the decoder but never reached the video sink
+    double      parserLatency = 0;      ///< First source buffer of a frame to parsed frame at the tee
+    double      queueLatency = 0;       ///< Tee to decoder input
+    double      decodeLatency = 0;      ///< Decoder input to video sink
+    double      totalLatency = 0;       ///< First source buffer to video sink
+    double      decodeP50 = 0;
+    double      decodeP95 = 0;
+    double      decodeP99 = 0;
+    double      jitter = 0;             ///< Mean deviation of the video sink frame interval from its running average
+    QList<int>  jitterHistogram;        ///< Frame count per jitterBuckets entry, plus one overflow bucket
+    QList<int>  jitterBuckets;          ///< Upper bound of each histogram bucket
+};
+Q_DECLARE_METATYPE(VideoFrameStats)
+
+/// Collects per frame timestamps from the stages of a video pipeline and reduces them to VideoFrameStats.
+/// Frames are matched between stages by presentation timestamp. The note* methods are called from the
+/// pipeline streaming threads, everything else from the receiver thread. Timestamps are monotonic microseconds.
+class VideoFrameStatsCollector
+{
+public:
+    VideoFrameStatsCollector();
+    ~VideoFrameStatsCollector();
+
+    void reset();
+
+    /// A buffer entered the parser. The first one after a parsed frame marks the start of the next frame.
+    void noteSourceBuffer(qint64 nowUs);
+    void noteParsedFrame(quint64 pts, qint64 nowUs);
+    void noteDecoderInput(quint64 pts, qint64 nowUs);
+    void noteDecodedFrame(quint64 pts, qint64 nowUs);
+
+    VideoFrameStats snapshot(qint64 nowUs);
+
+    /// Opens (appending to) a CSV file which receives one row per frame. Rows are written by flushLog().
+    bool openLog(const QString &fileName);
+    void closeLog();
+    void flushLog();
+    bool logging() const { return _logFile.isOpen(); }
+
+    static constexpr int kJitterBuckets[] = { 1, 2, 5, 10, 20, 50 };
+
+private:
+    struct Frame_t {
+        qint64 sourceUs = 0;
+        qint64 parsedUs = 0;
+        qint64 decoderInUs = 0;
+    };
+
+    void _evictFrames();
+    void _logFrame(quint64 pts, const Frame_t &frame, qint64 decodedUs);
+
+    QMutex _mutex;
+    QMap<quint64, Frame_t> _frames;
+    qint64 _pendingSourceUs = 0;
+
+    QList<qint64> _decodeTimes;
+    int _decodeTimesIndex = 0;
+
+    quint64 _framesDecoded = 0;
+    quint64 _framesDropped = 0;
+    qint64 _lastDecodedUs = 0;
+    double _averageIntervalUs = 0;
+    QList<int> _jitterHistogram;
+
+    quint64 _windowFrames = 0;
+    qint64 _windowStartUs = 0;
+    qint64 _windowParserUs = 0;
+    qint64 _windowQueueUs = 0;
+    qint64 _windowDecodeUs = 0;
+    qint64 _windowTotalUs = 0;
+    qint64 _windowJitterUs = 0;
+
+    QFile _logFile;
+    bool _logEnabled = false;
+    QByteArray _logRows;
+
+    static constexpr int kMaxPendingFrames = 120;
+    static constexpr int kDecodeTimeSamples = 300;
+};
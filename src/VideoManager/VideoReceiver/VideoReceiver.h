@@ -18,6 +18,8 @@
 #include <QtCore/QObject>
 #include <QtCore/QSize>
 
+#include "VideoFrameStats.h"
+
 class VideoReceiver : public QObject
 {
     Q_OBJECT
@@ -54,6 +56,7 @@ signals:
     void recordingChanged(bool active);
     void recordingStarted(void);
     void videoSizeChanged(QSize size);
+    void frameStatsChanged(const VideoFrameStats& stats);
 
     void onStartComplete(STATUS status);
     void onStopComplete(STATUS status);
@@ -75,4 +78,14 @@ public slots:
     virtual void startRecording(const QString& videoFile, FILE_FORMAT format) = 0;
     virtual void stopRecording(void) = 0;
     virtual void takeScreenshot(const QString& imageFile) = 0;
+
+    // Per frame timing is appended to this CSV file while streaming, empty disables it.
+    // Receivers which do not collect frame timing ignore it.
+    virtual void setFrameStatsLogFile(const QString& logFile) { Q_UNUSED(logFile) }
+
+    // Decoded frames are published to this POSIX shared memory object, see VideoFrameTap.h.
+    // Empty disables it. Takes effect on the next start().
+    virtual void setFrameTapName(const QString& name) { Q_UNUSED(name) }
+    // Vehicle attitude in degrees, attached to the frames published through the frame tap
+    virtual void setVehicleAttitude(float roll, float pitch, float yaw) { Q_UNUSED(roll) Q_UNUSED(pitch) Q_UNUSED(yaw) }
 };
@@ -14,6 +14,9 @@
 #include "MultiSignalSpy.h"
 
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QTest>
 
 LogDownloadTest::LogDownloadTest(void)
 {
@@ -22,9 +25,106 @@ LogDownloadTest::LogDownloadTest(void)
 
 void LogDownloadTest::downloadTest(void)
 {
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+    _downloadLog(10000);
+}
+
+void LogDownloadTest::windowTest(void)
+{
+    // 40 bins, the last one short
+    const uint logSize = (39 * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN) + 80;
+    QGCLogEntry entry(0, QDateTime(), logSize, true);
+    LogDownloadData data(&entry);
+    QCOMPARE(data.bins.size(), static_cast<qsizetype>(40));
+
+    QTemporaryDir downloadDir;
+    QVERIFY(downloadDir.isValid());
+    QVERIFY(data.createFile(downloadDir.filePath("window.ulg")));
+
+    // Everything but bins 3, 4, 6 and 35, so bins 8 to 31 are skipped a byte at a time
+    const QList<uint32_t> missing = { 3, 4, 6, 35 };
+    for (uint32_t bin = 0; bin < 40; bin++) {
+        if (!missing.contains(bin)) {
+            const QByteArray packet((bin == 39) ? 80 : MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN, static_cast<char>(bin));
+            QVERIFY(data.writeBin(bin, reinterpret_cast<const uint8_t*>(packet.constData()), static_cast<uint8_t>(packet.size())));
+        }
+    }
+    QCOMPARE(data.binsReceived, 36u);
+
+    // Bins received before are not counted again
+    const QByteArray duplicate(MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN, 0);
+    QVERIFY(data.writeBin(0, reinterpret_cast<const uint8_t*>(duplicate.constData()), static_cast<uint8_t>(duplicate.size())));
+    QCOMPARE(data.binsReceived, 36u);
+    QVERIFY(!data.complete());
+
+    uint32_t start = 0;
+    uint32_t end = 0;
+    QVERIFY(data.nextWindow(0, 1, start, end));
+    QCOMPARE(start, 3u);
+    QCOMPARE(end, 5u);
+
+    // Gaps closer than mergeBins are requested together
+    QVERIFY(data.nextWindow(0, 2, start, end));
+    QCOMPARE(start, 3u);
+    QCOMPARE(end, 7u);
+    QVERIFY(data.nextWindow(0, 28, start, end));
+    QCOMPARE(end, 7u);
+    QVERIFY(data.nextWindow(0, 29, start, end));
+    QCOMPARE(start, 3u);
+    QCOMPARE(end, 36u);
+
+    // Windows go on behind the last one and wrap around to the start of the log
+    QVERIFY(data.nextWindow(7, 1, start, end));
+    QCOMPARE(start, 35u);
+    QCOMPARE(end, 36u);
+    QVERIFY(data.nextWindow(36, 1, start, end));
+    QCOMPARE(start, 3u);
+    QCOMPARE(end, 5u);
+
+    for (const uint32_t bin : missing) {
+        const QByteArray packet(MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN, static_cast<char>(bin));
+        QVERIFY(data.writeBin(bin, reinterpret_cast<const uint8_t*>(packet.constData()), static_cast<uint8_t>(packet.size())));
+    }
+    QVERIFY(data.complete());
+    QVERIFY(!data.nextWindow(0, 1, start, end));
+    data.closeFile();
 
+    // Every bin landed at its offset
+    QFile file(downloadDir.filePath("window.ulg"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+    QCOMPARE(contents.size(), static_cast<qsizetype>(logSize));
+    for (qsizetype i = 0; i < contents.size(); i++) {
+        if (contents[i] != static_cast<char>(i / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN)) {
+            QFAIL(qPrintable(QStringLiteral("Unexpected byte at offset %1").arg(i)));
+        }
+    }
+}
+
+// MockLink sends a 2 MB log at up to 20 LOG_DATA messages per tick and drops a twentieth of them, so the gaps are
+// filled through further request windows. Download time is reported as a benchmark of the log download.
+void LogDownloadTest::downloadThroughputBenchmark(void)
+{
+    const uint32_t logSize = 2 * 1024 * 1024;
+
+    // The simulated log is created on the first request, so the settings are in place before the log is listed
     _connectMockLink(MAV_AUTOPILOT_PX4);
+    _mockLink->setLogDownloadFileSize(logSize);
+    _mockLink->setLogDataPacketsPerTick(20);
+    _mockLink->setLogDataLossPercent(5);
+
+    qint64 downloadMsecs = 0;
+    _downloadLog(120000, &downloadMsecs);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
 
+    qDebug() << "Log download of" << logSize << "bytes with 5% loss took" << downloadMsecs << "msecs,"
+             << (static_cast<qint64>(logSize) * 1000) / qMax<qint64>(downloadMsecs, 1) << "bytes/sec";
+}
+
+void LogDownloadTest::_downloadLog(int timeoutMsecs, qint64* downloadMsecs)
+{
     LogDownloadController* controller = new LogDownloadController();
 
     _rgLogDownloadControllerSignals[requestingListChangedSignalIndex] =     SIGNAL(requestingListChanged());
@@ -45,24 +145,35 @@ void LogDownloadTest::downloadTest(void)
 
     auto model = controller->model();
     QVERIFY(model);
-    qDebug() << model->count();
+    QCOMPARE(model->count(), 1);
     model->value<QGCLogEntry*>(0)->setSelected(true);
 
-    QString downloadTo = QDir::currentPath();
-    qDebug() << "download to:" << downloadTo;
+    QElapsedTimer downloadTimer;
+    downloadTimer.start();
+
+    // An empty directory, the controller renames a download that would overwrite a file left behind
+    QTemporaryDir downloadDir;
+    QVERIFY(downloadDir.isValid());
+    QString downloadTo = downloadDir.path();
     controller->downloadToDirectory(downloadTo);
     QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(downloadingLogsChangedSignalIndex, 10000));
     _multiSpyLogDownloadController->clearAllSignals();
     if (controller->downloadingLogs()) {
-        QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(downloadingLogsChangedSignalIndex, 10000));
+        QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(downloadingLogsChangedSignalIndex, timeoutMsecs));
         QCOMPARE(controller->downloadingLogs(), false);
     }
     _multiSpyLogDownloadController->clearAllSignals();
 
+    if (downloadMsecs) {
+        *downloadMsecs = downloadTimer.elapsed();
+    }
+
     QString downloadFile = QDir(downloadTo).filePath("log_0_UnknownDate.ulg");
     QVERIFY(UnitTest::fileCompare(downloadFile, _mockLink->logDownloadFile()));
 
     QFile::remove(downloadFile);
 
+    delete _multiSpyLogDownloadController;
+    _multiSpyLogDownloadController = nullptr;
     delete controller;
 }
@@ -26,8 +26,14 @@ private slots:
     //void cleanup(void) { _cleanup(); }
 
     void downloadTest(void);
+    void windowTest(void);
+    void downloadThroughputBenchmark(void);
 
 private:
+    /// Lists the logs of the MockLink vehicle and downloads the first one, comparing it to the simulated log file
+    ///     @param downloadMsecs Returns the time the download took
+    void _downloadLog(int timeoutMsecs, qint64* downloadMsecs = nullptr);
+
     // LogDownloadController signals
 
     enum {
@@ -43,7 +49,7 @@ private:
         modelChangedSignalIndexMask =       1 << modelChangedSignalIndex,
     };
 
-    MultiSignalSpy*     _multiSpyLogDownloadController;
+    MultiSignalSpy*     _multiSpyLogDownloadController = nullptr;
     static const size_t _cLogDownloadControllerSignals = logDownloadControllerMaxSignalIndex;
     const char*         _rgLogDownloadControllerSignals[_cLogDownloadControllerSignals];
 
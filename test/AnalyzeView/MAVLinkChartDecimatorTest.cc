@@ -0,0 +1,107 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkChartDecimatorTest.h"
+#include "MAVLinkChartDecimator.h"
+
+#include <QtTest/QTest>
+
+void MAVLinkChartDecimatorTest::_testBuckets()
+{
+    // 10 columns of 100 msecs
+    MAVLinkChartDecimator decimator(1000, 10);
+    QCOMPARE(decimator.bucketMSecs(), static_cast<qint64>(100));
+    QCOMPARE(decimator.newestIndex(), static_cast<qint64>(-1));
+
+    decimator.append(1000, 5);
+    decimator.append(1010, 9);
+    decimator.append(1020, qQNaN());
+    decimator.append(1030, -3);
+    decimator.append(1040, 2);
+    decimator.append(1100, 7);
+
+    QCOMPARE(decimator.newestIndex(), static_cast<qint64>(11));
+
+    const MAVLinkChartDecimator::Bucket* bucket = decimator.bucket(10);
+    QVERIFY(bucket);
+    QCOMPARE(bucket->first, 5.0);
+    QCOMPARE(bucket->min, -3.0);
+    QCOMPARE(bucket->minTime, static_cast<qint64>(1030));
+    QCOMPARE(bucket->max, 9.0);
+    QCOMPARE(bucket->maxTime, static_cast<qint64>(1010));
+    QCOMPARE(bucket->last, 2.0);
+    QCOMPARE(bucket->lastTime, static_cast<qint64>(1040));
+
+    bucket = decimator.bucket(11);
+    QVERIFY(bucket);
+    QCOMPARE(bucket->first, 7.0);
+    QCOMPARE(bucket->last, 7.0);
+
+    QVERIFY(!decimator.bucket(12));
+    QVERIFY(!decimator.bucket(-1));
+
+    decimator.clear();
+    QVERIFY(!decimator.bucket(10));
+    QCOMPARE(decimator.newestIndex(), static_cast<qint64>(-1));
+}
+
+void MAVLinkChartDecimatorTest::_testPoints()
+{
+    MAVLinkChartDecimator decimator(1000, 10);
+
+    // Single sample, a single point
+    decimator.append(0, 1);
+    QList<QPointF> points;
+    QCOMPARE(MAVLinkChartDecimator::appendPoints(*decimator.bucket(0), points), 1);
+    QCOMPARE(points.first(), QPointF(0, 1));
+
+    // First, max, min, last in time order
+    decimator.append(100, 4);
+    decimator.append(110, 8);
+    decimator.append(120, 6);
+    decimator.append(130, 0);
+    decimator.append(140, 3);
+    points.clear();
+    QCOMPARE(MAVLinkChartDecimator::appendPoints(*decimator.bucket(1), points), 4);
+    QCOMPARE(points[0], QPointF(100, 4));
+    QCOMPARE(points[1], QPointF(110, 8));
+    QCOMPARE(points[2], QPointF(130, 0));
+    QCOMPARE(points[3], QPointF(140, 3));
+
+    // The first sample is also the min
+    decimator.append(200, -1);
+    decimator.append(210, 2);
+    points.clear();
+    QCOMPARE(MAVLinkChartDecimator::appendPoints(*decimator.bucket(2), points), 2);
+    QCOMPARE(points[0], QPointF(200, -1));
+    QCOMPARE(points[1], QPointF(210, 2));
+}
+
+void MAVLinkChartDecimatorTest::_testWindow()
+{
+    MAVLinkChartDecimator decimator(1000, 10);
+    const qint64 capacity = decimator.capacity();
+    QCOMPARE(capacity, static_cast<qint64>(12));
+
+    for (qint64 i = 0; i < 100; i++) {
+        decimator.append(i * 100, static_cast<double>(i));
+    }
+    QCOMPARE(decimator.newestIndex(), static_cast<qint64>(99));
+
+    // Only the newest buckets are kept, older slots were reused
+    QVERIFY(decimator.bucket(99));
+    QVERIFY(decimator.bucket(99 - capacity + 1));
+    QVERIFY(!decimator.bucket(99 - capacity));
+
+    // Samples older than what is kept are dropped instead of overwriting newer buckets
+    decimator.append(0, -100);
+    QVERIFY(!decimator.bucket(0));
+    QVERIFY(decimator.bucket(96));
+    QCOMPARE(decimator.bucket(96)->min, 96.0);
+}
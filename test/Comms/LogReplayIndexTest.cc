@@ -0,0 +1,119 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LogReplayIndexTest.h"
+#include "LogReplayIndex.h"
+#include "MAVLinkLib.h"
+
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
+#include <QtTest/QTest>
+
+/// Builds a tlog with one heartbeat per record, with some garbage between records
+QByteArray LogReplayIndexTest::_buildLog(int recordCount)
+{
+    QByteArray log;
+
+    for (int i = 0; i < recordCount; i++) {
+        mavlink_message_t message;
+        (void) mavlink_msg_heartbeat_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, MAVLINK_COMM_13, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, 0, i, MAV_STATE_ACTIVE);
+
+        uchar timestamp[sizeof(quint64)];
+        qToBigEndian<quint64>(_startTimeUSecs + (i * _recordIntervalUSecs), timestamp);
+        (void) log.append(reinterpret_cast<const char*>(timestamp), sizeof(timestamp));
+
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        const uint16_t len = mavlink_msg_to_send_buffer(buffer, &message);
+        (void) log.append(reinterpret_cast<const char*>(buffer), len);
+
+        if ((i % 97) == 50) {
+            (void) log.append("\xFD\x01\x02garbage", 10);
+        }
+    }
+
+    return log;
+}
+
+void LogReplayIndexTest::_testBuild()
+{
+    static constexpr int kRecordCount = 1000;
+    const QByteArray log = _buildLog(kRecordCount);
+    const uchar *const data = reinterpret_cast<const uchar*>(log.constData());
+
+    LogReplayIndex index;
+    QVERIFY(index.build(data, log.size()));
+    QCOMPARE(index.recordCount(), static_cast<quint64>(kRecordCount));
+    QCOMPARE(index.startTimeUSecs(), _startTimeUSecs);
+    QCOMPARE(index.endTimeUSecs(), _startTimeUSecs + ((kRecordCount - 1) * _recordIntervalUSecs));
+
+    std::atomic_bool cancel = true;
+    LogReplayIndex cancelledIndex;
+    QVERIFY(!cancelledIndex.build(data, log.size(), &cancel));
+    QVERIFY(!cancelledIndex.isValid());
+
+    LogReplayIndex emptyIndex;
+    QVERIFY(!emptyIndex.build(reinterpret_cast<const uchar*>("garbage"), 7));
+}
+
+void LogReplayIndexTest::_testSeek()
+{
+    static constexpr int kRecordCount = 1000;
+    const QByteArray log = _buildLog(kRecordCount);
+    const uchar *const data = reinterpret_cast<const uchar*>(log.constData());
+    const quint64 now = LogReplayIndex::nowUSecs();
+
+    LogReplayIndex index;
+    QVERIFY(index.build(data, log.size()));
+
+    for (const int record : { 0, 1, 63, 64, 65, 500, 998, 999 }) {
+        const quint64 timeUSecs = _startTimeUSecs + (record * _recordIntervalUSecs);
+        const qint64 offset = index.seek(data, log.size(), timeUSecs);
+        QVERIFY(offset >= 0);
+
+        quint64 timestamp;
+        qint64 frameLength;
+        QVERIFY(LogReplayIndex::parseRecord(data, log.size(), offset, now, timestamp, frameLength));
+        QCOMPARE(timestamp, timeUSecs);
+
+        // Between records lands on the following one
+        const qint64 betweenOffset = index.seek(data, log.size(), timeUSecs - 1);
+        QVERIFY(LogReplayIndex::parseRecord(data, log.size(), betweenOffset, now, timestamp, frameLength));
+        QCOMPARE(timestamp, timeUSecs);
+    }
+
+    QCOMPARE(index.seek(data, log.size(), _startTimeUSecs + (kRecordCount * _recordIntervalUSecs)), -1);
+}
+
+void LogReplayIndexTest::_testSidecar()
+{
+    const QByteArray log = _buildLog(500);
+    const uchar *const data = reinterpret_cast<const uchar*>(log.constData());
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString indexFileName = LogReplayIndex::indexFileName(tempDir.filePath(QStringLiteral("test.tlog")));
+    static constexpr qint64 kModifiedMSecs = 1234;
+
+    LogReplayIndex index;
+    QVERIFY(index.build(data, log.size()));
+    QVERIFY(index.save(indexFileName, log.size(), kModifiedMSecs));
+
+    LogReplayIndex loadedIndex;
+    QVERIFY(loadedIndex.load(indexFileName, log.size(), kModifiedMSecs));
+    QCOMPARE(loadedIndex.recordCount(), index.recordCount());
+    QCOMPARE(loadedIndex.startTimeUSecs(), index.startTimeUSecs());
+    QCOMPARE(loadedIndex.endTimeUSecs(), index.endTimeUSecs());
+    const quint64 seekTime = _startTimeUSecs + (321 * _recordIntervalUSecs);
+    QCOMPARE(loadedIndex.seek(data, log.size(), seekTime), index.seek(data, log.size(), seekTime));
+
+    // Index for a different version of the log is ignored
+    LogReplayIndex staleIndex;
+    QVERIFY(!staleIndex.load(indexFileName, log.size() + 1, kModifiedMSecs));
+    QVERIFY(!staleIndex.load(indexFileName, log.size(), kModifiedMSecs + 1));
+}
@@ -0,0 +1,31 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class LogReplayIndexTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    LogReplayIndexTest() = default;
+
+private slots:
+    void _testBuild();
+    void _testSeek();
+    void _testSidecar();
+
+private:
+    static QByteArray _buildLog(int recordCount);
+
+    static constexpr quint64 _startTimeUSecs = 1700000000000000ULL;
+    static constexpr quint64 _recordIntervalUSecs = 1000;
+};
@@ -0,0 +1,96 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LogReplayLinkTest.h"
+#include "LogReplayLink.h"
+#include "MAVLinkProtocol.h"
+#include "MultiVehicleManager.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
+#include <QtTest/QTest>
+
+/// SYSTEM_TIME every msec with a HEARTBEAT every kHeartbeatInterval records, so the replay brings up a vehicle
+static void _writeLog(const QString &logFilename, int messageCount)
+{
+    static constexpr int kHeartbeatInterval = 100;
+
+    QFile logFile(logFilename);
+    QVERIFY(logFile.open(QIODevice::WriteOnly));
+    const quint64 startTimeUSecs = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() - (60 * 60 * 1000)) * 1000;
+    for (int i = 0; i < messageCount; i++) {
+        mavlink_message_t message;
+        if ((i % kHeartbeatInterval) == 0) {
+            (void) mavlink_msg_heartbeat_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, MAVLINK_COMM_13, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, 0, 0, MAV_STATE_ACTIVE);
+        } else {
+            (void) mavlink_msg_system_time_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, MAVLINK_COMM_13, &message, startTimeUSecs + (i * 1000), i);
+        }
+
+        uchar record[sizeof(quint64) + MAVLINK_MAX_PACKET_LEN];
+        qToBigEndian<quint64>(startTimeUSecs + (i * 1000), record);
+        const uint16_t len = mavlink_msg_to_send_buffer(record + sizeof(quint64), &message);
+        QCOMPARE(logFile.write(reinterpret_cast<const char*>(record), sizeof(quint64) + len), static_cast<qint64>(sizeof(quint64) + len));
+    }
+    logFile.close();
+}
+
+void LogReplayLinkTest::_testBatchReplay()
+{
+    static constexpr int kMessageCount = 20000;
+    static constexpr int kLogCount = 2;
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    QStringList logFilenames;
+    for (int i = 0; i < kLogCount; i++) {
+        logFilenames.append(tempDir.filePath(QStringLiteral("batch%1.tlog").arg(i)));
+        _writeLog(logFilenames.last(), kMessageCount);
+    }
+
+    int receivedCount = 0;
+    const QMetaObject::Connection messageConnection = connect(MAVLinkProtocol::instance(), &MAVLinkProtocol::messageReceived, this, [&receivedCount](LinkInterface*, const mavlink_message_t &message) {
+        if (message.msgid == MAVLINK_MSG_ID_SYSTEM_TIME) {
+            receivedCount++;
+        }
+    });
+    int vehicleCount = 0;
+    const QMetaObject::Connection vehicleConnection = connect(MultiVehicleManager::instance(), &MultiVehicleManager::vehicleAdded, this, [&vehicleCount]() {
+        vehicleCount++;
+    });
+
+    // The second log is only accepted once the vehicle of the first one has been deleted
+    const QList<LogReplayBatch::Result> results = LogReplayBatch::replay(logFilenames);
+    (void) disconnect(messageConnection);
+    (void) disconnect(vehicleConnection);
+
+    QCOMPARE(results.count(), kLogCount);
+    for (const LogReplayBatch::Result &result : results) {
+        QVERIFY2(result.success, qPrintable(result.errorString));
+        QCOMPARE(result.messageCount, static_cast<quint64>(kMessageCount));
+        QCOMPARE(result.overflowMessageCount, 0ULL);
+        QVERIFY(result.messagesPerSec > 0);
+    }
+    QCOMPARE(vehicleCount, kLogCount);
+    QVERIFY(!MultiVehicleManager::instance()->activeVehicle());
+    QCOMPARE(receivedCount, kLogCount * (kMessageCount - (kMessageCount / 100)));
+}
+
+void LogReplayLinkTest::_testBatchReplayMissingLog()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    const QList<LogReplayBatch::Result> results = LogReplayBatch::replay(QStringList{ tempDir.filePath(QStringLiteral("missing.tlog")) });
+    QCOMPARE(results.count(), 1);
+    QVERIFY(!results.first().success);
+    QCOMPARE(results.first().messageCount, 0ULL);
+}
@@ -0,0 +1,24 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class LogReplayLinkTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    LogReplayLinkTest() = default;
+
+private slots:
+    void _testBatchReplay();
+    void _testBatchReplayMissingLog();
+};
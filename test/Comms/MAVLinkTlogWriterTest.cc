@@ -0,0 +1,131 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkTlogWriterTest.h"
+#include "MAVLinkTlogWriter.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
+#include <QtTest/QTest>
+
+void MAVLinkTlogWriterTest::_testRecords()
+{
+    // Enough messages to roll over several blocks
+    static constexpr int kMessageCount = 20000;
+    static const QByteArray rawRecord("raw bytes record");
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString fileName = tempDir.filePath(QStringLiteral("test.tlog"));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    const quint64 startUsecs = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()) * 1000;
+
+    MAVLinkTlogWriter writer;
+    writer.open(fileName);
+    QVERIFY(writer.isOpen());
+
+    qsizetype expectedSize = 0;
+    for (int i = 0; i < kMessageCount; i++) {
+        mavlink_message_t message;
+        (void) mavlink_msg_heartbeat_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, MAVLINK_COMM_13, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, 0, i, MAV_STATE_ACTIVE);
+        writer.writeMessage(message);
+        expectedSize += MAVLinkTlogWriter::kTimestampLen + mavlink_msg_get_send_buffer_length(&message);
+    }
+    writer.writeBytes(rawRecord.constData(), rawRecord.size());
+    expectedSize += MAVLinkTlogWriter::kTimestampLen + rawRecord.size();
+
+    writer.close();
+    QVERIFY(!writer.isOpen());
+
+    const quint64 endUsecs = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() + 1) * 1000;
+
+    QCOMPARE(writer.droppedBytes(), 0ULL);
+    QCOMPARE(QFileInfo(fileName).size(), expectedSize);
+
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+    file.close();
+
+    // Walk the records: timestamp followed by a MAVLink 2 frame
+    const char *data = contents.constData();
+    quint64 lastTimestamp = 0;
+    qsizetype offset = 0;
+    for (int i = 0; i < kMessageCount; i++) {
+        const quint64 timestamp = qFromBigEndian<quint64>(data + offset);
+        QVERIFY(timestamp >= lastTimestamp);
+        QVERIFY(timestamp >= startUsecs);
+        QVERIFY(timestamp <= endUsecs);
+        lastTimestamp = timestamp;
+        offset += MAVLinkTlogWriter::kTimestampLen;
+
+        const uint8_t *const frame = reinterpret_cast<const uint8_t*>(data + offset);
+        QCOMPARE(frame[0], static_cast<uint8_t>(MAVLINK_STX));
+        const uint32_t msgid = frame[7] | (frame[8] << 8) | (frame[9] << 16);
+        QCOMPARE(msgid, static_cast<uint32_t>(MAVLINK_MSG_ID_HEARTBEAT));
+        offset += MAVLINK_NUM_NON_PAYLOAD_BYTES + frame[1];
+    }
+
+    offset += MAVLinkTlogWriter::kTimestampLen;
+    QCOMPARE(contents.mid(offset), rawRecord);
+}
+
+void MAVLinkTlogWriterTest::_testWriteWhileClosed()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString fileName = tempDir.filePath(QStringLiteral("test.tlog"));
+
+    MAVLinkTlogWriter writer;
+    writer.writeBytes("before", 6);
+
+    writer.open(fileName);
+    writer.writeBytes("during", 6);
+    writer.close();
+
+    writer.writeBytes("after", 5);
+    writer.close();
+
+    QCOMPARE(QFileInfo(fileName).size(), MAVLinkTlogWriter::kTimestampLen + 6);
+}
+
+void MAVLinkTlogWriterTest::_testErrorReportedOnClose()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString fileName = tempDir.filePath(QStringLiteral("missing/test.tlog"));
+
+    MAVLinkTlogWriter writer;
+    int errorCount = 0;
+    bool openDuringError = false;
+    (void) connect(&writer, &MAVLinkTlogWriter::writeError, this, [&writer, &errorCount, &openDuringError]() {
+        errorCount++;
+        openDuringError = writer.isOpen();
+        writer.close();
+    });
+
+    // The open error is still queued when close runs
+    writer.open(fileName);
+    writer.writeBytes("lost", 4);
+    writer.close();
+
+    QCOMPARE(errorCount, 1);
+    QVERIFY(openDuringError);
+    QVERIFY(!writer.isOpen());
+
+    // The queued copy of the error is not reported again
+    QCoreApplication::processEvents();
+    QCOMPARE(errorCount, 1);
+}
@@ -0,0 +1,25 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class MAVLinkTlogWriterTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    MAVLinkTlogWriterTest() = default;
+
+private slots:
+    void _testRecords();
+    void _testWriteWhileClosed();
+    void _testErrorReportedOnClose();
+};
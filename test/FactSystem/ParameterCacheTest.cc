@@ -0,0 +1,152 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterCacheTest.h"
+#include "ParameterCache.h"
+#include "QGC.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QTest>
+
+#include <algorithm>
+
+namespace {
+
+QList<ParameterCache::Param> testParams()
+{
+    QList<ParameterCache::Param> params;
+    params.append({ QStringLiteral("SYS_AUTOSTART"),    FactMetaData::valueTypeInt32,   QVariant(static_cast<qint32>(4001)),   false });
+    params.append({ QStringLiteral("BAT1_V_CHARGED"),   FactMetaData::valueTypeFloat,   QVariant(4.05f),                        false });
+    params.append({ QStringLiteral("CAL_ACC0_ID"),      FactMetaData::valueTypeUint32,  QVariant(static_cast<quint32>(3000000000u)), false });
+    params.append({ QStringLiteral("MAV_TYPE"),         FactMetaData::valueTypeUint8,   QVariant(static_cast<int>(200)),       false });
+    params.append({ QStringLiteral("RC_MAP_ROLL"),      FactMetaData::valueTypeInt8,    QVariant(static_cast<int>(-3)),        false });
+    params.append({ QStringLiteral("SENS_BOARD_ROT"),   FactMetaData::valueTypeInt16,   QVariant(static_cast<int>(-1234)),     false });
+    params.append({ QStringLiteral("COM_FLTMODE1"),     FactMetaData::valueTypeUint16,  QVariant(static_cast<int>(60000)),     false });
+    params.append({ QStringLiteral("LND_FLIGHT_T_HI"),  FactMetaData::valueTypeInt32,   QVariant(static_cast<qint32>(17)),     true });
+    return params;
+}
+
+} // namespace
+
+void ParameterCacheTest::_testRoundTrip()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = tempDir.filePath(QStringLiteral("1_1.v3"));
+
+    const QList<ParameterCache::Param> params = testParams();
+    QVERIFY(ParameterCache::write(path, params));
+
+    const ParameterCache cache(path);
+    QVERIFY(cache.isValid());
+    QCOMPARE(cache.count(), params.count());
+
+    // Sorted by name, values and variant types as received over MAVLink
+    for (int i = 1; i < cache.count(); i++) {
+        QVERIFY(cache.name(i - 1) < cache.name(i));
+    }
+    for (const ParameterCache::Param& param: params) {
+        int index = -1;
+        for (int i = 0; i < cache.count(); i++) {
+            if (cache.name(i) == param.name) {
+                index = i;
+            }
+        }
+        QVERIFY(index >= 0);
+        QCOMPARE(cache.type(index), param.type);
+        QCOMPARE(cache.rawValue(index), param.rawValue);
+        QCOMPARE(cache.rawValue(index).metaType(), param.rawValue.metaType());
+    }
+}
+
+void ParameterCacheTest::_testHashCrc()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = tempDir.filePath(QStringLiteral("1_1.v3"));
+
+    QList<ParameterCache::Param> params = testParams();
+    QVERIFY(ParameterCache::write(path, params));
+
+    // The crc the vehicle computes: name and value bytes of each non-volatile parameter in name order
+    std::sort(params.begin(), params.end(), [](const ParameterCache::Param& a, const ParameterCache::Param& b) { return a.name < b.name; });
+    quint32 crc = 0;
+    for (const ParameterCache::Param& param: params) {
+        if (param.volatileValue) {
+            continue;
+        }
+        const QByteArray name = param.name.toLatin1();
+        crc = QGC::crc32(reinterpret_cast<const quint8*>(name.constData()), static_cast<unsigned>(name.size()), crc);
+        const qint64 value = param.rawValue.toLongLong();
+        crc = (param.type == FactMetaData::valueTypeFloat) ?
+                  QGC::crc32(reinterpret_cast<const quint8*>(param.rawValue.constData()), 4, crc) :
+                  QGC::crc32(reinterpret_cast<const quint8*>(&value), static_cast<unsigned>(FactMetaData::typeToSize(param.type)), crc);
+    }
+
+    const ParameterCache cache(path);
+    QVERIFY(cache.isValid());
+    QCOMPARE(cache.hashCrc(), crc);
+    QCOMPARE(ParameterCache::computeHashCrc(params), crc);
+
+    // A volatile parameter changing does not change the crc
+    for (ParameterCache::Param& param: params) {
+        if (param.volatileValue) {
+            param.rawValue = QVariant(static_cast<qint32>(99));
+        }
+    }
+    QCOMPARE(ParameterCache::computeHashCrc(params), crc);
+}
+
+void ParameterCacheTest::_testCorruptCache()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = tempDir.filePath(QStringLiteral("1_1.v3"));
+    QVERIFY(ParameterCache::write(path, testParams()));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    file.close();
+
+    // Flipped value bit
+    QByteArray corrupt = data;
+    corrupt[40] = static_cast<char>(corrupt[40] ^ 0x01);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(corrupt), static_cast<qint64>(corrupt.size()));
+    file.close();
+    QVERIFY(!ParameterCache(path).isValid());
+
+    // Truncated
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(data.left(data.size() - 3)), static_cast<qint64>(data.size() - 3));
+    file.close();
+    QVERIFY(!ParameterCache(path).isValid());
+
+    // Not a cache
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(QByteArray(64, 'x')), static_cast<qint64>(64));
+    file.close();
+    QVERIFY(!ParameterCache(path).isValid());
+
+    QVERIFY(!ParameterCache(tempDir.filePath(QStringLiteral("missing.v3"))).isValid());
+}
+
+void ParameterCacheTest::_testUnsupportedType()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = tempDir.filePath(QStringLiteral("1_1.v3"));
+
+    QList<ParameterCache::Param> params = testParams();
+    params.append({ QStringLiteral("CUSTOM"), FactMetaData::valueTypeCustom, QVariant(QByteArray(128, 0)), false });
+    QVERIFY(!ParameterCache::write(path, params));
+    QVERIFY(!QFile::exists(path));
+}
@@ -0,0 +1,26 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class ParameterCacheTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    ParameterCacheTest() = default;
+
+private slots:
+    void _testRoundTrip();
+    void _testHashCrc();
+    void _testCorruptCache();
+    void _testUnsupportedType();
+};
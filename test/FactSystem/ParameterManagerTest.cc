@@ -13,6 +13,7 @@
 #include "Vehicle.h"
 #include "ParameterManager.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtTest/QTest>
 #include <QtTest/QSignalSpy>
 
@@ -142,6 +143,41 @@ void ParameterManagerTest::_requestListMissingParamFail(void)
     checkExpectedMessageBox();
 }
 
+// MockLink drops a tenth of the PARAM_VALUE messages, on the initial request list as well as on the param_read
+// requests for the missing params. Load time is reported as a benchmark of the request window.
+void ParameterManagerTest::_requestListLossyLink(void)
+{
+    Q_ASSERT(!_mockLink);
+    _mockLink = MockLink::startPX4MockLink(false);
+    _mockLink->setParamLossPercent(10);
+
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+
+    MultiVehicleManager* vehicleMgr = MultiVehicleManager::instance();
+    QVERIFY(vehicleMgr);
+
+    // Wait for the Vehicle to get created
+    QSignalSpy spyVehicle(vehicleMgr, SIGNAL(activeVehicleAvailableChanged(bool)));
+    QSignalSpy spyParamsReady(vehicleMgr, SIGNAL(parameterReadyVehicleAvailableChanged(bool)));
+    QCOMPARE(spyVehicle.wait(5000), true);
+    QCOMPARE(spyVehicle.count(), 1);
+
+    Vehicle* vehicle = vehicleMgr->activeVehicle();
+    QVERIFY(vehicle);
+
+    // All params should still load, the missing ones through param_read re-requests
+    if (spyParamsReady.count() == 0) {
+        QCOMPARE(spyParamsReady.wait(60000), true);
+    }
+    QList<QVariant> arguments = spyParamsReady.takeFirst();
+    QCOMPARE(arguments.count(), 1);
+    QCOMPARE(arguments.at(0).toBool(), true);
+    QCOMPARE(vehicle->parameterManager()->missingParameters(), false);
+
+    qDebug() << "Parameter load with 10% loss took" << loadTimer.elapsed() << "msecs";
+}
+
 void ParameterManagerTest::_FTPnoFailure()
 {
     Q_ASSERT(!_mockLink);
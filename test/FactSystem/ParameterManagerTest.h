@@ -23,6 +23,7 @@ private slots:
     void _requestListNoResponse(void);
     void _requestListMissingParamSuccess(void);
     void _requestListMissingParamFail(void);
+    void _requestListLossyLink(void);
     void _FTPnoFailure(void);
     // void _FTPChangeParam(void);
 
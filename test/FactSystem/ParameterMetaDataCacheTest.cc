@@ -0,0 +1,258 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterMetaDataCacheTest.h"
+#include "ParameterMetaDataCache.h"
+#include "ComponentInformationCache.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QTest>
+
+namespace {
+
+ParameterMetaDataCache::Sections testSections()
+{
+    ParameterMetaDataCache::Sections sections;
+    sections[QStringLiteral("libraries")][QStringLiteral("BATT_CAPACITY")] = QByteArrayLiteral("capacity");
+    sections[QStringLiteral("libraries")][QStringLiteral("ARMING_CHECK")] = QByteArrayLiteral("arming");
+    sections[QStringLiteral("libraries")][QStringLiteral("SERIAL1_BAUD")] = QByteArray();
+    sections[QStringLiteral("ArduCopter")][QStringLiteral("ARMING_CHECK")] = QByteArrayLiteral("copter arming");
+    sections[QStringLiteral("ArduCopter")][QStringLiteral("ANGLE_MAX")] = QByteArrayLiteral("angle");
+    sections[QString()][QStringLiteral("SYS_AUTOSTART")] = QByteArrayLiteral("autostart");
+    return sections;
+}
+
+bool writeFile(const QString& path, const QByteArray& content)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return file.write(content) == content.size();
+}
+
+} // namespace
+
+void ParameterMetaDataCacheTest::_testRoundTrip()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = tempDir.filePath(QStringLiteral("metadata.cache"));
+
+    const ParameterMetaDataCache::Sections sections = testSections();
+    QVERIFY(ParameterMetaDataCache::write(path, sections));
+
+    ParameterMetaDataCache cache;
+    QVERIFY(cache.open(path));
+    QVERIFY(cache.isMapped());
+
+    QCOMPARE(cache.sections(), QStringList({ QString(), QStringLiteral("ArduCopter"), QStringLiteral("libraries") }));
+    QCOMPARE(cache.names(QStringLiteral("libraries")), QStringList({ QStringLiteral("ARMING_CHECK"), QStringLiteral("BATT_CAPACITY"), QStringLiteral("SERIAL1_BAUD") }));
+
+    // The same name in different sections has different records
+    for (auto sectionIt = sections.constBegin(); sectionIt != sections.constEnd(); ++sectionIt) {
+        for (auto it = sectionIt->constBegin(); it != sectionIt->constEnd(); ++it) {
+            const QByteArray record = cache.record(sectionIt.key(), it.key());
+            QVERIFY(!record.isNull());
+            QCOMPARE(record, it.value());
+        }
+    }
+
+    QVERIFY(cache.record(QStringLiteral("libraries"), QStringLiteral("ANGLE_MAX")).isNull());
+    QVERIFY(cache.record(QStringLiteral("ArduPlane"), QStringLiteral("ARMING_CHECK")).isNull());
+    QVERIFY(cache.names(QStringLiteral("ArduPlane")).isEmpty());
+}
+
+void ParameterMetaDataCacheTest::_testRecord()
+{
+    ParameterMetaDataCache::Record record;
+    record.type = QStringLiteral("INT32");
+    record.category = QStringLiteral("Standard");
+    record.group = QStringLiteral("Battery Calibration");
+    record.shortDescription = QStringLiteral("Battery capacity");
+    record.longDescription = QStringLiteral("Defines the capacity of the attached battery. µAh are not supported.");
+    record.min = QStringLiteral("-1");
+    record.max = QStringLiteral("100000");
+    record.defaultValue = QStringLiteral("-1");
+    record.units = QStringLiteral("mAh");
+    record.decimalPlaces = QStringLiteral("0");
+    record.increment = QStringLiteral("50");
+    record.rebootRequired = true;
+    record.volatileValue = true;
+    record.values = { { QStringLiteral("-1"), QStringLiteral("Unknown") }, { QStringLiteral("0"), QStringLiteral("None") } };
+    record.bitmask = { { QStringLiteral("0"), QStringLiteral("First") } };
+
+    const QByteArray bytes = record.toBytes();
+
+    ParameterMetaDataCache::Record decoded;
+    QVERIFY(ParameterMetaDataCache::Record::fromBytes(bytes, decoded));
+    QCOMPARE(decoded.type, record.type);
+    QCOMPARE(decoded.category, record.category);
+    QCOMPARE(decoded.group, record.group);
+    QCOMPARE(decoded.shortDescription, record.shortDescription);
+    QCOMPARE(decoded.longDescription, record.longDescription);
+    QCOMPARE(decoded.min, record.min);
+    QCOMPARE(decoded.max, record.max);
+    QCOMPARE(decoded.defaultValue, record.defaultValue);
+    QCOMPARE(decoded.units, record.units);
+    QCOMPARE(decoded.decimalPlaces, record.decimalPlaces);
+    QCOMPARE(decoded.increment, record.increment);
+    QCOMPARE(decoded.rebootRequired, true);
+    QCOMPARE(decoded.readOnly, false);
+    QCOMPARE(decoded.volatileValue, true);
+    QCOMPARE(decoded.boolean, false);
+    QCOMPARE(decoded.values, record.values);
+    QCOMPARE(decoded.bitmask, record.bitmask);
+
+    // Fields left empty stay empty
+    ParameterMetaDataCache::Record empty;
+    QVERIFY(ParameterMetaDataCache::Record::fromBytes(ParameterMetaDataCache::Record().toBytes(), empty));
+    QVERIFY(empty.category.isEmpty());
+    QVERIFY(empty.values.isEmpty());
+
+    QVERIFY(!ParameterMetaDataCache::Record::fromBytes(bytes.left(bytes.size() - 1), decoded));
+    QVERIFY(!ParameterMetaDataCache::Record::fromBytes(bytes + QByteArray(1, '\0'), decoded));
+}
+
+void ParameterMetaDataCacheTest::_testCorruptCache()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = tempDir.filePath(QStringLiteral("metadata.cache"));
+
+    QVERIFY(ParameterMetaDataCache::write(path, testSections()));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray content = file.readAll();
+    file.close();
+
+    ParameterMetaDataCache cache;
+
+    // Truncated
+    QVERIFY(writeFile(path, content.left(content.size() - 1)));
+    QVERIFY(!cache.open(path));
+    QVERIFY(!cache.isMapped());
+    QVERIFY(cache.record(QStringLiteral("libraries"), QStringLiteral("ARMING_CHECK")).isNull());
+
+    // Other format version
+    QByteArray corrupt = content;
+    corrupt[4] = static_cast<char>(ParameterMetaDataCache::kVersion + 1);
+    QVERIFY(writeFile(path, corrupt));
+    QVERIFY(!cache.open(path));
+
+    // Name offset of the first section past the data area
+    corrupt = content;
+    corrupt[20 + 3] = '\x7f';
+    QVERIFY(writeFile(path, corrupt));
+    QVERIFY(!cache.open(path));
+
+    QVERIFY(writeFile(path, QByteArray()));
+    QVERIFY(!cache.open(path));
+
+    QVERIFY(writeFile(path, content));
+    QVERIFY(cache.open(path));
+}
+
+void ParameterMetaDataCacheTest::_testLoad()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    ComponentInformationCache fileCache(QDir(tempDir.filePath(QStringLiteral("cache"))), 10);
+    const QString metaDataFile = tempDir.filePath(QStringLiteral("parameters.xml"));
+    QVERIFY(writeFile(metaDataFile, QByteArrayLiteral("<parameters>1</parameters>")));
+
+    int buildCount = 0;
+    const ParameterMetaDataCache::BuildFunction build = [&buildCount](const QByteArray& metaData, ParameterMetaDataCache::Sections& sections) {
+        buildCount++;
+        sections[QString()][QStringLiteral("CONTENT")] = metaData;
+        return true;
+    };
+
+    {
+        ParameterMetaDataCache cache;
+        QVERIFY(cache.load(QStringLiteral("Test"), metaDataFile, build, &fileCache));
+        QCOMPARE(buildCount, 1);
+        QVERIFY(cache.isMapped());
+        QCOMPARE(cache.record(QString(), QStringLiteral("CONTENT")), QByteArrayLiteral("<parameters>1</parameters>"));
+    }
+
+    // Same content is not parsed again
+    {
+        ParameterMetaDataCache cache;
+        QVERIFY(cache.load(QStringLiteral("Test"), metaDataFile, build, &fileCache));
+        QCOMPARE(buildCount, 1);
+        QVERIFY(cache.isMapped());
+        QCOMPARE(cache.record(QString(), QStringLiteral("CONTENT")), QByteArrayLiteral("<parameters>1</parameters>"));
+    }
+
+    // Other producers of the same file have their own cache
+    {
+        ParameterMetaDataCache cache;
+        QVERIFY(cache.load(QStringLiteral("Other"), metaDataFile, build, &fileCache));
+        QCOMPARE(buildCount, 2);
+    }
+
+    // Changed content is parsed again
+    QVERIFY(writeFile(metaDataFile, QByteArrayLiteral("<parameters>2</parameters>")));
+    {
+        ParameterMetaDataCache cache;
+        QVERIFY(cache.load(QStringLiteral("Test"), metaDataFile, build, &fileCache));
+        QCOMPARE(buildCount, 3);
+        QCOMPARE(cache.record(QString(), QStringLiteral("CONTENT")), QByteArrayLiteral("<parameters>2</parameters>"));
+    }
+
+    // A damaged cache file is rebuilt in place
+    const QString cachedPath = fileCache.access(ParameterMetaDataCache::fileTag(QStringLiteral("Test"), QByteArrayLiteral("<parameters>2</parameters>")));
+    QVERIFY(!cachedPath.isEmpty());
+    QVERIFY(writeFile(cachedPath, QByteArrayLiteral("garbage")));
+    {
+        ParameterMetaDataCache cache;
+        QVERIFY(cache.load(QStringLiteral("Test"), metaDataFile, build, &fileCache));
+        QCOMPARE(buildCount, 4);
+        QVERIFY(cache.isMapped());
+    }
+    {
+        ParameterMetaDataCache cache;
+        QVERIFY(cache.load(QStringLiteral("Test"), metaDataFile, build, &fileCache));
+        QCOMPARE(buildCount, 4);
+    }
+
+    ParameterMetaDataCache cache;
+    QVERIFY(!cache.load(QStringLiteral("Test"), tempDir.filePath(QStringLiteral("missing.xml")), build, &fileCache));
+    QCOMPARE(buildCount, 4);
+}
+
+void ParameterMetaDataCacheTest::_testLoadWithErrors()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    ComponentInformationCache fileCache(QDir(tempDir.filePath(QStringLiteral("cache"))), 10);
+    const QString metaDataFile = tempDir.filePath(QStringLiteral("parameters.xml"));
+    QVERIFY(writeFile(metaDataFile, QByteArrayLiteral("<parameters>")));
+
+    int buildCount = 0;
+    const ParameterMetaDataCache::BuildFunction build = [&buildCount](const QByteArray& metaData, ParameterMetaDataCache::Sections& sections) {
+        Q_UNUSED(metaData);
+        buildCount++;
+        sections[QStringLiteral("libraries")][QStringLiteral("PARSED")] = QByteArrayLiteral("before the error");
+        return false;
+    };
+
+    // What was parsed is used, but not cached so the errors show up again on the next load
+    for (int i = 1; i <= 2; i++) {
+        ParameterMetaDataCache cache;
+        QVERIFY(cache.load(QStringLiteral("Test"), metaDataFile, build, &fileCache));
+        QCOMPARE(buildCount, i);
+        QVERIFY(!cache.isMapped());
+        QCOMPARE(cache.record(QStringLiteral("libraries"), QStringLiteral("PARSED")), QByteArrayLiteral("before the error"));
+        QCOMPARE(cache.names(QStringLiteral("libraries")), QStringList({ QStringLiteral("PARSED") }));
+        QVERIFY(cache.record(QStringLiteral("libraries"), QStringLiteral("OTHER")).isNull());
+    }
+}
@@ -0,0 +1,166 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterRequestWindowTest.h"
+#include "ParameterRequestWindow.h"
+
+#include <QtTest/QTest>
+
+void ParameterRequestWindowTest::_testWindowLimitsRequests()
+{
+    ParameterRequestWindow window;
+    window.addComponent(1, 100);
+    QCOMPARE(window.missingCount(), 100);
+
+    QList<ParameterRequestWindow::Request> requests = window.takeRequests(0);
+    QCOMPARE(static_cast<qint64>(requests.count()), static_cast<qint64>(ParameterRequestWindow::kInitialWindow));
+    QCOMPARE(window.inFlight(), ParameterRequestWindow::kInitialWindow);
+    QCOMPARE(requests.first().componentId, 1);
+    QCOMPARE(requests.first().paramIndex, 0);
+
+    // The window is full
+    QVERIFY(window.takeRequests(10).isEmpty());
+
+    // A response frees its slot and grows the window by one
+    QVERIFY(window.received(1, requests.first().paramIndex, 20));
+    QVERIFY(!window.received(1, requests.first().paramIndex, 20));
+    QCOMPARE(window.window(), ParameterRequestWindow::kInitialWindow + 1);
+    requests = window.takeRequests(20);
+    QCOMPARE(static_cast<qint64>(requests.count()), static_cast<qint64>(2));
+    QCOMPARE(requests.first().paramIndex, ParameterRequestWindow::kInitialWindow);
+    QCOMPARE(window.missingCount(), 99);
+
+    // Indices outside the component and unknown components are ignored
+    QVERIFY(!window.received(1, 65535, 20));
+    QVERIFY(!window.received(2, 0, 20));
+    QCOMPARE(window.missingCount(), 99);
+}
+
+void ParameterRequestWindowTest::_testRttEstimate()
+{
+    ParameterRequestWindow window;
+    window.addComponent(1, 100);
+
+    const QList<ParameterRequestWindow::Request> requests = window.takeRequests(0);
+    QVERIFY(window.received(1, requests.first().paramIndex, 50));
+    QCOMPARE(window.rttMs(), 50.);
+
+    // srtt + 4 * rttvar is below the minimum timeout
+    QCOMPARE(window.rtoMs(), static_cast<qint64>(200));
+    QCOMPARE(window.nextTimeoutMs(50), static_cast<qint64>(150));
+}
+
+void ParameterRequestWindowTest::_testTimeoutRetries()
+{
+    ParameterRequestWindow window;
+    window.addComponent(1, 100);
+
+    QCOMPARE(static_cast<qint64>(window.takeRequests(0).count()), static_cast<qint64>(ParameterRequestWindow::kInitialWindow));
+    QCOMPARE(window.nextTimeoutMs(0), static_cast<qint64>(1000));
+
+    // Occasional drops do not shrink the window, the lost indices are requested again after the ones never requested
+    const QList<ParameterRequestWindow::Request> requests = window.takeRequests(1000);
+    QCOMPARE(window.window(), ParameterRequestWindow::kInitialWindow);
+    QCOMPARE(static_cast<qint64>(requests.count()), static_cast<qint64>(ParameterRequestWindow::kInitialWindow));
+    QCOMPARE(requests.first().paramIndex, ParameterRequestWindow::kInitialWindow);
+    QVERIFY(window.lossRate() > 0.);
+    QCOMPARE(window.missingCount(), 100);
+    QCOMPARE(window.rtoMs(), static_cast<qint64>(1000));
+}
+
+void ParameterRequestWindowTest::_testHighLossShrinksWindow()
+{
+    ParameterRequestWindow window;
+    window.addComponent(1, 1000);
+
+    qint64 nowMs = 0;
+    (void) window.takeRequests(nowMs);
+    for (int i = 0; i < 5; i++) {
+        nowMs += window.nextTimeoutMs(nowMs);
+        (void) window.takeRequests(nowMs);
+    }
+
+    QVERIFY(window.lossRate() > 0.5);
+    QVERIFY(window.window() < ParameterRequestWindow::kInitialWindow);
+    QVERIFY(window.rtoMs() > 1000);
+    QVERIFY(window.inFlight() <= window.window());
+}
+
+void ParameterRequestWindowTest::_testRetransmitNoRttSample()
+{
+    ParameterRequestWindow window;
+    window.addComponent(1, 1);
+
+    QCOMPARE(static_cast<qint64>(window.takeRequests(0).count()), static_cast<qint64>(1));
+    QCOMPARE(static_cast<qint64>(window.takeRequests(1000).count()), static_cast<qint64>(1));
+
+    // Karn: the response may belong to either request
+    QVERIFY(window.received(1, 0, 1050));
+    QCOMPARE(window.rttMs(), 0.);
+    QCOMPARE(window.missingCount(), 0);
+    QCOMPARE(window.inFlight(), 0);
+}
+
+void ParameterRequestWindowTest::_testRetriesExhausted()
+{
+    ParameterRequestWindow window;
+    window.setMaxRetries(3);
+    window.addComponent(1, 1);
+
+    qint64 nowMs = 0;
+    for (int i = 0; i < 3; i++) {
+        const QList<ParameterRequestWindow::Request> requests = window.takeRequests(nowMs);
+        QCOMPARE(static_cast<qint64>(requests.count()), static_cast<qint64>(1));
+        QCOMPARE(window.missingCount(), 1);
+        nowMs += window.nextTimeoutMs(nowMs);
+    }
+
+    QVERIFY(window.takeRequests(nowMs).isEmpty());
+    QCOMPARE(window.missingCount(), 0);
+    QCOMPARE(window.failedIndices(1), QList<int>({ 0 }));
+    QCOMPARE(window.nextTimeoutMs(nowMs), static_cast<qint64>(-1));
+}
+
+void ParameterRequestWindowTest::_testNoRetries()
+{
+    ParameterRequestWindow window;
+    window.setMaxRetries(0);
+    window.addComponent(1, 20);
+    QVERIFY(window.received(1, 5, 0));
+
+    QVERIFY(window.takeRequests(0).isEmpty());
+    QCOMPARE(window.missingCount(), 0);
+    QCOMPARE(static_cast<qint64>(window.failedIndices(1).count()), static_cast<qint64>(19));
+}
+
+void ParameterRequestWindowTest::_testSetComplete()
+{
+    ParameterRequestWindow window;
+    window.addComponent(1, 10);
+    window.addComponent(2, 10);
+    QCOMPARE(static_cast<qint64>(window.takeRequests(0).count()), static_cast<qint64>(ParameterRequestWindow::kInitialWindow));
+
+    window.setComplete(1);
+    QCOMPARE(window.missingCount(1), 0);
+    QCOMPARE(window.missingCount(), 10);
+    QCOMPARE(window.inFlight(), 0);
+    QVERIFY(!window.isMissing(1, 0));
+
+    // Requests in flight for the completed component are stale and no longer time out
+    QCOMPARE(window.nextTimeoutMs(0), static_cast<qint64>(-1));
+
+    const QList<ParameterRequestWindow::Request> requests = window.takeRequests(0);
+    QCOMPARE(static_cast<qint64>(requests.count()), static_cast<qint64>(ParameterRequestWindow::kInitialWindow));
+    QCOMPARE(requests.first().componentId, 2);
+
+    // Complete for a component never seen
+    window.setComplete(3);
+    QVERIFY(window.hasComponent(3));
+    QCOMPARE(window.missingCount(3), 0);
+}
@@ -0,0 +1,30 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class ParameterRequestWindowTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    ParameterRequestWindowTest() = default;
+
+private slots:
+    void _testWindowLimitsRequests();
+    void _testRttEstimate();
+    void _testTimeoutRetries();
+    void _testHighLossShrinksWindow();
+    void _testRetransmitNoRttSample();
+    void _testRetriesExhausted();
+    void _testNoRetries();
+    void _testSetComplete();
+};
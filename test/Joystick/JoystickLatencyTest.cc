@@ -0,0 +1,52 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "JoystickLatencyTest.h"
+#include "Joystick.h"
+
+#include <QtTest/QTest>
+
+void JoystickLatencyTest::_testPercentiles()
+{
+    // 1 to 1000ms
+    QVector<quint32> sortedUs;
+    for (quint32 i = 1; i <= 1000; i++) {
+        sortedUs.append(i * 1000);
+    }
+
+    QCOMPARE(Joystick::latencyPercentileMs(sortedUs, 0), 1.0f);
+    QCOMPARE(Joystick::latencyPercentileMs(sortedUs, 50), 500.0f);
+    QCOMPARE(Joystick::latencyPercentileMs(sortedUs, 95), 950.0f);
+    QCOMPARE(Joystick::latencyPercentileMs(sortedUs, 99), 990.0f);
+    QCOMPARE(Joystick::latencyPercentileMs(sortedUs, 100), 1000.0f);
+    QCOMPARE(Joystick::latencyPercentileMs(sortedUs, 150), 1000.0f);
+
+    // Mostly fast with a slow tail
+    QVector<quint32> tailUs(100, 1500);
+    for (int i = 96; i < 100; i++) {
+        tailUs[i] = 20000;
+    }
+    QCOMPARE(Joystick::latencyPercentileMs(tailUs, 50), 1.5f);
+    QCOMPARE(Joystick::latencyPercentileMs(tailUs, 95), 1.5f);
+    QCOMPARE(Joystick::latencyPercentileMs(tailUs, 99), 20.0f);
+}
+
+void JoystickLatencyTest::_testFewSamples()
+{
+    QCOMPARE(Joystick::latencyPercentileMs(QVector<quint32>(), 50), 0.0f);
+
+    const QVector<quint32> single = { 2500 };
+    QCOMPARE(Joystick::latencyPercentileMs(single, 50), 2.5f);
+    QCOMPARE(Joystick::latencyPercentileMs(single, 99), 2.5f);
+
+    const QVector<quint32> two = { 1000, 3000 };
+    QCOMPARE(Joystick::latencyPercentileMs(two, 50), 1.0f);
+    QCOMPARE(Joystick::latencyPercentileMs(two, 99), 1.0f);
+    QCOMPARE(Joystick::latencyPercentileMs(two, 100), 3.0f);
+}
@@ -0,0 +1,196 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkFrameScannerTest.h"
+#include "MAVLinkFrameScanner.h"
+#include "MAVLinkSigning.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtTest/QTest>
+
+void MAVLinkFrameScannerTest::init()
+{
+    UnitTest::init();
+
+    _resetChannel(_encodeChannel);
+    _resetChannel(_bulkChannel);
+    _resetChannel(_bytewiseChannel);
+}
+
+void MAVLinkFrameScannerTest::_resetChannel(uint8_t channel)
+{
+    (void) MAVLinkSigning::initSigning(static_cast<mavlink_channel_t>(channel), QByteArrayView(), nullptr);
+    mavlink_reset_channel_status(channel);
+    mavlink_status_t *const status = mavlink_get_channel_status(channel);
+    status->flags = 0;
+    status->packet_rx_success_count = 0;
+    status->packet_rx_drop_count = 0;
+}
+
+/// Builds a stream of MAVLink 2 and MAVLink 1 frames with some line noise in between
+QByteArray MAVLinkFrameScannerTest::_buildStream(int messageCount)
+{
+    QByteArray stream;
+    mavlink_status_t *const encodeStatus = mavlink_get_channel_status(_encodeChannel);
+
+    for (int i = 0; i < messageCount; i++) {
+        mavlink_message_t message;
+
+        // Every 7th message goes out as MAVLink 1
+        if ((i % 7) == 6) {
+            encodeStatus->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        } else {
+            encodeStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        }
+
+        switch (i % 4) {
+        case 0:
+            (void) mavlink_msg_heartbeat_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _encodeChannel, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, 0, i, MAV_STATE_ACTIVE);
+            break;
+        case 1:
+            (void) mavlink_msg_attitude_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _encodeChannel, &message, i, 0.1f * i, -0.2f, 0.3f, 0.f, 0.f, 0.f);
+            break;
+        case 2:
+            // Mostly zero payload, exercises MAVLink 2 payload truncation
+            (void) mavlink_msg_param_value_pack_chan(2, MAV_COMP_ID_AUTOPILOT1, _encodeChannel, &message, "A", 0.f, MAV_PARAM_TYPE_REAL32, 0, 0);
+            break;
+        default:
+            (void) mavlink_msg_statustext_pack_chan(1, MAV_COMP_ID_USER1, _encodeChannel, &message, MAV_SEVERITY_INFO, "MAVLinkFrameScannerTest", 0, 0);
+            break;
+        }
+
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        const uint16_t len = mavlink_msg_to_send_buffer(buffer, &message);
+        (void) stream.append(reinterpret_cast<const char*>(buffer), len);
+
+        if ((i % 11) == 10) {
+            // Line noise between frames
+            (void) stream.append("\x00\x55\xAA", 3);
+        }
+    }
+
+    encodeStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+
+    return stream;
+}
+
+QList<mavlink_message_t> MAVLinkFrameScannerTest::_parse(uint8_t channel, const QByteArray &stream, qsizetype chunkSize, bool bytewiseOnly)
+{
+    QList<mavlink_message_t> messages;
+
+    for (qsizetype offset = 0; offset < stream.size(); offset += chunkSize) {
+        MAVLinkFrameScanner scanner(channel, QByteArrayView(stream).sliced(offset, qMin(chunkSize, stream.size() - offset)));
+        scanner.setBytewiseOnly(bytewiseOnly);
+
+        mavlink_message_t message;
+        while (scanner.next(message)) {
+            messages.append(message);
+        }
+    }
+
+    return messages;
+}
+
+void MAVLinkFrameScannerTest::_compareMessages(const QList<mavlink_message_t> &actual, const QList<mavlink_message_t> &expected)
+{
+    QCOMPARE(actual.count(), expected.count());
+
+    for (qsizetype i = 0; i < actual.count(); i++) {
+        const mavlink_message_t &a = actual[i];
+        const mavlink_message_t &e = expected[i];
+        QCOMPARE(static_cast<uint32_t>(a.msgid), static_cast<uint32_t>(e.msgid));
+        QCOMPARE(a.magic, e.magic);
+        QCOMPARE(a.len, e.len);
+        QCOMPARE(a.seq, e.seq);
+        QCOMPARE(a.sysid, e.sysid);
+        QCOMPARE(a.compid, e.compid);
+        QCOMPARE(a.checksum, e.checksum);
+
+        const mavlink_msg_entry_t *const entry = mavlink_get_msg_entry(a.msgid);
+        const size_t payloadLen = entry ? qMax<size_t>(entry->max_msg_len, a.len) : a.len;
+        QVERIFY(memcmp(_MAV_PAYLOAD(&a), _MAV_PAYLOAD(&e), payloadLen) == 0);
+    }
+}
+
+void MAVLinkFrameScannerTest::_testMatchesBytewise()
+{
+    const QByteArray stream = _buildStream(500);
+
+    const QList<mavlink_message_t> expected = _parse(_bytewiseChannel, stream, stream.size(), true);
+    const QList<mavlink_message_t> actual = _parse(_bulkChannel, stream, stream.size(), false);
+    QCOMPARE(expected.count(), 500);
+    _compareMessages(actual, expected);
+
+    const mavlink_status_t *const bulkStatus = mavlink_get_channel_status(_bulkChannel);
+    const mavlink_status_t *const bytewiseStatus = mavlink_get_channel_status(_bytewiseChannel);
+    QCOMPARE(bulkStatus->packet_rx_success_count, bytewiseStatus->packet_rx_success_count);
+    QCOMPARE(bulkStatus->current_rx_seq, bytewiseStatus->current_rx_seq);
+    QCOMPARE(bulkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1, bytewiseStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1);
+}
+
+void MAVLinkFrameScannerTest::_testSplitFrames()
+{
+    const QByteArray stream = _buildStream(200);
+    const QList<mavlink_message_t> expected = _parse(_bytewiseChannel, stream, stream.size(), true);
+
+    // Chunk sizes which split frames at every possible position
+    for (const qsizetype chunkSize : {1, 2, 5, 17, 64, 255, 1024}) {
+        _resetChannel(_bulkChannel);
+        _compareMessages(_parse(_bulkChannel, stream, chunkSize, false), expected);
+    }
+}
+
+void MAVLinkFrameScannerTest::_testBadCrcResync()
+{
+    QByteArray stream = _buildStream(20);
+
+    // Corrupt the CRC of the first frame, the scanner must resync exactly like the state machine
+    const qsizetype firstFrameLen = MAVLINK_NUM_NON_PAYLOAD_BYTES + static_cast<uint8_t>(stream[1]);
+    stream[firstFrameLen - 1] = static_cast<char>(stream[firstFrameLen - 1] ^ 0xFF);
+
+    const QList<mavlink_message_t> expected = _parse(_bytewiseChannel, stream, stream.size(), true);
+    QCOMPARE(expected.count(), 19);
+    _compareMessages(_parse(_bulkChannel, stream, stream.size(), false), expected);
+}
+
+/// Replays a tlog through both paths and reports messages/sec. Set QGC_BENCHMARK_TLOG to replay a captured
+/// log, otherwise a generated stream is used. Bytes are fed in datagram sized chunks, tlog timestamps
+/// are simply line noise to both parsers.
+void MAVLinkFrameScannerTest::_benchmarkTlogReplay()
+{
+    QByteArray stream;
+    const QString tlogPath = qEnvironmentVariable("QGC_BENCHMARK_TLOG");
+    if (!tlogPath.isEmpty()) {
+        QFile tlog(tlogPath);
+        QVERIFY(tlog.open(QIODevice::ReadOnly));
+        stream = tlog.readAll();
+    } else {
+        stream = _buildStream(100000);
+    }
+
+    constexpr qsizetype chunkSize = 512;
+
+    QElapsedTimer timer;
+    timer.start();
+    const QList<mavlink_message_t> expected = _parse(_bytewiseChannel, stream, chunkSize, true);
+    const qint64 bytewiseNsecs = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    timer.restart();
+    const QList<mavlink_message_t> actual = _parse(_bulkChannel, stream, chunkSize, false);
+    const qint64 bulkNsecs = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    QCOMPARE(actual.count(), expected.count());
+
+    const double bytewiseRate = expected.count() * 1e9 / bytewiseNsecs;
+    const double bulkRate = actual.count() * 1e9 / bulkNsecs;
+    qDebug() << "Messages:" << actual.count() << "bytes:" << stream.size();
+    qDebug() << "mavlink_parse_char msgs/sec:" << qRound64(bytewiseRate);
+    qDebug() << "MAVLinkFrameScanner msgs/sec:" << qRound64(bulkRate) << QStringLiteral("(%1x)").arg(bulkRate / bytewiseRate, 0, 'f', 2);
+}
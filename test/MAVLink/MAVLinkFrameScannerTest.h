@@ -0,0 +1,38 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class MAVLinkFrameScannerTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    MAVLinkFrameScannerTest() = default;
+
+private slots:
+    void init() final;
+
+    void _testMatchesBytewise();
+    void _testSplitFrames();
+    void _testBadCrcResync();
+    void _benchmarkTlogReplay();
+
+private:
+    static QByteArray _buildStream(int messageCount);
+    static QList<mavlink_message_t> _parse(uint8_t channel, const QByteArray &stream, qsizetype chunkSize, bool bytewiseOnly);
+    static void _compareMessages(const QList<mavlink_message_t> &actual, const QList<mavlink_message_t> &expected);
+    static void _resetChannel(uint8_t channel);
+
+    static constexpr uint8_t _encodeChannel = MAVLINK_COMM_13;
+    static constexpr uint8_t _bulkChannel = MAVLINK_COMM_14;
+    static constexpr uint8_t _bytewiseChannel = MAVLINK_COMM_15;
+};
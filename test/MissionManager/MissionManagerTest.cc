@@ -12,6 +12,7 @@
 #include "MissionManager.h"
 #include "MultiSignalSpy.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtTest/QTest>
 #include <QtTest/QSignalSpy>
 
@@ -317,6 +318,8 @@ void MissionManagerTest::_testWriteFailureHandlingAPM(void)
 void MissionManagerTest::_testReadFailureHandlingAPM(void)
 {
     _initForFirmwareType(MAV_AUTOPILOT_ARDUPILOTMEGA);
+    // The failures are simulated by the mission protocol
+    _mockLink->mockLinkFTP()->enableMissionFiles(false);
     _testReadFailureHandlingWorker();
 }
 
@@ -363,3 +366,95 @@ void MissionManagerTest::_testErrorAckFailureStrings(void)
     }
 
 }
+
+void MissionManagerTest::_testReadFTPAPM(void)
+{
+    _initForFirmwareType(MAV_AUTOPILOT_ARDUPILOTMEGA);
+    _mockLink->mockLinkFTP()->enableMissionFiles(true);
+
+    // The mission protocol would fail, so the items can only come through FTP
+    _roundTripItems(MockLinkMissionItemHandler::FailReadRequestListNoResponse, MAV_MISSION_ERROR, false /* shouldFail */);
+}
+
+void MissionManagerTest::_testReadFTPFallbackAPM(void)
+{
+    _initForFirmwareType(MAV_AUTOPILOT_ARDUPILOTMEGA);
+    _mockLink->mockLinkFTP()->enableMissionFiles(false);
+
+    // The vehicle has no mission files, the read falls back to the mission protocol
+    _roundTripItems(MockLinkMissionItemHandler::FailNone, MAV_MISSION_ERROR, false /* shouldFail */);
+}
+
+void MissionManagerTest::_writeWaypoints(int count)
+{
+    QList<MissionItem*> missionItems;
+
+    // Home position item on the front, as the editor does
+    for (int i=0; i<=count; i++) {
+        missionItems.append(new MissionItem(i,
+                                            MAV_CMD_NAV_WAYPOINT,
+                                            MAV_FRAME_GLOBAL_RELATIVE_ALT,
+                                            0, 0, 0, 0,
+                                            47.3769 + (i * 1e-4), 8.549444 + (i * 1e-4), 50,
+                                            true,   // autoContinue
+                                            false,  // isCurrentItem
+                                            this));
+    }
+
+    _missionManager->writeMissionItems(missionItems);
+    QVERIFY(_multiSpyMissionManager->waitForSignalByIndex(sendCompleteSignalIndex, _missionManagerSignalWaitTime * 10));
+    QCOMPARE(_multiSpyMissionManager->checkSignalByMask(errorSignalMask), false);
+    _multiSpyMissionManager->clearAllSignals();
+}
+
+qint64 MissionManagerTest::_loadFromVehicleMsecs(void)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    _missionManager->loadFromVehicle();
+    if (!_multiSpyMissionManager->waitForSignalByIndex(newMissionItemsAvailableSignalIndex, _missionManagerSignalWaitTime * 10)) {
+        return -1;
+    }
+    const qint64 msecs = timer.elapsed();
+
+    if (_multiSpyMissionManager->checkSignalByMask(errorSignalMask)) {
+        return -1;
+    }
+    _multiSpyMissionManager->clearAllSignals();
+
+    return msecs;
+}
+
+void MissionManagerTest::_testReadFTPBenchmark(void)
+{
+    static constexpr int cWaypoints = 500;
+
+    _initForFirmwareType(MAV_AUTOPILOT_ARDUPILOTMEGA);
+    _writeWaypoints(cWaypoints);
+
+    _mockLink->mockLinkFTP()->enableMissionFiles(true);
+    const qint64 ftpMsecs = _loadFromVehicleMsecs();
+    QVERIFY(ftpMsecs >= 0);
+    QCOMPARE(_missionManager->missionItems().count(), cWaypoints + 1);
+
+    QList<QGeoCoordinate> ftpCoordinates;
+    for (const MissionItem* item: _missionManager->missionItems()) {
+        ftpCoordinates.append(item->coordinate());
+    }
+
+    // Includes the failed FTP open before falling back, as with a vehicle without mission files
+    _mockLink->mockLinkFTP()->enableMissionFiles(false);
+    const qint64 missionProtocolMsecs = _loadFromVehicleMsecs();
+    QVERIFY(missionProtocolMsecs >= 0);
+    QCOMPARE(_missionManager->missionItems().count(), cWaypoints + 1);
+
+    for (int i=0; i<ftpCoordinates.count(); i++) {
+        const MissionItem* item = _missionManager->missionItems()[i];
+        QCOMPARE(item->sequenceNumber(), i);
+        QCOMPARE(item->coordinate(), ftpCoordinates[i]);
+    }
+
+    qDebug() << "Reading" << cWaypoints << "waypoints through FTP took" << ftpMsecs << "msecs";
+    qDebug() << "Reading" << cWaypoints << "waypoints through the mission protocol took" << missionProtocolMsecs << "msecs";
+}
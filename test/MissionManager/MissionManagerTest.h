@@ -26,6 +26,9 @@ private slots:
     void _testReadFailureHandlingPX4(void);
     //void _testReadFailureHandlingAPM(void);
     //void _testErrorAckFailureStrings(void);
+    void _testReadFTPAPM(void);
+    void _testReadFTPFallbackAPM(void);
+    void _testReadFTPBenchmark(void);
 
 private:
     void _testWriteFailureHandlingPX4(void);
@@ -37,6 +40,8 @@ private:
     void _writeItems(MockLinkMissionItemHandler::FailureMode_t failureMode, MAV_MISSION_RESULT failureAckResult, bool shouldFail);
     void _testWriteFailureHandlingWorker(void);
     void _testReadFailureHandlingWorker(void);
+    void _writeWaypoints(int count);
+    qint64 _loadFromVehicleMsecs(void);
     
     static const TestCase_t _rgTestCases[];
     static const size_t     _cTestCases;
@@ -0,0 +1,212 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileArchiveTest.h"
+#include "QGCMBTiles.h"
+#include "QGCPMTiles.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+#include <QtTest/QTest>
+
+static QString _tileKey(int z, int x, int y)
+{
+    return QStringLiteral("%1/%2/%3").arg(z).arg(x).arg(y);
+}
+
+/// Tiles of zoom levels 0 to 2 with distinct contents
+static QHash<QString, QByteArray> _testTiles()
+{
+    return {
+        { _tileKey(0, 0, 0), QByteArrayLiteral("tile 0/0/0") },
+        { _tileKey(1, 1, 0), QByteArrayLiteral("tile 1/1/0") },
+        { _tileKey(2, 3, 1), QByteArrayLiteral("tile 2/3/1") },
+        { _tileKey(2, 0, 3), QByteArrayLiteral("tile 2/0/3") },
+    };
+}
+
+void QGCTileArchiveTest::_testMBTilesRoundTrip()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = tempDir.filePath(QStringLiteral("test.mbtiles"));
+    const QHash<QString, QByteArray> tiles = _testTiles();
+
+    {
+        QGCMBTilesWriter writer(path);
+        QVERIFY2(writer.isValid(), qPrintable(writer.errorString()));
+        for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+            const QStringList zxy = it.key().split('/');
+            QVERIFY(writer.addTile(zxy[0].toInt(), zxy[1].toInt(), zxy[2].toInt(), it.value()));
+        }
+        QVERIFY(!writer.addTile(1, 2, 0, QByteArrayLiteral("outside of zoom level 1")));
+        QVERIFY(!writer.addTile(1, 0, 0, QByteArray()));
+        QCOMPARE(writer.tileCount(), static_cast<quint64>(tiles.count()));
+        QVERIFY2(writer.finish({ { QStringLiteral("name"), QStringLiteral("Test") }, { QStringLiteral("bounds"), QStringLiteral("-90.5,-45,90,45.25") }, { QStringLiteral("qgc_map_type"), QStringLiteral("Bing Satellite") } }), qPrintable(writer.errorString()));
+    }
+
+    // Rows are stored counted from the south
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("QGCTileArchiveTest"));
+        db.setDatabaseName(path);
+        QVERIFY(db.open());
+        QSqlQuery query(db);
+        QVERIFY(query.exec(QStringLiteral("SELECT tile_row FROM tiles WHERE zoom_level = 2 AND tile_column = 3")));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toInt(), 2);
+        query.finish();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(QStringLiteral("QGCTileArchiveTest"));
+
+    QGCMBTilesReader reader(path);
+    QVERIFY2(reader.isValid(), qPrintable(reader.errorString()));
+    QCOMPARE(reader.tileCount(), static_cast<quint64>(tiles.count()));
+    QCOMPARE(reader.minZoom(), 0);
+    QCOMPARE(reader.maxZoom(), 2);
+    QCOMPARE(reader.metadata().value(QStringLiteral("name")), QStringLiteral("Test"));
+    QCOMPARE(reader.metadata().value(QStringLiteral("qgc_map_type")), QStringLiteral("Bing Satellite"));
+
+    double west, south, east, north;
+    reader.bounds(west, south, east, north);
+    QCOMPARE(west, -90.5);
+    QCOMPARE(south, -45.0);
+    QCOMPARE(east, 90.0);
+    QCOMPARE(north, 45.25);
+
+    QHash<QString, QByteArray> readTiles;
+    QVERIFY(reader.forEachTile([&readTiles](int z, int x, int y, const QByteArray &data) {
+        readTiles.insert(_tileKey(z, x, y), data);
+        return true;
+    }));
+    QCOMPARE(readTiles, tiles);
+
+    int visited = 0;
+    QVERIFY(!reader.forEachTile([&visited](int, int, int, const QByteArray&) {
+        visited++;
+        return false;
+    }));
+    QCOMPARE(visited, 1);
+
+    QVERIFY(!QGCMBTilesReader(tempDir.filePath(QStringLiteral("missing.mbtiles"))).isValid());
+}
+
+void QGCTileArchiveTest::_testPMTilesTileId()
+{
+    // Values from the PMTiles reference implementation
+    QCOMPARE(QGCPMTiles::zxyToTileId(0, 0, 0), Q_UINT64_C(0));
+    QCOMPARE(QGCPMTiles::zxyToTileId(1, 0, 0), Q_UINT64_C(1));
+    QCOMPARE(QGCPMTiles::zxyToTileId(1, 0, 1), Q_UINT64_C(2));
+    QCOMPARE(QGCPMTiles::zxyToTileId(1, 1, 1), Q_UINT64_C(3));
+    QCOMPARE(QGCPMTiles::zxyToTileId(1, 1, 0), Q_UINT64_C(4));
+    QCOMPARE(QGCPMTiles::zxyToTileId(2, 0, 0), Q_UINT64_C(5));
+    QCOMPARE(QGCPMTiles::zxyToTileId(12, 3423, 1763), Q_UINT64_C(19078479));
+
+    // Every tile of the lower zoom levels, and corners and an inner tile of the highest one
+    for (int z = 0; z <= 8; z++) {
+        for (int x = 0; x < (1 << z); x++) {
+            for (int y = 0; y < (1 << z); y++) {
+                int z2, x2, y2;
+                QGCPMTiles::tileIdToZxy(QGCPMTiles::zxyToTileId(z, x, y), z2, x2, y2);
+                QVERIFY((z2 == z) && (x2 == x) && (y2 == y));
+            }
+        }
+    }
+
+    const int z = QGCPMTiles::kMaxZoom;
+    const int last = (1 << z) - 1;
+    const QList<QPair<int, int>> tiles = { { 0, 0 }, { last, 0 }, { 0, last }, { last, last }, { 12345678, 23456789 } };
+    for (const QPair<int, int> &tile : tiles) {
+        int z2, x2, y2;
+        QGCPMTiles::tileIdToZxy(QGCPMTiles::zxyToTileId(z, tile.first, tile.second), z2, x2, y2);
+        QCOMPARE(z2, z);
+        QCOMPARE(x2, tile.first);
+        QCOMPARE(y2, tile.second);
+    }
+}
+
+void QGCTileArchiveTest::_testPMTilesDirectory()
+{
+    // One entry, offset stored + 1
+    const QByteArray single = QGCPMTiles::serializeDirectory({ QGCPMTiles::Entry{ 0, 0, 100, 1 } });
+    QCOMPARE(single, QByteArray("\x01\x00\x01\x64\x01", 5));
+
+    const std::vector<QGCPMTiles::Entry> entries = {
+        { 0, 0, 100, 1 },
+        { 5, 100, 200, 3 },         // Contiguous with the previous tile, a run of three
+        { 300, 5000, 1000, 1 },
+        { 70000, 6000, 20, 0 },     // Leaf directory, multi byte varints
+    };
+    const QByteArray data = QGCPMTiles::serializeDirectory(entries);
+
+    std::vector<QGCPMTiles::Entry> decoded;
+    QVERIFY(QGCPMTiles::deserializeDirectory(data, decoded));
+    QCOMPARE(decoded.size(), entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        QCOMPARE(decoded[i].tileId, entries[i].tileId);
+        QCOMPARE(decoded[i].offset, entries[i].offset);
+        QCOMPARE(decoded[i].length, entries[i].length);
+        QCOMPARE(decoded[i].runLength, entries[i].runLength);
+    }
+
+    QVERIFY(!QGCPMTiles::deserializeDirectory(data.chopped(1), decoded));
+    QVERIFY(!QGCPMTiles::deserializeDirectory(QByteArray(), decoded));
+}
+
+void QGCTileArchiveTest::_testPMTilesRoundTrip()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString path = tempDir.filePath(QStringLiteral("test.pmtiles"));
+    const QHash<QString, QByteArray> tiles = _testTiles();
+
+    {
+        QGCPMTilesWriter writer(path);
+        QVERIFY2(writer.isValid(), qPrintable(writer.errorString()));
+        for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+            const QStringList zxy = it.key().split('/');
+            QVERIFY(writer.addTile(zxy[0].toInt(), zxy[1].toInt(), zxy[2].toInt(), it.value()));
+        }
+        // Tile ids 1 and 2, the same content is stored once
+        QVERIFY(writer.addTile(1, 0, 0, QByteArrayLiteral("water")));
+        QVERIFY(writer.addTile(1, 0, 1, QByteArrayLiteral("water")));
+
+        QGCPMTiles::Header header;
+        header.tileType = QGCPMTiles::TileTypePng;
+        QVERIFY2(writer.finish(header, QJsonObject{ { QStringLiteral("qgc_map_type"), QStringLiteral("Bing Satellite") } }), qPrintable(writer.errorString()));
+    }
+
+    QGCPMTilesReader reader(path);
+    QVERIFY2(reader.isValid(), qPrintable(reader.errorString()));
+    QCOMPARE(reader.header().addressedTiles, static_cast<quint64>(tiles.count() + 2));
+    QCOMPARE(reader.header().tileContents, static_cast<quint64>(tiles.count() + 1));
+    QCOMPARE(reader.header().minZoom, static_cast<quint8>(0));
+    QCOMPARE(reader.header().maxZoom, static_cast<quint8>(2));
+    QCOMPARE(reader.header().tileType, QGCPMTiles::TileTypePng);
+    QCOMPARE(reader.metadata().value(QStringLiteral("qgc_map_type")).toString(), QStringLiteral("Bing Satellite"));
+
+    QCOMPARE(reader.tile(2, 3, 1), tiles.value(_tileKey(2, 3, 1)));
+    QCOMPARE(reader.tile(1, 0, 0), QByteArrayLiteral("water"));
+    QCOMPARE(reader.tile(1, 0, 1), QByteArrayLiteral("water"));
+    QVERIFY(reader.tile(2, 2, 2).isEmpty());
+
+    QHash<QString, QByteArray> readTiles;
+    QVERIFY(reader.forEachTile([&readTiles](int z, int x, int y, const QByteArray &data) {
+        readTiles.insert(_tileKey(z, x, y), data);
+        return true;
+    }));
+    QCOMPARE(readTiles.count(), tiles.count() + 2);
+    for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+        QCOMPARE(readTiles.value(it.key()), it.value());
+    }
+}
@@ -0,0 +1,150 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileDownloadLimiterTest.h"
+#include "QGCTileDownloadLimiter.h"
+
+#include <QtTest/QTest>
+
+#include <functional>
+
+/// Feeds responses with all requests of the limit in flight
+///     @param latency Latency of response i with the given limit
+static void _feed(QGCTileDownloadLimiter &limiter, int count, const std::function<qint64(int i, int limit)> &latency)
+{
+    for (int i = 0; i < count; i++) {
+        limiter.requestSucceeded(i * 10, latency(i, limiter.limit()), 1000, limiter.limit());
+    }
+}
+
+void QGCTileDownloadLimiterTest::_testConstantLatency()
+{
+    QGCTileDownloadLimiter limiter;
+    QCOMPARE(limiter.limit(), QGCTileDownloadLimiter::kDefaultInitialLimit);
+
+    // The lowest latency is not taken from the first few responses
+    _feed(limiter, 19, [](int, int) { return 100; });
+    QCOMPARE(limiter.limit(), QGCTileDownloadLimiter::kDefaultInitialLimit);
+    QCOMPARE(limiter.baseLatencyMs(), 0.);
+
+    _feed(limiter, 2000, [](int, int) { return 100; });
+    QCOMPARE(limiter.limit(), QGCTileDownloadLimiter::kDefaultMaxLimit);
+    QCOMPARE(limiter.latencyMs(), 100.);
+    QCOMPARE(limiter.baseLatencyMs(), 100.);
+}
+
+void QGCTileDownloadLimiterTest::_testJitteryLatency()
+{
+    // 50 to 150ms spread evenly, with no queueing at all
+    QGCTileDownloadLimiter limiter;
+    _feed(limiter, 5000, [](int i, int) { return 50 + ((i * 37) % 101); });
+    QCOMPARE(limiter.limit(), QGCTileDownloadLimiter::kDefaultMaxLimit);
+    QVERIFY(limiter.latencyDeviationMs() > 10.);
+}
+
+void QGCTileDownloadLimiterTest::_testQueueing()
+{
+    // The server handles 10 requests at a time, the others queue
+    QGCTileDownloadLimiter limiter;
+    _feed(limiter, 5000, [](int, int limit) { return static_cast<qint64>(100 * qMax(1., limit / 10.)); });
+    QVERIFY2((limiter.limit() >= 13) && (limiter.limit() <= 16), qPrintable(QString::number(limiter.limit())));
+    QCOMPARE(limiter.baseLatencyMs(), 100.);
+
+    // With jitter on top
+    limiter.reset();
+    _feed(limiter, 5000, [](int i, int limit) { return static_cast<qint64>(100 * qMax(1., limit / 10.)) + ((i * 37) % 101); });
+    QVERIFY2((limiter.limit() >= 13) && (limiter.limit() <= 20), qPrintable(QString::number(limiter.limit())));
+}
+
+void QGCTileDownloadLimiterTest::_testFewInFlight()
+{
+    // Nothing to learn about the server if the limit is not used
+    QGCTileDownloadLimiter limiter;
+    for (int i = 0; i < 1000; i++) {
+        limiter.requestSucceeded(i * 10, 100, 1000, 1);
+    }
+    QCOMPARE(limiter.limit(), QGCTileDownloadLimiter::kDefaultInitialLimit);
+}
+
+void QGCTileDownloadLimiterTest::_testUnknownLatency()
+{
+    QGCTileDownloadLimiter limiter;
+    for (int i = 0; i < 1000; i++) {
+        limiter.requestSucceeded(i * 10, -1, 1000, limiter.limit());
+    }
+    QCOMPARE(limiter.limit(), QGCTileDownloadLimiter::kDefaultInitialLimit);
+    QCOMPARE(limiter.latencyMs(), 0.);
+    QVERIFY(limiter.tilesPerSecond(10000) > 0.);
+}
+
+void QGCTileDownloadLimiterTest::_testErrors()
+{
+    QGCTileDownloadLimiter limiter(20);
+
+    limiter.requestFailed(0);
+    QCOMPARE(limiter.limit(), 18);
+    QCOMPARE(limiter.backoffRemaining(0), Q_INT64_C(0));
+
+    limiter.requestFailed(0);
+    QCOMPARE(limiter.backoffRemaining(0), Q_INT64_C(0));
+
+    // Backs off from the third error in a row, twice as long every time
+    limiter.requestFailed(1000);
+    QCOMPARE(limiter.backoffRemaining(1000), Q_INT64_C(500));
+    limiter.requestFailed(2000);
+    QCOMPARE(limiter.backoffRemaining(2000), Q_INT64_C(1000));
+    QCOMPARE(limiter.backoffRemaining(5000), Q_INT64_C(0));
+
+    // A success ends the run of errors
+    limiter.requestSucceeded(5000, 100, 1000, 1);
+    limiter.requestFailed(5000);
+    QCOMPARE(limiter.backoffRemaining(5000), Q_INT64_C(0));
+
+    limiter.reset();
+    QCOMPARE(limiter.limit(), 20);
+}
+
+void QGCTileDownloadLimiterTest::_testThrottled()
+{
+    QGCTileDownloadLimiter limiter(20);
+
+    limiter.requestThrottled(0, 0);
+    QCOMPARE(limiter.limit(), 10);
+    QCOMPARE(limiter.backoffRemaining(0), Q_INT64_C(1000));
+
+    // Retry-After wins over a shorter backoff
+    limiter.requestThrottled(0, 5000);
+    QCOMPARE(limiter.limit(), 5);
+    QCOMPARE(limiter.backoffRemaining(0), Q_INT64_C(5000));
+    QCOMPARE(limiter.backoffRemaining(4000), Q_INT64_C(1000));
+
+    for (int i = 0; i < 10; i++) {
+        limiter.requestThrottled(0, 0);
+    }
+    QCOMPARE(limiter.limit(), 1);
+}
+
+void QGCTileDownloadLimiterTest::_testThroughput()
+{
+    QGCTileDownloadLimiter limiter;
+    QCOMPARE(limiter.tilesPerSecond(0), 0.);
+    QCOMPARE(limiter.etaMs(100, 0), Q_INT64_C(-1));
+
+    // A tile every 100ms over the 10s window
+    for (int i = 0; i <= 100; i++) {
+        limiter.requestSucceeded(i * 100, 100, 1000, 1);
+    }
+    QCOMPARE(limiter.tilesPerSecond(10000), 10.1);
+    QCOMPARE(limiter.bytesPerSecond(10000), 10100.);
+    QCOMPARE(limiter.etaMs(101, 10000), Q_INT64_C(10000));
+
+    // Half of the window has gone by with no tiles
+    QCOMPARE(limiter.tilesPerSecond(15000), 5.1);
+    QCOMPARE(limiter.bytesPerSecond(15000), 5100.);
+}
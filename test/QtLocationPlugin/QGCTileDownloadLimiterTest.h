@@ -0,0 +1,27 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class QGCTileDownloadLimiterTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testConstantLatency();
+    void _testJitteryLatency();
+    void _testQueueing();
+    void _testFewInFlight();
+    void _testUnknownLatency();
+    void _testErrors();
+    void _testThrottled();
+    void _testThroughput();
+};
@@ -9,5 +9,176 @@
 
 #include "TerrainTileTest.h"
 #include "TerrainTile.h"
+#include "TerrainTileCache.h"
 
+#include <QtCore/QTemporaryDir>
+#include <QtPositioning/QGeoCoordinate>
 #include <QtTest/QTest>
+
+#include <cstring>
+
+/// 3 rows by 4 columns of 0.25 degree cells, the elevation of each cell is row * 10 + column
+QByteArray TerrainTileTest::_tileData()
+{
+    constexpr int16_t gridSizeLat = 3;
+    constexpr int16_t gridSizeLon = 4;
+
+    TerrainTile::TileInfo_t tileInfo;
+    tileInfo.swLat = 0.0;
+    tileInfo.swLon = 0.0;
+    tileInfo.neLat = 0.75;
+    tileInfo.neLon = 1.0;
+    tileInfo.minElevation = 0;
+    tileInfo.maxElevation = 23;
+    tileInfo.avgElevation = 11.5;
+    tileInfo.gridSizeLat = gridSizeLat;
+    tileInfo.gridSizeLon = gridSizeLon;
+
+    QByteArray data(sizeof(tileInfo) + (sizeof(int16_t) * gridSizeLat * gridSizeLon), Qt::Uninitialized);
+    (void) memcpy(data.data(), &tileInfo, sizeof(tileInfo));
+    int16_t* const elevations = reinterpret_cast<int16_t*>(data.data() + sizeof(tileInfo));
+    for (int16_t row = 0; row < gridSizeLat; row++) {
+        for (int16_t col = 0; col < gridSizeLon; col++) {
+            elevations[(row * gridSizeLon) + col] = static_cast<int16_t>((row * 10) + col);
+        }
+    }
+
+    return data;
+}
+
+void TerrainTileTest::_testElevation()
+{
+    const TerrainTile tile(_tileData());
+    QVERIFY(tile.isValid());
+    QCOMPARE(tile.maxElevation(), 23.0);
+
+    QCOMPARE(tile.elevation(QGeoCoordinate(0.1, 0.1)), 0.0);
+    QCOMPARE(tile.elevation(QGeoCoordinate(0.375, 0.625)), 12.0);
+    QCOMPARE(tile.elevation(QGeoCoordinate(0.7, 0.99)), 23.0);
+    QVERIFY(qIsNaN(tile.elevation(QGeoCoordinate(0.8, 0.5))));
+
+    // Header without the elevations
+    QVERIFY(!TerrainTile(_tileData().left(sizeof(TerrainTile::TileInfo_t))).isValid());
+}
+
+void TerrainTileTest::_testElevationsNearest()
+{
+    const TerrainTile tile(_tileData());
+
+    const QList<QGeoCoordinate> coordinates = {
+        QGeoCoordinate(0.1, 0.1),
+        QGeoCoordinate(0.375, 0.625),
+        QGeoCoordinate(0.6, 0.3),
+        QGeoCoordinate(0.8, 0.5),
+        QGeoCoordinate(0.7, 0.99),
+    };
+    QList<double> elevations(coordinates.count());
+    QCOMPARE(tile.elevations(coordinates.constData(), elevations.data(), coordinates.count()), static_cast<qsizetype>(1));
+
+    for (qsizetype i = 0; i < coordinates.count(); i++) {
+        const double elevation = tile.elevation(coordinates[i]);
+        if (qIsNaN(elevation)) {
+            QVERIFY(qIsNaN(elevations[i]));
+        } else {
+            QCOMPARE(elevations[i], elevation);
+        }
+    }
+}
+
+void TerrainTileTest::_testElevationsBilinear()
+{
+    const TerrainTile tile(_tileData());
+
+    const QList<QGeoCoordinate> coordinates = {
+        QGeoCoordinate(0.375, 0.625),   // Cell center
+        QGeoCoordinate(0.375, 0.75),    // Between two cell centers of a row
+        QGeoCoordinate(0.5, 0.75),      // Between four cell centers
+        QGeoCoordinate(0.1, 0.1),       // Within half a cell of the south west corner
+        QGeoCoordinate(0.75, 1.0),      // North east corner
+        QGeoCoordinate(-0.1, 0.5),
+    };
+    QList<double> elevations(coordinates.count());
+    QCOMPARE(tile.elevations(coordinates.constData(), elevations.data(), coordinates.count(), TerrainTile::Interpolation::Bilinear), static_cast<qsizetype>(1));
+
+    QCOMPARE(elevations[0], 12.0);
+    QCOMPARE(elevations[1], 12.5);
+    QCOMPARE(elevations[2], 17.5);
+    QCOMPARE(elevations[3], 0.0);
+    QCOMPARE(elevations[4], 23.0);
+    QVERIFY(qIsNaN(elevations[5]));
+}
+
+void TerrainTileTest::_testCacheDisk()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    {
+        TerrainTileCache cache(dir.path());
+        QVERIFY(!cache.tile(QStringLiteral("tile")));
+        QVERIFY(cache.insert(QStringLiteral("tile"), _tileData()));
+        QVERIFY(!cache.insert(QStringLiteral("bad"), _tileData().left(10)));
+        QCOMPARE(cache.memoryTileCount(), static_cast<qsizetype>(1));
+    }
+
+    // A new cache on the same directory loads the tile from disk
+    TerrainTileCache cache(dir.path());
+    QCOMPARE(cache.memoryTileCount(), static_cast<qsizetype>(0));
+    const std::shared_ptr<const TerrainTile> tile = cache.tile(QStringLiteral("tile"));
+    QVERIFY(tile);
+    QVERIFY(tile->isValid());
+    QCOMPARE(tile->elevation(QGeoCoordinate(0.375, 0.625)), 12.0);
+    QCOMPARE(cache.memoryTileCount(), static_cast<qsizetype>(1));
+    QVERIFY(!cache.tile(QStringLiteral("bad")));
+
+    // A tile handed out stays usable after the cache drops it
+    cache.clearMemory();
+    QCOMPARE(tile->elevation(QGeoCoordinate(0.7, 0.99)), 23.0);
+}
+
+void TerrainTileTest::_testCacheDiskBound()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QByteArray data = _tileData();
+    const qint64 maxDiskBytes = 4 * (data.size() + 8);
+
+    {
+        TerrainTileCache cache(dir.path(), TerrainTileCache::kDefaultMaxMemoryBytes, maxDiskBytes);
+        for (int i = 0; i < 10; i++) {
+            QVERIFY(cache.insert(QString::number(i), data));
+            QVERIFY(cache.diskBytes() <= cache.maxDiskBytes());
+        }
+        QVERIFY(cache.diskBytes() > 0);
+    }
+
+    const QStringList files = QDir(dir.path()).entryList(QDir::Files);
+    QVERIFY(!files.isEmpty());
+    QVERIFY(files.count() <= 4);
+
+    // Usage is picked up again from the directory, tightening the budget prunes on startup
+    TerrainTileCache cache(dir.path(), TerrainTileCache::kDefaultMaxMemoryBytes, data.size() + 8);
+    QCOMPARE(cache.diskBytes(), static_cast<qint64>(data.size() + 8));
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Files).count(), static_cast<qsizetype>(1));
+}
+
+void TerrainTileTest::_testCacheMemoryBound()
+{
+    const QByteArray data = _tileData();
+    TerrainTileCache cache(QString(), 3 * data.size());
+
+    for (int i = 0; i < 10; i++) {
+        QVERIFY(cache.insert(QString::number(i), data));
+        QVERIFY(cache.memoryBytes() <= cache.maxMemoryBytes());
+        // Keep tile 0 the most recently used
+        QVERIFY(cache.tile(QStringLiteral("0")));
+    }
+    QCOMPARE(cache.memoryTileCount(), static_cast<qsizetype>(3));
+    QVERIFY(cache.tile(QStringLiteral("9")));
+    QVERIFY(cache.tile(QStringLiteral("8")));
+    QVERIFY(!cache.tile(QStringLiteral("7")));
+
+    // No disk tier, evicted tiles are gone
+    QVERIFY(!cache.tile(QStringLiteral("1")));
+}
@@ -16,4 +16,13 @@ class TerrainTileTest : public UnitTest
     Q_OBJECT
 
 private slots:
+    void _testElevation();
+    void _testElevationsNearest();
+    void _testElevationsBilinear();
+    void _testCacheDisk();
+    void _testCacheDiskBound();
+    void _testCacheMemoryBound();
+
+private:
+    static QByteArray _tileData();
 };
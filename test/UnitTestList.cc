@@ -17,8 +17,9 @@
 // AnalyzeView
 #include "ExifParserTest.h"
 #include "GeoTagControllerTest.h"
+#include "MAVLinkChartDecimatorTest.h"
 // #include "MavlinkLogTest.h"
-// #include "LogDownloadTest.h"
+#include "LogDownloadTest.h"
 #include "PX4LogParserTest.h"
 #include "ULogParserTest.h"
 
@@ -32,12 +33,18 @@
 #include "QGCCameraManagerTest.h"
 
 // Comms
+#include "LogReplayIndexTest.h"
+#include "LogReplayLinkTest.h"
+#include "MAVLinkTlogWriterTest.h"
 #include "QGCSerialPortInfoTest.h"
 
 // FactSystem
 #include "FactSystemTestGeneric.h"
 #include "FactSystemTestPX4.h"
+#include "ParameterCacheTest.h"
 #include "ParameterManagerTest.h"
+#include "ParameterMetaDataCacheTest.h"
+#include "ParameterRequestWindowTest.h"
 
 // FollowMe
 #include "FollowMeTest.h"
@@ -48,7 +55,11 @@
 // GPS
 #include "GpsTest.h"
 
+// Joystick
+#include "JoystickLatencyTest.h"
+
 // MAVLink
+#include "MAVLinkFrameScannerTest.h"
 #include "StatusTextHandlerTest.h"
 #include "SigningTest.h"
 
@@ -85,6 +96,10 @@
 
 // QmlControls
 
+// QtLocationPlugin
+#include "QGCTileArchiveTest.h"
+#include "QGCTileDownloadLimiterTest.h"
+
 // Terrain
 #include "TerrainQueryTest.h"
 #include "TerrainTileTest.h"
@@ -95,6 +110,7 @@
 // Compression
 #include "DecompressionTest.h"
 #include "QGCFileDownloadTest.h"
+#include "QGCSPSCRingTest.h"
 
 // Vehicle
 // Components
@@ -106,6 +122,14 @@
 // #include "RequestMessageTest.h"
 // #include "SendMavCommandWithHandlerTest.h"
 // #include "SendMavCommandWithSignalingTest.h"
+#include "VehicleMessageDispatcherTest.h"
+
+// VideoManager
+#include "TelemetryTrackTest.h"
+#include "VideoFrameStatsTest.h"
+#ifdef QGC_VIDEO_FRAME_TAP
+#include "VideoFrameTapTest.h"
+#endif
 
 // Missing
 // #include "FlightGearUnitTest.h"
@@ -123,8 +147,9 @@ int runTests(bool stress, QStringView unitTestOptions)
     // AnalyzeView
     UT_REGISTER_TEST(ExifParserTest)
     UT_REGISTER_TEST(GeoTagControllerTest)
+    UT_REGISTER_TEST(MAVLinkChartDecimatorTest)
     // UT_REGISTER_TEST(MavlinkLogTest)
-    // UT_REGISTER_TEST(LogDownloadTest)
+    UT_REGISTER_TEST(LogDownloadTest)
     UT_REGISTER_TEST(PX4LogParserTest)
     UT_REGISTER_TEST(ULogParserTest)
 
@@ -138,12 +163,18 @@ int runTests(bool stress, QStringView unitTestOptions)
     UT_REGISTER_TEST(QGCCameraManagerTest)
 
     // Comms
+    UT_REGISTER_TEST(LogReplayIndexTest)
+    UT_REGISTER_TEST(LogReplayLinkTest)
+    UT_REGISTER_TEST(MAVLinkTlogWriterTest)
     UT_REGISTER_TEST(QGCSerialPortInfoTest)
 
     // FactSystem
     UT_REGISTER_TEST(FactSystemTestGeneric)
     UT_REGISTER_TEST(FactSystemTestPX4)
+    UT_REGISTER_TEST(ParameterCacheTest)
     UT_REGISTER_TEST(ParameterManagerTest)
+    UT_REGISTER_TEST(ParameterMetaDataCacheTest)
+    UT_REGISTER_TEST(ParameterRequestWindowTest)
 
     // FollowMe
     UT_REGISTER_TEST(FollowMeTest)
@@ -154,7 +185,11 @@ int runTests(bool stress, QStringView unitTestOptions)
     // GPS
     // UT_REGISTER_TEST(GpsTest)
 
+    // Joystick
+    UT_REGISTER_TEST(JoystickLatencyTest)
+
     // MAVLink
+    UT_REGISTER_TEST(MAVLinkFrameScannerTest)
     UT_REGISTER_TEST(StatusTextHandlerTest)
     UT_REGISTER_TEST(SigningTest)
 
@@ -189,6 +224,10 @@ int runTests(bool stress, QStringView unitTestOptions)
 
     // QmlControls
 
+    // QtLocationPlugin
+    UT_REGISTER_TEST(QGCTileArchiveTest)
+    UT_REGISTER_TEST(QGCTileDownloadLimiterTest)
+
     // Terrain
     UT_REGISTER_TEST(TerrainQueryTest)
     UT_REGISTER_TEST(TerrainTileTest)
@@ -199,6 +238,7 @@ int runTests(bool stress, QStringView unitTestOptions)
     // Compression
     UT_REGISTER_TEST(DecompressionTest)
     UT_REGISTER_TEST(QGCFileDownloadTest)
+    UT_REGISTER_TEST(QGCSPSCRingTest)
 
     // Vehicle
     // Components
@@ -210,6 +250,14 @@ int runTests(bool stress, QStringView unitTestOptions)
     // UT_REGISTER_TEST(RequestMessageTest)
     // UT_REGISTER_TEST(SendMavCommandWithHandlerTest)
     // UT_REGISTER_TEST(SendMavCommandWithSignalingTest)
+    UT_REGISTER_TEST(VehicleMessageDispatcherTest)
+
+    // VideoManager
+    UT_REGISTER_TEST(TelemetryTrackTest)
+    UT_REGISTER_TEST(VideoFrameStatsTest)
+#ifdef QGC_VIDEO_FRAME_TAP
+    UT_REGISTER_TEST(VideoFrameTapTest)
+#endif
 
     // Missing
     // UT_REGISTER_TEST(FlightGearUnitTest)
@@ -3,6 +3,7 @@
 #include "QGCZlib.h"
 #include "QGCZip.h"
 
+#include <QtCore/QFile>
 #include <QtTest/QTest>
 
 void DecompressionTest::_testDecompressGzip()
@@ -13,6 +14,24 @@ void DecompressionTest::_testDecompressGzip()
 	QVERIFY(result);
 }
 
+void DecompressionTest::_testInflateGzipData()
+{
+    QFile gzippedFile(QStringLiteral(":/manifest.json.gz"));
+    QVERIFY(gzippedFile.open(QIODevice::ReadOnly));
+    const QByteArray gzippedData = gzippedFile.readAll();
+
+    const QString decompressedFilename = QStringLiteral("manifest.json");
+    QVERIFY(QGCZlib::inflateGzipFile(gzippedFile.fileName(), decompressedFilename));
+    QFile decompressedFile(decompressedFilename);
+    QVERIFY(decompressedFile.open(QIODevice::ReadOnly));
+
+    const QByteArray result = QGCZlib::inflateGzip(gzippedData);
+    QVERIFY(!result.isEmpty());
+    QCOMPARE(result, decompressedFile.readAll());
+
+    QVERIFY(QGCZlib::inflateGzip(gzippedData.left(gzippedData.size() / 2)).isEmpty());
+}
+
 void DecompressionTest::_testDecompressLZMA()
 {
     const QString lzmaFilename = QStringLiteral(":/manifest.json.xz");
@@ -8,6 +8,7 @@ class DecompressionTest : public UnitTest
 
 private slots:
     void _testDecompressGzip();
+    void _testInflateGzipData();
     void _testDecompressLZMA();
     void _testUnzip();
 };
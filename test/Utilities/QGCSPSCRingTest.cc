@@ -0,0 +1,93 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCSPSCRingTest.h"
+#include "QGCSPSCRing.h"
+
+#include <QtCore/QThread>
+#include <QtTest/QTest>
+
+void QGCSPSCRingTest::_testPushPop()
+{
+    QGCSPSCRing<int, 8> ring;
+    QVERIFY(ring.isEmpty());
+    QVERIFY(!ring.front());
+
+    QVERIFY(ring.push(1));
+    QVERIFY(ring.push(2));
+    QCOMPARE(ring.size(), 2);
+
+    int value = 0;
+    QVERIFY(ring.pop(value));
+    QCOMPARE(value, 1);
+
+    int *const front = ring.front();
+    QVERIFY(front);
+    QCOMPARE(*front, 2);
+    ring.popFront();
+
+    QVERIFY(ring.isEmpty());
+    QVERIFY(!ring.pop(value));
+}
+
+void QGCSPSCRingTest::_testFull()
+{
+    QGCSPSCRing<int, 4> ring;
+    for (int i = 0; i < ring.capacity(); i++) {
+        QVERIFY(ring.push(i));
+    }
+    QVERIFY(!ring.push(99));
+    QVERIFY(!ring.beginPush());
+
+    // Wrap around
+    int value = 0;
+    QVERIFY(ring.pop(value));
+    QCOMPARE(value, 0);
+    QVERIFY(ring.push(4));
+    for (int i = 1; i <= 4; i++) {
+        QVERIFY(ring.pop(value));
+        QCOMPARE(value, i);
+    }
+    QVERIFY(ring.isEmpty());
+}
+
+void QGCSPSCRingTest::_testProducerConsumerThreads()
+{
+    constexpr quint32 count = 200000;
+    QGCSPSCRing<quint32, 256> ring;
+
+    QThread *const producer = QThread::create([&ring]() {
+        for (quint32 i = 0; i < count; ) {
+            if (ring.push(i)) {
+                i++;
+            } else {
+                QThread::yieldCurrentThread();
+            }
+        }
+    });
+    producer->start();
+
+    quint32 expected = 0;
+    bool inOrder = true;
+    while (expected < count) {
+        quint32 value;
+        if (ring.pop(value)) {
+            inOrder &= (value == expected);
+            expected++;
+        } else {
+            QThread::yieldCurrentThread();
+        }
+    }
+
+    QVERIFY(producer->wait(5000));
+    delete producer;
+
+    QVERIFY(inOrder);
+    QVERIFY(ring.isEmpty());
+}
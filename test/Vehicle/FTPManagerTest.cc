@@ -12,7 +12,9 @@
 #include "Vehicle.h"
 #include "MockLink.h"
 #include "FTPManager.h"
+#include "QGCTemporaryFile.h"
 
+#include <QtCore/QRandomGenerator>
 #include <QtCore/QStandardPaths>
 #include <QtTest/QTest>
 #include <QtTest/QSignalSpy>
@@ -66,7 +68,7 @@ void FTPManagerTest::_sizeTestCaseWorker(int fileSize)
     QList<QVariant> arguments = spyDownloadComplete.takeFirst();
     QVERIFY(arguments[1].toString().isEmpty());
 
-    _verifyFileSizeAndDelete(arguments[0].toString(), fileSize);
+    _verifyFileContentsAndDelete(arguments[0].toString(), _mockLinkFileContents(fileSize));
 
     _disconnectMockLink();
 }
@@ -119,26 +121,37 @@ void FTPManagerTest::_testLostPackets(void)
     QList<QVariant> arguments = spyDownloadComplete.takeFirst();
     QVERIFY(arguments[1].toString().isEmpty());
 
-    _verifyFileSizeAndDelete(arguments[0].toString(), fileSize);
+    _verifyFileContentsAndDelete(arguments[0].toString(), _mockLinkFileContents(fileSize));
 
     _disconnectMockLink();
 }
 
-void FTPManagerTest::_verifyFileSizeAndDelete(const QString& filename, int expectedSize)
+/// Contents of the files MockLinkFTP serves for MockLinkFTP::sizeFilenamePrefix
+static QByteArray _mockLinkFileContents(int size)
 {
-    QFileInfo fileInfo(filename);
-
-    QVERIFY(fileInfo.exists());
-    QCOMPARE(fileInfo.size(), expectedSize);
+    QByteArray contents(size, Qt::Uninitialized);
+    for (int i=0; i<size; i++) {
+        contents[i] = static_cast<char>(i % 255);
+    }
+    return contents;
+}
 
+void FTPManagerTest::_verifyFileContentsAndDelete(const QString& filename, const QByteArray& expectedContents)
+{
     QFile file(filename);
     QVERIFY(file.open(QFile::ReadOnly));
-    for (int i=0; i<expectedSize; i++) {
-        QByteArray bytes = file.read(1);
-        QCOMPARE(bytes[0], (char)(i % 255));
-    }
+    const QByteArray contents = file.readAll();
     file.close();
     file.remove();
+
+    QCOMPARE(contents.size(), expectedContents.size());
+    if (contents != expectedContents) {
+        qsizetype offset = 0;
+        while (contents[offset] == expectedContents[offset]) {
+            offset++;
+        }
+        QFAIL(qPrintable(QStringLiteral("File contents differ at offset %1").arg(offset)));
+    }
 }
 
 void FTPManagerTest::_testListDirectory(void)
@@ -301,3 +314,146 @@ void FTPManagerTest::_testListDirectoryBadSequence(void)
 
     _disconnectMockLink();
 }
+
+void FTPManagerTest::_testConcurrentDownloads(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager* ftpManager  = _vehicle->ftpManager();
+    QString     toDir       = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+
+    // More sessions than the vehicle has, the download which gets no session waits for one of the others
+    ftpManager->setMaxSessions(3);
+    _mockLink->mockLinkFTP()->setMaxSessions(2);
+
+    QSignalSpy spyTransferComplete(ftpManager, &FTPManager::transferComplete);
+
+    const QList<int>    rgFileSizes = { 10 * 1024, 3 * 1024 + 1, 7 * 1024 };
+    QMap<int, int>      fileSizeByTransferId;
+    for (int fileSize: rgFileSizes) {
+        QString filename    = QStringLiteral("%1%2").arg(MockLinkFTP::sizeFilenamePrefix).arg(fileSize);
+        int     transferId  = ftpManager->queueDownload(MAV_COMP_ID_AUTOPILOT1, filename, toDir);
+        QVERIFY(transferId != -1);
+        fileSizeByTransferId[transferId] = fileSize;
+    }
+    QCOMPARE(ftpManager->transferCount(), rgFileSizes.count());
+
+    while (spyTransferComplete.count() < rgFileSizes.count() && spyTransferComplete.wait(10000)) {}
+    QCOMPARE(spyTransferComplete.count(), rgFileSizes.count());
+    QCOMPARE(ftpManager->transferCount(), 0);
+
+    // void transferComplete(int transferId, const QString& file, const QString& errorMsg);
+    for (const QList<QVariant>& arguments: spyTransferComplete) {
+        QVERIFY(arguments[2].toString().isEmpty());
+        _verifyFileContentsAndDelete(arguments[1].toString(), _mockLinkFileContents(fileSizeByTransferId[arguments[0].toInt()]));
+    }
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_uploadWorker(bool randomDrops)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager* ftpManager  = _vehicle->ftpManager();
+    int         fileSize    = 4 * 1024 + 17;
+    QString     uploadPath  = QStringLiteral("/upload.bin");
+
+    // Not the pattern MockLinkFTP serves, so the upload can't be mistaken for one of its files
+    QByteArray contents(fileSize, Qt::Uninitialized);
+    QRandomGenerator random(fileSize);
+    for (int i=0; i<fileSize; i++) {
+        contents[i] = static_cast<char>(random.bounded(256));
+    }
+
+    QGCTemporaryFile tmpFile("FTPManagerTestUpload");
+    QVERIFY(tmpFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(tmpFile.write(contents), static_cast<qint64>(fileSize));
+    tmpFile.close();
+
+    QSignalSpy spyTransferComplete(ftpManager, &FTPManager::transferComplete);
+    QSignalSpy spyTransferProgress(ftpManager, &FTPManager::transferProgress);
+
+    _mockLink->mockLinkFTP()->enableRandromDrops(randomDrops);
+    int transferId = ftpManager->queueUpload(MAV_COMP_ID_AUTOPILOT1, tmpFile.fileName(), uploadPath);
+    QVERIFY(transferId != -1);
+
+    QCOMPARE(spyTransferComplete.wait(10000), true);
+    QCOMPARE(spyTransferComplete.count(), 1);
+
+    // void transferComplete(int transferId, const QString& file, const QString& errorMsg);
+    QList<QVariant> arguments = spyTransferComplete.takeFirst();
+    QCOMPARE(arguments[0].toInt(), transferId);
+    QVERIFY(arguments[2].toString().isEmpty());
+
+    // void transferProgress(int transferId, float progress, qint64 bytesTransferred, double bytesPerSecond);
+    QVERIFY(spyTransferProgress.count() > 0);
+    QCOMPARE(spyTransferProgress.last()[1].toFloat(), 1.0f);
+    QCOMPARE(spyTransferProgress.last()[2].toLongLong(), static_cast<qint64>(fileSize));
+
+    _verifyFileContentsAndDelete(_mockLink->mockLinkFTP()->uploadedFile(uploadPath), contents);
+    tmpFile.remove();
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testUpload(void)
+{
+    _uploadWorker(false /* randomDrops */);
+}
+
+void FTPManagerTest::_testUploadLostPackets(void)
+{
+    _uploadWorker(true /* randomDrops */);
+}
+
+void FTPManagerTest::_testResume(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager* ftpManager  = _vehicle->ftpManager();
+    int         fileSize    = 64 * 1024;
+    QString     filename    = QStringLiteral("%1%2").arg(MockLinkFTP::sizeFilenamePrefix).arg(fileSize);
+    QString     toDir       = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+
+    QSignalSpy spyTransferComplete(ftpManager, &FTPManager::transferComplete);
+
+    // Lose the link part way through the download
+    QMetaObject::Connection connection = connect(ftpManager, &FTPManager::transferProgress, this, [this](int, float progress) {
+        if (progress > 0.3f) {
+            _mockLink->setCommLost(true);
+        }
+    });
+    QVERIFY(ftpManager->queueDownload(MAV_COMP_ID_AUTOPILOT1, filename, toDir) != -1);
+
+    QCOMPARE(spyTransferComplete.wait(10000), true);
+    disconnect(connection);
+
+    // void transferComplete(int transferId, const QString& file, const QString& errorMsg);
+    QList<QVariant> arguments = spyTransferComplete.takeFirst();
+    QVERIFY(!arguments[2].toString().isEmpty());
+    QString localFile = arguments[1].toString();
+    QVERIFY(QFile::exists(localFile));
+    QVERIFY(QFile::exists(localFile + FTPManager::resumeFileSuffix));
+
+    // The download picks up where it stopped
+    _mockLink->setCommLost(false);
+    QSignalSpy spyTransferProgress(ftpManager, &FTPManager::transferProgress);
+    QVERIFY(ftpManager->queueDownload(MAV_COMP_ID_AUTOPILOT1, filename, toDir) != -1);
+
+    QCOMPARE(spyTransferComplete.wait(10000), true);
+    arguments = spyTransferComplete.takeFirst();
+    QVERIFY(arguments[2].toString().isEmpty());
+    QCOMPARE(arguments[1].toString(), localFile);
+
+    // void transferProgress(int transferId, float progress, qint64 bytesTransferred, double bytesPerSecond);
+    QVERIFY(spyTransferProgress.count() > 0);
+    qint64 bytesTransferred = spyTransferProgress.last()[2].toLongLong();
+    qDebug() << "Resumed download transferred" << bytesTransferred << "of" << fileSize << "bytes";
+    QVERIFY(bytesTransferred < fileSize);
+
+    QVERIFY(!QFile::exists(localFile + FTPManager::resumeFileSuffix));
+    _verifyFileContentsAndDelete(localFile, _mockLinkFileContents(fileSize));
+
+    _disconnectMockLink();
+}
@@ -24,6 +24,10 @@ private slots:
     void _testListDirectoryNoSecondResponseAllowRetry   (void);
     void _testListDirectoryNakSecondResponse            (void);
     void _testListDirectoryBadSequence                  (void);
+    void _testConcurrentDownloads                       (void);
+    void _testUpload                                    (void);
+    void _testUploadLostPackets                         (void);
+    void _testResume                                    (void);
 
     // Overrides from UnitTest
     void cleanup(void) override;
@@ -38,7 +42,8 @@ private:
 
     void _testCaseWorker            (const TestCase_t& testCase);
     void _sizeTestCaseWorker        (int fileSize);
-    void _verifyFileSizeAndDelete   (const QString& filename, int expectedSize);
+    void _uploadWorker              (bool randomDrops);
+    void _verifyFileContentsAndDelete(const QString& filename, const QByteArray& expectedContents);
 
     static const TestCase_t _rgTestCases[];
 };
@@ -0,0 +1,141 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VehicleMessageDispatcherTest.h"
+#include "VehicleMessageDispatcher.h"
+
+#include <QtTest/QTest>
+
+mavlink_message_t VehicleMessageDispatcherTest::_message(uint32_t msgId)
+{
+    mavlink_message_t message{};
+    message.msgid = msgId;
+    return message;
+}
+
+void VehicleMessageDispatcherTest::_testRouting()
+{
+    VehicleMessageDispatcher dispatcher;
+    QStringList calls;
+
+    dispatcher.registerHandler(QStringLiteral("Heartbeat"), { MAVLINK_MSG_ID_HEARTBEAT }, [&calls](LinkInterface*, mavlink_message_t&) {
+        calls.append(QStringLiteral("Heartbeat"));
+        return true;
+    });
+    dispatcher.registerHandler(QStringLiteral("All"), {}, [&calls](LinkInterface*, mavlink_message_t&) {
+        calls.append(QStringLiteral("All"));
+        return true;
+    });
+    dispatcher.registerHandler(QStringLiteral("Attitude"), { MAVLINK_MSG_ID_ATTITUDE, MAVLINK_MSG_ID_HEARTBEAT }, [&calls](LinkInterface*, mavlink_message_t&) {
+        calls.append(QStringLiteral("Attitude"));
+        return true;
+    });
+
+    mavlink_message_t message = _message(MAVLINK_MSG_ID_HEARTBEAT);
+    QVERIFY(dispatcher.dispatch(nullptr, message));
+    QCOMPARE(calls, QStringList({ QStringLiteral("Heartbeat"), QStringLiteral("All"), QStringLiteral("Attitude") }));
+
+    calls.clear();
+    message = _message(MAVLINK_MSG_ID_ATTITUDE);
+    QVERIFY(dispatcher.dispatch(nullptr, message));
+    QCOMPARE(calls, QStringList({ QStringLiteral("All"), QStringLiteral("Attitude") }));
+
+    // Message ids outside of the lookup table
+    calls.clear();
+    message = _message(0x10000 + 5);
+    QVERIFY(dispatcher.dispatch(nullptr, message));
+    QCOMPARE(calls, QStringList({ QStringLiteral("All") }));
+
+    // Handlers registered after the route list was built are appended
+    dispatcher.registerHandler(QStringLiteral("Late"), { MAVLINK_MSG_ID_ATTITUDE }, [&calls](LinkInterface*, mavlink_message_t&) {
+        calls.append(QStringLiteral("Late"));
+        return true;
+    });
+    calls.clear();
+    message = _message(MAVLINK_MSG_ID_ATTITUDE);
+    QVERIFY(dispatcher.dispatch(nullptr, message));
+    QCOMPARE(calls, QStringList({ QStringLiteral("All"), QStringLiteral("Attitude"), QStringLiteral("Late") }));
+}
+
+void VehicleMessageDispatcherTest::_testStopDispatch()
+{
+    VehicleMessageDispatcher dispatcher;
+    int laterCalls = 0;
+
+    dispatcher.registerHandler(QStringLiteral("Terrain"), { MAVLINK_MSG_ID_TERRAIN_REQUEST }, [](LinkInterface*, mavlink_message_t&) {
+        return false;
+    });
+    dispatcher.registerHandler(QStringLiteral("All"), {}, [&laterCalls](LinkInterface*, mavlink_message_t&) {
+        laterCalls++;
+        return true;
+    });
+
+    mavlink_message_t message = _message(MAVLINK_MSG_ID_TERRAIN_REQUEST);
+    QVERIFY(!dispatcher.dispatch(nullptr, message));
+    QCOMPARE(laterCalls, 0);
+
+    message = _message(MAVLINK_MSG_ID_HEARTBEAT);
+    QVERIFY(dispatcher.dispatch(nullptr, message));
+    QCOMPARE(laterCalls, 1);
+}
+
+void VehicleMessageDispatcherTest::_testRegisterDuringDispatch()
+{
+    VehicleMessageDispatcher dispatcher;
+    int createdCalls = 0;
+    bool created = false;
+
+    // Same pattern as battery fact groups which are created by the first BATTERY_STATUS
+    dispatcher.registerHandler(QStringLiteral("Creator"), { MAVLINK_MSG_ID_BATTERY_STATUS }, [&](LinkInterface*, mavlink_message_t&) {
+        if (!created) {
+            created = true;
+            dispatcher.registerHandler(QStringLiteral("Created"), { MAVLINK_MSG_ID_BATTERY_STATUS }, [&createdCalls](LinkInterface*, mavlink_message_t&) {
+                createdCalls++;
+                return true;
+            });
+        }
+        return true;
+    });
+
+    mavlink_message_t message = _message(MAVLINK_MSG_ID_BATTERY_STATUS);
+    QVERIFY(dispatcher.dispatch(nullptr, message));
+    QCOMPARE(createdCalls, 1);
+    QVERIFY(dispatcher.dispatch(nullptr, message));
+    QCOMPARE(createdCalls, 2);
+}
+
+void VehicleMessageDispatcherTest::_testHandlerStats()
+{
+    VehicleMessageDispatcher dispatcher;
+
+    dispatcher.registerHandler(QStringLiteral("Slow"), { MAVLINK_MSG_ID_HEARTBEAT }, [](LinkInterface*, mavlink_message_t&) {
+        QTest::qSleep(2);
+        return true;
+    });
+    dispatcher.registerHandler(QStringLiteral("Fast"), { MAVLINK_MSG_ID_HEARTBEAT }, [](LinkInterface*, mavlink_message_t&) {
+        return true;
+    });
+
+    mavlink_message_t message = _message(MAVLINK_MSG_ID_HEARTBEAT);
+    for (int i = 0; i < 3; i++) {
+        QVERIFY(dispatcher.dispatch(nullptr, message));
+    }
+
+    const QList<VehicleMessageDispatcher::HandlerStats> stats = dispatcher.handlerStats();
+    QCOMPARE(stats.count(), 2);
+    QCOMPARE(stats[0].name, QStringLiteral("Slow"));
+    QCOMPARE(stats[0].msgId, static_cast<uint32_t>(MAVLINK_MSG_ID_HEARTBEAT));
+    QCOMPARE(stats[0].calls, 3ULL);
+    QVERIFY(stats[0].maxNsecs >= 2000000ULL);
+    QVERIFY(stats[0].totalNsecs >= stats[1].totalNsecs);
+    QCOMPARE(stats[1].calls, 3ULL);
+
+    dispatcher.resetHandlerStats();
+    QVERIFY(dispatcher.handlerStats().isEmpty());
+}
@@ -0,0 +1,29 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class VehicleMessageDispatcherTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    VehicleMessageDispatcherTest() = default;
+
+private slots:
+    void _testRouting();
+    void _testStopDispatch();
+    void _testRegisterDuringDispatch();
+    void _testHandlerStats();
+
+private:
+    static mavlink_message_t _message(uint32_t msgId);
+};
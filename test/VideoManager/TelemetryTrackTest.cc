@@ -0,0 +1,139 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TelemetryTrackTest.h"
+#include "TelemetryTrack.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QTest>
+
+using namespace TelemetryTrack;
+
+static Record_t _factRecord(qint64 timeUs, quint16 id, double value)
+{
+    Record_t record{};
+    record.timeUs = timeUs;
+    record.type = RecordTypeFact;
+    record.id = id;
+    record.payload.fact = value;
+    return record;
+}
+
+static Record_t _attitudeRecord(qint64 timeUs, float roll)
+{
+    Record_t record{};
+    record.timeUs = timeUs;
+    record.type = RecordTypeAttitude;
+    record.payload.attitude.timeBootMs = static_cast<quint32>(timeUs / 1000);
+    record.payload.attitude.roll = roll;
+    return record;
+}
+
+/// Attitude every 10ms, Fact 0 every 100ms and Fact 1 only once
+static void _writeTrack(const QString &fileName)
+{
+    TelemetryTrackWriter writer;
+    QVERIFY(writer.open(fileName, { { QStringLiteral("Altitude"), QStringLiteral("m") }, { QStringLiteral("Battery"), QStringLiteral("%") } }, Q_INT64_C(1700000000000)));
+
+    writer.writeRecord(_factRecord(0, 1, 87));
+    for (int i = 0; i < 1000; i++) {
+        const qint64 timeUs = i * 10000;
+        writer.writeRecord(_attitudeRecord(timeUs, i * 0.001f));
+        if ((i % 10) == 0) {
+            writer.writeRecord(_factRecord(timeUs, 0, i));
+        }
+    }
+
+    writer.close();
+    QVERIFY(!writer.isOpen());
+}
+
+void TelemetryTrackTest::_testRoundTrip()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString fileName = tempDir.filePath(QStringLiteral("test.qgctlm"));
+    _writeTrack(fileName);
+
+    TelemetryTrackReader reader;
+    QVERIFY(reader.open(fileName));
+    QCOMPARE(reader.startUtcMs(), Q_INT64_C(1700000000000));
+    QCOMPARE(reader.facts().count(), static_cast<qsizetype>(2));
+    QCOMPARE(reader.facts()[0].name, QStringLiteral("Altitude"));
+    QCOMPARE(reader.facts()[0].units, QStringLiteral("m"));
+    QCOMPARE(reader.facts()[1].name, QStringLiteral("Battery"));
+    QCOMPARE(reader.facts()[1].units, QStringLiteral("%"));
+    QCOMPARE(reader.count(), static_cast<qsizetype>(1101));
+
+    const Record_t first = reader.record(0);
+    QCOMPARE(first.type, static_cast<quint16>(RecordTypeFact));
+    QCOMPARE(first.id, static_cast<quint16>(1));
+    QCOMPARE(first.payload.fact, 87.0);
+
+    const Record_t last = reader.record(reader.count() - 1);
+    QCOMPARE(last.type, static_cast<quint16>(RecordTypeAttitude));
+    QCOMPARE(last.timeUs, Q_INT64_C(9990000));
+    QCOMPARE(last.payload.attitude.timeBootMs, 9990u);
+    QCOMPARE(last.payload.attitude.roll, 0.999f);
+
+    QVERIFY(!reader.open(tempDir.filePath(QStringLiteral("missing.qgctlm"))));
+    QVERIFY(!reader.isOpen());
+}
+
+void TelemetryTrackTest::_testLookup()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString fileName = tempDir.filePath(QStringLiteral("test.qgctlm"));
+    _writeTrack(fileName);
+
+    TelemetryTrackReader reader;
+    QVERIFY(reader.open(fileName));
+
+    QCOMPARE(reader.indexAt(-1), static_cast<qsizetype>(-1));
+    QCOMPARE(reader.record(reader.indexAt(0)).timeUs, Q_INT64_C(0));
+    QCOMPARE(reader.record(reader.indexAt(15000)).timeUs, Q_INT64_C(10000));
+    QCOMPARE(reader.record(reader.indexAt(20000)).timeUs, Q_INT64_C(20000));
+    QCOMPARE(reader.indexAt(100000000), reader.count() - 1);
+
+    Record_t record;
+    QVERIFY(reader.latest(RecordTypeAttitude, 0, 4567000, record));
+    QCOMPARE(record.timeUs, Q_INT64_C(4560000));
+    QCOMPARE(record.payload.attitude.roll, 0.456f);
+
+    QVERIFY(reader.latest(RecordTypeFact, 0, 4567000, record));
+    QCOMPARE(record.timeUs, Q_INT64_C(4500000));
+    QCOMPARE(record.payload.fact, 450.0);
+
+    // Only written at the start, out of the default window later on
+    QVERIFY(reader.latest(RecordTypeFact, 1, 1000000, record));
+    QCOMPARE(record.payload.fact, 87.0);
+    QVERIFY(!reader.latest(RecordTypeFact, 1, 4567000, record));
+    QVERIFY(reader.latest(RecordTypeFact, 1, 4567000, record, 5000000));
+
+    QVERIFY(!reader.latest(RecordTypePosition, 0, 4567000, record));
+}
+
+void TelemetryTrackTest::_testTruncatedRecord()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString fileName = tempDir.filePath(QStringLiteral("test.qgctlm"));
+    _writeTrack(fileName);
+
+    // Simulate QGC stopping in the middle of a record
+    QFile file(fileName);
+    QVERIFY(file.resize(file.size() - 20));
+
+    TelemetryTrackReader reader;
+    QVERIFY(reader.open(fileName));
+    QCOMPARE(reader.count(), static_cast<qsizetype>(1100));
+    QCOMPARE(reader.record(reader.count() - 1).timeUs, Q_INT64_C(9980000));
+}
@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VideoFrameStatsTest.h"
+#include "VideoFrameStats.h"
+
+#include <QtTest/QTest>
+
+void VideoFrameStatsTest::_testStageLatencies()
+{
+    VideoFrameStatsCollector collector;
+    QVERIFY(!collector.snapshot(1000000).valid);
+
+    // Two frames decoded in the opposite order to the one they were parsed in, matched by pts
+    collector.noteSourceBuffer(1000000);
+    collector.noteSourceBuffer(1000500);    // Same frame, only the first buffer counts
+    collector.noteParsedFrame(100, 1002000);
+    collector.noteSourceBuffer(1010000);
+    collector.noteParsedFrame(200, 1011000);
+    collector.noteDecoderInput(200, 1012000);
+    collector.noteDecoderInput(100, 1013000);
+    collector.noteDecodedFrame(200, 1016000);
+    collector.noteDecodedFrame(100, 1021000);
+
+    // Not seen by the parser, counts as decoded but has no latencies
+    collector.noteDecodedFrame(300, 1030000);
+
+    const VideoFrameStats stats = collector.snapshot(2000000);
+    QVERIFY(stats.valid);
+    QCOMPARE(stats.framesDecoded, Q_UINT64_C(3));
+    QCOMPARE(stats.framesDropped, Q_UINT64_C(0));
+    QCOMPARE(stats.fps, 3.0);
+
+    // pts 100: parser 2, queue 11, decode 8, total 21. pts 200: parser 1, queue 1, decode 4, total 6.
+    // Averaged over the three frames of the window.
+    QCOMPARE(stats.parserLatency, 1.0);
+    QCOMPARE(stats.queueLatency, 4.0);
+    QCOMPARE(stats.decodeLatency, 4.0);
+    QCOMPARE(stats.totalLatency, 9.0);
+
+    // The window starts over with each snapshot
+    const VideoFrameStats next = collector.snapshot(3000000);
+    QCOMPARE(next.framesDecoded, Q_UINT64_C(3));
+    QCOMPARE(next.fps, 0.0);
+    QCOMPARE(next.totalLatency, 0.0);
+
+    collector.reset();
+    QVERIFY(!collector.snapshot(4000000).valid);
+}
+
+void VideoFrameStatsTest::_testJitterHistogram()
+{
+    VideoFrameStatsCollector collector;
+
+    // Deviations of the frame interval from its running average: 0, 0, 0, 13, 3 and 100ms
+    const QList<qint64> decodedUs = { 0, 10000, 20000, 30000, 53000, 67300, 178900 };
+    quint64 pts = 0;
+    for (const qint64 timeUs : decodedUs) {
+        collector.noteDecodedFrame(pts++, 1000000 + timeUs);
+    }
+
+    const VideoFrameStats stats = collector.snapshot(2000000);
+    QCOMPARE(stats.jitterBuckets, QList<int>({ 1, 2, 5, 10, 20, 50 }));
+    QCOMPARE(stats.jitterHistogram, QList<int>({ 3, 0, 1, 0, 1, 0, 1 }));
+    QCOMPARE(stats.framesDecoded, static_cast<quint64>(decodedUs.count()));
+    QVERIFY(qAbs(stats.jitter - (116.0 / decodedUs.count())) < 0.01);
+}
+
+void VideoFrameStatsTest::_testDecodePercentiles()
+{
+    VideoFrameStatsCollector collector;
+
+    // Decode times of 1 to 100ms, in a shuffled order
+    for (int i = 0; i < 100; i++) {
+        const quint64 pts = i;
+        const qint64 startUs = 1000000 + (i * 200000);
+        const qint64 decodeUs = (((i * 37) % 100) + 1) * 1000;
+        collector.noteParsedFrame(pts, startUs);
+        collector.noteDecoderInput(pts, startUs);
+        collector.noteDecodedFrame(pts, startUs + decodeUs);
+    }
+
+    VideoFrameStats stats = collector.snapshot(30000000);
+    QCOMPARE(stats.decodeP50, 50.0);
+    QCOMPARE(stats.decodeP95, 95.0);
+    QCOMPARE(stats.decodeP99, 99.0);
+
+    // Only the most recent decode times are kept
+    for (int i = 0; i < 300; i++) {
+        const quint64 pts = 1000 + i;
+        const qint64 startUs = 40000000 + (i * 10000);
+        collector.noteParsedFrame(pts, startUs);
+        collector.noteDecoderInput(pts, startUs);
+        collector.noteDecodedFrame(pts, startUs + 2000);
+    }
+
+    stats = collector.snapshot(50000000);
+    QCOMPARE(stats.decodeP50, 2.0);
+    QCOMPARE(stats.decodeP99, 2.0);
+}
+
+void VideoFrameStatsTest::_testDroppedFrames()
+{
+    VideoFrameStatsCollector collector;
+
+    // Frames which entered the decoder and were never decoded are dropped once too many are pending,
+    // frames which never reached the decoder are not
+    for (int i = 0; i < 130; i++) {
+        collector.noteParsedFrame(i, 1000000 + (i * 1000));
+        if (i < 5) {
+            collector.noteDecoderInput(i, 1000000 + (i * 1000) + 500);
+        }
+    }
+    QCOMPARE(collector.snapshot(2000000).framesDropped, Q_UINT64_C(5));
+
+    for (int i = 130; i < 260; i++) {
+        collector.noteParsedFrame(i, 1000000 + (i * 1000));
+        collector.noteDecoderInput(i, 1000000 + (i * 1000) + 500);
+    }
+    QCOMPARE(collector.snapshot(3000000).framesDropped, Q_UINT64_C(15));
+}
@@ -0,0 +1,26 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class VideoFrameStatsTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    VideoFrameStatsTest() = default;
+
+private slots:
+    void _testStageLatencies();
+    void _testJitterHistogram();
+    void _testDecodePercentiles();
+    void _testDroppedFrames();
+};
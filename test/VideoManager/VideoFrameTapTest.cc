@@ -0,0 +1,160 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VideoFrameTapTest.h"
+#include "VideoFrameTapWriter.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtTest/QTest>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/// Unique per test process, so concurrent test runs don't share segments
+static QString _tapName()
+{
+    return QStringLiteral("/qgc_frame_tap_test_%1").arg(QCoreApplication::applicationPid());
+}
+
+/// RGBA frame whose pixels all hold value
+static std::vector<uint8_t> _pixels(uint32_t width, uint32_t height, uint8_t value)
+{
+    return std::vector<uint8_t>(static_cast<size_t>(width) * height * 4, value);
+}
+
+static bool _writeFrame(VideoFrameTapWriter& writer, const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, uint64_t ptsNs)
+{
+    VideoFrameTapWriter::Frame_t frame;
+    frame.data = pixels.data();
+    frame.size = pixels.size();
+    frame.width = width;
+    frame.height = height;
+    frame.stride = width * 4;
+    frame.ptsNs = ptsNs;
+    frame.roll = 1.5f;
+    return writer.writeFrame(frame);
+}
+
+void VideoFrameTapTest::_testRoundTrip()
+{
+    const QByteArray name = _tapName().toLocal8Bit();
+    VideoFrameTapWriter writer(_tapName());
+
+    // Nothing is published before the first frame
+    QVERIFY(!VideoFrameTapReader(name.constData()).isOpen());
+
+    std::vector<uint8_t> pixels = _pixels(4, 2, 0);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = static_cast<uint8_t>(i);
+    }
+    QVERIFY(_writeFrame(writer, pixels, 4, 2, 1000));
+
+    VideoFrameTapReader reader(name.constData());
+    QVERIFY(reader.isOpen());
+    QVERIFY(!reader.isStale());
+    QCOMPARE(reader.latestSequence(), Q_UINT64_C(1));
+
+    qgc_frame_tap_frame_info_t info;
+    std::vector<uint8_t> buffer;
+    QCOMPARE(reader.read(info, buffer), QGC_FRAME_TAP_OK);
+    QCOMPARE(info.sequence, Q_UINT64_C(1));
+    QCOMPARE(info.pts_ns, Q_UINT64_C(1000));
+    QCOMPARE(info.width, 4u);
+    QCOMPARE(info.height, 2u);
+    QCOMPARE(info.stride, 16u);
+    QCOMPARE(info.format, QGC_FRAME_TAP_FORMAT_RGBA);
+    QCOMPARE(info.data_size, static_cast<uint32_t>(pixels.size()));
+    QCOMPARE(info.roll, 1.5f);
+    QVERIFY(info.capture_time_us != 0);
+    QVERIFY(buffer == pixels);
+
+    // In place, without copying
+    const uint8_t* data = reader.peek(info);
+    QVERIFY(data != nullptr);
+    QVERIFY(memcmp(data, pixels.data(), pixels.size()) == 0);
+    QVERIFY(reader.frameValid(info));
+
+    QCOMPARE(reader.read(info, buffer, 2), QGC_FRAME_TAP_NO_FRAME);
+
+    qgc_frame_tap_t* const tap = qgc_frame_tap_open(name.constData());
+    QVERIFY(tap != nullptr);
+    uint8_t small[4];
+    QCOMPARE(qgc_frame_tap_read(tap, 0, &info, small, sizeof(small)), QGC_FRAME_TAP_BUFFER_TOO_SMALL);
+    QCOMPARE(info.data_size, static_cast<uint32_t>(pixels.size()));
+    qgc_frame_tap_close(tap);
+}
+
+void VideoFrameTapTest::_testOverwrite()
+{
+    const QByteArray name = _tapName().toLocal8Bit();
+    VideoFrameTapWriter writer(_tapName(), 2);
+
+    QVERIFY(_writeFrame(writer, _pixels(4, 2, 1), 4, 2, 1));
+    VideoFrameTapReader reader(name.constData());
+    QVERIFY(reader.isOpen());
+
+    QVERIFY(_writeFrame(writer, _pixels(4, 2, 2), 4, 2, 2));
+    QVERIFY(_writeFrame(writer, _pixels(4, 2, 3), 4, 2, 3));
+    QCOMPARE(reader.latestSequence(), Q_UINT64_C(3));
+
+    // Two slots, the first frame is gone
+    qgc_frame_tap_frame_info_t info;
+    std::vector<uint8_t> buffer;
+    QCOMPARE(reader.read(info, buffer, 1), QGC_FRAME_TAP_NO_FRAME);
+    QCOMPARE(reader.read(info, buffer, 2), QGC_FRAME_TAP_OK);
+    QVERIFY(buffer == _pixels(4, 2, 2));
+    QCOMPARE(reader.read(info, buffer, 3), QGC_FRAME_TAP_OK);
+    QVERIFY(buffer == _pixels(4, 2, 3));
+    QCOMPARE(reader.read(info, buffer, 4), QGC_FRAME_TAP_NO_FRAME);
+
+    // A frame peeked at is overwritten while the reader still holds it
+    QVERIFY(reader.peek(info, 2) != nullptr);
+    QVERIFY(reader.frameValid(info));
+    QVERIFY(_writeFrame(writer, _pixels(4, 2, 4), 4, 2, 4));
+    QVERIFY(!reader.frameValid(info));
+    QCOMPARE(reader.read(info, buffer, 2), QGC_FRAME_TAP_NO_FRAME);
+    QCOMPARE(reader.read(info, buffer), QGC_FRAME_TAP_OK);
+    QCOMPARE(info.sequence, Q_UINT64_C(4));
+    QVERIFY(buffer == _pixels(4, 2, 4));
+}
+
+void VideoFrameTapTest::_testStale()
+{
+    const QByteArray name = _tapName().toLocal8Bit();
+    std::unique_ptr<VideoFrameTapWriter> writer = std::make_unique<VideoFrameTapWriter>(_tapName());
+    QVERIFY(_writeFrame(*writer, _pixels(4, 2, 1), 4, 2, 1));
+
+    VideoFrameTapReader reader(name.constData());
+    QVERIFY(reader.isOpen());
+    QVERIFY(!reader.isStale());
+
+    // A larger frame no longer fits, the writer moves to a new segment
+    QVERIFY(_writeFrame(*writer, _pixels(64, 64, 2), 64, 64, 2));
+    QVERIFY(reader.isStale());
+
+    qgc_frame_tap_frame_info_t info;
+    std::vector<uint8_t> buffer;
+    QCOMPARE(reader.read(info, buffer), QGC_FRAME_TAP_STALE);
+    QVERIFY(reader.peek(info) == nullptr);
+
+    VideoFrameTapReader reopened(name.constData());
+    QVERIFY(reopened.isOpen());
+    QVERIFY(!reopened.isStale());
+    QCOMPARE(reopened.read(info, buffer), QGC_FRAME_TAP_OK);
+    QCOMPARE(info.sequence, Q_UINT64_C(1));
+    QCOMPARE(info.width, 64u);
+    QVERIFY(buffer == _pixels(64, 64, 2));
+
+    // The writer goes away, a reader still mapping the segment must not keep reading it
+    writer.reset();
+    QVERIFY(reopened.isStale());
+    QCOMPARE(reopened.read(info, buffer), QGC_FRAME_TAP_STALE);
+    QVERIFY(!VideoFrameTapReader(name.constData()).isOpen());
+}
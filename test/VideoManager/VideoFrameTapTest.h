@@ -0,0 +1,25 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class VideoFrameTapTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    VideoFrameTapTest() = default;
+
+private slots:
+    void _testRoundTrip();
+    void _testOverwrite();
+    void _testStale();
+};